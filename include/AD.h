@@ -12,6 +12,13 @@
  * additional analog input for the battery voltage (through a 10:1
  * divider).
  *
+ * The converter scans the pins by itself, one interrupt a scan, and the
+ * interrupt keeps the last AD_RING_LENGTH samples of each pin in a ring
+ * with the time of each scan, and a running sum of each ring. Blocks of
+ * the latest samples, their mean and an oversampled value all come out
+ * without a loop over samples on the caller's side. The uno32's
+ * PIC32MX320 has no DMA, so the interrupt does the copying, once a scan.
+ *
  * @note
  * Analog pins automatically take over digital I/O regardless of which
  * TRIS state it is in. There remains an error in the ADC code such that
@@ -51,6 +58,14 @@
 #define AD_PORTW8 (1<<11)
 #define BAT_VOLTAGE (1<<12)
 
+// Scans each pin's ring keeps, a power of two
+#define AD_RING_LENGTH 16
+
+// (Hz) Sample rates AD_startCapture takes, Timer3's period is 16 bits of
+//  the peripheral bus clock (1221 Hz at the performance profile)
+#define AD_CAPTURE_RATE_MIN (BOARD_PB_CLOCK / 0x10000 + 1)
+#define AD_CAPTURE_RATE_MAX 100000
+
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
@@ -71,11 +86,70 @@ unsigned char AD_init(unsigned int Pins);
  * Function: AD_readPin
  * @param Pin, use #defined AD_PORTxxx to select pin
  * @return 10-bit AD Value or ERROR
- * @remark Reads current value from buffer for given pin
+ * @remark Reads current value from buffer for given pin, also ERROR for
+ *  more than one pin at once
  * @author Max Dunne
  * @date 2011.12.10  */
 unsigned int AD_readPin(unsigned int Pin);
 
+/**
+ * Function: AD_readBlock
+ * @param Pin, use #defined AD_PORTxxx to select pin
+ * @param Samples, where to put them, oldest first
+ * @param Times, where to put the core timer count at each scan, or NULL
+ * @param Count, how many of the latest samples, up to AD_RING_LENGTH
+ * @return Samples read or ERROR
+ * @remark Every scan of the pins goes into a ring per pin, so a burst of
+ *  samples can be had at once instead of one a call. The times count the
+ *  same as Timer_getCycles.
+ * @date 2026.10.14  */
+unsigned int AD_readBlock(unsigned int Pin, unsigned short *Samples,
+    unsigned int *Times, unsigned int Count);
+
+/**
+ * Function: AD_readAverage
+ * @param Pin, use #defined AD_PORTxxx to select pin
+ * @return 10-bit mean of the last AD_RING_LENGTH samples or ERROR
+ * @remark Kept as a running sum by the interrupt, so it costs nothing to
+ *  read, for smoothing something like the battery voltage.
+ * @date 2026.10.14  */
+unsigned int AD_readAverage(unsigned int Pin);
+
+/**
+ * Function: AD_readOversampled
+ * @param Pin, use #defined AD_PORTxxx to select pin
+ * @return 12-bit value from the last AD_RING_LENGTH samples or ERROR
+ * @date 2026.10.14  */
+unsigned int AD_readOversampled(unsigned int Pin);
+
+/**
+ * Function: AD_getScanCount
+ * @return Scans of the pins since AD_init
+ * @remark Changes whenever there are new samples.
+ * @date 2026.10.14  */
+unsigned int AD_getScanCount(void);
+
+/**
+ * Function: AD_startCapture
+ * @param Pin, one of the pins given to AD_init
+ * @param Rate, (Hz) samples a second, AD_CAPTURE_RATE_MIN to _MAX
+ * @param Buffer, where the samples go, kept until the capture is done
+ * @param Length, samples to take, a multiple of 8
+ * @return SUCCESS or ERROR
+ * @remark Samples the pin on Timer3 into the buffer, so the samples are
+ *  evenly spaced by the hardware rather than by the main loop, then goes
+ *  back to scanning. Uses Timer3. The other pins aren't read meanwhile,
+ *  AD_readPin and the rings give what they had before.
+ * @date 2026.10.14  */
+unsigned char AD_startCapture(unsigned int Pin, unsigned int Rate,
+    unsigned short *Buffer, unsigned int Length);
+
+/**
+ * Function: AD_isCapturing
+ * @return TRUE until the capture has filled its buffer
+ * @date 2026.10.14  */
+unsigned char AD_isCapturing(void);
+
 
 
 /**
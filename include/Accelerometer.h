@@ -9,6 +9,16 @@
  * Module that wraps the accelerometer sensor in a state machine
  * that ocassionally takes readings over an I2C bus.
  *
+ * It can also stream: Accelerometer_startStream sets the output data
+ * rate, up to 800 Hz, and routes the sensor's interrupt to INT1 (pin 2,
+ * RD8). The interrupt only flags the data and calls the ready handler,
+ * and Accelerometer_drain then reads it in one burst. An MMA8451 is
+ * recognised by its WHO_AM_I and runs its 32 sample FIFO, interrupting
+ * at ACCELEROMETER_FIFO_WATERMARK, so a drain takes up to 32 samples
+ * for one transaction. The MMA8452 has no FIFO, so it interrupts on
+ * every sample and the drain takes that one. Either way every sample
+ * goes through a first-order low-pass weighted 1/2^shift.
+ *
  * @date January 23, 2013, 1:24 PM  -- Created
  */
 
@@ -16,11 +26,37 @@
 #define Accelerometer_H
 
 #include <stdint.h>
+#include "Board.h"
+#include "Boot.h"
 
 /***********************************************************************
  * PUBLIC DEFINITIONS                                                  *
  ***********************************************************************/
 
+// Samples in the FIFO that interrupt, leaving room for the time a drain
+//  takes to be scheduled (16 samples is 20 ms at 800 Hz)
+#define ACCELEROMETER_FIFO_WATERMARK    16
+#define ACCELEROMETER_FILTER_MAX        8 // largest low-pass shift
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+// Output data rates, in the order of the sensor's DR bits
+typedef enum {
+    ACCELEROMETER_RATE_800HZ = 0,
+    ACCELEROMETER_RATE_400HZ,
+    ACCELEROMETER_RATE_200HZ,
+    ACCELEROMETER_RATE_100HZ,
+    ACCELEROMETER_RATE_50HZ,
+    ACCELEROMETER_RATE_12_5HZ,
+    ACCELEROMETER_RATE_6_25HZ,
+    ACCELEROMETER_RATE_1_56HZ,
+} AccelerometerRate;
+
+// Called from the INT1 interrupt, see Accelerometer_setReadyHandler
+typedef void (*AccelerometerReadyHandler)();
+
 /***********************************************************************
  * PUBLIC FUNCTIONS                                                    *
  ***********************************************************************/
@@ -33,6 +69,15 @@
  * @date 2013.01.23  */
 char Accelerometer_init();
 
+/**
+ * Function: Accelerometer_initSM
+ * @return BOOT_PENDING while it's coming up, then BOOT_READY or BOOT_FAILED.
+ * @remark Does the same as Accelerometer_init one queued I2C transfer at a
+ *  time, so the rest of the board comes up alongside it. Call it until it
+ *  isn't pending, Boot_add takes it as it is. Needs I2C_init.
+ * @date 2026.10.14  */
+BootStatus Accelerometer_initSM();
+
 /**
  * Function: Accelerometer_runSM
  * @return None.
@@ -42,6 +87,14 @@ char Accelerometer_init();
  * @date 2013.01.23  */
 void Accelerometer_runSM();
 
+/**
+ * Function: Accelerometer_update
+ * @return None.
+ * @remark Updates the x,y,z readings now, for callers that keep their own
+ *      schedule, see Sensors.h.
+ * @date 2026.10.14  */
+void Accelerometer_update();
+
 /**
  * Function: Accelerometer_getX
  * @return G-Count on the X-axis.
@@ -66,5 +119,52 @@ int16_t Accelerometer_getY();
  * @date 2013.01.23  */
 int16_t Accelerometer_getZ();
 
+/**
+ * Function: Accelerometer_startStream
+ * @param Output data rate.
+ * @param Low-pass shift, each sample is weighted 1/2^shift, 0 for none.
+ * @return SUCCESS, or FAILURE for a bad rate or shift or if the sensor
+ *      didn't answer.
+ * @remark Call after Accelerometer_init, and use Accelerometer_drain
+ *      instead of Accelerometer_runSM from then on.
+ * @date 2026.10.14  */
+char Accelerometer_startStream(AccelerometerRate rate, uint8_t shift);
+
+/**
+ * Function: Accelerometer_setReadyHandler
+ * @param Function to call, or NULL for none.
+ * @return None.
+ * @remark The handler runs in the interrupt whenever data is waiting, so it
+ *      should only flag work for the main loop, like Scheduler_signal.
+ * @date 2026.10.14  */
+void Accelerometer_setReadyHandler(AccelerometerReadyHandler handler);
+
+/**
+ * Function: Accelerometer_isReady
+ * @return TRUE if the interrupt came since the last drain.
+ * @date 2026.10.14  */
+BOOL Accelerometer_isReady();
+
+/**
+ * Function: Accelerometer_drain
+ * @return Number of samples read.
+ * @remark Reads everything waiting in one burst and filters it into the
+ *      x,y,z readings. Blocks for the burst, about 5 ms for a full FIFO at
+ *      400 kHz.
+ * @date 2026.10.14  */
+uint8_t Accelerometer_drain();
+
+/**
+ * Function: Accelerometer_getSampleCount
+ * @return Samples drained since the stream started.
+ * @date 2026.10.14  */
+uint32_t Accelerometer_getSampleCount();
+
+/**
+ * Function: Accelerometer_hasFifo
+ * @return TRUE if the sensor is an MMA8451.
+ * @date 2026.10.14  */
+BOOL Accelerometer_hasFifo();
+
 
 #endif // Accelerometer_H
@@ -0,0 +1,104 @@
+/**
+ * @file    AngleFilter.h
+ *
+ * @brief
+ * Wrap-safe averaging of angles, for the encoders and the magnetometer.
+ *
+ * @details
+ * Averaging angles as plain numbers goes wrong where they wrap: the mean
+ * of 359 and 1 degrees comes out as 180. Here every angle is turned into
+ * a unit vector, the vectors are averaged, and the mean is the direction
+ * of the result. That is right everywhere on the circle, and noise that
+ * straddles north averages out like it does anywhere else.
+ *
+ * Angles are binary angles (see FastMath.h) and the vectors are Q15, from
+ * the table sine and cosine, so adding a sample costs a few table lookups
+ * and no floating point. A filter is either a moving window over the last
+ * so many samples, kept as running sums so adding one is O(1), or a
+ * first-order low-pass that weighs each new sample by 1/2^shift and keeps
+ * no history at all.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef AngleFilter_H
+#define AngleFilter_H
+
+#include <stdint.h>
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define ANGLEFILTER_WINDOW_MAX  255
+#define ANGLEFILTER_SHIFT_MAX   15
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+// Set up with AngleFilter_initWindow or AngleFilter_initLowPass
+typedef struct {
+    uint16_t *angles; // ring of the window, NULL for a low-pass
+    uint8_t length, next, count;
+    uint8_t shift; // low-pass weight of a new sample is 1/2^shift
+    int32_t sumSin, sumCos; // Q15 window sums, or low-pass state in Q23
+} AngleFilter;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: AngleFilter_initWindow()
+ * @param Filter to set up.
+ * @param Storage for the window, one binary angle a sample.
+ * @param Samples in the window, up to ANGLEFILTER_WINDOW_MAX.
+ * @return None
+ * @remark The mean is over however many samples there are until the
+ *  window fills.
+ **********************************************************************/
+void AngleFilter_initWindow(AngleFilter *filter, uint16_t *storage,
+    uint8_t length);
+
+/**********************************************************************
+ * Function: AngleFilter_initLowPass()
+ * @param Filter to set up.
+ * @param Weight of a new sample is 1/2^shift, up to ANGLEFILTER_SHIFT_MAX.
+ * @return None
+ * @remark The first sample sets the filter, so it doesn't have to settle
+ *  from nothing.
+ **********************************************************************/
+void AngleFilter_initLowPass(AngleFilter *filter, uint8_t shift);
+
+/**********************************************************************
+ * Function: AngleFilter_clear()
+ * @param Filter to empty.
+ * @return None
+ **********************************************************************/
+void AngleFilter_clear(AngleFilter *filter);
+
+/**********************************************************************
+ * Function: AngleFilter_add()
+ * @param Filter to add to.
+ * @param Binary angle of the sample.
+ * @return None
+ **********************************************************************/
+void AngleFilter_add(AngleFilter *filter, uint16_t angle);
+
+/**********************************************************************
+ * Function: AngleFilter_getMean()
+ * @param Filter.
+ * @return Binary angle of the mean, or 0 if the filter is empty or the
+ *  samples cancel out.
+ **********************************************************************/
+uint16_t AngleFilter_getMean(const AngleFilter *filter);
+
+/**********************************************************************
+ * Function: AngleFilter_getCount()
+ * @param Filter.
+ * @return Samples in the window, or for a low-pass, whether it has had
+ *  any as 0 or 1.
+ **********************************************************************/
+uint8_t AngleFilter_getCount(const AngleFilter *filter);
+
+#endif // AngleFilter_H
@@ -9,6 +9,12 @@
  * @details
  * Module that wraps the barometer sensor in a state machine
  * that ocassionally takes readings over an I2C bus.
+ *
+ * Every UPDATE_DELAY the state machine starts a temperature conversion,
+ * comes back for it once it's done, starts the pressure conversion and
+ * comes back for that, so no call waits out a conversion. Both are
+ * compensated with the datasheet's integer algorithm, and the altitude
+ * is interpolated from a table rather than a pow.
 
  * @date January 21, 2013, 4:55 PM -- Created
  */
@@ -17,6 +23,9 @@
 #ifndef Barometer_H
 #define Barometer_H
 
+#include <stdint.h>
+#include "Board.h"
+
 
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
@@ -30,10 +39,14 @@
 /**
  * Function: Barometer_init
  * @return None
- * @remark Intializes the Barometer and state machine.
+ * @param I2C bus the barometer is on, which should be initialized already.
+ * @remark Intializes the Barometer and state machine. Reads the calibration,
+ *      the first reading is done by Barometer_runSM. With the store up (see
+ *      Nvm.h) only AC1 is read, to tell it's the same sensor as the
+ *      calibration kept from the last boot.
  * @author David Goodman
  * @date 2013.02.01  */
-void Barometer_init();
+void Barometer_init(int BAROMETER_I2C_ID);
 
 /**
  * Function: Barometer_getTemperature
@@ -42,7 +55,7 @@ void Barometer_init();
  *      degerees C.
  * @author Shehadeh H. Dajani
  * @date 2013.01.21  */
-float Barometer_getTemperatureFahrenheit();
+int32_t Barometer_getTemperature();
 
 /**
  * Function: Barometer_getTemperatureFahrenheit
@@ -63,17 +76,26 @@ int32_t Barometer_getPressure();
 
 /**
  * Function: Barometer_getAltitude
- * @return Returns the altitude in meters.
- * @remark Converts pressure from altitude above sea level in meters. 
+ * @return Returns the altitude in feet.
+ * @remark Converts pressure to altitude above sea level, from a table for
+ *      PRESSURE_P0. 
  * @author David Goodman
  * @date 2013.02.01  */
 float Barometer_getAltitude();
 /**
- * Function: Barometer_getPressureData
- * @return Data, (long) 16-bit temperature data
- * @remark Updates the barometer's temperature.
+ * Function: Barometer_runSM
+ * @param I2C bus the barometer is on.
+ * @return None.
+ * @remark Steps the conversions, starting one or picking up one that has
+ *      finished. Never waits for the sensor, call it often.
  * @author David Goodman
  * @date 2013.01.22  */
-void Barometer_runSM();
+void Barometer_runSM(int BAROMETER_I2C_ID);
+
+/**
+ * Function: Barometer_isBusy
+ * @return TRUE while an update is between its conversions.
+ * @date 2026.10.14  */
+BOOL Barometer_isBusy();
 
 #endif // Barometer_H
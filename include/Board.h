@@ -26,6 +26,26 @@
  * PUBLIC #DEFINES                                                             *
  ******************************************************************************/
 
+/*****************************************************************************/
+// Clock profiles, pick one for the whole project in its preprocessor macros
+//  (every file has to agree), BOARD_PROFILE_PERFORMANCE without one:
+//   BOARD_PROFILE_PERFORMANCE 80 MHz system and peripheral bus, for the boat
+//   BOARD_PROFILE_LOW_POWER   40 MHz system, 20 MHz peripheral bus, for the
+//                             command center, which idles between its tasks
+// Board_init sets the clocks, flash wait states and prefetch cache for it,
+//  and everything timed off a clock takes it from here or Board_GetPBClock.
+#if defined(BOARD_PROFILE_LOW_POWER)
+#define BOARD_SYSTEM_CLOCK  40000000L // (Hz)
+#define BOARD_PB_DIVIDER    2
+#else
+#ifndef BOARD_PROFILE_PERFORMANCE
+#define BOARD_PROFILE_PERFORMANCE
+#endif
+#define BOARD_SYSTEM_CLOCK  80000000L // (Hz)
+#define BOARD_PB_DIVIDER    1
+#endif
+#define BOARD_PB_CLOCK      (BOARD_SYSTEM_CLOCK / BOARD_PB_DIVIDER) // (Hz)
+
 #define DELAY(ms)   do { int i; for (i = 0; i < (ms << 8); i++) { asm ("nop"); } } while(0);
 
 /*****************************************************************************/
@@ -62,6 +82,11 @@
 #define TIMER_ENCODER           5
 #define TIMER_BUTTONS           6
 #define TIMER_HEARTBEAT         7
+#define TIMER_LINK_STATUS       8
+#define TIMER_GPS_CONFIG        9
+#define TIMER_XBEE_CONFIG       10
+#define TIMER_NAVIGATION        11
+#define TIMER_GUIDANCE          12
 #define TIMER_BAROMETER2        14 // remove the blocking code!!
 #define TIMER_TEST              15
 
@@ -98,14 +123,16 @@
 /**
  * Function: Board_init
  * @return None.
- * @remark Initializes the Serial interface and enables interrupts.
+ * @remark Sets up the clocks for the board profile, and enables interrupts.
+ *  Call it before anything else, the peripherals take the bus clock it
+ *  sets.
  * @author David Goodman
  * @date 2013.01.18  */
 void Board_init();
 
 /**
  * Function: Board_GetPBClock
- * @return System bus speed in hertz.
+ * @return Peripheral bus speed in hertz, BOARD_PB_CLOCK.
  * @author David Goodman
  * @date 2013.01.18  */
 uint32_t Board_GetPBClock();
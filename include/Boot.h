@@ -0,0 +1,118 @@
+/**
+ * @file    Boot.h
+ *
+ * @brief
+ * Bring-up of the modules in the background, and whether they're up.
+ *
+ * @details
+ * Every module used to be initialized in turn before the main loop, so
+ * the board was only usable once the slowest of them was. Here each
+ * module's bring-up is a step function, a small state machine that
+ * starts a transfer or checks on one and returns straight away, and
+ * Boot_runSM calls every one that isn't done yet on each pass. A module
+ * that was already brought up in the background, like the XBee or the
+ * GPS configuration, just reports whether it's there.
+ *
+ * Modules are added as required or not. Boot_isReady is TRUE as soon as
+ * every required one is up, whatever the others are doing, so the
+ * operator can start with the subset that matters. Each change of status
+ * is printed with the time it took since Boot_init.
+ *
+ * BOOT_TEST (in the .c file) conditionally compiles the test harness.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef Boot_H
+#define Boot_H
+
+#include <stdint.h>
+#include "Board.h"
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define BOOT_MODULE_MAX     10
+#define BOOT_INVALID        0xFF
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+typedef enum {
+    BOOT_PENDING = 0,   // still coming up
+    BOOT_READY,         // up
+    BOOT_FAILED,        // gave up, it won't come up without a restart
+} BootStatus;
+
+// One step of a module's bring-up, returns where it got to
+typedef BootStatus (*BootStep)();
+
+typedef uint8_t BootId;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: Boot_init()
+ * @return None
+ * @remark Forgets every module, and starts the clock the ready times
+ *  are taken from. Needs Timer_init.
+ **********************************************************************/
+void Boot_init();
+
+/**********************************************************************
+ * Function: Boot_add()
+ * @param Name to print, which must outlive the module.
+ * @param Its bring-up step, called until it returns BOOT_READY or
+ *  BOOT_FAILED.
+ * @param Whether Boot_isReady waits for it.
+ * @return Its id, or BOOT_INVALID if BOOT_MODULE_MAX are added.
+ * @remark The step is first called by Boot_runSM, not here.
+ **********************************************************************/
+BootId Boot_add(const char *name, BootStep step, BOOL isRequired);
+
+/**********************************************************************
+ * Function: Boot_runSM()
+ * @return None
+ * @remark Calls the step of every module still coming up, once each.
+ *  Schedule it as a task, it does nothing once they're all done.
+ **********************************************************************/
+void Boot_runSM();
+
+/**********************************************************************
+ * Function: Boot_getStatus()
+ * @param Module id from Boot_add.
+ * @return Its status, BOOT_FAILED for an id that wasn't added.
+ **********************************************************************/
+BootStatus Boot_getStatus(BootId id);
+
+/**********************************************************************
+ * Function: Boot_isReady()
+ * @return TRUE once every required module is up.
+ **********************************************************************/
+BOOL Boot_isReady();
+
+/**********************************************************************
+ * Function: Boot_hasFailed()
+ * @return TRUE if a required module failed, so Boot_isReady never will
+ *  be.
+ **********************************************************************/
+BOOL Boot_hasFailed();
+
+/**********************************************************************
+ * Function: Boot_getReadyTime()
+ * @return (ms) From Boot_init until every required module was up, or 0
+ *  before then.
+ **********************************************************************/
+uint32_t Boot_getReadyTime();
+
+/**********************************************************************
+ * Function: Boot_printStatus()
+ * @return None
+ * @remark Prints each module with its status, and when it got there.
+ **********************************************************************/
+void Boot_printStatus();
+
+#endif // Boot_H
@@ -8,6 +8,7 @@
 #ifndef ENCODER_H
 #define	ENCODER_H
 
+#include "Board.h"
 
 /*******************************************************************************
  * Public Functions                                                            *
@@ -26,9 +27,10 @@ void Encoder_init();
 /**
  * Function: Encoder_runSM
  * @return None.
- * @remark Accumulates angles for both encoders and calculates distances.
- *  TODO: BREAK UP INTO STEPS
- *  TODO: Absorb button presses into this function and make true state machine.
+ * @remark Reads both encoders once each, into a window of their last 32
+ *  readings. Run it at a steady rate, usually off the sensor schedule
+ *  (see Sensors.h), so the angles are always a recent average and getting
+ *  one never touches the bus.
  * @author David Goodman
  * @date 2013.02.10  */
 void Encoder_runSM();
@@ -36,11 +38,28 @@ void Encoder_runSM();
 /**
  * Function: Encoder_setZeroAngle
  * @return None.
- * @remark Zeros both encoders at the current positions.
+ * @remark Zeros both encoders at their current mean angles.
  * @author David Goodman
  * @date 2013.02.10  */
 void Encoder_setZeroAngle();
 
+/**
+ * Function: Encoder_getZeroAngles
+ * @param Where to put the pitch zero, a binary angle.
+ * @param And the yaw zero.
+ * @return None.
+ * @remark For keeping them across boots, see Encoder_setZeroAngles.
+ * @date 2026.10.14  */
+void Encoder_getZeroAngles(uint16_t *pitch, uint16_t *yaw);
+
+/**
+ * Function: Encoder_setZeroAngles
+ * @param Pitch zero, a binary angle from Encoder_getZeroAngles.
+ * @param Yaw zero.
+ * @return None.
+ * @date 2026.10.14  */
+void Encoder_setZeroAngles(uint16_t pitch, uint16_t yaw);
+
 
 /**
  * Function: Encoder_enableZeroAngle
@@ -61,7 +80,7 @@ void Encoder_disableZeroAngle();
 /**
  * Function: Encoder_getPitch
  * @return Current angle of pitch encoder in decimal degrees.
- * @remark 
+ * @remark Mean of the recent readings from Encoder_runSM.
  * @author David Goodman
  * @date 2013.03.10  */
 float Encoder_getPitch();
@@ -69,9 +88,16 @@ float Encoder_getPitch();
 /**
  * Function: Encoder_getYaw
  * @return Current angle of yaw encoder in decimal degrees.
- * @remark 
+ * @remark Mean of the recent readings from Encoder_runSM.
  * @author David Goodman
  * @date 2013.03.10  */
 float Encoder_getYaw();
 
+/**
+ * Function: Encoder_isReady
+ * @return TRUE once both windows are full, so the angles are a whole
+ *  window's mean and not a few readings'.
+ * @date 2026.10.14  */
+BOOL Encoder_isReady();
+
 #endif
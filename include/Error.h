@@ -3,6 +3,14 @@
  *
  * An error handling module.
  *
+ * Besides the last error code, every error and event is kept in a ring
+ * of ERROR_LOG_LENGTH with when it happened, the module it came from and
+ * an argument, so a failure in the field can be pieced together after,
+ * from a normal build. Error_log takes the same few instructions every
+ * time and is safe from an interrupt. The ring is read back oldest first
+ * with Error_read, printed with Error_print, or sent as ERROR_EVENT
+ * messages with Mavlink_send_error_events.
+ *
  */
 #ifndef Error_H
 #define Error_H
@@ -19,6 +27,37 @@
 #define ERROR_TIMER_OFF 4
 #define ERROR_SERIAL_NOTREADY 5
 #define ERROR_SERIAL_DISCONNECTED 6
+#define ERROR_I2C_LOCKUP 7 // arg is the bus
+#define ERROR_GPS_DROPOUT 8 // fix lost, arg is the fix status
+#define ERROR_GPS_FIX 9 // fix back
+#define ERROR_LINK_LOST 10 // no heartbeat, arg is the loss (%)
+#define ERROR_LINK_RESTORED 11
+#define ERROR_ACK_DEAD 12 // never acknowledged, arg is the message name
+
+// Modules events are logged from
+#define ERROR_MODULE_NONE 0 // from error()
+#define ERROR_MODULE_QUEUE 1
+#define ERROR_MODULE_TIMER 2
+#define ERROR_MODULE_SERIAL 3
+#define ERROR_MODULE_I2C 4
+#define ERROR_MODULE_GPS 5
+#define ERROR_MODULE_XBEE 6
+#define ERROR_MODULE_MAVLINK 7
+
+#define ERROR_LOG_LENGTH 32 // events, a power of two
+
+// What Error_log does when the ring is full
+#define ERROR_LOG_OVERWRITE 0 // drops the oldest, keeps the latest
+#define ERROR_LOG_KEEP_FIRST 1 // drops the new one, keeps what led up
+
+// Types
+
+typedef struct {
+    uint32_t time; // (ms) get_time() it was logged at
+    uint16_t arg;
+    uint8_t module;
+    uint8_t code;
+} ErrorEvent;
 
 /**********************************************************************
  * PUBLIC FUNCTIONS                                                   *
@@ -28,7 +67,7 @@
  * Function: error()
  * @param An error code to set.
  * @return none
- * @remark none
+ * @remark Also logs it, from ERROR_MODULE_NONE.
  **********************************************************************/
 void error(uint8_t code);
 
@@ -38,7 +77,7 @@ void error(uint8_t code);
  * @remark none
  **********************************************************************/
 uint8_t get_error();
-    
+
 
 /**********************************************************************
  * Function: has_error()
@@ -54,5 +93,52 @@ uint8_t has_error();
  **********************************************************************/
 void clear_error();
 
+/**********************************************************************
+ * Function: Error_log()
+ * @param Module it happened in, ERROR_MODULE_*.
+ * @param Error code.
+ * @param Anything that goes with it.
+ * @return none
+ * @remark Stamped with get_time(). Safe from an interrupt.
+ **********************************************************************/
+void Error_log(uint8_t module, uint8_t code, uint16_t arg);
+
+/**********************************************************************
+ * Function: Error_read()
+ * @param Set to the oldest event.
+ * @return A true value if there was one, it's taken out of the ring.
+ * @remark none
+ **********************************************************************/
+uint8_t Error_read(ErrorEvent *event);
+
+/**********************************************************************
+ * Function: Error_getCount()
+ * @return Events waiting to be read.
+ * @remark none
+ **********************************************************************/
+uint8_t Error_getCount();
+
+/**********************************************************************
+ * Function: Error_getDropped()
+ * @return Events lost to a full ring since startup.
+ * @remark Overwritten or refused, depending on the policy.
+ **********************************************************************/
+uint16_t Error_getDropped();
+
+/**********************************************************************
+ * Function: Error_setPolicy()
+ * @param ERROR_LOG_OVERWRITE, the default, or ERROR_LOG_KEEP_FIRST.
+ * @return none
+ * @remark none
+ **********************************************************************/
+void Error_setPolicy(uint8_t policy);
+
+/**********************************************************************
+ * Function: Error_print()
+ * @return none
+ * @remark Prints and reads every event waiting, oldest first.
+ **********************************************************************/
+void Error_print();
+
 #endif
 
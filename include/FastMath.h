@@ -0,0 +1,131 @@
+/**
+ * @file    FastMath.h
+ *
+ * @brief
+ * Single precision and fixed-point trigonometry for the hot paths.
+ *
+ * @details
+ * The PIC32MX has no FPU, so every libm sin/cos/atan2 is a long software
+ * routine, and most of them run in double. The float functions here reduce
+ * the angle to an octant and evaluate a short minimax polynomial in float,
+ * which stays within 1e-6 rad (or 1e-6 absolute for sin and cos) of the
+ * true value for |angle| < 10000 rad. That covers anything the boat and
+ * the command center use, which is a few turns at most.
+ *
+ * The fixed-point functions work on binary angles, where the full 16 bits
+ * are one turn (65536 = 360 degrees, about 0.0055 degrees per count), so
+ * wrapping is free. They use a quarter-wave table with linear
+ * interpolation and return Q15 values, which are within one count of the
+ * rounded true value. The encoders read out a 14-bit binary angle, so
+ * shifting left by two gives one of these directly.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef FastMath_H
+#define FastMath_H
+
+#include <stdint.h>
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define FASTMATH_PI             3.14159265358979f
+#define FASTMATH_HALF_PI        1.57079632679490f
+#define FASTMATH_TWO_PI         6.28318530717959f
+
+// Binary angle, 65536 counts per turn
+#define ANGLE16_TURN            65536L
+#define ANGLE16_HALF_TURN       32768L
+#define ANGLE16_QUARTER_TURN    16384L
+
+#define ANGLE16_TO_DEGREES(a)   ((float)(a) * (360.0f / ANGLE16_TURN))
+#define ANGLE16_TO_RADIANS(a)   ((float)(a) * (FASTMATH_TWO_PI / ANGLE16_TURN))
+#define DEGREES_TO_ANGLE16(d)   ((uint16_t)(int32_t)((d) * (ANGLE16_TURN / 360.0f)))
+#define RADIANS_TO_ANGLE16(r)   \
+    ((uint16_t)(int32_t)((r) * (ANGLE16_TURN / FASTMATH_TWO_PI)))
+
+// Q15 fixed-point, 32767 is just under 1.0
+#define Q15_ONE                 32768L
+#define Q15_TO_FLOAT(q)         ((float)(q) * (1.0f / Q15_ONE))
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: FastMath_sin()
+ * @param Angle in radians.
+ * @return The sine of the angle.
+ **********************************************************************/
+float FastMath_sin(float angle);
+
+/**********************************************************************
+ * Function: FastMath_cos()
+ * @param Angle in radians.
+ * @return The cosine of the angle.
+ **********************************************************************/
+float FastMath_cos(float angle);
+
+/**********************************************************************
+ * Function: FastMath_sinCos()
+ * @param Angle in radians.
+ * @param Where to store the sine.
+ * @param Where to store the cosine.
+ * @return none
+ * @remark Shares the range reduction, so it costs about the same as one
+ *  of FastMath_sin or FastMath_cos.
+ **********************************************************************/
+void FastMath_sinCos(float angle, float *sine, float *cosine);
+
+/**********************************************************************
+ * Function: FastMath_tan()
+ * @param Angle in radians.
+ * @return The tangent of the angle.
+ * @remark Divides the sine by the cosine, so the error grows like 1/cos^2
+ *  near +/-90 degrees.
+ **********************************************************************/
+float FastMath_tan(float angle);
+
+/**********************************************************************
+ * Function: FastMath_atan2()
+ * @param Y component.
+ * @param X component.
+ * @return Angle of (x, y) in radians, from -PI to PI, or 0 for (0, 0).
+ **********************************************************************/
+float FastMath_atan2(float y, float x);
+
+/**********************************************************************
+ * Function: FastMath_fourthRoot()
+ * @param Value.
+ * @return Its fourth root, within 1e-6 of the true value relative to it,
+ *  or 0 for a value that isn't positive.
+ * @remark A bit-level first guess at the inverse fourth root and three
+ *  Newton steps, which need no divide or sqrt.
+ **********************************************************************/
+float FastMath_fourthRoot(float value);
+
+/**********************************************************************
+ * Function: FastMath_sinQ15()
+ * @param Binary angle.
+ * @return The sine of the angle in Q15.
+ **********************************************************************/
+int16_t FastMath_sinQ15(uint16_t angle);
+
+/**********************************************************************
+ * Function: FastMath_cosQ15()
+ * @param Binary angle.
+ * @return The cosine of the angle in Q15.
+ **********************************************************************/
+int16_t FastMath_cosQ15(uint16_t angle);
+
+/**********************************************************************
+ * Function: FastMath_atan2Angle16()
+ * @param Y component.
+ * @param X component.
+ * @return Binary angle of (x, y), or 0 for (0, 0).
+ * @remark Any scale works, only the ratio of the components matters.
+ **********************************************************************/
+uint16_t FastMath_atan2Angle16(int32_t y, int32_t x);
+
+#endif // FastMath_H
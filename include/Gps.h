@@ -26,6 +26,93 @@
  * PUBLIC DEFINITIONS                                                  *
  ***********************************************************************/
 
+// Units of the fixed-point coordinates
+#define GPS_COORDINATE_SCALE    10000000L // per degree of latitude or longitude
+#define GPS_ALTITUDE_SCALE      1000L // per meter of altitude
+
+// Options for GPS_init
+#define GPS_OPTION_PVT      0x01 // use NAV-PVT (u-blox 7 and newer only)
+#define GPS_OPTION_NO_CONFIG 0x02 // receiver was configured by hand
+#define GPS_OPTION_SAVED    0x04 // receiver kept the last configuration
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+// Receive counters for the GPS link, see GPS_getStats
+typedef struct GpsStats {
+    uint32_t messages;          // messages that passed the checksum
+    uint32_t bytesSkipped;      // bytes seen outside of a message
+    uint16_t checksumErrors;    // messages rejected for a bad checksum
+    uint16_t lengthErrors;      // messages too long for the buffer
+    uint32_t fixes;             // fixes added to the history
+} GpsStats;
+
+// Position in the receiver's own units, see GPS_getCoordinate
+typedef struct GpsCoordinate {
+    int32_t latitude;           // (1e-7 degrees)
+    int32_t longitude;          // (1e-7 degrees)
+    int32_t altitude;           // (mm) above mean sea level
+} GpsCoordinate;
+
+// Differential correction from a base station, see GPS_getCorrection
+typedef struct GpsCorrection {
+    uint32_t iTOW;              // (ms) GPS time of week of the base's fix
+    int32_t latitude;           // (1e-7 degrees) error, fix minus surveyed
+    int32_t longitude;          // (1e-7 degrees) error, fix minus surveyed
+} GpsCorrection;
+
+// One position fix, see GPS_getFixAt
+typedef struct GpsFix {
+    uint32_t time;              // (ms) local get_time() it was received at
+    uint32_t iTOW;              // (ms) GPS time of week of the epoch
+    int32_t latitude;           // (1e-7 degrees)
+    int32_t longitude;          // (1e-7 degrees)
+    int32_t altitude;           // (mm) above mean sea level
+    int32_t north, east;        // (cm/s) velocity
+} GpsFix;
+
+/**********************************************************************
+ * Function: GPS_init()
+ * @param Options to start the GPS with, GPS_OPTION_* flags or 0x0.
+ * @return SUCCESS or FAILURE.
+ * @remark Starts the GPS UART and the receiver auto-configuration, which
+ *  GPS_runSM carries out without blocking: the receiver is switched to
+ *  115200 baud, a 5 Hz navigation rate and the messages we decode. With
+ *  GPS_OPTION_PVT it is told to send only NAV-PVT, one message per epoch
+ *  instead of three. Leave that off for u-blox 6 receivers (like the
+ *  LEA-6), which lack NAV-PVT. GPS_OPTION_NO_CONFIG skips all of this
+ *  and stays at 38400 baud. The configuration is saved in the receiver,
+ *  and with GPS_OPTION_SAVED (see GPS_isConfigSaved) only checked, at
+ *  115200 baud, falling back to all of it if the receiver lost it.
+ **********************************************************************/
+BOOL GPS_init(uint8_t options);
+
+/**********************************************************************
+ * Function: GPS_isConfigured()
+ * @return TRUE once the receiver has acknowledged the auto-configuration.
+ * @remark none
+ **********************************************************************/
+BOOL GPS_isConfigured();
+
+/**********************************************************************
+ * Function: GPS_isConfigSaved()
+ * @return TRUE once the receiver has acknowledged saving the
+ *  configuration, or still had it with GPS_OPTION_SAVED.
+ * @remark So GPS_OPTION_SAVED can be given next time.
+ **********************************************************************/
+BOOL GPS_isConfigSaved();
+
+/**********************************************************************
+ * Function: GPS_setWarmStart()
+ * @param Position the receiver was last at.
+ * @param (m) How far it could be from there now.
+ * @return None
+ * @remark Sent as an AID-INI once the configuration is done, so the
+ *  receiver only searches for the satellites above it.
+ **********************************************************************/
+void GPS_setWarmStart(const GpsCoordinate *position, uint32_t accuracy);
+
 /**********************************************************************
  * Function: GPS_isInitialized()
  * @return Whether the GPS was initialized.
@@ -47,6 +134,123 @@ void GPS_runSM();
  **********************************************************************/
 BOOL GPS_hasFix();
 
+/**********************************************************************
+ * Function: GPS_hasPosition
+ * @return TRUE if a position has been obtained.
+ * @remark
+ **********************************************************************/
+BOOL GPS_hasPosition();
+
+/**********************************************************************
+ * Function: GPS_getCoordinate
+ * @param Where to store the position.
+ * @return None
+ * @remark The current position with error correction applied, in 1e-7
+ *  degrees and millimeters. Prefer this to the float getters, a float
+ *  only holds a coordinate to about a meter and costs a soft-float
+ *  conversion on the PIC32MX.
+ **********************************************************************/
+void GPS_getCoordinate(GpsCoordinate *coord);
+
+/**********************************************************************
+ * Function: GPS_getLatitudeFixed
+ * @return The GPS's latitude value (N/S) in degrees scaled 1e7.
+ * @remark Error correction applied.
+ **********************************************************************/
+int32_t GPS_getLatitudeFixed();
+
+/**********************************************************************
+ * Function: GPS_getLongitudeFixed
+ * @return The GPS's longitude value (E/W) in degrees scaled 1e7.
+ * @remark Error correction applied.
+ **********************************************************************/
+int32_t GPS_getLongitudeFixed();
+
+/**********************************************************************
+ * Function: GPS_getAltitudeFixed
+ * @return The GPS's altitude value in millimeters.
+ * @remark
+ **********************************************************************/
+int32_t GPS_getAltitudeFixed();
+
+/**********************************************************************
+ * Function: GPS_setError
+ * @param Error in the position, altitude is not used.
+ * @return None
+ * @remark Sets the error subtracted from the position when error
+ *  correction is enabled, in 1e-7 degrees.
+ **********************************************************************/
+void GPS_setError(const GpsCoordinate *coordError);
+
+/**********************************************************************
+ * Function: GPS_setBasePosition
+ * @param Surveyed position of the antenna.
+ * @return None
+ * @remark Makes this GPS a differential base station.
+ **********************************************************************/
+void GPS_setBasePosition(const GpsCoordinate *surveyed);
+
+/**********************************************************************
+ * Function: GPS_startSurvey
+ * @param Number of fixes to average into the base position.
+ * @return None
+ * @remark For a base station with no surveyed position. The boats'
+ *  positions then agree with the base's, but share its absolute error.
+ **********************************************************************/
+void GPS_startSurvey(uint16_t fixes);
+
+/**********************************************************************
+ * Function: GPS_isSurveyed
+ * @return TRUE once the base position is known.
+ * @remark none
+ **********************************************************************/
+BOOL GPS_isSurveyed();
+
+/**********************************************************************
+ * Function: GPS_getCorrection
+ * @param Where to store the correction.
+ * @return SUCCESS, or FAILURE without a base position or a current fix.
+ * @remark Base station side, the error in the newest fix.
+ **********************************************************************/
+int8_t GPS_getCorrection(GpsCorrection *correction);
+
+/**********************************************************************
+ * Function: GPS_addCorrection
+ * @param Correction received from the base station.
+ * @return None
+ * @remark Boat side. Enables error correction with the age weighted mean
+ *  of the last few corrections, matched against each new fix's GPS time.
+ **********************************************************************/
+void GPS_addCorrection(const GpsCorrection *correction);
+
+/**********************************************************************
+ * Function: GPS_setLatitudeError
+ * @return None
+ * @remark Sets the latitudal error for error corrections (1e-7 degrees).
+ **********************************************************************/
+void GPS_setLatitudeError(int32_t latError);
+
+/**********************************************************************
+ * Function: GPS_setLongitudeError
+ * @return None
+ * @remark Sets the longitudal error for error corrections (1e-7 degrees).
+ **********************************************************************/
+void GPS_setLongitudeError(int32_t lonError);
+
+/**********************************************************************
+ * Function: GPS_enableErrorCorrection
+ * @return None
+ * @remark Enables error correction for retreived coordinates.
+ **********************************************************************/
+void GPS_enableErrorCorrection();
+
+/**********************************************************************
+ * Function: GPS_disableErrorCorrection
+ * @return None
+ * @remark Disables error correction for retreived coordinates.
+ **********************************************************************/
+void GPS_disableErrorCorrection();
+
 /**********************************************************************
  * Function: GPS_getLatitude
  * @return The GPS's latitude value in decimal degrees (N/S).
@@ -83,6 +287,13 @@ int32_t GPS_getNorthVelocity();
 int32_t GPS_getEastVelocity();
 
 
+/**********************************************************************
+ * Function: GPS_getHorizontalAccuracy
+ * @return Returns the estimated horizontal accuracy of the last fix.
+ * @remark In millimeters.
+ **********************************************************************/
+uint32_t GPS_getHorizontalAccuracy();
+
 /**********************************************************************
  * Function: GPS_getHeading
  * @return Returns the current heading in degrees scaled 1e-5.
@@ -98,4 +309,41 @@ int32_t GPS_getHeading();
  **********************************************************************/
 int32_t GPS_isConnected();
 
+/**********************************************************************
+ * Function: GPS_getFixAt
+ * @param Local time, from get_time(), to get the position at.
+ * @param Where to store the fix.
+ * @return SUCCESS, or FAILURE if there are no recent fixes.
+ * @remark Interpolates the position at a given moment from the last few
+ *  fixes (or extrapolates up to a second past the newest), so an event
+ *  like a Lock press can be matched to where the boat was at the time.
+ *  The position has no error correction applied.
+ **********************************************************************/
+int8_t GPS_getFixAt(uint32_t time, GpsFix *fix);
+
+/**********************************************************************
+ * Function: GPS_getLastFix
+ * @param Where to store the fix.
+ * @return SUCCESS, or FAILURE if there have been no fixes.
+ * @remark Copies the newest fix in the history, a change in its time
+ *  means a new fix came in.
+ **********************************************************************/
+int8_t GPS_getLastFix(GpsFix *fix);
+
+/**********************************************************************
+ * Function: GPS_getStats
+ * @param Where to copy the counters.
+ * @return None
+ * @remark Takes a snapshot of the GPS link counters, to tell how close
+ *  the link is running to its error margin.
+ **********************************************************************/
+void GPS_getStats(GpsStats *copy);
+
+/**********************************************************************
+ * Function: GPS_clearStats
+ * @return None
+ * @remark Zeroes the GPS link counters.
+ **********************************************************************/
+void GPS_clearStats();
+
 #endif
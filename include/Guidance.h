@@ -0,0 +1,113 @@
+/**
+ * @file    Guidance.h
+ *
+ * @brief
+ * Waypoint guidance and heading-hold for the boat.
+ *
+ * @details
+ * Takes a rescue target, and every GUIDANCE_PERIOD works out the bearing
+ * and range to it from the navigation estimate, then runs a PID on the
+ * heading error into the rudder and a PI on the speed into the throttle.
+ * Both commands are slew limited so a new target can't slam the rudder
+ * over, and the boat slows down as it gets close and stops inside the
+ * arrival radius. With USE_SENSOR_FUSION the filtered pose is used,
+ * otherwise the raw GPS position and the magnetometer heading.
+ *
+ * The rudder and throttle are driven through motor drivers that take a
+ * PWM duty cycle, on the channels set by GUIDANCE_RUDDER_PWM and
+ * GUIDANCE_THROTTLE_PWM.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef Guidance_H
+#define Guidance_H
+
+#include <stdint.h>
+#include "Gps.h"
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define GUIDANCE_PERIOD         50 // (ms) 20 Hz control loop
+#define GUIDANCE_ARRIVAL_RADIUS 3.0f // (m)
+
+#ifndef GUIDANCE_RUDDER_PWM
+#define GUIDANCE_RUDDER_PWM     PWM_PORTY10
+#define GUIDANCE_THROTTLE_PWM   PWM_PORTY04
+#endif
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+typedef enum {
+    GUIDANCE_IDLE = 0,  // no target, motors off
+    GUIDANCE_TRACKING,  // steering to the target
+    GUIDANCE_HOLDING,   // have a target but no position, motors off
+    GUIDANCE_ARRIVED,   // inside the arrival radius, motors off
+} GuidanceState;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: Guidance_init()
+ * @return SUCCESS or FAILURE.
+ * @remark Starts the PWM channels with the motors off.
+ **********************************************************************/
+BOOL Guidance_init();
+
+/**********************************************************************
+ * Function: Guidance_runSM()
+ * @return None
+ * @remark Runs one control step every GUIDANCE_PERIOD, call it from the
+ *  main loop after Navigation_runSM.
+ **********************************************************************/
+void Guidance_runSM();
+
+/**********************************************************************
+ * Function: Guidance_setTarget()
+ * @param Where to go.
+ * @return None
+ * @remark Starts tracking the target, the controller state is reset.
+ **********************************************************************/
+void Guidance_setTarget(const GpsCoordinate *target);
+
+/**********************************************************************
+ * Function: Guidance_moveTarget()
+ * @param Where the target is now.
+ * @return None
+ * @remark For a target that's being tracked as it moves, the controller
+ *  carries on. Starts tracking like Guidance_setTarget if it wasn't.
+ **********************************************************************/
+void Guidance_moveTarget(const GpsCoordinate *target);
+
+/**********************************************************************
+ * Function: Guidance_stop()
+ * @return None
+ * @remark Drops the target and turns the motors off.
+ **********************************************************************/
+void Guidance_stop();
+
+/**********************************************************************
+ * Function: Guidance_getState()
+ * @return The guidance state.
+ **********************************************************************/
+GuidanceState Guidance_getState();
+
+/**********************************************************************
+ * Function: Guidance_getRange()
+ * @return Distance to the target in meters, as of the last step.
+ **********************************************************************/
+float Guidance_getRange();
+
+/**********************************************************************
+ * Function: Guidance_getBearing()
+ * @return Bearing to the target in degrees from north, as of the last
+ *  step.
+ **********************************************************************/
+float Guidance_getBearing();
+
+#endif // Guidance_H
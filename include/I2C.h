@@ -10,6 +10,30 @@
  * @details
  * This interface is for communication with devices of I2C.
  *
+ * Besides the byte level functions, which wait on the bus for every step,
+ * whole transfers can be queued with I2C_submit. A transfer writes some
+ * bytes to a device and then, after a repeated start, reads some back.
+ * The master interrupt runs the start, address, data, acknowledge and
+ * stop sequence by itself, so the main loop is free while it happens,
+ * and the transfer's callback is called from the interrupt when it's
+ * done. Don't mix the two on one bus while a transfer is queued.
+ *
+ * Nothing here waits on the bus forever. Every byte level wait gives up
+ * after I2C_WAIT_TIMEOUT, and a transfer that runs past twice its time
+ * on the wire (plus I2C_TIMEOUT_MARGIN) ends with I2C_TRANSFER_TIMEOUT.
+ * A timeout, or a start that can't get the bus, recovers it by clocking
+ * SCL nine times by hand, which lets a device that was cut off mid-byte
+ * finish and release SDA, and then sending a stop. Blocking transfers
+ * check their own time, queued ones are checked every millisecond by a
+ * Timer callback, so that needs Timer_init before I2C_init. The outcome
+ * of every transfer is counted per device, see I2C_getDeviceErrors.
+ *
+ * Devices on one bus don't all take the same clock. The bus runs at the
+ * slowest clock any I2C_init call asked for, and a driver whose device
+ * is faster registers it with I2C_addDevice. Every transfer then runs
+ * at its own device's clock, the baud rate being changed between
+ * transfers only when it differs from the last one.
+ *
  * @date January 21, 2013, 3:42 PM  -- Created
  */
 
@@ -28,6 +52,67 @@
 //#define I2C_ACK             1
 //#define I2C_NACK            0
 
+// Most data bytes I2C_writeRegisters sends after the register address
+#define I2C_WRITE_MAX       16
+
+// Longest a byte level function waits for one step of the bus (us)
+#define I2C_WAIT_TIMEOUT    500
+
+// Added to twice the time a transfer needs on the wire (us)
+#define I2C_TIMEOUT_MARGIN  200
+
+// Devices that get error counters, across both buses
+#define I2C_DEVICE_MAX      8
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef enum {
+    I2C_TRANSFER_IDLE = 0,      // never submitted
+    I2C_TRANSFER_QUEUED,        // waiting for the bus
+    I2C_TRANSFER_BUSY,          // on the bus now
+    I2C_TRANSFER_DONE,          // finished, read bytes are in place
+    I2C_TRANSFER_NACK,          // the device didn't acknowledge
+    I2C_TRANSFER_COLLISION,     // lost the bus to another master or a glitch
+    I2C_TRANSFER_TIMEOUT,       // the bus got stuck, it was recovered
+} I2CTransferStatus;
+
+// How the transfers to one device went
+typedef struct {
+    uint32_t transfers;
+    uint32_t nacks;
+    uint32_t collisions;
+    uint32_t timeouts;
+} I2CDeviceErrors;
+
+struct I2CTransfer;
+
+/**
+ * Called from the I2C interrupt when a transfer finishes, whether it
+ * worked or not, or with interrupts off when it timed out. Keep it
+ * short, like Scheduler_signal, or submit the next transfer.
+ */
+typedef void (*I2CCallback)(struct I2CTransfer *transfer);
+
+/**
+ * One queued transfer. Fill in everything above status, and keep the
+ * struct and its buffers alive until it finishes.
+ */
+typedef struct I2CTransfer {
+    uint8_t address;            // 7-bit device address
+    const uint8_t *write;       // sent first, usually the register
+    uint8_t writeLength;
+    uint8_t *read;              // then read after a repeated start
+    uint8_t readLength;
+    I2CCallback callback;       // or NULL
+    void *context;              // for the callback
+    volatile I2CTransferStatus status;
+    struct I2CTransfer *next;   // used by the queue
+} I2CTransfer;
+
+#define I2C_IS_FINISHED(status) ((status) >= I2C_TRANSFER_DONE)
+
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
  ******************************************************************************/
@@ -89,7 +174,9 @@ int16_t I2C_getData(I2C_MODULE I2C_ID);
  * @param I2C_ID, The I2C bus line that will be used
  * @param I2C_clockFreq, The desired frequency for the I2C bus
  * @return None.
- * @remark Turns on the I2C bus line specified and sets the frequency on it.
+ * @remark Turns on the I2C bus line specified and sets the frequency on it,
+ * and sets up its interrupt for I2C_submit. Called more than once, the
+ * bus keeps the slowest frequency, see I2C_addDevice for faster devices.
  * @author Shehadeh H. Dajani
  * @date 2013.01.21  */
 void I2C_init(I2C_MODULE I2C_ID, uint32_t I2C_clockFreq);
@@ -112,5 +199,85 @@ void I2C_acknowledgeRead(I2C_MODULE I2C_ID, BOOL ack);
  * @date 2013.01.21  */
 BOOL I2C_hasAcknowledged(I2C_MODULE I2C_ID);
 
+/**
+ * Function: I2C_submit
+ * @param I2C bus line that will be used.
+ * @param Transfer to queue, see I2CTransfer.
+ * @return SUCCESS, or FAILURE if the bus has no interrupt set up or the
+ *  transfer is already queued.
+ * @remark Returns right away. The transfer starts as soon as the ones
+ *  queued before it are done, and its status and callback tell when it
+ *  finished. Also safe to call from a transfer's callback.
+ * @date 2026.10.14  */
+BOOL I2C_submit(I2C_MODULE I2C_ID, I2CTransfer *transfer);
+
+/**
+ * Function: I2C_transfer
+ * @param I2C bus line that will be used.
+ * @param Transfer to run.
+ * @return The finished status, I2C_TRANSFER_DONE if it worked.
+ * @remark Submits the transfer and waits for it, for drivers that need
+ *  the answer straight away.
+ * @date 2026.10.14  */
+I2CTransferStatus I2C_transfer(I2C_MODULE I2C_ID, I2CTransfer *transfer);
+
+/**
+ * Function: I2C_isBusy
+ * @param I2C bus line that will be used.
+ * @return TRUE if a transfer is queued or running.
+ * @date 2026.10.14  */
+BOOL I2C_isBusy(I2C_MODULE I2C_ID);
+
+/**
+ * Function: I2C_readRegisters
+ * @param I2C bus line that will be used.
+ * @param 7-bit device address.
+ * @param First register to read.
+ * @param Where to store the bytes.
+ * @param Number of bytes to read.
+ * @return SUCCESS, or FAILURE if the device didn't answer.
+ * @remark One burst transaction: the register address, a repeated start
+ *  and every byte, for devices that step through their registers on each
+ *  read. Blocks until it finishes.
+ * @date 2026.10.14  */
+BOOL I2C_readRegisters(I2C_MODULE I2C_ID, uint8_t address, uint8_t reg,
+    uint8_t *data, uint8_t length);
+
+/**
+ * Function: I2C_writeRegisters
+ * @param I2C bus line that will be used.
+ * @param 7-bit device address.
+ * @param First register to write.
+ * @param Bytes to write.
+ * @param Number of bytes, at most I2C_WRITE_MAX.
+ * @return SUCCESS, or FAILURE if the device didn't answer or there are
+ *  too many bytes.
+ * @remark One burst transaction: the register address and every byte.
+ *  Blocks until it finishes.
+ * @date 2026.10.14  */
+BOOL I2C_writeRegisters(I2C_MODULE I2C_ID, uint8_t address, uint8_t reg,
+    const uint8_t *data, uint8_t length);
+
+/**
+ * Function: I2C_addDevice
+ * @param I2C bus line that will be used.
+ * @param 7-bit device address.
+ * @param Fastest clock the device takes (Hz), or 0 for the bus default.
+ * @return SUCCESS, or FAILURE if I2C_DEVICE_MAX devices are known.
+ * @remark Transfers to the device run at that clock from then on.
+ * @date 2026.10.14  */
+BOOL I2C_addDevice(I2C_MODULE I2C_ID, uint8_t address, uint32_t maxClock);
+
+/**
+ * Function: I2C_getDeviceErrors
+ * @param I2C bus line that will be used.
+ * @param 7-bit device address.
+ * @param Set to the device's counters.
+ * @return SUCCESS, or FAILURE if nothing was sent to the device yet.
+ * @remark Only the first I2C_DEVICE_MAX devices are counted.
+ * @date 2026.10.14  */
+BOOL I2C_getDeviceErrors(I2C_MODULE I2C_ID, uint8_t address,
+    I2CDeviceErrors *errors);
+
 
 #endif // I2C_H
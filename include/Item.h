@@ -4,31 +4,91 @@
  * An item that goes into a queue. Implemented similarly to a node in a
  * linked list.
  *
+ * Items come from a pool of ITEM_POOL_SIZE set aside at compile time,
+ * not the heap, so creating and destroying them costs the same every
+ * time and never fragments anything. Both are safe from an interrupt.
+ *
+ * An item points at its data where it already is, a UART frame or a
+ * MAVLink message, so nothing is copied. A payload of ITEM_INLINE_SIZE
+ * or less can be copied into the item instead with Item_createInline,
+ * so it needs no buffer of its own. An ITEM can also be a member of the
+ * struct it carries, set up with Item_init, and the struct found again
+ * from the item with ITEM_CONTAINER.
+ *
+ * The accessors are macros, so the queue's hot path is a field read, not
+ * a call.
+ *
  */
 #ifndef Item_H
 #define Item_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "Util.h"
 
 /***********************************************************************
  * PUBLIC DEFINITIONS                                                  *
  ***********************************************************************/
 
-#define QUEUE_MAX_SIZE 60 
+#define QUEUE_MAX_SIZE 60
+
+#define ITEM_POOL_SIZE QUEUE_MAX_SIZE // items, shared by every queue
+#define ITEM_INLINE_SIZE 8 // (bytes) payload an item can hold itself
+
+// Flags
+#define ITEM_POOLED 0x1 // give it back to the pool when destroyed
+#define ITEM_INLINE 0x2 // data is the item's own payload
 
 // Types
 
 typedef struct ITEM {
 
-    void *data, *next, *last;
+    struct ITEM *next, *last;
+    void *data;
     size_t size;
+    uint8_t flags;
+    uint8_t payload[ITEM_INLINE_SIZE];
 
 } ITEM;
 
 // avoid using asterisks everywhere
 typedef ITEM *Item;
 
+// The struct an ITEM set up with Item_init is the member of
+#define ITEM_CONTAINER(i, type, member) \
+    ((type *)((uint8_t *)(i) - offsetof(type, member)))
+
+/**********************************************************************
+ * PUBLIC MACROS                                                      *
+ **********************************************************************/
+
+// The item's data field.
+#define Item_getData(i)         ((i)->data)
+
+// The size of the item and its data, an inline payload is in the item.
+#define Item_getSize(i)         (sizeof(ITEM) \
+    + (((i)->flags & ITEM_INLINE)? 0 : (i)->size))
+
+// The item in front of this one, NULL at the front of the line.
+#define Item_getNext(i)         ((i)->next)
+
+// The item behind this one, NULL when this item is the last in line.
+#define Item_getLast(i)         ((i)->last)
+
+// Puts next in front of i, and i behind next.
+#define Item_setNext(i, n)      do { (i)->next = (n); (n)->last = (i); } while (0)
+
+// Puts last behind i, and i in front of last.
+#define Item_setLast(i, l)      do { (i)->last = (l); (l)->next = (i); } while (0)
+
+// Removes the next item, from both.
+#define Item_clearNext(i)       do { if ((i)->next != NULL) { \
+    (i)->next->last = NULL; (i)->next = NULL; } } while (0)
+
+// Removes the last item, from both.
+#define Item_clearLast(i)       do { if ((i)->last != NULL) { \
+    (i)->last->next = NULL; (i)->last = NULL; } } while (0)
+
 /**********************************************************************
  * PUBLIC FUNCTIONS                                                   *
  **********************************************************************/
@@ -37,96 +97,49 @@ typedef ITEM *Item;
  * Function: Item_create()
  * @param A pointer to an object or some data.
  * @param The sizeof that object or data.
- * @return The new item.
- * @remark none
+ * @return The new item, or NULL with ERROR_NO_MEMORY once all
+ *  ITEM_POOL_SIZE are in use.
+ * @remark Doesn't copy the data, it has to outlive the item.
  **********************************************************************/
 Item Item_create(void* data, size_t size);
 
 /**********************************************************************
- * Function: Item_getData()
- * @param An item.
- * @return The item's data field.
- * @remark none
+ * Function: Item_createInline()
+ * @param Data to copy into the item.
+ * @param The size of it, at most ITEM_INLINE_SIZE.
+ * @return The new item, or NULL with ERROR_NO_MEMORY once the pool is
+ *  used up or if the data won't fit.
+ * @remark The data can go away as soon as this returns.
  **********************************************************************/
-void* Item_getData (Item i);
-
+Item Item_createInline(const void* data, size_t size);
 
 /**********************************************************************
- * Function: Item_create()
+ * Function: Item_init()
+ * @param An ITEM that doesn't come from the pool, usually a member of
+ *  the struct it carries.
  * @param A pointer to an object or some data.
  * @param The sizeof that object or data.
- * @return The new item.
- * @remark none
+ * @return The item.
+ * @remark Item_destroy only unlinks it, the owner keeps it.
  **********************************************************************/
-Item Item_create(void* data, size_t size);
+Item Item_init(Item i, void* data, size_t size);
 
 /**********************************************************************
  * Function: Item_destroy(Item i)
  * @param An item to destroy.
  * @return none
- * @remark Destructor for an Item.
+ * @remark Destructor for an Item, gives it back to the pool if it came
+ *  from there.
  **********************************************************************/
 void Item_destroy(Item i);
 
 /**********************************************************************
- * Function: Item_getSize(Item i)
- * @param A Item to check the size of.
- * @return The size of the item and its data.
+ * Function: Item_getFreeCount()
+ * @return How many more items can be created.
  * @remark none
  **********************************************************************/
-size_t Item_getSize (Item i);
-
-/**********************************************************************
- * Function: Item_getNext()
- * @param An item.
- * @return The item in front of this one.
- * @remark Returns NULL when this item is at the front of the line.
- **********************************************************************/
-Item Item_getNext(Item i);
-
-/**********************************************************************
- * Function: Item_getLast()
- * @param An item.
- * @return The item behind this one.
- * @remark Returns NULL when this item is the last in line.
- **********************************************************************/
-Item Item_getLast(Item i);
-
-/**********************************************************************
- * Function: Item_setNext()
- * @param An item.
- * @param An item to put in front of this one.
- * @return none
- * @remark Sets the next item, and sets the next item's last item.
- **********************************************************************/
-void Item_setNext (Item i, Item next);
-
-/**********************************************************************
- * Function: Item_setLast()
- * @param An item.
- * @param An item to add behind this one.
- * @return none
- * @remark Sets the last item, and sets the last item's next item.
- **********************************************************************/
-void Item_setLast (Item i, Item last);
-
-/**********************************************************************
- * Function: Item_clearNext()
- * @param An item.
- * @return none
- * @remark Removes the next item.
- **********************************************************************/
-void Item_clearNext(Item i);
-
-/**********************************************************************
- * Function: Item_clearLast()
- * @param An item.
- * @return none
- * @remark Removes the last item.
- **********************************************************************/
-void Item_clearLast(Item i);
+uint8_t Item_getFreeCount();
 
 
 #endif
 
-
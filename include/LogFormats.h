@@ -0,0 +1,41 @@
+/**
+ * @file    LogFormats.h
+ *
+ * @brief
+ * Format strings for the deferred binary log (see SERIAL_LOG in Serial.h).
+ *
+ * @details
+ * The board only sends the index of a format string and its raw 32-bit
+ * arguments; tool/log_decoder reads this file to turn them back into text.
+ * Append new formats at the end so old captures still decode, and keep
+ * each LOG_FORMAT on one line. Floats must be passed through LOG_FLOAT()
+ * and printed with %f, everything else is an int32 or uint32.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef LogFormats_H
+#define LogFormats_H
+
+#define LOG_FORMAT_TABLE \
+    LOG_FORMAT(LOG_OVERFLOW,        "log: %u records dropped") \
+    LOG_FORMAT(LOG_MARK,            "mark %d") \
+    LOG_FORMAT(LOG_GPS_FIX,         "gps: lat=%f lon=%f alt=%f") \
+    LOG_FORMAT(LOG_GPS_STATUS,      "gps: fix type %u, flags 0x%x") \
+    LOG_FORMAT(LOG_GPS_TIMEOUT,     "gps: no message for %u ms") \
+    LOG_FORMAT(LOG_XBEE_LOST,       "xbee: lost connection") \
+    LOG_FORMAT(LOG_ACK_RESEND,      "mavlink: resending message %u") \
+    LOG_FORMAT(LOG_ENCODER_ANGLE,   "encoder: pitch=%f yaw=%f") \
+    LOG_FORMAT(LOG_GPS_IDLE,        "gps: entered idle state") \
+    LOG_FORMAT(LOG_GPS_READ,        "gps: entered read state") \
+    LOG_FORMAT(LOG_GPS_BAD_BYTE,    "gps: failed reading message at byte %u") \
+    LOG_FORMAT(LOG_GPS_CONNECTED,   "gps: connected") \
+    LOG_FORMAT(LOG_GPS_UNHANDLED,   "gps: unhandled message 0x%x 0x%x")
+
+#define LOG_FORMAT(id, format) id,
+typedef enum {
+    LOG_FORMAT_TABLE
+    LOG_FORMAT_COUNT
+} LogFormatId;
+#undef LOG_FORMAT
+
+#endif // LogFormats_H
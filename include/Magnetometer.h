@@ -8,6 +8,31 @@
 #ifndef MAGNETOMETER_H
 #define	MAGNETOMETER_H
 
+#include <stdint.h>
+#include "Board.h"
+
+/*******************************************************************************
+ * Public Definitions                                                          *
+ ******************************************************************************/
+
+// (degrees) Most tilt a heading is kept at. The HMC6352 only senses the two
+//  axes in its own plane, so tilting it lets the vertical field into the
+//  heading, by about tilt * tan(dip) degrees, and there's no third axis to
+//  take it back out with. Readings past this are dropped instead.
+#define MAGNETOMETER_TILT_MAX       5.0f
+
+/*******************************************************************************
+ * Public Typedefs                                                             *
+ ******************************************************************************/
+
+// Latest heading, see Magnetometer_getHeading
+typedef struct {
+    float heading;      // (degrees) from magnetic north, mean of the last few
+    float tilt;         // (degrees) from level at the last reading
+    uint32_t time;      // (ms) get_time() the last kept reading was taken at
+    BOOL isValid;       // a reading has been kept since Magnetometer_init
+} MagnetometerHeading;
+
 
 /*******************************************************************************
  * Public Functions                                                            *
@@ -16,7 +41,7 @@
 /**
  * Function: Magnetometer_init
  * @return None.
- * @remark Initializes the Magnetometer interface
+ * @remark Initializes the Magnetometer interface. Needs Timer_init.
  * @author Shehadeh H. Dajani
  * @date 2013.03.10  */
 void Magnetometer_init();
@@ -25,7 +50,10 @@ void Magnetometer_init();
 /**
  * Function: Magnetometer_runSM
  * @return None.
- * @remark Accumulates angles for Magnetometer calculates degrees.
+ * @remark One step of sampling in the background, never waits on the bus. It
+ *  queues the measure command, lets the 6 ms measurement run, queues the read
+ *  and then takes in the heading, one step a call. Call it often, usually off
+ *  the sensor schedule (see Sensors.h), it paces itself.
  * @author Shehadeh H. Dajani
  * @date 2013.03.10  */
  void Magnetometer_runSM();
@@ -33,9 +61,31 @@ void Magnetometer_init();
 /**
  * Function: Magnetometer_getDegree
  * @return Degree.
- * @remark Returns magnetometer degrees
+ * @remark Returns magnetometer degrees, the last published heading. Doesn't
+ *  touch the bus.
  * @author Shehadeh H. Dajani
  * @date 2013.03.10  */
 float Magnetometer_getDegree();
 
+/**
+ * Function: Magnetometer_getHeading
+ * @param Set to the latest heading, its tilt and when it was taken.
+ * @return None.
+ * @remark Doesn't touch the bus. The time only changes when a new reading
+ *  is kept, so a reader can tell whether it has seen it already.
+ * @date 2026.10.14  */
+void Magnetometer_getHeading(MagnetometerHeading *heading);
+
+/**
+ * Function: Magnetometer_setGravity
+ * @param X of the gravity vector, in the magnetometer's frame.
+ * @param Y of the gravity vector.
+ * @param Z of the gravity vector, any scale works.
+ * @return None.
+ * @remark Gives the tilt the next heading is checked against, usually the
+ *  accelerometer's counts after each read. Without it the sensor is taken
+ *  to be level.
+ * @date 2026.10.14  */
+void Magnetometer_setGravity(int16_t x, int16_t y, int16_t z);
+
 #endif
\ No newline at end of file
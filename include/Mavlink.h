@@ -13,6 +13,42 @@
 #define ACK_STATUS_WAIT 2
 #define ACK_STATUS_DEAD 3
 
+// Status of a START_RESCUE
+#define RESCUE_STATUS_NEW 0 // a new target, the boat starts over
+#define RESCUE_STATUS_TRACKING 1 // the same target, moved
+
+// Messages sent with Mavlink_send_acknowledged, see Mavlink_check_ACKs
+#define ACK_TABLE_SIZE 4 // waiting for an ACK at once
+#define ACK_PAYLOAD_MAX 32 // (bytes) largest message that can wait
+#define ACK_RETRIES_MAX 5 // resends before a message is dead
+#define ACK_TIMEOUT_START 3000 // (ms) before there is a round trip time
+#define ACK_TIMEOUT_MIN 100 // (ms)
+#define ACK_TIMEOUT_MAX 10000 // (ms)
+
+// System ids, the sysid of every frame, see Mavlink_set_system_id. The
+//  base is the command center, which every device used to be.
+#define MAVLINK_SYSTEM_BROADCAST 0 // a target, every peer
+#define MAVLINK_SYSTEM_BASE 15
+#define MAVLINK_SYSTEM_BOAT 16 // the first boat, the others count up
+#ifndef MAVLINK_SYSTEM_ID
+#define MAVLINK_SYSTEM_ID MAVLINK_SYSTEM_BASE // until one is set
+#endif
+
+// Radio address of a system id, the XBee's MY (see Xbee_init)
+#define MAVLINK_ADDRESS_PREFIX 0xA500
+#define MAVLINK_ADDRESS(sysid) (MAVLINK_ADDRESS_PREFIX | (sysid))
+#define MAVLINK_ADDRESS_BROADCAST 0xFFFF
+#define MAVLINK_ADDRESS_UNKNOWN 0xFFFE // came in some other way than a radio packet
+
+// Systems heard from, see Mavlink_get_peer
+#define MAVLINK_PEERS_MAX 4
+#define MAVLINK_NO_PEER 0xFF
+#define MAVLINK_PEER_TIMEOUT 4000 // (ms) without a message, it's gone
+
+// Most Mavlink_recieve takes in one call
+#define MAVLINK_RECEIVE_BYTES 128
+#define MAVLINK_RECEIVE_MICROS 2000
+
 
 /**********************************************************************
  * PUBLIC VARIABLES                                                   *
@@ -26,35 +62,142 @@ enum Message_names{
     messageName_stop_rescue
 };
 
+// Told ACK_STATUS_RECIEVED or ACK_STATUS_DEAD once a message is done with
+typedef void (*ACK_callback)(uint8_t Message_Name, uint8_t ACK_status);
+
+// Decodes and acts on one message id, see Mavlink_register
+typedef void (*Mavlink_handler)(uint8_t uart_id, const mavlink_message_t *msg);
+
+/* Another system, kept from the first message heard from it or sent to it.
+ * Its sequence numbers are its own, and so are ours to it, so each end can
+ * tell what it lost of the other's however many others share the radio. */
 typedef struct{
-    uint8_t messageName;
-    uint8_t ACK_status;
-    uint8_t last_buf[MAVLINK_MAX_PACKET_LEN];
-    uint16_t last_length;
-    uint8_t last_uart_id;
-    uint32_t ACK_time;
-}ACK;
-
-ACK start_rescue;
+    uint8_t sysid; // 0 while the entry is free
+    uint16_t address; // radio address it was last heard from
+    uint32_t heardTime; // (ms) of its last message, 0 before one
+    uint32_t received; // messages from it
+    uint32_t lost; // of its sequence numbers that never came
+    uint32_t sent; // messages to it, with the broadcasts fanned out to it
+    uint32_t bytesSent; // of those, in frames
+    uint8_t rxSeq; // of its last message
+    uint8_t txSeq; // of the next message to it
+    int32_t smoothedRTT, deviationRTT; // (ms) see Mavlink_add_RTT_sample
+    uint16_t ackTimeout; // (ms) a message to it starts with
+}MavlinkPeer;
+
+typedef struct{
+    uint32_t received; // messages that passed their checksum
+    uint32_t drops; // frames lost to bad checksums and framing
+    uint32_t unhandled; // good messages nothing was registered for
+    uint32_t budgetHits; // calls that stopped with bytes still waiting
+}MavlinkLinkStats;
+
 /**********************************************************************
  * PUBLIC FUNCTIONS                                                   *
  **********************************************************************/
-void Mavlink_recieve(uint8_t uart_id);
+/* Registers the handlers Mavlink.c has itself, the ACK and the rescue
+ * commands. Modules register their own after it. Forgets every peer. */
+void Mavlink_init(void);
+
+/* The system id frames go out with, MAVLINK_SYSTEM_ID until it's set. A
+ * boat sends to the base unless told otherwise, the base to every boat. */
+void Mavlink_set_system_id(uint8_t sysid);
+
+uint8_t Mavlink_get_system_id(void);
+
+/* Where Mavlink_send_frame sends, the base for a boat, and
+ * MAVLINK_SYSTEM_BROADCAST for the base. */
+uint8_t Mavlink_get_default_target(void);
+
+/* Peers are found by index, 0 to MAVLINK_PEERS_MAX - 1. Returns FAILURE
+ * for a free entry. */
+uint8_t Mavlink_get_peer(uint8_t index, MavlinkPeer *peer);
+
+/* Index of a system id's peer, or MAVLINK_NO_PEER if it isn't kept. */
+uint8_t Mavlink_find_peer(uint8_t sysid);
+
+/* TRUE if the peer at the index sent anything in MAVLINK_PEER_TIMEOUT. */
+uint8_t Mavlink_is_peer_connected(uint8_t index);
 
-void Mavlink_send_ACK(uint8_t uart_id, uint8_t Message_Name);
+/* Sets the handler of a message id, replacing any it had, or removes it
+ * with NULL. Returns FAILURE if MAVLINK_HANDLERS_MAX are taken. */
+uint8_t Mavlink_register(uint8_t msgid, Mavlink_handler handler);
 
-void Mavlink_send_xbee_heartbeat(uint8_t uart_id, uint8_t data);
+/* Parses what came in on the UART and dispatches each message, up to
+ * MAVLINK_RECEIVE_BYTES or MAVLINK_RECEIVE_MICROS. Returns TRUE if it ran
+ * out of budget with bytes still waiting, FALSE once the UART is empty. */
+uint8_t Mavlink_recieve(uint8_t uart_id);
 
-void Mavlink_send_start_rescue(uint8_t uart_id, uint8_t ack, uint8_t status, float latitude, float longitude);
+/* Parses bytes that came in some other way, the data of XBee packets,
+ * as if they came in on the UART. The radio address they came from is
+ * kept for the peer that sent them, or MAVLINK_ADDRESS_UNKNOWN. */
+void Mavlink_recieve_bytes(uint8_t uart_id, uint16_t address, const uint8_t *data,
+    uint16_t length);
 
-void Mavlink_recieve_ACK(mavlink_mavlink_ack_t* packet);
+void Mavlink_get_link_stats(MavlinkLinkStats *stats);
 
-void Mavlink_resend_message(ACK *message);
-/*
-uint8_t Mavlink_returnACKStatus(uint8_t message_name);
+/* Sends to the default target, see Mavlink_set_system_id. */
+void Mavlink_send_frame(uint8_t uart_id, const mavlink_message_t *msg);
 
-void Mavlink_editACKStatus(uint8_t message_name, uint8_t new_status);
-*/
+/* Sends to one system, numbered in its own sequence and to its radio
+ * address, or with MAVLINK_SYSTEM_BROADCAST to each connected peer in
+ * turn. With none connected a broadcast goes to every radio at once. */
+void Mavlink_send_frame_to(uint8_t uart_id, uint8_t target, const mavlink_message_t *msg);
+
+void Mavlink_send_ACK(uint8_t uart_id, uint8_t target, uint8_t Message_Name, uint8_t seq);
+
+/* Sends a packed message to one system and keeps it until an ACK from it
+ * with its name and sequence number comes back. Resent after the
+ * adaptive timeout of that peer, doubled each time, and dropped after
+ * ACK_RETRIES_MAX. A message with the same name and target still waiting
+ * is replaced without a callback. Returns FAILURE for a broadcast, if
+ * the table or the peers are full, or if the message is too long to
+ * keep. */
+uint8_t Mavlink_send_acknowledged(uint8_t uart_id, uint8_t target, const mavlink_message_t *msg,
+    uint8_t Message_Name, ACK_callback callback);
+
+/* Resends the messages whose timeout has passed, call it often. */
+void Mavlink_check_ACKs(void);
+
+/* Timeout in ms a message sent to the system now would start with. */
+uint16_t Mavlink_get_ACK_timeout(uint8_t sysid);
+
+/* Adds a round trip in ms to the system measured some other way, like the
+ * heartbeat's, to its timeout, so it follows the link between
+ * acknowledged messages. */
+void Mavlink_add_RTT_sample(uint8_t sysid, uint32_t rtt);
+
+void Mavlink_send_xbee_heartbeat(uint8_t uart_id, uint8_t target, uint16_t seq, uint32_t time,
+    uint32_t echo_time, uint16_t echo_delay, uint8_t loss);
+
+void Mavlink_send_start_rescue(uint8_t uart_id, uint8_t target, uint8_t ack, uint8_t status, float latitude, float longitude, ACK_callback callback);
+
+/* Coordinate in 1e-7 degrees like GpsCoordinate, use it over the float one */
+void Mavlink_send_start_rescue_int(uint8_t uart_id, uint8_t target, uint8_t ack, uint8_t status, int32_t latitude, int32_t longitude, ACK_callback callback);
+
+void Mavlink_send_gps_error(uint8_t uart_id, uint8_t ack, uint32_t time, int32_t latitude, int32_t longitude);
+
+void Mavlink_send_uart_status(uint8_t uart_id, uint8_t port_id);
+
+/* Sends up to max events of the error log as ERROR_EVENT messages, oldest
+ * first, and takes them out of it. Returns how many were sent. */
+uint8_t Mavlink_send_error_events(uint8_t uart_id, uint8_t max);
+
+/* Telemetry, see Telemetry.h. Units are in autoLifeguard.xml. */
+void Mavlink_send_boat_position(uint8_t uart_id, uint32_t time, int32_t latitude, int32_t longitude,
+    int16_t velocity_north, int16_t velocity_east, uint16_t heading, uint16_t accuracy, uint8_t guidance);
+
+void Mavlink_send_battery(uint8_t uart_id, uint32_t time, uint16_t voltage);
+
+void Mavlink_send_thermal_target(uint8_t uart_id, uint32_t time, uint16_t heading, int16_t elevation,
+    int16_t peak, uint8_t pixels);
+
+/* The radio's counters from Xbee_getStats, with the telemetry's own */
+void Mavlink_send_xbee_status(uint8_t uart_id, uint16_t telemetry_rate, uint32_t telemetry_decimated);
+
+void Mavlink_recieve_ACK(uint8_t sysid, mavlink_mavlink_ack_t* packet);
+
+void Mavlink_recieve_gps_error(mavlink_gps_error_t* packet);
 
 #ifdef XBEE_TEST
 void Mavlink_send_Test_data(uint8_t uart_id, uint8_t data);
@@ -62,4 +205,6 @@ void Mavlink_send_Test_data(uint8_t uart_id, uint8_t data);
 
 
 void Compas_recieve_start_rescue(mavlink_start_rescue_t* packet);
+
+void Compas_recieve_start_rescue_int(mavlink_start_rescue_int_t* packet);
 #endif
\ No newline at end of file
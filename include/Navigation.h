@@ -9,7 +9,8 @@
  * This module utilizes the GPS module to provide functions
  * for the navigation systems of the COMPAS and ATLAS. IS_COMPAS
  * or IS_ATLAS must be defined in order for this module to provide
- * functionality.
+ * functionality. Define USE_GEODETIC (with USE_GPS) to get projected
+ * coordinates as geodetic (lat, lon, alt) instead of NED from the COMPAS.
  *
  * @date March 10, 2013, 10:03 AM  -- Created
  */
@@ -19,6 +20,7 @@
 
 #include <stdint.h>
 #include <math.h>
+#include "Gps.h"
 
 /***********************************************************************
  * PUBLIC DEFINITIONS                                                  *
@@ -30,6 +32,15 @@
 
 #define DEGREE_TO_NEDFRAME(deg) (-deg + 90.0)
 
+// Meters per 1e-7 degrees of latitude (or longitude at the equator)
+#define METERS_PER_COORDINATE   (6378137.0f * DEGREE_TO_RADIAN / GPS_COORDINATE_SCALE)
+
+// Points the projection stream holds, a power of two
+#define NAVIGATION_STREAM_LENGTH    16
+
+// Step of the sensor fusion filter
+#define NAVIGATION_FILTER_PERIOD    20 // (ms) 50 Hz
+
 // Angle limits 
 #define YAW_LIMIT       360.0f // (non-inclusive)
 #define PITCH_LIMIT     90.0f  // (inclusive)
@@ -43,6 +54,29 @@ typedef struct oCoordinate {
     float x, y ,z;
 } Coordinate;
 
+// One sample for Navigation_projectBatch
+typedef struct oProjection {
+    float yaw, pitch;           // (degrees) in
+    Coordinate coord;           // out, geodetic or NED like the single call
+    BOOL isValid;               // out, FALSE if it couldn't be projected
+} Projection;
+
+// Projected point queued by Navigation_streamSample
+typedef struct oProjectedPoint {
+    uint32_t time;              // (ms) get_time() it was projected at
+    Coordinate coord;
+} ProjectedPoint;
+
+// Filtered pose from the sensor fusion, see Navigation_getPose
+typedef struct oPose {
+    float north, east;          // (m) from the filter origin
+    float velocityNorth;        // (m/s)
+    float velocityEast;         // (m/s)
+    float heading;              // (degrees) from north
+    float accuracy;             // (m) one sigma of the horizontal position
+    uint32_t time;              // (ms) get_time() of the last filter step
+} Pose;
+
 /***********************************************************************
  * PUBLIC FUNCTIONS                                                    *
  ***********************************************************************/
@@ -72,6 +106,28 @@ void Navigation_runSM();
  * @date 2013.03.10  */
 BOOL Navigation_isReady();
 
+#ifdef USE_SENSOR_FUSION
+/**
+ * Function: Navigation_getPose
+ * @param Where to store the pose.
+ * @return TRUE, or FALSE before the first GPS fix.
+ * @remark The pose is propagated from the accelerometer and magnetometer
+ *  every NAVIGATION_FILTER_PERIOD by Navigation_runSM, and corrected by
+ *  each GPS fix, so it moves smoothly between fixes. Position is in meters
+ *  north and east of the first fix, see Navigation_getPoseCoordinate.
+ * @date 2026.10.14  */
+BOOL Navigation_getPose(Pose *pose);
+
+/**
+ * Function: Navigation_getPoseCoordinate
+ * @param Where to store the filtered position.
+ * @return TRUE, or FALSE before the first GPS fix.
+ * @remark The filtered position in 1e-7 degrees like GPS_getCoordinate,
+ *  with the altitude of the last fix.
+ * @date 2026.10.14  */
+BOOL Navigation_getPoseCoordinate(GpsCoordinate *coord);
+#endif
+
 #ifdef IS_COMPAS
 /**
  * Function: Navigation_getProjectedCoordinate
@@ -85,6 +141,75 @@ BOOL Navigation_isReady();
  * @author David Goodman
  * @date 2013.03.10  */
 BOOL Navigation_getProjectedCoordinate(Coordinate *coord, float yaw, float pitch, float height);
+
+#ifdef USE_GPS
+/**
+ * Function: Navigation_getProjectedGpsCoordinate
+ * @param Where to save the projected coordinate.
+ * @param Yaw angle to projected position in degrees.
+ * @param Pitch angle to projected position in degrees.
+ * @param Height from projected position in meters.
+ * @return TRUE, or FALSE without a fix or with the angles out of range.
+ * @remark Like Navigation_getProjectedCoordinate, but the NED offset is
+ *  added to the fix in 1e-7 degrees, flat earth over the few hundred
+ *  meters it reaches, so a float never has to hold a whole latitude.
+ * @date 2026.10.14  */
+BOOL Navigation_getProjectedGpsCoordinate(GpsCoordinate *coord, float yaw,
+    float pitch, float height);
+#endif
+
+/**
+ * Function: Navigation_projectBatch
+ * @param Samples to project, yaw and pitch are read and coord and isValid
+ *  are written.
+ * @param Number of samples.
+ * @param Height from projected positions in meters.
+ * @return Number of samples projected.
+ * @remark Same as calling Navigation_getProjectedCoordinate on each
+ *  sample, but the reference position is read once and the cached frame
+ *  and trig state are shared across the batch.
+ * @date 2026.10.14  */
+uint16_t Navigation_projectBatch(Projection *samples, uint16_t count, float height);
+
+/**
+ * Function: Navigation_startStream
+ * @return None.
+ * @remark Empties the projection stream and starts accepting samples.
+ * @date 2026.10.14  */
+void Navigation_startStream();
+
+/**
+ * Function: Navigation_stopStream
+ * @return None.
+ * @remark Stops accepting samples, anything queued is dropped.
+ * @date 2026.10.14  */
+void Navigation_stopStream();
+
+/**
+ * Function: Navigation_streamSample
+ * @param Yaw angle to projected position in degrees.
+ * @param Pitch angle to projected position in degrees.
+ * @param Height from projected position in meters.
+ * @return TRUE if the point was queued, FALSE if it couldn't be projected,
+ *  the stream is stopped, or it is full.
+ * @remark Projects one encoder sample into the stream, for continuous
+ *  tracking. A full stream drops the new point and counts it.
+ * @date 2026.10.14  */
+BOOL Navigation_streamSample(float yaw, float pitch, float height);
+
+/**
+ * Function: Navigation_readStream
+ * @param Where to store the oldest queued point.
+ * @return TRUE, or FALSE if the stream is empty.
+ * @remark Consumer side of the stream, for the XBee downlink.
+ * @date 2026.10.14  */
+BOOL Navigation_readStream(ProjectedPoint *point);
+
+/**
+ * Function: Navigation_getStreamDropped
+ * @return Number of points dropped because the stream was full.
+ * @date 2026.10.14  */
+uint16_t Navigation_getStreamDropped();
 #endif
 
 /**
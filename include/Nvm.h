@@ -0,0 +1,127 @@
+/**
+ * @file    Nvm.h
+ *
+ * @brief
+ * Small key-value store in the PIC32's own program flash.
+ *
+ * @details
+ * Keeps what used to be worked out again on every boot, the calibration
+ * read off the sensors, the encoder zero, the tripod height and the GPS
+ * state, so starting up only has to check it instead of redoing the bus
+ * transfers and the operator's steps.
+ *
+ * The store is the last two 4 KB pages of the flash, NVM_ADDRESS on. One
+ * page is in use at a time and is a log: a write appends a new record for
+ * its key after the others, and a read finds the newest record of the
+ * key. Once the page is full the newest record of every key is copied to
+ * the other page, which is erased first, so each page is only erased
+ * about once per page worth of writes, and the two take turns. Writing
+ * what's already kept writes nothing.
+ *
+ * Layout, words of 32 bits. Every page starts with
+ *   'N', 'V', sequence (uint16_t), larger in the newer page
+ * which is the last word written when a page is filled, so a copy cut
+ * short by a reset is never taken for the newer one. Then the records:
+ *   key (uint8_t), data length (uint8_t), CRC-16 of both and the data
+ * followed by the data, padded to a word with 0xFF. A record cut short by
+ * a reset fails its CRC and is skipped, and a record with no data takes
+ * its key out of the store.
+ *
+ * A flash write stalls the CPU, about 20 us a word and 20 ms a page
+ * erase, with the interrupts still running. Write from the main loop,
+ * and not while something is timed to the tick. Programming the board
+ * erases the store too, unless the programmer is set to preserve
+ * NVM_ADDRESS to the end of the flash.
+ *
+ * NVM_TEST (in the .c file) conditionally compiles the test harness.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef Nvm_H
+#define Nvm_H
+
+#include <stdint.h>
+#include "Board.h"
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define NVM_PAGE_SIZE       4096 // (bytes) PIC32MX flash erase page
+#define NVM_PAGES           2
+#define NVM_ADDRESS         0x9D01E000 // last two pages of the 128 KB
+#define NVM_DATA_MAX        255 // (bytes) in a record
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+// What's kept, don't renumber them or the old records are read as new ones
+typedef enum {
+    NVM_KEY_TRIPOD_HEIGHT = 0,  // float (m), see Compas.c
+    NVM_KEY_ENCODER_ZERO,       // pitch, yaw (uint16_t binary angles)
+    NVM_KEY_THERMAL,            // camera coefficients, see Thermal.c
+    NVM_KEY_BAROMETER,          // BMP085 coefficients on I2C1
+    NVM_KEY_BAROMETER2,         // and on I2C2
+    NVM_KEY_GPS_CONFIG,         // GPS_init options the receiver kept
+    NVM_KEY_GPS_FIX,            // last position (GpsCoordinate)
+    NVM_KEY_SYSTEM_ID,          // MAVLink system id (uint8_t), see Xbee.h
+    NVM_KEY_COUNT
+} NvmKey;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: Nvm_init()
+ * @return SUCCESS, or FAILURE if neither page is in use and the first
+ *  couldn't be erased for it.
+ * @remark Finds the page in use, and where its records end. Takes a scan
+ *  of the page, well under a millisecond, and an erase on the first boot.
+ **********************************************************************/
+int8_t Nvm_init();
+
+/**********************************************************************
+ * Function: Nvm_isReady()
+ * @return TRUE once Nvm_init worked. Until then every read and write
+ *  fails, so a module can try the store and fall back without knowing
+ *  whether its board uses one.
+ **********************************************************************/
+BOOL Nvm_isReady();
+
+/**********************************************************************
+ * Function: Nvm_read()
+ * @param Key to read.
+ * @param Where to copy its data.
+ * @param Length the data has to be, in bytes.
+ * @return SUCCESS, or FAILURE if the key isn't kept or was kept with
+ *  another length, such as by an older build.
+ **********************************************************************/
+int8_t Nvm_read(NvmKey key, void *data, uint8_t length);
+
+/**********************************************************************
+ * Function: Nvm_write()
+ * @param Key to write.
+ * @param Its data.
+ * @param Length of the data, in bytes, 1 to NVM_DATA_MAX.
+ * @return SUCCESS, or FAILURE if the flash didn't take it.
+ * @remark Writes nothing if the key already has this data. See the file
+ *  comment for how long it stalls.
+ **********************************************************************/
+int8_t Nvm_write(NvmKey key, const void *data, uint8_t length);
+
+/**********************************************************************
+ * Function: Nvm_erase()
+ * @param Key to take out of the store.
+ * @return SUCCESS, or FAILURE if the flash didn't take it.
+ **********************************************************************/
+int8_t Nvm_erase(NvmKey key);
+
+/**********************************************************************
+ * Function: Nvm_getFree()
+ * @return (bytes) Left in the page in use before it's copied over.
+ **********************************************************************/
+uint16_t Nvm_getFree();
+
+#endif // Nvm_H
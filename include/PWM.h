@@ -12,7 +12,8 @@
  * PortX-11), and are set by the hardware (cannot be modified).
  *
  * @note
- * Module uses TIMER2 for its interrupts.
+ * Module uses TIMER2 for its interrupts. The interrupt only runs while
+ * there are duties to latch, see PWM_setDutyCycles.
  *
  * @note
  * PWM_TEST (in the .c file) conditionally compiles the test harness for
@@ -46,6 +47,10 @@
 #define MIN_PWM 0
 #define MAX_PWM 1000
 
+#define PWM_CHANNELS 5
+// Where the duty of a channel goes in the array for PWM_setDutyCycles
+#define PWM_INDEX(Channel) __builtin_ctz(Channel)
+
 
 
 /*******************************************************************************
@@ -72,6 +77,34 @@ char PWM_init(unsigned char Channels, unsigned int Period);
  * @date 2011.11.12  */
 char PWM_setDutyCycle(char Channel, unsigned int Duty);
 
+/**
+ * Function: PWM_setDutyCycles
+ * @param Channels, used #defined PWM_PORTxxx OR'd together
+ * @param Duties, duty of each channel in ticks (0-PWM_getResolution()),
+ *  at PWM_INDEX of the channel
+ * @return SUCCESS or ERROR
+ * @remark The channels all change at the same period boundary, the next
+ *  one after the whole of a period has passed at the latest.
+ * @date 2026.10.14  */
+char PWM_setDutyCycles(unsigned char Channels, const unsigned int *Duties);
+
+/**
+ * Function: PWM_setRateLimit
+ * @param Channels, used #defined PWM_PORTxxx OR'd together
+ * @param Limit, most ticks the duty may move in a period, 0 for no limit
+ * @return SUCCESS or ERROR
+ * @remark Also applies to a duty still on its way.
+ * @date 2026.10.14  */
+char PWM_setRateLimit(unsigned char Channels, unsigned int Limit);
+
+/**
+ * Function: PWM_getResolution
+ * @param None
+ * @return Ticks in a period, the duty that is always on
+ * @remark Depends on the frequency given to PWM_init.
+ * @date 2026.10.14  */
+unsigned int PWM_getResolution(void);
+
 
 /**
  * Function: PWM_end
@@ -0,0 +1,138 @@
+/*
+ * File: Queue.h
+ *
+ * A FIFO queue whose items are pointers to anything, see Item.h.
+ *
+ * With QUEUE_RING the queue is a ring of QUEUE_MAX_COUNT item pointers
+ * inside the QUEUE itself, so nothing is followed from item to item and
+ * the items' own links are left alone. Without it the items are linked
+ * into a list through their next and last, the way it was first written.
+ * The functions are the same either way.
+ *
+ * Queue_create takes a QUEUE from a pool of QUEUE_POOL_SIZE, or one can
+ * be declared anywhere and set up with Queue_init. Neither uses the heap.
+ * Enqueueing and dequeueing are safe from an interrupt.
+ *
+ */
+#ifndef Queue_H
+#define Queue_H
+
+#include <stdint.h>
+#include "Util.h"
+#include "Item.h"
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define QUEUE_RING // comment out for the linked list
+
+#define QUEUE_MAX_COUNT 16 // items in one queue
+#define QUEUE_POOL_SIZE 4 // queues Queue_create can hand out
+
+// Types
+
+typedef struct QUEUE {
+
+#ifdef QUEUE_RING
+    Item item[QUEUE_MAX_COUNT];
+    uint8_t front;
+#else
+    Item front, last;
+#endif
+    uint8_t count;
+    bool isPooled; // came from Queue_create
+
+} QUEUE;
+
+// avoid using asterisks everywhere
+typedef QUEUE *Queue;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: Queue_create()
+ * @param none
+ * @return The new Queue object, or NULL with ERROR_NO_MEMORY once all
+ *         QUEUE_POOL_SIZE are in use.
+ * @remark A Queue is actually a pointer to a QUEUE.
+ **********************************************************************/
+Queue Queue_create();
+
+/**********************************************************************
+ * Function: Queue_init()
+ * @param A QUEUE that wasn't made by Queue_create.
+ * @return none
+ * @remark Empties it, without destroying what was in it.
+ **********************************************************************/
+void Queue_init(Queue q);
+
+/**********************************************************************
+ * Function: Queue_destroy()
+ * @param A Queue to destroy.
+ * @return none
+ * @remark Destructor for a Queue, destroys its items too.
+ **********************************************************************/
+void Queue_destroy(Queue q);
+
+/**********************************************************************
+ * Function: Queue_isFull()
+ * @param A Queue to check the capacity of.
+ * @return A true or false value indicating whether the Queue is full
+ *         or not.
+ * @remark Checks if the Queue is full.
+ **********************************************************************/
+bool Queue_isFull(Queue q);
+
+/**********************************************************************
+ * Function: Queue_isEmpty()
+ * @param A queue to check.
+ * @return A true or false value indicating whether the Queue is empty.
+ * @remark Determines whether the Queue is empty or not.
+ **********************************************************************/
+bool Queue_isEmpty(Queue q);
+
+/**********************************************************************
+ * Function: Queue_enqueue()
+ * @param A queue to add to.
+ * @param A pointer to something to enqueue.
+ * @return SUCCESS, or FAILURE if the queue was full.
+ * @remark Adds the item to the Queue.
+ **********************************************************************/
+bool Queue_enqueue(Queue q, Item item);
+
+/**********************************************************************
+ * Function: Queue_dequeue()
+ * @param A queue to dequeue from.
+ * @return The item at the front of the queue, or NULL if empty.
+ * @remark Removes the item at the front (bottom) of the queue.
+ **********************************************************************/
+Item Queue_dequeue(Queue q);
+
+/**********************************************************************
+ * Function: Queue_clear()
+ * @param A queue to clear.
+ * @return none
+ * @remark Clears the queue, destroying its items.
+ **********************************************************************/
+void Queue_clear(Queue q);
+
+/**********************************************************************
+ * Function: Queue_getCount()
+ * @param A queue to check the count of.
+ * @return The number of items in the queue.
+ * @remark none
+ **********************************************************************/
+uint8_t Queue_getCount(Queue q);
+
+/**********************************************************************
+ * Function: Queue_peek()
+ * @param A queue.
+ * @return Returns the item at the front of the queue without removing it.
+ * @remark NULL if it's empty.
+ **********************************************************************/
+Item Queue_peek(Queue q);
+
+#endif
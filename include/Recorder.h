@@ -0,0 +1,220 @@
+/**
+ * @file    Recorder.h
+ *
+ * @brief
+ * Binary flight recorder, on an SPI flash chip.
+ *
+ * @details
+ * Records are a few bytes of fixed layout each, so a GPS fix, the encoder
+ * angles, the IMU, a thermal frame summary, the link stats and the logged
+ * events can all be kept at the rate they come in, without a laptop on
+ * the serial port. Recorder_write only copies a record into one of
+ * RECORDER_PAGE_COUNT pages in RAM. Recorder_runSM programs the full
+ * pages into the flash in the background, moving at most
+ * RECORDER_STEP_BYTES over the SPI bus a call, so it never holds up a
+ * control loop for longer than that takes (about 30 us at 10 MHz). A
+ * record that comes while every page is full is dropped and counted, the
+ * next page starts with a RECORD_DROPPED saying how many.
+ *
+ * The flash is a 25 series SPI NOR chip (W25Q32, SST25VF032 or alike) on
+ * SPI2, chip select on pin 10 of the Uno32 with JP4 on master.
+ * Recorder_init finds the end of what's already there and continues a new
+ * session after it. The chip is only erased by Recorder_erase, in the
+ * background, since that takes seconds. Once the chip is full recording
+ * stops.
+ *
+ * Layout, little endian. Every page starts with
+ *   'R', 'C', session (uint16_t), page in the session (uint32_t)
+ * followed by records, none split across pages, then 0xFF to the end:
+ *   type, payload length, get_time() in ms (uint32_t), payload
+ * where the payloads are described at RECORD_* below. tool/recorder_decoder
+ * turns a dump of the chip back into text.
+ *
+ * Recorder_write and the Recorder_record functions are for the main loop
+ * only, not from an interrupt.
+ *
+ * RECORDER_TEST (in the .c file) conditionally compiles the test harness.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef Recorder_H
+#define Recorder_H
+
+#include <stdint.h>
+#include "Board.h"
+#include "Error.h"
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define RECORDER_PAGE_SIZE          256 // (bytes) one flash page program
+#define RECORDER_PAGE_COUNT         2 // in RAM, at least two
+#define RECORDER_FLASH_SIZE         0x400000L // (bytes) 32 Mbit
+#define RECORDER_STEP_BYTES         32 // most moved over SPI a Recorder_runSM
+#define RECORDER_SPI_CLOCK          10000000L // (Hz)
+
+#define RECORDER_PAGE_HEADER        8 // (bytes)
+#define RECORDER_RECORD_HEADER      6 // (bytes)
+#define RECORDER_PAYLOAD_MAX        (RECORDER_PAGE_SIZE - RECORDER_PAGE_HEADER \
+                                        - RECORDER_RECORD_HEADER)
+
+// Record types and their payloads
+#define RECORD_DROPPED      1 // records lost (uint16_t)
+#define RECORD_GPS          2 // iTOW (ms), latitude, longitude (1e-7 degrees),
+                              //  altitude (mm), north, east (cm/s), all 32 bit
+#define RECORD_ANGLES       3 // pitch, yaw (int16_t centidegrees)
+#define RECORD_IMU          4 // acceleration x, y, z (int16_t raw), heading
+                              //  (uint16_t centidegrees)
+#define RECORD_THERMAL      5 // target heading (uint16_t centidegrees),
+                              //  elevation (int16_t centidegrees), peak
+                              //  (int16_t centidegrees F), pixels (uint8_t)
+#define RECORD_LINK         6 // connected, loss, peer loss (%) (uint8_t),
+                              //  rtt, jitter (uint16_t ms)
+#define RECORD_EVENT        7 // module, code (uint8_t), arg (uint16_t)
+#define RECORD_MARK         8 // anything, to find a moment in the log
+
+// Types
+
+typedef struct {
+    uint32_t records; // written into a page
+    uint32_t dropped; // lost to every page being full, or the chip
+    uint32_t pages; // programmed into the flash
+    uint32_t address; // next page goes at
+    uint16_t session; // since the chip was erased
+    uint8_t isReady; // found the chip and it can take more
+    uint8_t isErasing;
+} RecorderStats;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: Recorder_init()
+ * @return SUCCESS, or FAILURE if no flash chip answered.
+ * @remark Opens SPI2 and finds the end of the log, which takes a few
+ *  short reads. Recording starts right away, without a chip every
+ *  record is dropped.
+ **********************************************************************/
+int8_t Recorder_init();
+
+/**********************************************************************
+ * Function: Recorder_runSM()
+ * @return None
+ * @remark Programs the full pages into the flash, RECORDER_STEP_BYTES
+ *  at a time. Call it every pass of the loop, or as a polled task.
+ **********************************************************************/
+void Recorder_runSM();
+
+/**********************************************************************
+ * Function: Recorder_write()
+ * @param One of RECORD_*.
+ * @param Payload.
+ * @param Its length, at most RECORDER_PAYLOAD_MAX.
+ * @return SUCCESS, or FAILURE if it was dropped.
+ * @remark Stamped with get_time().
+ **********************************************************************/
+int8_t Recorder_write(uint8_t type, const void *payload, uint8_t length);
+
+/**********************************************************************
+ * Function: Recorder_recordGps()
+ * @param (ms) GPS time of week of the fix.
+ * @param (1e-7 degrees) Latitude.
+ * @param (1e-7 degrees) Longitude.
+ * @param (mm) Altitude.
+ * @param (cm/s) North velocity.
+ * @param (cm/s) East velocity.
+ * @return SUCCESS, or FAILURE if it was dropped.
+ * @remark A RECORD_GPS, the fields of a GpsFix.
+ **********************************************************************/
+int8_t Recorder_recordGps(uint32_t iTOW, int32_t latitude, int32_t longitude,
+    int32_t altitude, int32_t north, int32_t east);
+
+/**********************************************************************
+ * Function: Recorder_recordAngles()
+ * @param (degrees) Pitch.
+ * @param (degrees) Yaw.
+ * @return SUCCESS, or FAILURE if it was dropped.
+ * @remark A RECORD_ANGLES, from the encoders.
+ **********************************************************************/
+int8_t Recorder_recordAngles(float pitch, float yaw);
+
+/**********************************************************************
+ * Function: Recorder_recordImu()
+ * @param Acceleration x, y and z, as the accelerometer gives them.
+ * @param (degrees) Magnetic heading.
+ * @return SUCCESS, or FAILURE if it was dropped.
+ * @remark A RECORD_IMU.
+ **********************************************************************/
+int8_t Recorder_recordImu(int16_t x, int16_t y, int16_t z, float heading);
+
+/**********************************************************************
+ * Function: Recorder_recordThermal()
+ * @param (degrees) Heading of the target.
+ * @param (degrees) Elevation of the target.
+ * @param (degrees F) Warmest pixel above its background.
+ * @param Pixels in the blob, 0 for no target.
+ * @return SUCCESS, or FAILURE if it was dropped.
+ * @remark A RECORD_THERMAL, the summary of a frame.
+ **********************************************************************/
+int8_t Recorder_recordThermal(float heading, float elevation, float peak,
+    uint8_t pixels);
+
+/**********************************************************************
+ * Function: Recorder_recordLink()
+ * @param Whether heartbeats are coming in.
+ * @param (%) Our loss.
+ * @param (%) Their loss.
+ * @param (ms) Round trip.
+ * @param (ms) Jitter.
+ * @return SUCCESS, or FAILURE if it was dropped.
+ * @remark A RECORD_LINK, from XbeeLinkQuality.
+ **********************************************************************/
+int8_t Recorder_recordLink(uint8_t isConnected, uint8_t loss,
+    uint8_t peerLoss, uint16_t rtt, uint16_t jitter);
+
+/**********************************************************************
+ * Function: Recorder_recordEvent()
+ * @param An event read from the error log.
+ * @return SUCCESS, or FAILURE if it was dropped.
+ * @remark A RECORD_EVENT, stamped with when it was logged.
+ **********************************************************************/
+int8_t Recorder_recordEvent(const ErrorEvent *event);
+
+/**********************************************************************
+ * Function: Recorder_flush()
+ * @return None
+ * @remark Closes the page being filled, so Recorder_runSM writes it
+ *  even though it isn't full. For before a power down.
+ **********************************************************************/
+void Recorder_flush();
+
+/**********************************************************************
+ * Function: Recorder_erase()
+ * @return SUCCESS, or FAILURE without a chip.
+ * @remark Starts a chip erase, which Recorder_runSM waits out. Pages
+ *  that aren't written yet are thrown away, and records are dropped
+ *  until it's done.
+ **********************************************************************/
+int8_t Recorder_erase();
+
+/**********************************************************************
+ * Function: Recorder_read()
+ * @param Address in the flash.
+ * @param Buffer to read into.
+ * @param Bytes to read.
+ * @return SUCCESS, or FAILURE while the flash is busy.
+ * @remark Blocks for the whole read, for dumping the log after a run.
+ **********************************************************************/
+int8_t Recorder_read(uint32_t address, uint8_t *buffer, uint16_t length);
+
+/**********************************************************************
+ * Function: Recorder_getStats()
+ * @param Set to the recorder's counts.
+ * @return None
+ * @remark None
+ **********************************************************************/
+void Recorder_getStats(RecorderStats *stats);
+
+#endif // Recorder_H
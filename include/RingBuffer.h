@@ -0,0 +1,209 @@
+/**
+ * @file    RingBuffer.h
+ *
+ * @brief
+ * Single-producer/single-consumer byte ring buffer.
+ *
+ * @details
+ * The capacity is a power of two fixed at compile time, and the head and
+ * tail indices run freely and are masked on access. That means the length
+ * is just tail - head with no branch, and the whole capacity is usable.
+ * The producer only writes tail and the consumer only writes head, so one
+ * side can be an interrupt (or a DMA channel) and the other the main loop,
+ * with no locking. The span functions give direct access to the contiguous
+ * part of the buffer, so parsers and DMA can work in place.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef RingBuffer_H
+#define RingBuffer_H
+
+#include <stdint.h>
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+// Declares the storage for a ring buffer, won't compile if size is not a
+// power of two (or over 32768 so the uint16_t indices can't alias)
+#define RING_BUFFER_STORAGE(name, size) \
+    typedef char name##_size_check[(((size) & ((size) - 1)) == 0 && \
+        (size) <= 32768) ? 1 : -1]; \
+    static uint8_t name[size]
+
+// Keeps the compiler from moving buffer accesses across an index update
+#define RING_BUFFER_BARRIER()   __asm__ __volatile__("" ::: "memory")
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+typedef struct RingBuffer {
+    uint8_t *buffer;
+    uint16_t mask;                  // capacity - 1
+    volatile uint16_t head;         // written by the consumer only
+    volatile uint16_t tail;         // written by the producer only
+    volatile uint8_t overflowCount; // bytes dropped by the producer
+} RingBuffer;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: RingBuffer_init()
+ * @param The ring buffer.
+ * @param Storage declared with RING_BUFFER_STORAGE.
+ * @param Size of the storage, a power of two.
+ * @return none
+ * @remark Empties the ring buffer and points it at storage.
+ **********************************************************************/
+void RingBuffer_init(RingBuffer *rb, uint8_t *storage, uint16_t size);
+
+/**********************************************************************
+ * Function: RingBuffer_makeEmpty()
+ * @param The ring buffer.
+ * @return none
+ * @remark Drops everything in the buffer and clears the overflow count.
+ *  Only safe while neither side is running.
+ **********************************************************************/
+void RingBuffer_makeEmpty(RingBuffer *rb);
+
+/**********************************************************************
+ * Function: RingBuffer_getLength()
+ * @param The ring buffer.
+ * @return Number of bytes waiting to be consumed.
+ **********************************************************************/
+uint16_t RingBuffer_getLength(const RingBuffer *rb);
+
+/**********************************************************************
+ * Function: RingBuffer_getSpace()
+ * @param The ring buffer.
+ * @return Number of bytes that can still be produced.
+ **********************************************************************/
+uint16_t RingBuffer_getSpace(const RingBuffer *rb);
+
+/**********************************************************************
+ * Function: RingBuffer_getCapacity()
+ * @param The ring buffer.
+ * @return Total number of bytes the buffer holds.
+ **********************************************************************/
+uint16_t RingBuffer_getCapacity(const RingBuffer *rb);
+
+/**********************************************************************
+ * Function: RingBuffer_isEmpty()
+ * @param The ring buffer.
+ * @return TRUE or FALSE
+ **********************************************************************/
+char RingBuffer_isEmpty(const RingBuffer *rb);
+
+/**********************************************************************
+ * Function: RingBuffer_isFull()
+ * @param The ring buffer.
+ * @return TRUE or FALSE
+ **********************************************************************/
+char RingBuffer_isFull(const RingBuffer *rb);
+
+/**********************************************************************
+ * Function: RingBuffer_getOverflow()
+ * @param The ring buffer.
+ * @return Number of bytes dropped by RingBuffer_put because it was full.
+ **********************************************************************/
+uint8_t RingBuffer_getOverflow(const RingBuffer *rb);
+
+/**********************************************************************
+ * Function: RingBuffer_put()
+ * @param The ring buffer.
+ * @param Byte to add.
+ * @return SUCCESS or FAILURE if the buffer was full.
+ * @remark Producer side. A full buffer drops the byte and counts it.
+ **********************************************************************/
+int8_t RingBuffer_put(RingBuffer *rb, uint8_t data);
+
+/**********************************************************************
+ * Function: RingBuffer_get()
+ * @param The ring buffer.
+ * @param Where to store the byte.
+ * @return SUCCESS or FAILURE if the buffer was empty.
+ * @remark Consumer side.
+ **********************************************************************/
+int8_t RingBuffer_get(RingBuffer *rb, uint8_t *data);
+
+/**********************************************************************
+ * Function: RingBuffer_peek()
+ * @param The ring buffer.
+ * @param Offset from the front.
+ * @return The byte at offset without consuming it, or 0 if there is none.
+ **********************************************************************/
+uint8_t RingBuffer_peek(const RingBuffer *rb, uint16_t offset);
+
+/**********************************************************************
+ * Function: RingBuffer_write()
+ * @param The ring buffer.
+ * @param Bytes to add.
+ * @param Number of bytes.
+ * @return Number of bytes accepted.
+ * @remark Producer side, at most two memcpy spans. Bytes that don't fit
+ *  are not counted as overflow, the caller has the return to check.
+ **********************************************************************/
+uint16_t RingBuffer_write(RingBuffer *rb, const uint8_t *data, uint16_t length);
+
+/**********************************************************************
+ * Function: RingBuffer_read()
+ * @param The ring buffer.
+ * @param Where to copy the bytes.
+ * @param Maximum number of bytes to copy.
+ * @return Number of bytes copied.
+ * @remark Consumer side, at most two memcpy spans.
+ **********************************************************************/
+uint16_t RingBuffer_read(RingBuffer *rb, uint8_t *data, uint16_t maxLength);
+
+/**********************************************************************
+ * Function: RingBuffer_peekSpan()
+ * @param The ring buffer.
+ * @param Set to the first unconsumed byte.
+ * @return Number of contiguous bytes available at *span.
+ * @remark Consumer side. Read in place, then call RingBuffer_consume.
+ *  If this is less than the length, the rest starts at the beginning
+ *  of the storage and a second call returns it after consuming.
+ **********************************************************************/
+uint16_t RingBuffer_peekSpan(const RingBuffer *rb, const uint8_t **span);
+
+/**********************************************************************
+ * Function: RingBuffer_consume()
+ * @param The ring buffer.
+ * @param Number of bytes to drop from the front.
+ * @return none
+ * @remark Consumer side. Releases bytes read through RingBuffer_peekSpan.
+ **********************************************************************/
+void RingBuffer_consume(RingBuffer *rb, uint16_t length);
+
+/**********************************************************************
+ * Function: RingBuffer_reserveSpan()
+ * @param The ring buffer.
+ * @param Set to the first free byte.
+ * @return Number of contiguous free bytes at *span.
+ * @remark Producer side. Fill in place, then call RingBuffer_publish.
+ **********************************************************************/
+uint16_t RingBuffer_reserveSpan(RingBuffer *rb, uint8_t **span);
+
+/**********************************************************************
+ * Function: RingBuffer_publish()
+ * @param The ring buffer.
+ * @param Number of bytes written through RingBuffer_reserveSpan.
+ * @return none
+ * @remark Producer side. Makes the bytes visible to the consumer.
+ **********************************************************************/
+void RingBuffer_publish(RingBuffer *rb, uint16_t length);
+
+/**********************************************************************
+ * Function: RingBuffer_publishTo()
+ * @param The ring buffer.
+ * @param Storage index the producer has written up to.
+ * @return none
+ * @remark Producer side, for a DMA channel that writes into the storage
+ *  on its own and wraps around it. Moves the tail up to index.
+ **********************************************************************/
+void RingBuffer_publishTo(RingBuffer *rb, uint16_t index);
+
+#endif // RingBuffer_H
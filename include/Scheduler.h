@@ -0,0 +1,193 @@
+/**
+ * @file    Scheduler.h
+ *
+ * @brief
+ * Cooperative run-to-completion task scheduler for the main loops.
+ *
+ * @details
+ * Each module registers its state machine as a task with a priority and
+ * how it becomes ready: polled (once every pass), periodic (every so many
+ * milliseconds off a Timer handle), or only when signalled. Anything can
+ * signal a task, including an interrupt handler, so a receive interrupt
+ * or an expired timer makes its task ready right away.
+ *
+ * Scheduler_run makes one pass. It always runs the most urgent ready
+ * task next, and checks again after every task, so a signalled high
+ * priority task goes ahead of the polled tasks still waiting in the pass
+ * instead of at the end of the loop. Tasks are never preempted, so a
+ * task that blocks still delays everything for as long as it blocks,
+ * but only once rather than once per module.
+ *
+ * With SCHEDULER_USE_PROFILE every task is timed with the core timer,
+ * keeping the least, total and most cycles it took, and the time from
+ * the start of one pass to the next goes into a histogram with one bin
+ * per power of two cycles. Scheduler_printProfile dumps both over serial.
+ *
+ * With SCHEDULER_USE_DEADLINES a task can also be given the most time
+ * allowed between its runs, and each run later than that is recorded as
+ * a miss (see Watchdog.h). The watchdog is fed once every critical task
+ * has run since the last feed, so a task that hangs, or a loop that
+ * stops getting to the critical tasks, resets the board. Deadlines are
+ * for periodic tasks, a task that's only signalled now and then would
+ * miss whenever nothing signals it.
+ *
+ * With SCHEDULER_USE_IDLE, a pass that leaves nothing ready ends in the
+ * CPU's WAIT instruction, in idle mode, until the next interrupt. That
+ * only happens when no task is polled, since a polled task is always
+ * ready, so modules that want the battery savings should run periodic
+ * and be signalled by their interrupts.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef Scheduler_H
+#define Scheduler_H
+
+#include <stdint.h>
+#include "Board.h"
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define SCHEDULER_TASK_MAX      16 // at most 32
+#define SCHEDULER_INVALID       0xFF
+
+// Periods for Scheduler_addTask, other values are milliseconds
+#define SCHEDULER_POLL          0 // once every pass
+#define SCHEDULER_ON_SIGNAL     0xFFFFFFFF // only when signalled
+
+// Time every task and the loop period, costs two core timer reads a task
+#define SCHEDULER_USE_PROFILE
+
+// Record deadline misses and feed the watchdog, see Scheduler_setDeadline
+#define SCHEDULER_USE_DEADLINES
+
+// Idle the CPU when no task is ready, see Scheduler_run
+#define SCHEDULER_USE_IDLE
+
+// Bin n counts loop periods of 2^n to 2^(n+1)-1 core timer cycles
+#define SCHEDULER_HISTOGRAM_BINS    32
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+typedef enum {
+    SCHEDULER_PRIORITY_HIGH = 0,    // link servicing, anything with a deadline
+    SCHEDULER_PRIORITY_NORMAL,
+    SCHEDULER_PRIORITY_LOW,         // displays, debugging
+    SCHEDULER_PRIORITY_COUNT,
+} SchedulerPriority;
+
+typedef uint8_t TaskId;
+
+typedef void (*SchedulerTask)();
+
+// Execution time of one task, in core timer cycles (see Timer_getCycles)
+typedef struct {
+    uint32_t runs;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+} TaskProfile;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: Scheduler_init()
+ * @return None
+ * @remark Removes all tasks. Needs Timer_init for periodic tasks. With
+ *  SCHEDULER_USE_IDLE, also makes WAIT enter idle rather than sleep, so
+ *  the peripheral clock and Timer1 keep running.
+ **********************************************************************/
+void Scheduler_init();
+
+/**********************************************************************
+ * Function: Scheduler_addTask()
+ * @param Function to run, usually a module's runSM.
+ * @param Priority.
+ * @param SCHEDULER_POLL, SCHEDULER_ON_SIGNAL, or a period in ms.
+ * @return The task's id, or SCHEDULER_INVALID if the table or the
+ *  timers are full.
+ * @remark Tasks of the same priority run in the order they were added.
+ *  Any task can also be signalled.
+ **********************************************************************/
+TaskId Scheduler_addTask(SchedulerTask run, SchedulerPriority priority,
+    uint32_t period);
+
+/**********************************************************************
+ * Function: Scheduler_signal()
+ * @param Task to make ready.
+ * @return None
+ * @remark Safe to call from an interrupt. Signalling a task that is
+ *  already ready does nothing, it runs once.
+ **********************************************************************/
+void Scheduler_signal(TaskId task);
+
+/**********************************************************************
+ * Function: Scheduler_run()
+ * @return None
+ * @remark Makes one pass: runs every polled task once, and every
+ *  signalled or due task, most urgent first. Call it from the main loop.
+ *  With SCHEDULER_USE_IDLE it then waits for an interrupt if nothing is
+ *  ready, and returns after the interrupt has been handled.
+ **********************************************************************/
+void Scheduler_run();
+
+#ifdef SCHEDULER_USE_DEADLINES
+/**********************************************************************
+ * Function: Scheduler_setDeadline()
+ * @param Task to supervise.
+ * @param (ms) Most time allowed from the start of one of its runs to the
+ *  start of the next, a little over its period.
+ * @param Whether the watchdog is only fed once it has run.
+ * @return SUCCESS, or FAILURE for a bad task.
+ * @remark The deadline starts with the task's first run, so a slow start
+ *  up isn't counted as a miss.
+ **********************************************************************/
+BOOL Scheduler_setDeadline(TaskId task, uint32_t maxPeriod, BOOL isCritical);
+
+/**********************************************************************
+ * Function: Scheduler_getCriticalPeriod()
+ * @return (ms) Longest deadline of the critical tasks, what the watchdog
+ *  has to wait for at least (see Watchdog_start), or 0 if none are.
+ **********************************************************************/
+uint32_t Scheduler_getCriticalPeriod();
+#endif
+
+#ifdef SCHEDULER_USE_PROFILE
+/**********************************************************************
+ * Function: Scheduler_getProfile()
+ * @param Task to look up.
+ * @param Set to its counters.
+ * @return SUCCESS, or FAILURE for a bad task.
+ **********************************************************************/
+BOOL Scheduler_getProfile(TaskId task, TaskProfile *profile);
+
+/**********************************************************************
+ * Function: Scheduler_getLoopHistogram()
+ * @return The SCHEDULER_HISTOGRAM_BINS loop period counts.
+ **********************************************************************/
+const uint32_t *Scheduler_getLoopHistogram();
+
+/**********************************************************************
+ * Function: Scheduler_clearProfile()
+ * @return None
+ * @remark Starts every counter over, call it once things have settled
+ *  after startup.
+ **********************************************************************/
+void Scheduler_clearProfile();
+
+/**********************************************************************
+ * Function: Scheduler_printProfile()
+ * @return None
+ * @remark Prints the runs, min/mean/max microseconds of every task, the
+ *  share of time spent idle, and the non-empty histogram bins. Blocks
+ *  while it prints, so the pass it runs in shows up as a long one.
+ **********************************************************************/
+void Scheduler_printProfile();
+#endif
+
+#endif // Scheduler_H
@@ -0,0 +1,102 @@
+/**
+ * @file    Sensors.h
+ *
+ * @brief
+ * Shared schedule for the sensor reads on the I2C buses.
+ *
+ * @details
+ * Every driver used to keep its own period off its own timer, so reads
+ * that happened to fall due together queued up behind each other on the
+ * bus, and the one at the back of the queue was late by all of them.
+ * Here each sensor is given a period and the bus time it expects one
+ * read to take, and Sensors_start picks a phase for each so that the
+ * reads on a bus are spread out over the milliseconds of a frame as
+ * evenly as the periods allow. The frame is the least common multiple
+ * of the periods on the bus, or SENSORS_FRAME_MAX if that's shorter.
+ *
+ * The phases are placed fastest sensor first, each on the millisecond
+ * whose busiest slot is least loaded so far. Every sensor has its own
+ * Timer handle, all started together so the phases hold. Expiring only
+ * marks the sensor due and signals one scheduler task, which reads the
+ * due sensors in the order they were added, so add the ones whose
+ * latency matters most first.
+ *
+ * Each read is timed with the core timer. Sensors_printSchedule dumps
+ * the phases, the read times and the worst latency from due to read,
+ * and the share of each bus that was planned and that reads really
+ * took.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef Sensors_H
+#define Sensors_H
+
+#include <stdint.h>
+#include "Board.h"
+#include "Scheduler.h"
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define SENSORS_MAX             8 // at most 32
+#define SENSORS_FRAME_MAX       200 // (ms) longest frame phases are planned over
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+// Reads the sensor now, usually a driver's _update
+typedef void (*SensorRead)();
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: Sensors_add()
+ * @param Function that reads the sensor.
+ * @param I2C bus the sensor is on.
+ * @param Milliseconds between reads.
+ * @param Microseconds one read is expected to keep the bus busy.
+ * @return SUCCESS, or FAILURE if the table is full, the period is 0 or
+ *  the schedule was already started.
+ **********************************************************************/
+BOOL Sensors_add(SensorRead read, I2C_MODULE bus, uint32_t period,
+    uint32_t cost);
+
+/**********************************************************************
+ * Function: Sensors_start()
+ * @param Priority of the task that does the reads.
+ * @return SUCCESS, or FAILURE if the scheduler or the timers are full.
+ * @remark Plans the phases and starts reading. Needs Timer_init and
+ *  Scheduler_init, and comes after every Sensors_add.
+ **********************************************************************/
+BOOL Sensors_start(SchedulerPriority priority);
+
+/**********************************************************************
+ * Function: Sensors_getPlannedUtilisation()
+ * @param I2C bus.
+ * @return Share of the bus's time the sensors on it expect to take,
+ *  from their costs and periods.
+ **********************************************************************/
+float Sensors_getPlannedUtilisation(I2C_MODULE bus);
+
+/**********************************************************************
+ * Function: Sensors_getUtilisation()
+ * @param I2C bus.
+ * @return Share of the time since Sensors_start that reads of the
+ *  sensors on the bus really took.
+ **********************************************************************/
+float Sensors_getUtilisation(I2C_MODULE bus);
+
+/**********************************************************************
+ * Function: Sensors_printSchedule()
+ * @return None
+ * @remark Prints each sensor's bus, period, phase, runs, mean and max
+ *  read time and worst latency, then the planned and achieved bus
+ *  utilisation. Blocks while it prints.
+ **********************************************************************/
+void Sensors_printSchedule();
+
+#endif // Sensors_H
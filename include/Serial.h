@@ -12,10 +12,32 @@
 #ifndef Serial_H
 #define Serial_H
 
+#include <stdint.h>
+#include "LogFormats.h"
+
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
  ******************************************************************************/
 
+/* Deferred binary log. Only the format id from LogFormats.h and the raw
+ * 32-bit arguments are queued, as one record:
+ *   0xA5, id, argument count, sequence, arguments (little endian), checksum
+ * where the checksum is the XOR of every byte after the 0xA5. Serial_runSM
+ * moves whole records out to the UART, and tool/log_decoder formats them.
+ * Pass floats through LOG_FLOAT, e.g.
+ *   SERIAL_LOG(LOG_GPS_FIX, LOG_FLOAT(lat), LOG_FLOAT(lon), LOG_FLOAT(alt));
+ */
+#define SERIAL_LOG_SYNC         0xA5
+#define SERIAL_LOG_MAX_ARGS     6
+
+#define SERIAL_LOG(id, ...) do { \
+        uint32_t _logArgs[] = { 0, ##__VA_ARGS__ }; \
+        Serial_log((id), &_logArgs[1], \
+            sizeof(_logArgs) / sizeof(_logArgs[0]) - 1); \
+    } while (0)
+
+#define LOG_FLOAT(f)    Serial_floatBits(f)
+
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
@@ -77,4 +99,34 @@ char Serial_isTransmitEmpty(void);
  * @date 2011.12.15  */
 char Serial_isReceiveEmpty(void);
 
+/**
+ * Function: Serial_runSM
+ * @param None
+ * @return None
+ * @remark Moves whole queued log records into the UART transmit buffer as
+ *      room allows. Call it every pass of the main loop.
+ * @date 2026.10.14  */
+void Serial_runSM(void);
+
+/**
+ * Function: Serial_log
+ * @param id, index of the format string in LogFormats.h
+ * @param args, the raw 32-bit arguments
+ * @param count, number of arguments, at most SERIAL_LOG_MAX_ARGS
+ * @return SUCCESS, or FAILURE if the record was dropped
+ * @remark Queues a log record without formatting it. Takes a few
+ *      microseconds and never waits; dropped records are counted and
+ *      reported with a LOG_OVERFLOW record once there is room. Use the
+ *      SERIAL_LOG macro rather than calling this directly.
+ * @date 2026.10.14  */
+int8_t Serial_log(uint8_t id, const uint32_t *args, uint8_t count);
+
+/**
+ * Function: Serial_floatBits
+ * @param f, float to log
+ * @return the IEEE-754 bits of f
+ * @remark Used through LOG_FLOAT.
+ * @date 2026.10.14  */
+uint32_t Serial_floatBits(float f);
+
 #endif // Serial_H
@@ -1,14 +1,17 @@
 /*
- * @file  Xbee.h
+ * @file  Sonar.h
  *
  * @author John Ash
  *
  * @brief
- * State machine for Xbee module.
+ * Range from the sonar's echo.
  *
  * @details
- * Module that wraps the bee in a statemachine that
- * reads from the UART.
+ * The sonar's analog window is sampled by the A/D on a hardware timer,
+ * a capture at a time, and each capture is searched for the echo of the
+ * transmit pulse with a matched filter. The range comes with how sure
+ * the search is of it. The analog range output is also read, averaged,
+ * for comparison.
  *
  * @date February 1, 2013 2:59 AM -- created
  *
@@ -16,16 +19,63 @@
 #ifndef SONAR_H
 #define SONAR_H
 
+#include <stdint.h>
+#include "Board.h"
+
 #define ANALOG_PIN AD_PORTV4
 #define ANALOG_WINDOW_PIN AD_PORTV5
 
+// (Hz) 1.7 cm of range a sample in air
+#define SONAR_SAMPLE_RATE       10000
+// 40 ms, the round trip to 6.8 m in air, a multiple of 8
+#define SONAR_SAMPLES           400
+// (m/s) 343 in air, about 1480 in water
+#define SONAR_SPEED_OF_SOUND    343.0f
 
-void Sonar_init();
+// A/D counts of the window for the transmit pulse
+#define SONAR_PULSE_THRESHOLD   498
+// Samples an echo lasts, the length of the matched filter
+#define SONAR_PULSE_SAMPLES     4
+// A/D counts an echo has to be over the floor, on average over its length
+#define SONAR_ECHO_MIN          8
 
+// Latest reading, see Sonar_getRange
+typedef struct {
+    float range;        // (m) to the strongest echo
+    float confidence;   // 0 to 1, how far it stands out from the next best
+    uint32_t time;      // (ms) get_time() the capture was searched at
+    BOOL isValid;       // an echo was found in the last capture
+} SonarRange;
 
 
-BOOL Sonar_runSM(uint32_t* rawAnalogWindowData, uint32_t* rawAnalogData);
+/**
+ * Function: Sonar_init
+ * @return None.
+ * @remark Starts the A/D on both pins and the first capture, uses Timer3.
+ */
+void Sonar_init();
 
+/**
+ * Function: Sonar_runSM
+ * @return TRUE when a capture has just been searched, there's a new
+ *  reading.
+ * @remark Searches a finished capture and starts the next one, otherwise
+ *  returns straight away.
+ */
+BOOL Sonar_runSM();
+
+/**
+ * Function: Sonar_getRange
+ * @param Set to the latest reading.
+ * @return None.
+ */
+void Sonar_getRange(SonarRange *range);
+
+/**
+ * Function: Sonar_getAnalog
+ * @return The analog range output, averaged, in A/D counts.
+ */
+unsigned int Sonar_getAnalog();
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file    Telemetry.h
+ *
+ * @brief
+ * Downlink of periodic telemetry inside a budget of the radio's bytes.
+ *
+ * @details
+ * Each stream is a function that sends one message, with how often it
+ * should go out, a priority, and the most bytes one costs. Telemetry_runSM
+ * spends a token bucket on the streams that are due, most important
+ * first. The bucket fills at a rate in bytes per second and holds at most
+ * TELEMETRY_BURST of them, so telemetry can never use more of the link
+ * than that, however many streams there are.
+ *
+ * A stream that is a whole period late because bytes were short loses
+ * that message instead of queueing it. The most important streams get
+ * the bytes first, so it's the least important that are thinned out.
+ * Telemetry only goes out while TELEMETRY_TX_RESERVE bytes of the XBee
+ * transmit buffer stay free after it. Commands and ACKs are sent directly
+ * and don't go through the bucket, so they never wait behind telemetry.
+ *
+ * The rate follows the link. It drops by a quarter in any second the
+ * radio gave up on packets (API mode only) or the heartbeats show more
+ * than a tenth of them lost either way, and creeps back up by
+ * TELEMETRY_RATE_STEP in seconds the streams wanted more than they got.
+ * It stays between TELEMETRY_RATE_MIN and the rate given to
+ * Telemetry_init, and holds while the connection is lost.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef Telemetry_H
+#define Telemetry_H
+
+#include <stdint.h>
+#include "Board.h"
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define TELEMETRY_STREAM_MAX    8
+#define TELEMETRY_INVALID       0xFF
+
+#define TELEMETRY_BURST         256 // (bytes) the bucket holds
+#define TELEMETRY_TX_RESERVE    128 // (bytes) left free for commands
+#define TELEMETRY_RATE_MIN      100 // (bytes/s)
+#define TELEMETRY_RATE_STEP     50 // (bytes/s) a second, back up to the most
+#define TELEMETRY_ADAPT_PERIOD  1000 // (ms) between rate changes
+
+// Priorities for Telemetry_addStream, lower values go first
+#define TELEMETRY_PRIORITY_HIGH     0
+#define TELEMETRY_PRIORITY_NORMAL   1
+#define TELEMETRY_PRIORITY_LOW      2
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+// Sends one message of a stream, returns the bytes it took, 0 for none
+typedef uint16_t (*TelemetrySend)();
+
+typedef uint8_t StreamId;
+
+typedef struct {
+    uint32_t sent; // messages
+    uint32_t bytes;
+    uint32_t decimated; // messages skipped for want of bytes
+} TelemetryStats;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: Telemetry_init()
+ * @param (bytes/s) Most the telemetry may use, and what it starts at.
+ * @return None
+ * @remark Removes every stream.
+ **********************************************************************/
+void Telemetry_init(uint16_t bytesPerSecond);
+
+/**********************************************************************
+ * Function: Telemetry_addStream()
+ * @param Function that sends one message of the stream.
+ * @param (ms) Period the stream should go out at.
+ * @param TELEMETRY_PRIORITY_HIGH, _NORMAL or _LOW.
+ * @param Most bytes one message takes on the link.
+ * @return Id of the stream, or TELEMETRY_INVALID if there are
+ *  TELEMETRY_STREAM_MAX already.
+ * @remark Streams of the same priority go in the order they're added.
+ **********************************************************************/
+StreamId Telemetry_addStream(TelemetrySend send, uint16_t period,
+    uint8_t priority, uint16_t bytes);
+
+/**********************************************************************
+ * Function: Telemetry_setPeriod()
+ * @param Stream.
+ * @param (ms) New period.
+ * @return SUCCESS, or FAILURE for a stream that doesn't exist.
+ **********************************************************************/
+int8_t Telemetry_setPeriod(StreamId stream, uint16_t period);
+
+/**********************************************************************
+ * Function: Telemetry_runSM()
+ * @return None
+ * @remark Sends whatever streams are due and affordable. Call it often,
+ *  every few milliseconds at least.
+ **********************************************************************/
+void Telemetry_runSM();
+
+/**********************************************************************
+ * Function: Telemetry_getRate()
+ * @return (bytes/s) The rate the bucket fills at now.
+ **********************************************************************/
+uint16_t Telemetry_getRate();
+
+/**********************************************************************
+ * Function: Telemetry_getStats()
+ * @param Stream, or TELEMETRY_INVALID for the sum of all of them.
+ * @param Set to the counters.
+ * @return SUCCESS, or FAILURE for a stream that doesn't exist.
+ **********************************************************************/
+int8_t Telemetry_getStats(StreamId stream, TelemetryStats *stats);
+
+/**********************************************************************
+ * Function: Telemetry_addBoatStreams()
+ * @return None
+ * @remark Adds the boat's streams: position (and heading) and guidance
+ *  state, the link, the error log, and with USE_THERMAL and USE_BATTERY
+ *  the thermal target and the battery voltage.
+ **********************************************************************/
+void Telemetry_addBoatStreams();
+
+#endif // Telemetry_H
@@ -0,0 +1,106 @@
+/*
+ * File:   Thermal.h
+ *
+ * Created on October 14, 2026
+ */
+
+#ifndef THERMAL_H
+#define	THERMAL_H
+
+#include <stdint.h>
+#include "Board.h"
+#include "Boot.h"
+
+/*******************************************************************************
+ * Public Definitions                                                          *
+ ******************************************************************************/
+
+// MLX90620 array, pixel (row, column) is at row + column * THERMAL_ROWS
+#define THERMAL_ROWS                4
+#define THERMAL_COLUMNS             16
+#define THERMAL_PIXELS              (THERMAL_ROWS * THERMAL_COLUMNS)
+
+// (degrees) field of view of the 60x16 version, column 0 on the left
+#define THERMAL_FIELD_HORIZONTAL    60.0f
+#define THERMAL_FIELD_VERTICAL      16.0f
+
+// (degrees F) how far above the background a pixel has to be to be warm
+#define THERMAL_WARM_DELTA          4.0f
+
+/*******************************************************************************
+ * Public Typedefs                                                             *
+ ******************************************************************************/
+
+// Warmest blob in the last processed frame, see Thermal_getTarget
+typedef struct {
+    float bearing;      // (degrees) right of the yaw the frame was taken at
+    float heading;      // (degrees) 0 to 360, that yaw plus the bearing
+    float elevation;    // (degrees) above the middle of the array
+    float peak;         // (degrees F) warmest pixel above its background
+    uint8_t pixels;     // in the blob
+    uint32_t time;      // (ms) get_time() the frame was taken at
+} ThermalTarget;
+
+/*******************************************************************************
+ * Public Functions                                                            *
+ ******************************************************************************/
+
+/**
+ * Function: Thermal_init
+ * @return None.
+ * @remark Starts reading the calibration EEPROM and setting up the camera,
+ *  which Thermal_initSM carries on with. Needs Timer_init. With the store
+ *  up (see Nvm.h) the calibration kept from the last boot is used, once a
+ *  few EEPROM bytes show it's the same camera.
+ * @date 2013.01.21  */
+void Thermal_init();
+
+/**
+ * Function: Thermal_initSM
+ * @return BOOT_PENDING while the camera is coming up, then BOOT_READY or
+ *  BOOT_FAILED.
+ * @remark One step of the set up Thermal_init started, a queued I2C
+ *  transfer each, and the frame timer once it's done. Thermal_runSM calls
+ *  it too, and takes no frames before then.
+ * @date 2026.10.14  */
+BootStatus Thermal_initSM();
+
+/**
+ * Function: Thermal_runSM
+ * @return None.
+ * @remark One step, either takes a frame into the free buffer when one is
+ *  due, or processes the frame taken last. Call it often.
+ * @date 2013.01.21  */
+void Thermal_runSM();
+
+/**
+ * Function: Thermal_setYaw
+ * @param (degrees) Where the camera points now.
+ * @return None.
+ * @remark Stamped on each frame as it's taken, so a target's heading is
+ *  from where the camera was then, not where it is once processed.
+ * @date 2026.10.14  */
+void Thermal_setYaw(float yaw);
+
+/**
+ * Function: Thermal_getTarget
+ * @param Set to the warmest blob, if there is one.
+ * @return TRUE if the last processed frame had a warm blob, FALSE if not
+ *  or while the background is still being learnt.
+ * @date 2026.10.14  */
+BOOL Thermal_getTarget(ThermalTarget *target);
+
+/**
+ * Function: Thermal_getFrame
+ * @return (degrees F) THERMAL_PIXELS temperatures of the last processed
+ *  frame. They stay put until the next frame is processed.
+ * @date 2026.10.14  */
+const float *Thermal_getFrame();
+
+/**
+ * Function: Thermal_getProcessMicros
+ * @return (us) Longest any frame took to process.
+ * @date 2026.10.14  */
+uint32_t Thermal_getProcessMicros();
+
+#endif	/* THERMAL_H */
@@ -0,0 +1,141 @@
+/**
+ * @file    ThermalFrame.h
+ *
+ * @brief
+ * Packing of thermal camera frames for the radio, and rebuilding them.
+ *
+ * @details
+ * A frame of 64 floats is 256 bytes, over a quarter of a second of a
+ * 9600 baud XBee on its own. Here each pixel is rounded to a 16-bit
+ * centi-degree (F), and sent as the difference from what the receiver
+ * already has. Most of the array is water that barely changes, so most
+ * differences are no more than the noise and fit in a byte, and the runs
+ * where nothing changed at all take a byte for the whole run.
+ *
+ * Each difference is zigzagged, so small negative ones are small too, and
+ * shifted up a bit to leave room for a flag, then written as a varint of
+ * 7 bits a byte, low first. A flag of 0 is a difference, a flag of 1 is a
+ * run of (value + 1) pixels that didn't change. Pixels go in the order
+ * the camera reads them, down each column left to right.
+ *
+ * A keyframe predicts each pixel from the one before it in the same frame
+ * instead, so it can be rebuilt from nothing, and comes every
+ * THERMAL_FRAME_KEYFRAME_INTERVAL frames. A lost frame spoils the ones
+ * after it only until the next keyframe. Between keyframes differences
+ * inside the deadband are sent as no change, and the encoder keeps what
+ * the receiver rebuilt rather than what it saw, so the error stays inside
+ * the deadband rather than adding up.
+ *
+ * A packed frame is at most THERMAL_FRAME_BYTES_MAX and is sent as
+ * THERMAL_FRAME messages of up to THERMAL_FRAME_CHUNK bytes each, see
+ * ThermalFrame_getChunks. Nothing here touches the hardware, so the
+ * ground station builds it as it is.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef ThermalFrame_H
+#define ThermalFrame_H
+
+#include <stdint.h>
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define THERMAL_FRAME_PIXELS            64
+#define THERMAL_FRAME_BYTES_MAX         (3 * THERMAL_FRAME_PIXELS)
+#define THERMAL_FRAME_CHUNK             80 // data field of THERMAL_FRAME
+#define THERMAL_FRAME_KEYFRAME_INTERVAL 16
+#define THERMAL_FRAME_DEADBAND          5 // (centi-degrees) sent as no change
+
+// Flags of a THERMAL_FRAME message
+#define THERMAL_FRAME_KEYFRAME          0x01
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+// Sending side, set up with ThermalFrame_initEncoder
+typedef struct {
+    int16_t pixels[THERMAL_FRAME_PIXELS]; // (centi-degrees) as rebuilt
+    uint16_t frame; // number of the next frame
+    uint8_t sinceKeyframe;
+} ThermalFrameEncoder;
+
+// Receiving side, set up with ThermalFrame_initDecoder
+typedef struct {
+    int16_t pixels[THERMAL_FRAME_PIXELS]; // (centi-degrees) last rebuilt
+    uint32_t time; // (ms) of the last rebuilt
+    uint16_t frame; // number of the last rebuilt
+    uint8_t isSynced; // pixels are good to build the next frame on
+    // Chunks of the frame being put back together
+    uint8_t packed[THERMAL_FRAME_BYTES_MAX];
+    uint16_t packedLength, packedFrame;
+    uint8_t nextChunk, packedFlags;
+} ThermalFrameDecoder;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: ThermalFrame_initEncoder()
+ * @param Encoder to set up.
+ * @return None
+ * @remark The first frame packed is a keyframe.
+ **********************************************************************/
+void ThermalFrame_initEncoder(ThermalFrameEncoder *encoder);
+
+/**********************************************************************
+ * Function: ThermalFrame_encode()
+ * @param Encoder.
+ * @param (degrees F) THERMAL_FRAME_PIXELS temperatures.
+ * @param Where to pack the frame, THERMAL_FRAME_BYTES_MAX bytes.
+ * @param Set to the frame's flags.
+ * @return Bytes packed.
+ * @remark Numbers the frame, the number is encoder->frame - 1 after.
+ **********************************************************************/
+uint16_t ThermalFrame_encode(ThermalFrameEncoder *encoder,
+    const float *temperatures, uint8_t *packed, uint8_t *flags);
+
+/**********************************************************************
+ * Function: ThermalFrame_getChunks()
+ * @param Bytes in the packed frame.
+ * @return THERMAL_FRAME messages it takes, at least one.
+ **********************************************************************/
+uint8_t ThermalFrame_getChunks(uint16_t length);
+
+/**********************************************************************
+ * Function: ThermalFrame_initDecoder()
+ * @param Decoder to set up.
+ * @return None
+ * @remark Nothing is rebuilt until the first keyframe.
+ **********************************************************************/
+void ThermalFrame_initDecoder(ThermalFrameDecoder *decoder);
+
+/**********************************************************************
+ * Function: ThermalFrame_receive()
+ * @param Decoder.
+ * @param Fields of a THERMAL_FRAME message: time, frame, flags, chunk,
+ *  chunks, length and data.
+ * @return TRUE if the chunk finished a frame and decoder->pixels now
+ *  holds it, FALSE otherwise.
+ * @remark A missing chunk drops its frame, and a missing frame leaves the
+ *  decoder waiting for the next keyframe.
+ **********************************************************************/
+uint8_t ThermalFrame_receive(ThermalFrameDecoder *decoder, uint32_t time,
+    uint16_t frame, uint8_t flags, uint8_t chunk, uint8_t chunks,
+    uint8_t length, const uint8_t *data);
+
+/**********************************************************************
+ * Function: ThermalFrame_decode()
+ * @param Decoder.
+ * @param Packed frame, its length and its flags.
+ * @return TRUE if the frame was rebuilt into decoder->pixels, FALSE if it
+ *  was malformed or needs a frame the decoder doesn't have.
+ * @remark For a packed frame that didn't come in chunks.
+ **********************************************************************/
+uint8_t ThermalFrame_decode(ThermalFrameDecoder *decoder,
+    const uint8_t *packed, uint16_t length, uint8_t flags);
+
+#endif // ThermalFrame_H
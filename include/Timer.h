@@ -10,6 +10,22 @@
  * This module multiplexes a single timer into 16 timers with 1 ms
  * resoluton.
  *
+ * Timer1 is not ticked every millisecond. Running timers are kept sorted
+ * by deadline and the period register is set to reach the earliest one,
+ * so the interrupt only fires when a timer expires, or at least every
+ * 100 ms to keep the free running time. A timer still expires within a
+ * millisecond or so of its time.
+ *
+ * The first TIMER_NUMBER_MAX timers are the fixed numbers in Board.h.
+ * Modules that only need a timer for themselves should get a handle
+ * from Timer_create instead, optionally with a callback, which
+ * Timer_runCallbacks calls from the main loop once the timer expires.
+ * Durations are 32-bit milliseconds, up to about 24 days.
+ *
+ * For anything shorter than a millisecond, Timer_getCycles and
+ * Timer_getMicros read the MIPS core timer, which counts at half the
+ * system clock.
+ *
  * @date December 22, 2012  -- Created
  */
 #ifndef Timer_H
@@ -22,6 +38,13 @@
  ***********************************************************************/
 
 #define TIMER_NUMBER_MAX    16
+#define TIMER_HANDLE_MAX    32 // fixed numbers plus handles, at most 32
+#define TIMER_INVALID       0xFF
+
+// Core timer, half the system clock of the board profile
+#define TIMER_CYCLES_PER_SECOND     (BOARD_SYSTEM_CLOCK / 2)
+#define TIMER_CYCLES_PER_MICRO      (TIMER_CYCLES_PER_SECOND / 1000000L)
+#define TIMER_CYCLES_TO_MICROS(c)   ((c) / TIMER_CYCLES_PER_MICRO)
 
 #define TIMER_ACTIVE 1
 #define TIMER_EXPIRED 1
@@ -29,6 +52,13 @@
 #define TIMER_NOT_ACTIVE 0
 #define TIMER_NOT_EXPIRED 0
 
+typedef uint8_t TimerHandle;
+
+/**
+ * Called by Timer_runCallbacks with the handle that expired and the
+ * context it was created with.
+ */
+typedef void (*TimerCallback)(TimerHandle timer, void *context);
 
 /**********************************************************************
  * PUBLIC FUNCTIONS                                                   *
@@ -56,7 +86,66 @@ BOOL Timer_isInitialized();
  * @return SUCCESS or ERROR.
  * @remark Creates a new active timer that will tick for newTime milliseconds.
  **********************************************************************/
-int8_t Timer_new(uint8_t timerNumber, uint16_t newTime);
+int8_t Timer_new(uint8_t timerNumber, uint32_t newTime);
+
+/**********************************************************************
+ * Function: Timer_newPeriodic()
+ * @param Timer number.
+ * @param Number of milliseconds between expiring.
+ * @return SUCCESS or ERROR.
+ * @remark Starts a timer that expires every period milliseconds, until
+ *  it is stopped or restarted with Timer_new. Expiring is counted from
+ *  the last deadline, not from when it was noticed, so it doesn't drift.
+ **********************************************************************/
+int8_t Timer_newPeriodic(uint8_t timerNumber, uint32_t period);
+
+/**********************************************************************
+ * Function: Timer_newPhased()
+ * @param Timer number.
+ * @param Number of milliseconds until it first expires.
+ * @param Number of milliseconds between expiring after that.
+ * @return SUCCESS or ERROR.
+ * @remark Like Timer_newPeriodic, but with the first deadline set apart,
+ *  so timers of the same period started together can be kept out of
+ *  step with each other.
+ **********************************************************************/
+int8_t Timer_newPhased(uint8_t timerNumber, uint32_t delay, uint32_t period);
+
+/**********************************************************************
+ * Function: Timer_create()
+ * @param Function to call when the timer expires, or NULL to poll it.
+ * @param Passed to the callback.
+ * @return A free timer handle, or TIMER_INVALID if none are left.
+ * @remark The handle works with every function here that takes a timer
+ *  number. It starts stopped, use Timer_new or Timer_newPeriodic.
+ **********************************************************************/
+TimerHandle Timer_create(TimerCallback callback, void *context);
+
+/**********************************************************************
+ * Function: Timer_destroy()
+ * @param Handle from Timer_create.
+ * @return SUCCESS or ERROR.
+ * @remark Stops the timer and frees the handle. A callback already
+ *  queued for it is dropped.
+ **********************************************************************/
+int8_t Timer_destroy(TimerHandle timer);
+
+/**********************************************************************
+ * Function: Timer_runCallbacks()
+ * @return none
+ * @remark Call from the main loop. Runs the callback of every timer
+ *  that expired since the last call, in the order they expired, and
+ *  clears their expired events.
+ **********************************************************************/
+void Timer_runCallbacks();
+
+/**********************************************************************
+ * Function: Timer_hasCallbacks()
+ * @return TRUE if a callback is queued for Timer_runCallbacks.
+ * @remark Check it with interrupts off before sleeping, so a timer
+ *  expiring in between can't be missed.
+ **********************************************************************/
+BOOL Timer_hasCallbacks();
 
 /**********************************************************************
  * Function: Timer_start()
@@ -81,7 +170,7 @@ int8_t Timer_stop(uint8_t timerNumber);
  * @return SUCCESS or ERROR.
  * @remark Sets the timer's timeout time, but does not make it active.
  **********************************************************************/
-int8_t Timer_set(uint8_t timerNumber, uint16_t newTime);
+int8_t Timer_set(uint8_t timerNumber, uint32_t newTime);
 
 /**********************************************************************
  * Function: Timer_isActive()
@@ -110,9 +199,25 @@ int8_t Timer_clear(uint8_t timerNumber);
 
 /**********************************************************************
  * Function: get_time()
- * @return The free running time.
- * @remark Used to measure elapsed time.
+ * @return The free running time in milliseconds.
+ * @remark Used to measure elapsed time. Stays at 0 until Timer_init.
  **********************************************************************/
 uint32_t get_time(void);
 
+/**********************************************************************
+ * Function: Timer_getCycles()
+ * @return The core timer count, TIMER_CYCLES_PER_SECOND.
+ * @remark Wraps every 107 s. The difference of two reads taken as
+ *  uint32_t is right across the wrap for anything shorter than that,
+ *  so it's the cheapest way to time a short piece of code.
+ **********************************************************************/
+uint32_t Timer_getCycles();
+
+/**********************************************************************
+ * Function: Timer_getMicros()
+ * @return Microseconds since Timer_init, or 0 before it.
+ * @remark Wraps every 71 minutes, take differences as uint32_t.
+ **********************************************************************/
+uint32_t Timer_getMicros();
+
 #endif // Timer_H
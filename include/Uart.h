@@ -18,8 +18,81 @@
 
 #define UART1_ID 1
 #define UART2_ID 2
+#define UART3_ID 3
+#define UART4_ID 4
+#define UART5_ID 5
+#define UART6_ID 6
 #define UART_SERIAL_ID UART1_ID
 
+/* Receive and transmit buffer sizes per port, each a power of two. Override
+ * them from the project to put the RAM where the traffic is. A port with a
+ * receive size of 0 is not built. UART3-6 only exist on the PIC32MX5/6/7
+ * parts, not on the Uno32. */
+#ifndef UART1_RX_SIZE
+#define UART1_RX_SIZE 128   // serial console, mostly output
+#endif
+#ifndef UART1_TX_SIZE
+#define UART1_TX_SIZE 512
+#endif
+#ifndef UART2_RX_SIZE
+#define UART2_RX_SIZE 1024  // GPS or XBee, receive heavy on the GPS
+#endif
+#ifndef UART2_TX_SIZE
+#define UART2_TX_SIZE 512
+#endif
+#ifndef UART3_RX_SIZE
+#define UART3_RX_SIZE 0
+#endif
+#ifndef UART3_TX_SIZE
+#define UART3_TX_SIZE 64
+#endif
+#ifndef UART4_RX_SIZE
+#define UART4_RX_SIZE 0
+#endif
+#ifndef UART4_TX_SIZE
+#define UART4_TX_SIZE 64
+#endif
+#ifndef UART5_RX_SIZE
+#define UART5_RX_SIZE 0
+#endif
+#ifndef UART5_TX_SIZE
+#define UART5_TX_SIZE 64
+#endif
+#ifndef UART6_RX_SIZE
+#define UART6_RX_SIZE 0
+#endif
+#ifndef UART6_TX_SIZE
+#define UART6_TX_SIZE 64
+#endif
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+// Link counters for one port, see UART_getStats
+typedef struct UartStats {
+    uint32_t bytesIn;       // bytes received into the ring
+    uint32_t bytesOut;      // bytes accepted for transmit
+    uint32_t rxDropped;     // received bytes lost to a full ring
+    uint32_t txDropped;     // bytes the transmit ring had no room for
+    uint16_t rxOverruns;    // hardware receive FIFO overruns
+    uint16_t rxPeak;        // most bytes ever waiting in the receive ring
+    uint16_t txPeak;        // most bytes ever waiting in the transmit ring
+    uint16_t isrMaxTicks;   // longest ISR, in core timer ticks (SYSCLK/2)
+} UartStats;
+
+// Called from the receive interrupt with the port's id, see UART_setReceiveHandler
+typedef void (*UartReceiveHandler)(uint8_t id);
+
+/* Define to build the DMA receive/transmit path (see UART_enableDMA).
+ * The PIC32MX320F128H on the Uno32 has no DMA controller, so this is
+ * only usable on parts like the PIC32MX340/360/795 (Max32). */
+//#define UART_USE_DMA
+
+/* Interrupt on the RX FIFO 3/4 full and TX FIFO empty instead of on every
+ * byte, and move the whole FIFO in each ISR pass. */
+#define UART_USE_FIFO
+
 /**
 * Function: UART_init()
 * @param id: identifies the UART module we want to initialize.
@@ -32,6 +105,17 @@
 
 void UART_init(uint8_t id, uint32_t baudRate);
 
+/**
+* Function: UART_enableDMA
+* @param id: identifies the UART module to switch to DMA mode
+* @return SUCCESS or FAILURE if DMA is not built in (UART_USE_DMA)
+* @remark Must be called after UART_init. Received bytes are written straight
+*  into the receive buffer by a DMA channel, and the transmit buffer is sent
+*  out in contiguous blocks, so neither direction takes an interrupt per byte.
+*  UART_getChar/UART_putChar are used the same way as before.
+* @date October 14th, 2026 */
+char UART_enableDMA(uint8_t id);
+
 /**
 * Function: UART_putChar
 * @param identifies the UART module
@@ -57,6 +141,29 @@ void UART_putChar(uint8_t id, char ch);
 * @date February 1st, 2013 */
 void UART_putString(uint8_t id, char* Data, int Length);
 
+/**
+* Function: UART_write
+* @param identifies the UART module
+* @param data to be sent
+* @param number of bytes in data
+* @return number of bytes accepted into the transmit buffer
+* @remark Copies as much of data as fits into the transmit buffer (at most
+* two memcpy spans) and starts the uart transmitting. Never waits for
+* space, so callers should check the return against length.
+* @date October 14th, 2026 */
+uint16_t UART_write(uint8_t id, const uint8_t *data, uint16_t length);
+
+/**
+* Function: UART_read
+* @param identifies the UART module
+* @param buffer to copy received bytes into
+* @param maximum number of bytes to copy
+* @return number of bytes copied, 0 if nothing has been received
+* @remark Copies the received bytes out of the receive buffer in at most two
+* memcpy spans. Never waits for data.
+* @date October 14th, 2026 */
+uint16_t UART_read(uint8_t id, uint8_t *buffer, uint16_t maxLength);
+
 
 /**
 * Function: UART_getChar
@@ -91,4 +198,64 @@ char UART_isTransmitEmpty(uint8_t id);
 * @date February 1st, 2013 */
 char UART_isReceiveEmpty(uint8_t id);
 
+/**
+* Function: UART_getTransmitSpace
+* @param identifies the UART module
+* @return number of bytes UART_write would accept right now
+* @remark lets callers queue whole frames instead of partial ones
+* @date October 14th, 2026 */
+uint16_t UART_getTransmitSpace(uint8_t id);
+
+/**
+* Function: UART_reserve
+* @param identifies the UART module
+* @param set to the start of the reserved region in the transmit buffer
+* @param number of bytes wanted
+* @return length if a contiguous region that long is free, 0 otherwise
+* @remark Lets a frame be serialized straight into the transmit buffer.
+* Nothing is sent until UART_commit. A region can be too short near the
+* end of the buffer even when UART_getTransmitSpace is large enough, so
+* callers need a fallback to UART_write. Main loop only.
+* @date October 14th, 2026 */
+uint16_t UART_reserve(uint8_t id, uint8_t **region, uint16_t length);
+
+/**
+* Function: UART_commit
+* @param identifies the UART module
+* @param number of bytes written into the region from UART_reserve
+* @return None
+* @remark Hands the bytes to the transmitter.
+* @date October 14th, 2026 */
+void UART_commit(uint8_t id, uint16_t length);
+
+/**
+* Function: UART_getStats
+* @param identifies the UART module
+* @param where to copy the counters
+* @return SUCCESS or FAILURE for a bad id
+* @remark Takes a snapshot of the port's link counters, so buffers and
+* baud rates can be sized from field data.
+* @date October 14th, 2026 */
+char UART_getStats(uint8_t id, UartStats *stats);
+
+/**
+* Function: UART_setReceiveHandler
+* @param identifies the UART module
+* @param function to call, or NULL for none
+* @return SUCCESS or FAILURE for a bad id
+* @remark The handler runs in the receive interrupt whenever bytes were
+* put in the ring, so it should only flag work for the main loop, like
+* Scheduler_signal. With UART_USE_FIFO a short burst can sit in the
+* hardware FIFO without an interrupt, so the reader still has to poll.
+* @date October 14th, 2026 */
+char UART_setReceiveHandler(uint8_t id, UartReceiveHandler handler);
+
+/**
+* Function: UART_clearStats
+* @param identifies the UART module
+* @return None
+* @remark Zeroes the port's link counters.
+* @date October 14th, 2026 */
+void UART_clearStats(uint8_t id);
+
 #endif
\ No newline at end of file
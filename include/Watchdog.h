@@ -0,0 +1,166 @@
+/**
+ * @file    Watchdog.h
+ *
+ * @brief
+ * The PIC32's watchdog timer, the scheduler's deadline misses, and what
+ * of them outlives a reset.
+ *
+ * @details
+ * A task that hangs, such as on an I2C wait that never ends, or a main
+ * loop that's starved, used to leave the board frozen until the operator
+ * noticed. With the watchdog started the board resets instead, and says
+ * why once it's back up.
+ *
+ * The scheduler does the supervising (see Scheduler_setDeadline): each
+ * task can be given the most time allowed between its runs, and a run
+ * later than that is recorded here as a miss, with when it was and the
+ * task. Some of the tasks are critical, and the watchdog is only fed
+ * once every critical one has run since the last feed, so the board
+ * resets when one of them stops running for longer than the watchdog's
+ * period.
+ *
+ * The reset reason, the task running when a reset came, and the last
+ * miss are kept in RAM that the C startup doesn't clear, so they're still
+ * there after a watchdog or software reset, and are printed by
+ * Watchdog_init. A power-up or brown-out starts them over.
+ *
+ * The watchdog's period is set by the configuration bits, which belong
+ * to the bootloader, so Watchdog_start only turns it on if that period is
+ * long enough for the critical tasks.
+ *
+ * WATCHDOG_TEST (in the .c file) conditionally compiles the test harness.
+ *
+ * @date October 14, 2026 -- Created
+ */
+#ifndef Watchdog_H
+#define Watchdog_H
+
+#include <stdint.h>
+#include "Board.h"
+
+/***********************************************************************
+ * PUBLIC DEFINITIONS                                                  *
+ ***********************************************************************/
+
+#define WATCHDOG_MISS_LOG   8 // misses kept for Watchdog_printStatus
+#define WATCHDOG_NO_TASK    0xFF
+
+// The watchdog's period has to be this many times the longest critical
+//  period, the LPRC it counts is only good to about 15%
+#define WATCHDOG_MARGIN     2
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+typedef enum {
+    WATCHDOG_RESET_POWER = 0,   // power-up
+    WATCHDOG_RESET_BROWNOUT,
+    WATCHDOG_RESET_PIN,         // MCLR, the reset button or the programmer
+    WATCHDOG_RESET_SOFTWARE,
+    WATCHDOG_RESET_WATCHDOG,    // a critical task stopped running
+    WATCHDOG_RESET_CONFIG,      // configuration bits mismatch
+    WATCHDOG_RESET_UNKNOWN,
+} WatchdogReset;
+
+// A task that ran later than its deadline
+typedef struct {
+    uint32_t time; // (ms) since boot, when it finally ran
+    uint32_t late; // (ms) after its deadline
+    uint8_t task; // TaskId
+} WatchdogMiss;
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: Watchdog_init()
+ * @return None
+ * @remark Takes the reset reason, and prints it along with the task and
+ *  the last miss from before the reset if there was one. Call it first
+ *  thing after Serial_init, the watchdog stays off until Watchdog_start.
+ **********************************************************************/
+void Watchdog_init();
+
+/**********************************************************************
+ * Function: Watchdog_start()
+ * @param (ms) Longest time the critical tasks may go between feeds.
+ * @return SUCCESS, or FAILURE if the watchdog's period is shorter than
+ *  WATCHDOG_MARGIN times that, and it was left off.
+ * @remark Once on, the watchdog can't be turned off again until a reset.
+ **********************************************************************/
+BOOL Watchdog_start(uint32_t longestPeriod);
+
+/**********************************************************************
+ * Function: Watchdog_isRunning()
+ * @return TRUE once Watchdog_start turned the watchdog on.
+ **********************************************************************/
+BOOL Watchdog_isRunning();
+
+/**********************************************************************
+ * Function: Watchdog_getPeriod()
+ * @return (ms) Nominal watchdog period set by the configuration bits.
+ **********************************************************************/
+uint32_t Watchdog_getPeriod();
+
+/**********************************************************************
+ * Function: Watchdog_feed()
+ * @return None
+ * @remark Starts the watchdog's period over. The scheduler calls it, see
+ *  Scheduler_setDeadline.
+ **********************************************************************/
+void Watchdog_feed();
+
+/**********************************************************************
+ * Function: Watchdog_setTask()
+ * @param Task about to run, or WATCHDOG_NO_TASK once it's done.
+ * @return None
+ * @remark Kept through a reset, so a watchdog reset can tell which task
+ *  hung. Two stores, cheap enough to call around every task.
+ **********************************************************************/
+void Watchdog_setTask(uint8_t task);
+
+/**********************************************************************
+ * Function: Watchdog_recordMiss()
+ * @param Task that missed its deadline.
+ * @param (ms) How late it ran.
+ * @return None
+ **********************************************************************/
+void Watchdog_recordMiss(uint8_t task, uint32_t late);
+
+/**********************************************************************
+ * Function: Watchdog_getResetReason()
+ * @return Why the board last reset.
+ **********************************************************************/
+WatchdogReset Watchdog_getResetReason();
+
+/**********************************************************************
+ * Function: Watchdog_getResetTask()
+ * @return Task that was running when the board last reset, or
+ *  WATCHDOG_NO_TASK if none was, or it was a power-up.
+ **********************************************************************/
+uint8_t Watchdog_getResetTask();
+
+/**********************************************************************
+ * Function: Watchdog_getLastMiss()
+ * @param Set to the last miss, which may be from before the reset.
+ * @return SUCCESS, or FAILURE if there wasn't one since power-up.
+ **********************************************************************/
+BOOL Watchdog_getLastMiss(WatchdogMiss *miss);
+
+/**********************************************************************
+ * Function: Watchdog_getMissCount()
+ * @return Misses since Watchdog_init.
+ **********************************************************************/
+uint32_t Watchdog_getMissCount();
+
+/**********************************************************************
+ * Function: Watchdog_printStatus()
+ * @return None
+ * @remark Prints the reset reason, the watchdog's period, and the misses
+ *  since boot, the newest WATCHDOG_MISS_LOG of them in full.
+ **********************************************************************/
+void Watchdog_printStatus();
+
+#endif // Watchdog_H
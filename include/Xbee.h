@@ -10,6 +10,34 @@
  * Module that wraps the bee in a statemachine that
  * reads from the UART.
  *
+ * The radio runs in API mode at 57600 baud: MAVLink frames go out as TX
+ * requests to the other radio, which reports back whether each one was
+ * acknowledged, and come in as RX packets with their signal strength.
+ * A factory radio is moved to API mode from Xbee_runSM, a command at a
+ * time, the first time it boots, one already in API mode is ready in a
+ * few milliseconds. A radio that never answers is left transparent at
+ * 9600 baud, the way it used to run.
+ *
+ * Each radio's MY is the address of its MAVLink system id, so the base
+ * and any number of boats share the channel, and a frame goes to the
+ * one system it's for, see Mavlink_send_frame_to. The id is kept in the
+ * flash store once set with Xbee_setSystemId, and a radio in API mode
+ * that has another address is given it when it boots, so a boat is
+ * renumbered without reflashing. A transparent radio only has its DL, a
+ * boat reaches the base and the base only the first boat.
+ *
+ * Both ends of each link send a heartbeat every second, numbered and
+ * stamped with the sender's clock, and echo back the newest one they
+ * heard. From those each end works out how many of the other's it lost
+ * over the last 32, the round trip, and the jitter, for each peer, see
+ * Xbee_getPeerLinkQuality. The round trips also go to that peer's
+ * MAVLink retransmit timeout.
+ *
+ * A packet costs about the same time on the air however little is in it,
+ * so in API mode the sends of a few milliseconds to the same radio can be
+ * packed into one, see Xbee_setAggregation. MAVLink frames are read as a stream, so the
+ * other end unpacks them as it would separate packets.
+ *
  * @date February 1, 2013 2:59 AM -- created
  *
  */
@@ -22,6 +50,31 @@
  ***********************************************************************/
 //#define XBEE_TEST //used for testing Xbee
 #define XBEE_UART_ID             UART2_ID
+#define XBEE_PAYLOAD_MAX         100 // (bytes) RF data of one packet
+
+/***********************************************************************
+ * PUBLIC TYPEDEFS                                                     *
+ ***********************************************************************/
+
+typedef struct {
+    int8_t rssi; // (dBm) of the last packet received, 0 before one
+    uint8_t lastTxStatus; // of the last packet sent, 0 acknowledged
+    uint32_t txAcked; // packets the other radio acknowledged
+    uint32_t txFailed; // packets given up on, no ACK or no clear channel
+    uint32_t rxPackets; // packets received
+    uint32_t rxErrors; // API frames cut short or with a bad checksum
+    uint32_t txBatched; // sends packed into a packet after another one
+} XbeeStats;
+
+typedef struct {
+    uint8_t isConnected; // heard a heartbeat in the last 4 s
+    uint8_t loss; // (%) of their last 32 heartbeats we lost
+    uint8_t peerLoss; // (%) of ours they lost, from their heartbeat
+    uint16_t rtt; // (ms) smoothed round trip, 0 before one
+    uint16_t rttLast; // (ms) last round trip
+    uint16_t jitter; // (ms) smoothed change in the time on the way
+    uint32_t heartbeats; // received
+} XbeeLinkQuality;
 
 /**********************************************************************
  * PUBLIC FUNCTIONS                                                   *
@@ -32,8 +85,9 @@
  * Function: Xbee_init()
  * @param N/A
  * @return Failure or Success
- * @remark Initializes the Xbee module. Sets up API mode if the flag is
- * enabled. The function than initializes the sendArray.
+ * @remark Initializes the Xbee module and starts looking for the radio
+ * in API mode, without waiting. Nothing is sent until Xbee_isReady.
+ * Takes the system id from the flash store, call Nvm_init first.
  * @author John Ash
  * @date February 1st 2013
  **********************************************************************/
@@ -51,19 +105,122 @@ uint8_t Xbee_init();
  **********************************************************************/
 void Xbee_runSM();
 
+/**********************************************************************
+ * Function: Xbee_send()
+ * @param data: bytes to send, up to XBEE_PAYLOAD_MAX in API mode
+ * @param length: how many
+ * @return SUCCESS, or FAILURE if it was dropped
+ * @remark One packet to the default radio in API mode, the base's for
+ *  a boat and the first boat's for the base, or straight out of the UART
+ *  when transparent. Dropped while configuring.
+ * @date October 14th 2026
+ **********************************************************************/
+uint8_t Xbee_send(const uint8_t *data, uint16_t length);
+
+/**********************************************************************
+ * Function: Xbee_sendTo()
+ * @param address: radio of one system, MAVLINK_ADDRESS(sysid), or
+ *  MAVLINK_ADDRESS_BROADCAST for every radio on the channel
+ * @param data: bytes to send, up to XBEE_PAYLOAD_MAX in API mode
+ * @param length: how many
+ * @return SUCCESS, or FAILURE if it was dropped
+ * @remark As Xbee_send, a transparent radio sends to its DL whatever the
+ *  address. A broadcast isn't acknowledged or retried by the radios.
+ * @date October 14th 2026
+ **********************************************************************/
+uint8_t Xbee_sendTo(uint16_t address, const uint8_t *data, uint16_t length);
 
+/**********************************************************************
+ * Function: Xbee_setSystemId()
+ * @param sysid: MAVLink system id the board is from now on,
+ *  MAVLINK_SYSTEM_BASE or a boat, MAVLINK_SYSTEM_BOAT and up
+ * @return SUCCESS, or FAILURE if it couldn't be kept in the flash store,
+ *  it's used until the next boot anyway
+ * @remark The radio's MY moves with it, right away in API mode, and
+ *  otherwise the next time the radio is configured.
+ * @date October 14th 2026
+ **********************************************************************/
+uint8_t Xbee_setSystemId(uint8_t sysid);
 
 /**********************************************************************
- * Function: void Xbee_message_data_test();
- * @remark This function will be calle once a "data_test" packet has been
- *  recieved. It will send the data back immediatly, and restart the time out
- *  timer.
- * @param The test_data struct from Mavlink
+ * Function: Xbee_setAggregation()
+ * @param window: (ms) a send waits at most this long for others to join
+ *  its packet, 0 sends each on its own, the default
+ * @return none
+ * @remark A packet goes as soon as the next send wouldn't fit in
+ *  XBEE_PAYLOAD_MAX, so a window only slows the first of a burst. API
+ *  mode only, transparent mode is packed by the radio.
+ * @date October 14th 2026
+ **********************************************************************/
+void Xbee_setAggregation(uint8_t window);
+
+/**********************************************************************
+ * Function: Xbee_flush()
+ * @return SUCCESS, or FAILURE if the UART had no room, it's tried again
+ *  from Xbee_runSM
+ * @remark Sends the packet being packed now, without waiting out the
+ *  window.
+ * @date October 14th 2026
+ **********************************************************************/
+uint8_t Xbee_flush();
+
+/**********************************************************************
+ * Function: Xbee_isReady()
+ * @return TRUE once the configuration is done, in either mode
+ * @date October 14th 2026
+ **********************************************************************/
+uint8_t Xbee_isReady();
+
+/**********************************************************************
+ * Function: Xbee_isApiMode()
+ * @return TRUE if the radio answered in API mode
+ * @date October 14th 2026
+ **********************************************************************/
+uint8_t Xbee_isApiMode();
+
+/**********************************************************************
+ * Function: Xbee_getStats()
+ * @param stats: set to the radio's counters
+ * @return none
+ * @remark Only counted in API mode.
+ * @date October 14th 2026
+ **********************************************************************/
+void Xbee_getStats(XbeeStats *stats);
+
+/**********************************************************************
+ * Function: Xbee_getLinkQuality()
+ * @param linkQuality: set to what the heartbeats measured of the peer
+ *  heard from last, all 0 before one
+ * @return none
+ * @remark Works in either mode, the heartbeats are MAVLink messages. A
+ *  boat only has the base, the base should ask for each boat.
+ * @date October 14th 2026
+ **********************************************************************/
+void Xbee_getLinkQuality(XbeeLinkQuality *linkQuality);
+
+/**********************************************************************
+ * Function: Xbee_getPeerLinkQuality()
+ * @param sysid: system id of the peer
+ * @param linkQuality: set to what its heartbeats measured
+ * @return SUCCESS, or FAILURE if no heartbeat of it is kept
+ * @date October 14th 2026
+ **********************************************************************/
+uint8_t Xbee_getPeerLinkQuality(uint8_t sysid, XbeeLinkQuality *linkQuality);
+
+
+
+/**********************************************************************
+ * Function: void Xbee_recieved_message_heartbeat();
+ * @remark This function will be called once a heartbeat has been
+ *  recieved. It keeps the connection alive and measures the link from
+ *  its sequence number and timestamps.
+ * @param System id it came from
+ * @param The xbee_heartbeat struct from Mavlink
  * @return none
  * @author John Ash
  * @date February 1st 2013
  **********************************************************************/
-void Xbee_recieved_message_heartbeat(mavlink_xbee_heartbeat_t* packet);
+void Xbee_recieved_message_heartbeat(uint8_t sysid, mavlink_xbee_heartbeat_t* packet);
 
 #ifdef XBEE_TEST
 /**********************************************************************
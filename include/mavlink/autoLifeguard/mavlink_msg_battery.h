@@ -0,0 +1,166 @@
+// MESSAGE BATTERY PACKING
+
+#define MAVLINK_MSG_ID_BATTERY 246
+
+typedef struct __mavlink_battery_t
+{
+ uint32_t time; ///< Time of the reading (ms)
+ uint16_t voltage; ///< Battery voltage (mV)
+} mavlink_battery_t;
+
+#define MAVLINK_MSG_ID_BATTERY_LEN 6
+#define MAVLINK_MSG_ID_246_LEN 6
+
+
+
+#define MAVLINK_MESSAGE_INFO_BATTERY { \
+	"BATTERY", \
+	2, \
+	{  { "time", NULL, MAVLINK_TYPE_UINT32_T, 0, 0, offsetof(mavlink_battery_t, time) }, \
+         { "voltage", NULL, MAVLINK_TYPE_UINT16_T, 0, 4, offsetof(mavlink_battery_t, voltage) }, \
+         } \
+}
+
+
+/**
+ * @brief Pack a battery message
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ *
+ * @param time Time of the reading (ms)
+ * @param voltage Battery voltage (mV)
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_battery_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
+						       uint32_t time, uint16_t voltage)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[6];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, voltage);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 6);
+#else
+	mavlink_battery_t packet;
+	packet.time = time;
+	packet.voltage = voltage;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 6);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_BATTERY;
+	return mavlink_finalize_message(msg, system_id, component_id, 6, 146);
+}
+
+/**
+ * @brief Pack a battery message on a channel
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param chan The MAVLink channel this message was sent over
+ * @param msg The MAVLink message to compress the data into
+ * @param time Time of the reading (ms)
+ * @param voltage Battery voltage (mV)
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_battery_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
+							   mavlink_message_t* msg,
+						           uint32_t time,uint16_t voltage)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[6];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, voltage);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 6);
+#else
+	mavlink_battery_t packet;
+	packet.time = time;
+	packet.voltage = voltage;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 6);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_BATTERY;
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 6, 146);
+}
+
+/**
+ * @brief Encode a battery struct into a message
+ *
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ * @param battery C-struct to read the message contents from
+ */
+static inline uint16_t mavlink_msg_battery_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_battery_t* battery)
+{
+	return mavlink_msg_battery_pack(system_id, component_id, msg, battery->time, battery->voltage);
+}
+
+/**
+ * @brief Send a battery message
+ * @param chan MAVLink channel to send the message
+ *
+ * @param time Time of the reading (ms)
+ * @param voltage Battery voltage (mV)
+ */
+#ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
+
+static inline void mavlink_msg_battery_send(mavlink_channel_t chan, uint32_t time, uint16_t voltage)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[6];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, voltage);
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_BATTERY, buf, 6, 146);
+#else
+	mavlink_battery_t packet;
+	packet.time = time;
+	packet.voltage = voltage;
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_BATTERY, (const char *)&packet, 6, 146);
+#endif
+}
+
+#endif
+
+// MESSAGE BATTERY UNPACKING
+
+
+/**
+ * @brief Get field time from battery message
+ *
+ * @return Time of the reading (ms)
+ */
+static inline uint32_t mavlink_msg_battery_get_time(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  0);
+}
+
+/**
+ * @brief Get field voltage from battery message
+ *
+ * @return Battery voltage (mV)
+ */
+static inline uint16_t mavlink_msg_battery_get_voltage(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  4);
+}
+
+/**
+ * @brief Decode a battery message into a struct
+ *
+ * @param msg The message to decode
+ * @param battery C-struct to decode the message contents into
+ */
+static inline void mavlink_msg_battery_decode(const mavlink_message_t* msg, mavlink_battery_t* battery)
+{
+#if MAVLINK_NEED_BYTE_SWAP
+	battery->time = mavlink_msg_battery_get_time(msg);
+	battery->voltage = mavlink_msg_battery_get_voltage(msg);
+#else
+	memcpy(battery, _MAV_PAYLOAD(msg), 6);
+#endif
+}
@@ -0,0 +1,298 @@
+// MESSAGE BOAT_POSITION PACKING
+
+#define MAVLINK_MSG_ID_BOAT_POSITION 245
+
+typedef struct __mavlink_boat_position_t
+{
+ uint32_t time; ///< Time of the fix (ms)
+ int32_t latitude; ///< Latitude (degrees scaled 1e7)
+ int32_t longitude; ///< Longitude (degrees scaled 1e7)
+ int16_t velocity_north; ///< Velocity north (cm/s)
+ int16_t velocity_east; ///< Velocity east (cm/s)
+ uint16_t heading; ///< Heading from north (centidegrees)
+ uint16_t accuracy; ///< Horizontal accuracy, one sigma (cm)
+ uint8_t guidance; ///< Guidance state, see GuidanceState
+} mavlink_boat_position_t;
+
+#define MAVLINK_MSG_ID_BOAT_POSITION_LEN 21
+#define MAVLINK_MSG_ID_245_LEN 21
+
+
+
+#define MAVLINK_MESSAGE_INFO_BOAT_POSITION { \
+	"BOAT_POSITION", \
+	8, \
+	{  { "time", NULL, MAVLINK_TYPE_UINT32_T, 0, 0, offsetof(mavlink_boat_position_t, time) }, \
+         { "latitude", NULL, MAVLINK_TYPE_INT32_T, 0, 4, offsetof(mavlink_boat_position_t, latitude) }, \
+         { "longitude", NULL, MAVLINK_TYPE_INT32_T, 0, 8, offsetof(mavlink_boat_position_t, longitude) }, \
+         { "velocity_north", NULL, MAVLINK_TYPE_INT16_T, 0, 12, offsetof(mavlink_boat_position_t, velocity_north) }, \
+         { "velocity_east", NULL, MAVLINK_TYPE_INT16_T, 0, 14, offsetof(mavlink_boat_position_t, velocity_east) }, \
+         { "heading", NULL, MAVLINK_TYPE_UINT16_T, 0, 16, offsetof(mavlink_boat_position_t, heading) }, \
+         { "accuracy", NULL, MAVLINK_TYPE_UINT16_T, 0, 18, offsetof(mavlink_boat_position_t, accuracy) }, \
+         { "guidance", NULL, MAVLINK_TYPE_UINT8_T, 0, 20, offsetof(mavlink_boat_position_t, guidance) }, \
+         } \
+}
+
+
+/**
+ * @brief Pack a boat_position message
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ *
+ * @param time Time of the fix (ms)
+ * @param latitude Latitude (degrees scaled 1e7)
+ * @param longitude Longitude (degrees scaled 1e7)
+ * @param velocity_north Velocity north (cm/s)
+ * @param velocity_east Velocity east (cm/s)
+ * @param heading Heading from north (centidegrees)
+ * @param accuracy Horizontal accuracy, one sigma (cm)
+ * @param guidance Guidance state, see GuidanceState
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_boat_position_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
+						       uint32_t time, int32_t latitude, int32_t longitude, int16_t velocity_north, int16_t velocity_east, uint16_t heading, uint16_t accuracy, uint8_t guidance)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[21];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_int32_t(buf, 4, latitude);
+	_mav_put_int32_t(buf, 8, longitude);
+	_mav_put_int16_t(buf, 12, velocity_north);
+	_mav_put_int16_t(buf, 14, velocity_east);
+	_mav_put_uint16_t(buf, 16, heading);
+	_mav_put_uint16_t(buf, 18, accuracy);
+	_mav_put_uint8_t(buf, 20, guidance);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 21);
+#else
+	mavlink_boat_position_t packet;
+	packet.time = time;
+	packet.latitude = latitude;
+	packet.longitude = longitude;
+	packet.velocity_north = velocity_north;
+	packet.velocity_east = velocity_east;
+	packet.heading = heading;
+	packet.accuracy = accuracy;
+	packet.guidance = guidance;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 21);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_BOAT_POSITION;
+	return mavlink_finalize_message(msg, system_id, component_id, 21, 102);
+}
+
+/**
+ * @brief Pack a boat_position message on a channel
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param chan The MAVLink channel this message was sent over
+ * @param msg The MAVLink message to compress the data into
+ * @param time Time of the fix (ms)
+ * @param latitude Latitude (degrees scaled 1e7)
+ * @param longitude Longitude (degrees scaled 1e7)
+ * @param velocity_north Velocity north (cm/s)
+ * @param velocity_east Velocity east (cm/s)
+ * @param heading Heading from north (centidegrees)
+ * @param accuracy Horizontal accuracy, one sigma (cm)
+ * @param guidance Guidance state, see GuidanceState
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_boat_position_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
+							   mavlink_message_t* msg,
+						           uint32_t time,int32_t latitude,int32_t longitude,int16_t velocity_north,int16_t velocity_east,uint16_t heading,uint16_t accuracy,uint8_t guidance)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[21];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_int32_t(buf, 4, latitude);
+	_mav_put_int32_t(buf, 8, longitude);
+	_mav_put_int16_t(buf, 12, velocity_north);
+	_mav_put_int16_t(buf, 14, velocity_east);
+	_mav_put_uint16_t(buf, 16, heading);
+	_mav_put_uint16_t(buf, 18, accuracy);
+	_mav_put_uint8_t(buf, 20, guidance);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 21);
+#else
+	mavlink_boat_position_t packet;
+	packet.time = time;
+	packet.latitude = latitude;
+	packet.longitude = longitude;
+	packet.velocity_north = velocity_north;
+	packet.velocity_east = velocity_east;
+	packet.heading = heading;
+	packet.accuracy = accuracy;
+	packet.guidance = guidance;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 21);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_BOAT_POSITION;
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 21, 102);
+}
+
+/**
+ * @brief Encode a boat_position struct into a message
+ *
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ * @param boat_position C-struct to read the message contents from
+ */
+static inline uint16_t mavlink_msg_boat_position_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_boat_position_t* boat_position)
+{
+	return mavlink_msg_boat_position_pack(system_id, component_id, msg, boat_position->time, boat_position->latitude, boat_position->longitude, boat_position->velocity_north, boat_position->velocity_east, boat_position->heading, boat_position->accuracy, boat_position->guidance);
+}
+
+/**
+ * @brief Send a boat_position message
+ * @param chan MAVLink channel to send the message
+ *
+ * @param time Time of the fix (ms)
+ * @param latitude Latitude (degrees scaled 1e7)
+ * @param longitude Longitude (degrees scaled 1e7)
+ * @param velocity_north Velocity north (cm/s)
+ * @param velocity_east Velocity east (cm/s)
+ * @param heading Heading from north (centidegrees)
+ * @param accuracy Horizontal accuracy, one sigma (cm)
+ * @param guidance Guidance state, see GuidanceState
+ */
+#ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
+
+static inline void mavlink_msg_boat_position_send(mavlink_channel_t chan, uint32_t time, int32_t latitude, int32_t longitude, int16_t velocity_north, int16_t velocity_east, uint16_t heading, uint16_t accuracy, uint8_t guidance)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[21];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_int32_t(buf, 4, latitude);
+	_mav_put_int32_t(buf, 8, longitude);
+	_mav_put_int16_t(buf, 12, velocity_north);
+	_mav_put_int16_t(buf, 14, velocity_east);
+	_mav_put_uint16_t(buf, 16, heading);
+	_mav_put_uint16_t(buf, 18, accuracy);
+	_mav_put_uint8_t(buf, 20, guidance);
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_BOAT_POSITION, buf, 21, 102);
+#else
+	mavlink_boat_position_t packet;
+	packet.time = time;
+	packet.latitude = latitude;
+	packet.longitude = longitude;
+	packet.velocity_north = velocity_north;
+	packet.velocity_east = velocity_east;
+	packet.heading = heading;
+	packet.accuracy = accuracy;
+	packet.guidance = guidance;
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_BOAT_POSITION, (const char *)&packet, 21, 102);
+#endif
+}
+
+#endif
+
+// MESSAGE BOAT_POSITION UNPACKING
+
+
+/**
+ * @brief Get field time from boat_position message
+ *
+ * @return Time of the fix (ms)
+ */
+static inline uint32_t mavlink_msg_boat_position_get_time(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  0);
+}
+
+/**
+ * @brief Get field latitude from boat_position message
+ *
+ * @return Latitude (degrees scaled 1e7)
+ */
+static inline int32_t mavlink_msg_boat_position_get_latitude(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_int32_t(msg,  4);
+}
+
+/**
+ * @brief Get field longitude from boat_position message
+ *
+ * @return Longitude (degrees scaled 1e7)
+ */
+static inline int32_t mavlink_msg_boat_position_get_longitude(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_int32_t(msg,  8);
+}
+
+/**
+ * @brief Get field velocity_north from boat_position message
+ *
+ * @return Velocity north (cm/s)
+ */
+static inline int16_t mavlink_msg_boat_position_get_velocity_north(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_int16_t(msg,  12);
+}
+
+/**
+ * @brief Get field velocity_east from boat_position message
+ *
+ * @return Velocity east (cm/s)
+ */
+static inline int16_t mavlink_msg_boat_position_get_velocity_east(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_int16_t(msg,  14);
+}
+
+/**
+ * @brief Get field heading from boat_position message
+ *
+ * @return Heading from north (centidegrees)
+ */
+static inline uint16_t mavlink_msg_boat_position_get_heading(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  16);
+}
+
+/**
+ * @brief Get field accuracy from boat_position message
+ *
+ * @return Horizontal accuracy, one sigma (cm)
+ */
+static inline uint16_t mavlink_msg_boat_position_get_accuracy(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  18);
+}
+
+/**
+ * @brief Get field guidance from boat_position message
+ *
+ * @return Guidance state, see GuidanceState
+ */
+static inline uint8_t mavlink_msg_boat_position_get_guidance(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  20);
+}
+
+/**
+ * @brief Decode a boat_position message into a struct
+ *
+ * @param msg The message to decode
+ * @param boat_position C-struct to decode the message contents into
+ */
+static inline void mavlink_msg_boat_position_decode(const mavlink_message_t* msg, mavlink_boat_position_t* boat_position)
+{
+#if MAVLINK_NEED_BYTE_SWAP
+	boat_position->time = mavlink_msg_boat_position_get_time(msg);
+	boat_position->latitude = mavlink_msg_boat_position_get_latitude(msg);
+	boat_position->longitude = mavlink_msg_boat_position_get_longitude(msg);
+	boat_position->velocity_north = mavlink_msg_boat_position_get_velocity_north(msg);
+	boat_position->velocity_east = mavlink_msg_boat_position_get_velocity_east(msg);
+	boat_position->heading = mavlink_msg_boat_position_get_heading(msg);
+	boat_position->accuracy = mavlink_msg_boat_position_get_accuracy(msg);
+	boat_position->guidance = mavlink_msg_boat_position_get_guidance(msg);
+#else
+	memcpy(boat_position, _MAV_PAYLOAD(msg), 21);
+#endif
+}
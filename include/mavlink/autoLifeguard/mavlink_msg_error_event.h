@@ -0,0 +1,232 @@
+// MESSAGE ERROR_EVENT PACKING
+
+#define MAVLINK_MSG_ID_ERROR_EVENT 250
+
+typedef struct __mavlink_error_event_t
+{
+ uint32_t time; ///< When it was logged (ms)
+ uint16_t arg; ///< Argument that goes with the code
+ uint16_t dropped; ///< Events lost to a full log since startup
+ uint8_t module; ///< Module it came from, ERROR_MODULE_*
+ uint8_t code; ///< Error code, ERROR_*
+} mavlink_error_event_t;
+
+#define MAVLINK_MSG_ID_ERROR_EVENT_LEN 10
+#define MAVLINK_MSG_ID_250_LEN 10
+
+
+
+#define MAVLINK_MESSAGE_INFO_ERROR_EVENT { \
+	"ERROR_EVENT", \
+	5, \
+	{  { "time", NULL, MAVLINK_TYPE_UINT32_T, 0, 0, offsetof(mavlink_error_event_t, time) }, \
+         { "arg", NULL, MAVLINK_TYPE_UINT16_T, 0, 4, offsetof(mavlink_error_event_t, arg) }, \
+         { "dropped", NULL, MAVLINK_TYPE_UINT16_T, 0, 6, offsetof(mavlink_error_event_t, dropped) }, \
+         { "module", NULL, MAVLINK_TYPE_UINT8_T, 0, 8, offsetof(mavlink_error_event_t, module) }, \
+         { "code", NULL, MAVLINK_TYPE_UINT8_T, 0, 9, offsetof(mavlink_error_event_t, code) }, \
+         } \
+}
+
+
+/**
+ * @brief Pack a error_event message
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ *
+ * @param time When it was logged (ms)
+ * @param module Module it came from, ERROR_MODULE_*
+ * @param code Error code, ERROR_*
+ * @param arg Argument that goes with the code
+ * @param dropped Events lost to a full log since startup
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_error_event_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
+						       uint32_t time, uint8_t module, uint8_t code, uint16_t arg, uint16_t dropped)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[10];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, arg);
+	_mav_put_uint16_t(buf, 6, dropped);
+	_mav_put_uint8_t(buf, 8, module);
+	_mav_put_uint8_t(buf, 9, code);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 10);
+#else
+	mavlink_error_event_t packet;
+	packet.time = time;
+	packet.arg = arg;
+	packet.dropped = dropped;
+	packet.module = module;
+	packet.code = code;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 10);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_ERROR_EVENT;
+	return mavlink_finalize_message(msg, system_id, component_id, 10, 49);
+}
+
+/**
+ * @brief Pack a error_event message on a channel
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param chan The MAVLink channel this message was sent over
+ * @param msg The MAVLink message to compress the data into
+ * @param time When it was logged (ms)
+ * @param module Module it came from, ERROR_MODULE_*
+ * @param code Error code, ERROR_*
+ * @param arg Argument that goes with the code
+ * @param dropped Events lost to a full log since startup
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_error_event_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
+							   mavlink_message_t* msg,
+						           uint32_t time,uint8_t module,uint8_t code,uint16_t arg,uint16_t dropped)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[10];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, arg);
+	_mav_put_uint16_t(buf, 6, dropped);
+	_mav_put_uint8_t(buf, 8, module);
+	_mav_put_uint8_t(buf, 9, code);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 10);
+#else
+	mavlink_error_event_t packet;
+	packet.time = time;
+	packet.arg = arg;
+	packet.dropped = dropped;
+	packet.module = module;
+	packet.code = code;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 10);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_ERROR_EVENT;
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 10, 49);
+}
+
+/**
+ * @brief Encode a error_event struct into a message
+ *
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ * @param error_event C-struct to read the message contents from
+ */
+static inline uint16_t mavlink_msg_error_event_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_error_event_t* error_event)
+{
+	return mavlink_msg_error_event_pack(system_id, component_id, msg, error_event->time, error_event->module, error_event->code, error_event->arg, error_event->dropped);
+}
+
+/**
+ * @brief Send a error_event message
+ * @param chan MAVLink channel to send the message
+ *
+ * @param time When it was logged (ms)
+ * @param module Module it came from, ERROR_MODULE_*
+ * @param code Error code, ERROR_*
+ * @param arg Argument that goes with the code
+ * @param dropped Events lost to a full log since startup
+ */
+#ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
+
+static inline void mavlink_msg_error_event_send(mavlink_channel_t chan, uint32_t time, uint8_t module, uint8_t code, uint16_t arg, uint16_t dropped)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[10];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, arg);
+	_mav_put_uint16_t(buf, 6, dropped);
+	_mav_put_uint8_t(buf, 8, module);
+	_mav_put_uint8_t(buf, 9, code);
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_ERROR_EVENT, buf, 10, 49);
+#else
+	mavlink_error_event_t packet;
+	packet.time = time;
+	packet.arg = arg;
+	packet.dropped = dropped;
+	packet.module = module;
+	packet.code = code;
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_ERROR_EVENT, (const char *)&packet, 10, 49);
+#endif
+}
+
+#endif
+
+// MESSAGE ERROR_EVENT UNPACKING
+
+
+/**
+ * @brief Get field time from error_event message
+ *
+ * @return When it was logged (ms)
+ */
+static inline uint32_t mavlink_msg_error_event_get_time(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  0);
+}
+
+/**
+ * @brief Get field module from error_event message
+ *
+ * @return Module it came from, ERROR_MODULE_*
+ */
+static inline uint8_t mavlink_msg_error_event_get_module(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  8);
+}
+
+/**
+ * @brief Get field code from error_event message
+ *
+ * @return Error code, ERROR_*
+ */
+static inline uint8_t mavlink_msg_error_event_get_code(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  9);
+}
+
+/**
+ * @brief Get field arg from error_event message
+ *
+ * @return Argument that goes with the code
+ */
+static inline uint16_t mavlink_msg_error_event_get_arg(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  4);
+}
+
+/**
+ * @brief Get field dropped from error_event message
+ *
+ * @return Events lost to a full log since startup
+ */
+static inline uint16_t mavlink_msg_error_event_get_dropped(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  6);
+}
+
+/**
+ * @brief Decode a error_event message into a struct
+ *
+ * @param msg The message to decode
+ * @param error_event C-struct to decode the message contents into
+ */
+static inline void mavlink_msg_error_event_decode(const mavlink_message_t* msg, mavlink_error_event_t* error_event)
+{
+#if MAVLINK_NEED_BYTE_SWAP
+	error_event->time = mavlink_msg_error_event_get_time(msg);
+	error_event->arg = mavlink_msg_error_event_get_arg(msg);
+	error_event->dropped = mavlink_msg_error_event_get_dropped(msg);
+	error_event->module = mavlink_msg_error_event_get_module(msg);
+	error_event->code = mavlink_msg_error_event_get_code(msg);
+#else
+	memcpy(error_event, _MAV_PAYLOAD(msg), 10);
+#endif
+}
@@ -4,20 +4,24 @@
 
 typedef struct __mavlink_gps_error_t
 {
+ uint32_t time; ///< GPS time of week of the base station fix (ms)
+ int32_t latitude; ///< Latitude error (degrees scaled 1e7)
+ int32_t longitude; ///< Longitude error (degrees scaled 1e7)
  uint8_t ack; ///<  TRUE if we want an ACK return FALSE else
- uint8_t data; ///< Holds a Message ID number
 } mavlink_gps_error_t;
 
-#define MAVLINK_MSG_ID_GPS_ERROR_LEN 2
-#define MAVLINK_MSG_ID_240_LEN 2
+#define MAVLINK_MSG_ID_GPS_ERROR_LEN 13
+#define MAVLINK_MSG_ID_240_LEN 13
 
 
 
 #define MAVLINK_MESSAGE_INFO_GPS_ERROR { \
 	"GPS_ERROR", \
-	2, \
-	{  { "ack", NULL, MAVLINK_TYPE_UINT8_T, 0, 0, offsetof(mavlink_gps_error_t, ack) }, \
-         { "data", NULL, MAVLINK_TYPE_UINT8_T, 0, 1, offsetof(mavlink_gps_error_t, data) }, \
+	4, \
+	{  { "time", NULL, MAVLINK_TYPE_UINT32_T, 0, 0, offsetof(mavlink_gps_error_t, time) }, \
+         { "latitude", NULL, MAVLINK_TYPE_INT32_T, 0, 4, offsetof(mavlink_gps_error_t, latitude) }, \
+         { "longitude", NULL, MAVLINK_TYPE_INT32_T, 0, 8, offsetof(mavlink_gps_error_t, longitude) }, \
+         { "ack", NULL, MAVLINK_TYPE_UINT8_T, 0, 12, offsetof(mavlink_gps_error_t, ack) }, \
          } \
 }
 
@@ -29,28 +33,34 @@ typedef struct __mavlink_gps_error_t
  * @param msg The MAVLink message to compress the data into
  *
  * @param ack  TRUE if we want an ACK return FALSE else
- * @param data Holds a Message ID number
+ * @param time GPS time of week of the base station fix (ms)
+ * @param latitude Latitude error (degrees scaled 1e7)
+ * @param longitude Longitude error (degrees scaled 1e7)
  * @return length of the message in bytes (excluding serial stream start sign)
  */
 static inline uint16_t mavlink_msg_gps_error_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
-						       uint8_t ack, uint8_t data)
+						       uint8_t ack, uint32_t time, int32_t latitude, int32_t longitude)
 {
 #if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
-	char buf[2];
-	_mav_put_uint8_t(buf, 0, ack);
-	_mav_put_uint8_t(buf, 1, data);
+	char buf[13];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_int32_t(buf, 4, latitude);
+	_mav_put_int32_t(buf, 8, longitude);
+	_mav_put_uint8_t(buf, 12, ack);
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 2);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 13);
 #else
 	mavlink_gps_error_t packet;
+	packet.time = time;
+	packet.latitude = latitude;
+	packet.longitude = longitude;
 	packet.ack = ack;
-	packet.data = data;
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 2);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 13);
 #endif
 
 	msg->msgid = MAVLINK_MSG_ID_GPS_ERROR;
-	return mavlink_finalize_message(msg, system_id, component_id, 2, 110);
+	return mavlink_finalize_message(msg, system_id, component_id, 13, 232);
 }
 
 /**
@@ -60,29 +70,35 @@ static inline uint16_t mavlink_msg_gps_error_pack(uint8_t system_id, uint8_t com
  * @param chan The MAVLink channel this message was sent over
  * @param msg The MAVLink message to compress the data into
  * @param ack  TRUE if we want an ACK return FALSE else
- * @param data Holds a Message ID number
+ * @param time GPS time of week of the base station fix (ms)
+ * @param latitude Latitude error (degrees scaled 1e7)
+ * @param longitude Longitude error (degrees scaled 1e7)
  * @return length of the message in bytes (excluding serial stream start sign)
  */
 static inline uint16_t mavlink_msg_gps_error_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
 							   mavlink_message_t* msg,
-						           uint8_t ack,uint8_t data)
+						           uint8_t ack,uint32_t time,int32_t latitude,int32_t longitude)
 {
 #if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
-	char buf[2];
-	_mav_put_uint8_t(buf, 0, ack);
-	_mav_put_uint8_t(buf, 1, data);
+	char buf[13];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_int32_t(buf, 4, latitude);
+	_mav_put_int32_t(buf, 8, longitude);
+	_mav_put_uint8_t(buf, 12, ack);
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 2);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 13);
 #else
 	mavlink_gps_error_t packet;
+	packet.time = time;
+	packet.latitude = latitude;
+	packet.longitude = longitude;
 	packet.ack = ack;
-	packet.data = data;
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 2);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 13);
 #endif
 
 	msg->msgid = MAVLINK_MSG_ID_GPS_ERROR;
-	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 2, 110);
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 13, 232);
 }
 
 /**
@@ -95,7 +111,7 @@ static inline uint16_t mavlink_msg_gps_error_pack_chan(uint8_t system_id, uint8_
  */
 static inline uint16_t mavlink_msg_gps_error_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_gps_error_t* gps_error)
 {
-	return mavlink_msg_gps_error_pack(system_id, component_id, msg, gps_error->ack, gps_error->data);
+	return mavlink_msg_gps_error_pack(system_id, component_id, msg, gps_error->ack, gps_error->time, gps_error->latitude, gps_error->longitude);
 }
 
 /**
@@ -103,24 +119,30 @@ static inline uint16_t mavlink_msg_gps_error_encode(uint8_t system_id, uint8_t c
  * @param chan MAVLink channel to send the message
  *
  * @param ack  TRUE if we want an ACK return FALSE else
- * @param data Holds a Message ID number
+ * @param time GPS time of week of the base station fix (ms)
+ * @param latitude Latitude error (degrees scaled 1e7)
+ * @param longitude Longitude error (degrees scaled 1e7)
  */
 #ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
 
-static inline void mavlink_msg_gps_error_send(mavlink_channel_t chan, uint8_t ack, uint8_t data)
+static inline void mavlink_msg_gps_error_send(mavlink_channel_t chan, uint8_t ack, uint32_t time, int32_t latitude, int32_t longitude)
 {
 #if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
-	char buf[2];
-	_mav_put_uint8_t(buf, 0, ack);
-	_mav_put_uint8_t(buf, 1, data);
+	char buf[13];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_int32_t(buf, 4, latitude);
+	_mav_put_int32_t(buf, 8, longitude);
+	_mav_put_uint8_t(buf, 12, ack);
 
-	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_GPS_ERROR, buf, 2, 110);
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_GPS_ERROR, buf, 13, 232);
 #else
 	mavlink_gps_error_t packet;
+	packet.time = time;
+	packet.latitude = latitude;
+	packet.longitude = longitude;
 	packet.ack = ack;
-	packet.data = data;
 
-	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_GPS_ERROR, (const char *)&packet, 2, 110);
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_GPS_ERROR, (const char *)&packet, 13, 232);
 #endif
 }
 
@@ -136,17 +158,37 @@ static inline void mavlink_msg_gps_error_send(mavlink_channel_t chan, uint8_t ac
  */
 static inline uint8_t mavlink_msg_gps_error_get_ack(const mavlink_message_t* msg)
 {
-	return _MAV_RETURN_uint8_t(msg,  0);
+	return _MAV_RETURN_uint8_t(msg,  12);
 }
 
 /**
- * @brief Get field data from gps_error message
+ * @brief Get field time from gps_error message
  *
- * @return Holds a Message ID number
+ * @return GPS time of week of the base station fix (ms)
  */
-static inline uint8_t mavlink_msg_gps_error_get_data(const mavlink_message_t* msg)
+static inline uint32_t mavlink_msg_gps_error_get_time(const mavlink_message_t* msg)
 {
-	return _MAV_RETURN_uint8_t(msg,  1);
+	return _MAV_RETURN_uint32_t(msg,  0);
+}
+
+/**
+ * @brief Get field latitude from gps_error message
+ *
+ * @return Latitude error (degrees scaled 1e7)
+ */
+static inline int32_t mavlink_msg_gps_error_get_latitude(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_int32_t(msg,  4);
+}
+
+/**
+ * @brief Get field longitude from gps_error message
+ *
+ * @return Longitude error (degrees scaled 1e7)
+ */
+static inline int32_t mavlink_msg_gps_error_get_longitude(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_int32_t(msg,  8);
 }
 
 /**
@@ -158,9 +200,11 @@ static inline uint8_t mavlink_msg_gps_error_get_data(const mavlink_message_t* ms
 static inline void mavlink_msg_gps_error_decode(const mavlink_message_t* msg, mavlink_gps_error_t* gps_error)
 {
 #if MAVLINK_NEED_BYTE_SWAP
+	gps_error->time = mavlink_msg_gps_error_get_time(msg);
+	gps_error->latitude = mavlink_msg_gps_error_get_latitude(msg);
+	gps_error->longitude = mavlink_msg_gps_error_get_longitude(msg);
 	gps_error->ack = mavlink_msg_gps_error_get_ack(msg);
-	gps_error->data = mavlink_msg_gps_error_get_data(msg);
 #else
-	memcpy(gps_error, _MAV_PAYLOAD(msg), 2);
+	memcpy(gps_error, _MAV_PAYLOAD(msg), 13);
 #endif
 }
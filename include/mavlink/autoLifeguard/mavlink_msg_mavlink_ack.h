@@ -5,17 +5,19 @@
 typedef struct __mavlink_mavlink_ack_t
 {
  uint8_t Message_Name; ///<  Returns the name of message recieved
+ uint8_t seq; ///< Sequence number of the message recieved, to match it to the one sent
 } mavlink_mavlink_ack_t;
 
-#define MAVLINK_MSG_ID_MAVLINK_ACK_LEN 1
-#define MAVLINK_MSG_ID_237_LEN 1
+#define MAVLINK_MSG_ID_MAVLINK_ACK_LEN 2
+#define MAVLINK_MSG_ID_237_LEN 2
 
 
 
 #define MAVLINK_MESSAGE_INFO_MAVLINK_ACK { \
 	"MAVLINK_ACK", \
-	1, \
+	2, \
 	{  { "Message_Name", NULL, MAVLINK_TYPE_UINT8_T, 0, 0, offsetof(mavlink_mavlink_ack_t, Message_Name) }, \
+         { "seq", NULL, MAVLINK_TYPE_UINT8_T, 0, 1, offsetof(mavlink_mavlink_ack_t, seq) }, \
          } \
 }
 
@@ -27,25 +29,28 @@ typedef struct __mavlink_mavlink_ack_t
  * @param msg The MAVLink message to compress the data into
  *
  * @param Message_Name  Returns the name of message recieved
+ * @param seq Sequence number of the message recieved, to match it to the one sent
  * @return length of the message in bytes (excluding serial stream start sign)
  */
 static inline uint16_t mavlink_msg_mavlink_ack_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
-						       uint8_t Message_Name)
+						       uint8_t Message_Name, uint8_t seq)
 {
 #if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
-	char buf[1];
+	char buf[2];
 	_mav_put_uint8_t(buf, 0, Message_Name);
+	_mav_put_uint8_t(buf, 1, seq);
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 1);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 2);
 #else
 	mavlink_mavlink_ack_t packet;
 	packet.Message_Name = Message_Name;
+	packet.seq = seq;
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 1);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 2);
 #endif
 
 	msg->msgid = MAVLINK_MSG_ID_MAVLINK_ACK;
-	return mavlink_finalize_message(msg, system_id, component_id, 1, 203);
+	return mavlink_finalize_message(msg, system_id, component_id, 2, 253);
 }
 
 /**
@@ -55,26 +60,29 @@ static inline uint16_t mavlink_msg_mavlink_ack_pack(uint8_t system_id, uint8_t c
  * @param chan The MAVLink channel this message was sent over
  * @param msg The MAVLink message to compress the data into
  * @param Message_Name  Returns the name of message recieved
+ * @param seq Sequence number of the message recieved, to match it to the one sent
  * @return length of the message in bytes (excluding serial stream start sign)
  */
 static inline uint16_t mavlink_msg_mavlink_ack_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
 							   mavlink_message_t* msg,
-						           uint8_t Message_Name)
+						           uint8_t Message_Name,uint8_t seq)
 {
 #if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
-	char buf[1];
+	char buf[2];
 	_mav_put_uint8_t(buf, 0, Message_Name);
+	_mav_put_uint8_t(buf, 1, seq);
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 1);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 2);
 #else
 	mavlink_mavlink_ack_t packet;
 	packet.Message_Name = Message_Name;
+	packet.seq = seq;
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 1);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 2);
 #endif
 
 	msg->msgid = MAVLINK_MSG_ID_MAVLINK_ACK;
-	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 1, 203);
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 2, 253);
 }
 
 /**
@@ -87,7 +95,7 @@ static inline uint16_t mavlink_msg_mavlink_ack_pack_chan(uint8_t system_id, uint
  */
 static inline uint16_t mavlink_msg_mavlink_ack_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_mavlink_ack_t* mavlink_ack)
 {
-	return mavlink_msg_mavlink_ack_pack(system_id, component_id, msg, mavlink_ack->Message_Name);
+	return mavlink_msg_mavlink_ack_pack(system_id, component_id, msg, mavlink_ack->Message_Name, mavlink_ack->seq);
 }
 
 /**
@@ -95,21 +103,24 @@ static inline uint16_t mavlink_msg_mavlink_ack_encode(uint8_t system_id, uint8_t
  * @param chan MAVLink channel to send the message
  *
  * @param Message_Name  Returns the name of message recieved
+ * @param seq Sequence number of the message recieved, to match it to the one sent
  */
 #ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
 
-static inline void mavlink_msg_mavlink_ack_send(mavlink_channel_t chan, uint8_t Message_Name)
+static inline void mavlink_msg_mavlink_ack_send(mavlink_channel_t chan, uint8_t Message_Name, uint8_t seq)
 {
 #if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
-	char buf[1];
+	char buf[2];
 	_mav_put_uint8_t(buf, 0, Message_Name);
+	_mav_put_uint8_t(buf, 1, seq);
 
-	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_MAVLINK_ACK, buf, 1, 203);
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_MAVLINK_ACK, buf, 2, 253);
 #else
 	mavlink_mavlink_ack_t packet;
 	packet.Message_Name = Message_Name;
+	packet.seq = seq;
 
-	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_MAVLINK_ACK, (const char *)&packet, 1, 203);
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_MAVLINK_ACK, (const char *)&packet, 2, 253);
 #endif
 }
 
@@ -128,6 +139,16 @@ static inline uint8_t mavlink_msg_mavlink_ack_get_Message_Name(const mavlink_mes
 	return _MAV_RETURN_uint8_t(msg,  0);
 }
 
+/**
+ * @brief Get field seq from mavlink_ack message
+ *
+ * @return Sequence number of the message recieved, to match it to the one sent
+ */
+static inline uint8_t mavlink_msg_mavlink_ack_get_seq(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  1);
+}
+
 /**
  * @brief Decode a mavlink_ack message into a struct
  *
@@ -138,7 +159,8 @@ static inline void mavlink_msg_mavlink_ack_decode(const mavlink_message_t* msg,
 {
 #if MAVLINK_NEED_BYTE_SWAP
 	mavlink_ack->Message_Name = mavlink_msg_mavlink_ack_get_Message_Name(msg);
+	mavlink_ack->seq = mavlink_msg_mavlink_ack_get_seq(msg);
 #else
-	memcpy(mavlink_ack, _MAV_PAYLOAD(msg), 1);
+	memcpy(mavlink_ack, _MAV_PAYLOAD(msg), 2);
 #endif
 }
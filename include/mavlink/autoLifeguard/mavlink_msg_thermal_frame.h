@@ -0,0 +1,277 @@
+// MESSAGE THERMAL_FRAME PACKING
+
+#define MAVLINK_MSG_ID_THERMAL_FRAME 244
+
+typedef struct __mavlink_thermal_frame_t
+{
+ uint32_t time; ///< Time the frame was taken at (ms)
+ uint16_t frame; ///< Frame number, counts up by one each frame sent
+ uint8_t flags; ///< Bit 0 set on a keyframe, which needs no earlier frame to rebuild
+ uint8_t chunk; ///< Index of this chunk in the frame, from 0
+ uint8_t chunks; ///< Chunks in the frame
+ uint8_t length; ///< Bytes of data used in this chunk
+ uint8_t data[80]; ///< Packed pixel data
+} mavlink_thermal_frame_t;
+
+#define MAVLINK_MSG_ID_THERMAL_FRAME_LEN 90
+#define MAVLINK_MSG_ID_244_LEN 90
+
+#define MAVLINK_MSG_THERMAL_FRAME_FIELD_DATA_LEN 80
+
+
+#define MAVLINK_MESSAGE_INFO_THERMAL_FRAME { \
+	"THERMAL_FRAME", \
+	7, \
+	{  { "time", NULL, MAVLINK_TYPE_UINT32_T, 0, 0, offsetof(mavlink_thermal_frame_t, time) }, \
+         { "frame", NULL, MAVLINK_TYPE_UINT16_T, 0, 4, offsetof(mavlink_thermal_frame_t, frame) }, \
+         { "flags", NULL, MAVLINK_TYPE_UINT8_T, 0, 6, offsetof(mavlink_thermal_frame_t, flags) }, \
+         { "chunk", NULL, MAVLINK_TYPE_UINT8_T, 0, 7, offsetof(mavlink_thermal_frame_t, chunk) }, \
+         { "chunks", NULL, MAVLINK_TYPE_UINT8_T, 0, 8, offsetof(mavlink_thermal_frame_t, chunks) }, \
+         { "length", NULL, MAVLINK_TYPE_UINT8_T, 0, 9, offsetof(mavlink_thermal_frame_t, length) }, \
+         { "data", NULL, MAVLINK_TYPE_UINT8_T, 80, 10, offsetof(mavlink_thermal_frame_t, data) }, \
+         } \
+}
+
+
+/**
+ * @brief Pack a thermal_frame message
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ *
+ * @param time Time the frame was taken at (ms)
+ * @param frame Frame number, counts up by one each frame sent
+ * @param flags Bit 0 set on a keyframe, which needs no earlier frame to rebuild
+ * @param chunk Index of this chunk in the frame, from 0
+ * @param chunks Chunks in the frame
+ * @param length Bytes of data used in this chunk
+ * @param data Packed pixel data
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_thermal_frame_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
+						       uint32_t time, uint16_t frame, uint8_t flags, uint8_t chunk, uint8_t chunks, uint8_t length, const uint8_t *data)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[90];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, frame);
+	_mav_put_uint8_t(buf, 6, flags);
+	_mav_put_uint8_t(buf, 7, chunk);
+	_mav_put_uint8_t(buf, 8, chunks);
+	_mav_put_uint8_t(buf, 9, length);
+	_mav_put_uint8_t_array(buf, 10, data, 80);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 90);
+#else
+	mavlink_thermal_frame_t packet;
+	packet.time = time;
+	packet.frame = frame;
+	packet.flags = flags;
+	packet.chunk = chunk;
+	packet.chunks = chunks;
+	packet.length = length;
+	mav_array_memcpy(packet.data, data, sizeof(uint8_t)*80);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 90);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_THERMAL_FRAME;
+	return mavlink_finalize_message(msg, system_id, component_id, 90, 156);
+}
+
+/**
+ * @brief Pack a thermal_frame message on a channel
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param chan The MAVLink channel this message was sent over
+ * @param msg The MAVLink message to compress the data into
+ * @param time Time the frame was taken at (ms)
+ * @param frame Frame number, counts up by one each frame sent
+ * @param flags Bit 0 set on a keyframe, which needs no earlier frame to rebuild
+ * @param chunk Index of this chunk in the frame, from 0
+ * @param chunks Chunks in the frame
+ * @param length Bytes of data used in this chunk
+ * @param data Packed pixel data
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_thermal_frame_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
+							   mavlink_message_t* msg,
+						           uint32_t time,uint16_t frame,uint8_t flags,uint8_t chunk,uint8_t chunks,uint8_t length,const uint8_t *data)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[90];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, frame);
+	_mav_put_uint8_t(buf, 6, flags);
+	_mav_put_uint8_t(buf, 7, chunk);
+	_mav_put_uint8_t(buf, 8, chunks);
+	_mav_put_uint8_t(buf, 9, length);
+	_mav_put_uint8_t_array(buf, 10, data, 80);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 90);
+#else
+	mavlink_thermal_frame_t packet;
+	packet.time = time;
+	packet.frame = frame;
+	packet.flags = flags;
+	packet.chunk = chunk;
+	packet.chunks = chunks;
+	packet.length = length;
+	mav_array_memcpy(packet.data, data, sizeof(uint8_t)*80);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 90);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_THERMAL_FRAME;
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 90, 156);
+}
+
+/**
+ * @brief Encode a thermal_frame struct into a message
+ *
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ * @param thermal_frame C-struct to read the message contents from
+ */
+static inline uint16_t mavlink_msg_thermal_frame_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_thermal_frame_t* thermal_frame)
+{
+	return mavlink_msg_thermal_frame_pack(system_id, component_id, msg, thermal_frame->time, thermal_frame->frame, thermal_frame->flags, thermal_frame->chunk, thermal_frame->chunks, thermal_frame->length, thermal_frame->data);
+}
+
+/**
+ * @brief Send a thermal_frame message
+ * @param chan MAVLink channel to send the message
+ *
+ * @param time Time the frame was taken at (ms)
+ * @param frame Frame number, counts up by one each frame sent
+ * @param flags Bit 0 set on a keyframe, which needs no earlier frame to rebuild
+ * @param chunk Index of this chunk in the frame, from 0
+ * @param chunks Chunks in the frame
+ * @param length Bytes of data used in this chunk
+ * @param data Packed pixel data
+ */
+#ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
+
+static inline void mavlink_msg_thermal_frame_send(mavlink_channel_t chan, uint32_t time, uint16_t frame, uint8_t flags, uint8_t chunk, uint8_t chunks, uint8_t length, const uint8_t *data)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[90];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, frame);
+	_mav_put_uint8_t(buf, 6, flags);
+	_mav_put_uint8_t(buf, 7, chunk);
+	_mav_put_uint8_t(buf, 8, chunks);
+	_mav_put_uint8_t(buf, 9, length);
+	_mav_put_uint8_t_array(buf, 10, data, 80);
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_THERMAL_FRAME, buf, 90, 156);
+#else
+	mavlink_thermal_frame_t packet;
+	packet.time = time;
+	packet.frame = frame;
+	packet.flags = flags;
+	packet.chunk = chunk;
+	packet.chunks = chunks;
+	packet.length = length;
+	mav_array_memcpy(packet.data, data, sizeof(uint8_t)*80);
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_THERMAL_FRAME, (const char *)&packet, 90, 156);
+#endif
+}
+
+#endif
+
+// MESSAGE THERMAL_FRAME UNPACKING
+
+
+/**
+ * @brief Get field time from thermal_frame message
+ *
+ * @return Time the frame was taken at (ms)
+ */
+static inline uint32_t mavlink_msg_thermal_frame_get_time(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  0);
+}
+
+/**
+ * @brief Get field frame from thermal_frame message
+ *
+ * @return Frame number, counts up by one each frame sent
+ */
+static inline uint16_t mavlink_msg_thermal_frame_get_frame(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  4);
+}
+
+/**
+ * @brief Get field flags from thermal_frame message
+ *
+ * @return Bit 0 set on a keyframe, which needs no earlier frame to rebuild
+ */
+static inline uint8_t mavlink_msg_thermal_frame_get_flags(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  6);
+}
+
+/**
+ * @brief Get field chunk from thermal_frame message
+ *
+ * @return Index of this chunk in the frame, from 0
+ */
+static inline uint8_t mavlink_msg_thermal_frame_get_chunk(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  7);
+}
+
+/**
+ * @brief Get field chunks from thermal_frame message
+ *
+ * @return Chunks in the frame
+ */
+static inline uint8_t mavlink_msg_thermal_frame_get_chunks(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  8);
+}
+
+/**
+ * @brief Get field length from thermal_frame message
+ *
+ * @return Bytes of data used in this chunk
+ */
+static inline uint8_t mavlink_msg_thermal_frame_get_length(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  9);
+}
+
+/**
+ * @brief Get field data from thermal_frame message
+ *
+ * @return Packed pixel data
+ */
+static inline uint16_t mavlink_msg_thermal_frame_get_data(const mavlink_message_t* msg, uint8_t *data)
+{
+	return _MAV_RETURN_uint8_t_array(msg, data, 80,  10);
+}
+
+/**
+ * @brief Decode a thermal_frame message into a struct
+ *
+ * @param msg The message to decode
+ * @param thermal_frame C-struct to decode the message contents into
+ */
+static inline void mavlink_msg_thermal_frame_decode(const mavlink_message_t* msg, mavlink_thermal_frame_t* thermal_frame)
+{
+#if MAVLINK_NEED_BYTE_SWAP
+	thermal_frame->time = mavlink_msg_thermal_frame_get_time(msg);
+	thermal_frame->frame = mavlink_msg_thermal_frame_get_frame(msg);
+	thermal_frame->flags = mavlink_msg_thermal_frame_get_flags(msg);
+	thermal_frame->chunk = mavlink_msg_thermal_frame_get_chunk(msg);
+	thermal_frame->chunks = mavlink_msg_thermal_frame_get_chunks(msg);
+	thermal_frame->length = mavlink_msg_thermal_frame_get_length(msg);
+	mavlink_msg_thermal_frame_get_data(msg, thermal_frame->data);
+#else
+	memcpy(thermal_frame, _MAV_PAYLOAD(msg), 90);
+#endif
+}
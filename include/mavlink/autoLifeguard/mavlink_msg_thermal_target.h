@@ -0,0 +1,232 @@
+// MESSAGE THERMAL_TARGET PACKING
+
+#define MAVLINK_MSG_ID_THERMAL_TARGET 247
+
+typedef struct __mavlink_thermal_target_t
+{
+ uint32_t time; ///< Time the frame was taken at (ms)
+ uint16_t heading; ///< Heading of the blob from north (centidegrees)
+ int16_t elevation; ///< Elevation above the middle of the array (centidegrees)
+ int16_t peak; ///< Warmest pixel above its background (centidegrees F)
+ uint8_t pixels; ///< Pixels in the blob, 0 if there is none
+} mavlink_thermal_target_t;
+
+#define MAVLINK_MSG_ID_THERMAL_TARGET_LEN 11
+#define MAVLINK_MSG_ID_247_LEN 11
+
+
+
+#define MAVLINK_MESSAGE_INFO_THERMAL_TARGET { \
+	"THERMAL_TARGET", \
+	5, \
+	{  { "time", NULL, MAVLINK_TYPE_UINT32_T, 0, 0, offsetof(mavlink_thermal_target_t, time) }, \
+         { "heading", NULL, MAVLINK_TYPE_UINT16_T, 0, 4, offsetof(mavlink_thermal_target_t, heading) }, \
+         { "elevation", NULL, MAVLINK_TYPE_INT16_T, 0, 6, offsetof(mavlink_thermal_target_t, elevation) }, \
+         { "peak", NULL, MAVLINK_TYPE_INT16_T, 0, 8, offsetof(mavlink_thermal_target_t, peak) }, \
+         { "pixels", NULL, MAVLINK_TYPE_UINT8_T, 0, 10, offsetof(mavlink_thermal_target_t, pixels) }, \
+         } \
+}
+
+
+/**
+ * @brief Pack a thermal_target message
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ *
+ * @param time Time the frame was taken at (ms)
+ * @param heading Heading of the blob from north (centidegrees)
+ * @param elevation Elevation above the middle of the array (centidegrees)
+ * @param peak Warmest pixel above its background (centidegrees F)
+ * @param pixels Pixels in the blob, 0 if there is none
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_thermal_target_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
+						       uint32_t time, uint16_t heading, int16_t elevation, int16_t peak, uint8_t pixels)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[11];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, heading);
+	_mav_put_int16_t(buf, 6, elevation);
+	_mav_put_int16_t(buf, 8, peak);
+	_mav_put_uint8_t(buf, 10, pixels);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 11);
+#else
+	mavlink_thermal_target_t packet;
+	packet.time = time;
+	packet.heading = heading;
+	packet.elevation = elevation;
+	packet.peak = peak;
+	packet.pixels = pixels;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 11);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_THERMAL_TARGET;
+	return mavlink_finalize_message(msg, system_id, component_id, 11, 39);
+}
+
+/**
+ * @brief Pack a thermal_target message on a channel
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param chan The MAVLink channel this message was sent over
+ * @param msg The MAVLink message to compress the data into
+ * @param time Time the frame was taken at (ms)
+ * @param heading Heading of the blob from north (centidegrees)
+ * @param elevation Elevation above the middle of the array (centidegrees)
+ * @param peak Warmest pixel above its background (centidegrees F)
+ * @param pixels Pixels in the blob, 0 if there is none
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_thermal_target_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
+							   mavlink_message_t* msg,
+						           uint32_t time,uint16_t heading,int16_t elevation,int16_t peak,uint8_t pixels)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[11];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, heading);
+	_mav_put_int16_t(buf, 6, elevation);
+	_mav_put_int16_t(buf, 8, peak);
+	_mav_put_uint8_t(buf, 10, pixels);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 11);
+#else
+	mavlink_thermal_target_t packet;
+	packet.time = time;
+	packet.heading = heading;
+	packet.elevation = elevation;
+	packet.peak = peak;
+	packet.pixels = pixels;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 11);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_THERMAL_TARGET;
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 11, 39);
+}
+
+/**
+ * @brief Encode a thermal_target struct into a message
+ *
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ * @param thermal_target C-struct to read the message contents from
+ */
+static inline uint16_t mavlink_msg_thermal_target_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_thermal_target_t* thermal_target)
+{
+	return mavlink_msg_thermal_target_pack(system_id, component_id, msg, thermal_target->time, thermal_target->heading, thermal_target->elevation, thermal_target->peak, thermal_target->pixels);
+}
+
+/**
+ * @brief Send a thermal_target message
+ * @param chan MAVLink channel to send the message
+ *
+ * @param time Time the frame was taken at (ms)
+ * @param heading Heading of the blob from north (centidegrees)
+ * @param elevation Elevation above the middle of the array (centidegrees)
+ * @param peak Warmest pixel above its background (centidegrees F)
+ * @param pixels Pixels in the blob, 0 if there is none
+ */
+#ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
+
+static inline void mavlink_msg_thermal_target_send(mavlink_channel_t chan, uint32_t time, uint16_t heading, int16_t elevation, int16_t peak, uint8_t pixels)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[11];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint16_t(buf, 4, heading);
+	_mav_put_int16_t(buf, 6, elevation);
+	_mav_put_int16_t(buf, 8, peak);
+	_mav_put_uint8_t(buf, 10, pixels);
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_THERMAL_TARGET, buf, 11, 39);
+#else
+	mavlink_thermal_target_t packet;
+	packet.time = time;
+	packet.heading = heading;
+	packet.elevation = elevation;
+	packet.peak = peak;
+	packet.pixels = pixels;
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_THERMAL_TARGET, (const char *)&packet, 11, 39);
+#endif
+}
+
+#endif
+
+// MESSAGE THERMAL_TARGET UNPACKING
+
+
+/**
+ * @brief Get field time from thermal_target message
+ *
+ * @return Time the frame was taken at (ms)
+ */
+static inline uint32_t mavlink_msg_thermal_target_get_time(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  0);
+}
+
+/**
+ * @brief Get field heading from thermal_target message
+ *
+ * @return Heading of the blob from north (centidegrees)
+ */
+static inline uint16_t mavlink_msg_thermal_target_get_heading(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  4);
+}
+
+/**
+ * @brief Get field elevation from thermal_target message
+ *
+ * @return Elevation above the middle of the array (centidegrees)
+ */
+static inline int16_t mavlink_msg_thermal_target_get_elevation(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_int16_t(msg,  6);
+}
+
+/**
+ * @brief Get field peak from thermal_target message
+ *
+ * @return Warmest pixel above its background (centidegrees F)
+ */
+static inline int16_t mavlink_msg_thermal_target_get_peak(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_int16_t(msg,  8);
+}
+
+/**
+ * @brief Get field pixels from thermal_target message
+ *
+ * @return Pixels in the blob, 0 if there is none
+ */
+static inline uint8_t mavlink_msg_thermal_target_get_pixels(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  10);
+}
+
+/**
+ * @brief Decode a thermal_target message into a struct
+ *
+ * @param msg The message to decode
+ * @param thermal_target C-struct to decode the message contents into
+ */
+static inline void mavlink_msg_thermal_target_decode(const mavlink_message_t* msg, mavlink_thermal_target_t* thermal_target)
+{
+#if MAVLINK_NEED_BYTE_SWAP
+	thermal_target->time = mavlink_msg_thermal_target_get_time(msg);
+	thermal_target->heading = mavlink_msg_thermal_target_get_heading(msg);
+	thermal_target->elevation = mavlink_msg_thermal_target_get_elevation(msg);
+	thermal_target->peak = mavlink_msg_thermal_target_get_peak(msg);
+	thermal_target->pixels = mavlink_msg_thermal_target_get_pixels(msg);
+#else
+	memcpy(thermal_target, _MAV_PAYLOAD(msg), 11);
+#endif
+}
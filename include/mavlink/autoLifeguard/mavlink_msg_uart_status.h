@@ -0,0 +1,320 @@
+// MESSAGE UART_STATUS PACKING
+
+#define MAVLINK_MSG_ID_UART_STATUS 243
+
+typedef struct __mavlink_uart_status_t
+{
+ uint32_t rx_bytes; ///< Bytes received into the ring
+ uint32_t tx_bytes; ///< Bytes accepted for transmit
+ uint32_t rx_dropped; ///< Received bytes lost to a full ring
+ uint32_t tx_dropped; ///< Bytes the transmit ring had no room for
+ uint16_t rx_overruns; ///< Hardware receive FIFO overruns
+ uint16_t rx_peak; ///< Most bytes ever waiting in the receive ring
+ uint16_t tx_peak; ///< Most bytes ever waiting in the transmit ring
+ uint16_t isr_max_ticks; ///< Longest UART interrupt in core timer ticks (SYSCLK/2)
+ uint8_t uart_id; ///< UART the counters belong to
+} mavlink_uart_status_t;
+
+#define MAVLINK_MSG_ID_UART_STATUS_LEN 25
+#define MAVLINK_MSG_ID_243_LEN 25
+
+
+
+#define MAVLINK_MESSAGE_INFO_UART_STATUS { \
+	"UART_STATUS", \
+	9, \
+	{  { "rx_bytes", NULL, MAVLINK_TYPE_UINT32_T, 0, 0, offsetof(mavlink_uart_status_t, rx_bytes) }, \
+         { "tx_bytes", NULL, MAVLINK_TYPE_UINT32_T, 0, 4, offsetof(mavlink_uart_status_t, tx_bytes) }, \
+         { "rx_dropped", NULL, MAVLINK_TYPE_UINT32_T, 0, 8, offsetof(mavlink_uart_status_t, rx_dropped) }, \
+         { "tx_dropped", NULL, MAVLINK_TYPE_UINT32_T, 0, 12, offsetof(mavlink_uart_status_t, tx_dropped) }, \
+         { "rx_overruns", NULL, MAVLINK_TYPE_UINT16_T, 0, 16, offsetof(mavlink_uart_status_t, rx_overruns) }, \
+         { "rx_peak", NULL, MAVLINK_TYPE_UINT16_T, 0, 18, offsetof(mavlink_uart_status_t, rx_peak) }, \
+         { "tx_peak", NULL, MAVLINK_TYPE_UINT16_T, 0, 20, offsetof(mavlink_uart_status_t, tx_peak) }, \
+         { "isr_max_ticks", NULL, MAVLINK_TYPE_UINT16_T, 0, 22, offsetof(mavlink_uart_status_t, isr_max_ticks) }, \
+         { "uart_id", NULL, MAVLINK_TYPE_UINT8_T, 0, 24, offsetof(mavlink_uart_status_t, uart_id) }, \
+         } \
+}
+
+
+/**
+ * @brief Pack a uart_status message
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ *
+ * @param uart_id UART the counters belong to
+ * @param rx_bytes Bytes received into the ring
+ * @param tx_bytes Bytes accepted for transmit
+ * @param rx_dropped Received bytes lost to a full ring
+ * @param tx_dropped Bytes the transmit ring had no room for
+ * @param rx_overruns Hardware receive FIFO overruns
+ * @param rx_peak Most bytes ever waiting in the receive ring
+ * @param tx_peak Most bytes ever waiting in the transmit ring
+ * @param isr_max_ticks Longest UART interrupt in core timer ticks (SYSCLK/2)
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_uart_status_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
+						       uint8_t uart_id, uint32_t rx_bytes, uint32_t tx_bytes, uint32_t rx_dropped, uint32_t tx_dropped, uint16_t rx_overruns, uint16_t rx_peak, uint16_t tx_peak, uint16_t isr_max_ticks)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[25];
+	_mav_put_uint32_t(buf, 0, rx_bytes);
+	_mav_put_uint32_t(buf, 4, tx_bytes);
+	_mav_put_uint32_t(buf, 8, rx_dropped);
+	_mav_put_uint32_t(buf, 12, tx_dropped);
+	_mav_put_uint16_t(buf, 16, rx_overruns);
+	_mav_put_uint16_t(buf, 18, rx_peak);
+	_mav_put_uint16_t(buf, 20, tx_peak);
+	_mav_put_uint16_t(buf, 22, isr_max_ticks);
+	_mav_put_uint8_t(buf, 24, uart_id);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 25);
+#else
+	mavlink_uart_status_t packet;
+	packet.rx_bytes = rx_bytes;
+	packet.tx_bytes = tx_bytes;
+	packet.rx_dropped = rx_dropped;
+	packet.tx_dropped = tx_dropped;
+	packet.rx_overruns = rx_overruns;
+	packet.rx_peak = rx_peak;
+	packet.tx_peak = tx_peak;
+	packet.isr_max_ticks = isr_max_ticks;
+	packet.uart_id = uart_id;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 25);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_UART_STATUS;
+	return mavlink_finalize_message(msg, system_id, component_id, 25, 36);
+}
+
+/**
+ * @brief Pack a uart_status message on a channel
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param chan The MAVLink channel this message was sent over
+ * @param msg The MAVLink message to compress the data into
+ * @param uart_id UART the counters belong to
+ * @param rx_bytes Bytes received into the ring
+ * @param tx_bytes Bytes accepted for transmit
+ * @param rx_dropped Received bytes lost to a full ring
+ * @param tx_dropped Bytes the transmit ring had no room for
+ * @param rx_overruns Hardware receive FIFO overruns
+ * @param rx_peak Most bytes ever waiting in the receive ring
+ * @param tx_peak Most bytes ever waiting in the transmit ring
+ * @param isr_max_ticks Longest UART interrupt in core timer ticks (SYSCLK/2)
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_uart_status_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
+							   mavlink_message_t* msg,
+						           uint8_t uart_id,uint32_t rx_bytes,uint32_t tx_bytes,uint32_t rx_dropped,uint32_t tx_dropped,uint16_t rx_overruns,uint16_t rx_peak,uint16_t tx_peak,uint16_t isr_max_ticks)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[25];
+	_mav_put_uint32_t(buf, 0, rx_bytes);
+	_mav_put_uint32_t(buf, 4, tx_bytes);
+	_mav_put_uint32_t(buf, 8, rx_dropped);
+	_mav_put_uint32_t(buf, 12, tx_dropped);
+	_mav_put_uint16_t(buf, 16, rx_overruns);
+	_mav_put_uint16_t(buf, 18, rx_peak);
+	_mav_put_uint16_t(buf, 20, tx_peak);
+	_mav_put_uint16_t(buf, 22, isr_max_ticks);
+	_mav_put_uint8_t(buf, 24, uart_id);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 25);
+#else
+	mavlink_uart_status_t packet;
+	packet.rx_bytes = rx_bytes;
+	packet.tx_bytes = tx_bytes;
+	packet.rx_dropped = rx_dropped;
+	packet.tx_dropped = tx_dropped;
+	packet.rx_overruns = rx_overruns;
+	packet.rx_peak = rx_peak;
+	packet.tx_peak = tx_peak;
+	packet.isr_max_ticks = isr_max_ticks;
+	packet.uart_id = uart_id;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 25);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_UART_STATUS;
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 25, 36);
+}
+
+/**
+ * @brief Encode a uart_status struct into a message
+ *
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ * @param uart_status C-struct to read the message contents from
+ */
+static inline uint16_t mavlink_msg_uart_status_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_uart_status_t* uart_status)
+{
+	return mavlink_msg_uart_status_pack(system_id, component_id, msg, uart_status->uart_id, uart_status->rx_bytes, uart_status->tx_bytes, uart_status->rx_dropped, uart_status->tx_dropped, uart_status->rx_overruns, uart_status->rx_peak, uart_status->tx_peak, uart_status->isr_max_ticks);
+}
+
+/**
+ * @brief Send a uart_status message
+ * @param chan MAVLink channel to send the message
+ *
+ * @param uart_id UART the counters belong to
+ * @param rx_bytes Bytes received into the ring
+ * @param tx_bytes Bytes accepted for transmit
+ * @param rx_dropped Received bytes lost to a full ring
+ * @param tx_dropped Bytes the transmit ring had no room for
+ * @param rx_overruns Hardware receive FIFO overruns
+ * @param rx_peak Most bytes ever waiting in the receive ring
+ * @param tx_peak Most bytes ever waiting in the transmit ring
+ * @param isr_max_ticks Longest UART interrupt in core timer ticks (SYSCLK/2)
+ */
+#ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
+
+static inline void mavlink_msg_uart_status_send(mavlink_channel_t chan, uint8_t uart_id, uint32_t rx_bytes, uint32_t tx_bytes, uint32_t rx_dropped, uint32_t tx_dropped, uint16_t rx_overruns, uint16_t rx_peak, uint16_t tx_peak, uint16_t isr_max_ticks)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[25];
+	_mav_put_uint32_t(buf, 0, rx_bytes);
+	_mav_put_uint32_t(buf, 4, tx_bytes);
+	_mav_put_uint32_t(buf, 8, rx_dropped);
+	_mav_put_uint32_t(buf, 12, tx_dropped);
+	_mav_put_uint16_t(buf, 16, rx_overruns);
+	_mav_put_uint16_t(buf, 18, rx_peak);
+	_mav_put_uint16_t(buf, 20, tx_peak);
+	_mav_put_uint16_t(buf, 22, isr_max_ticks);
+	_mav_put_uint8_t(buf, 24, uart_id);
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_UART_STATUS, buf, 25, 36);
+#else
+	mavlink_uart_status_t packet;
+	packet.rx_bytes = rx_bytes;
+	packet.tx_bytes = tx_bytes;
+	packet.rx_dropped = rx_dropped;
+	packet.tx_dropped = tx_dropped;
+	packet.rx_overruns = rx_overruns;
+	packet.rx_peak = rx_peak;
+	packet.tx_peak = tx_peak;
+	packet.isr_max_ticks = isr_max_ticks;
+	packet.uart_id = uart_id;
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_UART_STATUS, (const char *)&packet, 25, 36);
+#endif
+}
+
+#endif
+
+// MESSAGE UART_STATUS UNPACKING
+
+
+/**
+ * @brief Get field uart_id from uart_status message
+ *
+ * @return UART the counters belong to
+ */
+static inline uint8_t mavlink_msg_uart_status_get_uart_id(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  24);
+}
+
+/**
+ * @brief Get field rx_bytes from uart_status message
+ *
+ * @return Bytes received into the ring
+ */
+static inline uint32_t mavlink_msg_uart_status_get_rx_bytes(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  0);
+}
+
+/**
+ * @brief Get field tx_bytes from uart_status message
+ *
+ * @return Bytes accepted for transmit
+ */
+static inline uint32_t mavlink_msg_uart_status_get_tx_bytes(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  4);
+}
+
+/**
+ * @brief Get field rx_dropped from uart_status message
+ *
+ * @return Received bytes lost to a full ring
+ */
+static inline uint32_t mavlink_msg_uart_status_get_rx_dropped(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  8);
+}
+
+/**
+ * @brief Get field tx_dropped from uart_status message
+ *
+ * @return Bytes the transmit ring had no room for
+ */
+static inline uint32_t mavlink_msg_uart_status_get_tx_dropped(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  12);
+}
+
+/**
+ * @brief Get field rx_overruns from uart_status message
+ *
+ * @return Hardware receive FIFO overruns
+ */
+static inline uint16_t mavlink_msg_uart_status_get_rx_overruns(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  16);
+}
+
+/**
+ * @brief Get field rx_peak from uart_status message
+ *
+ * @return Most bytes ever waiting in the receive ring
+ */
+static inline uint16_t mavlink_msg_uart_status_get_rx_peak(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  18);
+}
+
+/**
+ * @brief Get field tx_peak from uart_status message
+ *
+ * @return Most bytes ever waiting in the transmit ring
+ */
+static inline uint16_t mavlink_msg_uart_status_get_tx_peak(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  20);
+}
+
+/**
+ * @brief Get field isr_max_ticks from uart_status message
+ *
+ * @return Longest UART interrupt in core timer ticks (SYSCLK/2)
+ */
+static inline uint16_t mavlink_msg_uart_status_get_isr_max_ticks(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  22);
+}
+
+/**
+ * @brief Decode a uart_status message into a struct
+ *
+ * @param msg The message to decode
+ * @param uart_status C-struct to decode the message contents into
+ */
+static inline void mavlink_msg_uart_status_decode(const mavlink_message_t* msg, mavlink_uart_status_t* uart_status)
+{
+#if MAVLINK_NEED_BYTE_SWAP
+	uart_status->rx_bytes = mavlink_msg_uart_status_get_rx_bytes(msg);
+	uart_status->tx_bytes = mavlink_msg_uart_status_get_tx_bytes(msg);
+	uart_status->rx_dropped = mavlink_msg_uart_status_get_rx_dropped(msg);
+	uart_status->tx_dropped = mavlink_msg_uart_status_get_tx_dropped(msg);
+	uart_status->rx_overruns = mavlink_msg_uart_status_get_rx_overruns(msg);
+	uart_status->rx_peak = mavlink_msg_uart_status_get_rx_peak(msg);
+	uart_status->tx_peak = mavlink_msg_uart_status_get_tx_peak(msg);
+	uart_status->isr_max_ticks = mavlink_msg_uart_status_get_isr_max_ticks(msg);
+	uart_status->uart_id = mavlink_msg_uart_status_get_uart_id(msg);
+#else
+	memcpy(uart_status, _MAV_PAYLOAD(msg), 25);
+#endif
+}
@@ -4,20 +4,28 @@
 
 typedef struct __mavlink_xbee_heartbeat_t
 {
+ uint32_t time; ///< Sender's clock when it was sent (ms)
+ uint32_t echo_time; ///< time of the last heartbeat the sender heard, 0 for none
+ uint16_t seq; ///< Counts up by one for each heartbeat the sender sends
+ uint16_t echo_delay; ///< How long the sender held that heartbeat before this one (ms)
  uint8_t ack; ///<  TRUE if we want an ACK return FALSE else
- uint8_t data; ///< Holds raw data for use in testing
+ uint8_t loss; ///< Percent of the other end's heartbeats the sender lost, over its window
 } mavlink_xbee_heartbeat_t;
 
-#define MAVLINK_MSG_ID_XBEE_HEARTBEAT_LEN 2
-#define MAVLINK_MSG_ID_236_LEN 2
+#define MAVLINK_MSG_ID_XBEE_HEARTBEAT_LEN 14
+#define MAVLINK_MSG_ID_236_LEN 14
 
 
 
 #define MAVLINK_MESSAGE_INFO_XBEE_HEARTBEAT { \
 	"XBEE_HEARTBEAT", \
-	2, \
-	{  { "ack", NULL, MAVLINK_TYPE_UINT8_T, 0, 0, offsetof(mavlink_xbee_heartbeat_t, ack) }, \
-         { "data", NULL, MAVLINK_TYPE_UINT8_T, 0, 1, offsetof(mavlink_xbee_heartbeat_t, data) }, \
+	6, \
+	{  { "time", NULL, MAVLINK_TYPE_UINT32_T, 0, 0, offsetof(mavlink_xbee_heartbeat_t, time) }, \
+         { "echo_time", NULL, MAVLINK_TYPE_UINT32_T, 0, 4, offsetof(mavlink_xbee_heartbeat_t, echo_time) }, \
+         { "seq", NULL, MAVLINK_TYPE_UINT16_T, 0, 8, offsetof(mavlink_xbee_heartbeat_t, seq) }, \
+         { "echo_delay", NULL, MAVLINK_TYPE_UINT16_T, 0, 10, offsetof(mavlink_xbee_heartbeat_t, echo_delay) }, \
+         { "ack", NULL, MAVLINK_TYPE_UINT8_T, 0, 12, offsetof(mavlink_xbee_heartbeat_t, ack) }, \
+         { "loss", NULL, MAVLINK_TYPE_UINT8_T, 0, 13, offsetof(mavlink_xbee_heartbeat_t, loss) }, \
          } \
 }
 
@@ -29,28 +37,40 @@ typedef struct __mavlink_xbee_heartbeat_t
  * @param msg The MAVLink message to compress the data into
  *
  * @param ack  TRUE if we want an ACK return FALSE else
- * @param data Holds raw data for use in testing
+ * @param seq Counts up by one for each heartbeat the sender sends
+ * @param time Sender's clock when it was sent (ms)
+ * @param echo_time time of the last heartbeat the sender heard, 0 for none
+ * @param echo_delay How long the sender held that heartbeat before this one (ms)
+ * @param loss Percent of the other end's heartbeats the sender lost, over its window
  * @return length of the message in bytes (excluding serial stream start sign)
  */
 static inline uint16_t mavlink_msg_xbee_heartbeat_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
-						       uint8_t ack, uint8_t data)
+						       uint8_t ack, uint16_t seq, uint32_t time, uint32_t echo_time, uint16_t echo_delay, uint8_t loss)
 {
 #if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
-	char buf[2];
-	_mav_put_uint8_t(buf, 0, ack);
-	_mav_put_uint8_t(buf, 1, data);
-
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 2);
+	char buf[14];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint32_t(buf, 4, echo_time);
+	_mav_put_uint16_t(buf, 8, seq);
+	_mav_put_uint16_t(buf, 10, echo_delay);
+	_mav_put_uint8_t(buf, 12, ack);
+	_mav_put_uint8_t(buf, 13, loss);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 14);
 #else
 	mavlink_xbee_heartbeat_t packet;
+	packet.time = time;
+	packet.echo_time = echo_time;
+	packet.seq = seq;
+	packet.echo_delay = echo_delay;
 	packet.ack = ack;
-	packet.data = data;
+	packet.loss = loss;
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 2);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 14);
 #endif
 
 	msg->msgid = MAVLINK_MSG_ID_XBEE_HEARTBEAT;
-	return mavlink_finalize_message(msg, system_id, component_id, 2, 58);
+	return mavlink_finalize_message(msg, system_id, component_id, 14, 21);
 }
 
 /**
@@ -60,29 +80,41 @@ static inline uint16_t mavlink_msg_xbee_heartbeat_pack(uint8_t system_id, uint8_
  * @param chan The MAVLink channel this message was sent over
  * @param msg The MAVLink message to compress the data into
  * @param ack  TRUE if we want an ACK return FALSE else
- * @param data Holds raw data for use in testing
+ * @param seq Counts up by one for each heartbeat the sender sends
+ * @param time Sender's clock when it was sent (ms)
+ * @param echo_time time of the last heartbeat the sender heard, 0 for none
+ * @param echo_delay How long the sender held that heartbeat before this one (ms)
+ * @param loss Percent of the other end's heartbeats the sender lost, over its window
  * @return length of the message in bytes (excluding serial stream start sign)
  */
 static inline uint16_t mavlink_msg_xbee_heartbeat_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
 							   mavlink_message_t* msg,
-						           uint8_t ack,uint8_t data)
+						           uint8_t ack,uint16_t seq,uint32_t time,uint32_t echo_time,uint16_t echo_delay,uint8_t loss)
 {
 #if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
-	char buf[2];
-	_mav_put_uint8_t(buf, 0, ack);
-	_mav_put_uint8_t(buf, 1, data);
-
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 2);
+	char buf[14];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint32_t(buf, 4, echo_time);
+	_mav_put_uint16_t(buf, 8, seq);
+	_mav_put_uint16_t(buf, 10, echo_delay);
+	_mav_put_uint8_t(buf, 12, ack);
+	_mav_put_uint8_t(buf, 13, loss);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 14);
 #else
 	mavlink_xbee_heartbeat_t packet;
+	packet.time = time;
+	packet.echo_time = echo_time;
+	packet.seq = seq;
+	packet.echo_delay = echo_delay;
 	packet.ack = ack;
-	packet.data = data;
+	packet.loss = loss;
 
-        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 2);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 14);
 #endif
 
 	msg->msgid = MAVLINK_MSG_ID_XBEE_HEARTBEAT;
-	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 2, 58);
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 14, 21);
 }
 
 /**
@@ -95,7 +127,7 @@ static inline uint16_t mavlink_msg_xbee_heartbeat_pack_chan(uint8_t system_id, u
  */
 static inline uint16_t mavlink_msg_xbee_heartbeat_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_xbee_heartbeat_t* xbee_heartbeat)
 {
-	return mavlink_msg_xbee_heartbeat_pack(system_id, component_id, msg, xbee_heartbeat->ack, xbee_heartbeat->data);
+	return mavlink_msg_xbee_heartbeat_pack(system_id, component_id, msg, xbee_heartbeat->ack, xbee_heartbeat->seq, xbee_heartbeat->time, xbee_heartbeat->echo_time, xbee_heartbeat->echo_delay, xbee_heartbeat->loss);
 }
 
 /**
@@ -103,24 +135,36 @@ static inline uint16_t mavlink_msg_xbee_heartbeat_encode(uint8_t system_id, uint
  * @param chan MAVLink channel to send the message
  *
  * @param ack  TRUE if we want an ACK return FALSE else
- * @param data Holds raw data for use in testing
+ * @param seq Counts up by one for each heartbeat the sender sends
+ * @param time Sender's clock when it was sent (ms)
+ * @param echo_time time of the last heartbeat the sender heard, 0 for none
+ * @param echo_delay How long the sender held that heartbeat before this one (ms)
+ * @param loss Percent of the other end's heartbeats the sender lost, over its window
  */
 #ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
 
-static inline void mavlink_msg_xbee_heartbeat_send(mavlink_channel_t chan, uint8_t ack, uint8_t data)
+static inline void mavlink_msg_xbee_heartbeat_send(mavlink_channel_t chan, uint8_t ack, uint16_t seq, uint32_t time, uint32_t echo_time, uint16_t echo_delay, uint8_t loss)
 {
 #if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
-	char buf[2];
-	_mav_put_uint8_t(buf, 0, ack);
-	_mav_put_uint8_t(buf, 1, data);
-
-	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_XBEE_HEARTBEAT, buf, 2, 58);
+	char buf[14];
+	_mav_put_uint32_t(buf, 0, time);
+	_mav_put_uint32_t(buf, 4, echo_time);
+	_mav_put_uint16_t(buf, 8, seq);
+	_mav_put_uint16_t(buf, 10, echo_delay);
+	_mav_put_uint8_t(buf, 12, ack);
+	_mav_put_uint8_t(buf, 13, loss);
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_XBEE_HEARTBEAT, buf, 14, 21);
 #else
 	mavlink_xbee_heartbeat_t packet;
+	packet.time = time;
+	packet.echo_time = echo_time;
+	packet.seq = seq;
+	packet.echo_delay = echo_delay;
 	packet.ack = ack;
-	packet.data = data;
+	packet.loss = loss;
 
-	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_XBEE_HEARTBEAT, (const char *)&packet, 2, 58);
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_XBEE_HEARTBEAT, (const char *)&packet, 14, 21);
 #endif
 }
 
@@ -136,17 +180,57 @@ static inline void mavlink_msg_xbee_heartbeat_send(mavlink_channel_t chan, uint8
  */
 static inline uint8_t mavlink_msg_xbee_heartbeat_get_ack(const mavlink_message_t* msg)
 {
-	return _MAV_RETURN_uint8_t(msg,  0);
+	return _MAV_RETURN_uint8_t(msg,  12);
+}
+
+/**
+ * @brief Get field seq from xbee_heartbeat message
+ *
+ * @return Counts up by one for each heartbeat the sender sends
+ */
+static inline uint16_t mavlink_msg_xbee_heartbeat_get_seq(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  8);
+}
+
+/**
+ * @brief Get field time from xbee_heartbeat message
+ *
+ * @return Sender's clock when it was sent (ms)
+ */
+static inline uint32_t mavlink_msg_xbee_heartbeat_get_time(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  0);
+}
+
+/**
+ * @brief Get field echo_time from xbee_heartbeat message
+ *
+ * @return time of the last heartbeat the sender heard, 0 for none
+ */
+static inline uint32_t mavlink_msg_xbee_heartbeat_get_echo_time(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  4);
+}
+
+/**
+ * @brief Get field echo_delay from xbee_heartbeat message
+ *
+ * @return How long the sender held that heartbeat before this one (ms)
+ */
+static inline uint16_t mavlink_msg_xbee_heartbeat_get_echo_delay(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  10);
 }
 
 /**
- * @brief Get field data from xbee_heartbeat message
+ * @brief Get field loss from xbee_heartbeat message
  *
- * @return Holds raw data for use in testing
+ * @return Percent of the other end's heartbeats the sender lost, over its window
  */
-static inline uint8_t mavlink_msg_xbee_heartbeat_get_data(const mavlink_message_t* msg)
+static inline uint8_t mavlink_msg_xbee_heartbeat_get_loss(const mavlink_message_t* msg)
 {
-	return _MAV_RETURN_uint8_t(msg,  1);
+	return _MAV_RETURN_uint8_t(msg,  13);
 }
 
 /**
@@ -158,9 +242,13 @@ static inline uint8_t mavlink_msg_xbee_heartbeat_get_data(const mavlink_message_
 static inline void mavlink_msg_xbee_heartbeat_decode(const mavlink_message_t* msg, mavlink_xbee_heartbeat_t* xbee_heartbeat)
 {
 #if MAVLINK_NEED_BYTE_SWAP
+	xbee_heartbeat->time = mavlink_msg_xbee_heartbeat_get_time(msg);
+	xbee_heartbeat->echo_time = mavlink_msg_xbee_heartbeat_get_echo_time(msg);
+	xbee_heartbeat->seq = mavlink_msg_xbee_heartbeat_get_seq(msg);
+	xbee_heartbeat->echo_delay = mavlink_msg_xbee_heartbeat_get_echo_delay(msg);
 	xbee_heartbeat->ack = mavlink_msg_xbee_heartbeat_get_ack(msg);
-	xbee_heartbeat->data = mavlink_msg_xbee_heartbeat_get_data(msg);
+	xbee_heartbeat->loss = mavlink_msg_xbee_heartbeat_get_loss(msg);
 #else
-	memcpy(xbee_heartbeat, _MAV_PAYLOAD(msg), 2);
+	memcpy(xbee_heartbeat, _MAV_PAYLOAD(msg), 14);
 #endif
 }
@@ -0,0 +1,276 @@
+// MESSAGE XBEE_STATUS PACKING
+
+#define MAVLINK_MSG_ID_XBEE_STATUS 248
+
+typedef struct __mavlink_xbee_status_t
+{
+ uint32_t tx_acked; ///< Packets the other radio acknowledged
+ uint32_t tx_failed; ///< Packets the radio gave up on
+ uint32_t rx_packets; ///< Packets received
+ uint32_t rx_errors; ///< API frames cut short or with a bad checksum
+ uint32_t telemetry_decimated; ///< Telemetry messages skipped to stay inside the rate
+ uint16_t telemetry_rate; ///< Bytes per second telemetry may use
+ int8_t rssi; ///< Signal strength of the last packet received (dBm)
+} mavlink_xbee_status_t;
+
+#define MAVLINK_MSG_ID_XBEE_STATUS_LEN 23
+#define MAVLINK_MSG_ID_248_LEN 23
+
+
+
+#define MAVLINK_MESSAGE_INFO_XBEE_STATUS { \
+	"XBEE_STATUS", \
+	7, \
+	{  { "tx_acked", NULL, MAVLINK_TYPE_UINT32_T, 0, 0, offsetof(mavlink_xbee_status_t, tx_acked) }, \
+         { "tx_failed", NULL, MAVLINK_TYPE_UINT32_T, 0, 4, offsetof(mavlink_xbee_status_t, tx_failed) }, \
+         { "rx_packets", NULL, MAVLINK_TYPE_UINT32_T, 0, 8, offsetof(mavlink_xbee_status_t, rx_packets) }, \
+         { "rx_errors", NULL, MAVLINK_TYPE_UINT32_T, 0, 12, offsetof(mavlink_xbee_status_t, rx_errors) }, \
+         { "telemetry_decimated", NULL, MAVLINK_TYPE_UINT32_T, 0, 16, offsetof(mavlink_xbee_status_t, telemetry_decimated) }, \
+         { "telemetry_rate", NULL, MAVLINK_TYPE_UINT16_T, 0, 20, offsetof(mavlink_xbee_status_t, telemetry_rate) }, \
+         { "rssi", NULL, MAVLINK_TYPE_INT8_T, 0, 22, offsetof(mavlink_xbee_status_t, rssi) }, \
+         } \
+}
+
+
+/**
+ * @brief Pack a xbee_status message
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ *
+ * @param rssi Signal strength of the last packet received (dBm)
+ * @param tx_acked Packets the other radio acknowledged
+ * @param tx_failed Packets the radio gave up on
+ * @param rx_packets Packets received
+ * @param rx_errors API frames cut short or with a bad checksum
+ * @param telemetry_rate Bytes per second telemetry may use
+ * @param telemetry_decimated Telemetry messages skipped to stay inside the rate
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_xbee_status_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
+						       int8_t rssi, uint32_t tx_acked, uint32_t tx_failed, uint32_t rx_packets, uint32_t rx_errors, uint16_t telemetry_rate, uint32_t telemetry_decimated)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[23];
+	_mav_put_uint32_t(buf, 0, tx_acked);
+	_mav_put_uint32_t(buf, 4, tx_failed);
+	_mav_put_uint32_t(buf, 8, rx_packets);
+	_mav_put_uint32_t(buf, 12, rx_errors);
+	_mav_put_uint32_t(buf, 16, telemetry_decimated);
+	_mav_put_uint16_t(buf, 20, telemetry_rate);
+	_mav_put_int8_t(buf, 22, rssi);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 23);
+#else
+	mavlink_xbee_status_t packet;
+	packet.tx_acked = tx_acked;
+	packet.tx_failed = tx_failed;
+	packet.rx_packets = rx_packets;
+	packet.rx_errors = rx_errors;
+	packet.telemetry_decimated = telemetry_decimated;
+	packet.telemetry_rate = telemetry_rate;
+	packet.rssi = rssi;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 23);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_XBEE_STATUS;
+	return mavlink_finalize_message(msg, system_id, component_id, 23, 138);
+}
+
+/**
+ * @brief Pack a xbee_status message on a channel
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param chan The MAVLink channel this message was sent over
+ * @param msg The MAVLink message to compress the data into
+ * @param rssi Signal strength of the last packet received (dBm)
+ * @param tx_acked Packets the other radio acknowledged
+ * @param tx_failed Packets the radio gave up on
+ * @param rx_packets Packets received
+ * @param rx_errors API frames cut short or with a bad checksum
+ * @param telemetry_rate Bytes per second telemetry may use
+ * @param telemetry_decimated Telemetry messages skipped to stay inside the rate
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_xbee_status_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
+							   mavlink_message_t* msg,
+						           int8_t rssi,uint32_t tx_acked,uint32_t tx_failed,uint32_t rx_packets,uint32_t rx_errors,uint16_t telemetry_rate,uint32_t telemetry_decimated)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[23];
+	_mav_put_uint32_t(buf, 0, tx_acked);
+	_mav_put_uint32_t(buf, 4, tx_failed);
+	_mav_put_uint32_t(buf, 8, rx_packets);
+	_mav_put_uint32_t(buf, 12, rx_errors);
+	_mav_put_uint32_t(buf, 16, telemetry_decimated);
+	_mav_put_uint16_t(buf, 20, telemetry_rate);
+	_mav_put_int8_t(buf, 22, rssi);
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 23);
+#else
+	mavlink_xbee_status_t packet;
+	packet.tx_acked = tx_acked;
+	packet.tx_failed = tx_failed;
+	packet.rx_packets = rx_packets;
+	packet.rx_errors = rx_errors;
+	packet.telemetry_decimated = telemetry_decimated;
+	packet.telemetry_rate = telemetry_rate;
+	packet.rssi = rssi;
+
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 23);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_XBEE_STATUS;
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 23, 138);
+}
+
+/**
+ * @brief Encode a xbee_status struct into a message
+ *
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ * @param xbee_status C-struct to read the message contents from
+ */
+static inline uint16_t mavlink_msg_xbee_status_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_xbee_status_t* xbee_status)
+{
+	return mavlink_msg_xbee_status_pack(system_id, component_id, msg, xbee_status->rssi, xbee_status->tx_acked, xbee_status->tx_failed, xbee_status->rx_packets, xbee_status->rx_errors, xbee_status->telemetry_rate, xbee_status->telemetry_decimated);
+}
+
+/**
+ * @brief Send a xbee_status message
+ * @param chan MAVLink channel to send the message
+ *
+ * @param rssi Signal strength of the last packet received (dBm)
+ * @param tx_acked Packets the other radio acknowledged
+ * @param tx_failed Packets the radio gave up on
+ * @param rx_packets Packets received
+ * @param rx_errors API frames cut short or with a bad checksum
+ * @param telemetry_rate Bytes per second telemetry may use
+ * @param telemetry_decimated Telemetry messages skipped to stay inside the rate
+ */
+#ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
+
+static inline void mavlink_msg_xbee_status_send(mavlink_channel_t chan, int8_t rssi, uint32_t tx_acked, uint32_t tx_failed, uint32_t rx_packets, uint32_t rx_errors, uint16_t telemetry_rate, uint32_t telemetry_decimated)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[23];
+	_mav_put_uint32_t(buf, 0, tx_acked);
+	_mav_put_uint32_t(buf, 4, tx_failed);
+	_mav_put_uint32_t(buf, 8, rx_packets);
+	_mav_put_uint32_t(buf, 12, rx_errors);
+	_mav_put_uint32_t(buf, 16, telemetry_decimated);
+	_mav_put_uint16_t(buf, 20, telemetry_rate);
+	_mav_put_int8_t(buf, 22, rssi);
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_XBEE_STATUS, buf, 23, 138);
+#else
+	mavlink_xbee_status_t packet;
+	packet.tx_acked = tx_acked;
+	packet.tx_failed = tx_failed;
+	packet.rx_packets = rx_packets;
+	packet.rx_errors = rx_errors;
+	packet.telemetry_decimated = telemetry_decimated;
+	packet.telemetry_rate = telemetry_rate;
+	packet.rssi = rssi;
+
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_XBEE_STATUS, (const char *)&packet, 23, 138);
+#endif
+}
+
+#endif
+
+// MESSAGE XBEE_STATUS UNPACKING
+
+
+/**
+ * @brief Get field rssi from xbee_status message
+ *
+ * @return Signal strength of the last packet received (dBm)
+ */
+static inline int8_t mavlink_msg_xbee_status_get_rssi(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_int8_t(msg,  22);
+}
+
+/**
+ * @brief Get field tx_acked from xbee_status message
+ *
+ * @return Packets the other radio acknowledged
+ */
+static inline uint32_t mavlink_msg_xbee_status_get_tx_acked(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  0);
+}
+
+/**
+ * @brief Get field tx_failed from xbee_status message
+ *
+ * @return Packets the radio gave up on
+ */
+static inline uint32_t mavlink_msg_xbee_status_get_tx_failed(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  4);
+}
+
+/**
+ * @brief Get field rx_packets from xbee_status message
+ *
+ * @return Packets received
+ */
+static inline uint32_t mavlink_msg_xbee_status_get_rx_packets(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  8);
+}
+
+/**
+ * @brief Get field rx_errors from xbee_status message
+ *
+ * @return API frames cut short or with a bad checksum
+ */
+static inline uint32_t mavlink_msg_xbee_status_get_rx_errors(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  12);
+}
+
+/**
+ * @brief Get field telemetry_rate from xbee_status message
+ *
+ * @return Bytes per second telemetry may use
+ */
+static inline uint16_t mavlink_msg_xbee_status_get_telemetry_rate(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint16_t(msg,  20);
+}
+
+/**
+ * @brief Get field telemetry_decimated from xbee_status message
+ *
+ * @return Telemetry messages skipped to stay inside the rate
+ */
+static inline uint32_t mavlink_msg_xbee_status_get_telemetry_decimated(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint32_t(msg,  16);
+}
+
+/**
+ * @brief Decode a xbee_status message into a struct
+ *
+ * @param msg The message to decode
+ * @param xbee_status C-struct to decode the message contents into
+ */
+static inline void mavlink_msg_xbee_status_decode(const mavlink_message_t* msg, mavlink_xbee_status_t* xbee_status)
+{
+#if MAVLINK_NEED_BYTE_SWAP
+	xbee_status->tx_acked = mavlink_msg_xbee_status_get_tx_acked(msg);
+	xbee_status->tx_failed = mavlink_msg_xbee_status_get_tx_failed(msg);
+	xbee_status->rx_packets = mavlink_msg_xbee_status_get_rx_packets(msg);
+	xbee_status->rx_errors = mavlink_msg_xbee_status_get_rx_errors(msg);
+	xbee_status->telemetry_decimated = mavlink_msg_xbee_status_get_telemetry_decimated(msg);
+	xbee_status->telemetry_rate = mavlink_msg_xbee_status_get_telemetry_rate(msg);
+	xbee_status->rssi = mavlink_msg_xbee_status_get_rssi(msg);
+#else
+	memcpy(xbee_status, _MAV_PAYLOAD(msg), 23);
+#endif
+}
@@ -73,13 +73,21 @@ static void mavlink_test_xbee_heartbeat(uint8_t system_id, uint8_t component_id,
         uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
         uint16_t i;
 	mavlink_xbee_heartbeat_t packet_in = {
-		5,
-	72,
+		963497464,
+	963497516,
+	17339,
+	17391,
+	17,
+	84,
 	};
 	mavlink_xbee_heartbeat_t packet1, packet2;
         memset(&packet1, 0, sizeof(packet1));
+        	packet1.time = packet_in.time;
+        	packet1.echo_time = packet_in.echo_time;
+        	packet1.seq = packet_in.seq;
+        	packet1.echo_delay = packet_in.echo_delay;
         	packet1.ack = packet_in.ack;
-        	packet1.data = packet_in.data;
+        	packet1.loss = packet_in.loss;
         
         
 
@@ -89,12 +97,12 @@ static void mavlink_test_xbee_heartbeat(uint8_t system_id, uint8_t component_id,
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 
         memset(&packet2, 0, sizeof(packet2));
-	mavlink_msg_xbee_heartbeat_pack(system_id, component_id, &msg , packet1.ack , packet1.data );
+	mavlink_msg_xbee_heartbeat_pack(system_id, component_id, &msg , packet1.ack , packet1.seq , packet1.time , packet1.echo_time , packet1.echo_delay , packet1.loss );
 	mavlink_msg_xbee_heartbeat_decode(&msg, &packet2);
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 
         memset(&packet2, 0, sizeof(packet2));
-	mavlink_msg_xbee_heartbeat_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.ack , packet1.data );
+	mavlink_msg_xbee_heartbeat_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.ack , packet1.seq , packet1.time , packet1.echo_time , packet1.echo_delay , packet1.loss );
 	mavlink_msg_xbee_heartbeat_decode(&msg, &packet2);
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 
@@ -107,7 +115,7 @@ static void mavlink_test_xbee_heartbeat(uint8_t system_id, uint8_t component_id,
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
         
         memset(&packet2, 0, sizeof(packet2));
-	mavlink_msg_xbee_heartbeat_send(MAVLINK_COMM_1 , packet1.ack , packet1.data );
+	mavlink_msg_xbee_heartbeat_send(MAVLINK_COMM_1 , packet1.ack , packet1.seq , packet1.time , packet1.echo_time , packet1.echo_delay , packet1.loss );
 	mavlink_msg_xbee_heartbeat_decode(last_msg, &packet2);
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 }
@@ -119,10 +127,12 @@ static void mavlink_test_mavlink_ack(uint8_t system_id, uint8_t component_id, ma
         uint16_t i;
 	mavlink_mavlink_ack_t packet_in = {
 		5,
+	72,
 	};
 	mavlink_mavlink_ack_t packet1, packet2;
         memset(&packet1, 0, sizeof(packet1));
         	packet1.Message_Name = packet_in.Message_Name;
+        	packet1.seq = packet_in.seq;
         
         
 
@@ -132,12 +142,12 @@ static void mavlink_test_mavlink_ack(uint8_t system_id, uint8_t component_id, ma
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 
         memset(&packet2, 0, sizeof(packet2));
-	mavlink_msg_mavlink_ack_pack(system_id, component_id, &msg , packet1.Message_Name );
+	mavlink_msg_mavlink_ack_pack(system_id, component_id, &msg , packet1.Message_Name , packet1.seq );
 	mavlink_msg_mavlink_ack_decode(&msg, &packet2);
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 
         memset(&packet2, 0, sizeof(packet2));
-	mavlink_msg_mavlink_ack_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.Message_Name );
+	mavlink_msg_mavlink_ack_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.Message_Name , packet1.seq );
 	mavlink_msg_mavlink_ack_decode(&msg, &packet2);
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 
@@ -150,7 +160,7 @@ static void mavlink_test_mavlink_ack(uint8_t system_id, uint8_t component_id, ma
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
         
         memset(&packet2, 0, sizeof(packet2));
-	mavlink_msg_mavlink_ack_send(MAVLINK_COMM_1 , packet1.Message_Name );
+	mavlink_msg_mavlink_ack_send(MAVLINK_COMM_1 , packet1.Message_Name , packet1.seq );
 	mavlink_msg_mavlink_ack_decode(last_msg, &packet2);
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 }
@@ -161,13 +171,17 @@ static void mavlink_test_gps_error(uint8_t system_id, uint8_t component_id, mavl
         uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
         uint16_t i;
 	mavlink_gps_error_t packet_in = {
-		5,
-	72,
+		963497464,
+	963497516,
+	963497568,
+	206,
 	};
 	mavlink_gps_error_t packet1, packet2;
         memset(&packet1, 0, sizeof(packet1));
+        	packet1.time = packet_in.time;
+        	packet1.latitude = packet_in.latitude;
+        	packet1.longitude = packet_in.longitude;
         	packet1.ack = packet_in.ack;
-        	packet1.data = packet_in.data;
         
         
 
@@ -177,12 +191,12 @@ static void mavlink_test_gps_error(uint8_t system_id, uint8_t component_id, mavl
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 
         memset(&packet2, 0, sizeof(packet2));
-	mavlink_msg_gps_error_pack(system_id, component_id, &msg , packet1.ack , packet1.data );
+	mavlink_msg_gps_error_pack(system_id, component_id, &msg , packet1.ack , packet1.time , packet1.latitude , packet1.longitude );
 	mavlink_msg_gps_error_decode(&msg, &packet2);
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 
         memset(&packet2, 0, sizeof(packet2));
-	mavlink_msg_gps_error_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.ack , packet1.data );
+	mavlink_msg_gps_error_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.ack , packet1.time , packet1.latitude , packet1.longitude );
 	mavlink_msg_gps_error_decode(&msg, &packet2);
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 
@@ -195,7 +209,7 @@ static void mavlink_test_gps_error(uint8_t system_id, uint8_t component_id, mavl
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
         
         memset(&packet2, 0, sizeof(packet2));
-	mavlink_msg_gps_error_send(MAVLINK_COMM_1 , packet1.ack , packet1.data );
+	mavlink_msg_gps_error_send(MAVLINK_COMM_1 , packet1.ack , packet1.time , packet1.latitude , packet1.longitude );
 	mavlink_msg_gps_error_decode(last_msg, &packet2);
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 }
@@ -294,6 +308,428 @@ static void mavlink_test_stop_rescue(uint8_t system_id, uint8_t component_id, ma
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 }
 
+static void mavlink_test_uart_status(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
+{
+	mavlink_message_t msg;
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t i;
+	mavlink_uart_status_t packet_in = {
+		963497464,
+	963497516,
+	963497568,
+	963497620,
+	17443,
+	17495,
+	17547,
+	17599,
+	29,
+	};
+	mavlink_uart_status_t packet1, packet2;
+        memset(&packet1, 0, sizeof(packet1));
+        	packet1.rx_bytes = packet_in.rx_bytes;
+        	packet1.tx_bytes = packet_in.tx_bytes;
+        	packet1.rx_dropped = packet_in.rx_dropped;
+        	packet1.tx_dropped = packet_in.tx_dropped;
+        	packet1.rx_overruns = packet_in.rx_overruns;
+        	packet1.rx_peak = packet_in.rx_peak;
+        	packet1.tx_peak = packet_in.tx_peak;
+        	packet1.isr_max_ticks = packet_in.isr_max_ticks;
+        	packet1.uart_id = packet_in.uart_id;
+        
+        
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_uart_status_encode(system_id, component_id, &msg, &packet1);
+	mavlink_msg_uart_status_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_uart_status_pack(system_id, component_id, &msg , packet1.uart_id , packet1.rx_bytes , packet1.tx_bytes , packet1.rx_dropped , packet1.tx_dropped , packet1.rx_overruns , packet1.rx_peak , packet1.tx_peak , packet1.isr_max_ticks );
+	mavlink_msg_uart_status_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_uart_status_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.uart_id , packet1.rx_bytes , packet1.tx_bytes , packet1.rx_dropped , packet1.tx_dropped , packet1.rx_overruns , packet1.rx_peak , packet1.tx_peak , packet1.isr_max_ticks );
+	mavlink_msg_uart_status_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+        mavlink_msg_to_send_buffer(buffer, &msg);
+        for (i=0; i<mavlink_msg_get_send_buffer_length(&msg); i++) {
+        	comm_send_ch(MAVLINK_COMM_0, buffer[i]);
+        }
+	mavlink_msg_uart_status_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+        
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_uart_status_send(MAVLINK_COMM_1 , packet1.uart_id , packet1.rx_bytes , packet1.tx_bytes , packet1.rx_dropped , packet1.tx_dropped , packet1.rx_overruns , packet1.rx_peak , packet1.tx_peak , packet1.isr_max_ticks );
+	mavlink_msg_uart_status_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+}
+
+static void mavlink_test_thermal_frame(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
+{
+	mavlink_message_t msg;
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t i;
+	mavlink_thermal_frame_t packet_in = {
+		963497464,
+	17287,
+	139,
+	206,
+	17,
+	84,
+	{ 151, 218, 29, 96, 163, 230, 41, 108, 175, 242, 53, 120, 187, 254, 65, 132, 199, 10, 77, 144, 211, 22, 89, 156, 223, 34, 101, 168, 235, 46, 113, 180, 247, 58, 125, 192, 3, 70, 137, 204, 15, 82, 149, 216, 27, 94, 161, 228, 39, 106, 173, 240, 51, 118, 185, 252, 63, 130, 197, 8, 75, 142, 209, 20, 87, 154, 221, 32, 99, 166, 233, 44, 111, 178, 245, 56, 123, 190, 1, 68 },
+	};
+	mavlink_thermal_frame_t packet1, packet2;
+        memset(&packet1, 0, sizeof(packet1));
+        	packet1.time = packet_in.time;
+        	packet1.frame = packet_in.frame;
+        	packet1.flags = packet_in.flags;
+        	packet1.chunk = packet_in.chunk;
+        	packet1.chunks = packet_in.chunks;
+        	packet1.length = packet_in.length;
+        
+        	mav_array_memcpy(packet1.data, packet_in.data, sizeof(uint8_t)*80);
+        
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_thermal_frame_encode(system_id, component_id, &msg, &packet1);
+	mavlink_msg_thermal_frame_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_thermal_frame_pack(system_id, component_id, &msg , packet1.time , packet1.frame , packet1.flags , packet1.chunk , packet1.chunks , packet1.length , packet1.data );
+	mavlink_msg_thermal_frame_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_thermal_frame_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.time , packet1.frame , packet1.flags , packet1.chunk , packet1.chunks , packet1.length , packet1.data );
+	mavlink_msg_thermal_frame_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+        mavlink_msg_to_send_buffer(buffer, &msg);
+        for (i=0; i<mavlink_msg_get_send_buffer_length(&msg); i++) {
+        	comm_send_ch(MAVLINK_COMM_0, buffer[i]);
+        }
+	mavlink_msg_thermal_frame_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+        
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_thermal_frame_send(MAVLINK_COMM_1 , packet1.time , packet1.frame , packet1.flags , packet1.chunk , packet1.chunks , packet1.length , packet1.data );
+	mavlink_msg_thermal_frame_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+}
+
+static void mavlink_test_boat_position(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
+{
+	mavlink_message_t msg;
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t i;
+	mavlink_boat_position_t packet_in = {
+		963497464,
+	963497516,
+	963497568,
+	17391,
+	17443,
+	17495,
+	17547,
+	218,
+	};
+	mavlink_boat_position_t packet1, packet2;
+        memset(&packet1, 0, sizeof(packet1));
+        	packet1.time = packet_in.time;
+        	packet1.latitude = packet_in.latitude;
+        	packet1.longitude = packet_in.longitude;
+        	packet1.velocity_north = packet_in.velocity_north;
+        	packet1.velocity_east = packet_in.velocity_east;
+        	packet1.heading = packet_in.heading;
+        	packet1.accuracy = packet_in.accuracy;
+        	packet1.guidance = packet_in.guidance;
+        
+        
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_boat_position_encode(system_id, component_id, &msg, &packet1);
+	mavlink_msg_boat_position_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_boat_position_pack(system_id, component_id, &msg , packet1.time , packet1.latitude , packet1.longitude , packet1.velocity_north , packet1.velocity_east , packet1.heading , packet1.accuracy , packet1.guidance );
+	mavlink_msg_boat_position_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_boat_position_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.time , packet1.latitude , packet1.longitude , packet1.velocity_north , packet1.velocity_east , packet1.heading , packet1.accuracy , packet1.guidance );
+	mavlink_msg_boat_position_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+        mavlink_msg_to_send_buffer(buffer, &msg);
+        for (i=0; i<mavlink_msg_get_send_buffer_length(&msg); i++) {
+        	comm_send_ch(MAVLINK_COMM_0, buffer[i]);
+        }
+	mavlink_msg_boat_position_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+        
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_boat_position_send(MAVLINK_COMM_1 , packet1.time , packet1.latitude , packet1.longitude , packet1.velocity_north , packet1.velocity_east , packet1.heading , packet1.accuracy , packet1.guidance );
+	mavlink_msg_boat_position_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+}
+
+static void mavlink_test_battery(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
+{
+	mavlink_message_t msg;
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t i;
+	mavlink_battery_t packet_in = {
+		963497464,
+	17287,
+	};
+	mavlink_battery_t packet1, packet2;
+        memset(&packet1, 0, sizeof(packet1));
+        	packet1.time = packet_in.time;
+        	packet1.voltage = packet_in.voltage;
+        
+        
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_battery_encode(system_id, component_id, &msg, &packet1);
+	mavlink_msg_battery_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_battery_pack(system_id, component_id, &msg , packet1.time , packet1.voltage );
+	mavlink_msg_battery_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_battery_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.time , packet1.voltage );
+	mavlink_msg_battery_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+        mavlink_msg_to_send_buffer(buffer, &msg);
+        for (i=0; i<mavlink_msg_get_send_buffer_length(&msg); i++) {
+        	comm_send_ch(MAVLINK_COMM_0, buffer[i]);
+        }
+	mavlink_msg_battery_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+        
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_battery_send(MAVLINK_COMM_1 , packet1.time , packet1.voltage );
+	mavlink_msg_battery_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+}
+
+static void mavlink_test_thermal_target(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
+{
+	mavlink_message_t msg;
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t i;
+	mavlink_thermal_target_t packet_in = {
+		963497464,
+	17287,
+	17339,
+	17391,
+	17,
+	};
+	mavlink_thermal_target_t packet1, packet2;
+        memset(&packet1, 0, sizeof(packet1));
+        	packet1.time = packet_in.time;
+        	packet1.heading = packet_in.heading;
+        	packet1.elevation = packet_in.elevation;
+        	packet1.peak = packet_in.peak;
+        	packet1.pixels = packet_in.pixels;
+        
+        
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_thermal_target_encode(system_id, component_id, &msg, &packet1);
+	mavlink_msg_thermal_target_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_thermal_target_pack(system_id, component_id, &msg , packet1.time , packet1.heading , packet1.elevation , packet1.peak , packet1.pixels );
+	mavlink_msg_thermal_target_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_thermal_target_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.time , packet1.heading , packet1.elevation , packet1.peak , packet1.pixels );
+	mavlink_msg_thermal_target_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+        mavlink_msg_to_send_buffer(buffer, &msg);
+        for (i=0; i<mavlink_msg_get_send_buffer_length(&msg); i++) {
+        	comm_send_ch(MAVLINK_COMM_0, buffer[i]);
+        }
+	mavlink_msg_thermal_target_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+        
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_thermal_target_send(MAVLINK_COMM_1 , packet1.time , packet1.heading , packet1.elevation , packet1.peak , packet1.pixels );
+	mavlink_msg_thermal_target_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+}
+
+static void mavlink_test_xbee_status(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
+{
+	mavlink_message_t msg;
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t i;
+	mavlink_xbee_status_t packet_in = {
+		963497464,
+	963497516,
+	963497568,
+	963497620,
+	963497672,
+	17495,
+	23,
+	};
+	mavlink_xbee_status_t packet1, packet2;
+        memset(&packet1, 0, sizeof(packet1));
+        	packet1.tx_acked = packet_in.tx_acked;
+        	packet1.tx_failed = packet_in.tx_failed;
+        	packet1.rx_packets = packet_in.rx_packets;
+        	packet1.rx_errors = packet_in.rx_errors;
+        	packet1.telemetry_decimated = packet_in.telemetry_decimated;
+        	packet1.telemetry_rate = packet_in.telemetry_rate;
+        	packet1.rssi = packet_in.rssi;
+        
+        
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_xbee_status_encode(system_id, component_id, &msg, &packet1);
+	mavlink_msg_xbee_status_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_xbee_status_pack(system_id, component_id, &msg , packet1.rssi , packet1.tx_acked , packet1.tx_failed , packet1.rx_packets , packet1.rx_errors , packet1.telemetry_rate , packet1.telemetry_decimated );
+	mavlink_msg_xbee_status_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_xbee_status_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.rssi , packet1.tx_acked , packet1.tx_failed , packet1.rx_packets , packet1.rx_errors , packet1.telemetry_rate , packet1.telemetry_decimated );
+	mavlink_msg_xbee_status_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+        mavlink_msg_to_send_buffer(buffer, &msg);
+        for (i=0; i<mavlink_msg_get_send_buffer_length(&msg); i++) {
+        	comm_send_ch(MAVLINK_COMM_0, buffer[i]);
+        }
+	mavlink_msg_xbee_status_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+        
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_xbee_status_send(MAVLINK_COMM_1 , packet1.rssi , packet1.tx_acked , packet1.tx_failed , packet1.rx_packets , packet1.rx_errors , packet1.telemetry_rate , packet1.telemetry_decimated );
+	mavlink_msg_xbee_status_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+}
+
+static void mavlink_test_start_rescue_int(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
+{
+	mavlink_message_t msg;
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t i;
+	mavlink_start_rescue_int_t packet_in = {
+		963497464,
+	963497516,
+	139,
+	206,
+	};
+	mavlink_start_rescue_int_t packet1, packet2;
+        memset(&packet1, 0, sizeof(packet1));
+        	packet1.latitude = packet_in.latitude;
+        	packet1.longitude = packet_in.longitude;
+        	packet1.ack = packet_in.ack;
+        	packet1.status = packet_in.status;
+        
+        
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_start_rescue_int_encode(system_id, component_id, &msg, &packet1);
+	mavlink_msg_start_rescue_int_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_start_rescue_int_pack(system_id, component_id, &msg , packet1.ack , packet1.status , packet1.latitude , packet1.longitude );
+	mavlink_msg_start_rescue_int_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_start_rescue_int_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.ack , packet1.status , packet1.latitude , packet1.longitude );
+	mavlink_msg_start_rescue_int_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+        mavlink_msg_to_send_buffer(buffer, &msg);
+        for (i=0; i<mavlink_msg_get_send_buffer_length(&msg); i++) {
+        	comm_send_ch(MAVLINK_COMM_0, buffer[i]);
+        }
+	mavlink_msg_start_rescue_int_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+        
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_start_rescue_int_send(MAVLINK_COMM_1 , packet1.ack , packet1.status , packet1.latitude , packet1.longitude );
+	mavlink_msg_start_rescue_int_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+}
+
+static void mavlink_test_error_event(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
+{
+	mavlink_message_t msg;
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t i;
+	mavlink_error_event_t packet_in = {
+		963497464,
+	17287,
+	17339,
+	206,
+	17,
+	};
+	mavlink_error_event_t packet1, packet2;
+        memset(&packet1, 0, sizeof(packet1));
+        	packet1.time = packet_in.time;
+        	packet1.arg = packet_in.arg;
+        	packet1.dropped = packet_in.dropped;
+        	packet1.module = packet_in.module;
+        	packet1.code = packet_in.code;
+        
+        
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_error_event_encode(system_id, component_id, &msg, &packet1);
+	mavlink_msg_error_event_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_error_event_pack(system_id, component_id, &msg , packet1.time , packet1.module , packet1.code , packet1.arg , packet1.dropped );
+	mavlink_msg_error_event_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_error_event_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.time , packet1.module , packet1.code , packet1.arg , packet1.dropped );
+	mavlink_msg_error_event_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+        mavlink_msg_to_send_buffer(buffer, &msg);
+        for (i=0; i<mavlink_msg_get_send_buffer_length(&msg); i++) {
+        	comm_send_ch(MAVLINK_COMM_0, buffer[i]);
+        }
+	mavlink_msg_error_event_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+        
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_error_event_send(MAVLINK_COMM_1 , packet1.time , packet1.module , packet1.code , packet1.arg , packet1.dropped );
+	mavlink_msg_error_event_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+}
+
 static void mavlink_test_autoLifeguard(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
 {
 	mavlink_test_test_data(system_id, component_id, last_msg);
@@ -302,6 +738,14 @@ static void mavlink_test_autoLifeguard(uint8_t system_id, uint8_t component_id,
 	mavlink_test_gps_error(system_id, component_id, last_msg);
 	mavlink_test_start_rescue(system_id, component_id, last_msg);
 	mavlink_test_stop_rescue(system_id, component_id, last_msg);
+	mavlink_test_uart_status(system_id, component_id, last_msg);
+	mavlink_test_thermal_frame(system_id, component_id, last_msg);
+	mavlink_test_boat_position(system_id, component_id, last_msg);
+	mavlink_test_battery(system_id, component_id, last_msg);
+	mavlink_test_thermal_target(system_id, component_id, last_msg);
+	mavlink_test_xbee_status(system_id, component_id, last_msg);
+	mavlink_test_start_rescue_int(system_id, component_id, last_msg);
+	mavlink_test_error_event(system_id, component_id, last_msg);
 }
 
 #ifdef __cplusplus
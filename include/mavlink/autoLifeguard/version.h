@@ -5,8 +5,8 @@
 #ifndef MAVLINK_VERSION_H
 #define MAVLINK_VERSION_H
 
-#define MAVLINK_BUILD_DATE "Sun Mar 10 14:52:54 2013"
+#define MAVLINK_BUILD_DATE "Wed Oct 14 06:14:18 2026"
 #define MAVLINK_WIRE_PROTOCOL_VERSION "1.0"
-#define MAVLINK_MAX_DIALECT_PAYLOAD_SIZE 10
+#define MAVLINK_MAX_DIALECT_PAYLOAD_SIZE 90
  
 #endif // MAVLINK_VERSION_H
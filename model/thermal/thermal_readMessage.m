@@ -1,23 +1,29 @@
 function [pixels] = thermal_readMessage(serial_obj,use_hex_str)
 % [pixels] = thermal_readMessage(serial_obj,use_hex_str)
 %
-% Reads a message from the Thermal device and returns a pixel matrix
-%   containing temperatures.
+% Reads THERMAL_FRAME MAVLink messages from the Thermal device until a
+%   whole frame has been rebuilt, and returns a pixel matrix containing
+%   temperatures.
 %
 % Arguments:
 %   serial_obj: a serial object
-%   use_hex_str: returns packet data as hex string when set
+%   use_hex_str: returns the centi-degrees as hex strings when set
 %
-%   St St St St ....
-%   C0 C1 C2 C3 C4 C5 C6 C7 .........   C16
+% Each frame comes as one or more messages (id 244), packed as described
+%   in include/ThermalFrame.h: centi-degrees, each pixel as a zigzag
+%   varint difference with a flag bit, or a run of unchanged pixels.
+%   Keyframes predict from the pixel before in the same frame, the others
+%   from the last frame, so after a lost one nothing comes back until the
+%   next keyframe.
+%
+%      C0 C1 C2 C3 C4 C5 C6 C7 .........   C16
 % R0  
 % R1
 % R2
 % R3
-%   En En En En.... 
 %
 % Returns:
-%   a cell array containing ubx packet data
+%   a 4x16 matrix of degrees F
 %
 
 DEBUG = 0;
@@ -32,50 +38,95 @@ end
 
 TOTAL_PIXEL_ROWS =  4;
 TOTAL_PIXEL_COLS =  16;
-START_INT = hex2dec('FFFF1234'); %start sequence everytime we are ready to read next column
-END_COL_INT = hex2dec('FFFFAAAA'); %finish sending 4 pieces of information down each column
+TOTAL_PIXELS = TOTAL_PIXEL_ROWS * TOTAL_PIXEL_COLS;
 
+MAVLINK_STX = 254;
+THERMAL_FRAME_ID = 244;
+THERMAL_FRAME_LEN = 90;
+THERMAL_FRAME_CRC_EXTRA = 156;
+KEYFRAME_FLAG = 1;
 
-i = 0; j = 0;
-if ~use_hex_str
-    pixels = zeros(TOTAL_PIXEL_ROWS,TOTAL_PIXEL_COLS); %pre-allocate the row by column 
-else
-    pixels = {};
+% Kept between calls, frames build on the one before
+persistent previous synced lastFrame packed packedFrame nextChunk
+if isempty(previous)
+    previous = zeros(TOTAL_PIXELS,1);
+    synced = 0;
+    lastFrame = -1;
+    packed = [];
+    packedFrame = -1;
+    nextChunk = 0;
 end
 
-c = 0;
 while 1
-     % Wait for the start int
-     c = fread(serial_obj,1,'uint32');
-     while (c ~= START_INT)
-         disp(sprintf('%X != %X',c,START_INT));
-         c = fread(serial_obj,1,'uint32');
+     % Wait for the start of a message
+     c = fread(serial_obj,1,'uint8');
+     while (c ~= MAVLINK_STX)
+         c = fread(serial_obj,1,'uint8');
      end
-     if DEBUG
-     	disp(sprintf('Saw beginning of sequence.\n'));
+     % len, seq, sysid, compid, msgid
+     header = fread(serial_obj,5,'uint8');
+     if (header(1) ~= THERMAL_FRAME_LEN || header(5) ~= THERMAL_FRAME_ID)
+         continue;
      end
-     % Reading rows
-     for i=1:TOTAL_PIXEL_COLS
-         for j=1:TOTAL_PIXEL_ROWS
-             data = fread(serial_obj,1,'float');
-             if ~use_hex_str
-                pixels(j,i) = data;
-             else
-                 pixels{j,i} = sprintf('%X',data);
-             end
+     payload = fread(serial_obj,THERMAL_FRAME_LEN,'uint8');
+     crc = fread(serial_obj,2,'uint8');
+     if (x25([header; payload; THERMAL_FRAME_CRC_EXTRA]) ~= crc(1) + 256*crc(2))
+         if DEBUG
+             disp(sprintf('Bad checksum, dropped a chunk.\n'));
          end
-         % Look for row ending after reading whole row
-         if (fread(serial_obj,1,'uint32') ~= END_COL_INT)
-             if DEBUG
-                 disp(sprintf('Never saw col ending!\n'));
-             end
-             break;
+         continue;
+     end
+
+     frame = payload(5) + 256*payload(6);
+     flags = payload(7);
+     chunk = payload(8);
+     chunks = payload(9);
+     len = payload(10);
+     data = payload(11:10 + len);
+
+     % Put the chunks back together, a missing one drops the frame
+     if chunk == 0
+         packed = data;
+         packedFrame = frame;
+         nextChunk = 1;
+     elseif (frame == packedFrame && chunk == nextChunk)
+         packed = [packed; data];
+         nextChunk = nextChunk + 1;
+     else
+         nextChunk = 0;
+         continue;
+     end
+     if (nextChunk < chunks)
+         continue;
+     end
+     nextChunk = 0;
+
+     isKeyframe = bitand(flags, KEYFRAME_FLAG);
+     if (~isKeyframe && mod(lastFrame + 1, 65536) ~= frame)
+         synced = 0;
+     end
+     if (~isKeyframe && ~synced)
+         if DEBUG
+             disp(sprintf('Waiting for a keyframe.\n'));
          end
+         continue;
+     end
+
+     [values, ok] = decodeFrame(packed, previous, isKeyframe, TOTAL_PIXELS);
+     if ~ok
+         continue;
      end
-     % If we read a complete pixel matrix, then return
-     if (j == TOTAL_PIXEL_ROWS && i == TOTAL_PIXEL_COLS)
-         return;
+     previous = values;
+     synced = 1;
+     lastFrame = frame;
+
+     if ~use_hex_str
+         pixels = reshape(values / 100, TOTAL_PIXEL_ROWS, TOTAL_PIXEL_COLS);
+     else
+         pixels = reshape(arrayfun(@(v) sprintf('%X', mod(v, 65536)), values, ...
+             'UniformOutput', false), TOTAL_PIXEL_ROWS, TOTAL_PIXEL_COLS);
      end
+     return;
 end
 
 % Done 
@@ -83,4 +134,70 @@ end
 end % function
 
 
+function [values, ok] = decodeFrame(packed, previous, isKeyframe, total)
+% Rebuilds the centi-degrees of a frame, ok is 0 if it was malformed
+values = zeros(total,1);
+ok = 0;
+i = 0; k = 1; predicted = 0;
+while k <= length(packed)
+    % varint, 7 bits a byte low first
+    token = 0; shift = 0;
+    while 1
+        if k > length(packed)
+            return;
+        end
+        b = packed(k); k = k + 1;
+        token = token + bitand(b, 127) * 2^shift;
+        shift = shift + 7;
+        if b < 128
+            break;
+        end
+    end
+    if mod(token, 2)
+        % run of unchanged pixels
+        run = floor(token / 2) + 1;
+        if i + run > total
+            return;
+        end
+        for j = 1:run
+            i = i + 1;
+            if ~isKeyframe
+                predicted = previous(i);
+            end
+            values(i) = predicted;
+        end
+    else
+        z = floor(token / 2);
+        if mod(z, 2)
+            delta = -(z + 1) / 2;
+        else
+            delta = z / 2;
+        end
+        if i >= total
+            return;
+        end
+        i = i + 1;
+        if ~isKeyframe
+            predicted = previous(i);
+        end
+        predicted = predicted + delta;
+        values(i) = predicted;
+    end
+end
+ok = (i == total);
+
+end % function
 
+
+function [crc] = x25(bytes)
+% MAVLink checksum, CRC-16/MCRF4XX
+crc = 65535;
+for k = 1:length(bytes)
+    tmp = bitxor(bytes(k), bitand(crc, 255));
+    tmp = bitand(bitxor(tmp, bitshift(tmp, 4)), 255);
+    crc = bitxor(bitxor(bitxor(bitshift(crc, -8), bitshift(tmp, 8)), ...
+        bitshift(tmp, 3)), bitshift(tmp, -4));
+    crc = bitand(crc, 65535);
+end
+
+end % function
@@ -1,23 +0,0 @@
-/* 
- * File:   Thermal.h
- * Author: dagoodma
- *
- * Created on February 9, 2013, 10:35 PM
- */
-
-#ifndef THERMAL_H
-#define	THERMAL_H
-
-#ifdef	__cplusplus
-extern "C" {
-#endif
-
-
-
-
-#ifdef	__cplusplus
-}
-#endif
-
-#endif	/* THERMAL_H */
-
@@ -8,10 +8,12 @@
  */
 
 #include <xc.h>
+#include <stddef.h>
 #include "AD.h"
 
 #include <peripheral/adc10.h>
 #include <peripheral/ports.h>
+#include <peripheral/timer.h>
 #include <Board.h>
 
 
@@ -20,6 +22,8 @@
  ******************************************************************************/
 #define NUM_AD_PINS 13
 #define NUM_AD_PINS_UNO 16
+#define AD_RING_MASK (AD_RING_LENGTH - 1)
+#define AD_CAPTURE_HALF 8 // samples in each half of the alternating buffer
 
 
 /*******************************************************************************
@@ -43,7 +47,29 @@ static unsigned int AD1PCFG_POS[NUM_AD_PINS] = {_AD1PCFG_PCFG2_POSITION, _AD1PCF
 static unsigned int UsedPins;
 static unsigned int PinCount;
 static unsigned int ADValues[NUM_AD_PINS];
-static int PortMapping[NUM_AD_PINS];
+static int PortMapping[NUM_AD_PINS]; // pin's bit number to its slot in the scan
+
+// Last AD_RING_LENGTH scans, by slot, with a running sum of each ring
+static volatile unsigned short ADRing[NUM_AD_PINS][AD_RING_LENGTH];
+static volatile unsigned int ADSums[NUM_AD_PINS];
+static volatile unsigned int ADTimes[AD_RING_LENGTH]; // core timer at each scan
+static volatile unsigned int ScanCount;
+
+// Scan settings from AD_init, to go back to after a capture
+static unsigned int ScanPcfg;
+static unsigned int ScanCssl;
+
+// Capture of one pin off Timer3, see AD_startCapture
+static volatile unsigned short *CaptureBuffer;
+static volatile unsigned int CaptureLength;
+static volatile unsigned int CaptureCount;
+static volatile unsigned char Capturing = FALSE;
+
+/*******************************************************************************
+ * PRIVATE FUNCTION PROTOTYPES                                                 *
+ ******************************************************************************/
+static int getSlot(unsigned int Pin);
+static void openScan(void);
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                           *
@@ -77,6 +103,14 @@ unsigned char AD_init(unsigned int Pins) {
     if ((Pins == 0) || (Pins > 0x1FFF)) {
         return ERROR;
     }
+    PinCount = 0;
+    ScanCount = 0;
+    for (CurPin = 0; CurPin < NUM_AD_PINS; CurPin++) {
+        ADSums[CurPin] = 0;
+        for (PinCount2 = 0; PinCount2 < AD_RING_LENGTH; PinCount2++)
+            ADRing[CurPin][PinCount2] = 0;
+    }
+    PinCount2 = 0;
     for (CurPin = 0; CurPin < NUM_AD_PINS_UNO; CurPin++) {
         ADMapping[CurPin] = -1;
     }
@@ -96,15 +130,81 @@ unsigned char AD_init(unsigned int Pins) {
         }
     }
     UsedPins = Pins;
-    cssl = ~cssl;
-    OpenADC10(ADC_MODULE_ON | ADC_FORMAT_INTG | ADC_CLK_AUTO | ADC_AUTO_SAMPLING_ON, ADC_VREF_AVDD_AVSS
-            | ADC_SCAN_ON | ((PinCount - 1) << _AD1CON2_SMPI_POSITION) | ADC_BUF_16, ADC_SAMPLE_TIME_31 | ADC_CONV_CLK_32Tcy | ADC_CONV_CLK_PB, pcfg, cssl);
-    ConfigIntADC10(ADC_INT_ON | ADC_INT_PRI_1 | ADC_INT_SUB_PRI_3);
+    ScanPcfg = pcfg;
+    ScanCssl = ~cssl;
+    Capturing = FALSE;
+    openScan();
+    return SUCCESS;
+}
+
+/****************************************************************************
+ Function
+     AD_startCapture
 
+ Parameters
+    Pin, used #defined AD_PORTxxx to select pin
+    Rate, samples a second
+    Buffer, where to put the samples
+    Length, how many, a multiple of 8
+
+ Returns
+     SUCCESS or ERROR
+
+ Description
+    Samples one pin at a fixed rate into a buffer, then goes back to
+    scanning.
+ Notes
+    Timer3 triggers each conversion, so the spacing is exact whatever the
+    main loop is doing. The converter fills one half of its buffer while
+    the interrupt copies the other, 8 samples an interrupt. The scan and
+    its rings stop while it runs.
+
+ ****************************************************************************/
+unsigned char AD_startCapture(unsigned int Pin, unsigned int Rate,
+        unsigned short *Buffer, unsigned int Length) {
+    int Slot = getSlot(Pin);
+    if (Slot < 0 || Capturing || Rate < AD_CAPTURE_RATE_MIN
+            || Rate > AD_CAPTURE_RATE_MAX || Length == 0
+            || (Length % AD_CAPTURE_HALF) != 0) {
+        return ERROR;
+    }
+    mAD1IntEnable(0);
+    CloseADC10();
+    CaptureBuffer = Buffer;
+    CaptureLength = Length;
+    CaptureCount = 0;
+    Capturing = TRUE;
+
+    SetChanADC10(ADC_CH0_NEG_SAMPLEA_NVREF
+        | (AD1PCFG_POS[__builtin_ctz(Pin)] << _AD1CHS_CH0SA_POSITION));
+    OpenADC10(ADC_MODULE_ON | ADC_FORMAT_INTG | ADC_CLK_TMR | ADC_AUTO_SAMPLING_ON, ADC_VREF_AVDD_AVSS
+            | ADC_SCAN_OFF | ((AD_CAPTURE_HALF - 1) << _AD1CON2_SMPI_POSITION) | ADC_ALT_BUF_ON, ADC_SAMPLE_TIME_2 | ADC_CONV_CLK_8Tcy | ADC_CONV_CLK_PB, ScanPcfg, SKIP_SCAN_ALL);
+    ConfigIntADC10(ADC_INT_ON | ADC_INT_PRI_1 | ADC_INT_SUB_PRI_3);
+    OpenTimer3(T3_ON | T3_PS_1_1, Board_GetPBClock() / Rate - 1);
     EnableADC10();
     return SUCCESS;
 }
 
+/****************************************************************************
+ Function
+     AD_isCapturing
+
+ Parameters
+    None
+
+ Returns
+     TRUE while a capture runs
+
+ Description
+    The buffer is filled once this goes FALSE
+ Notes
+     None.
+
+ ****************************************************************************/
+unsigned char AD_isCapturing(void) {
+    return Capturing;
+}
+
 
 
 /****************************************************************************
@@ -118,9 +218,11 @@ unsigned char AD_init(unsigned int Pins) {
      None
 
  Description
-    Interrupt Handler for A/D. Reads all used pins into buffer.
+    Interrupt Handler for A/D. Reads all used pins into buffer, and into
+    the next place in their rings.
  Notes
-     None.
+     One interrupt a scan. A ring's sum takes off the sample it overwrites,
+     the rings start at zero, so it's right from the first scan.
 
  Author
  Max Dunne, 2011.12.10
@@ -128,9 +230,29 @@ unsigned char AD_init(unsigned int Pins) {
 void __ISR(_ADC_VECTOR, ipl1) ADCIntHandler(void) {
     mAD1ClearIntFlag();
     unsigned char CurPin = 0;
-    for (CurPin = 0; CurPin <= PinCount; CurPin++) {
-        ADValues[CurPin] = ReadADC10(CurPin);
+    unsigned int next = ScanCount & AD_RING_MASK;
+    unsigned short value;
+    if (Capturing) {
+        // BUFS set means the converter is on the top half
+        next = ReadActiveBufferADC10()? 0 : AD_CAPTURE_HALF;
+        for (CurPin = 0; CurPin < AD_CAPTURE_HALF; CurPin++)
+            CaptureBuffer[CaptureCount++] = ReadADC10(next + CurPin);
+        if (CaptureCount >= CaptureLength) {
+            CloseTimer3();
+            CloseADC10();
+            Capturing = FALSE;
+            openScan();
+        }
+        return;
+    }
+    ADTimes[next] = _CP0_GET_COUNT();
+    for (CurPin = 0; CurPin < PinCount; CurPin++) {
+        value = ReadADC10(CurPin);
+        ADValues[CurPin] = value;
+        ADSums[CurPin] += value - ADRing[CurPin][next];
+        ADRing[CurPin][next] = value;
     }
+    ScanCount++;
 }
 
 
@@ -153,16 +275,130 @@ void __ISR(_ADC_VECTOR, ipl1) ADCIntHandler(void) {
  Max Dunne, 2011.12.10
  ****************************************************************************/
 unsigned int AD_readPin(unsigned int Pin) {
-    if (!(UsedPins & Pin)) {
+    int Slot = getSlot(Pin);
+    if (Slot < 0) {
+        return ERROR;
+    }
+    return ADValues[Slot];
+}
+
+/****************************************************************************
+ Function
+    AD_readBlock
+
+ Parameters
+    Pin, used #defined AD_PORTxxx to select pin
+    Samples, where to put them, oldest first
+    Times, where to put the core timer count of each, or NULL
+    Count, how many of the latest to read
+
+ Returns
+    Samples read, fewer than Count if there haven't been that many scans
+    or it's past AD_RING_LENGTH, or ERROR
+
+ Description
+    Copies the latest samples of a pin out of its ring
+ Notes
+    Holds off the A/D interrupt while it copies, so a scan can't land in
+    the middle of the block.
+
+ ****************************************************************************/
+unsigned int AD_readBlock(unsigned int Pin, unsigned short *Samples,
+        unsigned int *Times, unsigned int Count) {
+    int Slot = getSlot(Pin);
+    unsigned int i, first;
+    if (Slot < 0) {
         return ERROR;
     }
-    unsigned char TranslatedPin = 0;
-    while (Pin > 1) {
+    if (Count > AD_RING_LENGTH)
+        Count = AD_RING_LENGTH;
+    mAD1IntEnable(0);
+    if (Count > ScanCount)
+        Count = ScanCount;
+    first = ScanCount - Count;
+    for (i = 0; i < Count; i++) {
+        Samples[i] = ADRing[Slot][(first + i) & AD_RING_MASK];
+        if (Times != NULL)
+            Times[i] = ADTimes[(first + i) & AD_RING_MASK];
+    }
+    mAD1IntEnable(1);
+    return Count;
+}
+
+/****************************************************************************
+ Function
+    AD_readAverage
+
+ Parameters
+    Pin, used #defined AD_PORTxxx to select pin
+
+ Returns
+    10-bit mean of the pin's ring or ERROR
+
+ Description
+    Mean of the last AD_RING_LENGTH samples, or of all of them until there
+    have been that many
+ Notes
+    The sum is kept as the samples come in, so this doesn't loop.
 
-        Pin >>= 1;
-        TranslatedPin++;
+ ****************************************************************************/
+unsigned int AD_readAverage(unsigned int Pin) {
+    int Slot = getSlot(Pin);
+    unsigned int scans = ScanCount;
+    if (Slot < 0) {
+        return ERROR;
     }
-    return ADValues[PortMapping[TranslatedPin]];
+    if (scans == 0)
+        return ADValues[Slot];
+    if (scans > AD_RING_LENGTH)
+        scans = AD_RING_LENGTH;
+    return ADSums[Slot] / scans;
+}
+
+/****************************************************************************
+ Function
+    AD_readOversampled
+
+ Parameters
+    Pin, used #defined AD_PORTxxx to select pin
+
+ Returns
+    12-bit value of the pin or ERROR
+
+ Description
+    The ring's sum with two more bits than a sample, from oversampling by
+    AD_RING_LENGTH (16 samples give one bit each for every factor of 4)
+ Notes
+    Only worth the bits where there's enough noise to dither the samples,
+    and only right once the ring has filled.
+
+ ****************************************************************************/
+unsigned int AD_readOversampled(unsigned int Pin) {
+    int Slot = getSlot(Pin);
+    if (Slot < 0) {
+        return ERROR;
+    }
+    return ADSums[Slot] >> 2;
+}
+
+/****************************************************************************
+ Function
+    AD_getScanCount
+
+ Parameters
+    None
+
+ Returns
+    Scans since AD_init
+
+ Description
+    Changes when there are new samples
+ Notes
+    None.
+
+ ****************************************************************************/
+unsigned int AD_getScanCount(void) {
+    return ScanCount;
 }
 
 /****************************************************************************
@@ -184,12 +420,38 @@ unsigned int AD_readPin(unsigned int Pin) {
  Max Dunne, 2011.12.10
  ****************************************************************************/
 void AD_end(void) {
+    if (Capturing) {
+        CloseTimer3();
+        Capturing = FALSE;
+    }
     UsedPins = 0;
     PinCount = 0;
     CloseADC10();
     AD1PCFG = 0xFF;
 }
 
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                          *
+ ******************************************************************************/
+
+// Scans the pins from AD_init, one interrupt a scan
+static void openScan(void) {
+    OpenADC10(ADC_MODULE_ON | ADC_FORMAT_INTG | ADC_CLK_AUTO | ADC_AUTO_SAMPLING_ON, ADC_VREF_AVDD_AVSS
+            | ADC_SCAN_ON | ((PinCount - 1) << _AD1CON2_SMPI_POSITION) | ADC_BUF_16, ADC_SAMPLE_TIME_31 | ADC_CONV_CLK_32Tcy | ADC_CONV_CLK_PB, ScanPcfg, ScanCssl);
+    ConfigIntADC10(ADC_INT_ON | ADC_INT_PRI_1 | ADC_INT_SUB_PRI_3);
+
+    EnableADC10();
+}
+
+// Slot of a single used pin in the scan, or -1. The bit number comes from
+//  one count leading zeros instruction, not a loop.
+static int getSlot(unsigned int Pin) {
+    if (Pin == 0 || (Pin & (Pin - 1)) != 0 || !(UsedPins & Pin)) {
+        return -1;
+    }
+    return PortMapping[__builtin_ctz(Pin)];
+}
+
 
 
 //#define AD_TEST
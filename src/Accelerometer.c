@@ -13,22 +13,41 @@
 #include "Timer.h"
 #include "Board.h"
 #include "Accelerometer.h"
+#include "Boot.h"
 
 
 /***********************************************************************
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 #define SLAVE_ADDRESS           0x1D // 0x1D if SA0 is high, 0x1C if low
-#define SLAVE_WRITE_ADDRESS     0x3A//((SLAVE_ADDRESS << 1) + 0)
-#define SLAVE_READ_ADDRESS      0x3B//((SLAVE_ADDRESS << 1) + 1)
+#define SLAVE_CLOCK_FREQ        400000 // (Hz) fast mode
 
 // List of registers for accelerometer readings
+#define STATUS_ADDRESS          0x00 // F_STATUS in FIFO mode
 #define WHO_AM_I_ADDRESS        0x0D
 #define OUT_X_MSB_ADDRESS       0x01
+#define F_SETUP_ADDRESS         0x09 // MMA8451 only
 #define XYZ_DATA_CFG_ADDRESS    0x0E
 #define CTRL_REG1_ADDRESS       0x2A
+#define CTRL_REG4_ADDRESS       0x2D // interrupt enables
+#define CTRL_REG5_ADDRESS       0x2E // interrupt pin routing, 1 is INT1
 
 #define WHO_AM_I_VALUE          0x2A // WHO_AM_I_ADDRESS should always be 0x2A
+#define WHO_AM_I_FIFO_VALUE     0x1A // the MMA8451, same registers plus a FIFO
+
+// Register bits
+#define CTRL_REG1_ACTIVE        0x01
+#define CTRL_REG1_DR_SHIFT      3
+#define CTRL_REG1_DR_MASK       0x38
+#define INT_DRDY                0x01 // in CTRL_REG4 and CTRL_REG5
+#define INT_FIFO                0x40
+#define STATUS_ZYXDR            0x08
+#define F_STATUS_COUNT_MASK     0x3F
+#define F_SETUP_CIRCULAR        0x40
+
+#define SAMPLE_BYTES            6
+#define FIFO_LENGTH             32 // samples
+#define FILTER_FRACTION_BITS    8
 
 // Options
 #define GSCALE          2 // Sets full-scale range to +/-2, 4, or 8g. Used to calc real g values.
@@ -42,6 +61,18 @@
 #define ACCUMULATOR_LENGTH      2 // use a power of 2 and update shift too
 #define ACCUMULATOR_SHIFT       1 // 2^shift = length
 
+// Bring-up, see Accelerometer_initSM
+typedef enum {
+    INIT_START = 0,
+    INIT_IDENTIFY,      // reading WHO_AM_I
+    INIT_READ_CTRL,     // reading CTRL_REG1
+    INIT_STANDBY,       // clearing the active bit
+    INIT_RANGE,         // setting the full scale range
+    INIT_ACTIVE,        // setting the active bit again
+    INIT_DONE,
+    INIT_FAILED,
+} InitState;
+
 /***********************************************************************
  * PRIVATE VARIABLES                                                   *
  ***********************************************************************/
@@ -58,6 +89,26 @@ struct {
 
 uint8_t accumulatorIndex = 0;
 
+// Streaming, see Accelerometer_startStream
+BOOL hasFifo = FALSE;
+BOOL isStreaming = FALSE;
+volatile BOOL isReady = FALSE;
+AccelerometerReadyHandler readyHandler = NULL;
+uint8_t filterShift = 0;
+BOOL isFilterPrimed = FALSE;
+struct {
+    int32_t x, y, z;
+} gFilter; // (counts << FILTER_FRACTION_BITS)
+uint32_t sampleCount = 0;
+uint8_t streamData[1 + FIFO_LENGTH * SAMPLE_BYTES];
+
+// Bring-up, one queued transfer at a time
+InitState initState = INIT_START;
+I2CTransfer initTransfer;
+uint8_t initCommand[2]; // register, then the byte to write
+uint8_t initReply;
+uint8_t initCtrl; // CTRL_REG1 as it was read
+
 
 
 /***********************************************************************
@@ -71,43 +122,102 @@ int16_t readRegister( uint8_t address);
 int16_t readRegisters( uint8_t address, uint16_t bytesToRead, uint8_t *dest );
 int16_t writeRegister( uint8_t address, uint8_t data );
 void resetAccumulator();
+int16_t toCounts(const uint8_t *data);
+void filterSample(const uint8_t *data);
+char submitInit(uint8_t address, int16_t data);
 
 /***********************************************************************
  * PUBLIC FUNCTIONS                                                    *
  ***********************************************************************/
 
 char Accelerometer_init() {
-    int16_t c = readRegister(WHO_AM_I_ADDRESS);  // Read WHO_AM_I register
-    if (c == WHO_AM_I_VALUE) //c != ERROR ||
-    {
+    BootStatus status;
+    initState = INIT_START;
+    while ((status = Accelerometer_initSM()) == BOOT_PENDING)
+        ;
+    return (status == BOOT_READY)? SUCCESS : FAILURE;
+}
+
+BootStatus Accelerometer_initSM() {
+    char fsr;
+
+    if (initState == INIT_DONE)
+        return BOOT_READY;
+    if (initState == INIT_FAILED)
+        return BOOT_FAILED;
+
+    if (initState != INIT_START) {
+        // Every other state waits on the transfer it started
+        if (!I2C_IS_FINISHED(initTransfer.status))
+            return BOOT_PENDING;
+        if (initTransfer.status != I2C_TRANSFER_DONE) {
 #ifdef DEBUG
-        //printf("Accelerometer is online...\n");
+            printf("Failed to set up the accelerometer at 0x%X.\n",
+                initCommand[0]);
 #endif
+            initState = INIT_FAILED;
+            return BOOT_FAILED;
+        }
     }
-    else
-    {
+
+    switch (initState) {
+        case INIT_START:
+            I2C_addDevice(I2C_ID, SLAVE_ADDRESS, SLAVE_CLOCK_FREQ);
+            initState = INIT_IDENTIFY;
+            if (submitInit(WHO_AM_I_ADDRESS, ERROR) != SUCCESS)
+                initState = INIT_FAILED;
+            break;
+        case INIT_IDENTIFY:
+            hasFifo = (initReply == WHO_AM_I_FIFO_VALUE);
+            if (initReply != WHO_AM_I_VALUE && !hasFifo) {
 #ifdef DEBUG
-        printf("Could not connect to Accelerometer: 0x%X\n",c);
+                printf("Could not connect to Accelerometer: 0x%X\n",
+                    initReply);
 #endif
-        return FAILURE;
-    }
-
-    setStandbyMode(); // Must be in standby to change registers
-
-    // Set up the full scale range to 2, 4, or 8g.
-    char fsr = GSCALE;
-    if(fsr > 8) fsr = 8; // Limit G-Scale
-    fsr >>= 2; // 00 = 2G, 01 = 4A, 10 = 8G (pg. 20)
-    writeRegister(XYZ_DATA_CFG_ADDRESS, fsr);
-
-    setActiveMode();
-    Timer_new(TIMER_ACCELEROMETER, UPDATE_DELAY);
-
+                initState = INIT_FAILED;
+                break;
+            }
+            initState = INIT_READ_CTRL;
+            if (submitInit(CTRL_REG1_ADDRESS, ERROR) != SUCCESS)
+                initState = INIT_FAILED;
+            break;
+        case INIT_READ_CTRL:
+            // Must be in standby to change registers
+            initCtrl = initReply;
+            initState = INIT_STANDBY;
+            if (submitInit(CTRL_REG1_ADDRESS, initCtrl & ~CTRL_REG1_ACTIVE)
+                    != SUCCESS)
+                initState = INIT_FAILED;
+            break;
+        case INIT_STANDBY:
+            // Set up the full scale range to 2, 4, or 8g.
+            fsr = GSCALE;
+            if(fsr > 8) fsr = 8; // Limit G-Scale
+            fsr >>= 2; // 00 = 2G, 01 = 4A, 10 = 8G (pg. 20)
+            initState = INIT_RANGE;
+            if (submitInit(XYZ_DATA_CFG_ADDRESS, fsr) != SUCCESS)
+                initState = INIT_FAILED;
+            break;
+        case INIT_RANGE:
+            initState = INIT_ACTIVE;
+            if (submitInit(CTRL_REG1_ADDRESS, initCtrl | CTRL_REG1_ACTIVE)
+                    != SUCCESS)
+                initState = INIT_FAILED;
+            break;
+        case INIT_ACTIVE:
+            Timer_new(TIMER_ACCELEROMETER, UPDATE_DELAY);
 #ifdef USE_ACCUMULATOR
-    resetAccumulator();
+            resetAccumulator();
 #endif
+            initState = INIT_DONE;
+            break;
+        default:
+            break;
+    }
 
-    return SUCCESS;
+    if (initState == INIT_DONE)
+        return BOOT_READY;
+    return (initState == INIT_FAILED)? BOOT_FAILED : BOOT_PENDING;
 }
 
 int16_t Accelerometer_getX(){
@@ -130,6 +240,100 @@ void Accelerometer_runSM() {
     }
 }
 
+void Accelerometer_update() {
+    updateReadings();
+}
+
+char Accelerometer_startStream(AccelerometerRate rate, uint8_t shift) {
+    char ctrl;
+    if (rate > ACCELEROMETER_RATE_1_56HZ || shift > ACCELEROMETER_FILTER_MAX)
+        return FAILURE;
+
+    setStandbyMode();
+    ctrl = readRegister(CTRL_REG1_ADDRESS);
+    ctrl = (ctrl & ~CTRL_REG1_DR_MASK) | (rate << CTRL_REG1_DR_SHIFT);
+    if (writeRegister(CTRL_REG1_ADDRESS, ctrl) != SUCCESS)
+        return FAILURE;
+    if (hasFifo) {
+        // Circular, interrupting at the watermark
+        writeRegister(F_SETUP_ADDRESS, F_SETUP_CIRCULAR
+            | ACCELEROMETER_FIFO_WATERMARK);
+        writeRegister(CTRL_REG4_ADDRESS, INT_FIFO);
+        writeRegister(CTRL_REG5_ADDRESS, INT_FIFO);
+    }
+    else {
+        writeRegister(CTRL_REG4_ADDRESS, INT_DRDY);
+        writeRegister(CTRL_REG5_ADDRESS, INT_DRDY);
+    }
+
+    filterShift = shift;
+    isFilterPrimed = FALSE;
+    sampleCount = 0;
+    isStreaming = TRUE;
+
+    // The pin is active low, and stays low until the data is read
+    INTCONCLR = _INTCON_INT1EP_MASK;
+    INTSetVectorPriority(INT_EXTERNAL_1_VECTOR, INT_PRIORITY_LEVEL_2);
+    INTClearFlag(INT_INT1);
+    INTEnable(INT_INT1, INT_ENABLED);
+    setActiveMode();
+    // In case it fell before the edge was armed, the first drain clears it
+    isReady = TRUE;
+    return SUCCESS;
+}
+
+void Accelerometer_setReadyHandler(AccelerometerReadyHandler handler) {
+    readyHandler = handler;
+}
+
+BOOL Accelerometer_isReady() {
+    return isReady;
+}
+
+uint8_t Accelerometer_drain() {
+    uint8_t count, i;
+    if (!isStreaming)
+        return 0;
+    isReady = FALSE;
+
+    if (hasFifo) {
+        // The count, then that many samples from the same burst address
+        if (readRegisters(STATUS_ADDRESS, 1, streamData) != SUCCESS)
+            return 0;
+        count = streamData[0] & F_STATUS_COUNT_MASK;
+        if (count == 0 || readRegisters(OUT_X_MSB_ADDRESS,
+                count * SAMPLE_BYTES, &streamData[1]) != SUCCESS)
+            return 0;
+    }
+    else {
+        // Status and the sample in one burst
+        if (readRegisters(STATUS_ADDRESS, 1 + SAMPLE_BYTES, streamData)
+                != SUCCESS)
+            return 0;
+        count = (streamData[0] & STATUS_ZYXDR)? 1 : 0;
+    }
+
+    for (i = 0; i < count; i++)
+        filterSample(&streamData[1 + i * SAMPLE_BYTES]);
+    sampleCount += count;
+    return count;
+}
+
+uint32_t Accelerometer_getSampleCount() {
+    return sampleCount;
+}
+
+BOOL Accelerometer_hasFifo() {
+    return hasFifo;
+}
+
+void __ISR(_EXTERNAL_1_VECTOR, ipl2) IntAccelerometerHandler(void) {
+    INTClearFlag(INT_INT1);
+    isReady = TRUE;
+    if (readyHandler != NULL)
+        readyHandler();
+}
+
 
 /*******************************************************************************
  * PRIVATE FUNCTIONS                                                          *
@@ -202,6 +406,72 @@ void updateReadings() {
 
 
 
+/**
+ * Function: toCounts
+ * @param MSB and LSB of one axis.
+ * @return The axis in counts, 1024 to a G at +/-2G.
+ * @remark Both parts left align their samples, so dropping the low four
+ *  bits gives the same scale from the MMA8451's 14 bits as the MMA8452's 12.
+ * @date 2026.10.14  */
+int16_t toCounts(const uint8_t *data) {
+    return (int16_t)(((uint16_t)data[0] << 8) | data[1]) >> 4;
+}
+
+/**
+ * Function: filterSample
+ * @param Six bytes of one x, y, z sample.
+ * @return None
+ * @remark Runs the sample through the low-pass and updates the readings.
+ *  The first sample after starting sets the filter.
+ * @date 2026.10.14  */
+void filterSample(const uint8_t *data) {
+    int32_t x = (int32_t)toCounts(&data[0]) << FILTER_FRACTION_BITS;
+    int32_t y = (int32_t)toCounts(&data[2]) << FILTER_FRACTION_BITS;
+    int32_t z = (int32_t)toCounts(&data[4]) << FILTER_FRACTION_BITS;
+
+    if (!isFilterPrimed) {
+        gFilter.x = x;
+        gFilter.y = y;
+        gFilter.z = z;
+        isFilterPrimed = TRUE;
+    }
+    else {
+        gFilter.x += (x - gFilter.x) >> filterShift;
+        gFilter.y += (y - gFilter.y) >> filterShift;
+        gFilter.z += (z - gFilter.z) >> filterShift;
+    }
+    gCount.x = (uint16_t)(gFilter.x >> FILTER_FRACTION_BITS);
+    gCount.y = (uint16_t)(gFilter.y >> FILTER_FRACTION_BITS);
+    gCount.z = (uint16_t)(gFilter.z >> FILTER_FRACTION_BITS);
+}
+
+/**
+ * Function: submitInit
+ * @param Register address.
+ * @param Byte to write to it, or ERROR to read a byte into initReply.
+ * @return SUCCESS or FAILURE if the transfer couldn't be queued.
+ * @remark Queues the one transfer of a bring-up step.
+ * @date 2026.10.14  */
+char submitInit(uint8_t address, int16_t data) {
+    initCommand[0] = address;
+    initTransfer.address = SLAVE_ADDRESS;
+    initTransfer.write = initCommand;
+    if (data == ERROR) {
+        initTransfer.writeLength = 1;
+        initTransfer.read = &initReply;
+        initTransfer.readLength = 1;
+    }
+    else {
+        initCommand[1] = (uint8_t)data;
+        initTransfer.writeLength = 2;
+        initTransfer.read = NULL;
+        initTransfer.readLength = 0;
+    }
+    initTransfer.callback = NULL;
+    initTransfer.context = NULL;
+    return I2C_submit(I2C_ID, &initTransfer);
+}
+
 /**
  * Function: resetAccumulator
  * @return None
@@ -247,35 +517,10 @@ void setStandbyMode() {
  * @author David Goodman
  * @date 2013.01.22  */
 int16_t readRegister( uint8_t address ) {
-    int8_t data = 0, success = FALSE;
-
-    do {
-        // Send the start bit with the restart flag low
-        if(!I2C_startTransfer(I2C_ID, I2C_WRITE )) {
-            return ERROR;
-        }
-        // Transmit the slave's address to notify it
-        if (!I2C_sendData(I2C_ID, SLAVE_WRITE_ADDRESS))
-            break;
-        // Transmit the read address
-        if(!I2C_sendData(I2C_ID,address))
-            break;
-        // Send a Repeated Started condition
-        if(!I2C_startTransfer(I2C_ID,I2C_READ))
-            break;
-        // Transmit the address with the READ bit set
-        if (!I2C_sendData(I2C_ID, SLAVE_READ_ADDRESS))
-            break;
-
-        // Read the I2C bus 
-        data = I2C_getData(I2C_ID);
+    uint8_t data;
 
-        success = TRUE;
-    } while(0);
-
-    // Send the stop bit to finidh the transfer
-    I2C_stopTransfer(I2C_ID);
-    if(!success){
+    if (I2C_readRegisters(I2C_ID, SLAVE_ADDRESS, address, &data, 1)
+            != SUCCESS) {
 #ifdef DEBUG
         printf("Failed to read register 0x%X.\n", address);
 #endif
@@ -294,47 +539,8 @@ int16_t readRegister( uint8_t address ) {
  * @author David Goodman
  * @date 2013.01.22  */
 int16_t readRegisters( uint8_t address, uint16_t bytesToRead, uint8_t *dest ) {
-    int8_t success = FALSE;
-
-    do {
-        // Send the start bit with the restart flag low
-        if(!I2C_startTransfer(I2C_ID, I2C_WRITE))
-            return ERROR;
-        // Transmit the slave's address to notify it
-        if (!I2C_sendData(I2C_ID, SLAVE_WRITE_ADDRESS))
-            break;
-        // Transmit the read address
-        if(!I2C_sendData(I2C_ID,address))
-            break;
-        // Send a Repeated Started condition
-        if(!I2C_startTransfer(I2C_ID,I2C_READ))
-            break;
-        // Transmit the address with the READ bit set
-        if (!I2C_sendData(I2C_ID, SLAVE_READ_ADDRESS))
-            break;
-
-        int i;
-        // Read the I2C bus and send an acknowledge bit each time
-        for(
-
-                i = 0 ; i < bytesToRead ; i++) {
-            dest[i] = I2C_getData(I2C_ID);
-
-            // Only send and wait for Ack if there's more to read
-            if (i < (bytesToRead - 1)) {
-                I2CAcknowledgeByte(I2C1, TRUE);
-                //I2C_acknowledgeRead(I2C1, I2C_ACK);
-
-                //while(!I2C_hasAcknowledged(I2C_ID));
-                while(!I2CAcknowledgeHasCompleted(I2C_ID));
-            }
-        }
-        success = TRUE;
-    } while(0);
-
-    // Send the stop bit to finidh the transfer
-    I2C_stopTransfer(I2C_ID);
-    if(!success){
+    if (I2C_readRegisters(I2C_ID, SLAVE_ADDRESS, address, dest, bytesToRead)
+            != SUCCESS) {
 #ifdef DEBUG
         printf("Failed to read registers 0x%X.\n", address);
 #endif
@@ -351,34 +557,14 @@ int16_t readRegisters( uint8_t address, uint16_t bytesToRead, uint8_t *dest ) {
  * @author David Goodman
  * @date 2013.01.22  */
 int16_t writeRegister( uint8_t address, uint8_t data ) {
-    int8_t  success = FALSE;
-
-// Send the start bit with the restart flag low
-    do {
-        if(!I2C_startTransfer(I2C_ID, I2C_WRITE))
-            return ERROR;
-    // Transmit the slave's address to notify it
-        if (!I2C_sendData(I2C_ID, SLAVE_WRITE_ADDRESS))
-            break;
-    // Tranmit the write address
-        if(!I2C_sendData(I2C_ID,address))
-            break;
-    // Transmit the data to write
-        if(!I2C_sendData(I2C_ID,data))
-            break;
-
-        success = TRUE;
-    } while(FALSE);
-
-    // Send the stop bit to finidh the transfer
-    I2C_stopTransfer(I2C_ID);
-    if(!success){
+    if (I2C_writeRegisters(I2C_ID, SLAVE_ADDRESS, address, &data, 1)
+            != SUCCESS) {
 #ifdef DEBUG
         printf("Failed to write to register 0x%X.\n", address);
 #endif
         return ERROR;
     }
-    return success;
+    return SUCCESS;
 }
 
 
@@ -428,6 +614,49 @@ int main(void) {
 
 #endif
 
+//#define ACCELEROMETER_STREAM_TEST
+#ifdef ACCELEROMETER_STREAM_TEST
+
+#define I2C_CLOCK_FREQ  400000 // (Hz)
+#define PRINT_DELAY     1000 // (ms)
+
+int main(void) {
+    uint32_t lastCount = 0;
+
+    Board_init();
+    Timer_init();
+    Serial_init();
+    I2C_init(I2C_ID, I2C_CLOCK_FREQ);
+
+    if (Accelerometer_init() != SUCCESS
+            || Accelerometer_startStream(ACCELEROMETER_RATE_800HZ, 3)
+            != SUCCESS) {
+        printf("Failed to start the accelerometer.\n");
+        return FAILURE;
+    }
+    printf("Streaming at 800 Hz, %s FIFO.\n",
+        Accelerometer_hasFifo()? "with" : "without");
+    Timer_new(TIMER_TEST, PRINT_DELAY);
+
+    while(1){
+        if (Accelerometer_isReady())
+            Accelerometer_drain();
+        if (Timer_isExpired(TIMER_TEST)) {
+            // Should be close to 800 samples a second
+            printf("%lu samples/s, x=%d, y=%d, z=%d\n",
+                (unsigned long)(Accelerometer_getSampleCount() - lastCount),
+                Accelerometer_getX(), Accelerometer_getY(),
+                Accelerometer_getZ());
+            lastCount = Accelerometer_getSampleCount();
+            Timer_new(TIMER_TEST, PRINT_DELAY);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+#endif
+
 //#define CC_CALIBRATION_TEST
 #ifdef CC_CALIBRATION_TEST
 
@@ -0,0 +1,141 @@
+/**********************************************************************
+ Module
+   AngleFilter.c
+
+ Revision
+   1.0.0
+
+ Description
+   Moving window and low-pass circular means of binary angles.
+
+ Notes
+   The window keeps the angles rather than their vectors, half the
+   memory, and looks up the vector of the oldest again to take it off
+   the sums. The lookups are the same table ones both times, so the sums
+   never drift. A window of 255 Q15 vectors sums to under 2^23, well
+   inside an int32.
+
+   The low-pass keeps its vector with 8 extra fraction bits, so a weight
+   as small as 1/2^15 still moves it by at least a count. The vector can
+   only shrink toward the origin when the samples disagree, it never
+   has to be normalised, because atan2 only looks at the direction.
+
+***********************************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FastMath.h"
+#include "AngleFilter.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define LOWPASS_FRACTION_BITS   8
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+void AngleFilter_initWindow(AngleFilter *filter, uint16_t *storage,
+        uint8_t length) {
+    filter->angles = storage;
+    filter->length = (length == 0)? 1 : length;
+    filter->shift = 0;
+    AngleFilter_clear(filter);
+}
+
+void AngleFilter_initLowPass(AngleFilter *filter, uint8_t shift) {
+    filter->angles = NULL;
+    filter->length = 1;
+    filter->shift = (shift > ANGLEFILTER_SHIFT_MAX)?
+        ANGLEFILTER_SHIFT_MAX : shift;
+    AngleFilter_clear(filter);
+}
+
+void AngleFilter_clear(AngleFilter *filter) {
+    filter->next = 0;
+    filter->count = 0;
+    filter->sumSin = 0;
+    filter->sumCos = 0;
+}
+
+void AngleFilter_add(AngleFilter *filter, uint16_t angle) {
+    int32_t sine = FastMath_sinQ15(angle);
+    int32_t cosine = FastMath_cosQ15(angle);
+
+    if (filter->angles == NULL) {
+        sine <<= LOWPASS_FRACTION_BITS;
+        cosine <<= LOWPASS_FRACTION_BITS;
+        if (filter->count == 0) {
+            filter->sumSin = sine;
+            filter->sumCos = cosine;
+            filter->count = 1;
+        }
+        else {
+            filter->sumSin += (sine - filter->sumSin) >> filter->shift;
+            filter->sumCos += (cosine - filter->sumCos) >> filter->shift;
+        }
+        return;
+    }
+
+    if (filter->count == filter->length) {
+        uint16_t oldest = filter->angles[filter->next];
+        filter->sumSin -= FastMath_sinQ15(oldest);
+        filter->sumCos -= FastMath_cosQ15(oldest);
+    }
+    else {
+        filter->count++;
+    }
+    filter->angles[filter->next] = angle;
+    filter->sumSin += sine;
+    filter->sumCos += cosine;
+    if (++filter->next == filter->length)
+        filter->next = 0;
+}
+
+uint16_t AngleFilter_getMean(const AngleFilter *filter) {
+    return FastMath_atan2Angle16(filter->sumSin, filter->sumCos);
+}
+
+uint8_t AngleFilter_getCount(const AngleFilter *filter) {
+    return filter->count;
+}
+
+//#define ANGLEFILTER_TEST
+#ifdef ANGLEFILTER_TEST
+
+#include <stdio.h>
+#include "Board.h"
+#include "Serial.h"
+
+int main() {
+    uint16_t storage[8];
+    AngleFilter window, lowPass;
+    int i;
+
+    Board_init();
+    Serial_init();
+
+    // Noise of a few degrees either side of north
+    AngleFilter_initWindow(&window, storage, 8);
+    AngleFilter_initLowPass(&lowPass, 3);
+    for (i = 0; i < 40; i++) {
+        int16_t noise = ((i * 37) % 11 - 5) * DEGREES_TO_ANGLE16(1);
+        AngleFilter_add(&window, (uint16_t)noise);
+        AngleFilter_add(&lowPass, (uint16_t)noise);
+    }
+    printf("Window: %.2f, low-pass: %.2f (should be near 0 or 360)\n",
+        ANGLE16_TO_DEGREES(AngleFilter_getMean(&window)),
+        ANGLE16_TO_DEGREES(AngleFilter_getMean(&lowPass)));
+
+    AngleFilter_clear(&window);
+    AngleFilter_add(&window, DEGREES_TO_ANGLE16(359));
+    AngleFilter_add(&window, DEGREES_TO_ANGLE16(1));
+    printf("Mean of 359 and 1: %.2f (should be 0)\n",
+        ANGLE16_TO_DEGREES(AngleFilter_getMean(&window)));
+
+    return SUCCESS;
+}
+
+#endif
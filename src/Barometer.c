@@ -8,20 +8,20 @@
 #include <p32xxxx.h>
 #include <stdio.h>
 #include <plib.h>
-#include <math.h>
 #include "I2C.h"
 #include "Serial.h"
 #include "Timer.h"
 #include "Board.h"
 #include "Barometer.h"
+#include "Nvm.h"
 
 
 /***********************************************************************
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 // List of registers for barometer readings
-#define SLAVE_READ_ADDRESS          0xEF
-#define SLAVE_WRITE_ADDRESS         0xEE
+#define SLAVE_ADDRESS               0x77
+#define SLAVE_CLOCK_FREQ            400000 // (Hz) fast mode
 
 // Oversampling setting
 #define OSS                         3
@@ -29,14 +29,20 @@
 #define SENSOR_DATA_ADDRESS         0xF6
 
 #define TEMPERATURE_DATA_ADDRESS    0x2E
-#define PRESSURE_DATA_ADDRESS       0x34 + (OSS << 6)
+#define PRESSURE_DATA_ADDRESS       (0x34 + (OSS << 6))
+
+// No calibration word is ever 0 or 0xFFFF, a read that failed or a bus
+//  with nothing on it (page 13 in datasheet)
+#define IS_CALIBRATION_VALID(word)  ((word) != 0 && (uint16_t)(word) != 0xFFFF)
+#define CALIBRATION_WORDS           11
 
 
 // Delay for baro. ADC to sample sensor
 //  temp: 4.5 ms, pressure: 4.5, 7.5, 13.5 or 25.5 ms
 //  (pressure delay depends on OSS see page 18 in datasheet)
 #define UPDATE_DELAY    	100 // (ms)
-#define READ_SENSOR_DELAY	25 // (ms) pause for sampling of sensor
+#define TEMPERATURE_DELAY	5 // (ms) for the conversion to finish
+#define PRESSURE_DELAY  	26 // (ms)
 
 // Calibration variable addresses
 #define AC1_ADDRESS     0xAA
@@ -60,6 +66,12 @@
 //#define PASCALS_TO_METERS(P)        () // Converts pressure to altitude
 
 #define PRESSURE_P0		102201.209 // (Pa)
+#define CENTIMETERS_TO_FEET         0.032808f
+
+// Altitude table, every 2^ALTITUDE_STEP_SHIFT Pa from ALTITUDE_PRESSURE_MIN
+#define ALTITUDE_PRESSURE_MIN       30000 // (Pa)
+#define ALTITUDE_STEP_SHIFT         9 // 512 Pa apart
+#define ALTITUDE_ENTRIES            158
 
 /***********************************************************************
  * PRIVATE VARIABLES                                                   *
@@ -85,9 +97,51 @@ int16_t mb;
 int16_t mc;
 int16_t md;
 
+// Calibration kept in the store, see NVM_KEY_BAROMETER
+typedef struct {
+    int16_t ac1, ac2, ac3;
+    uint16_t ac4, ac5, ac6;
+    int16_t b1, b2, mb, mc, md;
+} Calibration;
+
 // Converted readings
 int32_t temperature; // (degrees C)
 int32_t pressure; // (Pascal)
+int32_t b5; // temperature term the pressure compensation needs
+
+// Conversions alternate, see Barometer_runSM
+enum {
+    STATE_IDLE = 0,     // waiting for the next update
+    STATE_TEMPERATURE,  // temperature converting
+    STATE_PRESSURE,     // pressure converting
+} state = STATE_IDLE;
+
+// (cm) 44330*(1 - (p/PRESSURE_P0)^0.19029) at each step, made offline,
+//  redo it if PRESSURE_P0 changes. Interpolating is within 3 cm from 90
+//  to 110 kPa and 20 cm at the top of the sensor's range, under the 8 cm
+//  a pascal is near sea level.
+static const int32_t altitudeTable[ALTITUDE_ENTRIES] = {
+    922251, 910928, 899757, 888734, 877856, 867117, 856514, 846044,
+    835701, 825484, 815389, 805412, 795550, 785801, 776161, 766628,
+    757200, 747873, 738646, 729516, 720481, 711538, 702686, 693922,
+    685245, 676652, 668143, 659714, 651365, 643093, 634898, 626777,
+    618729, 610753, 602847, 595010, 587240, 579536, 571898, 564323,
+    556811, 549361, 541970, 534639, 527366, 520150, 512991, 505887,
+    498837, 491840, 484896, 478003, 471161, 464369, 457626, 450932,
+    444285, 437684, 431130, 424621, 418157, 411737, 405360, 399026,
+    392734, 386483, 380273, 374104, 367974, 361883, 355830, 349816,
+    343839, 337899, 331996, 326128, 320296, 314499, 308736, 303007,
+    297312, 291651, 286022, 280425, 274860, 269327, 263825, 258353,
+    252912, 247501, 242119, 236767, 231444, 226149, 220882, 215643,
+    210432, 205248, 200091, 194960, 189856, 184778, 179725, 174698,
+    169696, 164719, 159767, 154838, 149934, 145054, 140197, 135363,
+    130552, 125765, 120999, 116256, 111535, 106836, 102159, 97503,
+    92868, 88254, 83661, 79088, 74536, 70004, 65492, 60999,
+    56526, 52073, 47638, 43223, 38827, 34449, 30089, 25748,
+    21425, 17120, 12833, 8563, 4311, 76, -4142, -8342,
+    -12526, -16694, -20844, -24979, -29097, -33199, -37285, -41355,
+    -45409, -49448, -53471, -57480, -61473, -65451,
+};
 
 /***********************************************************************
  * PRIVATE PROTOTYPES                                                  *
@@ -95,16 +149,40 @@ int32_t pressure; // (Pascal)
 
 static int16_t readTwoDataBytes( uint8_t address, int BAROMETER_I2C_ID) ;
 static int32_t readThreeDataBytes( uint8_t address, int BAROMETER_I2C_ID);
-static int32_t readSensor(uint8_t sensorSelectAddress, int BAROMETER_I2C_ID);
-static void updateReadings(int BAROMETER_I2C_ID);
+static BOOL startConversion(uint8_t sensorSelectAddress, int BAROMETER_I2C_ID);
+static void convertTemperature(int32_t ut);
+static void convertPressure(int32_t up);
+static void keepCalibration(NvmKey key);
 
 /***********************************************************************
  * PUBLIC FUNCTIONS                                                    *
  ***********************************************************************/
 
 void Barometer_init(int BAROMETER_I2C_ID) {
+    Calibration kept;
+    NvmKey key = (BAROMETER_I2C_ID == I2C1)? NVM_KEY_BAROMETER
+        : NVM_KEY_BAROMETER2;
+    I2C_addDevice(BAROMETER_I2C_ID, SLAVE_ADDRESS, SLAVE_CLOCK_FREQ);
 
     ac1 = readTwoDataBytes(AC1_ADDRESS, BAROMETER_I2C_ID);
+    // The kept calibration if AC1 shows it's the same sensor
+    if (Nvm_read(key, &kept, sizeof(kept)) == SUCCESS && kept.ac1 == ac1
+            && IS_CALIBRATION_VALID(ac1)) {
+        ac2 = kept.ac2;
+        ac3 = kept.ac3;
+        ac4 = kept.ac4;
+        ac5 = kept.ac5;
+        ac6 = kept.ac6;
+        b1 = kept.b1;
+        b2 = kept.b2;
+        mb = kept.mb;
+        mc = kept.mc;
+        md = kept.md;
+        state = STATE_IDLE;
+        Timer_new(TIMER_BAROMETER, 0);
+        return;
+    }
+
     ac2 = readTwoDataBytes(AC2_ADDRESS, BAROMETER_I2C_ID);
     ac3 = readTwoDataBytes(AC3_ADDRESS, BAROMETER_I2C_ID);
     ac4 = readTwoDataBytes(AC4_ADDRESS, BAROMETER_I2C_ID);
@@ -115,10 +193,11 @@ void Barometer_init(int BAROMETER_I2C_ID) {
     mb = readTwoDataBytes(MB_ADDRESS, BAROMETER_I2C_ID);
     mc = readTwoDataBytes(MC_ADDRESS, BAROMETER_I2C_ID);
     md = readTwoDataBytes(MD_ADDRESS, BAROMETER_I2C_ID);
+    keepCalibration(key);
 
-    updateReadings(BAROMETER_I2C_ID);
-    Timer_new(TIMER_BAROMETER,UPDATE_DELAY);
-
+    // The first update starts straight away
+    state = STATE_IDLE;
+    Timer_new(TIMER_BAROMETER, 0);
 }
 
 int32_t Barometer_getTemperature(){
@@ -134,15 +213,59 @@ int32_t Barometer_getPressure(){
 }
 
 void Barometer_runSM(int BAROMETER_I2C_ID) {
-    if (Timer_isExpired(TIMER_BAROMETER)) {
-        updateReadings(BAROMETER_I2C_ID);
-        Timer_new(TIMER_BAROMETER,UPDATE_DELAY);
+    switch (state) {
+        case STATE_IDLE:
+            if (Timer_isExpired(TIMER_BAROMETER)
+                    && startConversion(TEMPERATURE_DATA_ADDRESS,
+                    BAROMETER_I2C_ID)) {
+                Timer_new(TIMER_BAROMETER, UPDATE_DELAY);
+                Timer_new(TIMER_BAROMETER2, TEMPERATURE_DELAY);
+                state = STATE_TEMPERATURE;
+            }
+            break;
+        case STATE_TEMPERATURE:
+            if (!Timer_isExpired(TIMER_BAROMETER2))
+                break;
+            convertTemperature(readTwoDataBytes(SENSOR_DATA_ADDRESS,
+                BAROMETER_I2C_ID));
+            if (startConversion(PRESSURE_DATA_ADDRESS, BAROMETER_I2C_ID)) {
+                Timer_new(TIMER_BAROMETER2, PRESSURE_DELAY);
+                state = STATE_PRESSURE;
+            }
+            else {
+                state = STATE_IDLE;
+            }
+            break;
+        case STATE_PRESSURE:
+            if (!Timer_isExpired(TIMER_BAROMETER2))
+                break;
+            convertPressure(readThreeDataBytes(SENSOR_DATA_ADDRESS,
+                BAROMETER_I2C_ID));
+            state = STATE_IDLE;
+            break;
     }
 }
 
+BOOL Barometer_isBusy() {
+    return state != STATE_IDLE;
+}
+
 float Barometer_getAltitude() {
-    //return 44330.8 - 4946.54 * pow(pressure,0.1902632);
-	return (float)((44330*(1 - pow(((float)pressure/PRESSURE_P0),0.19029)))*3.2808);
+    int32_t offset = pressure - ALTITUDE_PRESSURE_MIN;
+    int32_t i, fraction, centimeters;
+    if (offset < 0)
+        offset = 0;
+    i = offset >> ALTITUDE_STEP_SHIFT;
+    if (i >= ALTITUDE_ENTRIES - 1) {
+        i = ALTITUDE_ENTRIES - 2;
+        fraction = 1 << ALTITUDE_STEP_SHIFT;
+    }
+    else {
+        fraction = offset & ((1 << ALTITUDE_STEP_SHIFT) - 1);
+    }
+    centimeters = altitudeTable[i] + (((altitudeTable[i + 1] - altitudeTable[i])
+        * fraction) >> ALTITUDE_STEP_SHIFT);
+    return centimeters * CENTIMETERS_TO_FEET;
 }
 
 
@@ -159,58 +282,16 @@ float Barometer_getAltitude() {
  * @author Shehadeh H. Dajani
  * @date 2013.01.21  */
 static int16_t readTwoDataBytes( uint8_t address, int BAROMETER_I2C_ID) {
-    int8_t success = FALSE;
-    int16_t data = 0;
+    uint8_t data[2];
 
-    do {
-        // Send the start bit with the restart flag low
-        if(!I2C_startTransfer(BAROMETER_I2C_ID, I2C_WRITE )){
-            #ifdef DEBUG
-            printf("FAILED initial transfer!\n");
-            #endif
-            break;
-        }
-        // Transmit the slave's address to notify it
-        if (!I2C_sendData(BAROMETER_I2C_ID, SLAVE_WRITE_ADDRESS))
-            break;
-
-        // Tranmit the read address module
-        if(!I2C_sendData(BAROMETER_I2C_ID,address)){
-            #ifdef DEBUG
-            printf("Error: Sent byte was not acknowledged\n");
-            #endif
-            break;
-        }
-
-        // Send a Repeated Started condition
-        if(!I2C_startTransfer(BAROMETER_I2C_ID,I2C_READ)){
-            #ifdef DEBUG
-            printf("FAILED Repeated start!\n");
-            #endif
-            break;
-        }
-        // Transmit the address with the READ bit set
-        if (!I2C_sendData(BAROMETER_I2C_ID, SLAVE_READ_ADDRESS))
-            break;
-        
-        // Read the I2C bus twice
-        data = (I2C_getData(BAROMETER_I2C_ID) << 8);
-        I2C_acknowledgeRead(BAROMETER_I2C_ID, TRUE);
-        while(!I2C_hasAcknowledged(BAROMETER_I2C_ID));
-        data += I2C_getData(BAROMETER_I2C_ID);
-
-        // Send the stop bit to finish the transfer
-        I2C_stopTransfer(BAROMETER_I2C_ID);
-
-        success = TRUE;
-    } while(0);
-    if (!success) {
+    if (I2C_readRegisters(BAROMETER_I2C_ID, SLAVE_ADDRESS, address, data, 2)
+            != SUCCESS) {
         #ifdef DEBUG
         printf("Data transfer unsuccessful.\n");
         #endif
         return FALSE;
     }
-    return data;
+    return ((int16_t)data[0] << 8) | data[1];
 }
 
 /**
@@ -222,182 +303,105 @@ static int16_t readTwoDataBytes( uint8_t address, int BAROMETER_I2C_ID) {
  * @author Shehadeh H. Dajani
  * @date 2013.01.21  */
 static int32_t readThreeDataBytes( uint8_t address, int BAROMETER_I2C_ID) {
-    int8_t success = FALSE;
-    int32_t data = 0;
-
-    do {
-        // Send the start bit with the restart flag low
-        if(!I2C_startTransfer(BAROMETER_I2C_ID, I2C_WRITE )){
-            #ifdef DEBUG
-            printf("FAILED initial transfer!\n");
-            #endif
-            break;
-        }
-        // Transmit the slave's address to notify it
-        if (!I2C_sendData(BAROMETER_I2C_ID, SLAVE_WRITE_ADDRESS))
-            break;
+    uint8_t data[3];
 
-        // Tranmit the read address module
-        if(!I2C_sendData(BAROMETER_I2C_ID,address)){
-            #ifdef DEBUG
-            printf("Error: Sent byte was not acknowledged\n");
-            #endif
-            break;
-        }
-
-        // Send a Repeated Started condition
-        if(!I2C_startTransfer(BAROMETER_I2C_ID,I2C_READ)){
-            #ifdef DEBUG
-            printf("FAILED Repeated start!\n");
-            #endif
-            break;
-        }
-        // Transmit the address with the READ bit set
-        if (!I2C_sendData(BAROMETER_I2C_ID, SLAVE_READ_ADDRESS))
-            break;
-        
-        // Read the I2C bus twice
-        data = (I2C_getData(BAROMETER_I2C_ID) << 16);
-        I2C_acknowledgeRead(BAROMETER_I2C_ID, TRUE);
-        while(!I2C_hasAcknowledged(BAROMETER_I2C_ID));
-		
-        data += (I2C_getData(BAROMETER_I2C_ID) << 8);
-        I2CAcknowledgeByte(BAROMETER_I2C_ID, TRUE);
-        while(!I2CAcknowledgeHasCompleted(BAROMETER_I2C_ID));
-
-        data += I2C_getData(BAROMETER_I2C_ID);
-	I2CAcknowledgeByte(BAROMETER_I2C_ID, FALSE);
-        while(!I2CAcknowledgeHasCompleted(BAROMETER_I2C_ID));\
-
-        // Roll off extra
-        data = data >> (8 - OSS);
-		
-        // Send the stop bit to finish the transfer
-        I2C_stopTransfer(BAROMETER_I2C_ID);
-
-        success = TRUE;
-    } while(0);
-    if (!success) {
+    if (I2C_readRegisters(BAROMETER_I2C_ID, SLAVE_ADDRESS, address, data, 3)
+            != SUCCESS) {
         #ifdef DEBUG
         printf("Data transfer unsuccessful.\n");
         #endif
         return FALSE;
     }
-    return data;
+    // Roll off extra
+    return (((int32_t)data[0] << 16) | ((int32_t)data[1] << 8) | data[2])
+        >> (8 - OSS);
 }
 /**
- * Function: readSensor
+ * Function: startConversion
  * @param Sensor to select for sampling and reading.
- * @return Raw temperature or pressure value.
- * @remark Notifies the barometer to send back either temperature or pressure
- *      data.
+ * @return TRUE if the conversion was started.
+ * @remark Starts the barometer converting either temperature or pressure,
+ *      and returns without waiting for it.
  * @author Shehadeh H. Dajani
  * @date 2013.01.21  */
-static int32_t readSensor(uint8_t sensorSelectAddress, int BAROMETER_I2C_ID) {
-    BOOL success = FALSE;
-    int32_t data = 0;
-
-    do {
-        //Send the start bit to notify that a transmission is starting
-        if(!I2C_startTransfer(BAROMETER_I2C_ID, I2C_WRITE)){
-            #ifdef DEBUG
-            printf("FAILED initial transfer!\n");
-            #endif
-            break;
-        }
-        // Transmit the slave's address to notify it
-        if (!I2C_sendData(BAROMETER_I2C_ID, SLAVE_WRITE_ADDRESS))
-            break;
-
-        // Designate the sensor select register for writing
-        if(!I2C_sendData(BAROMETER_I2C_ID, SENSOR_SELECT_ADDRESS)){
-            #ifdef DEBUG
-            printf("Error: Sent byte was not acknowledged\n");
-            #endif
-            break;
-        }
-
-        // Tranmit the sensor to read's address
-        if(!I2C_sendData(BAROMETER_I2C_ID,sensorSelectAddress)){
-            #ifdef DEBUG
-            printf("Error: Sent byte was not acknowledged\n");
-            #endif
-            break;
-        }
-        // End the tranmission
-        I2C_stopTransfer(BAROMETER_I2C_ID);
-
-        // Wait while the sensor gets the desired data in the correct register
-		// TODO remove this blocking code
-        Timer_new(TIMER_BAROMETER2,READ_SENSOR_DELAY);
-        while(!Timer_isExpired(TIMER_BAROMETER2));	// max time is 4.5ms
-
-        // Read the address that has the desired data: temperature or pressure
-        if(sensorSelectAddress == PRESSURE_DATA_ADDRESS)
-            data = readThreeDataBytes(SENSOR_DATA_ADDRESS, BAROMETER_I2C_ID);
-        else
-            data = readTwoDataBytes(SENSOR_DATA_ADDRESS, BAROMETER_I2C_ID);
-
-        success = TRUE;
-    } while(0);
-
-    if(!success){
+static BOOL startConversion(uint8_t sensorSelectAddress, int BAROMETER_I2C_ID) {
+    // Designate the sensor select register and the sensor to read
+    if (I2C_writeRegisters(BAROMETER_I2C_ID, SLAVE_ADDRESS,
+            SENSOR_SELECT_ADDRESS, &sensorSelectAddress, 1) != SUCCESS) {
         #ifdef DEBUG
         printf("Data transfer unsuccessful.\n");
         #endif
-        return ERROR;
+        return FALSE;
     }
-        
-    return data;
+    return TRUE;
 }
 
 /**
- * Function: updateReadings
- * @return
- * @remark Gets the raw temperature and pressure readings and then converts
- * them into actual readings. The final readings are stored into the
- * temperature and pressure variables for future access.
- * @author Shehadeh H. Dajani
- * @date 2013.01.21  */
-static void updateReadings(int BAROMETER_I2C_ID) {
-    int32_t ut;
-    int32_t up;
-    int32_t x1, x2, b5, b6, x3, b3, p;
-    uint32_t b4, b7;
-
-    // Read the pressure and temperature values from the sensor.
-    up = readSensor(PRESSURE_DATA_ADDRESS,BAROMETER_I2C_ID);
-    //up &= 0x0000FFFF;
-    ut = readSensor(TEMPERATURE_DATA_ADDRESS,BAROMETER_I2C_ID);
+ * Function: keepCalibration
+ * @param Store key for the barometer's bus.
+ * @return None
+ * @remark Keeps the calibration just read for the next boot, unless a
+ *      word of it failed to read.
+ * @date 2026.10.14  */
+static void keepCalibration(NvmKey key) {
+    Calibration calibration = { ac1, ac2, ac3, ac4, ac5, ac6, b1, b2, mb, mc,
+        md };
+    const int16_t *word = (const int16_t *)&calibration;
+    uint8_t i;
+
+    for (i = 0; i < CALIBRATION_WORDS; i++) {
+        if (!IS_CALIBRATION_VALID(word[i]))
+            return;
+    }
+    Nvm_write(key, &calibration, sizeof(calibration));
+}
 
-	// Temperature conversion
-    x1 = (((long)ut - ac6) * ac5) >> 15;
-    x2 = ((long) mc << 11) / (x1 + md);
+/**
+ * Function: convertTemperature
+ * @param Raw temperature reading.
+ * @return None
+ * @remark The datasheet's integer temperature compensation, keeping B5 for
+ *      the pressure after it.
+ * @date 2026.10.14  */
+static void convertTemperature(int32_t ut) {
+    int32_t x1, x2;
+    x1 = ((ut - ac6) * ac5) >> 15;
+    x2 = ((int32_t)mc << 11) / (x1 + md);
     b5 = x1 + x2;
     temperature = (b5 + 8) >> 4;
+}
+
+/**
+ * Function: convertPressure
+ * @param Raw pressure reading.
+ * @return None
+ * @remark The datasheet's integer pressure compensation, every power of two
+ *      as a shift. Needs the B5 of the temperature just before it.
+ * @date 2026.10.14  */
+static void convertPressure(int32_t up) {
+    int32_t x1, x2, x3, b3, b6, p;
+    uint32_t b4, b7;
 
-	// Presure conversions
     b6 = b5 - 4000;
-    x1 = (b2 * (b6 * (b6/pow(2,12))))/pow(2,11);
-    x2 = (ac2 * b6)/(pow(2,11));
+    x1 = (b2 * ((b6 * b6) >> 12)) >> 11;
+    x2 = (ac2 * b6) >> 11;
     x3 = x1 + x2;
-    b3 = ((((ac1 * 4) + x3)<< OSS) + 2)/4;
+    b3 = ((((int32_t)ac1 * 4 + x3) << OSS) + 2) >> 2;
     x1 = (ac3 * b6) >> 13;
     x2 = (b1 * ((b6 * b6) >> 12)) >> 16;
     x3 = ((x1 + x2) + 2) >> 2;
-    b4 = (ac4 * (unsigned long)(x3 + 32768)) >> 15;
-    b7 = ((unsigned long)up - b3) * (50000 >> OSS);
+    b4 = (ac4 * (uint32_t)(x3 + 32768)) >> 15;
+    b7 = ((uint32_t)up - b3) * (50000 >> OSS);
     if(b7 < 0x80000000){
-        p = (b7 * 2)/b4;
+        p = (b7 << 1) / b4;
     }
     else{
-        p = (b7/b4)*2;
+        p = (b7 / b4) << 1;
     }
-    x1 = (p/(pow(2,8))) * (p/(pow(2,8)));
+    x1 = (p >> 8) * (p >> 8);
     x1 = (x1 * 3038) >> 16;
     x2 = (-7357 * p) >> 16;
     pressure = p + ((x1 + x2 + 3791) >> 4);
-
 }
 
 //#define BAROMETER_TEST
@@ -405,6 +409,15 @@ static void updateReadings(int BAROMETER_I2C_ID) {
 
 #define PRINT_DELAY     1 // (ms)
 
+// Runs the state machine through one whole update
+static void waitForReading(int BAROMETER_I2C_ID) {
+    do {
+        Barometer_runSM(BAROMETER_I2C_ID);
+    } while (!Barometer_isBusy());
+    while (Barometer_isBusy())
+        Barometer_runSM(BAROMETER_I2C_ID);
+}
+
 int main(void) {
 // Initialize the UART,Timers, and I2C1
     Board_init();
@@ -420,6 +433,7 @@ int main(void) {
         int i;
         for (i = 0; i < 100; ++i){
             Barometer_init(BAROMETER_COMPAS_I2C_ID);
+            waitForReading(BAROMETER_COMPAS_I2C_ID);
             // Convert the raw data to real values
             while (!Timer_isExpired(TIMER_TEST));
                 //printf("Altitude1: %.1f (ft)\n\n", Barometer_getAltitude());
@@ -427,6 +441,7 @@ int main(void) {
                 Timer_new(TIMER_TEST, PRINT_DELAY );
 
             Barometer_init(BAROMETER_ATLAS_I2C_ID);
+            waitForReading(BAROMETER_ATLAS_I2C_ID);
             // Convert the raw data to real values
             while (!Timer_isExpired(TIMER_TEST));
                 //printf("Altitude2: %.1f (ft)\n\n", Barometer_getAltitude());
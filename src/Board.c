@@ -28,24 +28,45 @@
 #include "Uart.h"
 //#include <plib.h>
 
-#define SYSTEM_CLOCK    80000000L
-#define PB_CLOCK        SYSTEM_CLOCK/2
+// The bootloader leaves the 8 MHz crystal on the PLL at 80 MHz, with the
+//  peripheral bus at half that
+#define BOOT_SYSTEM_CLOCK   80000000L
+
+#if BOARD_SYSTEM_CLOCK == 80000000L
+#define PLL_POST            OSC_PLL_POST_1
+#elif BOARD_SYSTEM_CLOCK == 40000000L
+#define PLL_POST            OSC_PLL_POST_2
+#else
+#error "No PLL setting for BOARD_SYSTEM_CLOCK"
+#endif
+
+#if BOARD_PB_DIVIDER == 1
+#define PB_DIV              OSC_PB_DIV_1
+#elif BOARD_PB_DIVIDER == 2
+#define PB_DIV              OSC_PB_DIV_2
+#else
+#error "No setting for BOARD_PB_DIVIDER"
+#endif
 
 #define LED1_
 
 void Board_init()
 {
-    //unsigned int pbclk=PB_CLOCK;
-    //SYSTEMConfig(SYSTEM_CLOCK,SYS_CFG_ALL);
-    //SYSTEMConfigPB(PB_CLOCK);
-    //OSCSetPBDIV(2);
-    //Serial_init();
+    // The wait states have to suit the faster of the two clocks while the
+    //  clock changes, so slowing down switches first and speeding up
+    //  would set them first. SYSTEMConfig also turns on the prefetch
+    //  cache for the program flash, and takes the RAM wait state out.
+    #if BOARD_SYSTEM_CLOCK != BOOT_SYSTEM_CLOCK
+    OSCConfig(OSC_POSC_PLL, OSC_PLL_MULT_20, PLL_POST, OSC_FRC_POST_1);
+    #endif
+    SYSTEMConfig(BOARD_SYSTEM_CLOCK, SYS_CFG_WAIT_STATES | SYS_CFG_PCACHE);
+    OSCSetPBDIV(PB_DIV);
     INTEnableSystemMultiVectoredInt();
 }
 
 unsigned int Board_GetPBClock()
 {
-    return PB_CLOCK;
+    return BOARD_PB_CLOCK;
 }
 
 
@@ -58,7 +79,9 @@ int main(void)
 {
     Board_init();
         
-    printf("If you can see this it worked");
+    printf("If you can see this it worked, at %lu MHz with a %lu MHz bus",
+        (unsigned long)(BOARD_SYSTEM_CLOCK / 1000000L),
+        (unsigned long)(BOARD_PB_CLOCK / 1000000L));
 }
 
 
@@ -0,0 +1,208 @@
+/**********************************************************************
+ Module
+   Boot.c
+
+ Revision
+   1.0.0
+
+ Description
+   Background bring-up of the modules, and their status.
+
+ Notes
+   The modules are stepped in the order they were added, each once a
+   pass, so one that keeps a bus busy only holds up the others for as
+   long as one of its steps takes. A step is never called again once it
+   returned BOOT_READY or BOOT_FAILED.
+
+   The pending mask is only touched from the main loop, so it needs no
+   locking.
+
+***********************************************************************/
+
+#include <xc.h>
+#include <stdio.h>
+#include "Board.h"
+#include "Timer.h"
+#include "Boot.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define BIT(module)             ((uint32_t)1 << (module))
+
+/***********************************************************************
+ * PRIVATE TYPEDEFS                                                    *
+ ***********************************************************************/
+
+typedef struct {
+    const char *name;
+    BootStep step;
+    BootStatus status;
+    uint32_t time; // (ms) since Boot_init it got to its status
+} Module;
+
+/***********************************************************************
+ * PRIVATE VARIABLES                                                   *
+ ***********************************************************************/
+
+static Module modules[BOOT_MODULE_MAX];
+static uint8_t moduleCount = 0;
+static uint32_t pendingMask = 0; // still being stepped
+static uint32_t requiredMask = 0; // Boot_isReady waits for
+static uint32_t readyMask = 0;
+static uint32_t failedMask = 0;
+static uint32_t startTime; // (ms)
+static uint32_t readyTime = 0; // (ms) since startTime, 0 before
+
+static const char *statusNames[] = { "pending", "ready", "FAILED" };
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+void Boot_init() {
+    moduleCount = 0;
+    pendingMask = requiredMask = readyMask = failedMask = 0;
+    readyTime = 0;
+    startTime = get_time();
+}
+
+BootId Boot_add(const char *name, BootStep step, BOOL isRequired) {
+    Module *module;
+    if (moduleCount >= BOOT_MODULE_MAX || step == NULL)
+        return BOOT_INVALID;
+
+    module = &modules[moduleCount];
+    module->name = name;
+    module->step = step;
+    module->status = BOOT_PENDING;
+    module->time = 0;
+    pendingMask |= BIT(moduleCount);
+    if (isRequired)
+        requiredMask |= BIT(moduleCount);
+    return moduleCount++;
+}
+
+void Boot_runSM() {
+    uint8_t i;
+    BootStatus status;
+    Module *module;
+
+    if (pendingMask == 0)
+        return;
+
+    for (i = 0; i < moduleCount; i++) {
+        if (!(pendingMask & BIT(i)))
+            continue;
+        module = &modules[i];
+        status = module->step();
+        if (status == BOOT_PENDING)
+            continue;
+
+        pendingMask &= ~BIT(i);
+        module->status = status;
+        module->time = get_time() - startTime;
+        if (status == BOOT_READY)
+            readyMask |= BIT(i);
+        else
+            failedMask |= BIT(i);
+        printf("Boot: %s %s at %lu ms.\n", module->name,
+            statusNames[status], (unsigned long)module->time);
+
+        if (readyTime == 0 && (readyMask & requiredMask) == requiredMask) {
+            readyTime = module->time? module->time : 1;
+            printf("Boot: ready for use at %lu ms.\n",
+                (unsigned long)readyTime);
+        }
+    }
+}
+
+BootStatus Boot_getStatus(BootId id) {
+    if (id >= moduleCount)
+        return BOOT_FAILED;
+    return modules[id].status;
+}
+
+BOOL Boot_isReady() {
+    return (readyMask & requiredMask) == requiredMask;
+}
+
+BOOL Boot_hasFailed() {
+    return (failedMask & requiredMask) != 0;
+}
+
+uint32_t Boot_getReadyTime() {
+    return readyTime;
+}
+
+void Boot_printStatus() {
+    uint8_t i;
+    Module *module;
+    for (i = 0; i < moduleCount; i++) {
+        module = &modules[i];
+        if (module->status == BOOT_PENDING)
+            printf("  %-14s %s%s\n", module->name, statusNames[BOOT_PENDING],
+                (requiredMask & BIT(i))? ", required" : "");
+        else
+            printf("  %-14s %s at %lu ms\n", module->name,
+                statusNames[module->status], (unsigned long)module->time);
+    }
+}
+
+//#define BOOT_TEST
+#ifdef BOOT_TEST
+
+#include "Serial.h"
+#include "Scheduler.h"
+
+#define PRINT_PERIOD    1000 // (ms)
+
+// Stand-ins that come up a while after they're first stepped
+static BootStatus readyAfter(uint32_t *start, uint32_t delay) {
+    if (*start == 0)
+        *start = get_time();
+    return (get_time() - *start >= delay)? BOOT_READY : BOOT_PENDING;
+}
+
+static BootStatus bootFast() {
+    static uint32_t start = 0;
+    return readyAfter(&start, 50);
+}
+
+static BootStatus bootSlow() {
+    static uint32_t start = 0;
+    return readyAfter(&start, 3000);
+}
+
+static BootStatus bootOptional() {
+    static uint32_t start = 0;
+    return readyAfter(&start, 8000);
+}
+
+static BootStatus bootBroken() {
+    return BOOT_FAILED;
+}
+
+int main() {
+    Board_init();
+    Serial_init();
+    Timer_init();
+    Scheduler_init();
+    Boot_init();
+
+    Boot_add("fast", bootFast, TRUE);
+    Boot_add("slow", bootSlow, TRUE);
+    Boot_add("optional", bootOptional, FALSE);
+    Boot_add("broken", bootBroken, FALSE);
+    Scheduler_addTask(Boot_runSM, SCHEDULER_PRIORITY_HIGH, 10);
+    Scheduler_addTask(Boot_printStatus, SCHEDULER_PRIORITY_LOW, PRINT_PERIOD);
+
+    // Ready at about 3 s, with the optional one still coming up
+    while (1)
+        Scheduler_run();
+
+    return SUCCESS;
+}
+
+#endif
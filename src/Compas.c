@@ -22,17 +22,28 @@
 
 #include <xc.h>
 #include <stdio.h>
+#include <math.h>
 #include <plib.h>
 #include "I2C.h"
 #include "Serial.h"
 #include "Board.h"
+#include "Timer.h"
+#include "Scheduler.h"
+#include "Sensors.h"
 #include "Encoder.h"
+#include "Accelerometer.h"
 #include "Ports.h"
 #include "Magnetometer.h"
 #include "Xbee.h"
 #include "UART.h"
 #include "Gps.h"
 #include "Navigation.h"
+#include "Guidance.h"
+#include "FastMath.h"
+#include "Recorder.h"
+#include "Boot.h"
+#include "Nvm.h"
+#include "Watchdog.h"
 
 /***********************************************************************
  * PRIVATE DEFINITIONS                                                 *
@@ -67,6 +78,10 @@ I2C_MODULE      I2C_BUS_ID = I2C1;
 
 #define LED_DELAY     1 // (ms)
 
+// Read off the shared sensor schedule
+#define ACCELEROMETER_PERIOD    50 // (ms)
+#define ACCELEROMETER_COST      250 // (us) burst of the six output registers
+
 // Leveling constants
 #define G_DELTA_HORIZONTAL         10 // (0.001 G) scaled by 1e-3 == 0.02 G
 #define G_DELTA_VERTICAL           25 // (0.001 G) scaled by 1e-3 == 0.02 G
@@ -88,8 +103,79 @@ I2C_MODULE      I2C_BUS_ID = I2C1;
 //------------------------------- XBEE --------------------------------
 #define USE_XBEE
 
+// A new rescue goes to the nearest connected boat that's idle, from the
+//  positions the boats send, or failing that to the nearest, and every
+//  update of its track to that same boat. A position older than
+//  FLEET_POSITION_TIMEOUT isn't used.
+#define FLEET_POSITION_TIMEOUT  5000 // (ms)
+
+//------------------------------- DGPS --------------------------------
+// Broadcast differential GPS corrections to the boats (needs USE_GPS)
+#define USE_DGPS_BASE
+
+#define DGPS_PERIOD     1000 // (ms) between corrections
+#define SURVEY_FIXES    300 // fixes averaged into the base position (60 s)
+
+//----------------------------- Recorder ------------------------------
+// Keep the angles, IMU, GPS, link and events in the flight recorder,
+//  needs a flash chip on SPI2 (see Recorder.h)
+//#define USE_RECORDER
+
+#define RECORD_PERIOD       20 // (ms) angles and IMU
+#define RECORD_LINK_EVERY   50 // records of the angles, once a second
+#define RECORDER_PERIOD     1 // (ms) a page takes about ten
+
+//------------------------------ Tasks ---------------------------------
+// Periods of the scheduler tasks. The link task is also woken by the
+//  receive interrupt, its period only picks up the end of a burst that
+//  stayed under the UART's FIFO interrupt threshold.
+#define LINK_PERIOD     10 // (ms)
+#define BUTTON_PERIOD   20 // (ms)
+#define ENCODER_PERIOD  5 // (ms) 32 readings are averaged, so 160 ms of them
+#define ENCODER_COST    300 // (us) a two byte read of each encoder
+#define LEVEL_PERIOD    50 // (ms)
+#define BOOT_PERIOD     10 // (ms) a step of each module still coming up
+#define LOG_PERIOD      10 // (ms) queued SERIAL_LOG records out to the UART
+
+// A supervised task that runs more than DEADLINE_PERIODS of its period
+//  after its last run is logged as a miss (see Watchdog.h). The link,
+//  navigation and buttons are critical, the watchdog resets the board if
+//  one of them stops running. It also has to allow for LOOP_BLOCK_MAX, the
+//  longest the loop is held up on purpose, by a flash erase or a profile
+//  print.
+#define DEADLINE_PERIODS    3
+#define LOOP_BLOCK_MAX      250 // (ms)
+
+//----------------------------- Tracking ------------------------------
+// While Lock is held the target under the sight is projected every
+//  TRACK_PERIOD and smoothed by an alpha-beta filter, and the boat is sent
+//  where it is now whenever it has moved, at most every TRACK_SEND_PERIOD
+#define TRACK_PERIOD        100 // (ms) 10 Hz
+#define TRACK_SEND_PERIOD   500 // (ms)
+#define TRACK_SEND_DISTANCE 1.0f // (m) moved since it was last sent
+#define TRACK_ALPHA         0.5f // of the position residual taken
+#define TRACK_BETA          0.1f // of the position residual, per period, into the velocity
+#define TRACK_JUMP          15.0f // (m) off the track, the sight moved to a new target
+#define TRACK_SPEED_MAX     3.0f // (m/s) faster than anyone swims or drifts
+
+//------------------------------- Store ---------------------------------
+// The tripod height and encoder zero are kept in the flash store (Nvm.h)
+//  across boots. TRIPOD_HEIGHT is only used until a height is kept,
+//  define KEEP_TRIPOD_HEIGHT for one boot to keep it after moving the
+//  tripod.
+#define TRIPOD_HEIGHT       5.44f // (m)
+//#define KEEP_TRIPOD_HEIGHT
+
+//------------------------------ Profile --------------------------------
+// Task times and loop period histogram, printed with DEBUG_VERBOSE
+#define PROFILE_PERIOD  10000 // (ms)
+
 //----------------------------- Other Modules ---------------------------
 #define USE_MAGNETOMETER
+
+// One step of its background sampling, a heading every few steps
+#define MAGNETOMETER_PERIOD     10 // (ms)
+#define MAGNETOMETER_COST       300 // (us) a queued read at 100 kHz
 #define USE_NAVIGATION
 #define USE_ENCODERS
 
@@ -100,8 +186,29 @@ I2C_MODULE      I2C_BUS_ID = I2C1;
 
 void initMasterSM();
 void runMasterSM();
+void checkButtons();
+void readAccelerometer();
+void updateLevel();
 void updateAccelerometerLEDs();
 void updateHeading();
+void sendCorrection();
+void recordState();
+void trackTarget();
+void startTracking();
+void stopTracking();
+BOOL sampleTarget(float *north, float *east);
+void sendTarget(uint8_t status, BOOL isFinal);
+void xbeeReceived(uint8_t id);
+void rescueAcknowledged(uint8_t messageName, uint8_t status);
+void boatPositionReceived(uint8_t uart_id, const mavlink_message_t *msg);
+uint8_t chooseBoat(const GpsCoordinate *target);
+void loadSettings();
+void keepZero();
+void superviseTask(TaskId task, uint32_t period, BOOL isCritical);
+BootStatus bootEncoders();
+BootStatus bootGps();
+BootStatus bootLink();
+BootStatus bootMagnetometer();
 
 BOOL readLockButton();
 BOOL readZeroButton();
@@ -112,7 +219,7 @@ BOOL isZeroPressed();
  * PRIVATE VARIABLES                                                   *
  ***********************************************************************/
 
-float height = 5.44; // (m)
+float height = TRIPOD_HEIGHT; // (m) see loadSettings
 float heading = 0;
 // Printing debug messages over serial
 BOOL useLevel = FALSE;
@@ -120,6 +227,36 @@ BOOL useLevel = FALSE;
 BOOL lockPressed = FALSE, lockTimerStarted = FALSE;
 BOOL zeroPressed = FALSE, zeroTimerStarted = FALSE;
 
+TaskId xbeeTask = SCHEDULER_INVALID;
+
+// Lock is ignored until the required modules are up, see Boot_isReady
+BootId accelerometerBoot = BOOT_INVALID;
+BOOL lockWaiting = FALSE; // held before then, the status is printed once
+
+// Target under the sight while Lock is held, see trackTarget
+static struct {
+    BOOL isTracking;
+    BOOL hasTrack; // a sample came since tracking started
+    BOOL hasSent; // since tracking started or the target jumped
+    uint32_t lastSample, lastSend; // (ms)
+    float north, east; // (m) smoothed, from the origin
+    float velocityNorth, velocityEast; // (m/s)
+    float sentNorth, sentEast; // (m) last sent to the boat
+    uint8_t boat; // system id of the boat, chosen for each new rescue
+    #ifdef USE_GPS
+    GpsCoordinate origin; // first sample
+    float metersPerLongitude; // per 1e-7 degrees at the origin
+    #endif
+} track;
+
+// Latest position of each boat, at the index of its MAVLink peer
+static struct {
+    uint8_t sysid; // 0 before one
+    uint32_t time; // (ms) ours, when it came
+    GpsCoordinate position;
+    uint8_t guidance; // GuidanceState
+} fleet[MAVLINK_PEERS_MAX];
+
 /******************************************************************************
  * PRIVATE FUNCTIONS                                                          *
  ******************************************************************************/
@@ -133,7 +270,8 @@ BOOL zeroPressed = FALSE, zeroTimerStarted = FALSE;
 #ifdef USE_MAIN
 int main(void) {
     initMasterSM();
-    printf("Command Center Ready for Use. \n\n\n\n\n");
+    printf("Command Center starting, Lock works once the encoders, GPS "
+        "and link are up.\n\n\n\n\n");
     while(1){
         runMasterSM();
     }
@@ -152,6 +290,14 @@ void initMasterSM() {
     Board_init();
     Serial_init();
     Timer_init();
+    // Says why the board reset, before anything else prints
+    Watchdog_init();
+    Scheduler_init();
+    // Each module comes up in the background from here, see Boot.h
+    Boot_init();
+    if (Nvm_init() != SUCCESS)
+        printf("No flash store, calibrating from scratch.\n");
+    loadSettings();
 
     // CC buttons
     LOCK_BUTTON_TRIS = 1;
@@ -161,24 +307,39 @@ void initMasterSM() {
 
     #ifdef USE_XBEE
     Xbee_init();
+    Mavlink_register(MAVLINK_MSG_ID_BOAT_POSITION, boatPositionReceived);
+    Boot_add("link", bootLink, TRUE);
     #endif
 
     #ifdef USE_NAVIGATION
     Navigation_init();
     #endif
 
+    #ifdef USE_GPS
+    Boot_add("gps", bootGps, TRUE);
+    #endif
+
+    #if defined(USE_DGPS_BASE) && defined(USE_GPS)
+    GPS_startSurvey(SURVEY_FIXES);
+    #endif
+
+    #ifdef USE_RECORDER
+    if (Recorder_init() != SUCCESS)
+        printf("No flash chip for the recorder.\n");
+    #endif
+
     #ifdef USE_ENCODERS
     I2C_init(I2C_BUS_ID, I2C_CLOCK_FREQ);
+    // First, its latency matters most when Lock is pressed
+    Sensors_add(Encoder_runSM, I2C_BUS_ID, ENCODER_PERIOD, ENCODER_COST);
+    Boot_add("encoders", bootEncoders, TRUE);
     #endif
 
 
     #ifdef USE_ACCELEROMETER
-    //printf("Initializing accelerometer...\n");
-    if (Accelerometer_init() != SUCCESS) {
-        printf("Failed to initialize the accelerometer.\n");
-        //return;
-    }
-    //printf("Initialized the accelerometer.\n");
+    // Only for the level lights and the tilt check, so not waited on
+    accelerometerBoot = Boot_add("accelerometer", Accelerometer_initSM,
+        FALSE);
 
     // Configure ports as outputs
     LED_N_TRIS = OUTPUT;
@@ -186,54 +347,129 @@ void initMasterSM() {
     LED_E_TRIS = OUTPUT;
     LED_W_TRIS = OUTPUT;
 
+    Sensors_add(readAccelerometer, I2C_BUS_ID, ACCELEROMETER_PERIOD,
+        ACCELEROMETER_COST);
+    #endif
+
+    #ifdef USE_MAGNETOMETER
+    Magnetometer_init();
+    Sensors_add(Magnetometer_runSM, I2C_BUS_ID, MAGNETOMETER_PERIOD,
+        MAGNETOMETER_COST);
+    Boot_add("magnetometer", bootMagnetometer, FALSE);
+    #endif
+
+    // After every Sensors_add, so the phases are planned together
+    Sensors_start(SCHEDULER_PRIORITY_HIGH);
+
+    // The link and the GPS stream first, then the buttons, then the rest.
+    //  Nothing is polled, so the scheduler idles between them.
+    #ifdef USE_XBEE
+    xbeeTask = Scheduler_addTask(Xbee_runSM, SCHEDULER_PRIORITY_HIGH,
+        LINK_PERIOD);
+    superviseTask(xbeeTask, LINK_PERIOD, TRUE);
+    UART_setReceiveHandler(XBEE_UART_ID, xbeeReceived);
+    #endif
+
+    #ifdef USE_NAVIGATION
+    superviseTask(Scheduler_addTask(Navigation_runSM,
+        SCHEDULER_PRIORITY_HIGH, LINK_PERIOD), LINK_PERIOD, TRUE);
+    #endif
+
+    superviseTask(Scheduler_addTask(Boot_runSM, SCHEDULER_PRIORITY_NORMAL,
+        BOOT_PERIOD), BOOT_PERIOD, FALSE);
+    superviseTask(Scheduler_addTask(checkButtons, SCHEDULER_PRIORITY_NORMAL,
+        BUTTON_PERIOD), BUTTON_PERIOD, TRUE);
 
-    Timer_new(TIMER_ACCELEROMETER, LED_DELAY );
+    #if defined(USE_NAVIGATION) && defined(USE_ENCODERS)
+    superviseTask(Scheduler_addTask(trackTarget, SCHEDULER_PRIORITY_NORMAL,
+        TRACK_PERIOD), TRACK_PERIOD, FALSE);
     #endif
+
+    #ifdef USE_ACCELEROMETER
+    superviseTask(Scheduler_addTask(updateLevel, SCHEDULER_PRIORITY_LOW,
+        LEVEL_PERIOD), LEVEL_PERIOD, FALSE);
+    #endif
+
+    #if defined(USE_DGPS_BASE) && defined(USE_GPS)
+    Scheduler_addTask(sendCorrection, SCHEDULER_PRIORITY_LOW, DGPS_PERIOD);
+    #endif
+
+    #ifdef USE_RECORDER
+    Scheduler_addTask(recordState, SCHEDULER_PRIORITY_LOW, RECORD_PERIOD);
+    Scheduler_addTask(Recorder_runSM, SCHEDULER_PRIORITY_LOW, RECORDER_PERIOD);
+    #endif
+
+    Scheduler_addTask(Serial_runSM, SCHEDULER_PRIORITY_LOW, LOG_PERIOD);
+
+    #if defined(DEBUG_VERBOSE) && defined(SCHEDULER_USE_PROFILE)
+    Scheduler_addTask(Scheduler_printProfile, SCHEDULER_PRIORITY_LOW,
+        PROFILE_PERIOD);
+    Scheduler_addTask(Sensors_printSchedule, SCHEDULER_PRIORITY_LOW,
+        PROFILE_PERIOD);
+    Scheduler_addTask(Watchdog_printStatus, SCHEDULER_PRIORITY_LOW,
+        PROFILE_PERIOD);
+    #endif
+
+    // Last, everything before it is allowed to block
+    Watchdog_start(Scheduler_getCriticalPeriod() + LOOP_BLOCK_MAX);
+}
+
+/**
+ * Function: superviseTask
+ * @param Task from Scheduler_addTask.
+ * @param (ms) Its period.
+ * @param Whether the watchdog waits on it.
+ * @return None.
+ * @remark Gives the task a deadline of DEADLINE_PERIODS of its period.
+ * @date 2026.10.14  */
+void superviseTask(TaskId task, uint32_t period, BOOL isCritical) {
+    if (task != SCHEDULER_INVALID)
+        Scheduler_setDeadline(task, DEADLINE_PERIODS * period, isCritical);
 }
 
 /**
  * Function: runMasterSM
  * @return None.
- * @remark Executes one cycle of the command center's state machine.
+ * @remark Executes one cycle of the command center's state machine, which
+ *  is one pass of the scheduler over the tasks from initMasterSM.
  * @author David Goodman
  * @date 2013.03.09  */
 void runMasterSM() {
+    Scheduler_run();
+}
+
+/**
+ * Function: checkButtons
+ * @return None.
+ * @remark Handles the lock and zero buttons. Lock tracks the target for
+ *  as long as it's held, see trackTarget.
+ * @author David Goodman
+ * @date 2013.03.09  */
+void checkButtons() {
     //Magnetometer_runSM();
     // Record these button presses since we don't know
     //  if they will be pressed after runSM
     lockPressed = isLockPressed();
     zeroPressed = isZeroPressed();
+    if (lockPressed && !Boot_isReady()) {
+        if (!lockWaiting) {
+            printf("Lock needs the encoders, GPS and link up first:\n");
+            Boot_printStatus();
+        }
+        lockWaiting = TRUE;
+        lockPressed = FALSE;
+    }
+    else if (!lockPressed) {
+        lockWaiting = FALSE;
+    }
     if(lockPressed || zeroPressed){
-        #ifdef USE_ENCODERS
-        Encoder_runSM();
-        #endif
-
         if(lockPressed) {
-            printf("Lock was pressed.\n");
-            #ifdef USE_NAVIGATION
-            #ifdef USE_ENCODERS
-            Encoder_enableZeroAngle();
-            Encoder_runSM();
-            Coordinate ned; // = Coordinate_new(ned, 0, 0 ,0);
-            if (Navigation_getProjectedCoordinate(&ned, Encoder_getYaw(),
-                Encoder_getPitch(), height)) {
-                printf("Desired coordinate -- N: %.6f, E: %.6f, D: %.2f (m)\n",
-                    ned.x, ned.y, ned.z);
-
-
-                #ifdef USE_XBEE
-                Mavlink_send_start_rescue(XBEE_UART_ID, TRUE, 0,ned.x, ned.y);
-                #endif
-            }
-            else {
-                printf("Failed to obtain desired NED coordinate.\n");
-            }
-            Encoder_disableZeroAngle();
+            #if defined(USE_NAVIGATION) && defined(USE_ENCODERS)
+            if (!track.isTracking)
+                startTracking();
             #else
             printf("Navigation module is disabled.\n");
             #endif
-            #endif
-
         }
         else if (zeroPressed) {
             // Zero was pressed
@@ -242,7 +478,6 @@ void runMasterSM() {
             #endif
             useLevel = TRUE;
             #ifdef  USE_MAGNETOMETER
-            Magnetometer_runSM();
             heading = Magnetometer_getDegree();
             updateHeading();
             #endif
@@ -252,27 +487,477 @@ void runMasterSM() {
 
         }
     }
+    #if defined(USE_NAVIGATION) && defined(USE_ENCODERS)
+    if (!lockPressed && track.isTracking)
+        stopTracking();
+    #endif
     if (!zeroPressed) {
-        if (useLevel)
+        if (useLevel) {
             printf("Done zeroing.\n");
+            #ifdef USE_ENCODERS
+            keepZero();
+            #endif
+        }
         
         useLevel = FALSE;
     }
+}
 
-    #ifdef USE_ACCELEROMETER
-    Accelerometer_runSM();
-    updateAccelerometerLEDs();
+/**
+ * Function: loadSettings
+ * @return None.
+ * @remark Takes the tripod height and the encoder zero kept in the store,
+ *  see KEEP_TRIPOD_HEIGHT.
+ * @date 2026.10.14  */
+void loadSettings() {
+    #ifdef USE_ENCODERS
+    uint16_t zero[2]; // pitch, yaw
     #endif
 
-    #ifdef USE_NAVIGATION
-    Navigation_runSM();
+    #ifdef KEEP_TRIPOD_HEIGHT
+    Nvm_write(NVM_KEY_TRIPOD_HEIGHT, &height, sizeof(height));
+    #else
+    Nvm_read(NVM_KEY_TRIPOD_HEIGHT, &height, sizeof(height));
+    #endif
+    printf("Tripod height is %.2f m.\n", height);
+
+    #ifdef USE_ENCODERS
+    if (Nvm_read(NVM_KEY_ENCODER_ZERO, zero, sizeof(zero)) == SUCCESS)
+        Encoder_setZeroAngles(zero[0], zero[1]);
     #endif
+}
+
+/**
+ * Function: keepZero
+ * @return None.
+ * @remark Keeps the encoder zero once Zero is let go, so the next boot
+ *  starts with it.
+ * @date 2026.10.14  */
+#ifdef USE_ENCODERS
+void keepZero() {
+    uint16_t zero[2]; // pitch, yaw
+    Encoder_getZeroAngles(&zero[0], &zero[1]);
+    Nvm_write(NVM_KEY_ENCODER_ZERO, zero, sizeof(zero));
+}
+#endif
+
+/**
+ * Function: startTracking
+ * @return None.
+ * @remark Starts projecting the sight every TRACK_PERIOD, the first
+ *  sample is sent to the boat as a new rescue.
+ * @date 2026.10.14  */
+#if defined(USE_NAVIGATION) && defined(USE_ENCODERS)
+void startTracking() {
+    printf("Lock was pressed, tracking.\n");
+    Encoder_enableZeroAngle();
+    track.isTracking = TRUE;
+    track.hasTrack = FALSE;
+    track.hasSent = FALSE;
+    trackTarget();
+}
+
+/**
+ * Function: stopTracking
+ * @return None.
+ * @remark Sends the boat where the target was last, acknowledged, once
+ *  Lock is let go.
+ * @date 2026.10.14  */
+void stopTracking() {
+    track.isTracking = FALSE;
+    if (track.hasTrack)
+        sendTarget(track.hasSent? RESCUE_STATUS_TRACKING : RESCUE_STATUS_NEW,
+            TRUE);
+    else
+        printf("Failed to obtain desired coordinate.\n");
+    Encoder_disableZeroAngle();
+}
+
+/**
+ * Function: trackTarget
+ * @return None.
+ * @remark Scheduled every TRACK_PERIOD, does nothing unless Lock is held.
+ *  Each projection of the sight is run through an alpha-beta filter, so
+ *  the track follows a drifting swimmer without the shake of the
+ *  operator's hands. A projection further than TRACK_JUMP from the track
+ *  is a new target, the track starts over there and goes out straight
+ *  away. Otherwise the boat gets the track every TRACK_SEND_PERIOD that
+ *  it moved TRACK_SEND_DISTANCE, acknowledged, each update replacing the
+ *  one before in the retransmit table.
+ * @date 2026.10.14  */
+void trackTarget() {
+    float north, east, dt, residualNorth, residualEast, speed;
+    uint32_t now = get_time();
+
+    if (!track.isTracking || !sampleTarget(&north, &east))
+        return;
+
+    dt = (now - track.lastSample) / 1000.0f;
+    track.lastSample = now;
+    if (track.hasTrack) {
+        track.north += track.velocityNorth * dt;
+        track.east += track.velocityEast * dt;
+        residualNorth = north - track.north;
+        residualEast = east - track.east;
+        if (hypotf(residualNorth, residualEast) > TRACK_JUMP) {
+            printf("New target under the sight.\n");
+            track.hasTrack = FALSE;
+            track.hasSent = FALSE;
+        }
+    }
+    if (!track.hasTrack) {
+        track.north = north;
+        track.east = east;
+        track.velocityNorth = track.velocityEast = 0.0f;
+        track.hasTrack = TRUE;
+    }
+    else {
+        track.north += TRACK_ALPHA * residualNorth;
+        track.east += TRACK_ALPHA * residualEast;
+        if (dt > 0.0f) {
+            track.velocityNorth += TRACK_BETA * residualNorth / dt;
+            track.velocityEast += TRACK_BETA * residualEast / dt;
+        }
+        speed = hypotf(track.velocityNorth, track.velocityEast);
+        if (speed > TRACK_SPEED_MAX) {
+            track.velocityNorth *= TRACK_SPEED_MAX / speed;
+            track.velocityEast *= TRACK_SPEED_MAX / speed;
+        }
+    }
+
+    if (!track.hasSent)
+        sendTarget(RESCUE_STATUS_NEW, FALSE);
+    else if (now - track.lastSend >= TRACK_SEND_PERIOD
+            && hypotf(track.north - track.sentNorth, track.east - track.sentEast)
+                >= TRACK_SEND_DISTANCE)
+        sendTarget(RESCUE_STATUS_TRACKING, FALSE);
+}
 
+/**
+ * Function: sampleTarget
+ * @param (m) Set to north of the origin of the track.
+ * @param (m) Set to east of it.
+ * @return TRUE, or FALSE if the sight couldn't be projected.
+ * @remark Projects the encoder angles, which are averaged in the
+ *  background. With the GPS, the first sample of a track is its origin.
+ * @date 2026.10.14  */
+BOOL sampleTarget(float *north, float *east) {
+    #ifdef USE_GPS
+    GpsCoordinate target;
+    if (!Navigation_getProjectedGpsCoordinate(&target, Encoder_getYaw(),
+            Encoder_getPitch(), height))
+        return FALSE;
+    if (!track.hasTrack && !track.hasSent) {
+        track.origin = target;
+        track.metersPerLongitude = METERS_PER_COORDINATE * FastMath_cos(
+            (float)target.latitude / GPS_COORDINATE_SCALE * DEGREE_TO_RADIAN);
+    }
+    *north = (target.latitude - track.origin.latitude) * METERS_PER_COORDINATE;
+    *east = (target.longitude - track.origin.longitude)
+        * track.metersPerLongitude;
+    #else
+    Coordinate ned;
+    if (!Navigation_getProjectedCoordinate(&ned, Encoder_getYaw(),
+            Encoder_getPitch(), height))
+        return FALSE;
+    *north = ned.x;
+    *east = ned.y;
+    #endif
+    return TRUE;
+}
+
+/**
+ * Function: sendTarget
+ * @param RESCUE_STATUS_NEW, or RESCUE_STATUS_TRACKING for one that moved.
+ * @param Whether it's the last of the track, reported when the boat
+ *  acknowledges it.
+ * @return None.
+ * @remark Sends the boat the track's position, a new rescue to the boat
+ *  chooseBoat picks.
+ * @date 2026.10.14  */
+void sendTarget(uint8_t status, BOOL isFinal) {
+    #ifdef USE_XBEE
+    ACK_callback callback = isFinal? rescueAcknowledged : NULL;
+    #endif
+    #ifdef USE_GPS
+    int32_t latitude = track.origin.latitude
+        + (int32_t)(track.north / METERS_PER_COORDINATE);
+    int32_t longitude = track.origin.longitude
+        + (int32_t)(track.east / track.metersPerLongitude);
+    if (isFinal || status == RESCUE_STATUS_NEW)
+        printf("Desired coordinate -- Lat: %ld, Lon: %ld (1e-7 degrees)\n",
+            (long)latitude, (long)longitude);
+    #ifdef USE_XBEE
+    if (status == RESCUE_STATUS_NEW) {
+        GpsCoordinate target;
+        target.latitude = latitude;
+        target.longitude = longitude;
+        target.altitude = 0;
+        track.boat = chooseBoat(&target);
+    }
+    Mavlink_send_start_rescue_int(XBEE_UART_ID, track.boat, TRUE, status,
+        latitude, longitude, callback);
+    #endif
+    #else
+    if (isFinal || status == RESCUE_STATUS_NEW)
+        printf("Desired coordinate -- N: %.6f, E: %.6f (m)\n", track.north,
+            track.east);
     #ifdef USE_XBEE
-    Xbee_runSM();
+    if (status == RESCUE_STATUS_NEW)
+        track.boat = chooseBoat(NULL);
+    Mavlink_send_start_rescue(XBEE_UART_ID, track.boat, TRUE, status,
+        track.north, track.east, callback);
     #endif
+    #endif
+    track.sentNorth = track.north;
+    track.sentEast = track.east;
+    track.lastSend = get_time();
+    track.hasSent = TRUE;
+}
+#endif
 
+/**
+ * Function: readAccelerometer
+ * @return None.
+ * @remark Reads the accelerometer off the sensor schedule, and hands its
+ *  gravity vector to the magnetometer for the tilt check.
+ * @date 2026.10.14  */
+#ifdef USE_ACCELEROMETER
+void readAccelerometer() {
+    if (Boot_getStatus(accelerometerBoot) != BOOT_READY)
+        return;
+    Accelerometer_update();
+    #ifdef USE_MAGNETOMETER
+    Magnetometer_setGravity(Accelerometer_getX(), Accelerometer_getY(),
+        Accelerometer_getZ());
+    #endif
 }
+#endif
+
+/**
+ * Function: updateLevel
+ * @return None.
+ * @remark Updates the level lights from the accelerometer, which is read
+ *  off the sensor schedule.
+ * @date 2026.10.14  */
+#ifdef USE_ACCELEROMETER
+void updateLevel() {
+    if (Boot_getStatus(accelerometerBoot) != BOOT_READY)
+        return;
+    updateAccelerometerLEDs();
+}
+#endif
+
+/**
+ * Function: xbeeReceived
+ * @param UART id.
+ * @return None.
+ * @remark Wakes the XBee task from the receive interrupt.
+ * @date 2026.10.14  */
+#ifdef USE_XBEE
+void xbeeReceived(uint8_t id) {
+    Scheduler_signal(xbeeTask);
+}
+
+/**
+ * Function: rescueAcknowledged
+ * @param Message name, messageName_start_rescue.
+ * @param ACK_STATUS_RECIEVED or ACK_STATUS_DEAD.
+ * @return None.
+ * @remark Reports whether the boat got the rescue coordinate.
+ * @date 2026.10.14  */
+void rescueAcknowledged(uint8_t messageName, uint8_t status) {
+    if (status == ACK_STATUS_RECIEVED)
+        printf("Boat %u has the rescue coordinate.\n", track.boat);
+    else
+        printf("Boat %u never acknowledged the rescue coordinate, "
+            "press lock again.\n", track.boat);
+}
+
+/**
+ * Function: boatPositionReceived
+ * @param UART id.
+ * @param BOAT_POSITION message.
+ * @return None.
+ * @remark Keeps the boat's position and guidance state for chooseBoat.
+ * @date 2026.10.14  */
+void boatPositionReceived(uint8_t uart_id, const mavlink_message_t *msg) {
+    mavlink_boat_position_t data;
+    uint8_t index = Mavlink_find_peer(msg->sysid);
+    if (index == MAVLINK_NO_PEER)
+        return;
+    mavlink_msg_boat_position_decode(msg, &data);
+    fleet[index].sysid = msg->sysid;
+    fleet[index].time = get_time();
+    fleet[index].position.latitude = data.latitude;
+    fleet[index].position.longitude = data.longitude;
+    fleet[index].position.altitude = 0;
+    fleet[index].guidance = data.guidance;
+}
+
+/**
+ * Function: chooseBoat
+ * @param Rescue coordinate, or NULL without the GPS.
+ * @return System id of the boat to send the rescue to.
+ * @remark Of the connected boats, the nearest idle one with a recent
+ *  position, then the nearest busy one, then any. With none connected
+ *  it's the first boat, in case it's only out of touch for now.
+ * @date 2026.10.14  */
+uint8_t chooseBoat(const GpsCoordinate *target) {
+    uint8_t i, rank, best = MAVLINK_SYSTEM_BOAT, bestRank = 0;
+    float distance, bestDistance = 0.0f;
+    uint32_t now = get_time();
+    MavlinkPeer peer;
+
+    for (i = 0; i < MAVLINK_PEERS_MAX; i++) {
+        if (!Mavlink_is_peer_connected(i) || Mavlink_get_peer(i, &peer) != SUCCESS
+                || peer.sysid < MAVLINK_SYSTEM_BOAT)
+            continue;
+        rank = 1;
+        distance = 0.0f;
+        if (fleet[i].sysid == peer.sysid
+                && now - fleet[i].time < FLEET_POSITION_TIMEOUT) {
+            rank = (fleet[i].guidance == GUIDANCE_IDLE)? 3 : 2;
+            #ifdef USE_GPS
+            // Near enough flat over a beach, scaled at the track's origin
+            if (target != NULL)
+                distance = hypotf((fleet[i].position.latitude - target->latitude)
+                    * METERS_PER_COORDINATE, (fleet[i].position.longitude
+                    - target->longitude) * track.metersPerLongitude);
+            #endif
+        }
+        if (rank > bestRank || (rank == bestRank && distance < bestDistance)) {
+            best = peer.sysid;
+            bestRank = rank;
+            bestDistance = distance;
+        }
+    }
+    printf("Rescue goes to boat %u.\n", best);
+    return best;
+}
+#endif
+
+/**
+ * Function: bootEncoders
+ * @return BOOT_READY once both encoders have a full window of readings.
+ * @remark Boot step, the readings come from the sensor schedule.
+ * @date 2026.10.14  */
+#ifdef USE_ENCODERS
+BootStatus bootEncoders() {
+    return Encoder_isReady()? BOOT_READY : BOOT_PENDING;
+}
+#endif
+
+/**
+ * Function: bootGps
+ * @return BOOT_READY once the GPS has a fix.
+ * @remark Boot step, the GPS is configured in the background by its
+ *  module. The DGPS survey carries on after this.
+ * @date 2026.10.14  */
+#ifdef USE_GPS
+BootStatus bootGps() {
+    return GPS_hasPosition()? BOOT_READY : BOOT_PENDING;
+}
+#endif
+
+/**
+ * Function: bootLink
+ * @return BOOT_READY once the XBee is configured and a boat is heard.
+ * @remark Boot step, Xbee_runSM does the configuring.
+ * @date 2026.10.14  */
+#ifdef USE_XBEE
+BootStatus bootLink() {
+    XbeeLinkQuality link;
+    if (!Xbee_isReady())
+        return BOOT_PENDING;
+    Xbee_getLinkQuality(&link);
+    return link.isConnected? BOOT_READY : BOOT_PENDING;
+}
+#endif
+
+/**
+ * Function: bootMagnetometer
+ * @return BOOT_READY once a heading was kept.
+ * @remark Boot step, the readings come from the sensor schedule.
+ * @date 2026.10.14  */
+#ifdef USE_MAGNETOMETER
+BootStatus bootMagnetometer() {
+    MagnetometerHeading reading;
+    Magnetometer_getHeading(&reading);
+    return reading.isValid? BOOT_READY : BOOT_PENDING;
+}
+#endif
+
+/**
+ * Function: sendCorrection
+ * @return None.
+ * @remark Broadcasts the error in the command center's GPS fix to the
+ *  boats, after the base position is surveyed in. Scheduled every
+ *  DGPS_PERIOD.
+ * @date 2026.10.14  */
+#if defined(USE_DGPS_BASE) && defined(USE_GPS)
+void sendCorrection() {
+    GpsCorrection correction;
+
+    if (GPS_getCorrection(&correction) == SUCCESS) {
+        #ifdef USE_XBEE
+        Mavlink_send_gps_error(XBEE_UART_ID, FALSE, correction.iTOW,
+            correction.latitude, correction.longitude);
+        #endif
+    }
+}
+#endif
+
+/**
+ * Function: recordState
+ * @return None.
+ * @remark Copies the command center's state into the flight recorder:
+ *  the angles and IMU every RECORD_PERIOD, each new GPS fix, the link
+ *  once a second and every logged event. The recorder takes the events
+ *  out of the error log.
+ * @date 2026.10.14  */
+#ifdef USE_RECORDER
+void recordState() {
+    static uint8_t count = 0;
+    float magneticHeading = 0.0f;
+    ErrorEvent event;
+    #ifdef USE_GPS
+    static uint32_t lastFix = 0;
+    GpsFix fix;
+    #endif
+    #ifdef USE_XBEE
+    XbeeLinkQuality link;
+    #endif
+
+    #ifdef USE_ENCODERS
+    Recorder_recordAngles(Encoder_getPitch(), Encoder_getYaw());
+    #endif
+    #ifdef USE_MAGNETOMETER
+    magneticHeading = Magnetometer_getDegree();
+    #endif
+    #ifdef USE_ACCELEROMETER
+    Recorder_recordImu(Accelerometer_getX(), Accelerometer_getY(),
+        Accelerometer_getZ(), magneticHeading);
+    #endif
+    #ifdef USE_GPS
+    if (GPS_getLastFix(&fix) == SUCCESS && fix.time != lastFix) {
+        lastFix = fix.time;
+        Recorder_recordGps(fix.iTOW, fix.latitude, fix.longitude,
+            fix.altitude, fix.north, fix.east);
+    }
+    #endif
+    #ifdef USE_XBEE
+    if (++count >= RECORD_LINK_EVERY) {
+        count = 0;
+        Xbee_getLinkQuality(&link);
+        Recorder_recordLink(link.isConnected, link.loss, link.peerLoss,
+            link.rtt, link.jitter);
+    }
+    #endif
+    while (Error_read(&event))
+        Recorder_recordEvent(&event);
+}
+#endif
 
 
 /**
@@ -13,6 +13,8 @@
 #include "Serial.h"
 #include "Board.h"
 #include "Ports.h"
+#include "FastMath.h"
+#include "AngleFilter.h"
 #include "Encoder.h"
 
 
@@ -20,15 +22,29 @@
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 // List of registers for Encoder
-#define SLAVE_VERTICAL_READ_ADDRESS          0x81
-#define SLAVE_VERTICAL_WRITE_ADDRESS         0x80
-#define SLAVE_HORIZONTAL_READ_ADDRESS        0x87
-#define SLAVE_HORIZONTAL_WRITE_ADDRESS       0x86
+#define SLAVE_VERTICAL_ADDRESS               0x40
+#define SLAVE_HORIZONTAL_ADDRESS             0x43
 #define SLAVE_ANGLE_ADDRESS                  0xFE
+#define SLAVE_CLOCK_FREQ                     400000 // (Hz) fast mode
 
 #define PI 3.14159265358979323846
 
-#define ACCUMULATOR_LENGTH  150
+// The encoders report a 14-bit binary angle
+#define RAW_TO_ANGLE16(raw)     ((uint16_t)((raw) << 2))
+
+// Samples averaged into an angle
+#define WINDOW_LENGTH       32
+
+/***********************************************************************
+ * PRIVATE TYPEDEFS                                                    *
+ ***********************************************************************/
+
+// Recent readings of one encoder, as binary angles (see AngleFilter.h)
+typedef struct {
+    uint8_t address;
+    AngleFilter filter;
+    uint16_t angles[WINDOW_LENGTH];
+} Window;
 
 /***********************************************************************
  * PRIVATE VARIABLES                                                   *
@@ -39,11 +55,10 @@ I2C_MODULE      ENCODER_I2C_ID = I2C1;
 // Set Desired Operation Frequency
 //#define I2C_CLOCK_FREQ  100000 // (Hz)
 
-float angleAccumulator = 0; // (degrees) accumlated angles
-float pitchAngle = 0; // (degrees) calculated angle
-float yawAngle = 0; // (degrees) calculated angle
-float zeroPitchAngle = 0; // (degrees)
-float zeroYawAngle = 0; // (degrees)
+Window pitchWindow = { SLAVE_VERTICAL_ADDRESS };
+Window yawWindow = { SLAVE_HORIZONTAL_ADDRESS };
+uint16_t zeroPitchAngle = 0; // binary angle
+uint16_t zeroYawAngle = 0; // binary angle
 
 BOOL useZeroAngle = FALSE;
 
@@ -54,39 +69,50 @@ BOOL useZeroAngle = FALSE;
  * PRIVATE PROTOTYPES                                                  *
  ***********************************************************************/
 
-void accumulateAngle(int READ_ADDRESS,int WRITE_ADDRESS);
-float calculateAngle(float zeroAngle,int READ_ADDRESS,int WRITE_ADDRESS);
-uint16_t readSensor(int SLAVE_READ_ADDRESS,int SLAVE_WRITE_ADDRESS);
+void accumulateAngle(Window *window);
+float calculateAngle(const Window *window, uint16_t zeroAngle);
+BOOL readSensor(uint8_t address, uint16_t *raw);
 
 /***********************************************************************
  * PUBLIC FUNCTIONS                                                    *
  ***********************************************************************/
 
 
- void Encoder_runSM(){
-
-     pitchAngle = calculateAngle(zeroPitchAngle,SLAVE_VERTICAL_READ_ADDRESS,
-                                   SLAVE_VERTICAL_WRITE_ADDRESS);
-     yawAngle = calculateAngle(zeroYawAngle,SLAVE_HORIZONTAL_READ_ADDRESS,
-                                     SLAVE_HORIZONTAL_WRITE_ADDRESS);
- }
+void Encoder_runSM(){
+    accumulateAngle(&pitchWindow);
+    accumulateAngle(&yawWindow);
+}
 
 void Encoder_init() {
-    // Do nothing
+    AngleFilter_initWindow(&pitchWindow.filter, pitchWindow.angles,
+        WINDOW_LENGTH);
+    AngleFilter_initWindow(&yawWindow.filter, yawWindow.angles, WINDOW_LENGTH);
+    I2C_addDevice(ENCODER_I2C_ID, SLAVE_VERTICAL_ADDRESS, SLAVE_CLOCK_FREQ);
+    I2C_addDevice(ENCODER_I2C_ID, SLAVE_HORIZONTAL_ADDRESS, SLAVE_CLOCK_FREQ);
 }
 
 void Encoder_setZeroAngle(){
-    zeroPitchAngle = pitchAngle;
-    zeroYawAngle = yawAngle;
+    zeroPitchAngle = AngleFilter_getMean(&pitchWindow.filter);
+    zeroYawAngle = AngleFilter_getMean(&yawWindow.filter);
+}
+
+void Encoder_getZeroAngles(uint16_t *pitch, uint16_t *yaw) {
+    *pitch = zeroPitchAngle;
+    *yaw = zeroYawAngle;
+}
+
+void Encoder_setZeroAngles(uint16_t pitch, uint16_t yaw) {
+    zeroPitchAngle = pitch;
+    zeroYawAngle = yaw;
 }
 
 
 float Encoder_getPitch() {
-    return pitchAngle;
+    return calculateAngle(&pitchWindow, zeroPitchAngle);
 }
 
 float Encoder_getYaw() {
-    return yawAngle;
+    return calculateAngle(&yawWindow, zeroYawAngle);
 }
 
 void Encoder_enableZeroAngle() {
@@ -97,92 +123,52 @@ void Encoder_disableZeroAngle() {
     useZeroAngle = FALSE;
 }
 
+BOOL Encoder_isReady() {
+    return AngleFilter_getCount(&pitchWindow.filter) >= WINDOW_LENGTH
+        && AngleFilter_getCount(&yawWindow.filter) >= WINDOW_LENGTH;
+}
+
 
 /******************************************************************************
  * PRIVATE FUNCTIONS                                                          *
  ******************************************************************************/
 
-
-void accumulateAngle(int READ_ADDRESS,int WRITE_ADDRESS) {
-   uint16_t rawAngle = readSensor(READ_ADDRESS,WRITE_ADDRESS);
-   angleAccumulator += (float)((360/pow(2,14))*rawAngle);
+/**
+ * Function: accumulateAngle
+ * @param Encoder to sample.
+ * @return None.
+ * @remark Reads the encoder once and pushes the reading into its window,
+ *  replacing the oldest once the window is full. A failed read is left out.
+ * @date 2026.10.14  */
+void accumulateAngle(Window *window) {
+    uint16_t rawAngle;
+    if (readSensor(window->address, &rawAngle) == SUCCESS)
+        AngleFilter_add(&window->filter, RAW_TO_ANGLE16(rawAngle));
 }
 
+// mean of the window in degrees, from the zero angle if that's enabled
+float calculateAngle(const Window *window, uint16_t zeroAngle){
+    uint16_t angle = AngleFilter_getMean(&window->filter);
+    // Binary angles wrap on their own, so no fixing up around zero
+    if(useZeroAngle)
+        angle -= zeroAngle;
+    return ANGLE16_TO_DEGREES(angle);
+}
 
-float calculateAngle(float zeroAngle,int READ_ADDRESS,int WRITE_ADDRESS){
-     int count;
-     angleAccumulator = 0;
-     for(count = 0; count < ACCUMULATOR_LENGTH; count++){
-        accumulateAngle(READ_ADDRESS,WRITE_ADDRESS);
-    }
-
-    float finalAngle = angleAccumulator/ACCUMULATOR_LENGTH;
-    // TODO remove magick numbers
-    if(useZeroAngle){
-        if(finalAngle >= zeroAngle)
-            finalAngle = finalAngle - zeroAngle;
-        else
-            finalAngle = 360 - (zeroAngle - finalAngle);
-        if(finalAngle > 359.98)
-            finalAngle = 0;
-    }
-    return finalAngle;
- }
-
-
-uint16_t readSensor(int SLAVE_READ_ADDRESS,int SLAVE_WRITE_ADDRESS) {
-    int8_t success = FALSE;
-    uint16_t data = 0;
 
-    do {
-        // Send the start bit with the restart flag low
-        if(!I2C_startTransfer(ENCODER_I2C_ID, I2C_WRITE )){
-            #ifdef DEBUG
-            printf("FAILED initial transfer!\n");
-            #endif
-            break;
-        }
-        // Transmit the slave's address to notify it
-        if (!I2C_sendData(ENCODER_I2C_ID, SLAVE_WRITE_ADDRESS))
-            break;
-
-        // Tranmit the read address module
-        if(!I2C_sendData(ENCODER_I2C_ID,SLAVE_ANGLE_ADDRESS)){
-            #ifdef DEBUG
-            printf("Error: Sent byte was not acknowledged\n");
-            #endif
-            break;
-        }
+BOOL readSensor(uint8_t address, uint16_t *raw) {
+    uint8_t data[2];
 
-        // Send a Repeated Started condition
-        if(!I2C_startTransfer(ENCODER_I2C_ID,I2C_READ)){
-            #ifdef DEBUG
-            printf("FAILED Repeated start!\n");
-            #endif
-            break;
-        }
-        // Transmit the address with the READ bit set
-        if (!I2C_sendData(ENCODER_I2C_ID, SLAVE_READ_ADDRESS))
-            break;
-        
-        // Read the I2C bus twice
-        data = (I2C_getData(ENCODER_I2C_ID) << 6);
-        I2C_acknowledgeRead(ENCODER_I2C_ID, TRUE);
-        while(!I2C_hasAcknowledged(ENCODER_I2C_ID));
-        data |= (I2C_getData(ENCODER_I2C_ID) & 0x3F);
-
-        // Send the stop bit to finish the transfer
-        I2C_stopTransfer(ENCODER_I2C_ID);
-
-        success = TRUE;
-    } while(0);
-    if (!success) {
+    if (I2C_readRegisters(ENCODER_I2C_ID, address, SLAVE_ANGLE_ADDRESS, data, 2)
+            != SUCCESS) {
         #ifdef DEBUG
         printf("Data transfer unsuccessful.\n");
         #endif
-        return FALSE;
+        return FAILURE;
     }
-    return data;
+    // 14 bits, the high byte then the low six bits
+    *raw = ((uint16_t)data[0] << 6) | (data[1] & 0x3F);
+    return SUCCESS;
 }
 
 //#define ENCODER_TEST
@@ -9,23 +9,41 @@
    Error handling module.
    
  Notes
+   The log is a ring indexed by free running head and tail counts, masked
+   down to the ring when used, so full and empty never look alike and
+   pushing is the same few instructions every time. Both only move with
+   interrupts off, so an interrupt can log in the middle of a read.
 
  History
  When           Who         What/Why
  -------------- ---         --------
  12-28-12 12:33 dagoodma    Created file.
+ 10-14-26                   Timestamped ring log of events.
 ***********************************************************************/
 
+#include <stdio.h>
+#include <plib.h>
 #include "Error.h"
-#include "Util.h"
+#include "Timer.h"
 
 
 /***********************************************************************
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 
+#define LOG_MASK (ERROR_LOG_LENGTH - 1)
+
+#if (ERROR_LOG_LENGTH & LOG_MASK) != 0 || ERROR_LOG_LENGTH > 128
+#error "ERROR_LOG_LENGTH has to be a power of two, at most 128"
+#endif
+
 static uint8_t errorCode = 0;
 
+static ErrorEvent events[ERROR_LOG_LENGTH];
+static volatile uint8_t head = 0, tail = 0; // written, read
+static volatile uint16_t dropped = 0;
+static uint8_t policy = ERROR_LOG_OVERWRITE;
+
 /**********************************************************************
  * PRIVATE FUNCTIONS                                                  *
  **********************************************************************/
@@ -43,6 +61,7 @@ static uint8_t errorCode = 0;
  **********************************************************************/
 void error(uint8_t code) {
     errorCode = code;
+    Error_log(ERROR_MODULE_NONE, code, 0);
 }
 
 /**********************************************************************
@@ -76,4 +95,123 @@ uint8_t has_error() {
     return errorCode != 0;
 }
 
+/**********************************************************************
+ * Function: Error_log()
+ * @param Module it happened in, ERROR_MODULE_*.
+ * @param Error code.
+ * @param Anything that goes with it.
+ * @return none
+ * @remark Stamped with get_time(). Safe from an interrupt.
+ **********************************************************************/
+void Error_log(uint8_t module, uint8_t code, uint16_t arg) {
+    uint32_t time = get_time();
+    unsigned int intStatus = INTDisableInterrupts();
+    ErrorEvent *event;
+
+    if ((uint8_t)(head - tail) >= ERROR_LOG_LENGTH) {
+        dropped++;
+        if (policy == ERROR_LOG_KEEP_FIRST) {
+            INTRestoreInterrupts(intStatus);
+            return;
+        }
+        tail++;
+    }
+    event = &events[head & LOG_MASK];
+    event->time = time;
+    event->arg = arg;
+    event->module = module;
+    event->code = code;
+    head++;
+    INTRestoreInterrupts(intStatus);
+}
+
+/**********************************************************************
+ * Function: Error_read()
+ * @param Set to the oldest event.
+ * @return A true value if there was one, it's taken out of the ring.
+ * @remark none
+ **********************************************************************/
+uint8_t Error_read(ErrorEvent *event) {
+    unsigned int intStatus = INTDisableInterrupts();
+    if (head == tail) {
+        INTRestoreInterrupts(intStatus);
+        return FALSE;
+    }
+    *event = events[tail & LOG_MASK];
+    tail++;
+    INTRestoreInterrupts(intStatus);
+    return TRUE;
+}
+
+/**********************************************************************
+ * Function: Error_getCount()
+ * @return Events waiting to be read.
+ * @remark none
+ **********************************************************************/
+uint8_t Error_getCount() {
+    return (uint8_t)(head - tail);
+}
+
+/**********************************************************************
+ * Function: Error_getDropped()
+ * @return Events lost to a full ring since startup.
+ * @remark Overwritten or refused, depending on the policy.
+ **********************************************************************/
+uint16_t Error_getDropped() {
+    return dropped;
+}
+
+/**********************************************************************
+ * Function: Error_setPolicy()
+ * @param ERROR_LOG_OVERWRITE, the default, or ERROR_LOG_KEEP_FIRST.
+ * @return none
+ * @remark none
+ **********************************************************************/
+void Error_setPolicy(uint8_t newPolicy) {
+    policy = newPolicy;
+}
+
+/**********************************************************************
+ * Function: Error_print()
+ * @return none
+ * @remark Prints and reads every event waiting, oldest first.
+ **********************************************************************/
+void Error_print() {
+    ErrorEvent event;
+    if (dropped > 0)
+        printf("%u events dropped\n", dropped);
+    while (Error_read(&event)) {
+        printf("%lu ms: module %u, code %u, arg %u\n",
+            (unsigned long)event.time, event.module, event.code, event.arg);
+    }
+}
+
+//#define ERROR_TEST
+#ifdef ERROR_TEST
+
+#include "Serial.h"
+
+int main() {
+    uint16_t i;
+    Board_init();
+    Serial_init();
+    Timer_init();
+
+    printf("Logging %u events into %u\n", ERROR_LOG_LENGTH + 4,
+        ERROR_LOG_LENGTH);
+    for (i = 0; i < ERROR_LOG_LENGTH + 4; i++)
+        Error_log(ERROR_MODULE_NONE, ERROR_TIMER_OFF, i);
+    printf("Overwrite keeps args 4 to %u:\n", ERROR_LOG_LENGTH + 3);
+    Error_print();
+
+    Error_setPolicy(ERROR_LOG_KEEP_FIRST);
+    for (i = 0; i < ERROR_LOG_LENGTH + 4; i++)
+        Error_log(ERROR_MODULE_NONE, ERROR_TIMER_OFF, i);
+    printf("Keep first keeps args 0 to %u:\n", ERROR_LOG_LENGTH - 1);
+    Error_print();
+
+    while (1);
+    return SUCCESS;
+}
 
+#endif
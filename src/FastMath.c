@@ -0,0 +1,390 @@
+/**********************************************************************
+ Module
+   FastMath.c
+
+ Revision
+   1.0.0
+
+ Description
+   Float and fixed-point sin, cos, tan and atan2 without libm.
+
+ Notes
+   The float kernels are minimax fits on [-PI/4, PI/4] (and on
+   [-tan(PI/8), tan(PI/8)] for atan), each under 5e-9 before rounding, so
+   the float arithmetic is what sets the 1e-6 accuracy. PI/2 is split in
+   three for the range reduction (Cody and Waite), the first two parts
+   have few enough bits that multiplying them by the quadrant is exact.
+
+   The tables hold the first quarter of a sine in Q15, and the first
+   octant of atan in a quarter of a binary angle count, both with one
+   extra entry so the interpolation never needs a bounds check.
+
+***********************************************************************/
+
+#include <stdint.h>
+#include "FastMath.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define TWO_OVER_PI     0.636619772367581f
+#define HALF_PI_HI      1.5703125f
+#define HALF_PI_MID     4.837512969970703125e-4f
+#define HALF_PI_LO      7.54978995489188216e-8f
+#define QUARTER_PI      0.785398163397448f
+#define TAN_EIGHTH_PI   0.414213562373095f
+
+// sin(r) = r + r^3*(S1 + r^2*(S2 + r^2*S3))
+#define S1  -1.6666650669059827e-1f
+#define S2  8.33197865406766e-3f
+#define S3  -1.949563537561364e-4f
+
+// cos(r) = 1 + r^2*(C1 + r^2*(C2 + r^2*(C3 + r^2*C4)))
+#define C1  -4.9999999725446725e-1f
+#define C2  4.166662335648043e-2f
+#define C3  -1.3886764672308058e-3f
+#define C4  2.439052357447585e-5f
+
+// atan(u) = u + u^3*(A1 + u^2*(A2 + u^2*(A3 + u^2*A4)))
+#define A1  -3.3332756651832685e-1f
+#define A2  1.9971878834165316e-1f
+#define A3  -1.382444973109904e-1f
+#define A4  7.90258727626395e-2f
+
+#define TABLE_BITS      8
+#define TABLE_SIZE      (1 << TABLE_BITS)
+
+// Binary angle within a quarter turn is 14 bits
+#define SINE_FRACTION_BITS  (14 - TABLE_BITS)
+// Tangent within the first octant is Q15, 0 to 1.0
+#define ATAN_FRACTION_BITS  (15 - TABLE_BITS)
+
+#define ABS(x)  (((x) < 0)? -(x) : (x))
+
+// A float's bits are roughly a scaled log of it, so taking a quarter of
+//  them off this is roughly its inverse fourth root. Tuned so one Newton
+//  step is within 0.8%.
+#define INVERSE_FOURTH_ROOT_MAGIC   0x4F584000
+#define FOURTH_ROOT_STEPS           3
+
+/***********************************************************************
+ * PRIVATE VARIABLES                                                   *
+ ***********************************************************************/
+
+// sin(PI/2 * i/256) in Q15
+static const int16_t sineTable[TABLE_SIZE + 1] = {
+    0, 201, 402, 603, 804, 1005, 1206, 1407, 1608, 1809,
+    2009, 2210, 2410, 2611, 2811, 3012, 3212, 3412, 3612, 3811,
+    4011, 4210, 4410, 4609, 4808, 5007, 5205, 5404, 5602, 5800,
+    5998, 6195, 6393, 6590, 6786, 6983, 7179, 7375, 7571, 7767,
+    7962, 8157, 8351, 8545, 8739, 8933, 9126, 9319, 9512, 9704,
+    9896, 10087, 10278, 10469, 10659, 10849, 11039, 11228, 11417, 11605,
+    11793, 11980, 12167, 12353, 12539, 12725, 12910, 13094, 13279, 13462,
+    13645, 13828, 14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269,
+    15446, 15623, 15800, 15976, 16151, 16325, 16499, 16673, 16846, 17018,
+    17189, 17360, 17530, 17700, 17869, 18037, 18204, 18371, 18537, 18703,
+    18868, 19032, 19195, 19357, 19519, 19680, 19841, 20000, 20159, 20317,
+    20475, 20631, 20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+    22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027, 23170, 23311,
+    23452, 23592, 23731, 23870, 24007, 24143, 24279, 24413, 24547, 24680,
+    24811, 24942, 25072, 25201, 25329, 25456, 25582, 25708, 25832, 25955,
+    26077, 26198, 26319, 26438, 26556, 26674, 26790, 26905, 27019, 27133,
+    27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001, 28105, 28208,
+    28310, 28411, 28510, 28609, 28706, 28803, 28898, 28992, 29085, 29177,
+    29268, 29358, 29447, 29534, 29621, 29706, 29791, 29874, 29956, 30037,
+    30117, 30195, 30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783,
+    30852, 30919, 30985, 31050, 31113, 31176, 31237, 31297, 31356, 31414,
+    31470, 31526, 31580, 31633, 31685, 31736, 31785, 31833, 31880, 31926,
+    31971, 32014, 32057, 32098, 32137, 32176, 32213, 32250, 32285, 32318,
+    32351, 32382, 32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+    32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717, 32728, 32737,
+    32745, 32752, 32757, 32761, 32765, 32766, 32767
+};
+
+// atan(i/256) in quarters of a binary angle count
+static const uint16_t atanTable[TABLE_SIZE + 1] = {
+    0, 163, 326, 489, 652, 815, 978, 1141, 1303, 1466,
+    1629, 1792, 1954, 2117, 2279, 2442, 2604, 2767, 2929, 3091,
+    3253, 3415, 3577, 3738, 3900, 4061, 4223, 4384, 4545, 4706,
+    4867, 5028, 5188, 5349, 5509, 5669, 5829, 5989, 6148, 6308,
+    6467, 6626, 6784, 6943, 7101, 7260, 7418, 7575, 7733, 7890,
+    8047, 8204, 8361, 8517, 8673, 8829, 8985, 9140, 9296, 9450,
+    9605, 9759, 9914, 10067, 10221, 10374, 10527, 10680, 10832, 10984,
+    11136, 11287, 11439, 11590, 11740, 11890, 12040, 12190, 12339, 12488,
+    12637, 12785, 12933, 13081, 13228, 13375, 13522, 13668, 13814, 13959,
+    14105, 14249, 14394, 14538, 14682, 14825, 14968, 15111, 15253, 15395,
+    15537, 15678, 15819, 15960, 16100, 16239, 16379, 16518, 16656, 16794,
+    16932, 17069, 17206, 17343, 17479, 17615, 17750, 17885, 18020, 18154,
+    18288, 18421, 18554, 18687, 18819, 18951, 19083, 19213, 19344, 19474,
+    19604, 19733, 19862, 19991, 20119, 20247, 20374, 20501, 20627, 20753,
+    20879, 21004, 21129, 21254, 21378, 21501, 21624, 21747, 21870, 21992,
+    22113, 22234, 22355, 22475, 22595, 22714, 22834, 22952, 23070, 23188,
+    23306, 23423, 23539, 23655, 23771, 23886, 24001, 24116, 24230, 24344,
+    24457, 24570, 24682, 24795, 24906, 25017, 25128, 25239, 25349, 25459,
+    25568, 25677, 25785, 25893, 26001, 26108, 26215, 26321, 26427, 26533,
+    26638, 26743, 26848, 26952, 27056, 27159, 27262, 27364, 27467, 27568,
+    27670, 27771, 27871, 27972, 28072, 28171, 28270, 28369, 28467, 28565,
+    28663, 28760, 28857, 28953, 29050, 29145, 29241, 29336, 29430, 29525,
+    29619, 29712, 29805, 29898, 29991, 30083, 30175, 30266, 30357, 30448,
+    30538, 30628, 30718, 30807, 30896, 30985, 31073, 31161, 31248, 31336,
+    31423, 31509, 31595, 31681, 31767, 31852, 31937, 32022, 32106, 32190,
+    32273, 32357, 32439, 32522, 32604, 32686, 32768
+};
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static int32_t reduceAngle(float angle, float *remainder);
+static float sinKernel(float r);
+static float cosKernel(float r);
+static float atanKernel(float u);
+static int16_t quarterSine(uint16_t angle);
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+float FastMath_sin(float angle) {
+    float r;
+    switch (reduceAngle(angle, &r) & 0x3) {
+        case 0: return sinKernel(r);
+        case 1: return cosKernel(r);
+        case 2: return -sinKernel(r);
+        default: return -cosKernel(r);
+    }
+}
+
+float FastMath_cos(float angle) {
+    float r;
+    switch (reduceAngle(angle, &r) & 0x3) {
+        case 0: return cosKernel(r);
+        case 1: return -sinKernel(r);
+        case 2: return -cosKernel(r);
+        default: return sinKernel(r);
+    }
+}
+
+void FastMath_sinCos(float angle, float *sine, float *cosine) {
+    float r;
+    int32_t quadrant = reduceAngle(angle, &r);
+    float s = sinKernel(r);
+    float c = cosKernel(r);
+
+    switch (quadrant & 0x3) {
+        case 0: *sine = s; *cosine = c; break;
+        case 1: *sine = c; *cosine = -s; break;
+        case 2: *sine = -s; *cosine = -c; break;
+        default: *sine = -c; *cosine = s; break;
+    }
+}
+
+float FastMath_tan(float angle) {
+    float r;
+    int32_t quadrant = reduceAngle(angle, &r);
+    float s = sinKernel(r);
+    float c = cosKernel(r);
+
+    // tan has a period of PI, odd quadrants are -cot
+    return (quadrant & 0x1)? -c / s : s / c;
+}
+
+float FastMath_atan2(float y, float x) {
+    float ax = ABS(x), ay = ABS(y);
+    float t, result;
+    char swapped = ay > ax;
+
+    if (ax == 0.0f && ay == 0.0f)
+        return 0.0f;
+
+    t = swapped? ax / ay : ay / ax;
+    if (t > TAN_EIGHTH_PI)
+        result = QUARTER_PI + atanKernel((t - 1.0f) / (t + 1.0f));
+    else
+        result = atanKernel(t);
+
+    if (swapped)
+        result = FASTMATH_HALF_PI - result;
+    if (x < 0.0f)
+        result = FASTMATH_PI - result;
+    return (y < 0.0f)? -result : result;
+}
+
+int16_t FastMath_sinQ15(uint16_t angle) {
+    uint16_t within = angle & (ANGLE16_QUARTER_TURN - 1);
+    switch (angle >> 14) {
+        case 0: return quarterSine(within);
+        case 1: return quarterSine(ANGLE16_QUARTER_TURN - within);
+        case 2: return -quarterSine(within);
+        default: return -quarterSine(ANGLE16_QUARTER_TURN - within);
+    }
+}
+
+int16_t FastMath_cosQ15(uint16_t angle) {
+    return FastMath_sinQ15(angle + ANGLE16_QUARTER_TURN);
+}
+
+float FastMath_fourthRoot(float value) {
+    union {
+        float f;
+        uint32_t i;
+    } bits;
+    float y, y2;
+    uint8_t step;
+    if (value <= 0.0f)
+        return 0.0f;
+
+    bits.f = value;
+    bits.i = INVERSE_FOURTH_ROOT_MAGIC - (bits.i >> 2);
+    y = bits.f;
+    // Newton on 1/y^4 - value, y' = y * (5 - value * y^4) / 4
+    for (step = 0; step < FOURTH_ROOT_STEPS; step++) {
+        y2 = y * y;
+        y = y * (1.25f - 0.25f * value * y2 * y2);
+    }
+    return value * y * y * y;
+}
+
+uint16_t FastMath_atan2Angle16(int32_t y, int32_t x) {
+    uint32_t ax = ABS((int64_t)x), ay = ABS((int64_t)y);
+    uint32_t small, large, t, octant;
+    char swapped = ay > ax;
+
+    if (ax == 0 && ay == 0)
+        return 0;
+
+    small = swapped? ax : ay;
+    large = swapped? ay : ax;
+    // Keep small << 15 from overflowing, only the ratio matters
+    while (large > 0x0000FFFF) {
+        small >>= 1;
+        large >>= 1;
+    }
+    t = (small << 15) / large; // Q15 tangent, 0 to 1.0
+
+    if (t >= Q15_ONE) {
+        octant = atanTable[TABLE_SIZE];
+    }
+    else {
+        uint16_t i = t >> ATAN_FRACTION_BITS;
+        uint16_t fraction = t & ((1 << ATAN_FRACTION_BITS) - 1);
+        octant = atanTable[i] + (((uint32_t)(atanTable[i + 1] - atanTable[i])
+            * fraction) >> ATAN_FRACTION_BITS);
+    }
+    octant = (octant + 2) >> 2;
+
+    if (swapped)
+        octant = ANGLE16_QUARTER_TURN - octant;
+    if (x < 0)
+        octant = ANGLE16_HALF_TURN - octant;
+    return (uint16_t)((y < 0)? -octant : octant);
+}
+
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: reduceAngle
+ * @param Angle in radians.
+ * @param Where to store the angle reduced to [-PI/4, PI/4].
+ * @return Number of quarter turns taken off, only the low two bits are
+ *  needed to pick the quadrant.
+ **********************************************************************/
+static int32_t reduceAngle(float angle, float *remainder) {
+    float k = angle * TWO_OVER_PI;
+    int32_t quadrant = (int32_t)((k < 0.0f)? k - 0.5f : k + 0.5f);
+    float q = (float)quadrant;
+
+    *remainder = ((angle - q * HALF_PI_HI) - q * HALF_PI_MID) - q * HALF_PI_LO;
+    return quadrant;
+}
+
+static float sinKernel(float r) {
+    float r2 = r * r;
+    return r + r * r2 * (S1 + r2 * (S2 + r2 * S3));
+}
+
+static float cosKernel(float r) {
+    float r2 = r * r;
+    return 1.0f + r2 * (C1 + r2 * (C2 + r2 * (C3 + r2 * C4)));
+}
+
+static float atanKernel(float u) {
+    float u2 = u * u;
+    return u + u * u2 * (A1 + u2 * (A2 + u2 * (A3 + u2 * A4)));
+}
+
+/**********************************************************************
+ * Function: quarterSine
+ * @param Binary angle from 0 to a quarter turn, inclusive.
+ * @return The sine in Q15, interpolated from the table.
+ **********************************************************************/
+static int16_t quarterSine(uint16_t angle) {
+    uint16_t i = angle >> SINE_FRACTION_BITS;
+    int32_t fraction = angle & ((1 << SINE_FRACTION_BITS) - 1);
+
+    if (i >= TABLE_SIZE)
+        return sineTable[TABLE_SIZE];
+    return sineTable[i] + (((sineTable[i + 1] - sineTable[i]) * fraction
+        + (1 << (SINE_FRACTION_BITS - 1))) >> SINE_FRACTION_BITS);
+}
+
+//#define FASTMATH_TEST
+#ifdef FASTMATH_TEST
+
+#include <stdio.h>
+#include <math.h>
+#include "Board.h"
+#include "Serial.h"
+#include "Timer.h"
+
+int main() {
+    Board_init();
+    Serial_init();
+    Timer_init();
+
+    printf("Comparing FastMath against libm...\n");
+    float angle, worstSin = 0, worstCos = 0, worstAtan = 0, worstRoot = 0;
+    int16_t worstQ15 = 0;
+    uint32_t start, fastTime, libmTime;
+    volatile float sink;
+    int i;
+
+    for (angle = -20.0f; angle < 20.0f; angle += 0.001f) {
+        float e = fabsf(FastMath_sin(angle) - (float)sin(angle));
+        if (e > worstSin) worstSin = e;
+        e = fabsf(FastMath_cos(angle) - (float)cos(angle));
+        if (e > worstCos) worstCos = e;
+        e = fabsf(FastMath_atan2(sinf(angle), cosf(angle) * 0.7f)
+            - (float)atan2(sinf(angle), cosf(angle) * 0.7f));
+        if (e > worstAtan) worstAtan = e;
+    }
+    for (i = 0; i < ANGLE16_TURN; i += 7) {
+        int16_t e = FastMath_sinQ15(i)
+            - (int16_t)(32767 * sin(ANGLE16_TO_RADIANS(i)));
+        if (ABS(e) > worstQ15) worstQ15 = ABS(e);
+    }
+    for (angle = 150.0f; angle < 700.0f; angle += 0.01f) {
+        float e = fabsf(FastMath_fourthRoot(angle * angle * angle * angle)
+            - angle) / angle;
+        if (e > worstRoot) worstRoot = e;
+    }
+    printf("Worst sin: %e, cos: %e, atan2: %e, sinQ15: %d, fourth root: %e\n",
+        worstSin, worstCos, worstAtan, worstQ15, worstRoot);
+
+    start = get_time();
+    for (i = 0; i < 1000; i++)
+        sink = FastMath_sin(i * 0.01f);
+    fastTime = get_time() - start;
+    start = get_time();
+    for (i = 0; i < 1000; i++)
+        sink = sin(i * 0.01f);
+    libmTime = get_time() - start;
+    printf("1000 sin: %u ms fast, %u ms libm\n", fastTime, libmTime);
+
+    return SUCCESS;
+}
+
+#endif
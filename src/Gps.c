@@ -7,12 +7,15 @@
 
 #include <xc.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 #include <plib.h>
 #include "Serial.h"
 #include "Timer.h"
 #include "Board.h"
 #include "Uart.h"
 #include "Gps.h"
+#include "Error.h"
 
 
 
@@ -23,16 +26,30 @@
 //#define DEBUG_STATE
 
 
-#define START_BAUDRATE      38400 // (baud)
-#define DESIRED_BAUDRATE    START_BAUDRATE
+#define START_BAUDRATE      38400 // (baud) u-blox default
+#define DESIRED_BAUDRATE    115200 // (baud) set by the auto-configuration
 
 #define GPS_UART_ID         UART2_ID
 #define GPS_UART_BAUDRATE   START_BAUDRATE
 
+// Navigation solution period set by the auto-configuration
+#ifndef GPS_NAV_PERIOD
+#define GPS_NAV_PERIOD      200 // (ms) 5 Hz, the most a LEA-6 will do
+#endif
+
 
 #define RAW_BUFFER_SIZE         255 // (bytes) maximum gps message size
 #define CHECKSUM_BYTES          2 // (bytes) number in checksum
 
+/* Most bytes GPS_runSM will take from the UART per call. A 5 Hz epoch of
+ * POSLLH + STATUS + VELNED is about 120 bytes, so this clears a burst of
+ * several epochs in one pass but still bounds how long the rest of the
+ * main loop waits. Override from the project to tune it. */
+#ifndef GPS_BYTE_BUDGET
+#define GPS_BYTE_BUDGET         256 // (bytes)
+#endif
+#define READ_CHUNK              32 // (bytes) copied out of the UART at once
+
 // Field indexes ( see pg. 60 in ublox UBX protocol specifications)
 #define SYNC1_INDEX             0 // index of first sync byte
 #define SYNC2_INDEX             1 // index of second sync byte
@@ -49,13 +66,83 @@
 #define NAV_POSLLH_ID           0x02 // geodetic postion message id+
 #define NAV_STATUS_ID           0x03 // receiver navigation status (fix/nofix)
 #define NAV_VELOCITY_ID         0x12 // velocity NED navigation message
+#define NAV_PVT_ID              0x07 // position, velocity and time solution
+#define ACK_CLASS               0x05 // acknowledgement message class
+#define ACK_NAK_ID              0x00 // command was rejected
+#define ACK_ACK_ID              0x01 // command was accepted
+#define CFG_CLASS               0x06 // configuration message class
+#define CFG_PRT_ID              0x00 // port settings
+#define CFG_MSG_ID              0x01 // set the rate of a message
+#define CFG_RATE_ID             0x08 // navigation solution rate
+#define CFG_CFG_ID              0x09 // save the configuration
+#define AID_CLASS               0x0B // aiding message class
+#define AID_INI_ID              0x01 // position, time and clock to start from
+
+#define PVT_FIX_OK_FLAG         0x01 // gnssFixOK bit of the NAV-PVT flags
+#define CFG_MSG_LENGTH          3 // (bytes) class, id, and rate
+
+// CFG-PRT fields for UART1 of the receiver, 8N1 with UBX+NMEA in, UBX out
+#define PRT_PORT_UART1          1
+#define PRT_MODE_8N1            0x000008D0
+#define PRT_PROTOCOL_UBX        0x0001
+#define PRT_PROTOCOL_NMEA       0x0002
+#define RATE_TIME_GPS           1 // align epochs to GPS time
+
+// CFG-CFG, the port, message and navigation settings into every memory
+//  the receiver has (battery backed RAM, flash, EEPROM)
+#define CFG_SAVE_MASK           0x0000000B
+#define CFG_DEVICE_MASK         0x07
+
+// AID-INI, position only as latitude, longitude and altitude
+#define AID_FLAG_POSITION       0x00000001
+#define AID_FLAG_LLA            0x00000020
+#define AID_ALTITUDE_PER_CM     10 // (mm)
+
+// Auto-configuration timing
+#define CONFIG_SWITCH_DELAY     20 // (ms) let CFG-PRT leave the shift register
+#define CONFIG_ACK_TIMEOUT      250 // (ms) wait for an ACK before resending
+#define CONFIG_RETRIES          3 // resends before trying the baud switch again
+#define CONFIG_PORT_RETRIES     3 // baud switches before giving up
+
+/* Fixes kept for GPS_getFixAt, a power of two. At 5 Hz the default covers
+ * the last 1.6 seconds. */
+#ifndef GPS_HISTORY_SIZE
+#define GPS_HISTORY_SIZE        8
+#endif
+#define HISTORY_INDEX(i)        ((i) & (GPS_HISTORY_SIZE - 1))
+
+// Furthest GPS_getFixAt will extrapolate past the newest fix
+#define MAX_EXTRAPOLATION       1000 // (ms)
+
+// Differential corrections, see GPS_addCorrection
+#define DGPS_CORRECTIONS        4 // newest corrections kept, a power of two
+#define DGPS_MAX_AGE            10000 // (ms) corrections older have no weight
+#define DGPS_MAX_FIX_AGE        1000 // (ms) base fix too old to correct from
 
 #define NOFIX_STATUS            0x00
 
+// NMEA sentences, the fallback for receivers that don't speak UBX
+#define NMEA_START_CHAR         '$'
+#define NMEA_CHECKSUM_CHAR      '*'
+#define NMEA_DELIMITER_CHAR     ','
+#define NMEA_MAX_LENGTH         82 // (chars) including $ and CR LF
+#define NMEA_TYPE_LENGTH        5 // (chars) talker and sentence, like GPGGA
+#define NMEA_MAX_DECIMALS       5 // fraction digits kept from a number
+#define NMEA_FIX_STATUS         0x03 // gpsStatus for a valid NMEA fix
+#define KNOTS_TO_CM_PER_S(knots) ((knots) * 51444 / 1000)
+
 // GPS connection timeout for packet not seen
 #define DELAY_TIMEOUT           5000
 
+// packing functions, for payload initializers
+#define PACK_LITTLE_ENDIAN_16(value) \
+    ((value) & 0xFF), (((value) >> 8) & 0xFF)
+#define PACK_LITTLE_ENDIAN_32(value) \
+    PACK_LITTLE_ENDIAN_16(value), PACK_LITTLE_ENDIAN_16((value) >> 16)
+
 // unpacking functions
+#define UNPACK_LITTLE_ENDIAN_16(data, start) \
+    ((uint16_t)(data[start] + ((uint16_t)data[start+1] << 8)))
 #define UNPACK_LITTLE_ENDIAN_32(data, start) \
     ((uint32_t)(data[start] + ((uint32_t)data[start+1] << 8) \
     + ((uint32_t)data[start+2] << 16) + ((uint32_t)data[start+3] << 24)))
@@ -67,6 +154,45 @@
 #define HEADING_TO_DEGREE(heading)      ((float)heading/100000)
 
 
+// Pointer and length, and the end, of a UBX descriptor table
+#define UBX_FIELDS(table)       (table), (sizeof(table)/sizeof((table)[0]))
+#define UBX_TABLE_END(table)    ((table) + sizeof(table)/sizeof((table)[0]))
+
+/**********************************************************************
+ * PRIVATE TYPEDEFS                                                   *
+ **********************************************************************/
+
+// UBX payload field types, the signed ones are sign extended
+typedef enum {
+    UBX_U1, UBX_I1, UBX_U2, UBX_I2, UBX_U4, UBX_I4
+} UbxType;
+
+// One payload field to keep from a UBX message
+typedef struct {
+    uint8_t offset;         // (bytes) from the start of the payload
+    UbxType type;
+    int32_t *destination;
+} UbxField;
+
+// One UBX message we decode
+typedef struct {
+    uint8_t class, id;
+    uint16_t length;        // (bytes) shortest payload we accept
+    const UbxField *fields;
+    uint8_t fieldCount;
+    void (*decoded)();      // called after the fields are stored, or NULL
+} UbxMessage;
+
+// Rate for one message in the auto-configuration
+typedef struct {
+    uint8_t class, id, rate;
+} UbxRate;
+
+typedef struct {
+    const UbxRate *rates;
+    uint8_t count;
+} UbxRateTable;
+
 /**********************************************************************
  * PRIVATE VARIABLES                                                  *
  **********************************************************************/
@@ -74,19 +200,79 @@ BOOL gpsInitialized = FALSE;
 static enum {
     STATE_IDLE      = 0x0,
     STATE_READ      = 0x1, // Reading GPS packet from UART
-    STATE_PARSE     = 0x2, // Parsing a received GPS packet
+    STATE_NMEA      = 0x2, // Reading an NMEA sentence from UART
 } state;
 
+// NMEA sentence being read, decoded field by field as it streams in
+static struct {
+    enum { NMEA_OTHER, NMEA_GGA, NMEA_RMC } type;
+    char typeChars[NMEA_TYPE_LENGTH];
+    uint8_t length, field, checksum, receivedChecksum, checksumDigits;
+    // Number in the current field, as digits and how many are decimals
+    uint32_t digits;
+    uint8_t decimals;
+    BOOL hasPoint, hasDigits;
+    char letter;
+    // Fields decoded so far
+    int32_t time, latitude, longitude, altitude, speed, course;
+    uint8_t quality;
+    char status;
+} nmea;
+
+// Receiver auto-configuration, run alongside the reader by GPS_runSM
+static enum {
+    CONFIG_OFF      = 0x0, // not configuring (done, failed or disabled)
+    CONFIG_PORT     = 0x1, // sending CFG-PRT at the start baud rate
+    CONFIG_SWITCH   = 0x2, // waiting to switch to the desired baud rate
+    CONFIG_COMMAND  = 0x3, // sending a command and waiting for its ACK
+} configState;
+
+static enum {
+    ACK_WAITING, ACK_RECEIVED, NAK_RECEIVED
+} ackState;
+
+BOOL isConfigured = FALSE, isConfigSaved = FALSE;
+uint8_t configCommand = 0, configRetries = 0, configPortRetries = 0;
+uint8_t configLast = 0; // command, see sendConfigCommand
+const UbxRateTable *configRates;
+
 uint8_t rawMessage[RAW_BUFFER_SIZE];
-uint8_t byteIndex = 0, messageLength = LENGTH2_INDEX + 1,
-        messageClass = 0, messageId = 0, gpsStatus = NOFIX_STATUS;
+uint16_t byteIndex = 0, messageLength = LENGTH2_INDEX + 1;
+uint8_t messageClass = 0, messageId = 0;
 
 
 BOOL hasNewMessage = FALSE, isConnected = FALSE, isUsingError = FALSE,
     hasPosition = FALSE;
 
+// Running 8-bit Fletcher checksum over class, id, length and payload
+uint8_t checksumA = 0, checksumB = 0;
+
+GpsStats stats;
+
+// Recent fixes, oldest to newest, for GPS_getFixAt
+GpsFix history[GPS_HISTORY_SIZE];
+uint8_t historyNewest = 0, historyCount = 0;
+
+// Position to start from once configured, see GPS_setWarmStart
+GpsCoordinate warmStart;
+uint32_t warmStartAccuracy; // (m)
+BOOL hasWarmStart = FALSE;
+
+// Base station: surveyed position, or the running sums of a survey-in
+GpsCoordinate basePosition;
+BOOL isSurveyed = FALSE;
+uint16_t surveyFixes = 0, surveyCount = 0;
+int64_t surveySum[3];
+
+// Boat: corrections received from the base station
+GpsCorrection corrections[DGPS_CORRECTIONS];
+uint8_t correctionNewest = 0, correctionCount = 0;
+
 // Variables read from the GPS
-int32_t heading;
+int32_t heading, gpsStatus = NOFIX_STATUS, pvtFlags;
+BOOL hadFix = FALSE; // at the last epoch, for logging dropouts
+int32_t iTOW, horizontalAccuracy; // (ms) GPS time of week, (mm)
+int32_t ackClass, ackId; // command an ACK-ACK or ACK-NAK is for
 
 struct {
     int32_t latitude, longitude, altitude;
@@ -95,12 +281,85 @@ struct {
 struct {
     int32_t north, east;
 } velocity;
+int32_t velocityITOW; // (ms) epoch of the last NAV-VELNED
 
 // TODO shrink these variables if possible
 struct {
     int32_t latitude, longitude;
-} error;
-
+} correctionError;
+
+void positionDecoded();
+void velocityDecoded();
+void pvtDecoded();
+void ackDecoded();
+void nakDecoded();
+
+/* Supported UBX messages. Each one lists the payload offset and type of
+ * the fields we keep and where they go (see pg. 60 in ublox UBX protocol
+ * specifications). Decoding a new message is just a new entry here. */
+static const UbxField navPosllhFields[] = {
+    { 0,  UBX_U4, &iTOW },
+    { 4,  UBX_I4, &geodetic.longitude },
+    { 8,  UBX_I4, &geodetic.latitude },
+    { 16, UBX_I4, &geodetic.altitude }, // hMSL
+    { 20, UBX_U4, &horizontalAccuracy },
+};
+
+static const UbxField navStatusFields[] = {
+    { 4,  UBX_U1, &gpsStatus }, // gpsFix
+};
+
+static const UbxField navVelnedFields[] = {
+    { 0,  UBX_U4, &velocityITOW },
+    { 4,  UBX_I4, &velocity.north },
+    { 8,  UBX_I4, &velocity.east },
+    { 24, UBX_I4, &heading },
+};
+
+// NAV-PVT (u-blox 7 and newer) carries all of the above from one epoch
+static const UbxField navPvtFields[] = {
+    { 0,  UBX_U4, &iTOW },
+    { 20, UBX_U1, &gpsStatus }, // fixType
+    { 21, UBX_U1, &pvtFlags },
+    { 24, UBX_I4, &geodetic.longitude },
+    { 28, UBX_I4, &geodetic.latitude },
+    { 36, UBX_I4, &geodetic.altitude }, // hMSL
+    { 40, UBX_U4, &horizontalAccuracy },
+    { 48, UBX_I4, &velocity.north }, // (mm/s)
+    { 52, UBX_I4, &velocity.east }, // (mm/s)
+    { 64, UBX_I4, &heading }, // headMot
+};
+
+static const UbxField ackFields[] = {
+    { 0,  UBX_U1, &ackClass },
+    { 1,  UBX_U1, &ackId },
+};
+
+static const UbxMessage ubxMessages[] = {
+    { NAV_CLASS, NAV_PVT_ID,      92, UBX_FIELDS(navPvtFields), pvtDecoded },
+    { ACK_CLASS, ACK_ACK_ID,      2,  UBX_FIELDS(ackFields), ackDecoded },
+    { ACK_CLASS, ACK_NAK_ID,      2,  UBX_FIELDS(ackFields), nakDecoded },
+    { NAV_CLASS, NAV_POSLLH_ID,   28, UBX_FIELDS(navPosllhFields), positionDecoded },
+    { NAV_CLASS, NAV_STATUS_ID,   16, UBX_FIELDS(navStatusFields), NULL },
+    { NAV_CLASS, NAV_VELOCITY_ID, 36, UBX_FIELDS(navVelnedFields), velocityDecoded },
+};
+
+// Messages the auto-configuration turns on and off, after CFG-RATE
+static const UbxRate pvtRates[] = {
+    { NAV_CLASS, NAV_PVT_ID,      1 },
+    { NAV_CLASS, NAV_POSLLH_ID,   0 },
+    { NAV_CLASS, NAV_STATUS_ID,   0 },
+    { NAV_CLASS, NAV_VELOCITY_ID, 0 },
+};
+
+static const UbxRate legacyRates[] = {
+    { NAV_CLASS, NAV_POSLLH_ID,   1 },
+    { NAV_CLASS, NAV_STATUS_ID,   1 },
+    { NAV_CLASS, NAV_VELOCITY_ID, 1 },
+};
+
+static const UbxRateTable pvtRateTable = { UBX_FIELDS(pvtRates) };
+static const UbxRateTable legacyRateTable = { UBX_FIELDS(legacyRates) };
 
 
 
@@ -108,13 +367,31 @@ struct {
  * PRIVATE PROTOTYPES                                                 *
  **********************************************************************/
 
-BOOL hasNewByte();
 void startReadState();
 void startIdleState();
-void startParseState();
-int8_t readMessageByte();
+void handleByte(uint8_t data);
+void startNmeaState();
+int8_t readNmeaByte(uint8_t data);
+void endNmeaField();
+void nmeaDecoded();
+int32_t scaleNmeaNumber(int32_t multiplier);
+int32_t nmeaToCoordinate();
+int32_t nmeaToTime();
+void addChecksum(uint8_t data);
+int8_t readMessageByte(uint8_t data);
 int8_t parseMessage();
-void parsePayloadField();
+void sendMessage(uint8_t class, uint8_t id, const uint8_t *payload,
+    uint16_t length);
+void setMessageRate(uint8_t class, uint8_t id, uint8_t rate);
+void runConfigSM();
+void startPortConfig();
+void sendPortConfig();
+void sendConfigCommand();
+void sendWarmStart();
+void recordFix();
+void surveyFix(const GpsFix *fix);
+void updateCorrection();
+int32_t interpolate(int32_t from, int32_t to, int32_t elapsed, int32_t period);
 
 /**********************************************************************
  * PUBLIC FUNCTIONS                                                   *
@@ -127,6 +404,28 @@ BOOL GPS_init(uint8_t options) {
 
     UART_init(GPS_UART_ID,GPS_UART_BAUDRATE);
 
+    // Only NAV-PVT each epoch, instead of POSLLH + STATUS + VELNED
+    configRates = (options & GPS_OPTION_PVT)? &pvtRateTable : &legacyRateTable;
+    isConfigured = FALSE;
+    isConfigSaved = FALSE;
+    configPortRetries = 0;
+    if (options & GPS_OPTION_NO_CONFIG) {
+        configState = CONFIG_OFF;
+    }
+    else if (options & GPS_OPTION_SAVED) {
+        // Only check it's still there, a CFG-RATE at the desired baud rate
+        //  answered is enough, otherwise it's configured from the start
+        UART_init(GPS_UART_ID, DESIRED_BAUDRATE);
+        configLast = 0;
+        configCommand = 0;
+        configRetries = 0;
+        sendConfigCommand();
+        configState = CONFIG_COMMAND;
+    }
+    else {
+        startPortConfig();
+    }
+
     startIdleState();
     gpsInitialized = TRUE;
     return SUCCESS;
@@ -144,43 +443,72 @@ BOOL GPS_isInitialized() {
 /**********************************************************************
  * Function: GPS_runSM()
  * @return None
- * @remark Executes the GPS's currently running state.
+ * @remark Executes the GPS's currently running state. Takes everything
+ *  waiting in the UART, up to GPS_BYTE_BUDGET bytes, and decodes each
+ *  message as soon as its last byte arrives.
  **********************************************************************/
 void GPS_runSM() {
-    switch (state) {
-        // Waiting for data
-        case STATE_IDLE:
-            // check for a new packet to start reading
-            if (hasNewByte())
-                startReadState();
-            break;
-        // Reading the message in and verifying sync, length, and checksum
-        case STATE_READ:
-            if (hasNewByte() && (readMessageByte() != SUCCESS)) {
-                #ifdef DEBUG
-                printf("Failed reading GPS message at byte %d.\n", byteIndex);
-                while (!Serial_isTransmitEmpty()) { asm("nop"); }
-                #endif
-                startIdleState();
-            }
-            if (hasNewMessage)
-                startParseState(); // finished reading, start parsing the payload
+    uint8_t chunk[READ_CHUNK];
+    uint16_t budget = GPS_BYTE_BUDGET;
+    uint16_t length, i;
+
+    while (budget > 0) {
+        length = UART_read(GPS_UART_ID, chunk,
+            (budget < READ_CHUNK)? budget : READ_CHUNK);
+        if (length == 0)
             break;
-        // Parsing the new message's payload
-        case STATE_PARSE:
-            if (hasNewMessage)
-                parseMessage();
-            else
-                startIdleState();
-           break;
-            // Should not be here!
-    } // switch
+        budget -= length;
+
+        for (i = 0; i < length; i++)
+            handleByte(chunk[i]);
+    }
+
+    if (configState != CONFIG_OFF)
+        runConfigSM();
 
     // Update connected variable
     if (Timer_isExpired(TIMER_GPS))
         isConnected = FALSE;
 }
 
+/**********************************************************************
+ * Function: GPS_isConfigured()
+ * @return TRUE once the receiver has acknowledged the auto-configuration.
+ * @remark Stays FALSE with GPS_OPTION_NO_CONFIG, or if the receiver never
+ *  answered, in which case it is left at whatever it was set to.
+ **********************************************************************/
+BOOL GPS_isConfigured() {
+    return isConfigured;
+}
+
+/**********************************************************************
+ * Function: GPS_isConfigSaved()
+ * @return TRUE once the receiver has acknowledged saving the
+ *  configuration, or still had it with GPS_OPTION_SAVED.
+ * @remark So GPS_OPTION_SAVED can be given next time.
+ **********************************************************************/
+BOOL GPS_isConfigSaved() {
+    return isConfigSaved;
+}
+
+/**********************************************************************
+ * Function: GPS_setWarmStart()
+ * @param Position the receiver was last at.
+ * @param (m) How far it could be from there now.
+ * @return None
+ * @remark Sent as an AID-INI once the configuration is done, or straight
+ *  away without one, so the receiver only searches the satellites above
+ *  it. It isn't acknowledged, and a receiver that already has a fix
+ *  ignores it.
+ **********************************************************************/
+void GPS_setWarmStart(const GpsCoordinate *position, uint32_t accuracy) {
+    warmStart = *position;
+    warmStartAccuracy = accuracy;
+    hasWarmStart = TRUE;
+    if (configState == CONFIG_OFF)
+        sendWarmStart();
+}
+
 /**********************************************************************
  * Function: GPS_hasFix
  * @return TRUE if a lock has been obtained.
@@ -201,31 +529,69 @@ BOOL GPS_hasPosition() {
 
 
 /**********************************************************************
- * Function: GPS_getLatitude
- * @return The GPS's latitude value (N/S) scaled 1e7.
+ * Function: GPS_getCoordinate
+ * @param Where to store the position.
+ * @return None
+ * @remark The current position in the receiver's own fixed-point units,
+ *  with error correction applied in integer math.
+ **********************************************************************/
+void GPS_getCoordinate(GpsCoordinate *coord) {
+    coord->latitude = GPS_getLatitudeFixed();
+    coord->longitude = GPS_getLongitudeFixed();
+    coord->altitude = geodetic.altitude;
+}
+
+/**********************************************************************
+ * Function: GPS_getLatitudeFixed
+ * @return The GPS's latitude value (N/S) in degrees scaled 1e7.
  * @remark
  **********************************************************************/
-float GPS_getLatitude() {
-    float lat =  (isUsingError)?
-        geodetic.latitude - error.latitude
+int32_t GPS_getLatitudeFixed() {
+    return (isUsingError)?
+        geodetic.latitude - correctionError.latitude
         :
         geodetic.latitude;
-
-    return COORDINATE_TO_DECIMAL(lat);
 }
 
 /**********************************************************************
- * Function: GPS_getLongitude
- * @return The GPS's longitude value (E/W) scaled 1e7.
+ * Function: GPS_getLongitudeFixed
+ * @return The GPS's longitude value (E/W) in degrees scaled 1e7.
  * @remark
  **********************************************************************/
-float GPS_getLongitude() {
-    float lon =  (isUsingError)?
-        (geodetic.longitude - error.longitude)
+int32_t GPS_getLongitudeFixed() {
+    return (isUsingError)?
+        geodetic.longitude - correctionError.longitude
         :
         geodetic.longitude;
+}
+
+/**********************************************************************
+ * Function: GPS_getLatitude
+ * @return The GPS's latitude value (N/S) in decimal degrees.
+ * @remark Converts GPS_getLatitudeFixed, which is only good to about a
+ *  meter in a float.
+ **********************************************************************/
+float GPS_getLatitude() {
+    return COORDINATE_TO_DECIMAL(GPS_getLatitudeFixed());
+}
+
+/**********************************************************************
+ * Function: GPS_getLongitude
+ * @return The GPS's longitude value (E/W) in decimal degrees.
+ * @remark Converts GPS_getLongitudeFixed, which is only good to about a
+ *  meter in a float.
+ **********************************************************************/
+float GPS_getLongitude() {
+    return COORDINATE_TO_DECIMAL(GPS_getLongitudeFixed());
+}
 
-    return COORDINATE_TO_DECIMAL(lon);
+/**********************************************************************
+ * Function: GPS_getAltitudeFixed
+ * @return The GPS's altitude value in millimeters above mean sea level.
+ * @remark
+ **********************************************************************/
+int32_t GPS_getAltitudeFixed() {
+    return geodetic.altitude;
 }
 
 /**********************************************************************
@@ -237,13 +603,96 @@ float GPS_getAltitude() {
     return ALTITUDE_TO_DECIMAL(geodetic.altitude);
 }
 
+/**********************************************************************
+ * Function: GPS_setBasePosition
+ * @param Surveyed position of the base station's antenna.
+ * @return None
+ * @remark Makes this GPS a differential base station, see
+ *  GPS_getCorrection. Cancels a survey-in.
+ **********************************************************************/
+void GPS_setBasePosition(const GpsCoordinate *surveyed) {
+    basePosition = *surveyed;
+    surveyFixes = 0;
+    isSurveyed = TRUE;
+}
+
+/**********************************************************************
+ * Function: GPS_startSurvey
+ * @param Number of fixes to average, at least 1.
+ * @return None
+ * @remark Surveys the base station position in by averaging the next
+ *  fixes. Corrections from a self-surveyed base remove the error common
+ *  to both receivers, not the absolute error of the average.
+ **********************************************************************/
+void GPS_startSurvey(uint16_t fixes) {
+    surveySum[0] = surveySum[1] = surveySum[2] = 0;
+    surveyCount = 0;
+    surveyFixes = (fixes > 0)? fixes : 1;
+    isSurveyed = FALSE;
+}
+
+/**********************************************************************
+ * Function: GPS_isSurveyed
+ * @return TRUE once the base position is known.
+ * @remark none
+ **********************************************************************/
+BOOL GPS_isSurveyed() {
+    return isSurveyed;
+}
+
+/**********************************************************************
+ * Function: GPS_getCorrection
+ * @param Where to store the correction.
+ * @return SUCCESS, or FAILURE without a base position or a recent fix.
+ * @remark Base station side. The newest fix minus the base position,
+ *  tagged with that fix's GPS time, for the boats' GPS_addCorrection.
+ **********************************************************************/
+int8_t GPS_getCorrection(GpsCorrection *correction) {
+    const GpsFix *fix = &history[historyNewest];
+    if (!isSurveyed || historyCount == 0 || !GPS_hasFix()
+            || (get_time() - fix->time) > DGPS_MAX_FIX_AGE)
+        return FAILURE;
+    correction->iTOW = fix->iTOW;
+    correction->latitude = fix->latitude - basePosition.latitude;
+    correction->longitude = fix->longitude - basePosition.longitude;
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: GPS_addCorrection
+ * @param Correction from the base station.
+ * @return None
+ * @remark Boat side. Keeps the last few corrections and turns on error
+ *  correction, which from now on follows their age weighted mean.
+ **********************************************************************/
+void GPS_addCorrection(const GpsCorrection *correction) {
+    correctionNewest = (correctionNewest + 1) & (DGPS_CORRECTIONS - 1);
+    if (correctionCount < DGPS_CORRECTIONS)
+        correctionCount++;
+    corrections[correctionNewest] = *correction;
+    isUsingError = TRUE;
+    updateCorrection();
+}
+
+/**********************************************************************
+ * Function: GPS_setError
+ * @param Error in the position, in the units of GpsCoordinate.
+ * @return None
+ * @remark Sets the latitudal and longitudal errors for error corrections
+ *  together, the altitude is not used.
+ **********************************************************************/
+void GPS_setError(const GpsCoordinate *coordError) {
+    correctionError.latitude = coordError->latitude;
+    correctionError.longitude = coordError->longitude;
+}
+
 /**********************************************************************
  * Function: GPS_setLongitudeError
  * @return None
  * @remark Sets the longitudal error for error corrections.
  **********************************************************************/
 void GPS_setLongitudeError(int32_t lonError) {
-    error.longitude = lonError;
+    correctionError.longitude = lonError;
 }
 
 /**********************************************************************
@@ -252,7 +701,7 @@ void GPS_setLongitudeError(int32_t lonError) {
  * @remark Sets the latitudal error for error corrections.
  **********************************************************************/
 void GPS_setLatitudeError(int32_t latError) {
-    error.latitude = latError;
+    correctionError.latitude = latError;
 }
 
 /**********************************************************************
@@ -292,6 +741,15 @@ int32_t GPS_getEastVelocity() {
 }
 
 
+/**********************************************************************
+ * Function: GPS_getHorizontalAccuracy
+ * @return Returns the estimated horizontal accuracy of the last fix.
+ * @remark In millimeters.
+ **********************************************************************/
+uint32_t GPS_getHorizontalAccuracy() {
+    return (uint32_t)horizontalAccuracy;
+}
+
 /**********************************************************************
  * Function: GPS_getHeading
  * @return Returns the current heading in degrees scaled 1e-5.
@@ -312,19 +770,100 @@ int32_t GPS_isConnected() {
 }
 
 /**********************************************************************
- * PRIVATE FUNCTIONS                                                  *
+ * Function: GPS_getFixAt
+ * @param Local time, from get_time(), to get the position at.
+ * @param Where to store the fix.
+ * @return SUCCESS, or FAILURE if there are no fixes or time is too far
+ *  past the newest one.
+ * @remark Interpolates between the two fixes either side of time, or
+ *  extrapolates along the last two fixes if time is newer than both.
+ *  A time older than the history gets the oldest fix.
+ **********************************************************************/
+int8_t GPS_getFixAt(uint32_t time, GpsFix *fix) {
+    const GpsFix *before, *after;
+    uint8_t i;
+    int32_t elapsed, period;
+
+    if (historyCount == 0)
+        return FAILURE;
+
+    after = &history[historyNewest];
+    if (historyCount == 1 || (int32_t)(time - after->time) > 0) {
+        // Past the newest fix
+        if ((int32_t)(time - after->time) > MAX_EXTRAPOLATION)
+            return FAILURE;
+        *fix = *after;
+        if (historyCount == 1)
+            return SUCCESS;
+        before = &history[HISTORY_INDEX(historyNewest - 1)];
+    }
+    else {
+        // Walk back to the pair around time
+        for (i = 1; i < historyCount; i++) {
+            before = &history[HISTORY_INDEX(historyNewest - i)];
+            if ((int32_t)(time - before->time) >= 0)
+                break;
+            after = before;
+        }
+        if (i == historyCount) {
+            *fix = *after; // older than the history
+            return SUCCESS;
+        }
+    }
+
+    elapsed = (int32_t)(time - before->time);
+    period = (int32_t)(after->time - before->time);
+    if (period <= 0) {
+        *fix = *after;
+        return SUCCESS;
+    }
+    fix->time = time;
+    fix->iTOW = before->iTOW + (uint32_t)interpolate(0,
+        (int32_t)(after->iTOW - before->iTOW), elapsed, period);
+    fix->latitude = interpolate(before->latitude, after->latitude, elapsed, period);
+    fix->longitude = interpolate(before->longitude, after->longitude, elapsed, period);
+    fix->altitude = interpolate(before->altitude, after->altitude, elapsed, period);
+    fix->north = interpolate(before->north, after->north, elapsed, period);
+    fix->east = interpolate(before->east, after->east, elapsed, period);
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: GPS_getLastFix
+ * @param Where to store the fix.
+ * @return SUCCESS, or FAILURE if there have been no fixes.
  **********************************************************************/
+int8_t GPS_getLastFix(GpsFix *fix) {
+    if (historyCount == 0)
+        return FAILURE;
+    *fix = history[historyNewest];
+    return SUCCESS;
+}
 
+/**********************************************************************
+ * Function: GPS_getStats
+ * @param Where to copy the counters.
+ * @return None
+ * @remark Takes a snapshot of the GPS link counters.
+ **********************************************************************/
+void GPS_getStats(GpsStats *copy) {
+    *copy = stats;
+}
 
 /**********************************************************************
- * Function: hasNewMessage
- * @return Returns true if a new message is ready to be read
- * @remark 
+ * Function: GPS_clearStats
+ * @return None
+ * @remark Zeroes the GPS link counters.
  **********************************************************************/
-BOOL hasNewByte() {
-    return !UART_isReceiveEmpty(GPS_UART_ID);
+void GPS_clearStats() {
+    memset(&stats, 0, sizeof(stats));
 }
 
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+
 /**********************************************************************
  * Function: startIdleState
  * @return None
@@ -333,8 +872,7 @@ BOOL hasNewByte() {
 void startIdleState() {
     state = STATE_IDLE;
 #ifdef DEBUG_STATE
-    printf("Entered idle state.\n");
-    while (!Serial_isTransmitEmpty()) { asm("nop"); }
+    SERIAL_LOG(LOG_GPS_IDLE);
 #endif
 
 }
@@ -349,26 +887,65 @@ void startReadState() {
     byteIndex = 0;
     messageLength = PAYLOAD_INDEX;
     hasNewMessage = FALSE;
+    checksumA = 0;
+    checksumB = 0;
     
 #ifdef DEBUG_STATE
-    printf("Entered read state.\n");
-    while (!Serial_isTransmitEmpty()) { asm("nop"); }
+    SERIAL_LOG(LOG_GPS_READ);
 #endif
 }
 
 /**********************************************************************
- * Function: startParseState
+ * Function: handleByte
+ * @param Byte received from the GPS.
  * @return None
- * @remark Switches into the GPS parse state.
+ * @remark Runs one received byte through the state machine, and parses
+ *  the message it completes. A byte that breaks a message is looked at
+ *  again as the start of the next one, so a frame that follows garbage
+ *  straight away is not lost.
  **********************************************************************/
-void startParseState() {
-    state = STATE_PARSE;
-    byteIndex = PAYLOAD_INDEX;
-    
-#ifdef DEBUG_STATE
-    printf("Entered parse state.\n");
-    while (!Serial_isTransmitEmpty()) { asm("nop"); }
-#endif
+void handleByte(uint8_t data) {
+    switch (state) {
+        // Waiting for the first sync byte of either protocol
+        case STATE_IDLE:
+            if (data == NMEA_START_CHAR) {
+                startNmeaState();
+                break;
+            }
+            else if (data != SYNC1_CHAR) {
+                stats.bytesSkipped++;
+                break;
+            }
+            startReadState();
+            // Store it, then read the message in and verify sync and length
+            /* fall through */
+        case STATE_READ:
+            if (readMessageByte(data) != SUCCESS) {
+                #ifdef DEBUG
+                SERIAL_LOG(LOG_GPS_BAD_BYTE, byteIndex);
+                #endif
+                startIdleState();
+                handleByte(data); // may start the next message
+            }
+            else if (hasNewMessage) {
+                // finished reading, parse the whole payload now
+                parseMessage();
+                startIdleState();
+            }
+            break;
+        // Reading an NMEA sentence and verifying its checksum
+        case STATE_NMEA:
+            if (readNmeaByte(data) != SUCCESS) {
+                startIdleState();
+                handleByte(data);
+            }
+            else if (hasNewMessage) {
+                nmeaDecoded();
+                startIdleState();
+            }
+            break;
+            // Should not be here!
+    } // switch
 }
 
 /**********************************************************************
@@ -381,25 +958,36 @@ void setConnected() {
     Timer_new(TIMER_GPS,DELAY_TIMEOUT);
 
 #ifdef DEBUG
-    printf("Connected to GPS.\n");
-    while (!Serial_isTransmitEmpty()) { asm("nop"); }
+    SERIAL_LOG(LOG_GPS_CONNECTED);
 #endif
 }
 
 /**********************************************************************
- * Function: parseMessageByte
+ * Function: addChecksum
+ * @param Byte of the message being read.
+ * @return None
+ * @remark Adds a byte to the running Fletcher checksum (see pg. 74 in
+ *  the ublox UBX protocol specifications).
+ **********************************************************************/
+void addChecksum(uint8_t data) {
+    checksumA += data;
+    checksumB += checksumA;
+}
+
+/**********************************************************************
+ * Function: readMessageByte
+ * @param Byte received from the GPS.
  * @return SUCCESS, FAILURE, or ERROR.
- * @remark Reads a GPS packet from the UART. This function will return
- *  SUCCESS every time a valid byte is read (interpets the sync, length,
- *  and checksum fields). The hasNewMessage field will be set to TRUE
- *  when a new message is received and ready for parsing.
- **********************************************************************/
-int8_t readMessageByte() {
-    // Read a new byte from the UART or return FAILURE
-    if (hasNewByte() && !hasNewMessage)
-        rawMessage[byteIndex] = UART_getChar(GPS_UART_ID);
-    else
+ * @remark Adds a byte to the GPS packet being read. This function will
+ *  return SUCCESS every time a valid byte is read (interpets the sync,
+ *  length, and checksum fields). The hasNewMessage field will be set to
+ *  TRUE when a new message is received and its checksum matches, so a
+ *  corrupted message never reaches the parser.
+ **********************************************************************/
+int8_t readMessageByte(uint8_t data) {
+    if (hasNewMessage || byteIndex >= RAW_BUFFER_SIZE)
         return FAILURE;
+    rawMessage[byteIndex] = data;
 
     // Look at the new byte
     switch(byteIndex) {
@@ -415,21 +1003,45 @@ int8_t readMessageByte() {
             break;
         case CLASS_INDEX:
             messageClass = rawMessage[byteIndex];
+            addChecksum(data);
             break;
         case ID_INDEX:
             messageId = rawMessage[byteIndex];
+            addChecksum(data);
             break;
         case LENGTH1_INDEX:
             messageLength = rawMessage[byteIndex];
+            addChecksum(data);
             break;
         case LENGTH2_INDEX:
             messageLength += rawMessage[byteIndex] << 8;
+            addChecksum(data);
             // Make length total for whole message
             messageLength += PAYLOAD_INDEX + CHECKSUM_BYTES;
+            if (messageLength > RAW_BUFFER_SIZE) {
+                stats.lengthErrors++;
+                return FAILURE; // won't fit, wait for the next one
+            }
             break;
         default:
-            // Just reading payload and checksum (look these later)
-            if (byteIndex >= (messageLength - 1)) {
+            if (byteIndex < (messageLength - CHECKSUM_BYTES)) {
+                // Payload
+                addChecksum(data);
+            }
+            else if (byteIndex == (messageLength - CHECKSUM_BYTES)) {
+                // CK_A
+                if (data != checksumA) {
+                    stats.checksumErrors++;
+                    return FAILURE;
+                }
+            }
+            else {
+                // CK_B, last byte of the message
+                if (data != checksumB) {
+                    stats.checksumErrors++;
+                    return FAILURE;
+                }
+                stats.messages++;
                 hasNewMessage = TRUE;
             }
     } // switch
@@ -439,165 +1051,643 @@ int8_t readMessageByte() {
 }
 
 /**********************************************************************
- * Function: parseMessageByte()
- * @return SUCCESS, FAILURE, or ERROR.
- * @remark Parses the payload fields of a newly received GPS message.
+ * Function: parseMessage()
+ * @return SUCCESS, or FAILURE for a message we don't decode.
+ * @remark Finds the new message in the message table and copies each of
+ *  its fields straight out of rawMessage in one pass. The checksum has
+ *  already been checked by readMessageByte.
  **********************************************************************/
 int8_t parseMessage() {
-    //for (byteIndex = 0; byteIndex < RAW_BUFFER_SIZE; byteIndex++) {
+    const UbxMessage *message;
+    const UbxField *field;
+    const uint8_t *payload = &rawMessage[PAYLOAD_INDEX];
+    uint16_t payloadLength = messageLength - PAYLOAD_INDEX - CHECKSUM_BYTES;
+    uint32_t value;
+
+    // Done with the message either way
+    hasNewMessage = FALSE;
 
-    // interpret message by parsing payload fields
-    if (byteIndex < (messageLength - CHECKSUM_BYTES)) {
-        parsePayloadField(); // Processing payload field by field
+    for (message = ubxMessages; message < UBX_TABLE_END(ubxMessages); message++) {
+        if (message->class == messageClass && message->id == messageId)
+            break;
+    }
+    if (message == UBX_TABLE_END(ubxMessages) || payloadLength < message->length) {
+        #ifdef DEBUG
+        SERIAL_LOG(LOG_GPS_UNHANDLED, messageClass, messageId);
+        #endif
+        return FAILURE;
+    }
+
+    for (field = message->fields; field < message->fields + message->fieldCount; field++) {
+        switch (field->type) {
+            case UBX_U1:
+                value = payload[field->offset];
+                break;
+            case UBX_I1:
+                value = (int32_t)(int8_t)payload[field->offset];
+                break;
+            case UBX_U2:
+                value = UNPACK_LITTLE_ENDIAN_16(payload, field->offset);
+                break;
+            case UBX_I2:
+                value = (int32_t)(int16_t)UNPACK_LITTLE_ENDIAN_16(payload, field->offset);
+                break;
+            default: // UBX_U4, UBX_I4
+                value = UNPACK_LITTLE_ENDIAN_32(payload, field->offset);
+                break;
+        }
+        *field->destination = (int32_t)value;
+    }
+
+    if (message->decoded != NULL)
+        message->decoded();
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: positionDecoded()
+ * @return None
+ * @remark Called after a NAV-POSLLH message is decoded.
+ **********************************************************************/
+void positionDecoded() {
+    hasPosition = TRUE;
+    recordFix();
+}
+
+/**********************************************************************
+ * Function: velocityDecoded()
+ * @return None
+ * @remark Called after a NAV-VELNED message is decoded. It comes after
+ *  the NAV-POSLLH of the same epoch, so it completes that fix.
+ **********************************************************************/
+void velocityDecoded() {
+    GpsFix *fix = &history[historyNewest];
+    if (historyCount > 0 && (int32_t)fix->iTOW == velocityITOW) {
+        fix->north = velocity.north;
+        fix->east = velocity.east;
+    }
+}
+
+/**********************************************************************
+ * Function: pvtDecoded()
+ * @return None
+ * @remark Called after a NAV-PVT message is decoded. Brings its fields
+ *  to the same units as the older messages.
+ **********************************************************************/
+void pvtDecoded() {
+    // NAV-PVT velocities are in mm/s, VELNED ones in cm/s
+    velocity.north /= 10;
+    velocity.east /= 10;
+    if (!(pvtFlags & PVT_FIX_OK_FLAG))
+        gpsStatus = NOFIX_STATUS;
+    hasPosition = TRUE;
+    recordFix();
+}
+
+/**********************************************************************
+ * Function: recordFix()
+ * @return None
+ * @remark Adds the position just decoded to the fix history, tagged with
+ *  its GPS time of week and the local time it was parsed at. Nothing is
+ *  kept without a fix.
+ **********************************************************************/
+void recordFix() {
+    GpsFix *fix;
+    if (GPS_hasFix() != hadFix) {
+        hadFix = GPS_hasFix();
+        Error_log(ERROR_MODULE_GPS, hadFix? ERROR_GPS_FIX : ERROR_GPS_DROPOUT,
+            (uint16_t)gpsStatus);
+    }
+    if (!GPS_hasFix())
+        return;
+
+    historyNewest = HISTORY_INDEX(historyNewest + 1);
+    if (historyCount < GPS_HISTORY_SIZE)
+        historyCount++;
+
+    fix = &history[historyNewest];
+    fix->time = get_time();
+    fix->iTOW = (uint32_t)iTOW;
+    fix->latitude = geodetic.latitude;
+    fix->longitude = geodetic.longitude;
+    fix->altitude = geodetic.altitude;
+    fix->north = velocity.north;
+    fix->east = velocity.east;
+    stats.fixes++;
+
+    if (surveyFixes > 0)
+        surveyFix(fix);
+    if (correctionCount > 0)
+        updateCorrection();
+}
+
+/**********************************************************************
+ * Function: surveyFix()
+ * @param The fix just recorded.
+ * @return None
+ * @remark Adds a fix to the survey-in average, and makes the average the
+ *  base position once enough fixes are in.
+ **********************************************************************/
+void surveyFix(const GpsFix *fix) {
+    surveySum[0] += fix->latitude;
+    surveySum[1] += fix->longitude;
+    surveySum[2] += fix->altitude;
+    if (++surveyCount < surveyFixes)
+        return;
+
+    basePosition.latitude = (int32_t)(surveySum[0] / surveyCount);
+    basePosition.longitude = (int32_t)(surveySum[1] / surveyCount);
+    basePosition.altitude = (int32_t)(surveySum[2] / surveyCount);
+    surveyFixes = 0;
+    isSurveyed = TRUE;
+}
+
+/**********************************************************************
+ * Function: updateCorrection()
+ * @return None
+ * @remark Sets the error correction to the weighted mean of the stored
+ *  corrections. Each one is weighted by how close its epoch is to the
+ *  newest fix, falling to nothing at DGPS_MAX_AGE, so a correction is
+ *  trusted less the more the common error has drifted since. With none
+ *  young enough the correction goes back to zero.
+ **********************************************************************/
+void updateCorrection() {
+    int64_t latSum = 0, lonSum = 0;
+    int32_t weightSum = 0, weight, age;
+    uint32_t now = history[historyNewest].iTOW;
+    uint8_t i;
+
+    if (historyCount == 0)
+        return; // nothing to weigh them against yet
+
+    for (i = 0; i < correctionCount; i++) {
+        const GpsCorrection *correction = &corrections[i];
+        age = (int32_t)(now - correction->iTOW);
+        if (age < 0)
+            age = -age; // our fix lags the base's
+        if (age >= DGPS_MAX_AGE)
+            continue;
+        weight = DGPS_MAX_AGE - age;
+        latSum += (int64_t)weight * correction->latitude;
+        lonSum += (int64_t)weight * correction->longitude;
+        weightSum += weight;
+    }
+
+    if (weightSum == 0) {
+        correctionError.latitude = 0;
+        correctionError.longitude = 0;
     }
-    /*
-    else if (byteIndex > (messageLength - CHECKSUM_BYTES) < messageLength) {
-        //if (verifyChecksum() != SUCCESS) return FAILURE;
-        startIdleState();
-        return SUCCESS;
-    }*/
     else {
-        // Done parsing the message
-        hasNewMessage = FALSE;
+        correctionError.latitude = (int32_t)(latSum / weightSum);
+        correctionError.longitude = (int32_t)(lonSum / weightSum);
     }
+}
+
+/**********************************************************************
+ * Function: interpolate()
+ * @param Value at the start of the period.
+ * @param Value at the end of the period.
+ * @param Time from the start of the period, past the end extrapolates.
+ * @param Length of the period.
+ * @return The value at elapsed, on the line through from and to.
+ * @remark In 64-bit so whole coordinates (1e-7 degrees) don't overflow.
+ **********************************************************************/
+int32_t interpolate(int32_t from, int32_t to, int32_t elapsed, int32_t period) {
+    return from + (int32_t)(((int64_t)(to - from) * elapsed) / period);
+}
+
+/**********************************************************************
+ * Function: ackDecoded()
+ * @return None
+ * @remark Called after an ACK-ACK, for the command it acknowledges.
+ **********************************************************************/
+void ackDecoded() {
+    if (configState == CONFIG_COMMAND && ackClass == CFG_CLASS)
+        ackState = ACK_RECEIVED;
+}
+
+/**********************************************************************
+ * Function: nakDecoded()
+ * @return None
+ * @remark Called after an ACK-NAK, for the command that was rejected.
+ **********************************************************************/
+void nakDecoded() {
+    if (configState == CONFIG_COMMAND && ackClass == CFG_CLASS)
+        ackState = NAK_RECEIVED;
+}
 
-    return SUCCESS; // ready to parse next byte
-}
-
-
-/**********************************************************************
- * Function: parsePayloadField()
- * @return None
- * @remark Parses one field of the payload for the new GPS message.
- **********************************************************************/
-void parsePayloadField() {
-    switch (messageClass) {
-        // #################### Navigation Message #######################
-        case NAV_CLASS:
-            switch (messageId) {
-                // ------------- NAV-POSLLH (0x01 0x02) --------------
-                case NAV_POSLLH_ID:
-                    switch (byteIndex - PAYLOAD_INDEX) {
-                        case 0: // iTow (not implemented)
-                            byteIndex += sizeof(uint32_t);
-                            break;
-                        case 4: // lon
-                            geodetic.longitude = (int32_t)(rawMessage[byteIndex]
-                                    + ((int32_t)rawMessage[byteIndex + 1] << 8)
-                                    + ((int32_t)rawMessage[byteIndex + 2] << 16)
-                                    + ((int32_t)rawMessage[byteIndex + 3] << 24));
-                            //(int32_t)UNPACK_LITTLE_ENDIAN_32(rawMessage,byteIndex);
-                            byteIndex += sizeof(int32_t);
-                            break;
-                        case 8: // lat
-                            geodetic.latitude = (int32_t)(rawMessage[byteIndex]
-                                    + ((int32_t)rawMessage[byteIndex + 1] << 8)
-                                    + ((int32_t)rawMessage[byteIndex + 2] << 16)
-                                    + ((int32_t)rawMessage[byteIndex + 3] << 24));
-                            byteIndex += sizeof(int32_t);
-                            break;
-                        case 12: // height (not implemented)
-                            byteIndex += sizeof(int32_t);
-                            break;
-                        case 16: // hMSL
-                            geodetic.altitude = (int32_t)(rawMessage[byteIndex]
-                                    + ((int32_t)rawMessage[byteIndex + 1] << 8)
-                                    + ((int32_t)rawMessage[byteIndex + 2] << 16)
-                                    + ((int32_t)rawMessage[byteIndex + 3] << 24));
-                            hasPosition = TRUE;
-                            byteIndex += sizeof(int32_t);
-                            break;
-                        case 20: // hAcc (not implemented)
-                            byteIndex += sizeof(uint32_t);
-                            break;
-                        case 24: // vAcc (not implemented)
-                            byteIndex += sizeof(uint32_t);
-                    } // NAV_POSLLH_ID byte
-                    break;
-                // ------------- NAV-STATUS (0x01 0x03) --------------
-                case NAV_STATUS_ID:
-                    switch (byteIndex - PAYLOAD_INDEX) {
-                        case 0: // iTow (not implemented)
-                            byteIndex += sizeof(uint32_t);
-                            break;
-                        case 4: // gpsFix
-                            gpsStatus = rawMessage[byteIndex];
-                            byteIndex += sizeof(uint8_t);
-                            break;
-                        case 5: // flags (not implemented)
-                            byteIndex += sizeof(uint8_t);
-                            break;
-                        case 6: // diffStat (not implemented)
-                            byteIndex += sizeof(uint8_t);
-                            break;
-                        case 7: // res (not implemented)
-                            byteIndex += sizeof(uint8_t);
-                            break;
-                        case 8: // ttff (not implemented)
-                            byteIndex += sizeof(uint32_t);
-                            break;
-                        case 12: // msss (not implemented)
-                            byteIndex += sizeof(uint32_t);
-                    } //  NAV_STATUS_ID byte
-                    break;
-                // ------------- NAV-VELNED (0x01 0x12) --------------
-                case NAV_VELOCITY_ID:
-                    switch (byteIndex - PAYLOAD_INDEX) {
-                        case 0: // iTow (not implemented)
-                            byteIndex += sizeof(uint32_t);
-                            break;
-                        case 4: // velN
-                            velocity.north = (int32_t)(rawMessage[byteIndex]
-                                    + ((int32_t)rawMessage[byteIndex + 1] << 8)
-                                    + ((int32_t)rawMessage[byteIndex + 2] << 16)
-                                    + ((int32_t)rawMessage[byteIndex + 3] << 24));
-                            byteIndex += sizeof(int32_t);
-                            break;
-                        case 8: // velE
-                            velocity.east = (int32_t)(rawMessage[byteIndex]
-                                    + ((int32_t)rawMessage[byteIndex + 1] << 8)
-                                    + ((int32_t)rawMessage[byteIndex + 2] << 16)
-                                    + ((int32_t)rawMessage[byteIndex + 3] << 24));
-                            byteIndex += sizeof(int32_t);
-                            break;
-                        case 12: // velD
-                            byteIndex += sizeof(int32_t);
-                            break;
-                        case 16: // speed
-                            byteIndex += sizeof(uint32_t);
-                            break;
-                        case 20: // gSpeed
-                            byteIndex += sizeof(uint32_t);
-                            break;
-                        case 24: // heading
-                            heading = (int32_t)(rawMessage[byteIndex]
-                                    + ((int32_t)rawMessage[byteIndex + 1] << 8)
-                                    + ((int32_t)rawMessage[byteIndex + 2] << 16)
-                                    + ((int32_t)rawMessage[byteIndex + 3] << 24));
-                            byteIndex += sizeof(int32_t);
-                            break;
-                        case 28: // sAcc
-                            byteIndex += sizeof(uint32_t);
-                        case 32: // cAcc
-                            byteIndex += sizeof(uint32_t);
-                    } //  NAV_STATUS_ID byte
-                    break;// ------------- End of Valid NAV message IDs --------------
-                default:
-                    byteIndex = messageLength; // skip rest of message
+/**********************************************************************
+ * Function: runConfigSM()
+ * @return None
+ * @remark Steps the receiver auto-configuration, never waits. The
+ *  receiver may already be at the desired baud rate (the board reset
+ *  but the GPS didn't), so CFG-PRT is sent blind and every command
+ *  after it waits for an ACK at the new rate. No ACKs at all means the
+ *  switch was missed, so it is tried again.
+ **********************************************************************/
+void runConfigSM() {
+    switch (configState) {
+        case CONFIG_PORT:
+            // Can't wait for this ACK, it comes back at the new baud rate
+            sendPortConfig();
+            Timer_new(TIMER_GPS_CONFIG, CONFIG_SWITCH_DELAY);
+            configState = CONFIG_SWITCH;
+            break;
+        case CONFIG_SWITCH:
+            if (!UART_isTransmitEmpty(GPS_UART_ID)
+                    || !Timer_isExpired(TIMER_GPS_CONFIG))
+                break;
+            UART_init(GPS_UART_ID, DESIRED_BAUDRATE);
+            startIdleState();
+            configCommand = 0;
+            configRetries = 0;
+            sendConfigCommand();
+            configState = CONFIG_COMMAND;
+            break;
+        case CONFIG_COMMAND:
+            if (ackState != ACK_WAITING) {
                 #ifdef DEBUG
-                    printf("Received unhandled navigation message id: 0x%X.\n", messageId);
-                    while (!Serial_isTransmitEmpty()) { asm("nop"); }
+                if (ackState == NAK_RECEIVED)
+                    printf("GPS rejected configuration command %d.\n", configCommand);
                 #endif
-            } // switch messageID = NAV_CLASS
+                // A NAK is an unsupported setting, carry on without it
+                if (ackState == ACK_RECEIVED && (configCommand
+                        > configRates->count || configLast == 0))
+                    isConfigSaved = TRUE;
+                configCommand++;
+                configRetries = 0;
+                if (configCommand > configLast) {
+                    isConfigured = TRUE;
+                    configState = CONFIG_OFF;
+                    if (hasWarmStart)
+                        sendWarmStart();
+                }
+                else {
+                    sendConfigCommand();
+                }
+            }
+            else if (Timer_isExpired(TIMER_GPS_CONFIG)) {
+                if (++configRetries <= CONFIG_RETRIES) {
+                    sendConfigCommand();
+                }
+                else if (++configPortRetries < CONFIG_PORT_RETRIES) {
+                    UART_init(GPS_UART_ID, START_BAUDRATE);
+                    startPortConfig();
+                }
+                else {
+                    #ifdef DEBUG
+                    printf("GPS did not answer the configuration.\n");
+                    #endif
+                    // Not a u-blox, or one that won't take UBX, so only
+                    //  NMEA from here at the rate it starts up with
+                    UART_init(GPS_UART_ID, START_BAUDRATE);
+                    startIdleState();
+                    configState = CONFIG_OFF;
+                }
+            }
             break;
-        // #################### End of NAV messages #######################
         default:
-            byteIndex = messageLength; // skip rest of message
-        #ifdef DEBUG
-            printf("Received unhandled message class: 0x%X.\n", messageClass);
-            while (!Serial_isTransmitEmpty()) { asm("nop"); }
-        #endif
-    } // switch messageClass
+            break;
+    } // switch
+}
+
+/**********************************************************************
+ * Function: startPortConfig()
+ * @return None
+ * @remark Starts the auto-configuration over with CFG-PRT.
+ **********************************************************************/
+void startPortConfig() {
+    // The rates, then saving them
+    configLast = configRates->count + 1;
+    configState = CONFIG_PORT;
+}
+
+/**********************************************************************
+ * Function: sendPortConfig()
+ * @return None
+ * @remark Sends a CFG-PRT that moves the receiver's UART to the desired
+ *  baud rate.
+ **********************************************************************/
+void sendPortConfig() {
+    uint8_t payload[] = { PRT_PORT_UART1, 0,
+        PACK_LITTLE_ENDIAN_16(0), // txReady
+        PACK_LITTLE_ENDIAN_32(PRT_MODE_8N1),
+        PACK_LITTLE_ENDIAN_32(DESIRED_BAUDRATE),
+        PACK_LITTLE_ENDIAN_16(PRT_PROTOCOL_UBX | PRT_PROTOCOL_NMEA), // in
+        PACK_LITTLE_ENDIAN_16(PRT_PROTOCOL_UBX), // out
+        PACK_LITTLE_ENDIAN_16(0), // flags
+        PACK_LITTLE_ENDIAN_16(0) };
+    sendMessage(CFG_CLASS, CFG_PRT_ID, payload, sizeof(payload));
+}
+
+/**********************************************************************
+ * Function: sendConfigCommand()
+ * @return None
+ * @remark Sends the current configuration command, CFG-RATE first,
+ *  then a CFG-MSG for each message rate, then a CFG-CFG to save them, and
+ *  starts its ACK timeout.
+ **********************************************************************/
+void sendConfigCommand() {
+    const UbxRate *rate;
+
+    if (configCommand == 0) {
+        uint8_t payload[] = { PACK_LITTLE_ENDIAN_16(GPS_NAV_PERIOD),
+            PACK_LITTLE_ENDIAN_16(1), // navRate, cycles per solution
+            PACK_LITTLE_ENDIAN_16(RATE_TIME_GPS) };
+        sendMessage(CFG_CLASS, CFG_RATE_ID, payload, sizeof(payload));
+    }
+    else if (configCommand > configRates->count) {
+        uint8_t payload[] = { PACK_LITTLE_ENDIAN_32(0), // clearMask
+            PACK_LITTLE_ENDIAN_32(CFG_SAVE_MASK),
+            PACK_LITTLE_ENDIAN_32(0), // loadMask
+            CFG_DEVICE_MASK };
+        sendMessage(CFG_CLASS, CFG_CFG_ID, payload, sizeof(payload));
+    }
+    else {
+        rate = &configRates->rates[configCommand - 1];
+        setMessageRate(rate->class, rate->id, rate->rate);
+    }
+    ackState = ACK_WAITING;
+    Timer_new(TIMER_GPS_CONFIG, CONFIG_ACK_TIMEOUT);
+}
+
+/**********************************************************************
+ * Function: sendWarmStart()
+ * @return None
+ * @remark Sends the AID-INI of GPS_setWarmStart, once.
+ **********************************************************************/
+void sendWarmStart() {
+    uint8_t payload[] = {
+        PACK_LITTLE_ENDIAN_32(warmStart.latitude),
+        PACK_LITTLE_ENDIAN_32(warmStart.longitude),
+        PACK_LITTLE_ENDIAN_32(warmStart.altitude / AID_ALTITUDE_PER_CM),
+        PACK_LITTLE_ENDIAN_32(warmStartAccuracy * 100), // posAcc (cm)
+        PACK_LITTLE_ENDIAN_16(0), // tmCfg
+        PACK_LITTLE_ENDIAN_16(0), // wn, no time to give
+        PACK_LITTLE_ENDIAN_32(0), // tow
+        PACK_LITTLE_ENDIAN_32(0), // towNs
+        PACK_LITTLE_ENDIAN_32(0), // tAccMs
+        PACK_LITTLE_ENDIAN_32(0), // tAccNs
+        PACK_LITTLE_ENDIAN_32(0), // clkDOrFreq
+        PACK_LITTLE_ENDIAN_32(0), // clkDAcc
+        PACK_LITTLE_ENDIAN_32(AID_FLAG_POSITION | AID_FLAG_LLA) };
+    sendMessage(AID_CLASS, AID_INI_ID, payload, sizeof(payload));
+    hasWarmStart = FALSE;
+}
+
+/**********************************************************************
+ * Function: sendMessage()
+ * @param Message class.
+ * @param Message id.
+ * @param Payload of the message.
+ * @param Length of the payload.
+ * @return None
+ * @remark Frames a UBX message with its checksum and queues it for the
+ *  GPS. Never waits, the UART transmits it from its buffer.
+ **********************************************************************/
+void sendMessage(uint8_t class, uint8_t id, const uint8_t *payload,
+    uint16_t length) {
+    uint8_t header[PAYLOAD_INDEX] = { SYNC1_CHAR, SYNC2_CHAR, class, id,
+        length & 0xFF, length >> 8 };
+    uint8_t checksum[CHECKSUM_BYTES] = { 0, 0 };
+    uint16_t i;
+
+    for (i = CLASS_INDEX; i < PAYLOAD_INDEX; i++) {
+        checksum[0] += header[i];
+        checksum[1] += checksum[0];
+    }
+    for (i = 0; i < length; i++) {
+        checksum[0] += payload[i];
+        checksum[1] += checksum[0];
+    }
+
+    UART_write(GPS_UART_ID, header, PAYLOAD_INDEX);
+    UART_write(GPS_UART_ID, payload, length);
+    UART_write(GPS_UART_ID, checksum, CHECKSUM_BYTES);
+}
+
+/**********************************************************************
+ * Function: setMessageRate()
+ * @param Message class.
+ * @param Message id.
+ * @param Send the message every this many navigation epochs, 0 for never.
+ * @return None
+ * @remark Sends a CFG-MSG to set a message's rate on the current port.
+ **********************************************************************/
+void setMessageRate(uint8_t class, uint8_t id, uint8_t rate) {
+    uint8_t payload[CFG_MSG_LENGTH] = { class, id, rate };
+    sendMessage(CFG_CLASS, CFG_MSG_ID, payload, CFG_MSG_LENGTH);
+}
+
+// ######################## NMEA sentences ############################
+
+/**********************************************************************
+ * Function: startNmeaState
+ * @return None
+ * @remark Switches into the NMEA read state, after a $.
+ **********************************************************************/
+void startNmeaState() {
+    state = STATE_NMEA;
+    hasNewMessage = FALSE;
+    memset(&nmea, 0, sizeof(nmea));
+    nmea.length = 1;
+}
+
+/**********************************************************************
+ * Function: readNmeaByte
+ * @param Byte received from the GPS.
+ * @return SUCCESS, or FAILURE if the sentence is broken.
+ * @remark Decodes an NMEA sentence as it streams in, one character at a
+ *  time, without keeping the text. The XOR checksum over everything
+ *  between $ and * is required, and hasNewMessage is set once it checks
+ *  out so nmeaDecoded can use the fields.
+ **********************************************************************/
+int8_t readNmeaByte(uint8_t data) {
+    if (data == NMEA_START_CHAR || data == '\r' || data == '\n'
+            || ++nmea.length > NMEA_MAX_LENGTH)
+        return FAILURE; // ended before its checksum
+
+    if (nmea.checksumDigits > 0 || data == NMEA_CHECKSUM_CHAR) {
+        if (data == NMEA_CHECKSUM_CHAR) {
+            endNmeaField();
+            nmea.checksumDigits = 1;
+            return SUCCESS;
+        }
+        // Two hex digits after the *
+        if (data >= '0' && data <= '9')
+            data -= '0';
+        else if (data >= 'A' && data <= 'F')
+            data -= 'A' - 10;
+        else if (data >= 'a' && data <= 'f')
+            data -= 'a' - 10;
+        else
+            return FAILURE;
+        nmea.receivedChecksum = (nmea.receivedChecksum << 4) | data;
+        if (++nmea.checksumDigits > CHECKSUM_BYTES) {
+            if (nmea.receivedChecksum != nmea.checksum) {
+                stats.checksumErrors++;
+                return FAILURE;
+            }
+            stats.messages++;
+            hasNewMessage = TRUE;
+        }
+        return SUCCESS;
+    }
+
+    nmea.checksum ^= data;
+    if (data == NMEA_DELIMITER_CHAR) {
+        endNmeaField();
+        nmea.field++;
+        nmea.digits = 0;
+        nmea.decimals = 0;
+        nmea.hasPoint = FALSE;
+        nmea.hasDigits = FALSE;
+        nmea.letter = 0;
+    }
+    else if (nmea.field == 0) {
+        if (nmea.length - 2 < NMEA_TYPE_LENGTH)
+            nmea.typeChars[nmea.length - 2] = data;
+    }
+    else if (data >= '0' && data <= '9') {
+        // Digits past what we keep are dropped, not rounded
+        if (!nmea.hasPoint || nmea.decimals < NMEA_MAX_DECIMALS) {
+            nmea.digits = nmea.digits * 10 + (data - '0');
+            if (nmea.hasPoint)
+                nmea.decimals++;
+        }
+        nmea.hasDigits = TRUE;
+    }
+    else if (data == '.') {
+        nmea.hasPoint = TRUE;
+    }
+    else {
+        nmea.letter = data; // N/S/E/W, A/V, M, or a sign
+    }
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: endNmeaField
+ * @return None
+ * @remark Stores the field that just ended, if the sentence uses it.
+ *  Fields are numbered from the sentence type, and a hemisphere letter
+ *  in its own field flips the number before it.
+ **********************************************************************/
+void endNmeaField() {
+    int32_t sign = (nmea.letter == 'S' || nmea.letter == 'W'
+        || nmea.letter == '-')? -1 : 1;
+
+    if (nmea.field == 0) {
+        if (memcmp(&nmea.typeChars[2], "GGA", 3) == 0)
+            nmea.type = NMEA_GGA;
+        else if (memcmp(&nmea.typeChars[2], "RMC", 3) == 0)
+            nmea.type = NMEA_RMC;
+        return;
+    }
+
+    switch (nmea.type) {
+        // -------------- GGA: time, position, fix quality, altitude
+        case NMEA_GGA:
+            switch (nmea.field) {
+                case 1: nmea.time = nmeaToTime(); break;
+                case 2: nmea.latitude = nmeaToCoordinate(); break;
+                case 3: nmea.latitude *= sign; break;
+                case 4: nmea.longitude = nmeaToCoordinate(); break;
+                case 5: nmea.longitude *= sign; break;
+                case 6: nmea.quality = (uint8_t)nmea.digits; break;
+                case 9: nmea.altitude = sign * scaleNmeaNumber(GPS_ALTITUDE_SCALE); break;
+                default: break;
+            }
+            break;
+        // -------------- RMC: time, status, speed, course
+        case NMEA_RMC:
+            switch (nmea.field) {
+                case 1: nmea.time = nmeaToTime(); break;
+                case 2: nmea.status = nmea.letter; break;
+                case 7: nmea.speed = KNOTS_TO_CM_PER_S(scaleNmeaNumber(100)) / 100; break;
+                case 8: nmea.course = scaleNmeaNumber(100000); break;
+                default: break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**********************************************************************
+ * Function: nmeaDecoded
+ * @return None
+ * @remark Copies a checked NMEA sentence into the same fix variables the
+ *  UBX messages use. The time of week is the UTC time of day, which is
+ *  enough to line up a GGA and RMC from the same epoch.
+ **********************************************************************/
+void nmeaDecoded() {
+    float course;
+
+    setConnected();
+
+    switch (nmea.type) {
+        case NMEA_GGA:
+            gpsStatus = (nmea.quality > 0)? NMEA_FIX_STATUS : NOFIX_STATUS;
+            iTOW = nmea.time;
+            geodetic.latitude = nmea.latitude;
+            geodetic.longitude = nmea.longitude;
+            geodetic.altitude = nmea.altitude;
+            positionDecoded();
+            break;
+        case NMEA_RMC:
+            if (nmea.status != 'A')
+                break;
+            // Course over ground, north through east, to a NED velocity
+            course = (float)nmea.course * (3.14159265f / 180.0f / 100000.0f);
+            velocityITOW = nmea.time;
+            velocity.north = (int32_t)(nmea.speed * cosf(course));
+            velocity.east = (int32_t)(nmea.speed * sinf(course));
+            heading = nmea.course;
+            velocityDecoded();
+            break;
+        default:
+            break;
+    }
+}
+
+/**********************************************************************
+ * Function: scaleNmeaNumber
+ * @param Units wanted per unit of the field.
+ * @return The number in the current field times multiplier.
+ **********************************************************************/
+int32_t scaleNmeaNumber(int32_t multiplier) {
+    int64_t value = (int64_t)nmea.digits * multiplier;
+    uint8_t i;
+    for (i = 0; i < nmea.decimals; i++)
+        value /= 10;
+    return (int32_t)value;
+}
+
+/**********************************************************************
+ * Function: nmeaToCoordinate
+ * @return The current field, in (d)ddmm.mmmm, as degrees scaled 1e7.
+ **********************************************************************/
+int32_t nmeaToCoordinate() {
+    uint32_t scale = 1, degrees, minutes;
+    uint8_t i;
+    for (i = 0; i < nmea.decimals; i++)
+        scale *= 10;
+    degrees = nmea.digits / (100 * scale);
+    minutes = nmea.digits - degrees * 100 * scale; // scaled minutes
+    return (int32_t)(degrees * GPS_COORDINATE_SCALE
+        + ((int64_t)minutes * GPS_COORDINATE_SCALE) / (60 * scale));
+}
+
+/**********************************************************************
+ * Function: nmeaToTime
+ * @return The current field, in hhmmss.ss, as milliseconds of the day.
+ **********************************************************************/
+int32_t nmeaToTime() {
+    int32_t hhmmss = scaleNmeaNumber(1);
+    int32_t ms = scaleNmeaNumber(1000) - hhmmss * 1000;
+    return ((hhmmss / 10000) * 3600 + ((hhmmss / 100) % 100) * 60
+        + (hhmmss % 100)) * 1000 + ms;
 }
 
 /****************************** TESTS ************************************/
@@ -632,7 +1722,7 @@ int main() {
             Timer_new(TIMER_TEST,1000);
         }
         GPS_runSM();
-
+        Serial_runSM();
     }
 }
 
@@ -0,0 +1,333 @@
+/**********************************************************************
+ Module
+   Guidance.c
+
+ Revision
+   1.0.0
+
+ Description
+   Steers the boat to a rescue target: bearing and range from the
+   navigation estimate, a heading PID into the rudder and a speed PI into
+   the throttle, at a fixed control period.
+
+ Notes
+   Everything runs off TIMER_GUIDANCE, so dt is the constant
+   GUIDANCE_PERIOD and the gains don't need rescaling per step. The
+   derivative is taken on the measured heading rather than the error, so
+   a new target doesn't kick the rudder, and the integral is clamped so
+   it can't wind up while the rudder is slew limited.
+
+   Commands are in [-1, 1] for the rudder (positive turns to starboard)
+   and [0, 1] for the throttle, and mapped onto the duty cycle at the end.
+
+***********************************************************************/
+
+#include <xc.h>
+#include <stdio.h>
+#include <math.h>
+#include "Board.h"
+#include "Timer.h"
+#include "PWM.h"
+#include "FastMath.h"
+#include "Gps.h"
+#include "Navigation.h"
+#ifndef USE_SENSOR_FUSION
+#include "Magnetometer.h"
+#endif
+#include "Guidance.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define DT                      (GUIDANCE_PERIOD / 1000.0f) // (s)
+#define PWM_FREQUENCY           PWM_1KHZ
+
+// Heading PID, on the error in degrees, out in rudder
+#define HEADING_KP              0.02f // full rudder at 50 degrees off
+#define HEADING_KI              0.002f // per degree second
+#define HEADING_KD              0.005f // per degree/s of turn rate
+#define HEADING_INTEGRAL_LIMIT  0.3f // (rudder)
+
+// Speed PI, on the error in m/s, out in throttle
+#define SPEED_KP                0.3f
+#define SPEED_KI                0.1f // per m
+#define SPEED_INTEGRAL_LIMIT    0.5f // (throttle)
+#define MAX_SPEED               3.0f // (m/s)
+#define APPROACH_GAIN           0.2f // (1/s) desired speed per meter of range
+
+// Largest change in one period, full rudder swing takes a second
+#define RUDDER_SLEW             (2.0f * DT)
+#define THROTTLE_SLEW           (0.5f * DT)
+
+// Duty cycles, see PWM.h
+#define RUDDER_CENTER           ((MIN_PWM + MAX_PWM) / 2)
+#define RUDDER_RANGE            ((MAX_PWM - MIN_PWM) / 2)
+#define THROTTLE_OFF            MIN_PWM
+#define THROTTLE_RANGE          (MAX_PWM - MIN_PWM)
+
+#define CLAMP(x, low, high)     (((x) < (low))? (low) : (((x) > (high))? (high) : (x)))
+
+/***********************************************************************
+ * PRIVATE VARIABLES                                                   *
+ ***********************************************************************/
+
+static GuidanceState state = GUIDANCE_IDLE;
+static GpsCoordinate target;
+static float range = 0.0f, bearing = 0.0f; // (m), (degrees)
+
+static struct {
+    float headingIntegral, speedIntegral;
+    float lastHeading;
+    BOOL hasLastHeading;
+    float rudder, throttle; // last commands
+} control;
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static BOOL getBoatState(float *north, float *east, float *heading, float *speed);
+static void resetControl();
+static void setMotors(float rudder, float throttle);
+static void setDuties();
+static float wrapDegrees(float angle);
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+BOOL Guidance_init() {
+    if (PWM_init(GUIDANCE_RUDDER_PWM | GUIDANCE_THROTTLE_PWM, PWM_FREQUENCY)
+            != SUCCESS)
+        return FAILURE;
+    Guidance_stop();
+    Timer_new(TIMER_GUIDANCE, GUIDANCE_PERIOD);
+    return SUCCESS;
+}
+
+void Guidance_runSM() {
+    float north, east, heading, speed;
+    float error, rate, rudder, desiredSpeed, throttle;
+
+    if (!Timer_isExpired(TIMER_GUIDANCE))
+        return;
+    Timer_new(TIMER_GUIDANCE, GUIDANCE_PERIOD);
+
+    if (state == GUIDANCE_IDLE)
+        return;
+
+    // Fail safe without a position, pick up again once it comes back
+    if (!getBoatState(&north, &east, &heading, &speed)) {
+        state = GUIDANCE_HOLDING;
+        resetControl();
+        setMotors(0.0f, 0.0f);
+        return;
+    }
+
+    range = hypotf(north, east);
+    bearing = RADIAN_TO_DEGREE * FastMath_atan2(east, north);
+    if (bearing < 0.0f)
+        bearing += 360.0f;
+
+    if (range < GUIDANCE_ARRIVAL_RADIUS) {
+        if (state != GUIDANCE_ARRIVED) {
+            #ifdef DEBUG
+            printf("Guidance: arrived, %.1f m from the target.\n", range);
+            #endif
+            state = GUIDANCE_ARRIVED;
+        }
+        resetControl();
+        setMotors(0.0f, 0.0f);
+        return;
+    }
+    state = GUIDANCE_TRACKING;
+
+    // Heading PID, derivative on the measurement
+    error = wrapDegrees(bearing - heading);
+    rate = control.hasLastHeading?
+        wrapDegrees(heading - control.lastHeading) / DT : 0.0f;
+    control.lastHeading = heading;
+    control.hasLastHeading = TRUE;
+    control.headingIntegral = CLAMP(control.headingIntegral
+        + HEADING_KI * error * DT, -HEADING_INTEGRAL_LIMIT, HEADING_INTEGRAL_LIMIT);
+    rudder = HEADING_KP * error + control.headingIntegral - HEADING_KD * rate;
+
+    // Slow down close in, and while pointing the wrong way
+    desiredSpeed = APPROACH_GAIN * range;
+    if (desiredSpeed > MAX_SPEED)
+        desiredSpeed = MAX_SPEED;
+    desiredSpeed *= CLAMP(FastMath_cos(error * DEGREE_TO_RADIAN), 0.0f, 1.0f);
+
+    error = desiredSpeed - speed;
+    control.speedIntegral = CLAMP(control.speedIntegral
+        + SPEED_KI * error * DT, -SPEED_INTEGRAL_LIMIT, SPEED_INTEGRAL_LIMIT);
+    throttle = SPEED_KP * error + control.speedIntegral;
+
+    setMotors(rudder, throttle);
+}
+
+void Guidance_setTarget(const GpsCoordinate *newTarget) {
+    target = *newTarget;
+    resetControl();
+    state = GUIDANCE_TRACKING;
+    #ifdef DEBUG
+    printf("Guidance: new target at %ld, %ld.\n", (long)target.latitude,
+        (long)target.longitude);
+    #endif
+}
+
+void Guidance_moveTarget(const GpsCoordinate *newTarget) {
+    if (state == GUIDANCE_IDLE) {
+        Guidance_setTarget(newTarget);
+        return;
+    }
+    target = *newTarget;
+}
+
+void Guidance_stop() {
+    state = GUIDANCE_IDLE;
+    resetControl();
+    control.rudder = 0.0f;
+    control.throttle = 0.0f;
+    setDuties();
+}
+
+GuidanceState Guidance_getState() {
+    return state;
+}
+
+float Guidance_getRange() {
+    return range;
+}
+
+float Guidance_getBearing() {
+    return bearing;
+}
+
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: getBoatState
+ * @param Set to meters north to the target.
+ * @param Set to meters east to the target.
+ * @param Set to the boat's heading in degrees from north.
+ * @param Set to the boat's speed over ground in m/s.
+ * @return TRUE, or FALSE if there is no position.
+ * @remark Flat earth around the boat, fine over the few kilometers a
+ *  rescue covers.
+ **********************************************************************/
+static BOOL getBoatState(float *north, float *east, float *heading, float *speed) {
+    GpsCoordinate boat;
+    #ifdef USE_SENSOR_FUSION
+    Pose pose;
+    if (!Navigation_getPose(&pose) || !Navigation_getPoseCoordinate(&boat))
+        return FALSE;
+    *heading = pose.heading;
+    *speed = hypotf(pose.velocityNorth, pose.velocityEast);
+    #else
+    if (!GPS_hasFix() || !GPS_hasPosition())
+        return FALSE;
+    GPS_getCoordinate(&boat);
+    *heading = Magnetometer_getDegree();
+    *speed = hypotf((float)GPS_getNorthVelocity(),
+        (float)GPS_getEastVelocity()) / 100.0f;
+    #endif
+
+    *north = METERS_PER_COORDINATE * (target.latitude - boat.latitude);
+    *east = METERS_PER_COORDINATE * (target.longitude - boat.longitude)
+        * FastMath_cos((float)boat.latitude / GPS_COORDINATE_SCALE
+            * DEGREE_TO_RADIAN);
+    return TRUE;
+}
+
+static void resetControl() {
+    control.headingIntegral = 0.0f;
+    control.speedIntegral = 0.0f;
+    control.hasLastHeading = FALSE;
+}
+
+/**********************************************************************
+ * Function: setMotors
+ * @param Rudder command from -1 (port) to 1 (starboard).
+ * @param Throttle command from 0 to 1.
+ * @return None
+ * @remark Clamps and slew limits the commands, then sets the duty cycles.
+ **********************************************************************/
+static void setMotors(float rudder, float throttle) {
+    rudder = CLAMP(rudder, -1.0f, 1.0f);
+    throttle = CLAMP(throttle, 0.0f, 1.0f);
+    control.rudder += CLAMP(rudder - control.rudder, -RUDDER_SLEW, RUDDER_SLEW);
+    control.throttle += CLAMP(throttle - control.throttle,
+        -THROTTLE_SLEW, THROTTLE_SLEW);
+    setDuties();
+}
+
+// Both channels change in the same PWM period, at the timer's resolution
+static void setDuties() {
+    unsigned int duties[PWM_CHANNELS];
+    float ticksPerDuty = (float)PWM_getResolution() / MAX_PWM;
+
+    duties[PWM_INDEX(GUIDANCE_RUDDER_PWM)] = (unsigned int)(ticksPerDuty
+        * (RUDDER_CENTER + control.rudder * RUDDER_RANGE) + 0.5f);
+    duties[PWM_INDEX(GUIDANCE_THROTTLE_PWM)] = (unsigned int)(ticksPerDuty
+        * (THROTTLE_OFF + control.throttle * THROTTLE_RANGE) + 0.5f);
+    PWM_setDutyCycles(GUIDANCE_RUDDER_PWM | GUIDANCE_THROTTLE_PWM, duties);
+}
+
+// Angle difference in (-180, 180]
+static float wrapDegrees(float angle) {
+    while (angle > 180.0f)
+        angle -= 360.0f;
+    while (angle <= -180.0f)
+        angle += 360.0f;
+    return angle;
+}
+
+//#define GUIDANCE_TEST
+#ifdef GUIDANCE_TEST
+
+#include "Serial.h"
+
+int main() {
+    Board_init();
+    Serial_init();
+    Timer_init();
+    if (GPS_init(0x0) != SUCCESS || Navigation_init() != SUCCESS
+            || Guidance_init() != SUCCESS) {
+        printf("Guidance failed to initialize.\n");
+        return FAILURE;
+    }
+    #ifndef USE_SENSOR_FUSION
+    Magnetometer_init();
+    #endif
+
+    while (!Navigation_isReady())
+        Navigation_runSM();
+
+    // Go 50 m north of where we started
+    GpsCoordinate here;
+    GPS_getCoordinate(&here);
+    here.latitude += (int32_t)(50.0f / METERS_PER_COORDINATE);
+    Guidance_setTarget(&here);
+
+    Timer_new(TIMER_TEST, 1000);
+    while (1) {
+        Navigation_runSM();
+        #ifndef USE_SENSOR_FUSION
+        Magnetometer_runSM();
+        #endif
+        Guidance_runSM();
+        if (Timer_isExpired(TIMER_TEST)) {
+            printf("State %d, range %.1f m, bearing %.1f\n",
+                Guidance_getState(), Guidance_getRange(), Guidance_getBearing());
+            Timer_new(TIMER_TEST, 1000);
+        }
+    }
+
+    return SUCCESS;
+}
+
+#endif
@@ -12,6 +12,10 @@
 #include <stdio.h>
 #include <plib.h>
 #include <stdint.h>
+#include "Board.h"
+#include "Timer.h"
+#include "I2C.h"
+#include "Error.h"
 
 
 /***********************************************************************
@@ -21,10 +25,105 @@
 // Printing debug messages over serial
 #define DEBUG
 
+#define ADDRESS_WRITE(address)  ((address) << 1)
+#define ADDRESS_READ(address)   (((address) << 1) | 1)
+
+#define WAIT_CYCLES             (I2C_WAIT_TIMEOUT * TIMER_CYCLES_PER_MICRO)
+#define MARGIN_CYCLES           (I2C_TIMEOUT_MARGIN * TIMER_CYCLES_PER_MICRO)
+#define BITS_PER_BYTE           9 // with the acknowledge
+#define WATCHDOG_PERIOD         1 // (ms)
+
+// Clocking SCL by hand at 100 kHz
+#define RECOVERY_PULSES         9
+#define RECOVERY_HALF_PERIOD    (5 * TIMER_CYCLES_PER_MICRO)
+
+// Waits until condition holds, or sets timedOut after WAIT_CYCLES
+#define WAIT_FOR(condition, timedOut) do { \
+        uint32_t waitStart = Timer_getCycles(); \
+        timedOut = FALSE; \
+        while (!(condition)) { \
+            if (Timer_getCycles() - waitStart > WAIT_CYCLES) { \
+                timedOut = TRUE; \
+                break; \
+            } \
+        } \
+    } while (0)
+
+/***********************************************************************
+ * PRIVATE TYPEDEFS                                                    *
+ ***********************************************************************/
+
+// Where the running transfer is, each state ends with a master interrupt
+typedef enum {
+    STATE_IDLE = 0,
+    STATE_START,            // start condition
+    STATE_WRITE_ADDRESS,    // address with the write bit
+    STATE_WRITE,            // one of the write bytes
+    STATE_RESTART,          // repeated start before the read
+    STATE_READ_ADDRESS,     // address with the read bit
+    STATE_READ,             // receiving a byte
+    STATE_ACKNOWLEDGE,      // ack (or nack for the last byte) sent
+    STATE_STOP,             // stop condition
+} TransferState;
+
+typedef struct {
+    I2C_MODULE module;
+    I2CTransfer *head, *tail;   // queue, head is on the bus
+    TransferState state;
+    uint8_t index;              // next byte to write or read
+    I2CTransferStatus result;   // given to the head at the stop
+    BOOL hasInterrupt;          // set by I2C_init
+    BOOL inInterrupt;           // in handleInterrupt or a callback
+    uint32_t defaultClock;      // (Hz) slowest asked for by I2C_init
+    uint32_t clock;             // (Hz) the bus runs at now
+    uint32_t byteCycles;        // one byte on the wire at that clock
+    struct I2CDevice *device;   // the head's, or NULL
+    uint32_t startCycles, timeoutCycles; // of the head
+    TimerHandle watchdog;       // checks queued transfers while busy
+    // Pins, for clocking the bus by hand
+    volatile unsigned int *tris, *lat, *port;
+    unsigned int sclMask, sdaMask;
+} I2CBus;
+
+typedef struct I2CDevice {
+    I2C_MODULE module;
+    uint8_t address;
+    uint32_t clock;             // (Hz) fastest it takes, 0 for the default
+    I2CDeviceErrors errors;
+} I2CDevice;
+
 /***********************************************************************
  * PRIVATE VARIABLES                                                   *
  ***********************************************************************/
 
+static I2CBus busTable[] = {
+    { .module = I2C1, .watchdog = TIMER_INVALID, .tris = &TRISG, .lat = &LATG,
+        .port = &PORTG, .sclMask = 1 << 2, .sdaMask = 1 << 3 }, // RG2, RG3
+    { .module = I2C2, .watchdog = TIMER_INVALID, .tris = &TRISF, .lat = &LATF,
+        .port = &PORTF, .sclMask = 1 << 5, .sdaMask = 1 << 4 }, // RF5, RF4
+};
+
+#define BUS_COUNT (sizeof(busTable) / sizeof(busTable[0]))
+
+static I2CDevice deviceTable[I2C_DEVICE_MAX];
+static uint8_t deviceCount = 0;
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static I2CBus *getBus(I2C_MODULE module);
+static void handleInterrupt(I2CBus *bus);
+static void startNext(I2CBus *bus);
+static void stop(I2CBus *bus, I2CTransferStatus result);
+static void finish(I2CBus *bus);
+static void checkTimeout(I2CBus *bus);
+static void watchdogExpired(TimerHandle timer, void *context);
+static void recover(I2CBus *bus);
+static void delayCycles(uint32_t cycles);
+static void setClock(I2CBus *bus, uint32_t clock);
+static I2CDevice *getDevice(I2C_MODULE module, uint8_t address, BOOL add);
+
 /***********************************************************************
  * PUBLIC FUNCTIONS                                                    *
  ***********************************************************************/
@@ -35,11 +134,11 @@ void I2C_acknowledgeRead(I2C_MODULE I2C_ID, BOOL ack) {
 }
 
 BOOL I2C_hasAcknowledged(I2C_MODULE I2C_ID) {
-    I2CAcknowledgeHasCompleted(I2C_ID);
+    return I2CAcknowledgeHasCompleted(I2C_ID);
 }
 
 BOOL I2C_startTransfer(I2C_MODULE I2C_ID, BOOL restart){
-    I2C_STATUS  status;
+    BOOL timedOut;
 
 // Send the Start (or Restart) signal
     if(restart){
@@ -52,7 +151,15 @@ BOOL I2C_startTransfer(I2C_MODULE I2C_ID, BOOL restart){
     }
     else{
     // Wait for the bus to be idle, then start the transfer
-        while( !I2CBusIsIdle(I2C_ID) );
+        WAIT_FOR(I2CBusIsIdle(I2C_ID), timedOut);
+        if (timedOut) {
+            #ifdef DEBUG
+            printf("Error: Bus stuck before Start, recovering\n");
+            #endif
+            if (getBus(I2C_ID) != NULL)
+                recover(getBus(I2C_ID));
+            return FALSE;
+        }
         if(I2CStart(I2C_ID) != I2C_SUCCESS){
             #ifdef DEBUG
             printf("Error: Bus collision during transfer Start at Write\n");
@@ -61,31 +168,38 @@ BOOL I2C_startTransfer(I2C_MODULE I2C_ID, BOOL restart){
         }
     }
     // Wait for the signal to complete
-    do{
-        status = I2CGetStatus(I2C_ID);
+    WAIT_FOR(I2CGetStatus(I2C_ID) & I2C_START, timedOut);
+    if (timedOut) {
+        #ifdef DEBUG
+        printf("Error: Start timed out\n");
+        #endif
+        return FALSE;
     }
-    while (!(status & I2C_START) );
 
     return TRUE;
 }
 
 void I2C_stopTransfer(I2C_MODULE I2C_ID){
-    I2C_STATUS  status;
+    BOOL timedOut;
 
     // Send the Stop signal
     I2CStop(I2C_ID);
 
     // Wait for the signal to complete
-    do{
-        status = I2CGetStatus(I2C_ID);
-    }
-    while (!(status & I2C_STOP));
+    WAIT_FOR(I2CGetStatus(I2C_ID) & I2C_STOP, timedOut);
+    #ifdef DEBUG
+    if (timedOut)
+        printf("Error: Stop timed out\n");
+    #endif
 }
 
 BOOL I2C_transmitOneByte(I2C_MODULE I2C_ID, uint8_t data) {
+    BOOL timedOut;
 
     // Wait for the transmitter to be ready
-    while(!I2CTransmitterIsReady(I2C_ID));
+    WAIT_FOR(I2CTransmitterIsReady(I2C_ID), timedOut);
+    if (timedOut)
+        return FALSE;
 
     // Transmit the byte and check for bus collision
     if(I2CSendByte(I2C_ID, data) == I2C_MASTER_BUS_COLLISION){
@@ -96,7 +210,13 @@ BOOL I2C_transmitOneByte(I2C_MODULE I2C_ID, uint8_t data) {
     }
 
 // Wait for the transmission to finish
-    while(!I2CTransmissionHasCompleted(I2C_ID));
+    WAIT_FOR(I2CTransmissionHasCompleted(I2C_ID), timedOut);
+    if (timedOut) {
+        #ifdef DEBUG
+        printf("Error: I2C transmit timed out\n");
+        #endif
+        return FALSE;
+    }
     
     return TRUE;
 }
@@ -119,6 +239,7 @@ BOOL I2C_sendData(I2C_MODULE I2C_ID, uint8_t data){
 
 int16_t I2C_getData(I2C_MODULE I2C_ID){
     BOOL Success = TRUE;
+    BOOL timedOut;
 
         // Enables the module to receive data from the I2C bus
     if(I2CReceiverEnable(I2C_ID, TRUE) == I2C_RECEIVE_OVERFLOW){
@@ -129,7 +250,13 @@ int16_t I2C_getData(I2C_MODULE I2C_ID){
     }
     else{
     //wait until data is available
-        while(!I2CReceivedDataIsAvailable(I2C_ID));
+        WAIT_FOR(I2CReceivedDataIsAvailable(I2C_ID), timedOut);
+        if (timedOut) {
+            #ifdef DEBUG
+            printf("Error: I2C receive timed out\n");
+            #endif
+            return FALSE;
+        }
     //get a byte of data received from the I2C bus.
         return I2CGetByte(I2C_ID);
     }
@@ -137,10 +264,437 @@ int16_t I2C_getData(I2C_MODULE I2C_ID){
 }
 
 void I2C_init(I2C_MODULE I2C_ID, uint32_t I2C_clockFreq) {
+    I2CBus *bus = getBus(I2C_ID);
 
     // Configure Various I2C Options
     I2CConfigure(I2C_ID, I2C_EN);
 
-    // Set Desired Operation Frequency
-    I2CSetFrequency(I2C_ID, Board_GetPBClock(), I2C_clockFreq);
-}
\ No newline at end of file
+    // Set Desired Operation Frequency, the slowest any module asked for
+    if (bus == NULL) {
+        I2CSetFrequency(I2C_ID, Board_GetPBClock(), I2C_clockFreq);
+    }
+    else {
+        if (bus->defaultClock == 0 || I2C_clockFreq < bus->defaultClock)
+            bus->defaultClock = I2C_clockFreq;
+        bus->clock = 0;
+        setClock(bus, bus->defaultClock);
+    }
+
+    // Master events and bus collisions share the vector
+    if (bus != NULL && !bus->hasInterrupt) {
+        INTSetVectorPriority(INT_VECTOR_I2C(I2C_ID), INT_PRIORITY_LEVEL_2);
+        INTClearFlag(INT_SOURCE_I2C_MASTER(I2C_ID));
+        INTClearFlag(INT_SOURCE_I2C_BUS(I2C_ID));
+        INTEnable(INT_SOURCE_I2C_MASTER(I2C_ID), INT_ENABLED);
+        INTEnable(INT_SOURCE_I2C_BUS(I2C_ID), INT_ENABLED);
+        bus->hasInterrupt = TRUE;
+    }
+    if (bus != NULL && bus->watchdog == TIMER_INVALID && Timer_isInitialized())
+        bus->watchdog = Timer_create(watchdogExpired, bus);
+}
+
+BOOL I2C_submit(I2C_MODULE I2C_ID, I2CTransfer *transfer) {
+    I2CBus *bus = getBus(I2C_ID);
+    unsigned int intStatus;
+    if (bus == NULL || !bus->hasInterrupt
+            || transfer->status == I2C_TRANSFER_QUEUED
+            || transfer->status == I2C_TRANSFER_BUSY)
+        return FAILURE;
+
+    transfer->status = I2C_TRANSFER_QUEUED;
+    transfer->next = NULL;
+
+    intStatus = INTDisableInterrupts();
+    if (bus->head == NULL) {
+        bus->head = bus->tail = transfer;
+        startNext(bus);
+    }
+    else {
+        bus->tail->next = transfer;
+        bus->tail = transfer;
+    }
+    INTRestoreInterrupts(intStatus);
+
+    // The Timer isn't safe to use from here, a running watchdog goes on
+    if (!bus->inInterrupt && bus->watchdog != TIMER_INVALID
+            && !Timer_isActive(bus->watchdog))
+        Timer_new(bus->watchdog, WATCHDOG_PERIOD);
+    return SUCCESS;
+}
+
+I2CTransferStatus I2C_transfer(I2C_MODULE I2C_ID, I2CTransfer *transfer) {
+    I2CBus *bus = getBus(I2C_ID);
+    unsigned int intStatus;
+    if (I2C_submit(I2C_ID, transfer) != SUCCESS)
+        return I2C_TRANSFER_COLLISION;
+    while (!I2C_IS_FINISHED(transfer->status)) {
+        intStatus = INTDisableInterrupts();
+        checkTimeout(bus);
+        INTRestoreInterrupts(intStatus);
+    }
+    return transfer->status;
+}
+
+BOOL I2C_isBusy(I2C_MODULE I2C_ID) {
+    I2CBus *bus = getBus(I2C_ID);
+    return bus != NULL && bus->head != NULL;
+}
+
+BOOL I2C_readRegisters(I2C_MODULE I2C_ID, uint8_t address, uint8_t reg,
+        uint8_t *data, uint8_t length) {
+    I2CTransfer transfer = {
+        .address = address,
+        .write = &reg,
+        .writeLength = 1,
+        .read = data,
+        .readLength = length,
+    };
+    if (I2C_transfer(I2C_ID, &transfer) != I2C_TRANSFER_DONE)
+        return FAILURE;
+    return SUCCESS;
+}
+
+BOOL I2C_writeRegisters(I2C_MODULE I2C_ID, uint8_t address, uint8_t reg,
+        const uint8_t *data, uint8_t length) {
+    uint8_t buffer[I2C_WRITE_MAX + 1];
+    uint8_t i;
+    I2CTransfer transfer = {
+        .address = address,
+        .write = buffer,
+        .writeLength = length + 1,
+    };
+    if (length > I2C_WRITE_MAX)
+        return FAILURE;
+
+    buffer[0] = reg;
+    for (i = 0; i < length; i++)
+        buffer[i + 1] = data[i];
+    if (I2C_transfer(I2C_ID, &transfer) != I2C_TRANSFER_DONE)
+        return FAILURE;
+    return SUCCESS;
+}
+
+BOOL I2C_addDevice(I2C_MODULE I2C_ID, uint8_t address, uint32_t maxClock) {
+    unsigned int intStatus = INTDisableInterrupts();
+    I2CDevice *device = getDevice(I2C_ID, address, TRUE);
+    if (device != NULL)
+        device->clock = maxClock;
+    INTRestoreInterrupts(intStatus);
+    return (device != NULL)? SUCCESS : FAILURE;
+}
+
+BOOL I2C_getDeviceErrors(I2C_MODULE I2C_ID, uint8_t address,
+        I2CDeviceErrors *errors) {
+    unsigned int intStatus = INTDisableInterrupts();
+    I2CDevice *device = getDevice(I2C_ID, address, FALSE);
+    if (device != NULL)
+        *errors = device->errors;
+    INTRestoreInterrupts(intStatus);
+    return (device != NULL)? SUCCESS : FAILURE;
+}
+
+/**********************************************************************
+ * Function: IntI2C1Handler
+ * @return None.
+ * @remark Master and bus collision interrupt for I2C1, the one for I2C2
+ *  below is the same with its own bus.
+ **********************************************************************/
+void __ISR(_I2C_1_VECTOR, ipl2) IntI2C1Handler(void) {
+    handleInterrupt(&busTable[0]);
+}
+
+void __ISR(_I2C_2_VECTOR, ipl2) IntI2C2Handler(void) {
+    handleInterrupt(&busTable[1]);
+}
+
+/***********************************************************************
+ * PRIVATE FUNCTIONS                                                   *
+ ***********************************************************************/
+
+static I2CBus *getBus(I2C_MODULE module) {
+    uint8_t i;
+    for (i = 0; i < BUS_COUNT; i++) {
+        if (busTable[i].module == module)
+            return &busTable[i];
+    }
+    return NULL;
+}
+
+/**********************************************************************
+ * Function: handleInterrupt
+ * @param Bus that interrupted.
+ * @return None.
+ * @remark Moves the head transfer on by one step. Every step after the
+ *  address checks the acknowledge, and a missing one ends the transfer
+ *  with a stop.
+ **********************************************************************/
+static void handleInterrupt(I2CBus *bus) {
+    I2CTransfer *transfer = bus->head;
+    I2C_MODULE module = bus->module;
+
+    bus->inInterrupt = TRUE;
+    if (INTGetFlag(INT_SOURCE_I2C_BUS(module))) {
+        // Lost arbitration, the module is idle again and needs no stop
+        INTClearFlag(INT_SOURCE_I2C_BUS(module));
+        INTClearFlag(INT_SOURCE_I2C_MASTER(module));
+        I2CClearStatus(module, I2C_ARBITRATION_LOSS);
+        if (transfer != NULL && bus->state != STATE_IDLE) {
+            bus->result = I2C_TRANSFER_COLLISION;
+            finish(bus);
+        }
+        bus->inInterrupt = FALSE;
+        return;
+    }
+    if (!INTGetFlag(INT_SOURCE_I2C_MASTER(module)) || transfer == NULL) {
+        INTClearFlag(INT_SOURCE_I2C_MASTER(module));
+        bus->inInterrupt = FALSE;
+        return;
+    }
+    INTClearFlag(INT_SOURCE_I2C_MASTER(module));
+
+    switch (bus->state) {
+        case STATE_START:
+            if (transfer->writeLength > 0 || transfer->readLength == 0) {
+                bus->state = STATE_WRITE_ADDRESS;
+                I2CSendByte(module, ADDRESS_WRITE(transfer->address));
+            }
+            else {
+                bus->state = STATE_READ_ADDRESS;
+                I2CSendByte(module, ADDRESS_READ(transfer->address));
+            }
+            break;
+        case STATE_WRITE_ADDRESS:
+        case STATE_WRITE:
+            if (!I2CByteWasAcknowledged(module)) {
+                stop(bus, I2C_TRANSFER_NACK);
+            }
+            else if (bus->index < transfer->writeLength) {
+                bus->state = STATE_WRITE;
+                I2CSendByte(module, transfer->write[bus->index++]);
+            }
+            else if (transfer->readLength > 0) {
+                bus->state = STATE_RESTART;
+                I2CRepeatStart(module);
+            }
+            else {
+                stop(bus, I2C_TRANSFER_DONE);
+            }
+            break;
+        case STATE_RESTART:
+            bus->state = STATE_READ_ADDRESS;
+            I2CSendByte(module, ADDRESS_READ(transfer->address));
+            break;
+        case STATE_READ_ADDRESS:
+            if (!I2CByteWasAcknowledged(module)) {
+                stop(bus, I2C_TRANSFER_NACK);
+                break;
+            }
+            bus->index = 0;
+            bus->state = STATE_READ;
+            I2CReceiverEnable(module, TRUE);
+            break;
+        case STATE_READ:
+            transfer->read[bus->index++] = I2CGetByte(module);
+            // Nack the last byte so the device lets go of the bus
+            bus->state = STATE_ACKNOWLEDGE;
+            I2CAcknowledgeByte(module, bus->index < transfer->readLength);
+            break;
+        case STATE_ACKNOWLEDGE:
+            if (bus->index < transfer->readLength) {
+                bus->state = STATE_READ;
+                I2CReceiverEnable(module, TRUE);
+            }
+            else {
+                stop(bus, I2C_TRANSFER_DONE);
+            }
+            break;
+        case STATE_STOP:
+            finish(bus);
+            break;
+        default:
+            break;
+    }
+    bus->inInterrupt = FALSE;
+}
+
+// puts the head on the bus, interrupts must be off or in the ISR
+static void startNext(I2CBus *bus) {
+    I2CTransfer *transfer = bus->head;
+    uint32_t bytes;
+    if (transfer == NULL) {
+        bus->state = STATE_IDLE;
+        return;
+    }
+    transfer->status = I2C_TRANSFER_BUSY;
+    bus->index = 0;
+    bus->state = STATE_START;
+
+    // The bus is idle between transfers, so the speed can change here
+    bus->device = getDevice(bus->module, transfer->address, TRUE);
+    if (bus->device != NULL && bus->device->clock != 0)
+        setClock(bus, bus->device->clock);
+    else
+        setClock(bus, bus->defaultClock);
+
+    // Address and data, the start and stop take about a byte together
+    bytes = 2 + transfer->writeLength;
+    if (transfer->readLength > 0)
+        bytes += 1 + transfer->readLength;
+    bus->timeoutCycles = 2 * bytes * bus->byteCycles + MARGIN_CYCLES;
+    bus->startCycles = Timer_getCycles();
+
+    if (I2CStart(bus->module) != I2C_SUCCESS) {
+        // Most likely a device holding SDA low
+        recover(bus);
+        bus->result = I2C_TRANSFER_COLLISION;
+        finish(bus);
+    }
+}
+
+static void stop(I2CBus *bus, I2CTransferStatus result) {
+    bus->result = result;
+    bus->state = STATE_STOP;
+    I2CStop(bus->module);
+}
+
+// hands the head its result and starts the next one
+static void finish(I2CBus *bus) {
+    I2CTransfer *transfer = bus->head;
+    I2CDevice *device = bus->device;
+    bus->head = transfer->next;
+    if (bus->head == NULL)
+        bus->tail = NULL;
+    transfer->status = bus->result;
+
+    if (device != NULL) {
+        device->errors.transfers++;
+        if (bus->result == I2C_TRANSFER_NACK)
+            device->errors.nacks++;
+        else if (bus->result == I2C_TRANSFER_COLLISION)
+            device->errors.collisions++;
+        else if (bus->result == I2C_TRANSFER_TIMEOUT)
+            device->errors.timeouts++;
+    }
+
+    // Start the next one first, so a callback that submits only queues
+    startNext(bus);
+    if (transfer->callback != NULL)
+        transfer->callback(transfer);
+}
+
+/**********************************************************************
+ * Function: checkTimeout
+ * @param Bus to check.
+ * @return None.
+ * @remark Ends the head transfer with I2C_TRANSFER_TIMEOUT if it's been
+ *  on the bus too long, and recovers the bus. Interrupts must be off.
+ **********************************************************************/
+static void checkTimeout(I2CBus *bus) {
+    if (bus == NULL || bus->head == NULL || bus->state == STATE_IDLE
+            || Timer_getCycles() - bus->startCycles <= bus->timeoutCycles)
+        return;
+
+    bus->inInterrupt = TRUE;
+    recover(bus);
+    INTClearFlag(INT_SOURCE_I2C_MASTER(bus->module));
+    INTClearFlag(INT_SOURCE_I2C_BUS(bus->module));
+    bus->result = I2C_TRANSFER_TIMEOUT;
+    finish(bus);
+    bus->inInterrupt = FALSE;
+}
+
+// runs from Timer_runCallbacks while the bus is busy
+static void watchdogExpired(TimerHandle timer, void *context) {
+    I2CBus *bus = (I2CBus *)context;
+    unsigned int intStatus = INTDisableInterrupts();
+    BOOL busy;
+    checkTimeout(bus);
+    busy = bus->head != NULL;
+    INTRestoreInterrupts(intStatus);
+    if (busy)
+        Timer_new(timer, WATCHDOG_PERIOD);
+}
+
+/**********************************************************************
+ * Function: recover
+ * @param Bus to recover.
+ * @return None.
+ * @remark Turns the module off and clocks SCL by hand until SDA is
+ *  released, at most nine times, then sends a stop and turns the module
+ *  back on. With their latches at 0, the pins are driven low by making
+ *  them outputs and released by making them inputs, the same as an open
+ *  drain. Takes about 110 us.
+ **********************************************************************/
+static void recover(I2CBus *bus) {
+    uint8_t pulse;
+    Error_log(ERROR_MODULE_I2C, ERROR_I2C_LOCKUP, bus->module);
+    I2CEnable(bus->module, FALSE);
+    *bus->lat &= ~(bus->sclMask | bus->sdaMask);
+    *bus->tris |= bus->sclMask | bus->sdaMask;
+    delayCycles(RECOVERY_HALF_PERIOD);
+
+    for (pulse = 0; pulse < RECOVERY_PULSES && !(*bus->port & bus->sdaMask);
+            pulse++) {
+        *bus->tris &= ~bus->sclMask;
+        delayCycles(RECOVERY_HALF_PERIOD);
+        *bus->tris |= bus->sclMask;
+        delayCycles(RECOVERY_HALF_PERIOD);
+    }
+
+    // Stop, SDA rises while SCL is high
+    *bus->tris &= ~bus->sclMask;
+    delayCycles(RECOVERY_HALF_PERIOD);
+    *bus->tris &= ~bus->sdaMask;
+    delayCycles(RECOVERY_HALF_PERIOD);
+    *bus->tris |= bus->sclMask;
+    delayCycles(RECOVERY_HALF_PERIOD);
+    *bus->tris |= bus->sdaMask;
+    delayCycles(RECOVERY_HALF_PERIOD);
+
+    I2CEnable(bus->module, TRUE);
+    bus->state = STATE_IDLE;
+}
+
+static void delayCycles(uint32_t cycles) {
+    uint32_t start = Timer_getCycles();
+    while (Timer_getCycles() - start < cycles)
+        ;
+}
+
+// only touches the baud rate generator when the speed changes
+static void setClock(I2CBus *bus, uint32_t clock) {
+    if (clock == bus->clock)
+        return;
+    I2CSetFrequency(bus->module, Board_GetPBClock(), clock);
+    bus->clock = clock;
+    bus->byteCycles = BITS_PER_BYTE * (TIMER_CYCLES_PER_SECOND / clock);
+}
+
+/**********************************************************************
+ * Function: getDevice
+ * @param Bus the device is on.
+ * @param 7-bit device address.
+ * @param Whether to add it if it's not there yet.
+ * @return The device's entry, or NULL if it isn't there and can't be
+ *  added. Interrupts must be off.
+ **********************************************************************/
+static I2CDevice *getDevice(I2C_MODULE module, uint8_t address, BOOL add) {
+    uint8_t i;
+    I2CDevice *device;
+    for (i = 0; i < deviceCount; i++) {
+        if (deviceTable[i].module == module && deviceTable[i].address == address)
+            return &deviceTable[i];
+    }
+    if (!add || deviceCount >= I2C_DEVICE_MAX)
+        return NULL;
+
+    device = &deviceTable[deviceCount++];
+    device->module = module;
+    device->address = address;
+    device->clock = 0;
+    device->errors.transfers = 0;
+    device->errors.nacks = 0;
+    device->errors.collisions = 0;
+    device->errors.timeouts = 0;
+    return device;
+}
@@ -11,13 +11,23 @@
  Notes
    Implemented similarly to a node in a linked list.
 
+   The free items are a list of their own, through next, so taking one
+   and giving it back are a couple of pointer moves with interrupts off.
+
+   The accessors are macros in Item.h, only what touches the pool is
+   here.
+
  History
  When           Who         What/Why
  -------------- ---         --------
  12-8-12 12:33  dagoodma    Created file.
+ 10-14-26                   Items from a static pool instead of malloc.
+ 10-14-26                   Inline payloads and items inside their data.
 ***********************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
+#include <plib.h>
 #include "Error.h"
 #include "Item.h"
 
@@ -25,10 +35,42 @@
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 
+static ITEM pool[ITEM_POOL_SIZE];
+static Item freeItems = NULL;
+static uint8_t freeCount = 0;
+static bool isPoolReady = FALSE;
+
 /**********************************************************************
  * PRIVATE FUNCTIONS                                                  *
  **********************************************************************/
 
+// Chains the whole pool into the free list, the first time it's needed
+static void initPool() {
+    uint8_t n;
+    for (n = 0; n < ITEM_POOL_SIZE; n++)
+        pool[n].next = (n + 1 < ITEM_POOL_SIZE)? &pool[n + 1] : NULL;
+    freeItems = &pool[0];
+    freeCount = ITEM_POOL_SIZE;
+    isPoolReady = TRUE;
+}
+
+// Takes an item off the free list, NULL with ERROR_NO_MEMORY if none
+static Item takeItem() {
+    Item i;
+    unsigned int intStatus = INTDisableInterrupts();
+    if (!isPoolReady)
+        initPool();
+    i = freeItems;
+    if (i != NULL) {
+        freeItems = i->next;
+        freeCount--;
+    }
+    INTRestoreInterrupts(intStatus);
+    if (i == NULL)
+        error(ERROR_NO_MEMORY);
+    return i;
+}
+
 
 /***********************************************************************
  * PUBLIC DEFINITIONS                                                  *
@@ -38,21 +80,59 @@
  * Function: Item_create()
  * @param A pointer to an object or some data.
  * @param The sizeof that object or data.
- * @return The new item.
- * @remark none
+ * @return The new item, or NULL with ERROR_NO_MEMORY once all
+ *  ITEM_POOL_SIZE are in use.
+ * @remark Doesn't copy the data, it has to outlive the item.
  **********************************************************************/
 Item Item_create(void* data, size_t size) {
+    Item i = takeItem();
+    if (i == NULL)
+        return NULL;
+
+    Item_init(i, data, size);
+    i->flags = ITEM_POOLED;
+    return(i);
+}
+
+/**********************************************************************
+ * Function: Item_createInline()
+ * @param Data to copy into the item.
+ * @param The size of it, at most ITEM_INLINE_SIZE.
+ * @return The new item, or NULL with ERROR_NO_MEMORY once the pool is
+ *  used up or if the data won't fit.
+ * @remark The data can go away as soon as this returns.
+ **********************************************************************/
+Item Item_createInline(const void* data, size_t size) {
     Item i;
-    i = (Item) malloc(sizeof(ITEM));
-    if (i == NULL) {
+    if (size > ITEM_INLINE_SIZE) {
         error(ERROR_NO_MEMORY);
         return NULL;
     }
+    i = takeItem();
+    if (i == NULL)
+        return NULL;
+
+    memcpy(i->payload, data, size);
+    Item_init(i, i->payload, size);
+    i->flags = ITEM_POOLED | ITEM_INLINE;
+    return(i);
+}
 
+/**********************************************************************
+ * Function: Item_init()
+ * @param An ITEM that doesn't come from the pool, usually a member of
+ *  the struct it carries.
+ * @param A pointer to an object or some data.
+ * @param The sizeof that object or data.
+ * @return The item.
+ * @remark Item_destroy only unlinks it, the owner keeps it.
+ **********************************************************************/
+Item Item_init(Item i, void* data, size_t size) {
     i->next = NULL;
     i->last = NULL;
     i->data = data;
     i->size = size;
+    i->flags = 0;
     return(i);
 }
 
@@ -60,112 +140,35 @@ Item Item_create(void* data, size_t size) {
  * Function: Item_destroy()
  * @param An item to destroy.
  * @return none
- * @remark Destructor for an Item.
+ * @remark Destructor for an Item, gives it back to the pool if it came
+ *  from there.
  **********************************************************************/
 void Item_destroy(Item i) {
+    unsigned int intStatus;
+    // Already given back, its next is the free list now
+    if (i >= pool && i < &pool[ITEM_POOL_SIZE] && !(i->flags & ITEM_POOLED))
+        return;
     Item_clearNext(i);
     Item_clearLast(i);
     i->data = NULL;
     i->size = 0;
-    free(i);
-}
-
-/**********************************************************************
- * Function: Item_getSize()
- * @param A item.
- * @return The size of the item and its data.
- * @remark none
- **********************************************************************/
-size_t Item_getSize (Item i) {
-    size_t size = sizeof(ITEM);
-
-    if (i->size != 0)
-        size += i->size;
-
-    return size;
-}
-
-/**********************************************************************
- * Function: Item_getData()
- * @param An item.
- * @return The item's data field.
- * @remark none
- **********************************************************************/
-void* Item_getData (Item i) {
-    return i->data;
-}
-
-/**********************************************************************
- * Function: Item_getNext()
- * @param An item.
- * @return The item in front of this one.
- * @remark Returns NULL when this item is at the front of the line.
- **********************************************************************/
-Item Item_getNext(Item i) {
-    return (Item) i->next;
-}
-
-/**********************************************************************
- * Function: Item_getLast()
- * @param An item.
- * @return The item behind this one.
- * @remark Returns NULL when this item is the last in line.
- **********************************************************************/
-Item Item_getLast(Item i) {
-    return (Item) i->last;
-}
-
-/**********************************************************************
- * Function: Item_setNext()
- * @param An item.
- * @param An item to put in front of this one.
- * @return none
- * @remark Sets the next item, and sets the next item's last item.
- **********************************************************************/
-void Item_setNext (Item i, Item next) {
-    i->next = (void*)next;
-    next->last = (void*)i;
-}
-
-/**********************************************************************
- * Function: Item_setLast()
- * @param An item.
- * @param An item to add behind this one.
- * @return none
- * @remark Sets the last item, and sets the last item's next item.
- **********************************************************************/
-void Item_setLast (Item i, Item last) {
-    i->last = (void*)last;
-    last->next = (void*)i;
-}
-
-/**********************************************************************
- * Function: Item_clearNext()
- * @param An item.
- * @return none
- * @remark Removes the next item.
- **********************************************************************/
-void Item_clearNext(Item i) {
-    if (i->next == NULL)
+    if (!(i->flags & ITEM_POOLED))
         return;
 
-    Item next = (Item) i->next;
-    i->next = NULL;
-    next->last = NULL;
+    i->flags = 0;
+    intStatus = INTDisableInterrupts();
+    i->next = freeItems;
+    freeItems = i;
+    freeCount++;
+    INTRestoreInterrupts(intStatus);
 }
 
 /**********************************************************************
- * Function: Item_clearLast()
- * @param An item.
- * @return none
- * @remark Removes the last item.
+ * Function: Item_getFreeCount()
+ * @return How many more items can be created.
+ * @remark none
  **********************************************************************/
-void Item_clearLast(Item i) {
-    if (i->last == NULL)
-        return;
-
-    Item last = (Item) i->last;
-    i->last = NULL;
-    last->next = NULL;
+uint8_t Item_getFreeCount() {
+    return isPoolReady? freeCount : ITEM_POOL_SIZE;
 }
 
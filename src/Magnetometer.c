@@ -10,18 +10,42 @@
 #include <math.h>
 #include <plib.h>
 #include "I2C.h"
+#include "Timer.h"
 #include "Serial.h"
 #include "Board.h"
+#include "FastMath.h"
+#include "AngleFilter.h"
+#include "Magnetometer.h"
 
 
 /***********************************************************************
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 // List of registers for Encoder
-#define SLAVE_READ_ADDRESS          0x43
-#define SLAVE_WRITE_ADDRESS         0x42
-#define SLAVE_DEGREE_ADDRESS        0x41
-#define ACCUMULATOR_LENGTH          50
+#define SLAVE_ADDRESS               0x21
+#define SLAVE_DEGREE_ADDRESS        0x41 // 'A', measure the heading
+#define SLAVE_CLOCK_FREQ            100000 // (Hz) it can't do fast mode
+#define MEASURE_TIME                7 // (ms) 'A' takes 6 ms in standby
+
+// Headings averaged into the published one
+#define ACCUMULATOR_LENGTH          4
+
+// Headings are read out in tenths of a degree
+#define TENTHS_PER_TURN             3600
+#define TENTHS_TO_ANGLE16(tenths)   \
+    ((uint16_t)(((uint32_t)(tenths) * ANGLE16_TURN) / TENTHS_PER_TURN))
+
+#define RADIAN_TO_DEGREE            (180.0f / FASTMATH_PI)
+
+/***********************************************************************
+ * PRIVATE TYPEDEFS                                                    *
+ ***********************************************************************/
+
+typedef enum {
+    STATE_IDLE = 0,     // nothing on the bus
+    STATE_MEASURING,    // 'A' sent, waiting out MEASURE_TIME
+    STATE_READING,      // heading read queued
+} MagnetometerState;
 
 /***********************************************************************
  * PRIVATE VARIABLES                                                   *
@@ -31,8 +55,17 @@ I2C_MODULE      MAGNETOMETER_I2C_ID = I2C1;
 // Set Desired Operation Frequency
 #define I2C_CLOCK_FREQ  100000 // (Hz)
 
-uint16_t Degree;
-float finalDegree; // (degrees)
+AngleFilter headingFilter;
+uint16_t headings[ACCUMULATOR_LENGTH];
+MagnetometerHeading published;
+
+MagnetometerState state = STATE_IDLE;
+uint32_t measureTime; // (ms) when the 'A' was sent
+float tilt = 0; // (degrees) from the gravity vector last set
+
+const uint8_t measureCommand = SLAVE_DEGREE_ADDRESS;
+uint8_t readBuffer[2];
+I2CTransfer transfer;
 
 // Printing debug messages over serial
 #define DEBUG
@@ -41,94 +74,120 @@ float finalDegree; // (degrees)
  * PRIVATE PROTOTYPES                                                  *
  ***********************************************************************/
 
-uint16_t Magnetometer_readSensor();
+void startMeasurement();
+void startRead();
+void publishHeading();
 
 /***********************************************************************
  * PUBLIC FUNCTIONS                                                    *
  ***********************************************************************/
 
 void Magnetometer_init() {
+    AngleFilter_initWindow(&headingFilter, headings, ACCUMULATOR_LENGTH);
+    published.heading = 0;
+    published.tilt = 0;
+    published.time = 0;
+    published.isValid = FALSE;
+    state = STATE_IDLE;
     I2C_init(MAGNETOMETER_I2C_ID, I2C_CLOCK_FREQ);
+    I2C_addDevice(MAGNETOMETER_I2C_ID, SLAVE_ADDRESS, SLAVE_CLOCK_FREQ);
 }
 
 float Magnetometer_getDegree(){
-    return finalDegree;
+    return published.heading;
+}
+
+void Magnetometer_getHeading(MagnetometerHeading *heading) {
+    *heading = published;
+}
+
+void Magnetometer_setGravity(int16_t x, int16_t y, int16_t z) {
+    float horizontal = sqrtf((float)x * x + (float)y * y);
+    tilt = FastMath_atan2(horizontal, (float)z) * RADIAN_TO_DEGREE;
 }
 
 void Magnetometer_runSM(){
-     int count;
-     float accumulator = 0;
-     for(count = 0; count < ACCUMULATOR_LENGTH; count++){
-        Degree = Magnetometer_readSensor();
-        if(Degree < 0020)
-            Degree += 3600;
-        accumulator += Degree;
+    switch (state) {
+        case STATE_IDLE:
+            startMeasurement();
+            break;
+        case STATE_MEASURING:
+            if (get_time() - measureTime >= MEASURE_TIME)
+                startRead();
+            break;
+        case STATE_READING:
+            if (!I2C_IS_FINISHED(transfer.status))
+                break;
+            if (transfer.status == I2C_TRANSFER_DONE)
+                publishHeading();
+            #ifdef DEBUG
+            else
+                printf("Data transfer unsuccessful.\n");
+            #endif
+            startMeasurement();
+            break;
     }
-    finalDegree = (float)(accumulator/(ACCUMULATOR_LENGTH*10));
-    if(finalDegree > 360)
-        finalDegree -= 360;
-    if(finalDegree < 0.5 || finalDegree > 359.5)
-        finalDegree = 0;
- }
+}
 
 /******************************************************************************
  * PRIVATE FUNCTIONS                                                          *
  ******************************************************************************/
 
- 
-
-uint16_t Magnetometer_readSensor() {
-    int8_t success = FALSE;
-    uint16_t data = 0;
+/**
+ * Function: startMeasurement
+ * @return None.
+ * @remark Queues the 'A' command, which makes the sensor measure a heading
+ *  it can be read back after MEASURE_TIME.
+ * @date 2026.10.14  */
+void startMeasurement() {
+    transfer.address = SLAVE_ADDRESS;
+    transfer.write = &measureCommand;
+    transfer.writeLength = 1;
+    transfer.read = NULL;
+    transfer.readLength = 0;
+    transfer.callback = NULL;
+    if (I2C_submit(MAGNETOMETER_I2C_ID, &transfer) != SUCCESS)
+        return;
+    measureTime = get_time();
+    state = STATE_MEASURING;
+}
 
-    do {
-        // Send the start bit with the restart flag low
-        if(!I2C_startTransfer(MAGNETOMETER_I2C_ID, I2C_WRITE )){
-            #ifdef DEBUG
-            printf("FAILED initial transfer!\n");
-            #endif
-            break;
-        }
-        // Transmit the slave's address to notify it
-        if (!I2C_sendData(MAGNETOMETER_I2C_ID, SLAVE_WRITE_ADDRESS))
-            break;
+/**
+ * Function: startRead
+ * @return None.
+ * @remark Queues the read of the two heading bytes. The 'A' transfer has
+ *  long finished by now, MEASURE_TIME is far longer than it takes.
+ * @date 2026.10.14  */
+void startRead() {
+    if (!I2C_IS_FINISHED(transfer.status))
+        return;
+    transfer.write = NULL;
+    transfer.writeLength = 0;
+    transfer.read = readBuffer;
+    transfer.readLength = 2;
+    if (I2C_submit(MAGNETOMETER_I2C_ID, &transfer) == SUCCESS)
+        state = STATE_READING;
+    else
+        state = STATE_IDLE;
+}
 
-        // Tranmit the read address module
-        if(!I2C_sendData(MAGNETOMETER_I2C_ID,SLAVE_DEGREE_ADDRESS)){
-            #ifdef DEBUG
-            printf("Error: Sent byte was not acknowledged\n");
-            #endif
-            break;
-        }
-        // Send a Repeated Started condition
-        if(!I2C_startTransfer(MAGNETOMETER_I2C_ID,I2C_READ)){
-            #ifdef DEBUG
-            printf("FAILED Repeated start!\n");
-            #endif
-            break;
-        }
-        // Transmit the address with the READ bit set
-        if (!I2C_sendData(MAGNETOMETER_I2C_ID, SLAVE_READ_ADDRESS))
-            break;
-        
-        // Read the I2C bus twice
-        data = (I2C_getData(MAGNETOMETER_I2C_ID) << 8);
-        I2C_acknowledgeRead(MAGNETOMETER_I2C_ID, TRUE);
-        while(!I2C_hasAcknowledged(MAGNETOMETER_I2C_ID));
-        data += (I2C_getData(MAGNETOMETER_I2C_ID));
-
-        // Send the stop bit to finish the transfer
-        I2C_stopTransfer(MAGNETOMETER_I2C_ID);
-
-        success = TRUE;
-    } while(0);
-    if (!success) {
-        #ifdef DEBUG
-        printf("Data transfer unsuccessful.\n");
-        #endif
-        return FALSE;
-    }
-    return data;
+/**
+ * Function: publishHeading
+ * @return None.
+ * @remark Adds the heading just read to the filter unless the sensor was
+ *  tilted past MAGNETOMETER_TILT_MAX, and publishes the mean.
+ * @date 2026.10.14  */
+void publishHeading() {
+    uint16_t tenths = ((uint16_t)readBuffer[0] << 8) | readBuffer[1];
+    published.tilt = tilt;
+    if (tilt > MAGNETOMETER_TILT_MAX || tenths >= TENTHS_PER_TURN)
+        return;
+
+    AngleFilter_add(&headingFilter, TENTHS_TO_ANGLE16(tenths));
+    published.heading = ANGLE16_TO_DEGREES(AngleFilter_getMean(&headingFilter));
+    // The heading is from when the 'A' was sent, not when it was read
+    published.time = measureTime;
+    published.isValid = TRUE;
 }
 
 //#define MAGNETOMETER_TEST
@@ -136,13 +195,20 @@ uint16_t Magnetometer_readSensor() {
 
 int main(void) {
 // Initialize the UART,Timers, and I2C1v
+    MagnetometerHeading heading;
+    uint32_t lastTime = 0;
     Board_init();
     Serial_init();
+    Timer_init();
     Magnetometer_init();
     while(1){
         Magnetometer_runSM();
-        while(!Serial_isTransmitEmpty());
-        printf("Angle: %.1f\n", Magnetometer_getDegree());
+        Magnetometer_getHeading(&heading);
+        if (heading.isValid && heading.time != lastTime) {
+            lastTime = heading.time;
+            printf("Angle: %.1f, tilt %.1f at %lu ms\n", heading.heading,
+                heading.tilt, (unsigned long)heading.time);
+        }
     }
 
     return (SUCCESS);
@@ -1,102 +1,380 @@
 #include <xc.h>
+#include <stdio.h>
+#include <string.h>
 #include "Mavlink.h"
 #include "Uart.h"
 #include "Board.h"
+#include "Timer.h"
 #include "Xbee.h"
+#include "Error.h"
 #include "Compas.h"
+#ifdef USE_GPS
+#include "Gps.h"
+#endif
+#ifdef USE_GUIDANCE
+#include "Guidance.h"
+#endif
 
-static int packet_drops = 0;
 static mavlink_message_t msg;
 static mavlink_status_t status;
+static MavlinkLinkStats linkStats;
 
-#define MAV_NUMBER 15 // defines the MAV number, arbitrary
 #define COMP_ID 15
+#define RECEIVE_CHUNK 32 // bytes pulled out of the UART per read
+#define MAVLINK_HANDLERS_MAX 12
+#define ACK_FRAME_MAX (MAVLINK_NUM_NON_PAYLOAD_BYTES + ACK_PAYLOAD_MAX)
 
-void Mavlink_recieve(uint8_t uart_id){
-    while(UART_isReceiveEmpty(uart_id) == FALSE){
-        uint8_t c = UART_getChar(uart_id);
-        //if a message can be deciphered
-        if(mavlink_parse_char(MAVLINK_COMM_0, c, &msg, &status)) {
-            switch(msg.msgid){
-                case MAVLINK_MSG_ID_XBEE_HEARTBEAT:
-                {
-                    mavlink_xbee_heartbeat_t data;
-                    mavlink_msg_xbee_heartbeat_decode(&msg, &data);
-                    //call outside function to handle data
-                    Xbee_recieved_message_heartbeat(&data);
-                }break;
-#ifdef XBEE_TEST
-                case MAVLINK_MSG_ID_TEST_DATA:
-                {
-                    mavlink_test_data_t data;
-                    mavlink_msg_test_data_decode(&msg, &data);
-                    //call outside function to handle data
-                    Xbee_message_data_test(&data);
-                }break;
+/* A message waiting for its ACK, free while length is 0. The frame is
+ * kept as it went out, so a resend has the same sequence number and any
+ * of the copies can be acknowledged. */
+typedef struct{
+    uint8_t frame[ACK_FRAME_MAX];
+    uint8_t length;
+    uint8_t uart_id;
+    uint8_t target; // system id the ACK has to come from
+    uint8_t messageName;
+    uint8_t seq;
+    uint8_t retries;
+    uint16_t timeout; // (ms) this try, doubles each resend
+    uint32_t sentTime;
+    ACK_callback callback;
+}AckEntry;
+
+static AckEntry ackTable[ACK_TABLE_SIZE];
+
+/* Handlers by message id, see Mavlink_register. A handful of ids, so a
+ * scan is quicker than it would be to keep a table of all 256. */
+static struct{
+    uint8_t msgid;
+    Mavlink_handler handler; // NULL if the entry is free
+}handlers[MAVLINK_HANDLERS_MAX];
+
+/* The systems on the other end, each with its own sequence numbers and
+ * round trip. A frame to a system that isn't kept, with the table full
+ * of connected ones, goes out numbered from broadcastSeq. */
+static MavlinkPeer peers[MAVLINK_PEERS_MAX];
+static uint8_t broadcastSeq = 0;
+static uint8_t systemId = MAVLINK_SYSTEM_ID;
+
+/* The CRC covers the sequence number, so a frame renumbered for a peer
+ * needs its CRC again, and that includes the message's extra byte. */
+static const uint8_t crcExtras[256] = MAVLINK_MESSAGE_CRCS;
+
+static void finishACK(AckEntry *entry, uint8_t ACK_status);
+static uint8_t writeFrame(uint8_t uart_id, uint16_t address, const uint8_t *frame, uint16_t length);
+static MavlinkPeer *findPeer(uint8_t sysid);
+static MavlinkPeer *addPeer(uint8_t sysid);
+static uint8_t isConnected(const MavlinkPeer *peer, uint32_t now);
+static uint16_t peerAddress(uint8_t sysid);
+static uint8_t nextSeq(MavlinkPeer *peer, uint16_t length);
+static void stampFrame(uint8_t *frame, uint8_t seq);
+static void notePeer(uint16_t address, const mavlink_message_t *msg);
+static void dispatch(uint8_t uart_id, uint16_t address, const mavlink_message_t *msg);
+static void handleACK(uint8_t uart_id, const mavlink_message_t *msg);
+static void handleStartRescue(uint8_t uart_id, const mavlink_message_t *msg);
+static void handleStartRescueInt(uint8_t uart_id, const mavlink_message_t *msg);
+#ifdef USE_GUIDANCE
+static void handleStopRescue(uint8_t uart_id, const mavlink_message_t *msg);
 #endif
-                case MAVLINK_MSG_ID_START_RESCUE:
-                {
-                    mavlink_start_rescue_t data;
-                    mavlink_msg_start_rescue_decode(&msg, &data);
-                    if(data.ack == TRUE){
-                        Mavlink_send_ACK(XBEE_UART_ID, messageName_start_rescue);
-                    }
-                    Compas_recieve_start_rescue(&data);
-                }break;
-                case MAVLINK_MSG_ID_MAVLINK_ACK:
-                {
-                    mavlink_mavlink_ack_t data;
-                    mavlink_msg_mavlink_ack_decode(&msg, &data);
-                    Mavlink_recieve_ACK(&data);
-                }break;
-            }
+#ifdef USE_GPS
+static void handleGpsError(uint8_t uart_id, const mavlink_message_t *msg);
+#endif
+
+/* Takes at most the byte and time budget a call, so a burst can't hold
+ * up the rest of the loop, what's left waits in the UART for next time.
+ * The time is only checked between chunks, a chunk is quick. */
+uint8_t Mavlink_recieve(uint8_t uart_id){
+    uint8_t chunk[RECEIVE_CHUNK];
+    uint16_t length, taken = 0;
+    uint32_t start = Timer_getMicros();
+    while(taken < MAVLINK_RECEIVE_BYTES
+            && (Timer_getMicros() - start) < MAVLINK_RECEIVE_MICROS){
+        length = MAVLINK_RECEIVE_BYTES - taken;
+        length = UART_read(uart_id, chunk,
+            (length < RECEIVE_CHUNK)? length : RECEIVE_CHUNK);
+        if(length == 0)
+            return FALSE;
+        taken += length;
+        Mavlink_recieve_bytes(uart_id, MAVLINK_ADDRESS_UNKNOWN, chunk, length);
+    }
+    linkStats.budgetHits++;
+    return TRUE;
+}
+
+void Mavlink_recieve_bytes(uint8_t uart_id, uint16_t address, const uint8_t *data,
+        uint16_t length){
+    uint16_t i;
+    for(i = 0; i < length; i++){
+        //if a message can be deciphered
+        uint8_t isMessage = mavlink_parse_char(MAVLINK_COMM_0, data[i], &msg, &status);
+        // The drops are parse errors since the last character
+        linkStats.drops += status.packet_rx_drop_count;
+        if(isMessage)
+            dispatch(uart_id, address, &msg);
+    }
+}
+
+uint8_t Mavlink_register(uint8_t msgid, Mavlink_handler handler){
+    uint8_t i, free = MAVLINK_HANDLERS_MAX;
+    for(i = 0; i < MAVLINK_HANDLERS_MAX; i++){
+        if(handlers[i].handler != NULL && handlers[i].msgid == msgid){
+            handlers[i].handler = handler;
+            return SUCCESS;
         }
+        if(handlers[i].handler == NULL && free == MAVLINK_HANDLERS_MAX)
+            free = i;
     }
-    packet_drops += status.packet_rx_drop_count;
+    if(handler == NULL)
+        return SUCCESS;
+    if(free == MAVLINK_HANDLERS_MAX)
+        return FAILURE;
+    handlers[free].msgid = msgid;
+    handlers[free].handler = handler;
+    return SUCCESS;
+}
+
+void Mavlink_init(void){
+    memset(peers, 0, sizeof(peers));
+    Mavlink_register(MAVLINK_MSG_ID_MAVLINK_ACK, handleACK);
+    Mavlink_register(MAVLINK_MSG_ID_START_RESCUE, handleStartRescue);
+    Mavlink_register(MAVLINK_MSG_ID_START_RESCUE_INT, handleStartRescueInt);
+#ifdef USE_GUIDANCE
+    Mavlink_register(MAVLINK_MSG_ID_STOP_RESCUE, handleStopRescue);
+#endif
+#ifdef USE_GPS
+    Mavlink_register(MAVLINK_MSG_ID_GPS_ERROR, handleGpsError);
+#endif
+}
+
+void Mavlink_get_link_stats(MavlinkLinkStats *stats){
+    *stats = linkStats;
+    stats->received = status.packet_rx_success_count;
+}
+
+void Mavlink_set_system_id(uint8_t sysid){
+    if(sysid != MAVLINK_SYSTEM_BROADCAST)
+        systemId = sysid;
+}
+
+uint8_t Mavlink_get_system_id(void){
+    return systemId;
+}
+
+/* A boat answers to the base, the base to the whole fleet */
+uint8_t Mavlink_get_default_target(void){
+    return (systemId == MAVLINK_SYSTEM_BASE)? MAVLINK_SYSTEM_BROADCAST
+        : MAVLINK_SYSTEM_BASE;
+}
+
+uint8_t Mavlink_get_peer(uint8_t index, MavlinkPeer *peer){
+    if(index >= MAVLINK_PEERS_MAX || peers[index].sysid == 0)
+        return FAILURE;
+    *peer = peers[index];
+    return SUCCESS;
+}
+
+uint8_t Mavlink_find_peer(uint8_t sysid){
+    MavlinkPeer *peer = findPeer(sysid);
+    return (peer == NULL)? MAVLINK_NO_PEER : (uint8_t)(peer - peers);
+}
+
+uint8_t Mavlink_is_peer_connected(uint8_t index){
+    return index < MAVLINK_PEERS_MAX && isConnected(&peers[index], get_time());
 }
+
 /*************************************************************************
  * SEND FUNCTIONS                                                        *
  *************************************************************************/
 
-void Mavlink_send_ACK(uint8_t uart_id, uint8_t Message_Name){
-    mavlink_message_t msg;
-    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
-    mavlink_msg_mavlink_ack_pack(MAV_NUMBER, COMP_ID, &msg, Message_Name);
-    uint16_t length = mavlink_msg_to_send_buffer(buf, &msg);
-    UART_putString(uart_id, buf, length);
+void Mavlink_send_frame(uint8_t uart_id, const mavlink_message_t *msg){
+    Mavlink_send_frame_to(uart_id, Mavlink_get_default_target(), msg);
 }
-void Mavlink_send_xbee_heartbeat(uint8_t uart_id, uint8_t data){
-    mavlink_message_t msg;
+
+/* Serializes a packed message straight into the UART transmit buffer when
+ * there is a contiguous region for it, otherwise through a stack buffer.
+ * Frames that don't fit at all are dropped whole rather than cut short.
+ * A wire only has one system on the other end, so a UART gets one copy
+ * whatever the target. The XBee gets each frame as one packet of its own,
+ * to the target's address, and a copy for each connected peer for a
+ * broadcast so each one can count what it lost. */
+void Mavlink_send_frame_to(uint8_t uart_id, uint8_t target, const mavlink_message_t *msg){
+    uint16_t length = MAVLINK_NUM_NON_PAYLOAD_BYTES + msg->len;
     uint8_t buf[MAVLINK_MAX_PACKET_LEN];
-    mavlink_msg_xbee_heartbeat_pack(MAV_NUMBER, COMP_ID, &msg, TRUE, data);
-    uint16_t length = mavlink_msg_to_send_buffer(buf, &msg);
-    UART_putString(uart_id, buf, length);
+    uint8_t *frame;
+    MavlinkPeer *peer = NULL;
+    uint32_t now = get_time();
+    uint8_t i, sent = 0;
+    if(target != MAVLINK_SYSTEM_BROADCAST)
+        peer = addPeer(target);
+    if(uart_id == XBEE_UART_ID){
+        mavlink_msg_to_send_buffer(buf, msg);
+        if(target != MAVLINK_SYSTEM_BROADCAST){
+            stampFrame(buf, nextSeq(peer, length));
+            Xbee_sendTo(peerAddress(target), buf, length);
+            return;
+        }
+        for(i = 0; i < MAVLINK_PEERS_MAX; i++){
+            if(!isConnected(&peers[i], now))
+                continue;
+            stampFrame(buf, nextSeq(&peers[i], length));
+            Xbee_sendTo(peers[i].address, buf, length);
+            sent++;
+        }
+        // Nobody to count it for, whoever hears it
+        if(sent == 0){
+            stampFrame(buf, nextSeq(NULL, length));
+            Xbee_sendTo(MAVLINK_ADDRESS_BROADCAST, buf, length);
+        }
+        return;
+    }
+    if(UART_getTransmitSpace(uart_id) < length)
+        return;
+    if(UART_reserve(uart_id, &frame, length) == length){
+        mavlink_msg_to_send_buffer(frame, msg);
+        stampFrame(frame, nextSeq(peer, length));
+        UART_commit(uart_id, length);
+    }else{
+        mavlink_msg_to_send_buffer(buf, msg);
+        stampFrame(buf, nextSeq(peer, length));
+        UART_write(uart_id, buf, length);
+    }
 }
 
-void Mavlink_send_start_rescue(uint8_t uart_id, uint8_t ack, uint8_t status, float latitude, float longitude){
+void Mavlink_send_ACK(uint8_t uart_id, uint8_t target, uint8_t Message_Name, uint8_t seq){
     mavlink_message_t msg;
-    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
-    mavlink_msg_start_rescue_pack(MAV_NUMBER, COMP_ID, &msg, ack, status, latitude, longitude);
-    uint16_t length = mavlink_msg_to_send_buffer(buf, &msg);
-    UART_putString(uart_id, buf, length);
-    if(ack == TRUE){
-        start_rescue.ACK_status = ACK_STATUS_WAIT;
-        int x;
-        for(x = 0; x <=MAVLINK_MAX_PACKET_LEN;x++){
-            start_rescue.last_buf[x] = buf[x];
+    mavlink_msg_mavlink_ack_pack(systemId, COMP_ID, &msg, Message_Name, seq);
+    Mavlink_send_frame_to(uart_id, target, &msg);
+}
+
+uint8_t Mavlink_send_acknowledged(uint8_t uart_id, uint8_t target, const mavlink_message_t *msg,
+        uint8_t Message_Name, ACK_callback callback){
+    AckEntry *entry = NULL;
+    MavlinkPeer *peer;
+    uint8_t i;
+    if(msg->len > ACK_PAYLOAD_MAX || target == MAVLINK_SYSTEM_BROADCAST)
+        return FAILURE;
+    peer = addPeer(target);
+    if(peer == NULL)
+        return FAILURE;
+    for(i = 0; i < ACK_TABLE_SIZE; i++){
+        if(ackTable[i].length != 0 && ackTable[i].messageName == Message_Name
+                && ackTable[i].target == target){
+            entry = &ackTable[i];
+            break;
         }
-        start_rescue.last_length = length;
-        start_rescue.last_uart_id = uart_id;
+        if(ackTable[i].length == 0 && entry == NULL)
+            entry = &ackTable[i];
+    }
+    if(entry == NULL)
+        return FAILURE;
+
+    entry->length = (uint8_t)mavlink_msg_to_send_buffer(entry->frame, msg);
+    stampFrame(entry->frame, nextSeq(peer, entry->length));
+    entry->uart_id = uart_id;
+    entry->target = target;
+    entry->messageName = Message_Name;
+    entry->seq = entry->frame[2];
+    entry->retries = 0;
+    entry->timeout = peer->ackTimeout;
+    entry->sentTime = get_time();
+    entry->callback = callback;
+    // Lost to a full UART is the same as lost on the air, it gets resent
+    writeFrame(uart_id, peer->address, entry->frame, entry->length);
+    return SUCCESS;
+}
+void Mavlink_send_xbee_heartbeat(uint8_t uart_id, uint8_t target, uint16_t seq, uint32_t time,
+        uint32_t echo_time, uint16_t echo_delay, uint8_t loss){
+    mavlink_message_t msg;
+    mavlink_msg_xbee_heartbeat_pack(systemId, COMP_ID, &msg, FALSE, seq, time,
+        echo_time, echo_delay, loss);
+    Mavlink_send_frame_to(uart_id, target, &msg);
+}
+
+void Mavlink_send_start_rescue(uint8_t uart_id, uint8_t target, uint8_t ack, uint8_t status, float latitude, float longitude, ACK_callback callback){
+    mavlink_message_t msg;
+    mavlink_msg_start_rescue_pack(systemId, COMP_ID, &msg, ack, status, latitude, longitude);
+    if(ack == TRUE)
+        Mavlink_send_acknowledged(uart_id, target, &msg, messageName_start_rescue, callback);
+    else
+        Mavlink_send_frame_to(uart_id, target, &msg);
+}
+
+/* Same message name as the float one, so either replaces the other in the
+ * retransmit table */
+void Mavlink_send_start_rescue_int(uint8_t uart_id, uint8_t target, uint8_t ack, uint8_t status, int32_t latitude, int32_t longitude, ACK_callback callback){
+    mavlink_message_t msg;
+    mavlink_msg_start_rescue_int_pack(systemId, COMP_ID, &msg, ack, status, latitude, longitude);
+    if(ack == TRUE)
+        Mavlink_send_acknowledged(uart_id, target, &msg, messageName_start_rescue, callback);
+    else
+        Mavlink_send_frame_to(uart_id, target, &msg);
+}
+
+void Mavlink_send_gps_error(uint8_t uart_id, uint8_t ack, uint32_t time, int32_t latitude, int32_t longitude){
+    mavlink_message_t msg;
+    mavlink_msg_gps_error_pack(systemId, COMP_ID, &msg, ack, time, latitude, longitude);
+    Mavlink_send_frame(uart_id, &msg);
+}
+
+void Mavlink_send_uart_status(uint8_t uart_id, uint8_t port_id){
+    mavlink_message_t msg;
+    UartStats stats;
+    if(UART_getStats(port_id, &stats) != SUCCESS)
+        return;
+    mavlink_msg_uart_status_pack(systemId, COMP_ID, &msg, port_id,
+        stats.bytesIn, stats.bytesOut, stats.rxDropped, stats.txDropped,
+        stats.rxOverruns, stats.rxPeak, stats.txPeak, stats.isrMaxTicks);
+    Mavlink_send_frame(uart_id, &msg);
+}
+
+void Mavlink_send_boat_position(uint8_t uart_id, uint32_t time, int32_t latitude, int32_t longitude,
+        int16_t velocity_north, int16_t velocity_east, uint16_t heading, uint16_t accuracy, uint8_t guidance){
+    mavlink_message_t msg;
+    mavlink_msg_boat_position_pack(systemId, COMP_ID, &msg, time, latitude, longitude,
+        velocity_north, velocity_east, heading, accuracy, guidance);
+    Mavlink_send_frame(uart_id, &msg);
+}
+
+void Mavlink_send_battery(uint8_t uart_id, uint32_t time, uint16_t voltage){
+    mavlink_message_t msg;
+    mavlink_msg_battery_pack(systemId, COMP_ID, &msg, time, voltage);
+    Mavlink_send_frame(uart_id, &msg);
+}
+
+void Mavlink_send_thermal_target(uint8_t uart_id, uint32_t time, uint16_t heading, int16_t elevation,
+        int16_t peak, uint8_t pixels){
+    mavlink_message_t msg;
+    mavlink_msg_thermal_target_pack(systemId, COMP_ID, &msg, time, heading, elevation, peak, pixels);
+    Mavlink_send_frame(uart_id, &msg);
+}
+
+void Mavlink_send_xbee_status(uint8_t uart_id, uint16_t telemetry_rate, uint32_t telemetry_decimated){
+    mavlink_message_t msg;
+    XbeeStats stats;
+    Xbee_getStats(&stats);
+    mavlink_msg_xbee_status_pack(systemId, COMP_ID, &msg, stats.rssi, stats.txAcked,
+        stats.txFailed, stats.rxPackets, stats.rxErrors, telemetry_rate, telemetry_decimated);
+    Mavlink_send_frame(uart_id, &msg);
+}
+
+uint8_t Mavlink_send_error_events(uint8_t uart_id, uint8_t max){
+    mavlink_message_t msg;
+    ErrorEvent event;
+    uint8_t sent = 0;
+    while(sent < max && Error_read(&event)){
+        mavlink_msg_error_event_pack(systemId, COMP_ID, &msg, event.time,
+            event.module, event.code, event.arg, Error_getDropped());
+        Mavlink_send_frame(uart_id, &msg);
+        sent++;
     }
+    return sent;
 }
 
 #ifdef XBEE_TEST
 void Mavlink_send_Test_data(uint8_t uart_id, uint8_t data){
     mavlink_message_t msg;
-    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
-    mavlink_msg_test_data_pack(MAV_NUMBER, COMP_ID, &msg, data);
-    uint16_t length = mavlink_msg_to_send_buffer(buf, &msg);
-    UART_putString(uart_id, buf, length);
+    mavlink_msg_test_data_pack(systemId, COMP_ID, &msg, data);
+    Mavlink_send_frame(uart_id, &msg);
 }
 #endif
 
@@ -105,24 +383,285 @@ void Mavlink_send_Test_data(uint8_t uart_id, uint8_t data){
  * RECIEVE FUNCTIONS                                                     *
  *************************************************************************/
 
-void Mavlink_recieve_ACK(mavlink_mavlink_ack_t* packet){
-    switch(packet->Message_Name){
-        case messageName_start_rescue:
-        {
-            start_rescue.ACK_status = ACK_STATUS_RECIEVED;
-        }break;
+void Mavlink_recieve_ACK(uint8_t sysid, mavlink_mavlink_ack_t* packet){
+    uint8_t i;
+    for(i = 0; i < ACK_TABLE_SIZE; i++){
+        AckEntry *entry = &ackTable[i];
+        if(entry->length == 0 || entry->messageName != packet->Message_Name
+                || entry->seq != packet->seq || entry->target != sysid)
+            continue;
+        // Can't tell which copy a resent message's ACK is for (Karn)
+        if(entry->retries == 0)
+            Mavlink_add_RTT_sample(sysid, get_time() - entry->sentTime);
+        finishACK(entry, ACK_STATUS_RECIEVED);
     }
 }
 
+#ifdef USE_GPS
+void Mavlink_recieve_gps_error(mavlink_gps_error_t* packet){
+    GpsCorrection correction;
+    correction.iTOW = packet->time;
+    correction.latitude = packet->latitude;
+    correction.longitude = packet->longitude;
+    GPS_addCorrection(&correction);
+}
+#endif
+
 void Compas_recieve_start_rescue(mavlink_start_rescue_t* packet){
-    printf("Lat: %d Long: %d\n",packet->latitude,packet->longitude);
+    printf("Lat: %.6f Long: %.6f\n",packet->latitude,packet->longitude);
+#ifdef USE_GUIDANCE
+    GpsCoordinate target;
+    target.latitude = (int32_t)(packet->latitude * GPS_COORDINATE_SCALE);
+    target.longitude = (int32_t)(packet->longitude * GPS_COORDINATE_SCALE);
+    target.altitude = 0;
+    if (packet->status == RESCUE_STATUS_TRACKING)
+        Guidance_moveTarget(&target);
+    else
+        Guidance_setTarget(&target);
+#endif
+}
+
+void Compas_recieve_start_rescue_int(mavlink_start_rescue_int_t* packet){
+    printf("Lat: %ld Long: %ld (1e-7 degrees)\n", (long)packet->latitude,
+        (long)packet->longitude);
+#ifdef USE_GUIDANCE
+    GpsCoordinate target;
+    target.latitude = packet->latitude;
+    target.longitude = packet->longitude;
+    target.altitude = 0;
+    if (packet->status == RESCUE_STATUS_TRACKING)
+        Guidance_moveTarget(&target);
+    else
+        Guidance_setTarget(&target);
+#endif
 }
 
 /*************************************************************************
  * PUBLIC FUNCTIONS                                                      *
  *************************************************************************/
 
-void Mavlink_resend_message(ACK *message){
-    UART_putString(message->last_uart_id, message->last_buf, message->last_length);
-    message->ACK_status = ACK_STATUS_WAIT;
-}
\ No newline at end of file
+void Mavlink_check_ACKs(void){
+    uint32_t now = get_time();
+    uint8_t i;
+    for(i = 0; i < ACK_TABLE_SIZE; i++){
+        AckEntry *entry = &ackTable[i];
+        if(entry->length == 0 || (now - entry->sentTime) < entry->timeout)
+            continue;
+        if(entry->retries >= ACK_RETRIES_MAX){
+            finishACK(entry, ACK_STATUS_DEAD);
+            continue;
+        }
+        // Try again next time rather than count a resend that never left
+        if(writeFrame(entry->uart_id, peerAddress(entry->target), entry->frame,
+                entry->length) != SUCCESS)
+            continue;
+        entry->retries++;
+        entry->sentTime = now;
+        entry->timeout = (entry->timeout >= ACK_TIMEOUT_MAX / 2)?
+            ACK_TIMEOUT_MAX : entry->timeout * 2;
+    }
+}
+
+uint16_t Mavlink_get_ACK_timeout(uint8_t sysid){
+    MavlinkPeer *peer = findPeer(sysid);
+    return (peer == NULL)? ACK_TIMEOUT_START : peer->ackTimeout;
+}
+
+/* Timeout is the smoothed round trip plus four deviations, RFC 6298. */
+void Mavlink_add_RTT_sample(uint8_t sysid, uint32_t rtt){
+    MavlinkPeer *peer = findPeer(sysid);
+    int32_t error, timeout;
+    if(peer == NULL)
+        return;
+    if(rtt > ACK_TIMEOUT_MAX)
+        rtt = ACK_TIMEOUT_MAX;
+    if(peer->smoothedRTT == 0){
+        peer->smoothedRTT = rtt;
+        peer->deviationRTT = rtt / 2;
+    }else{
+        error = (int32_t)rtt - peer->smoothedRTT;
+        peer->smoothedRTT += error / 8;
+        if(error < 0)
+            error = -error;
+        peer->deviationRTT += (error - peer->deviationRTT) / 4;
+    }
+    timeout = peer->smoothedRTT + 4 * peer->deviationRTT;
+    if(timeout < ACK_TIMEOUT_MIN)
+        timeout = ACK_TIMEOUT_MIN;
+    if(timeout > ACK_TIMEOUT_MAX)
+        timeout = ACK_TIMEOUT_MAX;
+    peer->ackTimeout = (uint16_t)timeout;
+}
+
+/*************************************************************************
+ * PRIVATE FUNCTIONS                                                     *
+ *************************************************************************/
+
+static void finishACK(AckEntry *entry, uint8_t ACK_status){
+    ACK_callback callback = entry->callback;
+    entry->length = 0;
+    if(ACK_status == ACK_STATUS_DEAD)
+        Error_log(ERROR_MODULE_MAVLINK, ERROR_ACK_DEAD, entry->messageName);
+    if(callback != NULL)
+        callback(entry->messageName, ACK_status);
+}
+
+/* All of a serialized frame or none of it */
+static uint8_t writeFrame(uint8_t uart_id, uint16_t address, const uint8_t *frame, uint16_t length){
+    if(uart_id == XBEE_UART_ID)
+        return Xbee_sendTo(address, frame, length);
+    if(UART_getTransmitSpace(uart_id) < length)
+        return FAILURE;
+    UART_write(uart_id, frame, length);
+    return SUCCESS;
+}
+
+static MavlinkPeer *findPeer(uint8_t sysid){
+    uint8_t i;
+    if(sysid == MAVLINK_SYSTEM_BROADCAST)
+        return NULL;
+    for(i = 0; i < MAVLINK_PEERS_MAX; i++){
+        if(peers[i].sysid == sysid)
+            return &peers[i];
+    }
+    return NULL;
+}
+
+/* Takes a free entry, or the one heard from longest ago that's no longer
+ * connected. NULL if every entry is connected. */
+static MavlinkPeer *addPeer(uint8_t sysid){
+    MavlinkPeer *peer = findPeer(sysid), *oldest = NULL;
+    uint32_t now = get_time();
+    uint8_t i;
+    if(peer != NULL || sysid == MAVLINK_SYSTEM_BROADCAST || sysid == systemId)
+        return peer;
+    for(i = 0; i < MAVLINK_PEERS_MAX; i++){
+        if(peers[i].sysid == 0){
+            oldest = &peers[i];
+            break;
+        }
+        if(!isConnected(&peers[i], now) && (oldest == NULL
+                || (now - peers[i].heardTime) > (now - oldest->heardTime)))
+            oldest = &peers[i];
+    }
+    if(oldest == NULL)
+        return NULL;
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->sysid = sysid;
+    oldest->address = MAVLINK_ADDRESS(sysid);
+    oldest->ackTimeout = ACK_TIMEOUT_START;
+    return oldest;
+}
+
+static uint8_t isConnected(const MavlinkPeer *peer, uint32_t now){
+    return peer->sysid != 0 && peer->received != 0
+        && (now - peer->heardTime) < MAVLINK_PEER_TIMEOUT;
+}
+
+/* A board on our own id can only be reached by a broadcast */
+static uint16_t peerAddress(uint8_t sysid){
+    MavlinkPeer *peer = findPeer(sysid);
+    if(sysid == MAVLINK_SYSTEM_BROADCAST || sysid == systemId)
+        return MAVLINK_ADDRESS_BROADCAST;
+    return (peer == NULL)? MAVLINK_ADDRESS(sysid) : peer->address;
+}
+
+/* Counted as sent when it's numbered, a frame the radio couldn't take is
+ * lost on the air as far as the peer can tell */
+static uint8_t nextSeq(MavlinkPeer *peer, uint16_t length){
+    if(peer == NULL)
+        return broadcastSeq++;
+    peer->sent++;
+    peer->bytesSent += length;
+    return peer->txSeq++;
+}
+
+static void stampFrame(uint8_t *frame, uint8_t seq){
+    uint8_t length = frame[1];
+    uint16_t checksum;
+    frame[2] = seq;
+    checksum = crc_calculate(&frame[1], MAVLINK_CORE_HEADER_LEN + length);
+    crc_accumulate(crcExtras[frame[5]], &checksum);
+    frame[MAVLINK_NUM_HEADER_BYTES + length] = (uint8_t)(checksum & 0xFF);
+    frame[MAVLINK_NUM_HEADER_BYTES + length + 1] = (uint8_t)(checksum >> 8);
+}
+
+/* A gap in the sequence is what was lost, one going back is a resend or
+ * a peer that started over, and neither counts. */
+static void notePeer(uint16_t address, const mavlink_message_t *msg){
+    MavlinkPeer *peer = addPeer(msg->sysid);
+    uint8_t gap;
+    if(peer == NULL)
+        return;
+    if(peer->received != 0){
+        gap = (uint8_t)(msg->seq - peer->rxSeq - 1);
+        if(gap < 128)
+            peer->lost += gap;
+    }
+    peer->rxSeq = msg->seq;
+    peer->received++;
+    peer->heardTime = get_time();
+    if(address != MAVLINK_ADDRESS_UNKNOWN)
+        peer->address = address;
+}
+
+/* A frame with our own system id is from a board still on the old fixed
+ * id, it's handled but not kept as a peer. */
+static void dispatch(uint8_t uart_id, uint16_t address, const mavlink_message_t *msg){
+    uint8_t i;
+    notePeer(address, msg);
+    for(i = 0; i < MAVLINK_HANDLERS_MAX; i++){
+        if(handlers[i].handler != NULL && handlers[i].msgid == msg->msgid){
+            handlers[i].handler(uart_id, msg);
+            return;
+        }
+    }
+    linkStats.unhandled++;
+}
+
+static void handleACK(uint8_t uart_id, const mavlink_message_t *msg){
+    mavlink_mavlink_ack_t data;
+    mavlink_msg_mavlink_ack_decode(msg, &data);
+    Mavlink_recieve_ACK(msg->sysid, &data);
+}
+
+/* ACKs go back the way the message came, to the system that sent it */
+static void handleStartRescue(uint8_t uart_id, const mavlink_message_t *msg){
+    mavlink_start_rescue_t data;
+    mavlink_msg_start_rescue_decode(msg, &data);
+    if(data.ack == TRUE){
+        Mavlink_send_ACK(uart_id, msg->sysid, messageName_start_rescue, msg->seq);
+    }
+    Compas_recieve_start_rescue(&data);
+}
+
+static void handleStartRescueInt(uint8_t uart_id, const mavlink_message_t *msg){
+    mavlink_start_rescue_int_t data;
+    mavlink_msg_start_rescue_int_decode(msg, &data);
+    if(data.ack == TRUE){
+        Mavlink_send_ACK(uart_id, msg->sysid, messageName_start_rescue, msg->seq);
+    }
+    Compas_recieve_start_rescue_int(&data);
+}
+
+#ifdef USE_GUIDANCE
+static void handleStopRescue(uint8_t uart_id, const mavlink_message_t *msg){
+    mavlink_stop_rescue_t data;
+    mavlink_msg_stop_rescue_decode(msg, &data);
+    if(data.ack == TRUE){
+        Mavlink_send_ACK(uart_id, msg->sysid, messageName_stop_rescue, msg->seq);
+    }
+    Guidance_stop();
+}
+#endif
+
+#ifdef USE_GPS
+static void handleGpsError(uint8_t uart_id, const mavlink_message_t *msg){
+    mavlink_gps_error_t data;
+    mavlink_msg_gps_error_decode(msg, &data);
+    if(data.ack == TRUE){
+        Mavlink_send_ACK(uart_id, msg->sysid, messageName_GPS_error, msg->seq);
+    }
+    Mavlink_recieve_gps_error(&data);
+}
+#endif
\ No newline at end of file
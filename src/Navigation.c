@@ -9,11 +9,19 @@
 #include <plib.h>
 //#define __XC32
 #include <math.h>
+#include <stdlib.h>
 #include "Serial.h"
 #include "Timer.h"
 #include "Board.h"
-#include "GPS.h"
+#include "Gps.h"
+#include "FastMath.h"
+#include "RingBuffer.h"
 #include "Navigation.h"
+#include "Nvm.h"
+#ifdef USE_SENSOR_FUSION
+#include "Accelerometer.h"
+#include "Magnetometer.h"
+#endif
 
 
 /***********************************************************************
@@ -32,12 +40,79 @@
 #define R_EN    6378137.0f     // (m) prime vertical radius (semi-major axis)
 #define R_EM    (R_EN * (1 - FLATR)) // meridian radius (semi-minor axis)
 
+// How far the reference can move before its ENU frame is recomputed
+#define FRAME_DEGREE_THRESHOLD  0.00001f // (degrees) about 1 m
+#define FRAME_ALTITUDE_THRESHOLD 1.0f // (m)
+
+// GPS state kept across boots, see keepGpsState
+#define WARM_START_ACCURACY     10000 // (m) a boat can have gone since
+#define FIX_KEEP_DISTANCE       90000 // (1e-7 degrees) about 1 km of latitude
+
+// Sensor fusion, see updateFilter. The accelerometer is mounted level with
+// x toward the bow and y to starboard, at +/-2 G over 12 bits.
+#define GRAVITY                 9.80665f // (m/s^2)
+#define ACCEL_COUNTS_PER_G      1024.0f
+#define ACCEL_TO_MPS2           (GRAVITY / ACCEL_COUNTS_PER_G)
+// White noise of the horizontal acceleration, mostly from waves and tilt
+#define ACCEL_NOISE             0.5f // (m/s^2) one sigma
+// Quantization adds a uniform step^2/12 on top (Han and Wang, 2011)
+#define ACCEL_VARIANCE          (ACCEL_NOISE*ACCEL_NOISE \
+    + ACCEL_TO_MPS2*ACCEL_TO_MPS2/12.0f)
+#define GPS_MIN_ACCURACY        2.5f // (m) floor on the hAcc we trust
+#define GPS_VELOCITY_NOISE      0.1f // (m/s) one sigma
+#define INITIAL_VELOCITY_NOISE  1.0f // (m/s) one sigma
+#define MAX_FILTER_STEP         0.1f // (s) longer gaps are clamped
+#define HEADING_GAIN            0.1f // weight of each magnetometer reading
 
 
 /***********************************************************************
  * PRIVATE VARIABLES                                                   *
  ***********************************************************************/
 
+// ENU frame at the reference (the command center), see updateReferenceFrame
+static struct {
+    BOOL isValid;
+    float lat, lon, alt; // reference it was computed for
+    Coordinate ecef; // reference in ECEF
+    float rotation[3][3]; // ENU to ECEF, columns are east, north, up
+} frame;
+
+// GPS state kept once a boot, see keepGpsState
+#ifdef USE_GPS
+static uint8_t gpsOptions = 0x0; // without GPS_OPTION_SAVED
+static BOOL isConfigKept = FALSE, isFixKept = FALSE;
+#endif
+
+// Projected points waiting for the downlink, see Navigation_streamSample
+RING_BUFFER_STORAGE(streamStorage,
+    NAVIGATION_STREAM_LENGTH * sizeof(ProjectedPoint));
+static struct {
+    BOOL isActive;
+    uint16_t dropped; // points that didn't fit
+    RingBuffer ring;
+} stream;
+
+#ifdef USE_SENSOR_FUSION
+// Position and velocity along north or east, with their covariance
+typedef struct {
+    float position; // (m)
+    float velocity; // (m/s)
+    float p00, p01, p11; // [position velocity] covariance, symmetric
+} AxisFilter;
+
+static struct {
+    BOOL isValid;
+    uint32_t lastStep; // (ms) get_time() of the last predict
+    uint32_t lastFix; // (ms) GpsFix time of the last correction
+    uint32_t lastHeading; // (ms) MagnetometerHeading time last blended in
+    GpsCoordinate origin; // first fix, north and east are from here
+    int32_t altitude; // (mm) of the last fix
+    float metersPerLongitude; // per 1e-7 degrees at the origin
+    float heading; // (degrees) from north
+    AxisFilter north, east;
+} fusion;
+#endif
+
 /***********************************************************************
  * PRIVATE PROTOTYPES                                                  *
  ***********************************************************************/
@@ -46,17 +121,46 @@ void convertENU2ECEF(Coordinate *var, float east, float north, float up, float l
 void convertGeodetic2ECEF(Coordinate *var, float lat, float lon, float alt);
 void convertECEF2Geodetic(Coordinate *var, float ecef_x, float ecef_y, float ecef_z);
 void convertEuler2NED(Coordinate *var, float yaw, float pitch, float height);
+void updateReferenceFrame(float lat_ref, float lon_ref, float alt_ref);
+static BOOL getReference(Coordinate *ref);
+static BOOL projectSample(Coordinate *coord, float yaw, float pitch,
+    float height, const Coordinate *ref);
+#ifdef USE_GPS
+static void keepGpsState();
+#endif
+#ifdef USE_SENSOR_FUSION
+static void updateFilter();
+static void startFilter(const GpsCoordinate *coord, float accuracy);
+static void predictAxis(AxisFilter *axis, float accel, float dt);
+static void correctPosition(AxisFilter *axis, float position, float variance);
+static void correctVelocity(AxisFilter *axis, float velocity, float variance);
+#endif
 
 /***********************************************************************
  * PUBLIC FUNCTIONS                                                    *
  ***********************************************************************/
 BOOL Navigation_init() {
     #ifdef USE_GPS
-    uint8_t options = 0x0;
+    uint8_t options = gpsOptions, kept;
+    GpsCoordinate lastFix;
+    // A receiver that kept this configuration is only checked
+    if (Nvm_read(NVM_KEY_GPS_CONFIG, &kept, sizeof(kept)) == SUCCESS
+            && kept == gpsOptions)
+        options |= GPS_OPTION_SAVED;
     if (GPS_init(options) != SUCCESS || !GPS_isInitialized()) {
         printf("Failed to initialize Navigation system.\n");
         return FAILURE;
     }
+    if (Nvm_read(NVM_KEY_GPS_FIX, &lastFix, sizeof(lastFix)) == SUCCESS)
+        GPS_setWarmStart(&lastFix, WARM_START_ACCURACY);
+    isConfigKept = FALSE;
+    isFixKept = FALSE;
+    #endif
+    #ifdef USE_SENSOR_FUSION
+    fusion.isValid = FALSE;
+    fusion.heading = Magnetometer_getDegree();
+    fusion.lastHeading = 0;
+    Timer_new(TIMER_NAVIGATION, NAVIGATION_FILTER_PERIOD);
     #endif
     return SUCCESS;
 }
@@ -64,6 +168,14 @@ BOOL Navigation_init() {
 void Navigation_runSM() {
     #ifdef USE_GPS
     GPS_runSM();
+    if (!isConfigKept || !isFixKept)
+        keepGpsState();
+    #endif
+    #ifdef USE_SENSOR_FUSION
+    if (Timer_isExpired(TIMER_NAVIGATION)) {
+        Timer_new(TIMER_NAVIGATION, NAVIGATION_FILTER_PERIOD);
+        updateFilter();
+    }
     #endif
 }
 
@@ -77,38 +189,198 @@ BOOL Navigation_isReady() {
 }
 
 
+#ifdef USE_SENSOR_FUSION
+BOOL Navigation_getPose(Pose *pose) {
+    if (!fusion.isValid)
+        return FALSE;
+    pose->north = fusion.north.position;
+    pose->east = fusion.east.position;
+    pose->velocityNorth = fusion.north.velocity;
+    pose->velocityEast = fusion.east.velocity;
+    pose->heading = fusion.heading;
+    pose->accuracy = sqrtf(fusion.north.p00 + fusion.east.p00);
+    pose->time = fusion.lastStep;
+    return TRUE;
+}
+
+BOOL Navigation_getPoseCoordinate(GpsCoordinate *coord) {
+    if (!fusion.isValid)
+        return FALSE;
+    coord->latitude = fusion.origin.latitude
+        + (int32_t)(fusion.north.position / METERS_PER_COORDINATE);
+    coord->longitude = fusion.origin.longitude
+        + (int32_t)(fusion.east.position / fusion.metersPerLongitude);
+    coord->altitude = fusion.altitude;
+    return TRUE;
+}
+#endif
+
 //#ifdef IS_COMPAS
 BOOL Navigation_getProjectedCoordinate(Coordinate *coord, float yaw, float pitch, float height) {
-    if (yaw >= YAW_LIMIT)
+    Coordinate ref;
+    if (!getReference(&ref))
         return FALSE;
-    else if (pitch > PITCH_LIMIT)
+    return projectSample(coord, yaw, pitch, height, &ref);
+}
+
+#ifdef USE_GPS
+BOOL Navigation_getProjectedGpsCoordinate(GpsCoordinate *coord, float yaw,
+        float pitch, float height) {
+    GpsCoordinate here;
+    Coordinate ned;
+    if (!Navigation_isReady() || yaw >= YAW_LIMIT || pitch > PITCH_LIMIT)
+        return FALSE;
+
+    // Only the offset is in floats, tens of meters to well under a cm
+    convertEuler2NED(&ned, yaw, pitch, height);
+    GPS_getCoordinate(&here);
+    coord->latitude = here.latitude
+        + (int32_t)(ned.x / METERS_PER_COORDINATE);
+    coord->longitude = here.longitude
+        + (int32_t)(ned.y / (METERS_PER_COORDINATE * FastMath_cos(
+            (float)here.latitude / GPS_COORDINATE_SCALE * DEGREE_TO_RADIAN)));
+    coord->altitude = here.altitude - (int32_t)(ned.z * 1000.0f);
+    return TRUE;
+}
+#endif
+
+uint16_t Navigation_projectBatch(Projection *samples, uint16_t count, float height) {
+    Coordinate ref;
+    uint16_t i, valid = 0;
+    BOOL isReady = getReference(&ref);
+
+    for (i = 0; i < count; i++) {
+        samples[i].isValid = isReady && projectSample(&samples[i].coord,
+            samples[i].yaw, samples[i].pitch, height, &ref);
+        if (samples[i].isValid)
+            valid++;
+    }
+    return valid;
+}
+
+void Navigation_startStream() {
+    RingBuffer_init(&stream.ring, streamStorage, sizeof(streamStorage));
+    stream.dropped = 0;
+    stream.isActive = TRUE;
+}
+
+void Navigation_stopStream() {
+    stream.isActive = FALSE;
+}
+
+BOOL Navigation_streamSample(float yaw, float pitch, float height) {
+    ProjectedPoint point;
+    Coordinate ref;
+
+    if (!stream.isActive || !getReference(&ref)
+            || !projectSample(&point.coord, yaw, pitch, height, &ref))
+        return FALSE;
+    if (RingBuffer_getSpace(&stream.ring) < sizeof(point)) {
+        stream.dropped++;
         return FALSE;
+    }
+    point.time = get_time();
+    RingBuffer_write(&stream.ring, (const uint8_t *)&point, sizeof(point));
+    return TRUE;
+}
+
+BOOL Navigation_readStream(ProjectedPoint *point) {
+    if (!stream.isActive
+            || RingBuffer_getLength(&stream.ring) < sizeof(*point))
+        return FALSE;
+    RingBuffer_read(&stream.ring, (uint8_t *)point, sizeof(*point));
+    return TRUE;
+}
 
+uint16_t Navigation_getStreamDropped() {
+    return stream.dropped;
+}
+//#endif
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                          *
+ ******************************************************************************/
+
+/**
+ * Function: getReference
+ * @param Set to the reference geodetic coordinate (lat, lon, alt).
+ * @return TRUE, or FALSE if it isn't available.
+ * @remark The reference is where the COMPAS is, only needed for geodetic
+ *  projections. Read once per call so a batch shares it.
+ * @date 2026.10.14  */
+static BOOL getReference(Coordinate *ref) {
     #ifdef USE_GEODETIC
     if ( ! Navigation_isReady())
         return FALSE;
-
-    float alt = GPS_getAltitude();
+    ref->x = GPS_getLatitude();
+    ref->y = GPS_getLongitude();
+    ref->z = GPS_getAltitude();
+    #else
+    ref->x = ref->y = ref->z = 0.0f;
     #endif
-    float alt = 0.0;
-    
+    return TRUE;
+}
+
+/**
+ * Function: keepGpsState
+ * @return None.
+ * @remark Keeps whether the receiver saved its configuration once it's
+ *  done, and the first fix if it's moved from the one kept, so the next
+ *  boot starts warm. At most one write each a boot.
+ * @date 2026.10.14  */
+#ifdef USE_GPS
+static void keepGpsState() {
+    GpsCoordinate coord, kept;
+
+    if (!isConfigKept && GPS_isConfigured()) {
+        if (GPS_isConfigSaved())
+            Nvm_write(NVM_KEY_GPS_CONFIG, &gpsOptions, sizeof(gpsOptions));
+        else
+            Nvm_erase(NVM_KEY_GPS_CONFIG);
+        isConfigKept = TRUE;
+    }
+    if (!isFixKept && GPS_hasFix() && GPS_hasPosition()) {
+        GPS_getCoordinate(&coord);
+        if (Nvm_read(NVM_KEY_GPS_FIX, &kept, sizeof(kept)) != SUCCESS
+                || abs(coord.latitude - kept.latitude) > FIX_KEEP_DISTANCE
+                || abs(coord.longitude - kept.longitude) > FIX_KEEP_DISTANCE)
+            Nvm_write(NVM_KEY_GPS_FIX, &coord, sizeof(coord));
+        isFixKept = TRUE;
+    }
+}
+#endif
+
+/**
+ * Function: projectSample
+ * @param Where to save the projected coordinate.
+ * @param Yaw angle to projected position in degrees.
+ * @param Pitch angle to projected position in degrees.
+ * @param Height from projected position in meters.
+ * @param Reference from getReference.
+ * @return TRUE, or FALSE if the angles are out of range.
+ * @remark Geodetic (lat, lon, alt) with USE_GEODETIC, otherwise NED.
+ * @date 2026.10.14  */
+static BOOL projectSample(Coordinate *coord, float yaw, float pitch,
+        float height, const Coordinate *ref) {
+    if (yaw >= YAW_LIMIT)
+        return FALSE;
+    else if (pitch > PITCH_LIMIT)
+        return FALSE;
+
     // Convert params to NED vector (x=north, y=east, z=down)
     Coordinate ned;
-    convertEuler2NED(&ned, yaw, pitch, height + alt);
+    convertEuler2NED(&ned, yaw, pitch, height);
 
     #ifdef USE_GEODETIC
-    // Get refence geodetic coordinate
-    float lat = GPS_getLatitude();
-    float lon = GPS_getLongitude();
-
     // Convert NED to ENU and obtain projected ECEF
-    Coordinate ecef = Coordinate_new(ecef, 0, 0 ,0);
-    convertENU2ECEF(ecef, ned->y, ned->x, -(ned->z), lat, lon, alt);
+    Coordinate ecef;
+    convertENU2ECEF(&ecef, ned.y, ned.x, -(ned.z), ref->x, ref->y, ref->z);
 
     // Convert projected ECEF into projected Geodetic (LLA)
-    convertECEF2Geodetic(geo, ecef->x, ecef->y, ecef->z);
+    convertECEF2Geodetic(coord, ecef.x, ecef.y, ecef.z);
 
     #else
+    (void)ref; // the NED vector is already relative
     coord->x = ned.x;
     coord->y = ned.y;
     coord->z = ned.z;
@@ -122,7 +394,6 @@ BOOL Navigation_getProjectedCoordinate(Coordinate *coord, float yaw, float pitch
 
     return TRUE;
 }
-//#endif
 
 // -------------------------- Functions for Types ----------------------
 /*
@@ -136,9 +407,6 @@ Coordinate Coordinate_new(Coordinate coord, float x, float y, float z) {
     return coord;
 }
 */
-/*******************************************************************************
- * PRIVATE FUNCTIONS                                                          *
- ******************************************************************************/
 
 /**
  * Function: convertENU2ECEF
@@ -147,30 +415,213 @@ Coordinate Coordinate_new(Coordinate coord, float x, float y, float z) {
  * @param North component in meters.
  * @param Up component in meters.
  * @return None.
- * @remark Converts the given ENU vector into a ECEF coordinate.
+ * @remark Converts the given ENU vector into a ECEF coordinate. The
+ *  reference's ECEF position and rotation are cached, so this is just a
+ *  3x3 multiply-add until the reference moves.
  * @author David Goodman
  * @author MATLAB
  * @date 2013.03.10  */
 void convertENU2ECEF(Coordinate *var, float east, float north, float up, float lat_ref,
     float lon_ref, float alt_ref) {
-    // Convert geodetic lla  reference to ecef
-    Coordinate ecef_ref; //= Coordinate_new(ecef_ref, 0, 0, 0);
-    convertGeodetic2ECEF(&ecef_ref, lat_ref, lon_ref, alt_ref);
+    updateReferenceFrame(lat_ref, lon_ref, alt_ref);
+
+    var->x = frame.ecef.x + frame.rotation[0][0] * east
+        + frame.rotation[0][1] * north + frame.rotation[0][2] * up;
+    var->y = frame.ecef.y + frame.rotation[1][0] * east
+        + frame.rotation[1][1] * north + frame.rotation[1][2] * up;
+    var->z = frame.ecef.z + frame.rotation[2][0] * east
+        + frame.rotation[2][1] * north + frame.rotation[2][2] * up;
+}
+
+#ifdef USE_SENSOR_FUSION
+/**
+ * Function: updateFilter
+ * @return None.
+ * @remark One step of the fusion filter, the same handful of float
+ *  operations every time. The heading follows each new magnetometer
+ *  heading through a low-pass, and rotates the acceleration into north and east. Each axis
+ *  is a two state Kalman filter (position, velocity) driven by that
+ *  acceleration, and corrected by the GPS position, weighted by its hAcc,
+ *  and velocity whenever a new fix has come in.
+ * @date 2026.10.14  */
+static void updateFilter() {
+    uint32_t now = get_time();
+    float dt = (float)(now - fusion.lastStep) / 1000.0f;
+    float delta, sinyaw, cosyaw, forward, starboard;
+    MagnetometerHeading magnetometer;
+    GpsFix fix;
+
+    fusion.lastStep = now;
+    if (dt > MAX_FILTER_STEP)
+        dt = MAX_FILTER_STEP;
+
+    // Heading, taking the short way around, once per reading
+    Magnetometer_getHeading(&magnetometer);
+    if (magnetometer.isValid && magnetometer.time != fusion.lastHeading) {
+        fusion.lastHeading = magnetometer.time;
+        delta = magnetometer.heading - fusion.heading;
+        if (delta > 180.0f)
+            delta -= 360.0f;
+        else if (delta < -180.0f)
+            delta += 360.0f;
+        fusion.heading += HEADING_GAIN * delta;
+        if (fusion.heading >= 360.0f)
+            fusion.heading -= 360.0f;
+        else if (fusion.heading < 0.0f)
+            fusion.heading += 360.0f;
+    }
+
+    if (fusion.isValid) {
+        forward = Accelerometer_getX() * ACCEL_TO_MPS2;
+        starboard = Accelerometer_getY() * ACCEL_TO_MPS2;
+        FastMath_sinCos(fusion.heading * DEGREE_TO_RADIAN, &sinyaw, &cosyaw);
+        predictAxis(&fusion.north, forward * cosyaw - starboard * sinyaw, dt);
+        predictAxis(&fusion.east, forward * sinyaw + starboard * cosyaw, dt);
+    }
+
+    if (GPS_getLastFix(&fix) != SUCCESS || !GPS_hasFix()
+            || (fusion.isValid && fix.time == fusion.lastFix))
+        return;
+
+    // New fix, use the corrected position rather than the raw one
+    GpsCoordinate coord;
+    float accuracy = GPS_getHorizontalAccuracy() / 1000.0f;
+    if (accuracy < GPS_MIN_ACCURACY)
+        accuracy = GPS_MIN_ACCURACY;
+    GPS_getCoordinate(&coord);
+    fusion.lastFix = fix.time;
+    fusion.altitude = coord.altitude;
+    if (!fusion.isValid) {
+        startFilter(&coord, accuracy);
+        return;
+    }
+
+    float variance = accuracy * accuracy;
+    correctPosition(&fusion.north, METERS_PER_COORDINATE
+        * (coord.latitude - fusion.origin.latitude), variance);
+    correctPosition(&fusion.east, fusion.metersPerLongitude
+        * (coord.longitude - fusion.origin.longitude), variance);
+    variance = GPS_VELOCITY_NOISE * GPS_VELOCITY_NOISE;
+    correctVelocity(&fusion.north, fix.north / 100.0f, variance);
+    correctVelocity(&fusion.east, fix.east / 100.0f, variance);
+}
+
+/**
+ * Function: startFilter
+ * @param First GPS position, which becomes the origin.
+ * @param Its accuracy in meters.
+ * @return None.
+ * @date 2026.10.14  */
+static void startFilter(const GpsCoordinate *coord, float accuracy) {
+    AxisFilter start = { 0.0f, 0.0f, accuracy * accuracy, 0.0f,
+        INITIAL_VELOCITY_NOISE * INITIAL_VELOCITY_NOISE };
+
+    fusion.origin = *coord;
+    fusion.metersPerLongitude = METERS_PER_COORDINATE * FastMath_cos(
+        (float)coord->latitude / GPS_COORDINATE_SCALE * DEGREE_TO_RADIAN);
+    fusion.north = start;
+    fusion.east = start;
+    fusion.isValid = TRUE;
+}
 
-    float coslat = cos(DEGREE_TO_RADIAN*lat_ref);
-    float sinlat = sin(DEGREE_TO_RADIAN*lat_ref);
-    float coslon = cos(DEGREE_TO_RADIAN*lon_ref);
-    float sinlon = sin(DEGREE_TO_RADIAN*lon_ref);
+/**
+ * Function: predictAxis
+ * @param The axis to propagate.
+ * @param Acceleration along the axis in m/s^2.
+ * @param Time step in seconds.
+ * @return None.
+ * @remark x = F x + B a and P = F P F' + Q, expanded for F = [1 dt; 0 1]
+ *  and Q from white acceleration noise.
+ * @date 2026.10.14  */
+static void predictAxis(AxisFilter *axis, float accel, float dt) {
+    float dt2 = dt * dt;
+
+    axis->position += axis->velocity * dt + 0.5f * accel * dt2;
+    axis->velocity += accel * dt;
+
+    axis->p00 += dt * (2.0f * axis->p01 + dt * axis->p11)
+        + 0.25f * ACCEL_VARIANCE * dt2 * dt2;
+    axis->p01 += dt * axis->p11 + 0.5f * ACCEL_VARIANCE * dt2 * dt;
+    axis->p11 += ACCEL_VARIANCE * dt2;
+}
 
-    float t = coslat * up - sinlat * north;
-    float dz = sinlat * up + coslat * north;
+/**
+ * Function: correctPosition
+ * @param The axis to correct.
+ * @param Measured position in meters.
+ * @param Variance of the measurement.
+ * @return None.
+ * @date 2026.10.14  */
+static void correctPosition(AxisFilter *axis, float position, float variance) {
+    float innovation = position - axis->position;
+    float s = axis->p00 + variance;
+    float k0 = axis->p00 / s, k1 = axis->p01 / s;
+
+    axis->position += k0 * innovation;
+    axis->velocity += k1 * innovation;
+    axis->p11 -= k1 * axis->p01;
+    axis->p01 -= k0 * axis->p01;
+    axis->p00 -= k0 * axis->p00;
+}
+
+/**
+ * Function: correctVelocity
+ * @param The axis to correct.
+ * @param Measured velocity in m/s.
+ * @param Variance of the measurement.
+ * @return None.
+ * @date 2026.10.14  */
+static void correctVelocity(AxisFilter *axis, float velocity, float variance) {
+    float innovation = velocity - axis->velocity;
+    float s = axis->p11 + variance;
+    float k0 = axis->p01 / s, k1 = axis->p11 / s;
+
+    axis->position += k0 * innovation;
+    axis->velocity += k1 * innovation;
+    axis->p00 -= k0 * axis->p01;
+    axis->p01 -= k1 * axis->p01;
+    axis->p11 -= k1 * axis->p11;
+}
+#endif
 
-    float dx = coslon * t - sinlon * east;
-    float dy = sinlon * t + coslon * east;
+/**
+ * Function: updateReferenceFrame
+ * @param Reference latitude in degrees.
+ * @param Reference longitude in degrees.
+ * @param Reference altitude in meters.
+ * @return None.
+ * @remark Recomputes the cached ECEF position and ENU rotation of the
+ *  reference, only if it moved more than the frame thresholds since the
+ *  last time. The reference is the command center, which sits still.
+ * @date 2026.10.14  */
+void updateReferenceFrame(float lat_ref, float lon_ref, float alt_ref) {
+    if (frame.isValid
+            && fabsf(lat_ref - frame.lat) < FRAME_DEGREE_THRESHOLD
+            && fabsf(lon_ref - frame.lon) < FRAME_DEGREE_THRESHOLD
+            && fabsf(alt_ref - frame.alt) < FRAME_ALTITUDE_THRESHOLD)
+        return;
 
-    var->x = ecef_ref.x + dx;
-    var->y = ecef_ref.y + dy;
-    var->z = ecef_ref.z + dz;
+    // Convert geodetic lla  reference to ecef
+    convertGeodetic2ECEF(&frame.ecef, lat_ref, lon_ref, alt_ref);
+
+    float sinlat, coslat, sinlon, coslon;
+    FastMath_sinCos(DEGREE_TO_RADIAN*lat_ref, &sinlat, &coslat);
+    FastMath_sinCos(DEGREE_TO_RADIAN*lon_ref, &sinlon, &coslon);
+
+    frame.rotation[0][0] = -sinlon;
+    frame.rotation[0][1] = -sinlat * coslon;
+    frame.rotation[0][2] = coslat * coslon;
+    frame.rotation[1][0] = coslon;
+    frame.rotation[1][1] = -sinlat * sinlon;
+    frame.rotation[1][2] = coslat * sinlon;
+    frame.rotation[2][0] = 0;
+    frame.rotation[2][1] = coslat;
+    frame.rotation[2][2] = sinlat;
+
+    frame.lat = lat_ref;
+    frame.lon = lon_ref;
+    frame.alt = alt_ref;
+    frame.isValid = TRUE;
 }
 
 
@@ -187,13 +638,14 @@ void convertENU2ECEF(Coordinate *var, float east, float north, float up, float l
  * @author MATLAB
  * @date 2013.03.10  */
 void convertGeodetic2ECEF(Coordinate *var, float lat, float lon, float alt) {
-    float sinlat = sin(DEGREE_TO_RADIAN*lat);
-    float coslat = cos(DEGREE_TO_RADIAN*lat);
-
-    float rad_ne = R_EN / sqrt(1.0 - (ECC2 * sinlat * sinlat));
-    var->x = (rad_ne + alt) * coslat * cos(lon*DEGREE_TO_RADIAN);
-    var->y = (rad_ne + alt) * coslat * sin(lon*DEGREE_TO_RADIAN);
-    var->z = (rad_ne*(1.0 - ECC2) + alt) * sinlat;
+    float sinlat, coslat, sinlon, coslon;
+    FastMath_sinCos(DEGREE_TO_RADIAN*lat, &sinlat, &coslat);
+    FastMath_sinCos(DEGREE_TO_RADIAN*lon, &sinlon, &coslon);
+
+    float rad_ne = R_EN / sqrtf(1.0f - (ECC2 * sinlat * sinlat));
+    var->x = (rad_ne + alt) * coslat * coslon;
+    var->y = (rad_ne + alt) * coslat * sinlon;
+    var->z = (rad_ne*(1.0f - ECC2) + alt) * sinlat;
 }
 
 
@@ -205,36 +657,31 @@ void convertGeodetic2ECEF(Coordinate *var, float lat, float lon, float alt) {
  * @param ECEF Z position.
  * @return None.
  * @remark Converts the given ECEF coordinates into a geodetic coordinate in degrees.
- *  Note that x=lat, y=lon, z=alt.
+ *  Note that x=lat, y=lon, z=alt. Uses one pass of Bowring's method, which
+ *  is within 1e-9 rad (under 0.01 m) of the exact latitude and 0.01 m of
+ *  the exact altitude from 10 km below to 100 km above the ellipsoid, so
+ *  the float ECEF input (0.5 m steps, under 2 m round trip) is what
+ *  limits the result. Always three atan2, two sinCos and a sqrt, with no loop.
  * @author David Goodman
  * @author MATLAB
  * @date 2013.03.10  */
 void convertECEF2Geodetic(Coordinate *var, float ecef_x, float ecef_y, float ecef_z) {
     float lat = 0, lon = 0, alt = 0;
 
-    lon = atan2(ecef_y, ecef_x);
+    float sinbeta, cosbeta, sinlat, coslat;
+    lon = FastMath_atan2(ecef_y, ecef_x);
 
     float rho = hypotf(ecef_x,ecef_y); // distance from z-axis
-    float beta = atan2(ecef_z, (1 - FLATR) * rho);
+    float beta = FastMath_atan2(ecef_z, (1 - FLATR) * rho);
 
-    lat = atan2(ecef_z + R_EM * ECCP2 * sin(beta)*sin(beta)*sin(beta),
-        rho - R_EN * ECC2 * cos(beta)*cos(beta)*cos(beta));
+    FastMath_sinCos(beta, &sinbeta, &cosbeta);
+    lat = FastMath_atan2(ecef_z + R_EM * ECCP2 * sinbeta*sinbeta*sinbeta,
+        rho - R_EN * ECC2 * cosbeta*cosbeta*cosbeta);
 
-    float betaNew = atan2((1 - FLATR)*sin(lat), cos(lat));
-    int count = 0;
-    while (beta != betaNew && count < 5) {
-        beta = betaNew;
-        var->x = atan2(ecef_z  + R_EM * ECCP2 * sin(beta)*sin(beta)*sin(beta),
-            rho - R_EN * ECC2 * cos(beta)*cos(beta)*cos(beta));
-
-        betaNew = atan2((1 - FLATR)*sin(lat), cos(lat));
-        count = count + 1;
-    }
-
-    float sinlat = sin(lat);
-    float rad_ne = R_EN / sqrt(1.0 - (ECC2 * sinlat * sinlat));
-
-    alt = rho * cos(lat) + (ecef_z + ECC2 * rad_ne * sinlat) * sinlat - rad_ne;
+    // Holds everywhere, unlike rho/cos(lat) - N which blows up at the poles
+    FastMath_sinCos(lat, &sinlat, &coslat);
+    alt = rho * coslat + ecef_z * sinlat
+        - R_EN * sqrtf(1.0f - (ECC2 * sinlat * sinlat));
 
     // Convert radian geodetic to degrees
     var->x = RADIAN_TO_DEGREE*lat;
@@ -257,8 +704,9 @@ void convertECEF2Geodetic(Coordinate *var, float ecef_x, float ecef_y, float ece
 void convertEuler2NED(Coordinate *var, float yaw, float pitch, float height) {
     //printf("At angle: %.3f and pitch: %.3f\n",yaw,pitch);
 
-    float mag = height * tan((90.0-pitch)*DEGREE_TO_RADIAN);
-    #ifdef DEBUG
+    float mag = height * FastMath_tan((90.0f-pitch)*DEGREE_TO_RADIAN);
+    float sinyaw, cosyaw;
+    #ifdef DEBUG_VERBOSE
     printf("\tMagnitude: %.3f\n",mag);
     #endif
 
@@ -266,26 +714,30 @@ void convertEuler2NED(Coordinate *var, float yaw, float pitch, float height) {
     
     if (yaw <= 90.0) {
         //First quadrant
-        var->x = mag * cos(yaw*DEGREE_TO_RADIAN);
-        var->y = mag * sin(yaw*DEGREE_TO_RADIAN);
+        FastMath_sinCos(yaw*DEGREE_TO_RADIAN, &sinyaw, &cosyaw);
+        var->x = mag * cosyaw;
+        var->y = mag * sinyaw;
     }
     else if (yaw > 90.0 && yaw <= 180.0) {
         // Second quadrant
-        yaw = yaw - 270.0;
-        var->x = mag * sin(yaw*DEGREE_TO_RADIAN);
-        var->y = -mag * cos(yaw*DEGREE_TO_RADIAN);
+        yaw = yaw - 90.0;
+        FastMath_sinCos(yaw*DEGREE_TO_RADIAN, &sinyaw, &cosyaw);
+        var->x = -mag * sinyaw;
+        var->y = mag * cosyaw;
     }
     else if (yaw > 180.0 && yaw <= 270.0) {
         // Third quadrant
         yaw = yaw - 180.0;
-        var->x = -mag * cos(yaw*DEGREE_TO_RADIAN);
-        var->y = -mag * sin(yaw*DEGREE_TO_RADIAN);
+        FastMath_sinCos(yaw*DEGREE_TO_RADIAN, &sinyaw, &cosyaw);
+        var->x = -mag * cosyaw;
+        var->y = -mag * sinyaw;
     }
-    else if (yaw > 270 < 360.0) {
+    else if (yaw > 270.0 && yaw < 360.0) {
         // Fourth quadrant
-        yaw = yaw - 90.0;
-        var->x = -mag * sin(yaw*DEGREE_TO_RADIAN);
-        var->y = mag * cos(yaw*DEGREE_TO_RADIAN);
+        yaw = yaw - 270.0;
+        FastMath_sinCos(yaw*DEGREE_TO_RADIAN, &sinyaw, &cosyaw);
+        var->x = mag * sinyaw;
+        var->y = -mag * cosyaw;
     }
 
 
@@ -376,4 +828,162 @@ int main() {
     return SUCCESS;
 }
 
-#endif
\ No newline at end of file
+#endif
+
+//#define NAVIGATION_BENCHMARK
+#ifdef NAVIGATION_BENCHMARK
+/*
+ * Times the conversions with the core timer and checks them against double
+ * precision over the operating envelope. Builds on the board as is, or on
+ * a PC against the stubs in tool/navigation_bench.
+ */
+
+#define BENCH_CALLS             1000
+#define OPERATING_LATITUDE      36.95 // (degrees) Santa Cruz
+#define OPERATING_LONGITUDE     -122.03 // (degrees)
+#define METERS_PER_DEGREE       111320.0
+
+static volatile float sink;
+
+// Double precision references of the private conversions
+
+static void referenceGeodetic2ECEF(double *ecef, double lat, double lon, double alt) {
+    double e2 = (double)ECC * ECC;
+    double phi = lat * M_PI / 180.0, lambda = lon * M_PI / 180.0;
+    double n = R_EN / sqrt(1.0 - e2 * sin(phi) * sin(phi));
+    ecef[0] = (n + alt) * cos(phi) * cos(lambda);
+    ecef[1] = (n + alt) * cos(phi) * sin(lambda);
+    ecef[2] = (n * (1.0 - e2) + alt) * sin(phi);
+}
+
+static void referenceECEF2Geodetic(double *lla, const double *ecef) {
+    double e2 = (double)ECC * ECC;
+    double p = sqrt(ecef[0] * ecef[0] + ecef[1] * ecef[1]);
+    double lat = atan2(ecef[2], p * (1.0 - e2)), n = R_EN;
+    int i;
+    for (i = 0; i < 10; i++) {
+        n = R_EN / sqrt(1.0 - e2 * sin(lat) * sin(lat));
+        lat = atan2(ecef[2] + e2 * n * sin(lat), p);
+    }
+    lla[0] = lat * 180.0 / M_PI;
+    lla[1] = atan2(ecef[1], ecef[0]) * 180.0 / M_PI;
+    lla[2] = p * cos(lat) + ecef[2] * sin(lat)
+        - R_EN * sqrt(1.0 - e2 * sin(lat) * sin(lat));
+}
+
+static void report(const char *name, uint32_t ticks, double error, const char *unit) {
+    printf("%-22s %9.1f ticks %8.2f us  max error %.3g %s\n", name,
+        (double)ticks / BENCH_CALLS,
+        ticks * 1e6 / BENCH_CALLS / TIMER_CYCLES_PER_SECOND, error, unit);
+}
+
+int main() {
+    Board_init();
+    Serial_init();
+    Timer_init();
+
+    Coordinate out;
+    double ref[3], lla[3], e, error;
+    float yaw, pitch, height, lat, lon;
+    uint32_t start, ticks;
+    int i;
+
+    printf("Navigation benchmark, %d calls each\n", BENCH_CALLS);
+
+    // Euler to NED, the whole sight range over 1-10 m of height
+    error = 0;
+    for (yaw = 0; yaw < YAW_LIMIT; yaw += 1.0f)
+        for (pitch = 30.0f; pitch < PITCH_LIMIT; pitch += 0.5f)
+            for (height = 1.0f; height <= 10.0f; height += 3.0f) {
+                double mag = height * tan((90.0 - pitch) * M_PI / 180.0);
+                convertEuler2NED(&out, yaw, pitch, height);
+                e = hypot(out.x - mag * cos(yaw * M_PI / 180.0),
+                    out.y - mag * sin(yaw * M_PI / 180.0));
+                if (e > error) error = e;
+            }
+    start = Timer_getCycles();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        convertEuler2NED(&out, (float)(i % 360), 80.0f, 4.572f);
+        sink = out.x;
+    }
+    ticks = Timer_getCycles() - start;
+    report("convertEuler2NED", ticks, error, "m");
+
+    // Geodetic to ECEF, the whole globe up to 1 km
+    error = 0;
+    for (lat = -89.0f; lat < 90.0f; lat += 2.0f)
+        for (lon = -180.0f; lon < 180.0f; lon += 5.0f) {
+            convertGeodetic2ECEF(&out, lat, lon, 100.0f);
+            referenceGeodetic2ECEF(ref, lat, lon, 100.0);
+            e = sqrt((out.x - ref[0]) * (out.x - ref[0])
+                + (out.y - ref[1]) * (out.y - ref[1])
+                + (out.z - ref[2]) * (out.z - ref[2]));
+            if (e > error) error = e;
+        }
+    start = Timer_getCycles();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        convertGeodetic2ECEF(&out, OPERATING_LATITUDE, OPERATING_LONGITUDE, i);
+        sink = out.x;
+    }
+    ticks = Timer_getCycles() - start;
+    report("convertGeodetic2ECEF", ticks, error, "m");
+
+    // ENU to ECEF, 200 m around the command center
+    error = 0;
+    referenceGeodetic2ECEF(ref, OPERATING_LATITUDE, OPERATING_LONGITUDE, 10.0);
+    for (yaw = -200.0f; yaw <= 200.0f; yaw += 10.0f)
+        for (pitch = -200.0f; pitch <= 200.0f; pitch += 10.0f) {
+            double phi = OPERATING_LATITUDE * M_PI / 180.0;
+            double lambda = OPERATING_LONGITUDE * M_PI / 180.0;
+            double x = ref[0] - sin(lambda) * yaw - sin(phi) * cos(lambda) * pitch;
+            double y = ref[1] + cos(lambda) * yaw - sin(phi) * sin(lambda) * pitch;
+            double z = ref[2] + cos(phi) * pitch;
+            convertENU2ECEF(&out, yaw, pitch, 0.0f, OPERATING_LATITUDE,
+                OPERATING_LONGITUDE, 10.0f);
+            e = sqrt((out.x - x) * (out.x - x) + (out.y - y) * (out.y - y)
+                + (out.z - z) * (out.z - z));
+            if (e > error) error = e;
+        }
+    start = Timer_getCycles();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        convertENU2ECEF(&out, i % 100, 50.0f, -4.5f, OPERATING_LATITUDE,
+            OPERATING_LONGITUDE, 10.0f);
+        sink = out.x;
+    }
+    ticks = Timer_getCycles() - start;
+    report("convertENU2ECEF", ticks, error, "m");
+
+    // ECEF to geodetic, from exact ECEF of the whole globe
+    error = 0;
+    for (lat = -89.0f; lat < 90.0f; lat += 2.0f)
+        for (lon = -180.0f; lon < 180.0f; lon += 5.0f) {
+            referenceGeodetic2ECEF(ref, lat, lon, 100.0);
+            convertECEF2Geodetic(&out, ref[0], ref[1], ref[2]);
+            referenceECEF2Geodetic(lla, ref);
+            e = fabs(out.x - lla[0]) * METERS_PER_DEGREE;
+            if (e > error) error = e;
+            e = fabs(out.z - lla[2]);
+            if (e > error) error = e;
+        }
+    referenceGeodetic2ECEF(ref, OPERATING_LATITUDE, OPERATING_LONGITUDE, 10.0);
+    start = Timer_getCycles();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        convertECEF2Geodetic(&out, ref[0] + i, ref[1], ref[2]);
+        sink = out.x;
+    }
+    ticks = Timer_getCycles() - start;
+    report("convertECEF2Geodetic", ticks, error, "m");
+
+    // Whole projection, as the COMPAS does it on a Lock
+    start = Timer_getCycles();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        Navigation_getProjectedCoordinate(&out, (float)(i % 360), 80.0f, 4.572f);
+        sink = out.x;
+    }
+    ticks = Timer_getCycles() - start;
+    report("getProjectedCoordinate", ticks, 0.0, "(timing only)");
+
+    return SUCCESS;
+}
+
+#endif
@@ -0,0 +1,445 @@
+/**********************************************************************
+ Module
+   Nvm.c
+
+ Revision
+   1.0.0
+
+ Description
+   Key-value store in the last two pages of program flash.
+
+ Notes
+   The flash is read through KSEG1, uncached, since the prefetch cache
+   could still hold a line from before a write. A word is only written
+   once after an erase, a record's header before its data, and each word
+   is read back to check it took.
+
+   The store array only reserves the pages, so the linker keeps code out
+   of them. It's never read through, the compiler knows it as all 0xFF.
+
+***********************************************************************/
+
+#include <xc.h>
+#include <plib.h>
+#include <sys/kmem.h>
+#include <stdint.h>
+#include "Board.h"
+#include "Nvm.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define PAGE_WORDS          (NVM_PAGE_SIZE / sizeof(uint32_t))
+#define ERASED_WORD         0xFFFFFFFF
+#define NO_PAGE             0xFF
+#define NO_RECORD           0 // word 0 is the page header
+
+#define PAGE_MAGIC          ((uint32_t)'N' | ((uint32_t)'V' << 8))
+#define PAGE_MAGIC_MASK     0xFFFF
+#define PAGE_HEADER(sequence)   (PAGE_MAGIC | ((uint32_t)(sequence) << 16))
+#define PAGE_SEQUENCE(header)   ((uint16_t)((header) >> 16))
+
+#define RECORD_HEADER(key, length, crc) ((uint32_t)(key) \
+    | ((uint32_t)(length) << 8) | ((uint32_t)(crc) << 16))
+#define RECORD_KEY(header)      ((uint8_t)(header))
+#define RECORD_LENGTH(header)   ((uint8_t)((header) >> 8))
+#define RECORD_CRC(header)      ((uint16_t)((header) >> 16))
+#define DATA_WORDS(length)      (((length) + sizeof(uint32_t) - 1) \
+                                    / sizeof(uint32_t))
+
+#define CRC_POLYNOMIAL      0x1021 // CRC-16/CCITT
+#define CRC_INITIAL         0xFFFF
+
+// Uncached word of a page
+#define FLASH_WORD(page, index) (((const volatile uint32_t *)KVA0_TO_KVA1( \
+    NVM_ADDRESS + (page) * NVM_PAGE_SIZE))[index])
+
+/***********************************************************************
+ * PRIVATE VARIABLES                                                   *
+ ***********************************************************************/
+
+// Reserves the pages, erased in the hex file
+static const uint32_t __attribute__((space(prog), address(NVM_ADDRESS),
+    aligned(NVM_PAGE_SIZE), __used__)) store[NVM_PAGES][PAGE_WORDS] = {
+    [0 ... NVM_PAGES - 1] = { [0 ... PAGE_WORDS - 1] = ERASED_WORD } };
+
+static uint8_t active = NO_PAGE; // page in use
+static uint16_t sequence = 0; // of the page in use
+static uint16_t used = 0; // (words) of the page in use, with its header
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static uint16_t addCrc(uint16_t crc, uint8_t data);
+static uint16_t calculateCrc(uint8_t key, const uint8_t *data, uint8_t length);
+static uint8_t readByte(uint8_t page, uint16_t index, uint8_t byte);
+static BOOL isRecordValid(uint8_t page, uint16_t index);
+static uint16_t findRecord(uint8_t key);
+static uint16_t findEnd(uint8_t page);
+static BOOL writeWord(uint8_t page, uint16_t index, uint32_t word);
+static BOOL erasePage(uint8_t page);
+static BOOL appendRecord(uint8_t key, const uint8_t *data, uint8_t length);
+static BOOL compact(uint8_t skipKey);
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+int8_t Nvm_init() {
+    uint8_t page;
+    uint32_t header;
+
+    active = NO_PAGE;
+    for (page = 0; page < NVM_PAGES; page++) {
+        header = FLASH_WORD(page, 0);
+        if ((header & PAGE_MAGIC_MASK) != PAGE_MAGIC)
+            continue;
+        // Newer even across a wrap of the sequence
+        if (active == NO_PAGE
+                || (int16_t)(PAGE_SEQUENCE(header) - sequence) > 0) {
+            active = page;
+            sequence = PAGE_SEQUENCE(header);
+        }
+    }
+
+    if (active == NO_PAGE) {
+        // First boot, or both pages were lost
+        if (!erasePage(0) || !writeWord(0, 0, PAGE_HEADER(0)))
+            return FAILURE;
+        active = 0;
+        sequence = 0;
+    }
+    used = findEnd(active);
+    return SUCCESS;
+}
+
+BOOL Nvm_isReady() {
+    return active != NO_PAGE;
+}
+
+int8_t Nvm_read(NvmKey key, void *data, uint8_t length) {
+    uint16_t index, i;
+    uint8_t *bytes = (uint8_t *)data;
+
+    if (active == NO_PAGE || key >= NVM_KEY_COUNT)
+        return FAILURE;
+    index = findRecord(key);
+    if (index == NO_RECORD
+            || RECORD_LENGTH(FLASH_WORD(active, index)) != length)
+        return FAILURE;
+
+    for (i = 0; i < length; i++)
+        bytes[i] = readByte(active, index + 1, i);
+    return SUCCESS;
+}
+
+int8_t Nvm_write(NvmKey key, const void *data, uint8_t length) {
+    uint16_t index, i;
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    if (active == NO_PAGE || key >= NVM_KEY_COUNT || length == 0)
+        return FAILURE;
+
+    // Already kept, save the flash the wear
+    index = findRecord(key);
+    if (index != NO_RECORD
+            && RECORD_LENGTH(FLASH_WORD(active, index)) == length) {
+        for (i = 0; i < length; i++) {
+            if (readByte(active, index + 1, i) != bytes[i])
+                break;
+        }
+        if (i == length)
+            return SUCCESS;
+    }
+
+    return appendRecord(key, bytes, length)? SUCCESS : FAILURE;
+}
+
+int8_t Nvm_erase(NvmKey key) {
+    if (active == NO_PAGE || key >= NVM_KEY_COUNT)
+        return FAILURE;
+    if (findRecord(key) == NO_RECORD)
+        return SUCCESS;
+    return appendRecord(key, NULL, 0)? SUCCESS : FAILURE;
+}
+
+uint16_t Nvm_getFree() {
+    if (active == NO_PAGE)
+        return 0;
+    return (PAGE_WORDS - used) * sizeof(uint32_t);
+}
+
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: addCrc
+ * @param CRC so far.
+ * @param Next byte.
+ * @return The CRC with the byte.
+ * @remark Bit at a time, the store is only checked at boot and written
+ *  rarely, so a table isn't worth its flash.
+ **********************************************************************/
+static uint16_t addCrc(uint16_t crc, uint8_t data) {
+    uint8_t bit;
+    crc ^= (uint16_t)data << 8;
+    for (bit = 0; bit < 8; bit++)
+        crc = (crc & 0x8000)? (crc << 1) ^ CRC_POLYNOMIAL : crc << 1;
+    return crc;
+}
+
+/**********************************************************************
+ * Function: calculateCrc
+ * @param Key of the record.
+ * @param Its data.
+ * @param Length of the data.
+ * @return CRC of the key, the length and the data.
+ **********************************************************************/
+static uint16_t calculateCrc(uint8_t key, const uint8_t *data,
+        uint8_t length) {
+    uint16_t crc = CRC_INITIAL;
+    uint8_t i;
+    crc = addCrc(crc, key);
+    crc = addCrc(crc, length);
+    for (i = 0; i < length; i++)
+        crc = addCrc(crc, data[i]);
+    return crc;
+}
+
+/**********************************************************************
+ * Function: readByte
+ * @param Page.
+ * @param Word the bytes start at.
+ * @param Byte from there.
+ * @return The byte, little endian within each word.
+ **********************************************************************/
+static uint8_t readByte(uint8_t page, uint16_t index, uint8_t byte) {
+    return (uint8_t)(FLASH_WORD(page, index + byte / sizeof(uint32_t))
+        >> (8 * (byte % sizeof(uint32_t))));
+}
+
+/**********************************************************************
+ * Function: isRecordValid
+ * @param Page.
+ * @param Word the record's header is at.
+ * @return TRUE if the record's data matches the CRC in its header.
+ **********************************************************************/
+static BOOL isRecordValid(uint8_t page, uint16_t index) {
+    uint32_t header = FLASH_WORD(page, index);
+    uint8_t length = RECORD_LENGTH(header), i;
+    uint16_t crc = CRC_INITIAL;
+
+    if (index + 1 + DATA_WORDS(length) > PAGE_WORDS)
+        return FALSE;
+    crc = addCrc(crc, RECORD_KEY(header));
+    crc = addCrc(crc, length);
+    for (i = 0; i < length; i++)
+        crc = addCrc(crc, readByte(page, index + 1, i));
+    return crc == RECORD_CRC(header);
+}
+
+/**********************************************************************
+ * Function: findRecord
+ * @param Key.
+ * @return Word of the newest good record of the key in the page in
+ *  use, or NO_RECORD if there's none or that one erased it.
+ **********************************************************************/
+static uint16_t findRecord(uint8_t key) {
+    uint16_t index = 1, found = NO_RECORD;
+    uint32_t header;
+
+    while (index < used) {
+        header = FLASH_WORD(active, index);
+        if (RECORD_KEY(header) == key && isRecordValid(active, index))
+            found = (RECORD_LENGTH(header) > 0)? index : NO_RECORD;
+        index += 1 + DATA_WORDS(RECORD_LENGTH(header));
+    }
+    return found;
+}
+
+/**********************************************************************
+ * Function: findEnd
+ * @param Page.
+ * @return (words) Used by the page's header and records. A record cut
+ *  short still takes the room its header gave it.
+ **********************************************************************/
+static uint16_t findEnd(uint8_t page) {
+    uint16_t index = 1;
+    uint32_t header;
+
+    while (index < PAGE_WORDS) {
+        header = FLASH_WORD(page, index);
+        if (header == ERASED_WORD)
+            break;
+        index += 1 + DATA_WORDS(RECORD_LENGTH(header));
+    }
+    return (index < PAGE_WORDS)? index : PAGE_WORDS;
+}
+
+/**********************************************************************
+ * Function: writeWord
+ * @param Page.
+ * @param Word in the page.
+ * @param What to write there, erased before.
+ * @return TRUE if it reads back.
+ **********************************************************************/
+static BOOL writeWord(uint8_t page, uint16_t index, uint32_t word) {
+    if (NVMWriteWord((void *)&FLASH_WORD(page, index), word) != 0)
+        return FALSE;
+    return FLASH_WORD(page, index) == word;
+}
+
+/**********************************************************************
+ * Function: erasePage
+ * @param Page.
+ * @return TRUE if it's erased.
+ **********************************************************************/
+static BOOL erasePage(uint8_t page) {
+    return NVMErasePage((void *)&FLASH_WORD(page, 0)) == 0
+        && FLASH_WORD(page, 0) == ERASED_WORD;
+}
+
+/**********************************************************************
+ * Function: appendRecord
+ * @param Key.
+ * @param Data, or NULL with no length to erase the key.
+ * @param Length of the data.
+ * @return TRUE if it's written, copying the page over first if it's full.
+ **********************************************************************/
+static BOOL appendRecord(uint8_t key, const uint8_t *data, uint8_t length) {
+    uint16_t words = 1 + DATA_WORDS(length), i;
+    uint32_t word;
+    uint8_t byte;
+    BOOL isWritten = TRUE;
+
+    if (used + words > PAGE_WORDS) {
+        // The erase only needs the room of keeping the others
+        if (!compact(key))
+            return FALSE;
+        if (length == 0)
+            return TRUE;
+        if (used + words > PAGE_WORDS)
+            return FALSE;
+    }
+
+    if (!writeWord(active, used, RECORD_HEADER(key, length,
+            calculateCrc(key, data, length))))
+        isWritten = FALSE;
+    for (i = 0; isWritten && i < DATA_WORDS(length); i++) {
+        word = ERASED_WORD;
+        for (byte = 0; byte < sizeof(uint32_t)
+                && i * sizeof(uint32_t) + byte < length; byte++) {
+            word &= ~((uint32_t)0xFF << (8 * byte));
+            word |= (uint32_t)data[i * sizeof(uint32_t) + byte] << (8 * byte);
+        }
+        isWritten = writeWord(active, used + 1 + i, word);
+    }
+    // Even cut short, the header already took the room
+    used += words;
+    return isWritten;
+}
+
+/**********************************************************************
+ * Function: compact
+ * @param Key not to copy, it's about to be written.
+ * @return TRUE if the newest good record of every other key is now in
+ *  the other page, and that page is in use.
+ * @remark The header is written last, so until then the old page stays
+ *  the one in use.
+ **********************************************************************/
+static BOOL compact(uint8_t skipKey) {
+    uint8_t to = !active, key;
+    uint16_t index, end = 1, words, i;
+
+    if (!erasePage(to))
+        return FALSE;
+    for (key = 0; key < NVM_KEY_COUNT; key++) {
+        if (key == skipKey || (index = findRecord(key)) == NO_RECORD)
+            continue;
+        words = 1 + DATA_WORDS(RECORD_LENGTH(FLASH_WORD(active, index)));
+        for (i = 0; i < words; i++) {
+            if (!writeWord(to, end + i, FLASH_WORD(active, index + i)))
+                return FALSE;
+        }
+        end += words;
+    }
+    if (!writeWord(to, 0, PAGE_HEADER(sequence + 1)))
+        return FALSE;
+
+    active = to;
+    sequence++;
+    used = end;
+    return TRUE;
+}
+
+//#define NVM_TEST
+#ifdef NVM_TEST
+
+// Overwrites NVM_KEY_TRIPOD_HEIGHT, and takes it out after
+#include <stdio.h>
+#include "Serial.h"
+#include "Timer.h"
+
+#define TEST_WRITES     2000 // enough to copy the page over a few times
+
+int main() {
+    uint32_t start, cycles, maxCycles = 0, value, readValue;
+    uint16_t i, lastSequence, compactions = 0;
+    BOOL isGood = TRUE;
+
+    Board_init();
+    Serial_init();
+    Timer_init();
+
+    start = Timer_getCycles();
+    if (Nvm_init() != SUCCESS) {
+        printf("FAILED to set up the store.\n");
+        return FAILURE;
+    }
+    printf("Store is up in %lu us, page %d, sequence %u, %u bytes free.\n",
+        (unsigned long)TIMER_CYCLES_TO_MICROS(Timer_getCycles() - start),
+        active, sequence, Nvm_getFree());
+
+    lastSequence = sequence;
+    for (i = 0; i < TEST_WRITES && isGood; i++) {
+        value = 0x5A000000 | i;
+        start = Timer_getCycles();
+        if (Nvm_write(NVM_KEY_TRIPOD_HEIGHT, &value, sizeof(value)) != SUCCESS)
+            isGood = FALSE;
+        cycles = Timer_getCycles() - start;
+        if (sequence != lastSequence) {
+            compactions++;
+            lastSequence = sequence;
+        }
+        else if (cycles > maxCycles) {
+            maxCycles = cycles;
+        }
+        if (Nvm_read(NVM_KEY_TRIPOD_HEIGHT, &readValue, sizeof(readValue))
+                != SUCCESS || readValue != value)
+            isGood = FALSE;
+    }
+    printf("%u writes, %u copies, slowest write without a copy %lu us.\n",
+        i, compactions, (unsigned long)TIMER_CYCLES_TO_MICROS(maxCycles));
+
+    // Same data, so nothing written
+    i = used;
+    Nvm_write(NVM_KEY_TRIPOD_HEIGHT, &value, sizeof(value));
+    if (used != i)
+        isGood = FALSE;
+
+    Nvm_erase(NVM_KEY_TRIPOD_HEIGHT);
+    if (Nvm_read(NVM_KEY_TRIPOD_HEIGHT, &readValue, sizeof(readValue))
+            == SUCCESS)
+        isGood = FALSE;
+
+    printf(isGood? "Passed.\n" : "FAILED.\n");
+    while (1)
+        ;
+
+    return SUCCESS;
+}
+
+#endif
@@ -22,6 +22,8 @@
  ******************************************************************************/
 
 #define F_PB Board_GetPBClock()
+#define PERIOD_MAX 0x10000 // Timer2 is 16 bits
+#define CHANNEL_MASK ((1 << PWM_CHANNELS) - 1)
 //#define DEBUG_VERBOSE
 #ifdef DEBUG_VERBOSE
     #define dbprintf(...) printf(__VA_ARGS__)
@@ -29,6 +31,8 @@
     #define dbprintf(...)
 #endif
 
+#define mPWMIntEnable(e) mT2IntEnable(e)
+
 
 /*******************************************************************************
  * PRIVATE VARIABLES                                                            *
@@ -36,6 +40,20 @@
 static unsigned char SystemActiveFlag;
 static unsigned int usedChannels;
 static volatile unsigned int * const Duty_Registers[] = {&OC1RS, &OC2RS, &OC3RS, &OC4RS, &OC5RS};
+static unsigned int Resolution;
+
+// Latched by the Timer2 interrupt, see PWM_setDutyCycles
+static unsigned int Targets[PWM_CHANNELS];
+static unsigned int Outputs[PWM_CHANNELS];
+static unsigned int RateLimits[PWM_CHANNELS];
+static volatile unsigned int PendingChannels;
+
+static const struct {
+    unsigned int Divide, Bits;
+} Prescalers[] = {
+    {1, T2_PS_1_1}, {2, T2_PS_1_2}, {4, T2_PS_1_4}, {8, T2_PS_1_8},
+    {16, T2_PS_1_16}, {32, T2_PS_1_32}, {64, T2_PS_1_64}, {256, T2_PS_1_256}
+};
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                           *
@@ -63,14 +81,26 @@ static volatile unsigned int * const Duty_Registers[] = {&OC1RS, &OC2RS, &OC3RS,
  Max Dunne, 2011.11.12
  ****************************************************************************/
 char PWM_init(unsigned char Channels, unsigned int Period) {
-    if ((Channels < 1) || (Channels > 0x1F) || (usedChannels != 0))
+    unsigned int i, Ticks;
+    if ((Channels < 1) || (Channels > 0x1F) || (usedChannels != 0) || (Period == 0))
+        return ERROR;
+    // Smallest prescaler the period fits in, for the most steps of duty
+    for (i = 0; i < sizeof(Prescalers) / sizeof(Prescalers[0]) - 1; i++) {
+        if (F_PB / Prescalers[i].Divide / Period <= PERIOD_MAX)
+            break;
+    }
+    Ticks = F_PB / Prescalers[i].Divide / Period;
+    if (Ticks > PERIOD_MAX)
+        Ticks = PERIOD_MAX;
+    if (Ticks < 2)
         return ERROR;
-    if (Period <= 1000) {
-        OpenTimer2(T2_ON | T2_PS_1_32, F_PB / 32 / Period);
-        dbprintf("Period less than 1KHz, setting prescaler to 32");
-    } else {
-        OpenTimer2(T2_ON | T2_PS_1_1, F_PB / Period);
-        dbprintf("Period greater than 1KHz, setting prescaler to 1");
+    OpenTimer2(T2_ON | Prescalers[i].Bits, Ticks - 1);
+    ConfigIntTimer2(T2_INT_OFF | T2_INT_PRIOR_5);
+    dbprintf("Prescaler %u, %u ticks a period\r\n", Prescalers[i].Divide, Ticks);
+    Resolution = Ticks;
+    PendingChannels = 0;
+    for (i = 0; i < PWM_CHANNELS; i++) {
+        Targets[i] = Outputs[i] = RateLimits[i] = 0;
     }
     usedChannels = Channels;
     if (PWM_PORTZ06 & Channels) {
@@ -93,6 +123,7 @@ char PWM_init(unsigned char Channels, unsigned int Period) {
         OpenOC5(OC_ON | OC_TIMER2_SRC | OC_PWM_FAULT_PIN_DISABLE, 0, 0);
         dbprintf("Port X11 Initialized\r\n");
     }
+    return SUCCESS;
 }
 
 /****************************************************************************
@@ -116,20 +147,111 @@ char PWM_init(unsigned char Channels, unsigned int Period) {
  ****************************************************************************/
 
 char PWM_setDutyCycle(char Channel, unsigned int Duty) {
-    unsigned int ScaledDuty = 0;
-    unsigned int TranslatedChannel = 0;
-    if ((Duty < 0 || Duty > 1000) || (Channel < 1 || Channel > 0x1F) || !(Channel & usedChannels)) {
+    unsigned int Duties[PWM_CHANNELS];
+    if ((Duty > MAX_PWM) || (Channel < 1 || Channel > 0x1F)
+            || (Channel & (Channel - 1))) {
+        return ERROR;
+    }
+    Duties[PWM_INDEX(Channel)] = (Resolution * Duty) / MAX_PWM;
+    return PWM_setDutyCycles(Channel, Duties);
+}
+
+/****************************************************************************
+ Function
+ PWM_setDutyCycles
+
+ Parameters
+    Channels: #defined PWM_PORTxxx OR'd together
+    Duties: duty of each channel in ticks (0-PWM_getResolution()), at
+        PWM_INDEX of the channel, other entries are not read
+
+ Returns
+     SUCCESS or ERROR
+
+ Description
+    Stages the duty cycles of several channels to change together
+ Notes
+    Writing OCxRS straight away can land either side of a period boundary,
+    so two channels set one after the other may change a period apart.
+    Instead the duties are staged and the Timer2 interrupt, which only runs
+    while there is something to latch, copies them into the OCxRS registers
+    just after a boundary. That leaves the whole period before the hardware
+    loads them into OCxR, all at the same boundary. A channel with a rate
+    limit moves toward its duty by at most that much a period instead.
+
+ ****************************************************************************/
+char PWM_setDutyCycles(unsigned char Channels, const unsigned int *Duties) {
+    unsigned int i;
+    if ((Channels < 1) || (Channels > 0x1F) || ((Channels & usedChannels) != Channels)) {
+        return ERROR;
+    }
+    for (i = 0; i < PWM_CHANNELS; i++) {
+        if ((Channels & (1 << i)) && (Duties[i] > Resolution))
+            return ERROR;
+    }
+    mPWMIntEnable(0);
+    for (i = 0; i < PWM_CHANNELS; i++) {
+        if (Channels & (1 << i))
+            Targets[i] = Duties[i];
+    }
+    // A flag left from periods ago would latch part way through this one
+    if (PendingChannels == 0)
+        mT2ClearIntFlag();
+    PendingChannels |= Channels;
+    mPWMIntEnable(1);
+    return SUCCESS;
+}
+
+/****************************************************************************
+ Function
+ PWM_setRateLimit
+
+ Parameters
+    Channels: #defined PWM_PORTxxx OR'd together
+    Limit: most ticks the duty can move in one period, 0 for no limit
+
+ Returns
+     SUCCESS or ERROR
+
+ Description
+    Limits how fast the duty of channels can change
+ Notes
+    The Timer2 interrupt runs every period while a limited channel is
+    still on its way, so a limit too small at a high frequency costs time.
+
+ ****************************************************************************/
+char PWM_setRateLimit(unsigned char Channels, unsigned int Limit) {
+    unsigned int i;
+    if ((Channels < 1) || (Channels > 0x1F) || ((Channels & usedChannels) != Channels)) {
         return ERROR;
     }
-    ScaledDuty = ((PR2 + 1) * Duty) / MAX_PWM;
-    while (Channel > 1) {
-        Channel >>= 1;
-        TranslatedChannel++;
+    mPWMIntEnable(0);
+    for (i = 0; i < PWM_CHANNELS; i++) {
+        if (Channels & (1 << i))
+            RateLimits[i] = Limit;
     }
-    dbprintf("Translated Channel is %d and Scaled Duty is %d\r\n",TranslatedChannel,ScaledDuty);
-    *Duty_Registers[TranslatedChannel] = ScaledDuty;
+    mPWMIntEnable(PendingChannels != 0);
     return SUCCESS;
+}
+
+/****************************************************************************
+ Function
+ PWM_getResolution
+
+ Parameters
+    None.
+
+ Returns
+     Ticks in a period, the duty of a channel that is always on
 
+ Description
+    Number of steps of duty at the frequency given to PWM_init
+ Notes
+     40000 at 1KHz, 2000 at 20KHz.
+
+ ****************************************************************************/
+unsigned int PWM_getResolution(void) {
+    return Resolution;
 }
 
 /****************************************************************************
@@ -152,6 +274,8 @@ char PWM_setDutyCycle(char Channel, unsigned int Duty) {
     Max Dunne, 2011.11.14
  ****************************************************************************/
 void PWM_end(void) {
+    mPWMIntEnable(0);
+    PendingChannels = 0;
     CloseTimer2();
     CloseOC1();
     CloseOC2();
@@ -162,6 +286,45 @@ void PWM_end(void) {
 
 }
 
+/****************************************************************************
+ Function
+     Timer2IntHandler
+
+ Parameters
+     None.
+
+ Returns
+     None
+
+ Description
+     Latches the staged duties just after a period boundary.
+
+ Notes
+     Turns itself off once every channel has reached its duty.
+
+ ****************************************************************************/
+void __ISR(_TIMER_2_VECTOR, ipl5) Timer2IntHandler(void) {
+    unsigned int i, Pending = PendingChannels, Distance;
+    mT2ClearIntFlag();
+    for (i = 0; i < PWM_CHANNELS; i++) {
+        if (!(Pending & (1 << i)))
+            continue;
+        Distance = (Targets[i] > Outputs[i])? Targets[i] - Outputs[i] : Outputs[i] - Targets[i];
+        if (RateLimits[i] == 0 || Distance <= RateLimits[i])
+            Outputs[i] = Targets[i];
+        else if (Targets[i] > Outputs[i])
+            Outputs[i] += RateLimits[i];
+        else
+            Outputs[i] -= RateLimits[i];
+        *Duty_Registers[i] = Outputs[i];
+        if (Outputs[i] == Targets[i])
+            Pending &= ~(1 << i);
+    }
+    PendingChannels = Pending;
+    if (Pending == 0)
+        mPWMIntEnable(0);
+}
+
 
 
 #define PWM_TEST
@@ -9,14 +9,20 @@
    This is a FIFO queue whose items are pointers to anything.
    
  Notes
+   With QUEUE_RING the items sit in an array in the QUEUE, front is the
+   index of the oldest and the rest follow it around the end.
+
+   Queues from Queue_create are taken from a pool, the same as items.
 
  History
  When           Who         What/Why
  -------------- ---         --------
  12-8-12 12:33  dagoodma    Created file.
+ 10-14-26                   Ring of items, queues from a static pool.
 ***********************************************************************/
 
 #include <stdlib.h>
+#include <plib.h>
 #include "Error.h"
 #include "Queue.h"
 #include "Util.h"
@@ -26,6 +32,8 @@
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 
+static QUEUE pool[QUEUE_POOL_SIZE];
+
 /**********************************************************************
  * PRIVATE FUNCTIONS                                                  *
  **********************************************************************/
@@ -43,18 +51,41 @@
  * @remark A Queue is actually a pointer to a QUEUE.
  **********************************************************************/
 Queue Queue_create() {
-    Queue q;
-    q = (Queue) malloc(sizeof(QUEUE));
+    Queue q = NULL;
+    uint8_t n;
+    unsigned int intStatus = INTDisableInterrupts();
+    for (n = 0; n < QUEUE_POOL_SIZE; n++) {
+        if (!pool[n].isPooled) {
+            q = &pool[n];
+            q->isPooled = TRUE;
+            break;
+        }
+    }
+    INTRestoreInterrupts(intStatus);
 
     if (q == NULL) {
         error(ERROR_NO_MEMORY);
         return NULL;
     }
 
+    Queue_init(q);
+    return(q);
+}
+
+/**********************************************************************
+ * Function: Queue_init()
+ * @param A QUEUE that wasn't made by Queue_create.
+ * @return none
+ * @remark Empties it, without destroying what was in it.
+ **********************************************************************/
+void Queue_init(Queue q) {
     q->count = 0;
+#ifdef QUEUE_RING
+    q->front = 0;
+#else
     q->front = NULL;
     q->last = NULL;
-    return(q);
+#endif
 }
 
 /**********************************************************************
@@ -66,7 +97,7 @@ Queue Queue_create() {
 void Queue_destroy(Queue q) { 
     Queue_clear(q);
 
-    free(q);
+    q->isPooled = FALSE;
 }
 
 /**********************************************************************
@@ -95,8 +126,18 @@ bool Queue_isEmpty (Queue q) { return(q->count == 0); }
  * @remark Adds the item to the Queue.
  **********************************************************************/
 bool Queue_enqueue (Queue q, Item item) {
-    if (Queue_isFull(q))
+    unsigned int intStatus = INTDisableInterrupts();
+    if (Queue_isFull(q)) {
+        INTRestoreInterrupts(intStatus);
         return FAILURE;
+    }
+
+#ifdef QUEUE_RING
+    uint8_t back = q->front + q->count;
+    if (back >= QUEUE_MAX_COUNT)
+        back -= QUEUE_MAX_COUNT;
+    q->item[back] = item;
+#else
 
     // Clear the item's next and last, just incase
     Item_clearNext(item);
@@ -111,12 +152,10 @@ bool Queue_enqueue (Queue q, Item item) {
         Item_setLast(q->last,item);
         q->last = item;
     }
+#endif
 
     q->count += 1;
-    //q->item[(q->count)++] = item;
-
-    
-
+    INTRestoreInterrupts(intStatus);
     return SUCCESS;
 }
 
@@ -127,9 +166,17 @@ bool Queue_enqueue (Queue q, Item item) {
  * @remark Removes the item at the front (bottom) of the queue.
  **********************************************************************/
 Item Queue_dequeue (Queue q) {
-    if (Queue_isEmpty(q))
+    unsigned int intStatus = INTDisableInterrupts();
+    if (Queue_isEmpty(q)) {
+        INTRestoreInterrupts(intStatus);
         return NULL;
+    }
     
+#ifdef QUEUE_RING
+    Item item = q->item[q->front];
+    if (++(q->front) == QUEUE_MAX_COUNT)
+        q->front = 0;
+#else
     Item item = q->front;
     Item next = Item_getLast(item);
     if (item == q->last || next == NULL) {
@@ -141,11 +188,10 @@ Item Queue_dequeue (Queue q) {
         q->front = next;
         Item_clearLast(item);
     }
+#endif
 
     q->count -= 1;
-
-    //Item item = q->item[0];
-    //q->item[(q->count)--] = '\0';
+    INTRestoreInterrupts(intStatus);
     return item;
 }
 
@@ -189,7 +235,11 @@ uint8_t Queue_getCount (Queue q) {
  * @remark none
  **********************************************************************/
 Item Queue_peek(Queue q) {
+#ifdef QUEUE_RING
+    return Queue_isEmpty(q)? NULL : q->item[q->front];
+#else
     return q->front;
+#endif
 }
 
 
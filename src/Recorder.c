@@ -0,0 +1,512 @@
+/**********************************************************************
+ Module
+   Recorder.c
+
+ Revision
+   1.0.0
+
+ Description
+   Binary flight recorder on a 25 series SPI flash.
+
+ Notes
+   The pages in RAM are a ring. One is filled while the ones in front of
+   it wait to be programmed, the oldest of them a few bytes a call. The
+   page being filled is only closed when a record doesn't fit in it, so
+   at least one page has to be free to move on to, otherwise the record
+   is dropped. A page gets its header with its first record, so one that
+   never had any takes no room in the flash.
+
+   The end of the log is found by a binary search over the first byte of
+   each page, since the pages are programmed in order from an erased
+   chip and are 0xFF until then.
+
+***********************************************************************/
+
+#include <xc.h>
+#include <plib.h>
+#include <stdint.h>
+#include <string.h>
+#include "Board.h"
+#include "Ports.h"
+#include "Timer.h"
+#include "Recorder.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define SPI_CHANNEL         SPI_CHANNEL2
+#define CS_TRIS             PORTX11_TRIS // RD4, pin 10
+#define CS_LAT              PORTX11_LAT
+
+// Commands every 25 series part has
+#define COMMAND_WRITE_ENABLE    0x06
+#define COMMAND_PAGE_PROGRAM    0x02
+#define COMMAND_READ            0x03
+#define COMMAND_READ_STATUS     0x05
+#define COMMAND_CHIP_ERASE      0xC7
+#define COMMAND_JEDEC_ID        0x9F
+#define STATUS_BUSY             0x01
+
+#define PAGE_MAGIC_0            'R'
+#define PAGE_MAGIC_1            'C'
+#define ERASED                  0xFF
+#define PAGES                   (RECORDER_FLASH_SIZE / RECORDER_PAGE_SIZE)
+
+#if RECORDER_PAGE_COUNT < 2
+#error "RECORDER_PAGE_COUNT has to be at least two"
+#endif
+
+#define DEGREES_TO_CENTI(x)     ((int32_t)((x) * 100.0f))
+#define CLAMP(x, low, high)     (((x) < (low))? (low) : (((x) > (high))? (high) : (x)))
+
+typedef enum {
+    STATE_OFF, // no chip
+    STATE_IDLE,
+    STATE_PROGRAM, // clocking out a page
+    STATE_WAIT, // for the page program
+    STATE_ERASE, // waiting out a chip erase
+    STATE_FULL
+} RecorderState;
+
+/***********************************************************************
+ * PRIVATE VARIABLES                                                   *
+ ***********************************************************************/
+
+static uint8_t page[RECORDER_PAGE_COUNT][RECORDER_PAGE_SIZE];
+static uint8_t filling = 0, flushing = 0; // ring of pages
+static uint8_t pending = 0; // closed, waiting to be programmed
+static uint16_t used = 0; // (bytes) of the page being filled
+static uint16_t sent = 0; // (bytes) of the page being programmed
+
+static RecorderState state = STATE_OFF;
+static BOOL wantErase = FALSE;
+static uint32_t address = 0;
+static uint16_t session = 1;
+static uint32_t sessionPage = 0;
+static uint16_t unreported = 0; // dropped since the last RECORD_DROPPED
+static RecorderStats stats;
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static uint8_t transfer(uint8_t data);
+static void select();
+static void deselect();
+static void sendCommand(uint8_t command);
+static void sendAddress(uint32_t at);
+static uint8_t readStatus();
+static void readFlash(uint32_t at, uint8_t *buffer, uint16_t length);
+static void findEnd();
+static int8_t writeRecord(uint8_t type, uint32_t time, const uint8_t *payload,
+    uint8_t length);
+static BOOL closePage();
+static uint8_t *putU16(uint8_t *out, uint16_t value);
+static uint8_t *putU32(uint8_t *out, uint32_t value);
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+int8_t Recorder_init() {
+    uint8_t manufacturer;
+
+    CS_TRIS = OUTPUT;
+    CS_LAT = 1;
+    SpiChnOpen(SPI_CHANNEL, SPI_OPEN_MSTEN | SPI_OPEN_MODE8 | SPI_OPEN_CKE_REV
+        | SPI_OPEN_ON, Board_GetPBClock() / RECORDER_SPI_CLOCK);
+
+    filling = flushing = pending = 0;
+    used = sent = 0;
+    unreported = 0;
+    wantErase = FALSE;
+    memset(&stats, 0, sizeof(stats));
+
+    select();
+    transfer(COMMAND_JEDEC_ID);
+    manufacturer = transfer(0);
+    transfer(0);
+    transfer(0);
+    deselect();
+    if (manufacturer == 0x00 || manufacturer == ERASED) {
+        state = STATE_OFF;
+        return FAILURE;
+    }
+
+    while (readStatus() & STATUS_BUSY)
+        ;
+    findEnd();
+    state = (address < RECORDER_FLASH_SIZE)? STATE_IDLE : STATE_FULL;
+    return SUCCESS;
+}
+
+void Recorder_runSM() {
+    uint8_t *data;
+    uint16_t end;
+
+    switch (state) {
+        case STATE_IDLE:
+            if (wantErase) {
+                wantErase = FALSE;
+                filling = flushing = pending = 0;
+                used = 0;
+                sendCommand(COMMAND_WRITE_ENABLE);
+                sendCommand(COMMAND_CHIP_ERASE);
+                state = STATE_ERASE;
+            }
+            else if (pending > 0) {
+                if (address >= RECORDER_FLASH_SIZE) {
+                    state = STATE_FULL;
+                    break;
+                }
+                sendCommand(COMMAND_WRITE_ENABLE);
+                select();
+                transfer(COMMAND_PAGE_PROGRAM);
+                sendAddress(address);
+                sent = 0;
+                state = STATE_PROGRAM;
+            }
+            break;
+
+        case STATE_PROGRAM:
+            data = page[flushing];
+            end = sent + RECORDER_STEP_BYTES;
+            if (end > RECORDER_PAGE_SIZE)
+                end = RECORDER_PAGE_SIZE;
+            while (sent < end)
+                transfer(data[sent++]);
+            if (sent == RECORDER_PAGE_SIZE) {
+                deselect();
+                state = STATE_WAIT;
+            }
+            break;
+
+        case STATE_WAIT:
+            if (readStatus() & STATUS_BUSY)
+                break;
+            flushing = (flushing + 1) % RECORDER_PAGE_COUNT;
+            pending--;
+            address += RECORDER_PAGE_SIZE;
+            stats.pages++;
+            state = STATE_IDLE;
+            break;
+
+        case STATE_ERASE:
+            if (readStatus() & STATUS_BUSY)
+                break;
+            address = 0;
+            session = 1;
+            sessionPage = 0;
+            state = STATE_IDLE;
+            break;
+
+        case STATE_FULL:
+            if (wantErase)
+                state = STATE_IDLE;
+            break;
+
+        case STATE_OFF:
+        default:
+            break;
+    }
+}
+
+int8_t Recorder_write(uint8_t type, const void *payload, uint8_t length) {
+    return writeRecord(type, get_time(), (const uint8_t *)payload, length);
+}
+
+int8_t Recorder_recordGps(uint32_t iTOW, int32_t latitude, int32_t longitude,
+        int32_t altitude, int32_t north, int32_t east) {
+    uint8_t payload[24], *out = payload;
+    out = putU32(out, iTOW);
+    out = putU32(out, (uint32_t)latitude);
+    out = putU32(out, (uint32_t)longitude);
+    out = putU32(out, (uint32_t)altitude);
+    out = putU32(out, (uint32_t)north);
+    out = putU32(out, (uint32_t)east);
+    return writeRecord(RECORD_GPS, get_time(), payload, out - payload);
+}
+
+int8_t Recorder_recordAngles(float pitch, float yaw) {
+    uint8_t payload[4], *out = payload;
+    out = putU16(out, (uint16_t)CLAMP(DEGREES_TO_CENTI(pitch), -32767, 32767));
+    out = putU16(out, (uint16_t)CLAMP(DEGREES_TO_CENTI(yaw), -32767, 32767));
+    return writeRecord(RECORD_ANGLES, get_time(), payload, out - payload);
+}
+
+int8_t Recorder_recordImu(int16_t x, int16_t y, int16_t z, float heading) {
+    uint8_t payload[8], *out = payload;
+    out = putU16(out, (uint16_t)x);
+    out = putU16(out, (uint16_t)y);
+    out = putU16(out, (uint16_t)z);
+    out = putU16(out, (uint16_t)CLAMP(DEGREES_TO_CENTI(heading), 0, 35999));
+    return writeRecord(RECORD_IMU, get_time(), payload, out - payload);
+}
+
+int8_t Recorder_recordThermal(float heading, float elevation, float peak,
+        uint8_t pixels) {
+    uint8_t payload[7], *out = payload;
+    out = putU16(out, (uint16_t)CLAMP(DEGREES_TO_CENTI(heading), 0, 35999));
+    out = putU16(out, (uint16_t)CLAMP(DEGREES_TO_CENTI(elevation), -32767, 32767));
+    out = putU16(out, (uint16_t)CLAMP(DEGREES_TO_CENTI(peak), -32767, 32767));
+    *out++ = pixels;
+    return writeRecord(RECORD_THERMAL, get_time(), payload, out - payload);
+}
+
+int8_t Recorder_recordLink(uint8_t isConnected, uint8_t loss,
+        uint8_t peerLoss, uint16_t rtt, uint16_t jitter) {
+    uint8_t payload[7], *out = payload;
+    *out++ = isConnected;
+    *out++ = loss;
+    *out++ = peerLoss;
+    out = putU16(out, rtt);
+    out = putU16(out, jitter);
+    return writeRecord(RECORD_LINK, get_time(), payload, out - payload);
+}
+
+int8_t Recorder_recordEvent(const ErrorEvent *event) {
+    uint8_t payload[4], *out = payload;
+    *out++ = event->module;
+    *out++ = event->code;
+    out = putU16(out, event->arg);
+    return writeRecord(RECORD_EVENT, event->time, payload, out - payload);
+}
+
+void Recorder_flush() {
+    if (used > 0)
+        closePage();
+}
+
+int8_t Recorder_erase() {
+    if (state == STATE_OFF)
+        return FAILURE;
+    wantErase = TRUE;
+    return SUCCESS;
+}
+
+int8_t Recorder_read(uint32_t at, uint8_t *buffer, uint16_t length) {
+    if (state != STATE_IDLE && state != STATE_FULL)
+        return FAILURE;
+    readFlash(at, buffer, length);
+    return SUCCESS;
+}
+
+void Recorder_getStats(RecorderStats *copy) {
+    *copy = stats;
+    copy->address = address;
+    copy->session = session;
+    copy->isReady = (state != STATE_OFF && state != STATE_FULL);
+    copy->isErasing = (state == STATE_ERASE || wantErase);
+}
+
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+static uint8_t transfer(uint8_t data) {
+    SpiChnPutC(SPI_CHANNEL, data);
+    return (uint8_t)SpiChnGetC(SPI_CHANNEL);
+}
+
+static void select() {
+    CS_LAT = 0;
+}
+
+static void deselect() {
+    while (SpiChnIsBusy(SPI_CHANNEL))
+        ;
+    CS_LAT = 1;
+}
+
+static void sendCommand(uint8_t command) {
+    select();
+    transfer(command);
+    deselect();
+}
+
+static void sendAddress(uint32_t at) {
+    transfer((uint8_t)(at >> 16));
+    transfer((uint8_t)(at >> 8));
+    transfer((uint8_t)at);
+}
+
+static uint8_t readStatus() {
+    uint8_t status;
+    select();
+    transfer(COMMAND_READ_STATUS);
+    status = transfer(0);
+    deselect();
+    return status;
+}
+
+static void readFlash(uint32_t at, uint8_t *buffer, uint16_t length) {
+    select();
+    transfer(COMMAND_READ);
+    sendAddress(at);
+    while (length-- > 0)
+        *buffer++ = transfer(0);
+    deselect();
+}
+
+/**********************************************************************
+ * Function: findEnd
+ * @return None
+ * @remark Sets the address to the first erased page, and the session to
+ *  one after the session of the page before it.
+ **********************************************************************/
+static void findEnd() {
+    uint32_t low = 0, high = PAGES; // first erased is in [low, high]
+    uint8_t header[4];
+
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        readFlash(middle * RECORDER_PAGE_SIZE, header, 1);
+        if (header[0] == ERASED)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    address = low * RECORDER_PAGE_SIZE;
+    session = 1;
+    sessionPage = 0;
+    if (low > 0) {
+        readFlash(address - RECORDER_PAGE_SIZE, header, sizeof(header));
+        if (header[0] == PAGE_MAGIC_0 && header[1] == PAGE_MAGIC_1)
+            session = (header[2] | ((uint16_t)header[3] << 8)) + 1;
+    }
+}
+
+/**********************************************************************
+ * Function: writeRecord
+ * @param Type.
+ * @param (ms) Time stamp.
+ * @param Payload.
+ * @param Its length.
+ * @return SUCCESS, or FAILURE if it was dropped.
+ * @remark Moves on to the next page when it doesn't fit in this one, and
+ *  puts a RECORD_DROPPED in front of it if anything was lost.
+ **********************************************************************/
+static int8_t writeRecord(uint8_t type, uint32_t time, const uint8_t *payload,
+        uint8_t length) {
+    uint16_t needed = RECORDER_RECORD_HEADER + length;
+    uint8_t *out;
+
+    if (unreported > 0 && type != RECORD_DROPPED) {
+        uint8_t count[2];
+        putU16(count, unreported);
+        if (writeRecord(RECORD_DROPPED, time, count, sizeof(count)) == SUCCESS)
+            unreported = 0;
+    }
+    if (state == STATE_OFF || state == STATE_ERASE || state == STATE_FULL
+            || wantErase || length > RECORDER_PAYLOAD_MAX
+            || (unreported > 0 && type != RECORD_DROPPED)
+            || (used + needed > RECORDER_PAGE_SIZE && !closePage())) {
+        stats.dropped++;
+        if (type != RECORD_DROPPED && unreported < 0xFFFF)
+            unreported++;
+        return FAILURE;
+    }
+
+    out = &page[filling][used];
+    if (used == 0) {
+        *out++ = PAGE_MAGIC_0;
+        *out++ = PAGE_MAGIC_1;
+        out = putU16(out, session);
+        out = putU32(out, sessionPage++);
+    }
+    *out++ = type;
+    *out++ = length;
+    out = putU32(out, time);
+    memcpy(out, payload, length);
+    used = (out + length) - page[filling];
+    stats.records++;
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: closePage
+ * @return TRUE if there was a free page to move on to.
+ * @remark Pads the rest of the page with erased bytes, which the flash
+ *  leaves alone.
+ **********************************************************************/
+static BOOL closePage() {
+    if (pending >= RECORDER_PAGE_COUNT - 1)
+        return FALSE;
+    memset(&page[filling][used], ERASED, RECORDER_PAGE_SIZE - used);
+    filling = (filling + 1) % RECORDER_PAGE_COUNT;
+    pending++;
+    used = 0;
+    return TRUE;
+}
+
+static uint8_t *putU16(uint8_t *out, uint16_t value) {
+    *out++ = (uint8_t)value;
+    *out++ = (uint8_t)(value >> 8);
+    return out;
+}
+
+static uint8_t *putU32(uint8_t *out, uint32_t value) {
+    out = putU16(out, (uint16_t)value);
+    return putU16(out, (uint16_t)(value >> 16));
+}
+
+//#define RECORDER_TEST
+#ifdef RECORDER_TEST
+
+#include <stdio.h>
+#include "Serial.h"
+
+#define RECORD_PERIOD   10 // (ms)
+#define PRINT_DELAY     5000
+
+// Records fake angles at 100 Hz, prints the counts, dumps the log with 'd'
+int main() {
+    RecorderStats recorder;
+    uint8_t buffer[RECORDER_PAGE_SIZE];
+    uint32_t at, next;
+    uint16_t i;
+    float yaw = 0.0f;
+
+    Board_init();
+    Serial_init();
+    Timer_init();
+    if (Recorder_init() != SUCCESS)
+        printf("No flash chip.\n");
+    Recorder_getStats(&recorder);
+    printf("Recorder test, session %u at 0x%lx\n", recorder.session,
+        (unsigned long)recorder.address);
+
+    next = get_time();
+    Timer_new(TIMER_TEST, PRINT_DELAY);
+    while (1) {
+        Recorder_runSM();
+        if ((int32_t)(get_time() - next) >= 0) {
+            next += RECORD_PERIOD;
+            yaw = (yaw >= 359.0f)? 0.0f : yaw + 1.0f;
+            Recorder_recordAngles(10.0f, yaw);
+        }
+        if (Timer_isExpired(TIMER_TEST)) {
+            Timer_new(TIMER_TEST, PRINT_DELAY);
+            Recorder_getStats(&recorder);
+            printf("%lu records, %lu dropped, %lu pages, at 0x%lx\n",
+                (unsigned long)recorder.records, (unsigned long)recorder.dropped,
+                (unsigned long)recorder.pages, (unsigned long)recorder.address);
+        }
+        if (Serial_getChar() == 'd') {
+            Recorder_flush();
+            while (pending > 0)
+                Recorder_runSM();
+            Recorder_getStats(&recorder);
+            for (at = 0; at < recorder.address; at += RECORDER_PAGE_SIZE) {
+                Recorder_read(at, buffer, RECORDER_PAGE_SIZE);
+                for (i = 0; i < RECORDER_PAGE_SIZE; i++)
+                    printf("%02x", buffer[i]);
+                printf("\n");
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+#endif
@@ -0,0 +1,171 @@
+/**********************************************************************
+ Module
+   RingBuffer.c
+
+ Revision
+   1.0.0
+
+ Description
+   Lock-free single-producer/single-consumer byte ring buffer with a
+   power of two capacity and free-running indices.
+
+ Notes
+   Each index has one writer. The producer fills the storage before it
+   moves tail, and the consumer reads before it moves head; the barrier
+   keeps the compiler from reordering those. The PIC32 core does not
+   reorder its own loads and stores, so nothing more is needed there.
+
+***********************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "Board.h"
+#include "RingBuffer.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define INDEX(rb, i)    ((i) & (rb)->mask)
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+void RingBuffer_init(RingBuffer *rb, uint8_t *storage, uint16_t size) {
+    rb->buffer = storage;
+    rb->mask = size - 1;
+    RingBuffer_makeEmpty(rb);
+}
+
+void RingBuffer_makeEmpty(RingBuffer *rb) {
+    rb->head = 0;
+    rb->tail = 0;
+    rb->overflowCount = 0;
+}
+
+uint16_t RingBuffer_getLength(const RingBuffer *rb) {
+    return (uint16_t)(rb->tail - rb->head);
+}
+
+uint16_t RingBuffer_getSpace(const RingBuffer *rb) {
+    return (uint16_t)(rb->mask + 1 - RingBuffer_getLength(rb));
+}
+
+uint16_t RingBuffer_getCapacity(const RingBuffer *rb) {
+    return rb->mask + 1;
+}
+
+char RingBuffer_isEmpty(const RingBuffer *rb) {
+    return (rb->tail == rb->head)? TRUE : FALSE;
+}
+
+char RingBuffer_isFull(const RingBuffer *rb) {
+    return (RingBuffer_getLength(rb) > rb->mask)? TRUE : FALSE;
+}
+
+uint8_t RingBuffer_getOverflow(const RingBuffer *rb) {
+    return rb->overflowCount;
+}
+
+int8_t RingBuffer_put(RingBuffer *rb, uint8_t data) {
+    uint16_t tail = rb->tail;
+    if ((uint16_t)(tail - rb->head) > rb->mask) {
+        rb->overflowCount++;
+        return FAILURE;
+    }
+    rb->buffer[INDEX(rb, tail)] = data;
+    RING_BUFFER_BARRIER();
+    rb->tail = tail + 1;
+    return SUCCESS;
+}
+
+int8_t RingBuffer_get(RingBuffer *rb, uint8_t *data) {
+    uint16_t head = rb->head;
+    if (head == rb->tail)
+        return FAILURE;
+    *data = rb->buffer[INDEX(rb, head)];
+    RING_BUFFER_BARRIER();
+    rb->head = head + 1;
+    return SUCCESS;
+}
+
+uint8_t RingBuffer_peek(const RingBuffer *rb, uint16_t offset) {
+    if (offset >= RingBuffer_getLength(rb))
+        return 0;
+    return rb->buffer[INDEX(rb, rb->head + offset)];
+}
+
+uint16_t RingBuffer_write(RingBuffer *rb, const uint8_t *data, uint16_t length) {
+    uint16_t tail = rb->tail;
+    uint16_t space = RingBuffer_getSpace(rb);
+    uint16_t first;
+
+    if (length > space)
+        length = space;
+    first = rb->mask + 1 - INDEX(rb, tail);
+    if (first > length)
+        first = length;
+    memcpy(&rb->buffer[INDEX(rb, tail)], data, first);
+    memcpy(rb->buffer, data + first, length - first);
+    RING_BUFFER_BARRIER();
+    rb->tail = tail + length;
+    return length;
+}
+
+uint16_t RingBuffer_read(RingBuffer *rb, uint8_t *data, uint16_t maxLength) {
+    uint16_t head = rb->head;
+    uint16_t length = RingBuffer_getLength(rb);
+    uint16_t first;
+
+    if (length > maxLength)
+        length = maxLength;
+    first = rb->mask + 1 - INDEX(rb, head);
+    if (first > length)
+        first = length;
+    memcpy(data, &rb->buffer[INDEX(rb, head)], first);
+    memcpy(data + first, rb->buffer, length - first);
+    RING_BUFFER_BARRIER();
+    rb->head = head + length;
+    return length;
+}
+
+uint16_t RingBuffer_peekSpan(const RingBuffer *rb, const uint8_t **span) {
+    uint16_t head = rb->head;
+    uint16_t length = (uint16_t)(rb->tail - head);
+    uint16_t first = rb->mask + 1 - INDEX(rb, head);
+
+    *span = &rb->buffer[INDEX(rb, head)];
+    return (length < first)? length : first;
+}
+
+void RingBuffer_consume(RingBuffer *rb, uint16_t length) {
+    uint16_t available = RingBuffer_getLength(rb);
+    if (length > available)
+        length = available;
+    RING_BUFFER_BARRIER();
+    rb->head = rb->head + length;
+}
+
+uint16_t RingBuffer_reserveSpan(RingBuffer *rb, uint8_t **span) {
+    uint16_t tail = rb->tail;
+    uint16_t space = RingBuffer_getSpace(rb);
+    uint16_t first = rb->mask + 1 - INDEX(rb, tail);
+
+    *span = &rb->buffer[INDEX(rb, tail)];
+    return (space < first)? space : first;
+}
+
+void RingBuffer_publish(RingBuffer *rb, uint16_t length) {
+    uint16_t space = RingBuffer_getSpace(rb);
+    if (length > space)
+        length = space;
+    RING_BUFFER_BARRIER();
+    rb->tail = rb->tail + length;
+}
+
+void RingBuffer_publishTo(RingBuffer *rb, uint16_t index) {
+    uint16_t tail = rb->tail;
+    RING_BUFFER_BARRIER();
+    rb->tail = tail + (uint16_t)((index - INDEX(rb, tail)) & rb->mask);
+}
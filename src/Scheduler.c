@@ -0,0 +1,462 @@
+/**********************************************************************
+ Module
+   Scheduler.c
+
+ Revision
+   1.0.0
+
+ Description
+   Cooperative task scheduler with priorities, periods and signals.
+
+ Notes
+   Which tasks are ready is kept in bit masks, one bit per task, so
+   picking the next task is a mask per priority and a count of trailing
+   zeros. Signals are set from interrupts, so everything that clears
+   one does it with interrupts off. Polled tasks have their own mask
+   that is refilled at the start of every pass.
+
+   Periodic tasks get a Timer handle with a callback that signals them.
+   Those callbacks are run by Timer_runCallbacks, which is called before
+   every task so a timer that just expired is seen straight away.
+
+   The profile counts wrap-safe core timer differences, so a task or a
+   pass is measured right as long as it is shorter than 107 s. The
+   histogram bin is the index of the top set bit of the period.
+
+   A task with a deadline is checked just before it runs, against the
+   start of its last run, and checks in with the watchdog then too. So a
+   critical task that hangs has checked in, but the others never get to,
+   and the watchdog isn't fed again. Every task run is also handed to
+   Watchdog_setTask, so a watchdog reset can name the one that hung.
+
+   Going idle has to be atomic with checking that nothing is ready, or
+   an interrupt that signals a task just before the WAIT would leave it
+   waiting until some later interrupt. So the check and the WAIT are
+   done with interrupts off. The M4K still leaves WAIT when an interrupt
+   is asserted with IE clear, it just doesn't take it until interrupts are
+   restored, which happens right after, and the next pass sees its signal.
+
+***********************************************************************/
+
+#include <xc.h>
+#include <plib.h>
+#include <stdio.h>
+#include "Board.h"
+#include "Timer.h"
+#include "Scheduler.h"
+#ifdef SCHEDULER_USE_DEADLINES
+#include "Watchdog.h"
+#endif
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define BIT(task)               ((uint32_t)1 << (task))
+
+// Writing OSCCON needs the system unlock sequence
+#define SYSKEY_UNLOCK_1         0xAA996655
+#define SYSKEY_UNLOCK_2         0x556699AA
+
+/***********************************************************************
+ * PRIVATE TYPEDEFS                                                    *
+ ***********************************************************************/
+
+typedef struct {
+    SchedulerTask run;
+    TimerHandle timer; // TIMER_INVALID unless periodic
+} Task;
+
+/***********************************************************************
+ * PRIVATE VARIABLES                                                   *
+ ***********************************************************************/
+
+static Task tasks[SCHEDULER_TASK_MAX];
+static uint8_t taskCount = 0;
+
+static uint32_t priorityMask[SCHEDULER_PRIORITY_COUNT];
+static uint32_t pollMask;
+static volatile uint32_t signalMask;
+
+#ifdef SCHEDULER_USE_PROFILE
+static TaskProfile profiles[SCHEDULER_TASK_MAX];
+static uint32_t loopHistogram[SCHEDULER_HISTOGRAM_BINS];
+static uint32_t lastPassStart;
+static uint64_t profileCycles, idleCycles;
+static BOOL hasLastPass = FALSE;
+#endif
+
+#ifdef SCHEDULER_USE_DEADLINES
+static uint32_t maxPeriods[SCHEDULER_TASK_MAX]; // (ms)
+static uint32_t lastRuns[SCHEDULER_TASK_MAX]; // (ms)
+static uint32_t deadlineMask; // have a deadline
+static uint32_t criticalMask;
+static uint32_t timedMask; // have run once, so lastRuns is set
+static uint32_t checkinMask; // critical tasks run since the last feed
+#endif
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static void timerExpired(TimerHandle timer, void *context);
+static int8_t nextTask(uint32_t ready);
+static void runTask(TaskId task);
+#ifdef SCHEDULER_USE_PROFILE
+static void countPass();
+#endif
+#ifdef SCHEDULER_USE_DEADLINES
+static void checkDeadline(TaskId task);
+#endif
+#ifdef SCHEDULER_USE_IDLE
+static void idle();
+#endif
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+void Scheduler_init() {
+    uint8_t i;
+    for (i = 0; i < taskCount; i++) {
+        if (tasks[i].timer != TIMER_INVALID)
+            Timer_destroy(tasks[i].timer);
+    }
+    for (i = 0; i < SCHEDULER_PRIORITY_COUNT; i++)
+        priorityMask[i] = 0;
+    taskCount = 0;
+    pollMask = 0;
+    signalMask = 0;
+    #ifdef SCHEDULER_USE_PROFILE
+    Scheduler_clearProfile();
+    #endif
+    #ifdef SCHEDULER_USE_DEADLINES
+    deadlineMask = criticalMask = timedMask = checkinMask = 0;
+    #endif
+
+    #ifdef SCHEDULER_USE_IDLE
+    {
+        unsigned int intStatus = INTDisableInterrupts();
+        SYSKEY = 0;
+        SYSKEY = SYSKEY_UNLOCK_1;
+        SYSKEY = SYSKEY_UNLOCK_2;
+        OSCCONCLR = _OSCCON_SLPEN_MASK;
+        SYSKEY = 0;
+        INTRestoreInterrupts(intStatus);
+    }
+    #endif
+}
+
+TaskId Scheduler_addTask(SchedulerTask run, SchedulerPriority priority,
+        uint32_t period) {
+    TaskId id = taskCount;
+    if (id >= SCHEDULER_TASK_MAX || priority >= SCHEDULER_PRIORITY_COUNT)
+        return SCHEDULER_INVALID;
+
+    tasks[id].run = run;
+    tasks[id].timer = TIMER_INVALID;
+    if (period == SCHEDULER_POLL) {
+        pollMask |= BIT(id);
+    }
+    else if (period != SCHEDULER_ON_SIGNAL) {
+        tasks[id].timer = Timer_create(timerExpired, &tasks[id]);
+        if (tasks[id].timer == TIMER_INVALID)
+            return SCHEDULER_INVALID;
+        Timer_newPeriodic(tasks[id].timer, period);
+    }
+    priorityMask[priority] |= BIT(id);
+    taskCount++;
+    return id;
+}
+
+void Scheduler_signal(TaskId task) {
+    unsigned int intStatus;
+    if (task >= taskCount)
+        return;
+
+    intStatus = INTDisableInterrupts();
+    signalMask |= BIT(task);
+    INTRestoreInterrupts(intStatus);
+}
+
+void Scheduler_run() {
+    uint32_t pending = pollMask;
+    unsigned int intStatus;
+    int8_t task;
+
+    #ifdef SCHEDULER_USE_PROFILE
+    countPass();
+    #endif
+    while (1) {
+        Timer_runCallbacks();
+        task = nextTask(pending | signalMask);
+        if (task < 0)
+            break;
+
+        pending &= ~BIT(task);
+        intStatus = INTDisableInterrupts();
+        signalMask &= ~BIT(task);
+        INTRestoreInterrupts(intStatus);
+
+        runTask(task);
+    }
+
+    #ifdef SCHEDULER_USE_IDLE
+    if (pollMask == 0)
+        idle();
+    #endif
+}
+
+#ifdef SCHEDULER_USE_DEADLINES
+BOOL Scheduler_setDeadline(TaskId task, uint32_t maxPeriod, BOOL isCritical) {
+    if (task >= taskCount)
+        return FAILURE;
+
+    maxPeriods[task] = maxPeriod;
+    deadlineMask |= BIT(task);
+    timedMask &= ~BIT(task);
+    if (isCritical)
+        criticalMask |= BIT(task);
+    else
+        criticalMask &= ~BIT(task);
+    return SUCCESS;
+}
+
+uint32_t Scheduler_getCriticalPeriod() {
+    uint8_t i;
+    uint32_t longest = 0;
+    for (i = 0; i < taskCount; i++) {
+        if ((criticalMask & BIT(i)) && maxPeriods[i] > longest)
+            longest = maxPeriods[i];
+    }
+    return longest;
+}
+#endif
+
+#ifdef SCHEDULER_USE_PROFILE
+BOOL Scheduler_getProfile(TaskId task, TaskProfile *profile) {
+    if (task >= taskCount)
+        return FAILURE;
+    *profile = profiles[task];
+    return SUCCESS;
+}
+
+const uint32_t *Scheduler_getLoopHistogram() {
+    return loopHistogram;
+}
+
+void Scheduler_clearProfile() {
+    uint8_t i;
+    for (i = 0; i < SCHEDULER_TASK_MAX; i++) {
+        profiles[i].runs = 0;
+        profiles[i].minCycles = 0xFFFFFFFF;
+        profiles[i].maxCycles = 0;
+        profiles[i].totalCycles = 0;
+    }
+    for (i = 0; i < SCHEDULER_HISTOGRAM_BINS; i++)
+        loopHistogram[i] = 0;
+    profileCycles = 0;
+    idleCycles = 0;
+    hasLastPass = FALSE;
+}
+
+void Scheduler_printProfile() {
+    uint8_t i;
+    TaskProfile *profile;
+    printf("task    runs   min(us)  mean(us)   max(us)\n");
+    for (i = 0; i < taskCount; i++) {
+        profile = &profiles[i];
+        if (profile->runs == 0) {
+            printf("%4u %7lu\n", i, 0UL);
+            continue;
+        }
+        printf("%4u %7lu %9lu %9lu %9lu\n", i, (unsigned long)profile->runs,
+            (unsigned long)TIMER_CYCLES_TO_MICROS(profile->minCycles),
+            (unsigned long)TIMER_CYCLES_TO_MICROS(profile->totalCycles
+                / profile->runs),
+            (unsigned long)TIMER_CYCLES_TO_MICROS(profile->maxCycles));
+    }
+    if (profileCycles != 0)
+        printf("idle %lu%%\n", (unsigned long)(100 * idleCycles / profileCycles));
+    printf("loop period (cycles)   passes\n");
+    for (i = 0; i < SCHEDULER_HISTOGRAM_BINS; i++) {
+        if (loopHistogram[i] != 0)
+            printf("%10lu+ %14lu\n", 1UL << i, (unsigned long)loopHistogram[i]);
+    }
+}
+#endif
+
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+static void timerExpired(TimerHandle timer, void *context) {
+    Scheduler_signal((Task *)context - tasks);
+}
+
+/**********************************************************************
+ * Function: runTask
+ * @param Task to run.
+ * @return None
+ * @remark Supervises and times the run, each if it's compiled in.
+ **********************************************************************/
+static void runTask(TaskId task) {
+    #ifdef SCHEDULER_USE_PROFILE
+    TaskProfile *profile = &profiles[task];
+    uint32_t start = Timer_getCycles();
+    uint32_t cycles;
+    #endif
+
+    #ifdef SCHEDULER_USE_DEADLINES
+    checkDeadline(task);
+    Watchdog_setTask(task);
+    #endif
+    tasks[task].run();
+    #ifdef SCHEDULER_USE_DEADLINES
+    Watchdog_setTask(WATCHDOG_NO_TASK);
+    #endif
+
+    #ifdef SCHEDULER_USE_PROFILE
+    cycles = Timer_getCycles() - start;
+    profile->runs++;
+    profile->totalCycles += cycles;
+    if (cycles < profile->minCycles)
+        profile->minCycles = cycles;
+    if (cycles > profile->maxCycles)
+        profile->maxCycles = cycles;
+    #endif
+}
+
+#ifdef SCHEDULER_USE_DEADLINES
+/**********************************************************************
+ * Function: checkDeadline
+ * @param Task about to run.
+ * @return None
+ * @remark Records a miss if it's late, and feeds the watchdog if it's the
+ *  last critical task to check in.
+ **********************************************************************/
+static void checkDeadline(TaskId task) {
+    uint32_t now, elapsed;
+    if (!(deadlineMask & BIT(task)))
+        return;
+
+    now = get_time();
+    if (timedMask & BIT(task)) {
+        elapsed = now - lastRuns[task];
+        if (elapsed > maxPeriods[task])
+            Watchdog_recordMiss(task, elapsed - maxPeriods[task]);
+    }
+    lastRuns[task] = now;
+    timedMask |= BIT(task);
+
+    if (criticalMask & BIT(task)) {
+        checkinMask |= BIT(task);
+        if ((checkinMask & criticalMask) == criticalMask) {
+            Watchdog_feed();
+            checkinMask = 0;
+        }
+    }
+}
+#endif
+
+#ifdef SCHEDULER_USE_PROFILE
+static void countPass() {
+    uint32_t now = Timer_getCycles();
+    uint32_t period = now - lastPassStart;
+    if (hasLastPass && period != 0) {
+        loopHistogram[31 - __builtin_clz(period)]++;
+        profileCycles += period;
+    }
+    lastPassStart = now;
+    hasLastPass = TRUE;
+}
+#endif
+
+#ifdef SCHEDULER_USE_IDLE
+/**********************************************************************
+ * Function: idle
+ * @return None
+ * @remark Waits for an interrupt unless a task or a timer callback is
+ *  already waiting to run.
+ **********************************************************************/
+static void idle() {
+    unsigned int intStatus = INTDisableInterrupts();
+    #ifdef SCHEDULER_USE_PROFILE
+    uint32_t start = Timer_getCycles();
+    #endif
+
+    if (signalMask == 0 && !Timer_hasCallbacks()) {
+        asm volatile("wait");
+        #ifdef SCHEDULER_USE_PROFILE
+        idleCycles += Timer_getCycles() - start;
+        #endif
+    }
+    INTRestoreInterrupts(intStatus);
+}
+#endif
+
+/**********************************************************************
+ * Function: nextTask
+ * @param Mask of the tasks that are ready.
+ * @return The most urgent of them, or -1 if none are.
+ **********************************************************************/
+static int8_t nextTask(uint32_t ready) {
+    uint8_t priority;
+    uint32_t candidates;
+    for (priority = 0; priority < SCHEDULER_PRIORITY_COUNT; priority++) {
+        candidates = ready & priorityMask[priority];
+        if (candidates != 0)
+            return __builtin_ctz(candidates);
+    }
+    return -1;
+}
+
+//#define SCHEDULER_TEST
+#ifdef SCHEDULER_TEST
+
+#include "Serial.h"
+
+static uint32_t fastCount = 0, slowCount = 0, pollCount = 0;
+
+static void fast() {
+    fastCount++;
+}
+
+static void slow() {
+    uint32_t start = get_time();
+    slowCount++;
+    // Hog the loop, the fast task should still get close to its rate
+    while (get_time() - start < 5)
+        ;
+}
+
+static void poll() {
+    pollCount++;
+}
+
+static void report() {
+    printf("fast %lu, slow %lu, polled %lu\n", (unsigned long)fastCount,
+        (unsigned long)slowCount, (unsigned long)pollCount);
+    #ifdef SCHEDULER_USE_PROFILE
+    Scheduler_printProfile();
+    #endif
+}
+
+int main() {
+    Board_init();
+    Serial_init();
+    Timer_init();
+    Scheduler_init();
+
+    Scheduler_addTask(fast, SCHEDULER_PRIORITY_HIGH, 10);
+    Scheduler_addTask(slow, SCHEDULER_PRIORITY_LOW, 100);
+    Scheduler_addTask(poll, SCHEDULER_PRIORITY_NORMAL, SCHEDULER_POLL);
+    Scheduler_addTask(report, SCHEDULER_PRIORITY_LOW, 1000);
+
+    while (1)
+        Scheduler_run();
+
+    return SUCCESS;
+}
+
+#endif
@@ -0,0 +1,383 @@
+/**********************************************************************
+ Module
+   Sensors.c
+
+ Revision
+   1.0.0
+
+ Description
+   Staggered schedule for the I2C sensor reads.
+
+ Notes
+   Phases are planned on a table of the expected bus time in each
+   millisecond of the frame. A sensor of period P at phase p reads in
+   slots p, p + P, p + 2P and so on, and a read longer than a
+   millisecond spills over into the slots after it. The phase picked is
+   the one whose busiest slot is least loaded, the earliest of those on
+   a tie. Placing the fastest sensors first leaves the slower ones, which
+   have more phases to choose from, to fill in around them.
+
+   A period that doesn't divide the frame wraps around it imperfectly,
+   which is why the frame is the common multiple when that's short
+   enough. The plan is only a spread, it doesn't stop a read that
+   overruns its cost from running into the next one.
+
+   The due mask is only touched from Timer callbacks and the read task,
+   both in the main loop, so it needs no locking.
+
+***********************************************************************/
+
+#include <xc.h>
+#include <stdio.h>
+#include "Board.h"
+#include "Timer.h"
+#include "Scheduler.h"
+#include "Sensors.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define BIT(sensor)             ((uint32_t)1 << (sensor))
+#define MICROS_PER_SLOT         1000
+#define MAX_LOAD                0xFFFF
+
+/***********************************************************************
+ * PRIVATE TYPEDEFS                                                    *
+ ***********************************************************************/
+
+typedef struct {
+    SensorRead read;
+    I2C_MODULE bus;
+    uint32_t period, phase; // (ms)
+    uint32_t cost; // (us) expected per read
+    TimerHandle timer;
+    uint32_t dueCycles; // when the timer last expired
+    // Measured
+    uint32_t runs;
+    uint32_t maxCycles, maxLatencyCycles;
+    uint64_t totalCycles;
+} Sensor;
+
+/***********************************************************************
+ * PRIVATE VARIABLES                                                   *
+ ***********************************************************************/
+
+static Sensor sensors[SENSORS_MAX];
+static uint8_t sensorCount = 0;
+static uint32_t dueMask = 0;
+static TaskId readTask = SCHEDULER_INVALID;
+static BOOL started = FALSE;
+static uint32_t startTime; // (ms)
+
+// Expected bus time in each millisecond of the frame, for planning
+static uint16_t slotLoad[SENSORS_FRAME_MAX];
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static void planBus(I2C_MODULE bus);
+static uint32_t getFrame(I2C_MODULE bus);
+static uint16_t worstLoad(const Sensor *sensor, uint32_t phase, uint32_t frame);
+static void addLoad(const Sensor *sensor, uint32_t frame);
+static void sensorDue(TimerHandle timer, void *context);
+static void readDue();
+static uint32_t gcd(uint32_t a, uint32_t b);
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+BOOL Sensors_add(SensorRead read, I2C_MODULE bus, uint32_t period,
+        uint32_t cost) {
+    Sensor *sensor;
+    if (started || sensorCount >= SENSORS_MAX || period == 0)
+        return FAILURE;
+
+    sensor = &sensors[sensorCount++];
+    sensor->read = read;
+    sensor->bus = bus;
+    sensor->period = period;
+    sensor->phase = 0;
+    sensor->cost = cost;
+    sensor->timer = TIMER_INVALID;
+    sensor->runs = 0;
+    sensor->maxCycles = 0;
+    sensor->maxLatencyCycles = 0;
+    sensor->totalCycles = 0;
+    return SUCCESS;
+}
+
+BOOL Sensors_start(SchedulerPriority priority) {
+    uint8_t i, j;
+    Sensor *sensor;
+    if (started)
+        return FAILURE;
+
+    // Plan each bus once, from its first sensor
+    for (i = 0; i < sensorCount; i++) {
+        for (j = 0; j < i && sensors[j].bus != sensors[i].bus; j++)
+            ;
+        if (j == i)
+            planBus(sensors[i].bus);
+    }
+
+    readTask = Scheduler_addTask(readDue, priority, SCHEDULER_ON_SIGNAL);
+    if (readTask == SCHEDULER_INVALID)
+        return FAILURE;
+    for (i = 0; i < sensorCount; i++) {
+        sensor = &sensors[i];
+        sensor->timer = Timer_create(sensorDue, sensor);
+        if (sensor->timer == TIMER_INVALID)
+            return FAILURE;
+    }
+
+    // Back to back, so the phases are relative to the same time
+    for (i = 0; i < sensorCount; i++) {
+        sensor = &sensors[i];
+        Timer_newPhased(sensor->timer,
+            (sensor->phase == 0)? sensor->period : sensor->phase,
+            sensor->period);
+    }
+    startTime = get_time();
+    started = TRUE;
+    return SUCCESS;
+}
+
+float Sensors_getPlannedUtilisation(I2C_MODULE bus) {
+    uint8_t i;
+    float share = 0.0f;
+    for (i = 0; i < sensorCount; i++) {
+        if (sensors[i].bus == bus)
+            share += (float)sensors[i].cost
+                / (sensors[i].period * MICROS_PER_SLOT);
+    }
+    return share;
+}
+
+float Sensors_getUtilisation(I2C_MODULE bus) {
+    uint8_t i;
+    uint32_t elapsed = get_time() - startTime;
+    uint64_t busy = 0;
+    if (!started || elapsed == 0)
+        return 0.0f;
+
+    for (i = 0; i < sensorCount; i++) {
+        if (sensors[i].bus == bus)
+            busy += sensors[i].totalCycles;
+    }
+    return (float)TIMER_CYCLES_TO_MICROS(busy)
+        / ((float)elapsed * MICROS_PER_SLOT);
+}
+
+void Sensors_printSchedule() {
+    uint8_t i, j;
+    Sensor *sensor;
+    printf("sensor bus period phase    runs mean(us) max(us) late(us)\n");
+    for (i = 0; i < sensorCount; i++) {
+        sensor = &sensors[i];
+        printf("%6u %3u %6lu %5lu %7lu %8lu %7lu %8lu\n", i, sensor->bus + 1,
+            (unsigned long)sensor->period, (unsigned long)sensor->phase,
+            (unsigned long)sensor->runs,
+            (unsigned long)((sensor->runs == 0)? 0 :
+                TIMER_CYCLES_TO_MICROS(sensor->totalCycles / sensor->runs)),
+            (unsigned long)TIMER_CYCLES_TO_MICROS(sensor->maxCycles),
+            (unsigned long)TIMER_CYCLES_TO_MICROS(sensor->maxLatencyCycles));
+    }
+    for (i = 0; i < sensorCount; i++) {
+        for (j = 0; j < i && sensors[j].bus != sensors[i].bus; j++)
+            ;
+        if (j == i)
+            printf("I2C%u planned %.1f%%, achieved %.1f%%\n",
+                sensors[i].bus + 1,
+                100.0f * Sensors_getPlannedUtilisation(sensors[i].bus),
+                100.0f * Sensors_getUtilisation(sensors[i].bus));
+    }
+}
+
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: planBus
+ * @param Bus to plan.
+ * @return None
+ * @remark Sets the phase of every sensor on the bus, fastest first.
+ **********************************************************************/
+static void planBus(I2C_MODULE bus) {
+    uint32_t frame = getFrame(bus);
+    uint32_t phase, placed = 0;
+    uint16_t load, bestLoad;
+    uint8_t i, next;
+    Sensor *sensor;
+
+    for (phase = 0; phase < frame; phase++)
+        slotLoad[phase] = 0;
+
+    // Selection by period, ties in the order they were added
+    while (1) {
+        next = SENSORS_MAX;
+        for (i = 0; i < sensorCount; i++) {
+            if (sensors[i].bus != bus || (placed & BIT(i)))
+                continue;
+            if (next == SENSORS_MAX || sensors[i].period < sensors[next].period)
+                next = i;
+        }
+        if (next == SENSORS_MAX)
+            break;
+        sensor = &sensors[next];
+        placed |= BIT(next);
+
+        bestLoad = MAX_LOAD;
+        for (phase = 0; phase < sensor->period && phase < frame; phase++) {
+            load = worstLoad(sensor, phase, frame);
+            if (load < bestLoad) {
+                bestLoad = load;
+                sensor->phase = phase;
+            }
+        }
+        addLoad(sensor, frame);
+    }
+}
+
+// least common multiple of the periods on the bus, up to the maximum
+static uint32_t getFrame(I2C_MODULE bus) {
+    uint32_t frame = 1;
+    uint8_t i;
+    for (i = 0; i < sensorCount; i++) {
+        if (sensors[i].bus != bus)
+            continue;
+        frame = frame / gcd(frame, sensors[i].period) * sensors[i].period;
+        if (frame > SENSORS_FRAME_MAX)
+            return SENSORS_FRAME_MAX;
+    }
+    return frame;
+}
+
+// busiest slot the sensor would read in at the phase
+static uint16_t worstLoad(const Sensor *sensor, uint32_t phase, uint32_t frame) {
+    uint32_t slot, spill, slots = (sensor->cost + MICROS_PER_SLOT - 1)
+        / MICROS_PER_SLOT;
+    uint16_t worst = 0;
+    if (slots == 0)
+        slots = 1;
+    for (slot = phase; slot < frame; slot += sensor->period) {
+        for (spill = 0; spill < slots; spill++) {
+            if (slotLoad[(slot + spill) % frame] > worst)
+                worst = slotLoad[(slot + spill) % frame];
+        }
+    }
+    return worst;
+}
+
+static void addLoad(const Sensor *sensor, uint32_t frame) {
+    uint32_t slot, spill, added, index;
+    uint32_t remaining;
+    for (slot = sensor->phase; slot < frame; slot += sensor->period) {
+        remaining = sensor->cost;
+        spill = 0;
+        do {
+            added = (remaining > MICROS_PER_SLOT)? MICROS_PER_SLOT : remaining;
+            index = (slot + spill++) % frame;
+            slotLoad[index] = (slotLoad[index] + added > MAX_LOAD)?
+                MAX_LOAD : slotLoad[index] + added;
+            remaining -= added;
+        } while (remaining > 0);
+    }
+}
+
+static void sensorDue(TimerHandle timer, void *context) {
+    Sensor *sensor = (Sensor *)context;
+    sensor->dueCycles = Timer_getCycles();
+    dueMask |= BIT(sensor - sensors);
+    Scheduler_signal(readTask);
+}
+
+/**********************************************************************
+ * Function: readDue
+ * @return None
+ * @remark The scheduler task, reads every due sensor and times it.
+ **********************************************************************/
+static void readDue() {
+    uint8_t i;
+    uint32_t start, cycles;
+    Sensor *sensor;
+
+    while (dueMask != 0) {
+        i = __builtin_ctz(dueMask);
+        dueMask &= ~BIT(i);
+        sensor = &sensors[i];
+
+        start = Timer_getCycles();
+        if (start - sensor->dueCycles > sensor->maxLatencyCycles)
+            sensor->maxLatencyCycles = start - sensor->dueCycles;
+        sensor->read();
+        cycles = Timer_getCycles() - start;
+
+        sensor->runs++;
+        sensor->totalCycles += cycles;
+        if (cycles > sensor->maxCycles)
+            sensor->maxCycles = cycles;
+    }
+}
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+    uint32_t remainder;
+    while (b != 0) {
+        remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+//#define SENSORS_TEST
+#ifdef SENSORS_TEST
+
+#include "Serial.h"
+
+// Stand-ins that keep the CPU busy about as long as a read would
+static void busyFor(uint32_t micros) {
+    uint32_t start = Timer_getCycles();
+    while (Timer_getCycles() - start < micros * TIMER_CYCLES_PER_MICRO)
+        ;
+}
+
+static void readImu() {
+    busyFor(250);
+}
+
+static void readEncoders() {
+    busyFor(400);
+}
+
+static void readCompass() {
+    busyFor(700);
+}
+
+static void readBarometer() {
+    busyFor(300);
+}
+
+int main() {
+    Board_init();
+    Serial_init();
+    Timer_init();
+    Scheduler_init();
+
+    Sensors_add(readEncoders, I2C1, 10, 400);
+    Sensors_add(readImu, I2C1, 10, 250);
+    Sensors_add(readCompass, I2C1, 50, 700);
+    Sensors_add(readBarometer, I2C2, 100, 300);
+    Sensors_start(SCHEDULER_PRIORITY_HIGH);
+    Scheduler_addTask(Sensors_printSchedule, SCHEDULER_PRIORITY_LOW, 5000);
+
+    while (1)
+        Scheduler_run();
+
+    return SUCCESS;
+}
+
+#endif
@@ -13,9 +13,11 @@
 #include <xc.h>
 #include <peripheral/uart.h>
 #include <stdint.h>
+#include <string.h>
 #include "Board.h"
 #include "Serial.h"
 #include "Uart.h"
+#include "RingBuffer.h"
 //#include <plib.h>
 //#include <stdlib.h>
 
@@ -30,6 +32,9 @@
 
 #define F_PB (Board_GetPBClock())
 #define QUEUESIZE 512
+#define LOG_QUEUESIZE 512       // power of two, see RingBuffer.h
+#define LOG_HEADER_LENGTH 4     // sync, id, count, sequence
+#define LOG_RECORD_MAX (LOG_HEADER_LENGTH + 4*SERIAL_LOG_MAX_ARGS + 1)
 
 /*******************************************************************************
  * PRIVATE DATATYPES                                                           *
@@ -40,6 +45,7 @@
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                *
  ******************************************************************************/
+static int8_t queueRecord(uint8_t id, const uint32_t *args, uint8_t count);
 
 
 /*******************************************************************************
@@ -49,6 +55,11 @@ BOOL canBlock = TRUE;
 const char *buffer;
 uint16_t bufferIndex = 0;
 
+RING_BUFFER_STORAGE(logStorage, LOG_QUEUESIZE);
+static RingBuffer logBuffer;
+static uint8_t logSequence = 0;
+static uint32_t logDropped = 0; // records dropped since the last LOG_OVERFLOW
+
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                           *
@@ -79,6 +90,7 @@ char Serial_init()
     printf("Intializing the Serial on UART %d.\n", SERIAL_UART_ID);
     #endif
     UART_init(SERIAL_UART_ID,SERIAL_UART_BAUDRATE);
+    RingBuffer_init(&logBuffer, logStorage, LOG_QUEUESIZE);
     return SUCCESS;
 }
 
@@ -123,16 +135,69 @@ void Serial_putChar(char ch)
      None.
 
  Description
-    Sends one character from buffer if there are any characters and the trasmit
- *  buffer is empty.
+    Moves whole log records into the UART transmit buffer while they fit,
+    so they never get split up by printf output.
 
 
  Author
     Max Dunne, 2011.11.10
  ****************************************************************************/
 void Serial_runSM() {
-    if (Serial_isTransmitEmpty() && bufferIndex < sizeof(buffer))
-        Serial_putChar(buffer[bufferIndex++]);
+    uint8_t record[LOG_RECORD_MAX];
+    uint16_t length;
+
+    while (!RingBuffer_isEmpty(&logBuffer)) {
+        length = LOG_HEADER_LENGTH + 4*RingBuffer_peek(&logBuffer, 2) + 1;
+        if (UART_getTransmitSpace(SERIAL_UART_ID) < length)
+            break;
+        RingBuffer_read(&logBuffer, record, length);
+        UART_write(SERIAL_UART_ID, record, length);
+    }
+}
+
+/****************************************************************************
+ Function
+     Serial_log
+
+ Parameters
+    id - format string index from LogFormats.h
+    args - raw 32-bit arguments
+    count - number of arguments
+
+ Returns
+     SUCCESS, or FAILURE if the record did not fit.
+
+ Description
+    Queues one binary log record, see Serial.h for the layout. A pending
+    LOG_OVERFLOW record goes first so the decoder sees where the gap was.
+
+ Notes
+    Called from the main loop only, the log ring has one producer.
+
+ ****************************************************************************/
+int8_t Serial_log(uint8_t id, const uint32_t *args, uint8_t count)
+{
+    if (count > SERIAL_LOG_MAX_ARGS)
+        count = SERIAL_LOG_MAX_ARGS;
+    if (logDropped > 0) {
+        if (queueRecord(LOG_OVERFLOW, &logDropped, 1) == SUCCESS)
+            logDropped = 0;
+    }
+    if (logDropped > 0 || queueRecord(id, args, count) != SUCCESS) {
+        logDropped++;
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+
+uint32_t Serial_floatBits(float f)
+{
+    union {
+        float f;
+        uint32_t bits;
+    } value;
+    value.f = f;
+    return value.bits;
 }
 
 
@@ -291,6 +356,28 @@ char Serial_isTransmitEmpty(void)
  * PRIVATE FUNCTIONS                                                          *
  ******************************************************************************/
 
+// builds a record and queues it whole, or not at all
+static int8_t queueRecord(uint8_t id, const uint32_t *args, uint8_t count)
+{
+    uint8_t record[LOG_RECORD_MAX];
+    uint8_t length = LOG_HEADER_LENGTH + 4*count;
+    uint8_t checksum = 0;
+    uint8_t i;
+
+    if (RingBuffer_getSpace(&logBuffer) < length + 1)
+        return FAILURE;
+    record[0] = SERIAL_LOG_SYNC;
+    record[1] = id;
+    record[2] = count;
+    record[3] = logSequence++;
+    memcpy(&record[LOG_HEADER_LENGTH], args, 4*count); // PIC32 is little endian
+    for (i = 1; i < length; i++)
+        checksum ^= record[i];
+    record[length] = checksum;
+    RingBuffer_write(&logBuffer, record, length + 1);
+    return SUCCESS;
+}
+
 
 
 
@@ -1,13 +1,29 @@
 /**********************************************************************
  Module
-   Xbee.c
+   Sonar.c
 
  Author: John Ash
 
  Description
-	Code to initialzie and control the Xbee modules in API mode
-   
+	Reads the sonar's analog window, and finds the range of the echo in it.
+
  Notes
+   The window pin is captured by the A/D on Timer3 (see AD_startCapture)
+   at SONAR_SAMPLE_RATE, so the range resolution is set by the sample
+   rate rather than by how often the main loop comes round. Each capture
+   is searched once it's in, and the next one started.
+
+   The transmit pulse is the first rise over SONAR_PULSE_THRESHOLD, the
+   time of flight is counted from there, and nothing is looked for until
+   the window has fallen back under the threshold. The echo is found with
+   a matched filter for a pulse SONAR_PULSE_SAMPLES long, a running sum of
+   that many samples over the floor of the window, which is the mean of
+   what's after the transmit pulse. The peak is refined between samples
+   on the parabola through it and its neighbours.
+
+   Confidence is how much the peak stands out from the next best peak
+   outside it, 1 - next / peak. One clear echo comes out near 1, a window
+   of clutter or only noise near 0.
 
  History
  When               Who         What/Why
@@ -15,15 +31,13 @@
  12-29-12 2:10 PM   jash    Created file.
  1-17-13 4:10 PM    jash    Work on functions, add receieve pseudo code
  2-1-13  2:50 AM    jash    Complete functions and add comments.
+ 10-14-26                       Hardware timed capture and peak detection.
 ***********************************************************************/
 
 #include <xc.h>
-#include <peripheral/uart.h>
 #include <stdint.h>
 #include <Ports.h>
 #include "Board.h"
-#include "Uart.h"
-//#include "Mavlink.h"
 #include <Timer.h>
 #include <AD.h>
 #include "Sonar.h"
@@ -31,32 +45,23 @@
 /***********************************************************************
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
-//Cannot be greater than 100
-#define NUMBER_OF_SAMPLES 100
-
-#define TIMER_NUMBER 4
-#define TIMER_TIME 100/NUMBER_OF_SAMPLES
-
-#define INIT_THRESHOLD 498
-
 
+#define NO_PULSE            0xFFFF
 
 /**********************************************************************
  * PRIVATE PROTOTYPES                                                 *
  **********************************************************************/
 
-static uint32_t getAnalog();
-static uint32_t getAnalogWindow();
+static void findEcho();
+static int32_t filterAt(uint16_t index, int32_t floor);
 
 /**********************************************************************
  * PRIVATE VARIABLES                                                 *
  **********************************************************************/
 
-//uint32_t rawAnalogData[100] = 0;
-//uint32_t averagedAnalogData[100]=0;
-uint8_t count = 0;
-uint8_t print_count = 0xFF;
-uint32_t oldWindowValue=0, windowValue=0;
+static unsigned short samples[SONAR_SAMPLES];
+static SonarRange latest;
+
 /**********************************************************************
  * PUBLIC FUNCTIONS                                                   *
  **********************************************************************/
@@ -64,86 +69,146 @@ uint32_t oldWindowValue=0, windowValue=0;
 void Sonar_init(){
     AD_init(ANALOG_WINDOW_PIN | ANALOG_PIN);
     Timer_init();
-    Timer_new(TIMER_NUMBER, TIMER_TIME);
+    latest.isValid = FALSE;
+    latest.range = 0;
+    latest.confidence = 0;
+    latest.time = 0;
+    AD_startCapture(ANALOG_WINDOW_PIN, SONAR_SAMPLE_RATE, samples,
+        SONAR_SAMPLES);
 }
 
-BOOL Sonar_runSM(uint32_t* rawAnalogWindowData, uint32_t* rawAnalogData){
-    windowValue = getAnalogWindow();
-    if(windowValue > INIT_THRESHOLD && windowValue < oldWindowValue){
-        Timer_new(TIMER_NUMBER, TIMER_TIME);
-        count = 0;
-        rawAnalogWindowData[count++%NUMBER_OF_SAMPLES] = windowValue;
-        //printf("\nNEW DATA print_count = %d\n", print_count);
-        print_count = 0;
-        return TRUE;
-
-    }else if(Timer_isExpired(TIMER_NUMBER) && count < NUMBER_OF_SAMPLES){
-        Timer_new(TIMER_NUMBER, TIMER_TIME);
-        *rawAnalogData = getAnalog();
-        rawAnalogWindowData[count++%NUMBER_OF_SAMPLES] = windowValue;
-    }
-   /*
-    }else if(print_count < NUMBER_OF_SAMPLES){
-        printf("%d \t",rawAnalogWindowData[print_count++]);
-    }
-    */
-    oldWindowValue = windowValue;
-    return FALSE;
+BOOL Sonar_runSM(){
+    if (AD_isCapturing())
+        return FALSE;
+    findEcho();
+    AD_startCapture(ANALOG_WINDOW_PIN, SONAR_SAMPLE_RATE, samples,
+        SONAR_SAMPLES);
+    return TRUE;
 }
 
+void Sonar_getRange(SonarRange *range){
+    *range = latest;
+}
 
-
+unsigned int Sonar_getAnalog(){
+    return AD_readAverage(ANALOG_PIN);
+}
 
 /**********************************************************************
  * PRIVATE FUNCTIONS                                                  *
  **********************************************************************/
 
-static uint32_t getAnalog(){
-    return AD_readPin(ANALOG_PIN);
+/**********************************************************************
+ * Function: findEcho
+ * @return None
+ * @remark Searches the capture for the transmit pulse and the strongest
+ *  echo after it, and updates the latest range. Three passes over the
+ *  samples, each a running sum, so the time is the same every capture.
+ **********************************************************************/
+static void findEcho(){
+    uint16_t i, pulse = NO_PULSE, start = NO_PULSE, last, best = 0;
+    int32_t floor = 0, sum, peak = 0, next = 0, before, after;
+    float offset = 0, curve;
+
+    latest.time = get_time();
+    latest.isValid = FALSE;
+    latest.confidence = 0;
+
+    // A rising edge, a window that starts inside a ping can't time it
+    for (i = 1; i < SONAR_SAMPLES; i++) {
+        if (pulse == NO_PULSE) {
+            if (samples[i] >= SONAR_PULSE_THRESHOLD
+                    && samples[i - 1] < SONAR_PULSE_THRESHOLD)
+                pulse = i;
+        }
+        else if (samples[i] < SONAR_PULSE_THRESHOLD) {
+            start = i;
+            break;
+        }
+    }
+    if (start == NO_PULSE || SONAR_SAMPLES - start < 2 * SONAR_PULSE_SAMPLES)
+        return; // no ping in this window, or its echoes are past the end
+    last = SONAR_SAMPLES - SONAR_PULSE_SAMPLES;
+
+    for (i = start; i < SONAR_SAMPLES; i++)
+        floor += samples[i];
+    floor /= SONAR_SAMPLES - start;
+
+    // Matched filter as a running sum over the pulse's length
+    sum = filterAt(start, floor);
+    for (i = start; i <= last; i++) {
+        if (i > start)
+            sum += samples[i + SONAR_PULSE_SAMPLES - 1] - samples[i - 1];
+        if (sum > peak) {
+            peak = sum;
+            best = i;
+        }
+    }
+    if (peak < SONAR_ECHO_MIN * SONAR_PULSE_SAMPLES)
+        return;
+
+    // Next best, outside the pulse either side of the peak
+    sum = filterAt(start, floor);
+    for (i = start; i <= last; i++) {
+        if (i > start)
+            sum += samples[i + SONAR_PULSE_SAMPLES - 1] - samples[i - 1];
+        if ((i + SONAR_PULSE_SAMPLES <= best || i >= best + SONAR_PULSE_SAMPLES)
+                && sum > next)
+            next = sum;
+    }
+
+    if (best > start && best < last) {
+        before = filterAt(best - 1, floor);
+        after = filterAt(best + 1, floor);
+        curve = (float)(before - 2 * peak + after);
+        if (curve < 0)
+            offset = 0.5f * (before - after) / curve;
+    }
+
+    // Middle of the pulse in the echo, from the start of the transmit one
+    latest.range = ((float)(best - pulse) + offset) / SONAR_SAMPLE_RATE
+        * SONAR_SPEED_OF_SOUND / 2;
+    latest.confidence = 1.0f - (float)next / peak;
+    latest.isValid = TRUE;
 }
 
-static uint32_t getAnalogWindow(){
-    return AD_readPin(ANALOG_WINDOW_PIN);
+// Matched filter output at one index, the pulse starting there
+static int32_t filterAt(uint16_t index, int32_t floor){
+    int32_t sum = 0;
+    uint16_t k;
+    for (k = 0; k < SONAR_PULSE_SAMPLES; k++)
+        sum += samples[index + k];
+    return sum - floor * SONAR_PULSE_SAMPLES;
 }
 
 
 /*************************************************************
- * This test function will program two Xbees, Master & Slave.
- * The Master will send data packets 1-255. However before
- * sending the next packet in sequence it has to recieve a
- * return packet from Slave.
- *
- * Slave will look for packets, and then return the packet data
- * field in  a packet to the Master
+ * Prints the range of each capture, its confidence, and the
+ * analog range output for comparison.
  */
 #define SONAR_TEST
 #ifdef SONAR_TEST
 
-
-//#include "Board.h"
-
-
+#include <stdio.h>
+#include "Serial.h"
 
 int main(){
+    SonarRange range;
     Board_init();
     Serial_init();
     //mJTAGPortEnable(0);
     Sonar_init();
     printf("Sonar Init");
 
-    uint8_t count = 0;
-    uint32_t rawAnalogWindow[NUMBER_OF_SAMPLES] = {0};
-    uint32_t analog;
     while(1){
-        if(Sonar_runSM(rawAnalogWindow, &analog) == TRUE){
-            printf("\n");
-            printf("\nAnalog: %d\n", analog);
-            printf("Raw Data:");
-            count = 0;
-        }else if(count < NUMBER_OF_SAMPLES){
-            printf("%d\t",rawAnalogWindow[count]);
-            rawAnalogWindow[count++] = 0;
+        if(Sonar_runSM() == TRUE){
+            Sonar_getRange(&range);
+            if (range.isValid)
+                printf("\nRange: %.3f m, confidence %.2f, analog %u",
+                    range.range, range.confidence, Sonar_getAnalog());
+            else
+                printf("\nNo echo, analog %u", Sonar_getAnalog());
         }
     }
 }
-#endif
\ No newline at end of file
+#endif
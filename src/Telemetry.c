@@ -0,0 +1,394 @@
+/**********************************************************************
+ Module
+   Telemetry.c
+
+ Revision
+   1.0.0
+
+ Description
+   Token bucket scheduler of the boat's telemetry streams.
+
+ Notes
+   The bucket is kept in thousandths of a byte, so a rate in bytes per
+   second times the milliseconds since the last refill adds exactly, and
+   a few bytes a second still fill it between calls a millisecond apart.
+
+   The streams are kept in the order they were added, so an id stays put,
+   and visited through a list sorted by priority. Once a stream that's
+   due can't be paid for, nothing after it in the pass is sent either,
+   otherwise small cheap streams would keep the bucket from ever filling
+   up for a bigger, more important one.
+
+***********************************************************************/
+
+#include <xc.h>
+#include <stdint.h>
+#include "Board.h"
+#include "Timer.h"
+#include "Uart.h"
+#include "Xbee.h"
+#include "Mavlink.h"
+#include "Telemetry.h"
+#include "Error.h"
+#ifdef USE_GPS
+#include "Gps.h"
+#endif
+#ifdef USE_SENSOR_FUSION
+#include "Navigation.h"
+#endif
+#ifdef USE_GUIDANCE
+#include "Guidance.h"
+#endif
+#ifdef USE_THERMAL
+#include "Thermal.h"
+#endif
+#ifdef USE_BATTERY
+#include "AD.h"
+#endif
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define MILLI                   1000L
+#define LOSS_MAX                10 // (%) of heartbeats lost before backing off
+
+// Bytes a message takes on the link, its MAVLink frame in an API frame
+#define API_OVERHEAD            9
+#define MESSAGE_BYTES(length)   (MAVLINK_NUM_NON_PAYLOAD_BYTES + (length) \
+                                    + API_OVERHEAD)
+
+// Boat streams, see Telemetry_addBoatStreams
+#define POSITION_PERIOD         1000 // (ms)
+#define THERMAL_PERIOD          500 // (ms)
+#define LINK_PERIOD             5000 // (ms)
+#define ERROR_PERIOD            250 // (ms) one logged event each
+#define BATTERY_PERIOD          10000 // (ms)
+#define BATTERY_MILLIVOLTS      33000L // full scale, 3.3 V through 10:1
+#define AD_FULL_SCALE           1023
+
+#define CLAMP(x, low, high)     (((x) < (low))? (low) : (((x) > (high))? (high) : (x)))
+
+/***********************************************************************
+ * PRIVATE VARIABLES                                                   *
+ ***********************************************************************/
+
+static struct {
+    TelemetrySend send;
+    uint16_t period; // (ms)
+    uint16_t bytes; // most one message costs
+    uint8_t priority;
+    uint32_t next; // (ms) get_time() it's due at
+    TelemetryStats stats;
+} streams[TELEMETRY_STREAM_MAX];
+
+static uint8_t streamCount = 0;
+static StreamId order[TELEMETRY_STREAM_MAX]; // by priority
+
+static uint32_t tokens = 0; // (bytes / MILLI)
+static uint16_t rate = 0, rateMax = 0; // (bytes/s)
+static uint32_t lastRefill = 0, lastAdapt = 0;
+static BOOL wantedMore = FALSE; // since the last rate change
+static uint32_t lastTxFailed = 0;
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static void adaptRate(uint32_t now);
+static uint16_t sendLink();
+static uint16_t sendError();
+#ifdef USE_GPS
+static uint16_t sendPosition();
+#endif
+#ifdef USE_THERMAL
+static uint16_t sendThermal();
+#endif
+#ifdef USE_BATTERY
+static uint16_t sendBattery();
+#endif
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+void Telemetry_init(uint16_t bytesPerSecond) {
+    streamCount = 0;
+    rate = rateMax = (bytesPerSecond < TELEMETRY_RATE_MIN)?
+        TELEMETRY_RATE_MIN : bytesPerSecond;
+    tokens = TELEMETRY_BURST * MILLI;
+    lastRefill = lastAdapt = get_time();
+    wantedMore = FALSE;
+    if (Xbee_isApiMode()) {
+        XbeeStats xbee;
+        Xbee_getStats(&xbee);
+        lastTxFailed = xbee.txFailed;
+    }
+}
+
+StreamId Telemetry_addStream(TelemetrySend send, uint16_t period,
+        uint8_t priority, uint16_t bytes) {
+    StreamId stream = streamCount;
+    uint8_t i;
+
+    if (streamCount >= TELEMETRY_STREAM_MAX || send == NULL)
+        return TELEMETRY_INVALID;
+    streams[stream].send = send;
+    streams[stream].period = period;
+    streams[stream].bytes = bytes;
+    streams[stream].priority = priority;
+    streams[stream].next = get_time();
+    streams[stream].stats.sent = 0;
+    streams[stream].stats.bytes = 0;
+    streams[stream].stats.decimated = 0;
+
+    // Behind every stream of the same or a more important priority
+    for (i = streamCount; i > 0
+            && streams[order[i - 1]].priority > priority; i--)
+        order[i] = order[i - 1];
+    order[i] = stream;
+    streamCount++;
+    return stream;
+}
+
+int8_t Telemetry_setPeriod(StreamId stream, uint16_t period) {
+    if (stream >= streamCount)
+        return FAILURE;
+    streams[stream].period = period;
+    return SUCCESS;
+}
+
+void Telemetry_runSM() {
+    uint32_t now = get_time();
+    uint16_t sent;
+    uint8_t i;
+    BOOL isShort = FALSE;
+
+    tokens += (uint32_t)rate * (now - lastRefill);
+    if (tokens > TELEMETRY_BURST * MILLI)
+        tokens = TELEMETRY_BURST * MILLI;
+    lastRefill = now;
+
+    for (i = 0; i < streamCount; i++) {
+        StreamId stream = order[i];
+        int32_t late = (int32_t)(now - streams[stream].next);
+        if (late < 0)
+            continue;
+
+        if (!isShort && tokens >= streams[stream].bytes * MILLI
+                && UART_getTransmitSpace(XBEE_UART_ID)
+                    >= streams[stream].bytes + TELEMETRY_TX_RESERVE) {
+            sent = streams[stream].send();
+            if (sent > 0) {
+                tokens -= CLAMP(sent, 0, streams[stream].bytes) * MILLI;
+                streams[stream].stats.sent++;
+                streams[stream].stats.bytes += sent;
+            }
+            // Keep to the period, but don't make up for a long stall
+            streams[stream].next = (late >= streams[stream].period)?
+                now + streams[stream].period
+                : streams[stream].next + streams[stream].period;
+        }
+        else {
+            isShort = TRUE;
+            wantedMore = TRUE;
+            if (late >= streams[stream].period) {
+                streams[stream].stats.decimated++;
+                streams[stream].next += streams[stream].period;
+            }
+        }
+    }
+
+    if (now - lastAdapt >= TELEMETRY_ADAPT_PERIOD)
+        adaptRate(now);
+}
+
+uint16_t Telemetry_getRate() {
+    return rate;
+}
+
+int8_t Telemetry_getStats(StreamId stream, TelemetryStats *stats) {
+    uint8_t i;
+    if (stream != TELEMETRY_INVALID) {
+        if (stream >= streamCount)
+            return FAILURE;
+        *stats = streams[stream].stats;
+        return SUCCESS;
+    }
+    stats->sent = stats->bytes = stats->decimated = 0;
+    for (i = 0; i < streamCount; i++) {
+        stats->sent += streams[i].stats.sent;
+        stats->bytes += streams[i].stats.bytes;
+        stats->decimated += streams[i].stats.decimated;
+    }
+    return SUCCESS;
+}
+
+void Telemetry_addBoatStreams() {
+    #ifdef USE_GPS
+    Telemetry_addStream(sendPosition, POSITION_PERIOD, TELEMETRY_PRIORITY_HIGH,
+        MESSAGE_BYTES(MAVLINK_MSG_ID_BOAT_POSITION_LEN));
+    #endif
+    #ifdef USE_THERMAL
+    Telemetry_addStream(sendThermal, THERMAL_PERIOD, TELEMETRY_PRIORITY_NORMAL,
+        MESSAGE_BYTES(MAVLINK_MSG_ID_THERMAL_TARGET_LEN));
+    #endif
+    Telemetry_addStream(sendLink, LINK_PERIOD, TELEMETRY_PRIORITY_NORMAL,
+        MESSAGE_BYTES(MAVLINK_MSG_ID_XBEE_STATUS_LEN));
+    Telemetry_addStream(sendError, ERROR_PERIOD, TELEMETRY_PRIORITY_NORMAL,
+        MESSAGE_BYTES(MAVLINK_MSG_ID_ERROR_EVENT_LEN));
+    #ifdef USE_BATTERY
+    Telemetry_addStream(sendBattery, BATTERY_PERIOD, TELEMETRY_PRIORITY_LOW,
+        MESSAGE_BYTES(MAVLINK_MSG_ID_BATTERY_LEN));
+    #endif
+}
+
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: adaptRate
+ * @param (ms) Now.
+ * @return None
+ * @remark Backs off by a quarter when the radio gave up on packets since
+ *  the last time, or either end is losing more than LOSS_MAX of the
+ *  heartbeats, and creeps up while the streams want more. With the
+ *  connection lost there's nothing to go on, so the rate stays put.
+ **********************************************************************/
+static void adaptRate(uint32_t now) {
+    XbeeStats xbee;
+    XbeeLinkQuality link;
+    BOOL isFailing = FALSE;
+
+    lastAdapt = now;
+    if (Xbee_isApiMode()) {
+        Xbee_getStats(&xbee);
+        isFailing = (xbee.txFailed != lastTxFailed);
+        lastTxFailed = xbee.txFailed;
+    }
+    Xbee_getLinkQuality(&link);
+    if (link.isConnected) {
+        if (isFailing || link.loss > LOSS_MAX || link.peerLoss > LOSS_MAX)
+            rate -= rate / 4;
+        else if (wantedMore)
+            rate += TELEMETRY_RATE_STEP;
+        rate = CLAMP(rate, TELEMETRY_RATE_MIN, rateMax);
+    }
+    wantedMore = FALSE;
+}
+
+static uint16_t sendLink() {
+    TelemetryStats total;
+    Telemetry_getStats(TELEMETRY_INVALID, &total);
+    Mavlink_send_xbee_status(XBEE_UART_ID, rate, total.decimated);
+    return MESSAGE_BYTES(MAVLINK_MSG_ID_XBEE_STATUS_LEN);
+}
+
+// Nothing sent while the log is empty
+static uint16_t sendError() {
+    if (Mavlink_send_error_events(XBEE_UART_ID, 1) == 0)
+        return 0;
+    return MESSAGE_BYTES(MAVLINK_MSG_ID_ERROR_EVENT_LEN);
+}
+
+#ifdef USE_GPS
+static uint16_t sendPosition() {
+    GpsCoordinate coord;
+    int32_t north, east, heading, accuracy; // (cm/s), (centidegrees), (cm)
+    uint32_t time;
+    uint8_t guidance = 0;
+    #ifdef USE_SENSOR_FUSION
+    Pose pose;
+    if (!Navigation_getPose(&pose) || !Navigation_getPoseCoordinate(&coord))
+        return 0;
+    north = (int32_t)(pose.velocityNorth * 100.0f);
+    east = (int32_t)(pose.velocityEast * 100.0f);
+    heading = (int32_t)(pose.heading * 100.0f);
+    accuracy = (int32_t)(pose.accuracy * 100.0f);
+    time = pose.time;
+    #else
+    if (!GPS_hasFix() || !GPS_hasPosition())
+        return 0;
+    GPS_getCoordinate(&coord);
+    north = GPS_getNorthVelocity();
+    east = GPS_getEastVelocity();
+    heading = GPS_getHeading() / 1000;
+    accuracy = (int32_t)(GPS_getHorizontalAccuracy() / 10);
+    time = get_time();
+    #endif
+    #ifdef USE_GUIDANCE
+    guidance = (uint8_t)Guidance_getState();
+    #endif
+
+    Mavlink_send_boat_position(XBEE_UART_ID, time, coord.latitude,
+        coord.longitude, (int16_t)CLAMP(north, -32767, 32767),
+        (int16_t)CLAMP(east, -32767, 32767),
+        (uint16_t)CLAMP(heading, 0, 35999), (uint16_t)CLAMP(accuracy, 0, 65535),
+        guidance);
+    return MESSAGE_BYTES(MAVLINK_MSG_ID_BOAT_POSITION_LEN);
+}
+#endif
+
+#ifdef USE_THERMAL
+static uint16_t sendThermal() {
+    ThermalTarget target;
+    if (!Thermal_getTarget(&target)) {
+        Mavlink_send_thermal_target(XBEE_UART_ID, get_time(), 0, 0, 0, 0);
+    }
+    else {
+        Mavlink_send_thermal_target(XBEE_UART_ID, target.time,
+            (uint16_t)CLAMP(target.heading * 100.0f, 0.0f, 35999.0f),
+            (int16_t)(target.elevation * 100.0f),
+            (int16_t)CLAMP(target.peak * 100.0f, 0.0f, 32767.0f),
+            target.pixels);
+    }
+    return MESSAGE_BYTES(MAVLINK_MSG_ID_THERMAL_TARGET_LEN);
+}
+#endif
+
+#ifdef USE_BATTERY
+static uint16_t sendBattery() {
+    unsigned int raw = AD_readAverage(BAT_VOLTAGE);
+    if (raw == (unsigned int)ERROR)
+        return 0;
+    Mavlink_send_battery(XBEE_UART_ID, get_time(),
+        (uint16_t)(raw * BATTERY_MILLIVOLTS / AD_FULL_SCALE));
+    return MESSAGE_BYTES(MAVLINK_MSG_ID_BATTERY_LEN);
+}
+#endif
+
+//#define TELEMETRY_TEST
+#ifdef TELEMETRY_TEST
+
+#include <stdio.h>
+#include "Serial.h"
+
+#define PRINT_DELAY     5000
+
+int main() {
+    TelemetryStats total;
+    Board_init();
+    Serial_init();
+    Timer_init();
+    Xbee_init();
+    Telemetry_init(1000);
+    Telemetry_addBoatStreams();
+    printf("Telemetry test, %u bytes/s\n", Telemetry_getRate());
+
+    Timer_new(TIMER_TEST, PRINT_DELAY);
+    while (1) {
+        Xbee_runSM();
+        Telemetry_runSM();
+        if (Timer_isExpired(TIMER_TEST)) {
+            Timer_new(TIMER_TEST, PRINT_DELAY);
+            Telemetry_getStats(TELEMETRY_INVALID, &total);
+            printf("Sent %lu messages, %lu bytes, %lu decimated, rate %u bytes/s\n",
+                (unsigned long)total.sent, (unsigned long)total.bytes,
+                (unsigned long)total.decimated, Telemetry_getRate());
+        }
+    }
+    return SUCCESS;
+}
+
+#endif
@@ -7,11 +7,16 @@
 
 #include <xc.h>
 #include <stdio.h>
+#include <string.h>
 #include <plib.h>
 #include "Board.h"
 #include "I2C.h"
 #include "Serial.h"
 #include "Timer.h"
+#include "FastMath.h"
+#include "Thermal.h"
+#include "Boot.h"
+#include "Nvm.h"
 #include <math.h>
 
 //#define DEBUG
@@ -20,22 +25,86 @@
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 
-#define EEPROM_WRITE_ADDRESS            0xA0
-#define EEPROM_READ_ADDRESS             0xA1
-#define CAMERA_WRITE_ADDRESS            0xC0
-#define CAMERA_READ_ADDRESS             0xC1
+#define EEPROM_ADDRESS                  0x50
+#define CAMERA_ADDRESS                  0x60
+#define SLAVE_CLOCK_FREQ                400000 // (Hz) fast mode, both of them
 
 #define EEPROM_READ_COMMAND             0x00
 #define CAMERA_READ_COMMAND             0x02
 #define CAMERA_WRITE_CONFIG_COMMAND     0x03
 #define CAMERA_WRITE_TRIM_COMMAND       0x04
 
+#define EEPROM_HALF                     128
 
-#define TOTAL_PIXEL_ROWS    4
-#define TOTAL_PIXEL_COLS    16
-#define TOTAL_PIXELS        (TOTAL_PIXEL_ROWS * TOTAL_PIXEL_COLS)
+// Camera RAM
+#define PIXEL_ADDRESS                   0x00
+#define PTAT_ADDRESS                    0x90
+#define CPIXEL_ADDRESS                  0x91 // right after the PTAT
+#define CONFIG_ADDRESS                  0x92
 
-#define READ_DELAY      100
+
+#define TOTAL_PIXEL_ROWS    THERMAL_ROWS
+#define TOTAL_PIXEL_COLS    THERMAL_COLUMNS
+#define TOTAL_PIXELS        THERMAL_PIXELS
+
+// IR refresh rate in the config register's low bits, 16 Hz, and a read a
+//  frame. The conversion below takes well under a frame even at 64 Hz.
+#define REFRESH_RATE_BITS   0x0A
+#define READ_DELAY          63 // (ms)
+
+#define CELSIUS_TO_KELVIN   273.15f
+
+// Background weights as shifts, 1/16 of a new frame, and 1/256 where a blob
+//  is, so something warm that stays put fades in over half a minute
+#define BACKGROUND_SHIFT        4
+#define BACKGROUND_BLOB_SHIFT   8
+#define BACKGROUND_FRAMES       16 // learnt before anything is reported
+
+#define UNLABELLED          0xFF
+
+#define WRITE_COMMAND_LENGTH    5 // the command and two bytes, each checked
+
+// EEPROM bytes compared with the kept calibration to tell it's the same
+//  camera, Tgc, B_iscale, V_th, K_t1 and K_t2
+#define SIGNATURE_ADDRESS       216
+#define SIGNATURE_LENGTH        8
+#define TRIM_ADDRESS            247
+#define CONFIG_LOW_ADDRESS      245
+#define CONFIG_HIGH_ADDRESS     246
+
+/***********************************************************************
+ * PRIVATE TYPEDEFS                                                    *
+ ***********************************************************************/
+
+// Bring-up, see Thermal_initSM
+typedef enum {
+    INIT_START = 0,
+    INIT_SIGNATURE,     // reading the EEPROM bytes the kept calibration has
+    INIT_EEPROM_LOW,    // reading the first half of the EEPROM
+    INIT_EEPROM_HIGH,   // and the second
+    INIT_TRIM,          // writing the oscillator trim
+    INIT_CONFIG,        // writing the config register
+    INIT_READ_CONFIG,   // reading it back
+    INIT_DONE,
+    INIT_FAILED,
+} InitState;
+
+// Calibration kept in the store, see NVM_KEY_THERMAL. The per pixel floats
+//  are worked out again from it, they'd take 768 bytes.
+typedef struct {
+    UINT8 signature[SIGNATURE_LENGTH]; // EEPROM at SIGNATURE_ADDRESS
+    UINT8 trim, configLow, configHigh; // EEPROM the set up writes
+    int8_t A_cp, B_cp, Tgc;
+    UINT8 B_iscale;
+    int8_t A_ij[TOTAL_PIXELS], B_ij[TOTAL_PIXELS];
+    float V_th, K_t1, K_t2, emissivity;
+} Calibration;
+
+typedef struct {
+    float temperature[TOTAL_PIXELS]; // (degrees F)
+    float yaw; // (degrees) at capture
+    uint32_t time; // (ms) at capture
+} Frame;
 
 /***********************************************************************
  * PRIVATE VARIABLES                                                   *
@@ -48,10 +117,17 @@ UINT32          I2C_CLOCK_FREQ = 100000;
 UINT8           eepromData[256];
 UINT16          rawTemp;
 float           V_th, K_t1, K_t2, chipTempC, chipTempF, emissivity;
-float           V_ir_tgc_comp[TOTAL_PIXELS], finalPixelTempF[TOTAL_PIXELS],V_off_comp[TOTAL_PIXELS];
+float           V_ir_tgc_comp[TOTAL_PIXELS], V_off_comp[TOTAL_PIXELS];
 int             pixelData[TOTAL_PIXELS], A_cp, B_cp, Tgc, B_iscale, CPixel;
 int             A_ij[TOTAL_PIXELS], B_ij[TOTAL_PIXELS];
 
+// Per pixel terms from configCalculationData, and the ones that only change
+//  with the chip temperature from calculateChipTemp
+float           offsetSlope[TOTAL_PIXELS]; // B_ij / 2^B_iscale
+float           inverseAlpha[TOTAL_PIXELS];
+float           pixelOffset[TOTAL_PIXELS]; // A_ij + slope * (chip - 25 C)
+float           chipTempK4; // (K^4) of the chip
+
 float alpha[TOTAL_PIXELS] = {1.79866E-8,1.96164E-8,1.93836E-8,1.65314E-8,2.03149E-8,2.13045E-8,
                             2.08388E-8,1.84523E-8,2.13045E-8,2.29343E-8,2.24686E-8,2.00239E-8,2.22358E-8,2.3691E-8,
                             2.27014E-8,2.15373E-8,2.32835E-8,2.5088E-8,2.5088E-8,2.27014E-8,2.41566E-8,2.63103E-8,
@@ -64,17 +140,53 @@ float alpha[TOTAL_PIXELS] = {1.79866E-8,1.96164E-8,1.93836E-8,1.65314E-8,2.03149
 
 uint8_t count = 0;
 
+// Captured into frames[!front] while frames[front] is processed and read
+Frame           frames[2];
+uint8_t         front = 0;
+BOOL            frameReady = FALSE;
+float           currentYaw = 0.0f;
+
+float           background[TOTAL_PIXELS];
+uint8_t         backgroundFrames = 0;
+uint8_t         label[TOTAL_PIXELS];
+ThermalTarget   target;
+BOOL            hasTarget = FALSE;
+uint32_t        maxProcessCycles = 0;
+
+// Frame capture in the background, both reads queued at once so they run
+//  back to back in the I2C interrupt
+UINT8           pixelCommand[4] = { CAMERA_READ_COMMAND, PIXEL_ADDRESS, 1,
+                    TOTAL_PIXELS };
+UINT8           compensationCommand[4] = { CAMERA_READ_COMMAND, PTAT_ADDRESS,
+                    1, 2 };
+UINT8           rawPixels[TOTAL_PIXELS * 2];
+UINT8           rawCompensation[4]; // PTAT then the compensation pixel
+I2CTransfer     pixelTransfer, compensationTransfer;
+BOOL            isCapturing = FALSE;
+uint32_t        droppedFrames = 0;
+
+// Bring-up, one queued transfer at a time
+InitState       initState = INIT_START;
+I2CTransfer     initTransfer;
+UINT8           initCommand[WRITE_COMMAND_LENGTH];
+UINT8           config[2];
+Calibration     calibration;
+
 
 /***********************************************************************
  * PRIVATE PROTOTYPES                                                  *
  ***********************************************************************/
-void readEeprom(void);
-void readConfigReg(void);
-void writeTrimmingValue(void);
+BOOL readEeprom(UINT8 offset);
+BOOL readConfigReg(void);
+BOOL writeTrimmingValue(void);
 
-void writeConfigReg(void);
+BOOL writeConfigReg(void);
+BOOL submitInit(UINT8 commandLength, UINT8 *data, UINT8 dataLength);
 
 void configCalculationData(void);
+void configPixels(void);
+void keepCalibration(void);
+void loadCalibration(void);
 
 
 void readChipTemp(void);
@@ -83,8 +195,15 @@ void calculateChipTemp(void);
 
 void readCPixelValue(void);
 void readPixelValue(void);
-
-void calculateIRTemp(void);
+BOOL readCamera(UINT8 address, UINT8 words, UINT8 *data);
+BOOL startCapture(Frame *frame);
+void convertPixels(const UINT8 *raw);
+
+void calculateIRTemp(float *temperatures);
+void finishCapture(Frame *frame);
+void processFrame(const Frame *frame);
+uint8_t fillBlob(uint8_t seed, uint8_t blob, const float *excess,
+    float *weight, float *sumColumn, float *sumRow, float *peak);
 /***********************************************************************
  * PUBLIC FUNCTIONS                                                    *
  ***********************************************************************/
@@ -92,229 +211,223 @@ void calculateIRTemp(void);
 
 void Thermal_init(){
     I2C_init(THERMAL_I2C_ID,I2C_CLOCK_FREQ);
+    I2C_addDevice(THERMAL_I2C_ID, EEPROM_ADDRESS, SLAVE_CLOCK_FREQ);
+    I2C_addDevice(THERMAL_I2C_ID, CAMERA_ADDRESS, SLAVE_CLOCK_FREQ);
     count = 0;
+    front = 0;
+    frameReady = FALSE;
+    isCapturing = FALSE;
+    backgroundFrames = 0;
+    hasTarget = FALSE;
+
+    // The rest runs in the background, see Thermal_initSM
+    initState = INIT_START;
+    Thermal_initSM();
+}
+
+BootStatus Thermal_initSM() {
+    BOOL isSubmitted = FALSE;
+
+    if (initState == INIT_DONE)
+        return BOOT_READY;
+    if (initState == INIT_FAILED)
+        return BOOT_FAILED;
+
+    if (initState != INIT_START) {
+        // Every other state waits on the transfer it started
+        if (!I2C_IS_FINISHED(initTransfer.status))
+            return BOOT_PENDING;
+        if (initTransfer.status != I2C_TRANSFER_DONE) {
+            printf("FAILED to set up the camera (%d)!\n", initState);
+            initState = INIT_FAILED;
+            return BOOT_FAILED;
+        }
+    }
 
-    readEeprom();
-    writeTrimmingValue();
-    writeConfigReg();
-    readConfigReg();
-    configCalculationData();
+    switch (initState) {
+        case INIT_START:
+            if (Nvm_read(NVM_KEY_THERMAL, &calibration, sizeof(calibration))
+                    == SUCCESS) {
+                // Only a few bytes if it's the same camera
+                initState = INIT_SIGNATURE;
+                initCommand[0] = EEPROM_READ_COMMAND + SIGNATURE_ADDRESS;
+                initTransfer.address = EEPROM_ADDRESS;
+                isSubmitted = submitInit(1, &eepromData[SIGNATURE_ADDRESS],
+                    SIGNATURE_LENGTH);
+                break;
+            }
+            // Two halves, a transfer reads at most 255 bytes
+            initState = INIT_EEPROM_LOW;
+            isSubmitted = readEeprom(0);
+            break;
+        case INIT_SIGNATURE:
+            if (memcmp(&eepromData[SIGNATURE_ADDRESS], calibration.signature,
+                    SIGNATURE_LENGTH) == 0) {
+                loadCalibration();
+                initState = INIT_TRIM;
+                isSubmitted = writeTrimmingValue();
+            }
+            else {
+                printf("Thermal camera changed, reading its EEPROM.\n");
+                initState = INIT_EEPROM_LOW;
+                isSubmitted = readEeprom(0);
+            }
+            break;
+        case INIT_EEPROM_LOW:
+            initState = INIT_EEPROM_HIGH;
+            isSubmitted = readEeprom(EEPROM_HALF);
+            break;
+        case INIT_EEPROM_HIGH:
+            configCalculationData();
+            keepCalibration();
+            initState = INIT_TRIM;
+            isSubmitted = writeTrimmingValue();
+            break;
+        case INIT_TRIM:
+            initState = INIT_CONFIG;
+            isSubmitted = writeConfigReg();
+            break;
+        case INIT_CONFIG:
+            initState = INIT_READ_CONFIG;
+            isSubmitted = readConfigReg();
+            break;
+        case INIT_READ_CONFIG:
+            //printf("Config Data %x %x\n", config[1], config[0]);
+            Timer_new(TIMER_THERMAL,READ_DELAY);
+            initState = INIT_DONE;
+            return BOOT_READY;
+        default:
+            break;
+    }
 
-    Timer_new(TIMER_THERMAL,READ_DELAY);
+    if (!isSubmitted) {
+        printf("FAILED to queue the camera set up (%d)!\n", initState);
+        initState = INIT_FAILED;
+        return BOOT_FAILED;
+    }
+    return BOOT_PENDING;
 }
 
 void Thermal_runSM() {
-    if (Timer_isExpired(TIMER_THERMAL)) {
+    uint32_t start, cycles;
+    if (Thermal_initSM() != BOOT_READY)
+        return;
+    // The queue runs in order, so the second read finishing means both did
+    if (isCapturing && I2C_IS_FINISHED(compensationTransfer.status)) {
+        isCapturing = FALSE;
+        if (pixelTransfer.status == I2C_TRANSFER_DONE
+                && compensationTransfer.status == I2C_TRANSFER_DONE) {
+            finishCapture(&frames[!front]);
+            front = !front;
+            frameReady = TRUE;
+        }
+        else {
+            droppedFrames++;
+            #ifdef DEBUG
+            printf("FAILED to read frame!\n");
+            #endif
+        }
+    }
+    // Next frame goes on the bus while this one is processed
+    if (!isCapturing && Timer_isExpired(TIMER_THERMAL)) {
         #ifdef DEBUG
         printf("Reading sensor...\n");
         #endif
-        if(count == 0){
-            readChipTemp();
-            calculateChipTemp();
-        }
-        count++;
-        if(count >= 16){
-            count = 0;
-        }
-        readPixelValue();
-        readCPixelValue();
-        calculateIRTemp();
-
         Timer_new(TIMER_THERMAL,READ_DELAY);
+        isCapturing = startCapture(&frames[!front]);
+    }
+    if (frameReady) {
+        start = Timer_getCycles();
+        processFrame(&frames[front]);
+        cycles = Timer_getCycles() - start;
+        if (cycles > maxProcessCycles)
+            maxProcessCycles = cycles;
+        frameReady = FALSE;
     }
 }
 
-/*******************************************************************************
- * PRIVATE FUNCTIONS                                                          *
- ******************************************************************************/
+void Thermal_setYaw(float yaw) {
+    currentYaw = yaw;
+}
 
-void readEeprom(void){
-    BOOL success = FALSE;
-    int index;
+BOOL Thermal_getTarget(ThermalTarget *result) {
+    if (!hasTarget)
+        return FALSE;
+    *result = target;
+    return TRUE;
+}
 
-    do {
-        if(!I2C_startTransfer(THERMAL_I2C_ID, FALSE)){
-            #ifdef DEBUG
-            printf("FAILED initial transfer!\n");
-            #endif
-            break;
-        }
-        // Transmit the slave's address to notify it
-        if (!I2C_sendData(THERMAL_I2C_ID,EEPROM_WRITE_ADDRESS))
-            break;
+const float *Thermal_getFrame() {
+    return frames[front].temperature;
+}
 
-        // Tranmit the read address module
-        if(!I2C_sendData(THERMAL_I2C_ID,EEPROM_READ_COMMAND)){
-            #ifdef DEBUG
-            printf("Error: Sent byte was not acknowledged\n");
-            #endif
-            break;
-        }
+uint32_t Thermal_getProcessMicros() {
+    return TIMER_CYCLES_TO_MICROS(maxProcessCycles);
+}
 
-        // Send a Repeated Started condition
-        if(!I2C_startTransfer(THERMAL_I2C_ID,TRUE)){
-            #ifdef DEBUG
-                printf("FAILED Repeated start!\n");
-            #endif
-            break;
-        }
-        // Transmit the address with the READ bit set
-        if (!I2C_sendData(THERMAL_I2C_ID,EEPROM_READ_ADDRESS))
-            break;
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                          *
+ ******************************************************************************/
 
-        // Read the I2C bus most significant byte and send an acknowledge bit
-        for(index = 0; index <=0xFF; index++){
-            eepromData[index] = I2C_getData(THERMAL_I2C_ID);
-            if(index < 0xFF)
-                I2CAcknowledgeByte(I2C1, TRUE);
-            else
-                I2CAcknowledgeByte(I2C1, FALSE);
-            while(!I2CAcknowledgeHasCompleted(I2C1));
-        }
-        success = TRUE;
-    } while(0);
-    // Send the stop bit to finish the transfer
-    I2C_stopTransfer(THERMAL_I2C_ID);
-    if(!success){
-        printf("Data transfer unsuccessful.\n");
-        return;
-    }
-    // Stop transfer twice?
-    I2C_stopTransfer(THERMAL_I2C_ID);
-    int Index;
-    for(Index = 0; Index <=255; Index++){
-        while(!Serial_isTransmitEmpty());
-        //printf("EEPROM %x / %d: %x\n", Index, Index, eepromData[Index]);
-    }
-     
+// The bring-up transfers below only queue, Thermal_initSM waits on them
+BOOL readEeprom(UINT8 offset){
+    initCommand[0] = EEPROM_READ_COMMAND + offset;
+    initTransfer.address = EEPROM_ADDRESS;
+    //int Index;
+    //for(Index = 0; Index <=255; Index++){
+    //    while(!Serial_isTransmitEmpty());
+    //    printf("EEPROM %x / %d: %x\n", Index, Index, eepromData[Index]);
+    //}
+    return submitInit(1, &eepromData[offset], EEPROM_HALF);
 }
 
-void readConfigReg(void){
-    BOOL Success = TRUE;
-    UINT8 configMSB, configLSB;
-    if(!I2C_startTransfer(THERMAL_I2C_ID, FALSE)){
-        printf("FAILED initial transfer!\n");
-        Success = FALSE;
-    }
-// Transmit the slave's address to notify it
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_WRITE_ADDRESS)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_READ_COMMAND)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x92)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x00)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x01)){
-        Success = FALSE;
-    }
-    if(Success){
-    // Send a Repeated Started condition
-        if(!I2C_startTransfer(THERMAL_I2C_ID,TRUE)){
-            printf("FAILED Repeated start!\n");
-            Success = FALSE;
-        }
-    // Transmit the address with the READ bit set
-        if (!I2C_sendData(THERMAL_I2C_ID,CAMERA_READ_ADDRESS)){
-            Success = FALSE;
-        }
-    }
-    if(Success){
-    // Read the I2C bus most significan byte and send an acknowledge bit
-        configLSB = I2C_getData(THERMAL_I2C_ID);
-        I2CAcknowledgeByte(I2C1, TRUE);
-        while(!I2CAcknowledgeHasCompleted(THERMAL_I2C_ID));
-        configMSB = I2C_getData(THERMAL_I2C_ID);
-        }
-    I2C_stopTransfer(THERMAL_I2C_ID);
-        //while(!IsTransmitEmpty());
-        //printf("Config Data %x %x\n", configMSB, configLSB);
+BOOL readConfigReg(void){
+    initCommand[0] = CAMERA_READ_COMMAND;
+    initCommand[1] = CONFIG_ADDRESS;
+    initCommand[2] = 1;
+    initCommand[3] = 1;
+    initTransfer.address = CAMERA_ADDRESS;
+    return submitInit(4, config, sizeof(config));
 }
 
-void writeTrimmingValue(void){
-    BOOL Success = TRUE;
-    UINT8 MSByte, LSByte, MSByteCheck, LSByteCheck;
-    LSByte = eepromData[247];
-    LSByteCheck = LSByte - 0xAA;
+BOOL writeTrimmingValue(void){
+    UINT8 MSByte, LSByte;
+    LSByte = eepromData[TRIM_ADDRESS];
     MSByte = 0x00;
-    MSByteCheck = 0x56;
-    if(!I2C_startTransfer(THERMAL_I2C_ID, FALSE)){
-        printf("FAILED initial transfer!\n");
-        Success = FALSE;
-    }
-// Transmit the slave's address to notify it
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_WRITE_ADDRESS)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_WRITE_TRIM_COMMAND)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,LSByteCheck)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,LSByte)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,MSByteCheck)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,MSByte)){
-        Success = FALSE;
-    }
-    I2C_stopTransfer(THERMAL_I2C_ID);
+    // Each byte goes after a check byte
+    initCommand[0] = CAMERA_WRITE_TRIM_COMMAND;
+    initCommand[1] = LSByte - 0xAA;
+    initCommand[2] = LSByte;
+    initCommand[3] = 0x56;
+    initCommand[4] = MSByte;
+    initTransfer.address = CAMERA_ADDRESS;
+    return submitInit(WRITE_COMMAND_LENGTH, NULL, 0);
 }
 
-void writeConfigReg(void){
-    BOOL Success = TRUE;
-    UINT8 MSByte, LSByte, MSByteCheck, LSByteCheck;
-    LSByte = eepromData[245];
+BOOL writeConfigReg(void){
+    UINT8 MSByte, LSByte;
+    LSByte = eepromData[CONFIG_LOW_ADDRESS];
     LSByte &= 0xF0;
-    LSByte |= 0x0C;
-    LSByteCheck = LSByte - 0x55;
-    MSByte = eepromData[246];
-    MSByteCheck = MSByte - 0x55;
-    if(!I2C_startTransfer(THERMAL_I2C_ID, FALSE)){
-        printf("FAILED initial transfer!\n");
-        Success = FALSE;
-    }
-// Transmit the slave's address to notify it
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_WRITE_ADDRESS)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_WRITE_CONFIG_COMMAND)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,LSByteCheck)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,LSByte)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,MSByteCheck)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,MSByte)){
-        Success = FALSE;
-    }
-    I2C_stopTransfer(THERMAL_I2C_ID);
+    LSByte |= REFRESH_RATE_BITS;
+    MSByte = eepromData[CONFIG_HIGH_ADDRESS];
+    initCommand[0] = CAMERA_WRITE_CONFIG_COMMAND;
+    initCommand[1] = LSByte - 0x55;
+    initCommand[2] = LSByte;
+    initCommand[3] = MSByte - 0x55;
+    initCommand[4] = MSByte;
+    initTransfer.address = CAMERA_ADDRESS;
+    return submitInit(WRITE_COMMAND_LENGTH, NULL, 0);
+}
+
+// Queues initTransfer with initCommand, to the address already set
+BOOL submitInit(UINT8 commandLength, UINT8 *data, UINT8 dataLength){
+    initTransfer.write = initCommand;
+    initTransfer.writeLength = commandLength;
+    initTransfer.read = data;
+    initTransfer.readLength = dataLength;
+    initTransfer.callback = NULL;
+    initTransfer.context = NULL;
+    return I2C_submit(THERMAL_I2C_ID, &initTransfer) == SUCCESS;
 }
 
 void configCalculationData(void){
@@ -351,186 +464,337 @@ void configCalculationData(void){
             B_ij[i] = B_ij[i] - 256;
         }
     }
+    configPixels();
 }
 
-void readChipTemp(void){
-    BOOL Success = TRUE;
-    UINT8 tempMSB, tempLSB;
-    if(!I2C_startTransfer(THERMAL_I2C_ID, FALSE)){
-        printf("FAILED initial transfer!\n");
-        Success = FALSE;
-    }
-// Transmit the slave's address to notify it
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_WRITE_ADDRESS)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_READ_COMMAND)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x90)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x00)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x01)){
-        Success = FALSE;
+// Per pixel terms from A_ij, B_ij and B_iscale
+void configPixels(void){
+    int i;
+    float slopeScale = 1.0f / (float)(1UL << B_iscale);
+    for(i = 0; i <= 63; i++){
+        offsetSlope[i] = B_ij[i] * slopeScale;
+        inverseAlpha[i] = 1.0f / alpha[i];
+        pixelOffset[i] = A_ij[i];
     }
-    if(Success){
-    // Send a Repeated Started condition
-        if(!I2C_startTransfer(THERMAL_I2C_ID,TRUE)){
-            printf("FAILED Repeated start!\n");
-            Success = FALSE;
-        }
-    // Transmit the address with the READ bit set
-        if (!I2C_sendData(THERMAL_I2C_ID,CAMERA_READ_ADDRESS)){
-            Success = FALSE;
-        }
+}
+
+// Keeps what configCalculationData worked out, and the bytes the set up
+//  writes, for the next boot
+void keepCalibration(void){
+    int i;
+    memcpy(calibration.signature, &eepromData[SIGNATURE_ADDRESS],
+        SIGNATURE_LENGTH);
+    calibration.trim = eepromData[TRIM_ADDRESS];
+    calibration.configLow = eepromData[CONFIG_LOW_ADDRESS];
+    calibration.configHigh = eepromData[CONFIG_HIGH_ADDRESS];
+    calibration.A_cp = A_cp;
+    calibration.B_cp = B_cp;
+    calibration.Tgc = Tgc;
+    calibration.B_iscale = B_iscale;
+    for(i = 0; i <= 63; i++){
+        calibration.A_ij[i] = A_ij[i];
+        calibration.B_ij[i] = B_ij[i];
+    }
+    calibration.V_th = V_th;
+    calibration.K_t1 = K_t1;
+    calibration.K_t2 = K_t2;
+    calibration.emissivity = emissivity;
+    Nvm_write(NVM_KEY_THERMAL, &calibration, sizeof(calibration));
+}
+
+// The other way, instead of reading the whole EEPROM
+void loadCalibration(void){
+    int i;
+    eepromData[TRIM_ADDRESS] = calibration.trim;
+    eepromData[CONFIG_LOW_ADDRESS] = calibration.configLow;
+    eepromData[CONFIG_HIGH_ADDRESS] = calibration.configHigh;
+    A_cp = calibration.A_cp;
+    B_cp = calibration.B_cp;
+    Tgc = calibration.Tgc;
+    B_iscale = calibration.B_iscale;
+    for(i = 0; i <= 63; i++){
+        A_ij[i] = calibration.A_ij[i];
+        B_ij[i] = calibration.B_ij[i];
+    }
+    V_th = calibration.V_th;
+    K_t1 = calibration.K_t1;
+    K_t2 = calibration.K_t2;
+    emissivity = calibration.emissivity;
+    configPixels();
+}
+
+void readChipTemp(void){
+    UINT8 temp[2];
+    if (!readCamera(PTAT_ADDRESS, 1, temp)) {
+        printf("FAILED to read chip temperature!\n");
+        return;
     }
-    if(Success){
-    // Read the I2C bus most significan byte and send an acknowledge bit
-        tempLSB = I2C_getData(THERMAL_I2C_ID);
-        I2CAcknowledgeByte(THERMAL_I2C_ID, TRUE);
-        while(!I2CAcknowledgeHasCompleted(THERMAL_I2C_ID));
-        tempMSB = I2C_getData(THERMAL_I2C_ID);
-        I2CAcknowledgeByte(THERMAL_I2C_ID, TRUE);
-        while(!I2CAcknowledgeHasCompleted(THERMAL_I2C_ID));
-        }
-    I2C_stopTransfer(THERMAL_I2C_ID);
-        rawTemp = (tempMSB << 8) + tempLSB;
+    rawTemp = (temp[1] << 8) + temp[0];
 }
 
 void readCPixelValue(void){
-    BOOL Success = TRUE;
-    UINT8 CPixelMSB, CPixelLSB;
-    if(!I2C_startTransfer(THERMAL_I2C_ID, FALSE)){
-        printf("FAILED initial transfer!\n");
-        Success = FALSE;
-    }
-// Transmit the slave's address to notify it
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_WRITE_ADDRESS)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_READ_COMMAND)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x91)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x00)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x01)){
-        Success = FALSE;
-    }
-    if(Success){
-    // Send a Repeated Started condition
-        if(!I2C_startTransfer(THERMAL_I2C_ID,TRUE)){
-            printf("FAILED Repeated start!\n");
-            Success = FALSE;
-        }
-    // Transmit the address with the READ bit set
-        if (!I2C_sendData(THERMAL_I2C_ID,CAMERA_READ_ADDRESS)){
-            Success = FALSE;
-        }
-    }
-    if(Success){
-    // Read the I2C bus most significan byte and send an acknowledge bit
-        CPixelLSB = I2C_getData(THERMAL_I2C_ID);
-        I2CAcknowledgeByte(I2C1, TRUE);
-        while(!I2CAcknowledgeHasCompleted(THERMAL_I2C_ID));
-        CPixelMSB = I2C_getData(THERMAL_I2C_ID);
-        I2CAcknowledgeByte(I2C1, TRUE);
-        while(!I2CAcknowledgeHasCompleted(THERMAL_I2C_ID));
-        CPixel = (CPixelMSB << 8) + CPixelLSB;
-    }
-    I2C_stopTransfer(THERMAL_I2C_ID);
-    if(CPixel > 32767){
-        CPixel = CPixel - 65536;
+    UINT8 raw[2];
+    if (!readCamera(CPIXEL_ADDRESS, 1, raw)) {
+        printf("FAILED to read compensation pixel!\n");
+        return;
     }
+    CPixel = (int16_t)((raw[1] << 8) + raw[0]);
 }
 
 void readPixelValue(void){
-    int Index = 0;
-    BOOL Success = TRUE;
-    UINT8 pixelMSB, pixelLSB;
-    if(!I2C_startTransfer(THERMAL_I2C_ID, FALSE)){
-        printf("FAILED initial transfer!\n");
-        Success = FALSE;
-    }
-// Transmit the slave's address to notify it
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_WRITE_ADDRESS)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,CAMERA_READ_COMMAND)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x00)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x01)){
-        Success = FALSE;
-    }
-// Tranmit the read address module
-    if(!I2C_sendData(THERMAL_I2C_ID,0x40)){
-        Success = FALSE;
-    }
-    if(Success){
-    // Send a Repeated Started condition
-        if(!I2C_startTransfer(THERMAL_I2C_ID,TRUE)){
-            printf("FAILED Repeated start!\n");
-            Success = FALSE;
-        }
-    // Transmit the address with the READ bit set
-        if (!I2C_sendData(THERMAL_I2C_ID,CAMERA_READ_ADDRESS)){
-            Success = FALSE;
-        }
-    }
-    if(Success){
-    // Read the I2C bus most significan byte and send an acknowledge bit
-        for(Index = 0; Index <=63; Index++){
-            pixelLSB = I2C_getData(THERMAL_I2C_ID);
-            I2CAcknowledgeByte(I2C1, TRUE);
-            while(!I2CAcknowledgeHasCompleted(THERMAL_I2C_ID));
-            pixelMSB = I2C_getData(THERMAL_I2C_ID);
-            I2CAcknowledgeByte(I2C1, TRUE);
-            while(!I2CAcknowledgeHasCompleted(THERMAL_I2C_ID));
-            pixelData[Index] = (pixelMSB << 8) + pixelLSB;
-            if(pixelData[Index] > 32767)
-                pixelData[Index] = pixelData[Index] - 65536;
-        }
+    UINT8 raw[TOTAL_PIXELS * 2];
+    if (!readCamera(PIXEL_ADDRESS, TOTAL_PIXELS, raw)) {
+        printf("FAILED to read pixels!\n");
+        return;
     }
-    I2C_stopTransfer(THERMAL_I2C_ID);
+    convertPixels(raw);
 }
 
+/**
+ * Function: convertPixels
+ * @param The 128 bytes of pixel RAM, each pixel low byte first.
+ * @return None.
+ * @remark Signed pixels out of the raw block, separate from the bus so it
+ *  runs as one tight loop.
+ */
+void convertPixels(const UINT8 *raw){
+    int Index;
+    for(Index = 0; Index < TOTAL_PIXELS; Index++)
+        pixelData[Index] = (int16_t)((raw[2*Index + 1] << 8) | raw[2*Index]);
+}
+
+/**
+ * Function: readCamera
+ * @param First RAM address to read.
+ * @param Number of 16-bit words to read.
+ * @param Where to store them, low byte first.
+ * @return TRUE, or FALSE if the camera didn't answer.
+ * @remark The read command carries the start address, the address step
+ *  and the number of reads, followed by a repeated start and the data.
+ */
+BOOL readCamera(UINT8 address, UINT8 words, UINT8 *data) {
+    UINT8 command[4] = { CAMERA_READ_COMMAND, address, 1, words };
+    I2CTransfer transfer = {
+        .address = CAMERA_ADDRESS,
+        .write = command,
+        .writeLength = sizeof(command),
+        .read = data,
+        .readLength = 2 * words,
+    };
+    return I2C_transfer(THERMAL_I2C_ID, &transfer) == I2C_TRANSFER_DONE;
+}
+
+/**
+ * Function: calculateChipTemp
+ * @return None.
+ * @remark Converts the PTAT reading, and updates everything in the pixel
+ *  conversion that only depends on the chip temperature.
+ */
 void calculateChipTemp(void){
-    chipTempC = ((-K_t1+sqrt(pow(K_t1,2)-(4*K_t2*(V_th-(float)rawTemp))))/(2*K_t2))+25;
+    int i;
+    float chipTempK, chipDelta;
+    chipTempC = ((-K_t1+sqrtf(K_t1*K_t1-(4*K_t2*(V_th-(float)rawTemp))))/(2*K_t2))+25;
     chipTempF = (chipTempC*9/5)+32;
     //printf("Chip TempC: %.2f\nChip TempF: %.2f\n",chipTempC, chipTempF);
+
+    chipTempK = chipTempC + CELSIUS_TO_KELVIN;
+    chipTempK4 = (chipTempK * chipTempK) * (chipTempK * chipTempK);
+    chipDelta = chipTempC - 25;
+    for(i = 0; i < TOTAL_PIXELS; ++i)
+        pixelOffset[i] = A_ij[i] + offsetSlope[i] * chipDelta;
 }
 
-void calculateIRTemp(void){
+/**
+ * Function: calculateIRTemp
+ * @param (degrees F) Where to put the TOTAL_PIXELS temperatures.
+ * @return None.
+ * @remark Per pixel, an offset, a multiply and the fourth root, which
+ *  FastMath_fourthRoot gives to 1e-6, a few thousandths of a degree.
+ */
+void calculateIRTemp(float *temperatures){
     int i = 0;
     for(i = 0; i < TOTAL_PIXELS; ++i){
-        V_off_comp[i] = pixelData[i] - (A_ij[i] + (float)(B_ij[i]/pow(2,B_iscale))*
-                           (chipTempC - 25));
-        finalPixelTempF[i] = sqrt(sqrt((V_off_comp[i]/alpha[i]) +
-                            pow((chipTempC + 273.15),4))) - 273.15;
-        finalPixelTempF[i] = finalPixelTempF[i]*9/5 + 32;
+        V_off_comp[i] = pixelData[i] - pixelOffset[i];
+        temperatures[i] = (FastMath_fourthRoot(V_off_comp[i] * inverseAlpha[i]
+            + chipTempK4) - CELSIUS_TO_KELVIN) * 1.8f + 32;
     }
 }
 
+/**
+ * Function: startCapture
+ * @param Buffer the frame goes into, not the one being processed.
+ * @return TRUE if the reads were queued.
+ * @remark Queues the whole pixel RAM as one read, and the PTAT with the
+ *  compensation pixel after it as another, they're next to each other.
+ *  The gap between them in RAM is too long to read through in one.
+ */
+BOOL startCapture(Frame *frame){
+    pixelTransfer.address = CAMERA_ADDRESS;
+    pixelTransfer.write = pixelCommand;
+    pixelTransfer.writeLength = sizeof(pixelCommand);
+    pixelTransfer.read = rawPixels;
+    pixelTransfer.readLength = sizeof(rawPixels);
+    pixelTransfer.callback = NULL;
+
+    compensationTransfer.address = CAMERA_ADDRESS;
+    compensationTransfer.write = compensationCommand;
+    compensationTransfer.writeLength = sizeof(compensationCommand);
+    compensationTransfer.read = rawCompensation;
+    compensationTransfer.readLength = sizeof(rawCompensation);
+    compensationTransfer.callback = NULL;
+
+    frame->yaw = currentYaw;
+    frame->time = get_time();
+    if (I2C_submit(THERMAL_I2C_ID, &pixelTransfer) != SUCCESS)
+        return FALSE;
+    if (I2C_submit(THERMAL_I2C_ID, &compensationTransfer) != SUCCESS) {
+        while (!I2C_IS_FINISHED(pixelTransfer.status))
+            ; // a frame's read, it finishes or times out
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Function: finishCapture
+ * @param Buffer the frame was read for.
+ * @return None.
+ * @remark Converts the raw reads once they're in. The chip temperature
+ *  only drifts, so it's only worked out again every 16 frames.
+ */
+void finishCapture(Frame *frame){
+    rawTemp = (rawCompensation[1] << 8) | rawCompensation[0];
+    CPixel = (int16_t)((rawCompensation[3] << 8) | rawCompensation[2]);
+    if(count == 0)
+        calculateChipTemp();
+    count++;
+    if(count >= 16){
+        count = 0;
+    }
+    convertPixels(rawPixels);
+    calculateIRTemp(frame->temperature);
+}
+
+/**
+ * Function: processFrame
+ * @param Frame to look for targets in.
+ * @return None.
+ * @remark Subtracts the background, labels the 4-connected warm blobs, keeps
+ *  the one with the most heat above the background as the target and then
+ *  folds the frame into the background. Every pixel is visited a fixed
+ *  number of times whatever the scene, a few passes of 64, so a frame costs
+ *  the same bounded time with one swimmer or a beach full of them.
+ */
+void processFrame(const Frame *frame){
+    float excess[TOTAL_PIXELS];
+    float weight, sumColumn, sumRow, peak;
+    float bestWeight = 0, bestColumn = 0, bestRow = 0, bestPeak = 0;
+    uint8_t i, blobs = 0, pixels, bestPixels = 0;
+
+    if (backgroundFrames == 0) {
+        for (i = 0; i < TOTAL_PIXELS; i++)
+            background[i] = frame->temperature[i];
+    }
+    for (i = 0; i < TOTAL_PIXELS; i++) {
+        excess[i] = frame->temperature[i] - background[i];
+        label[i] = UNLABELLED;
+    }
+
+    if (backgroundFrames >= BACKGROUND_FRAMES) {
+        for (i = 0; i < TOTAL_PIXELS; i++) {
+            if (label[i] != UNLABELLED || excess[i] < THERMAL_WARM_DELTA)
+                continue;
+            pixels = fillBlob(i, blobs++, excess, &weight, &sumColumn,
+                &sumRow, &peak);
+            if (weight > bestWeight) {
+                bestWeight = weight;
+                bestColumn = sumColumn / weight;
+                bestRow = sumRow / weight;
+                bestPeak = peak;
+                bestPixels = pixels;
+            }
+        }
+    }
+    else {
+        backgroundFrames++;
+    }
+
+    hasTarget = (bestPixels > 0);
+    if (hasTarget) {
+        // Centre of a pixel is half a pixel in from its edge
+        target.bearing = ((bestColumn + 0.5f) / TOTAL_PIXEL_COLS - 0.5f)
+            * THERMAL_FIELD_HORIZONTAL;
+        target.elevation = (0.5f - (bestRow + 0.5f) / TOTAL_PIXEL_ROWS)
+            * THERMAL_FIELD_VERTICAL;
+        target.heading = frame->yaw + target.bearing;
+        if (target.heading < 0)
+            target.heading += 360.0f;
+        else if (target.heading >= 360.0f)
+            target.heading -= 360.0f;
+        target.peak = bestPeak;
+        target.pixels = bestPixels;
+        target.time = frame->time;
+    }
+
+    for (i = 0; i < TOTAL_PIXELS; i++) {
+        background[i] += excess[i] / (float)(1 << ((label[i] == UNLABELLED)?
+            BACKGROUND_SHIFT : BACKGROUND_BLOB_SHIFT));
+    }
+}
+
+/**
+ * Function: fillBlob
+ * @param Warm pixel to grow the blob from.
+ * @param Label to give the blob.
+ * @param (degrees F) Each pixel above its background.
+ * @param Set to the blob's heat, the sum of its excess.
+ * @param Set to the column of each pixel weighed by its excess, summed.
+ * @param Set to the row of each pixel weighed by its excess, summed.
+ * @param Set to the warmest excess in the blob.
+ * @return Pixels in the blob.
+ * @remark A flood fill off an explicit stack rather than recursion. A pixel
+ *  is labelled as it's pushed, so it's pushed once and the stack never
+ *  needs more than a pixel each.
+ */
+uint8_t fillBlob(uint8_t seed, uint8_t blob, const float *excess,
+        float *weight, float *sumColumn, float *sumRow, float *peak){
+    uint8_t stack[TOTAL_PIXELS], neighbour[4];
+    uint8_t top = 0, pixels = 0, pixel, row, column, n, j;
+
+    *weight = *sumColumn = *sumRow = *peak = 0;
+    label[seed] = blob;
+    stack[top++] = seed;
+    while (top > 0) {
+        pixel = stack[--top];
+        row = pixel % TOTAL_PIXEL_ROWS;
+        column = pixel / TOTAL_PIXEL_ROWS;
+        pixels++;
+        *weight += excess[pixel];
+        *sumColumn += column * excess[pixel];
+        *sumRow += row * excess[pixel];
+        if (excess[pixel] > *peak)
+            *peak = excess[pixel];
+
+        n = 0;
+        if (row > 0)
+            neighbour[n++] = pixel - 1;
+        if (row < TOTAL_PIXEL_ROWS - 1)
+            neighbour[n++] = pixel + 1;
+        if (column > 0)
+            neighbour[n++] = pixel - TOTAL_PIXEL_ROWS;
+        if (column < TOTAL_PIXEL_COLS - 1)
+            neighbour[n++] = pixel + TOTAL_PIXEL_ROWS;
+        for (j = 0; j < n; j++) {
+            if (label[neighbour[j]] == UNLABELLED
+                    && excess[neighbour[j]] >= THERMAL_WARM_DELTA) {
+                label[neighbour[j]] = blob;
+                stack[top++] = neighbour[j];
+            }
+        }
+    }
+    return pixels;
+}
+
 
 //#define THERMAL_TEST
 #ifdef THERMAL_TEST
@@ -541,6 +805,8 @@ int main(void){
     Timer_init();
     Serial_init();
     Thermal_init();
+    while (Thermal_initSM() == BOOT_PENDING)
+        ;
     while(1){
         if(count == 0){
             readChipTemp();
@@ -552,11 +818,11 @@ int main(void){
         }
         readPixelValue();
         readCPixelValue();
-        calculateIRTemp();
+        calculateIRTemp(frames[front].temperature);
         int i;
         for(i = 0; i <= 63; ++i){
         while(!Serial_isTransmitEmpty());
-            printf("V_ir[%d]: %.2f\n",i,finalPixelTempF[i]);
+            printf("V_ir[%d]: %.2f\n",i,frames[front].temperature[i]);
         }
     }
 }
@@ -564,82 +830,90 @@ int main(void){
 
 
 
+// Thermal.X runs this, t/bench links Thermal.c without it
+#ifndef BENCH
 #define THERMAL_TEST2
+#endif
 #ifdef THERMAL_TEST2
 
-//#define DEBUG_TEST2         1
+// Streams the frames as THERMAL_FRAME messages for
+//  model/thermal/thermal_readMessage.m, see ThermalFrame.h
+#include "ThermalFrame.h"
+#include "mavlink/autoLifeguard/mavlink.h"
 
-#define END_COL_SEQUENCE    (0xFFFFAAAA)
-#define START_SEQUENCE      (0xFFFF1234)
+//#define DEBUG_TEST2         1
 
-#define PRINT_DELAY         200
+#define MAV_NUMBER          15
+#define COMP_ID             15
+#define SEND_DELAY          125 // (ms) 8 frames a second
 
-void sendSerial32(uint32_t data);
-void sendSerialFloat(float data) ;
+void sendFrame(ThermalFrameEncoder *encoder);
 
 int main(void) {
 // Initialize the UART,Timers, and I2C1
-    //int row = 0;
+    ThermalFrameEncoder encoder;
     Board_init();
     Timer_init();
     Thermal_init();
     Serial_init();
+    ThermalFrame_initEncoder(&encoder);
 
-    /*Timer_new(TIMER_TEST,100);
-    while(!Timer_isExpired(TIMER_TEST);*/
 #ifdef DEBUG_TEST2
     printf("Initialized Thermal module.\n");
 #endif
 
-    uint8_t row = 0, col = 0;
-    Timer_new(TIMER_TEST,PRINT_DELAY);
+    Timer_new(TIMER_TEST,SEND_DELAY);
 
     while(1) {
         if (Timer_isExpired(TIMER_TEST)) {
-            #ifdef DEBUG_TEST2
-                printf("Sending thermal data...\n");
-            #endif
-            sendSerial32(0xFFFF1234);
-
-            for(col = 0; col < TOTAL_PIXEL_COLS; col++) {
-                for(row = 0; row < TOTAL_PIXEL_ROWS; row++){
-                    uint8_t pixel = row + (col * TOTAL_PIXEL_ROWS);
-                    sendSerialFloat(finalPixelTempF[pixel]);
-                }
-                sendSerial32(END_COL_SEQUENCE);
-            }
-
-            #ifdef DEBUG_TEST2
-                printf("\nFinished sending thermal data.\n");
-            #endif
-            Timer_new(TIMER_TEST,PRINT_DELAY);
+            Timer_new(TIMER_TEST,SEND_DELAY);
+            sendFrame(&encoder);
         } // Timer_isExpired
         Thermal_runSM();
     } // while
 }
 
-void sendSerial32(uint32_t data) {
-    #ifndef DEBUG_TEST2
-    int i;
-    for (i = 0; i < 4; i++) {
-        //while (!Serial_isTransmitEmpty()) { asm("nop"); }
-            Serial_putChar((uint8_t)(data >>  (8 * i)));
+/**
+ * Function: sendFrame
+ * @param Encoder holding what the ground station has.
+ * @return None.
+ * @remark Packs the last processed frame and sends it in as many chunks
+ *  as it takes, one message each.
+ */
+void sendFrame(ThermalFrameEncoder *encoder) {
+    uint8_t packed[THERMAL_FRAME_BYTES_MAX], chunk[THERMAL_FRAME_CHUNK];
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    uint8_t flags, chunks, i;
+    uint16_t length, offset, used, bytes, j;
+    mavlink_message_t msg;
+    ThermalTarget found;
+
+    length = ThermalFrame_encode(encoder, Thermal_getFrame(), packed, &flags);
+    chunks = ThermalFrame_getChunks(length);
+    for (i = 0, offset = 0; i < chunks; i++, offset += used) {
+        used = (length - offset > THERMAL_FRAME_CHUNK)?
+            THERMAL_FRAME_CHUNK : length - offset;
+        memset(chunk, 0, sizeof(chunk));
+        memcpy(chunk, &packed[offset], used);
+        mavlink_msg_thermal_frame_pack(MAV_NUMBER, COMP_ID, &msg, get_time(),
+            encoder->frame - 1, flags, i, chunks, used, chunk);
+        bytes = mavlink_msg_to_send_buffer(buffer, &msg);
+        #ifndef DEBUG_TEST2
+        for (j = 0; j < bytes; j++)
+            Serial_putChar(buffer[j]);
+        #endif
     }
-    #else
-    printf("0x%X",data);
-    #endif
-}
 
-void sendSerialFloat(float data) {
-    #ifndef DEBUG_TEST2
-    int i;
-    for (i = 0; i < 4; i++) {
-        //while (!Serial_isTransmitEmpty()) { asm("nop"); }
-            Serial_putChar(((uint8_t)data >>  (8 * i)));
-    }
+    #ifdef DEBUG_TEST2
+    printf("Frame %u: %u bytes in %u chunks%s\n", encoder->frame - 1, length,
+        chunks, (flags & THERMAL_FRAME_KEYFRAME)? ", keyframe" : "");
+    if (Thermal_getTarget(&found))
+        printf("Target %.1f deg right, %.1f up, %u pixels, %.1f F over, %lu us\n",
+            found.bearing, found.elevation, found.pixels, found.peak,
+            (unsigned long)Thermal_getProcessMicros());
     #else
-    printf("_%.8f/",data);
+    (void)found;
     #endif
 }
 
-#endif
\ No newline at end of file
+#endif
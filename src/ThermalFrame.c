@@ -0,0 +1,279 @@
+/**********************************************************************
+ Module
+   ThermalFrame.c
+
+ Revision
+   1.0.0
+
+ Description
+   Delta, run-length and varint packing of thermal frames.
+
+ Notes
+   Two pixels 16 bits apart differ by at most 17 bits, zigzagged and
+   with the flag that's 19, so a difference is never more than three
+   varint bytes and a frame never more than THERMAL_FRAME_BYTES_MAX.
+
+   The decoder checks every token against the end of the data and the
+   end of the frame, so a frame mangled on the way only fails, it can't
+   write past the pixels.
+
+***********************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "ThermalFrame.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#ifndef TRUE
+#define TRUE    1
+#define FALSE   0
+#endif
+
+#define FLAG_RUN            0x1
+#define CENTI_MAX           32767
+#define CENTI_MIN           -32768
+
+#define ZIGZAG(d)           (((uint32_t)(d) << 1) ^ (uint32_t)((d) >> 31))
+#define UNZIGZAG(z)         ((int32_t)((z) >> 1) ^ -(int32_t)((z) & 1))
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static int16_t toCenti(float temperature);
+static uint8_t *putVarint(uint8_t *out, uint32_t value);
+static const uint8_t *getVarint(const uint8_t *in, const uint8_t *end,
+    uint32_t *value);
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+void ThermalFrame_initEncoder(ThermalFrameEncoder *encoder) {
+    memset(encoder->pixels, 0, sizeof(encoder->pixels));
+    encoder->frame = 0;
+    encoder->sinceKeyframe = THERMAL_FRAME_KEYFRAME_INTERVAL;
+}
+
+uint16_t ThermalFrame_encode(ThermalFrameEncoder *encoder,
+        const float *temperatures, uint8_t *packed, uint8_t *flags) {
+    uint8_t *out = packed;
+    uint8_t i, run = 0;
+    int16_t centi, predicted = 0;
+    int32_t delta;
+    uint8_t isKeyframe = (encoder->sinceKeyframe
+        >= THERMAL_FRAME_KEYFRAME_INTERVAL);
+
+    for (i = 0; i < THERMAL_FRAME_PIXELS; i++) {
+        centi = toCenti(temperatures[i]);
+        if (!isKeyframe)
+            predicted = encoder->pixels[i];
+        delta = (int32_t)centi - predicted;
+        if (!isKeyframe && delta <= THERMAL_FRAME_DEADBAND
+                && delta >= -THERMAL_FRAME_DEADBAND)
+            delta = 0;
+        predicted = encoder->pixels[i] = (int16_t)(predicted + delta);
+
+        if (delta == 0) {
+            run++;
+            continue;
+        }
+        if (run > 0) {
+            out = putVarint(out, ((uint32_t)(run - 1) << 1) | FLAG_RUN);
+            run = 0;
+        }
+        out = putVarint(out, ZIGZAG(delta) << 1);
+    }
+    if (run > 0)
+        out = putVarint(out, ((uint32_t)(run - 1) << 1) | FLAG_RUN);
+
+    *flags = isKeyframe? THERMAL_FRAME_KEYFRAME : 0;
+    encoder->sinceKeyframe = isKeyframe? 1 : encoder->sinceKeyframe + 1;
+    encoder->frame++;
+    return (uint16_t)(out - packed);
+}
+
+uint8_t ThermalFrame_getChunks(uint16_t length) {
+    return (length == 0)? 1 :
+        (uint8_t)((length + THERMAL_FRAME_CHUNK - 1) / THERMAL_FRAME_CHUNK);
+}
+
+void ThermalFrame_initDecoder(ThermalFrameDecoder *decoder) {
+    memset(decoder->pixels, 0, sizeof(decoder->pixels));
+    decoder->time = 0;
+    decoder->frame = 0;
+    decoder->isSynced = FALSE;
+    decoder->packedLength = 0;
+    decoder->packedFrame = 0;
+    decoder->nextChunk = 0;
+    decoder->packedFlags = 0;
+}
+
+uint8_t ThermalFrame_receive(ThermalFrameDecoder *decoder, uint32_t time,
+        uint16_t frame, uint8_t flags, uint8_t chunk, uint8_t chunks,
+        uint8_t length, const uint8_t *data) {
+    if (length > THERMAL_FRAME_CHUNK || chunk >= chunks)
+        return FALSE;
+    if (chunk == 0) {
+        decoder->packedLength = 0;
+        decoder->packedFrame = frame;
+        decoder->packedFlags = flags;
+        decoder->nextChunk = 0;
+    }
+    else if (frame != decoder->packedFrame || chunk != decoder->nextChunk) {
+        decoder->nextChunk = 0; // drop the rest of it
+        return FALSE;
+    }
+    if (decoder->packedLength + length > THERMAL_FRAME_BYTES_MAX)
+        return FALSE;
+
+    memcpy(&decoder->packed[decoder->packedLength], data, length);
+    decoder->packedLength += length;
+    decoder->nextChunk++;
+    if (decoder->nextChunk < chunks)
+        return FALSE;
+    decoder->nextChunk = 0;
+
+    // A frame was missed since the last one, so there's nothing to
+    //  build this on until the next keyframe
+    if (!(flags & THERMAL_FRAME_KEYFRAME)
+            && (uint16_t)(decoder->frame + 1) != frame)
+        decoder->isSynced = FALSE;
+    if (!ThermalFrame_decode(decoder, decoder->packed, decoder->packedLength,
+            flags))
+        return FALSE;
+    decoder->time = time;
+    decoder->frame = frame;
+    return TRUE;
+}
+
+uint8_t ThermalFrame_decode(ThermalFrameDecoder *decoder,
+        const uint8_t *packed, uint16_t length, uint8_t flags) {
+    int16_t pixels[THERMAL_FRAME_PIXELS];
+    const uint8_t *in = packed, *end = packed + length;
+    uint8_t i = 0, isKeyframe = (flags & THERMAL_FRAME_KEYFRAME) != 0;
+    int16_t predicted = 0;
+    uint32_t token, run;
+
+    if (!isKeyframe && !decoder->isSynced)
+        return FALSE;
+
+    while (in < end) {
+        in = getVarint(in, end, &token);
+        if (in == NULL)
+            return FALSE;
+        if (token & FLAG_RUN) {
+            run = (token >> 1) + 1;
+            if (run > (uint32_t)(THERMAL_FRAME_PIXELS - i))
+                return FALSE;
+            while (run-- > 0) {
+                if (!isKeyframe)
+                    predicted = decoder->pixels[i];
+                pixels[i++] = predicted;
+            }
+        }
+        else {
+            if (i >= THERMAL_FRAME_PIXELS)
+                return FALSE;
+            if (!isKeyframe)
+                predicted = decoder->pixels[i];
+            predicted = (int16_t)(predicted + UNZIGZAG(token >> 1));
+            pixels[i++] = predicted;
+        }
+    }
+    if (i != THERMAL_FRAME_PIXELS)
+        return FALSE;
+
+    memcpy(decoder->pixels, pixels, sizeof(pixels));
+    decoder->isSynced = TRUE;
+    return TRUE;
+}
+
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+static int16_t toCenti(float temperature) {
+    float centi = temperature * 100.0f;
+    if (centi >= CENTI_MAX)
+        return CENTI_MAX;
+    if (centi <= CENTI_MIN)
+        return CENTI_MIN;
+    return (int16_t)((centi < 0)? centi - 0.5f : centi + 0.5f);
+}
+
+static uint8_t *putVarint(uint8_t *out, uint32_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+// NULL if the data ends inside the varint or it's too long to be one
+static const uint8_t *getVarint(const uint8_t *in, const uint8_t *end,
+        uint32_t *value) {
+    uint8_t shift = 0;
+    *value = 0;
+    while (in < end && shift <= 21) {
+        *value |= (uint32_t)(*in & 0x7F) << shift;
+        if ((*in++ & 0x80) == 0)
+            return in;
+        shift += 7;
+    }
+    return NULL;
+}
+
+//#define THERMALFRAME_TEST
+#ifdef THERMALFRAME_TEST
+
+#include <stdio.h>
+#include "Board.h"
+#include "Serial.h"
+
+int main() {
+    ThermalFrameEncoder encoder;
+    ThermalFrameDecoder decoder;
+    float temperatures[THERMAL_FRAME_PIXELS];
+    uint8_t packed[THERMAL_FRAME_BYTES_MAX], flags;
+    uint16_t length, total = 0;
+    int frame, i, worst = 0, error;
+
+    Board_init();
+    Serial_init();
+    ThermalFrame_initEncoder(&encoder);
+    ThermalFrame_initDecoder(&decoder);
+
+    // Water at 60 F with a little noise, and a swimmer drifting across
+    for (frame = 0; frame < 48; frame++) {
+        for (i = 0; i < THERMAL_FRAME_PIXELS; i++) {
+            temperatures[i] = 60.0f + ((i * 7 + frame * 13) % 9 - 4) * 0.03f;
+            if (i / 4 == frame / 4 % 16)
+                temperatures[i] += 30.0f;
+        }
+        length = ThermalFrame_encode(&encoder, temperatures, packed, &flags);
+        total += length;
+        if (!ThermalFrame_decode(&decoder, packed, length, flags)) {
+            printf("Frame %d failed to decode\n", frame);
+            continue;
+        }
+        for (i = 0; i < THERMAL_FRAME_PIXELS; i++) {
+            error = decoder.pixels[i] - (int)(temperatures[i] * 100.0f + 0.5f);
+            if (error < 0)
+                error = -error;
+            if (error > worst)
+                worst = error;
+        }
+    }
+    printf("%u bytes a frame on average, worst error %d centi-degrees"
+        " (should be at most %d)\n", total / 48, worst,
+        THERMAL_FRAME_DEADBAND);
+
+    return SUCCESS;
+}
+
+#endif
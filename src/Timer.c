@@ -10,6 +10,33 @@
    array of timers with 1 millisecond resolution.
    
  Notes
+   Active timers hold an absolute deadline against freeRunningTimer and
+   sit in a list sorted by it, so the interrupt only looks at the head.
+   The timer is tickless: the period register is set to the next
+   deadline (or as far as 16 bits reach, about 100 ms), and each
+   interrupt advances freeRunningTimer by the period that just ended.
+   get_time() adds the part of the current period already counted, so
+   between interrupts it still moves every millisecond.
+
+   Periods are always a whole number of milliseconds. A timer started
+   in the middle of a period that ends after its deadline shortens the
+   period to the first millisecond boundary on or after the deadline,
+   unless that is too close to TMR1 to write safely, in which case it
+   takes the next one.
+
+   Slots below TIMER_NUMBER_MAX are the fixed numbers from Board.h, the
+   rest are handed out by Timer_create. A periodic timer is put back in
+   the list by the interrupt with its deadline moved by one period, so
+   it doesn't drift with main loop latency. Callbacks are never run in
+   the interrupt: it queues the handle, and Timer_runCallbacks calls
+   them from the main loop. A handle is queued at most once, so the
+   queue can't overflow.
+
+   Timer_getCycles reads the MIPS core timer directly. Timer_getMicros
+   adds the cycles since its last read to a microsecond count, keeping
+   the remainder, and the Timer1 interrupt does the same so that the
+   core timer can never wrap twice between reads (it takes 107 s at the
+   fastest board profile, the interrupt comes at least every 52 ms).
 
  History
  When           Who         What/Why
@@ -33,18 +60,65 @@
 #define TIMER_FREQUENCY 1000
 //Change to alter number of used timers with a max of 32
 
+// The largest prescale that still makes a millisecond a whole number of
+//  counts, 1250 at 80 MHz and 2500 at 20 MHz, so 52 ms or 26 ms fit in PR1
+#if (BOARD_PB_CLOCK / 64) % TIMER_FREQUENCY == 0
+#define TIMER_PRESCALE          64
+#define TIMER_PRESCALE_BITS     T1_PS_1_64
+#else
+#define TIMER_PRESCALE          8
+#define TIMER_PRESCALE_BITS     T1_PS_1_8
+#endif
+#define MAX_PERIOD_COUNTS       0xFFFF
+// Counts of headroom needed to move PR1 ahead of TMR1
+#define REPROGRAM_MARGIN        (ticksPerMs / 4)
+
+#define NO_TIMER                TIMER_INVALID
+
+#define IS_VALID(timer)         ((timer) < TIMER_HANDLE_MAX)
+#define BIT(timer)              ((uint32_t)1 << (timer))
+
+// Deadline a is before b, across the 32-bit wrap
+#define IS_BEFORE(a, b)         ((int32_t)((a) - (b)) < 0)
+
 /***********************************************************************
  * PRIVATE FUNCTIONS                                                   *
  ***********************************************************************/
 
+static uint32_t currentTime();
+static void insertTimer(uint8_t timerNumber);
+static void removeTimer(uint8_t timerNumber);
+static void reschedule();
+static uint8_t lockTimer();
+static void unlockTimer(uint8_t wasEnabled);
+static void startTimer(uint8_t timerNumber, uint32_t delay, uint32_t period);
+static uint32_t updateMicros();
+
 /***********************************************************************
  * PRIVATE VARIABLES                                                   *
  ***********************************************************************/
 static BOOL     timerInitialized = FALSE;
-static uint32_t timerArray[TIMER_NUMBER_MAX];
+static uint32_t timerArray[TIMER_HANDLE_MAX]; // duration, or remaining when stopped
+static uint32_t timerDeadline[TIMER_HANDLE_MAX];
+static uint32_t timerPeriod[TIMER_HANDLE_MAX]; // 0 for one-shot
+static uint8_t  timerNext[TIMER_HANDLE_MAX]; // sorted list of active timers
+static volatile uint8_t timerHead = NO_TIMER;
 static volatile uint32_t timerActiveFlags;
 static volatile uint32_t timerEventFlags;
+static uint32_t timerAllocatedFlags;
+
+// Deferred callbacks, filled by the interrupt
+static TimerCallback timerCallback[TIMER_HANDLE_MAX];
+static void *timerContext[TIMER_HANDLE_MAX];
+static volatile uint32_t timerQueuedFlags;
+static uint8_t callbackQueue[TIMER_HANDLE_MAX];
+static volatile uint8_t callbackHead, callbackTail;
+
+// Microseconds, extended from the core timer
+static uint32_t microsTime, microsLastCycles, microsRemainder;
 static volatile uint32_t freeRunningTimer; // timer in milliseconds
+static volatile uint16_t periodMs; // length of the running period
+static uint16_t ticksPerMs, maxPeriodMs;
 
 /**********************************************************************
  * PUBLIC FUNCTIONS                                                   *
@@ -53,14 +127,29 @@ static volatile uint32_t freeRunningTimer; // timer in milliseconds
 /**********************************************************************
  * Function: Timer_init()
  * @return none
- * @remark Configures the timer module.
+ * @remark Configures the timer module. Does nothing if it already was,
+ *  so modules can call it themselves without resetting other timers.
  **********************************************************************/
 void Timer_init(void) {
+    if (timerInitialized)
+        return;
+
     timerActiveFlags = 0;
     timerEventFlags = 0;
+    timerQueuedFlags = 0;
+    callbackHead = callbackTail = 0;
+    microsTime = 0;
+    microsRemainder = 0;
+    microsLastCycles = _CP0_GET_COUNT();
+    timerHead = NO_TIMER;
     freeRunningTimer = 0;
 
-    OpenTimer1(T1_ON | T1_SOURCE_INT | T1_PS_1_1, F_PB / TIMER_FREQUENCY);
+    ticksPerMs = F_PB / TIMER_PRESCALE / TIMER_FREQUENCY;
+    maxPeriodMs = MAX_PERIOD_COUNTS / ticksPerMs;
+    periodMs = maxPeriodMs;
+
+    OpenTimer1(T1_ON | T1_SOURCE_INT | TIMER_PRESCALE_BITS,
+        periodMs * ticksPerMs - 1);
     ConfigIntTimer1(T1_INT_ON | T1_INT_PRIOR_3);
 
     mT1IntEnable(1);
@@ -84,17 +173,128 @@ BOOL Timer_isInitialized() {
  * @return SUCCESS or ERROR.
  * @remark Creates a new active timer that will tick for newTime milliseconds.
  **********************************************************************/
-int8_t Timer_new(uint8_t timerNumber, uint16_t newTime) {
-    if (timerNumber >= TIMER_NUMBER_MAX)
+int8_t Timer_new(uint8_t timerNumber, uint32_t newTime) {
+    if (!IS_VALID(timerNumber))
         return ERROR;
 
-    timerArray[timerNumber] = newTime;
-    // Clear timers event flag and set its active flag.
-    timerEventFlags &= ~(1 << timerNumber);
-    timerActiveFlags |= (1 << timerNumber);
+    startTimer(timerNumber, newTime, 0);
     return SUCCESS;
 }
 
+/**********************************************************************
+ * Function: Timer_newPeriodic()
+ * @param Timer number.
+ * @param Number of milliseconds between expiring.
+ * @return SUCCESS or ERROR.
+ * @remark Starts a timer that expires every period milliseconds, until
+ *  it is stopped or restarted with Timer_new.
+ **********************************************************************/
+int8_t Timer_newPeriodic(uint8_t timerNumber, uint32_t period) {
+    if (!IS_VALID(timerNumber) || period == 0)
+        return ERROR;
+
+    startTimer(timerNumber, period, period);
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: Timer_newPhased()
+ * @param Timer number.
+ * @param Number of milliseconds until it first expires.
+ * @param Number of milliseconds between expiring after that.
+ * @return SUCCESS or ERROR.
+ * @remark Like Timer_newPeriodic, with the first deadline set apart.
+ **********************************************************************/
+int8_t Timer_newPhased(uint8_t timerNumber, uint32_t delay, uint32_t period) {
+    if (!IS_VALID(timerNumber) || period == 0)
+        return ERROR;
+
+    startTimer(timerNumber, delay, period);
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: Timer_create()
+ * @param Function to call when the timer expires, or NULL to poll it.
+ * @param Passed to the callback.
+ * @return A free timer handle, or TIMER_INVALID if none are left.
+ * @remark The handle works with every function here that takes a timer
+ *  number. It starts stopped, use Timer_new or Timer_newPeriodic.
+ **********************************************************************/
+TimerHandle Timer_create(TimerCallback callback, void *context) {
+    uint8_t timer;
+    for (timer = TIMER_NUMBER_MAX; timer < TIMER_HANDLE_MAX; timer++) {
+        if (!(timerAllocatedFlags & BIT(timer))) {
+            timerAllocatedFlags |= BIT(timer);
+            timerCallback[timer] = callback;
+            timerContext[timer] = context;
+            timerArray[timer] = 0;
+            timerPeriod[timer] = 0;
+            Timer_clear(timer);
+            return timer;
+        }
+    }
+    return TIMER_INVALID;
+}
+
+/**********************************************************************
+ * Function: Timer_destroy()
+ * @param Handle from Timer_create.
+ * @return SUCCESS or ERROR.
+ * @remark Stops the timer and frees the handle. A callback already
+ *  queued for it is dropped.
+ **********************************************************************/
+int8_t Timer_destroy(TimerHandle timer) {
+    if (timer < TIMER_NUMBER_MAX || !IS_VALID(timer)
+            || !(timerAllocatedFlags & BIT(timer)))
+        return ERROR;
+
+    Timer_stop(timer);
+    Timer_clear(timer);
+    timerCallback[timer] = NULL;
+    timerAllocatedFlags &= ~BIT(timer);
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: Timer_runCallbacks()
+ * @return none
+ * @remark Call from the main loop. Runs the callback of every timer
+ *  that expired since the last call, in the order they expired, and
+ *  clears their expired events.
+ **********************************************************************/
+void Timer_runCallbacks() {
+    uint8_t timer;
+    uint8_t wasEnabled;
+    BOOL expired;
+    TimerCallback callback;
+
+    while (callbackHead != callbackTail) {
+        timer = callbackQueue[callbackHead];
+        callbackHead = (callbackHead + 1) % TIMER_HANDLE_MAX;
+
+        wasEnabled = lockTimer();
+        timerQueuedFlags &= ~BIT(timer);
+        expired = (timerEventFlags & BIT(timer)) != 0;
+        timerEventFlags &= ~BIT(timer);
+        unlockTimer(wasEnabled);
+
+        // Skip it if the timer was cleared or destroyed since
+        callback = timerCallback[timer];
+        if (expired && callback != NULL)
+            callback(timer, timerContext[timer]);
+    }
+}
+
+/**********************************************************************
+ * Function: Timer_hasCallbacks()
+ * @return TRUE if a callback is queued for Timer_runCallbacks.
+ * @remark none
+ **********************************************************************/
+BOOL Timer_hasCallbacks() {
+    return callbackHead != callbackTail;
+}
+
 /**********************************************************************
  * Function: Timer_start()
  * @param Timer number.
@@ -102,11 +302,18 @@ int8_t Timer_new(uint8_t timerNumber, uint16_t newTime) {
  * @remark Starts the timer counting.
  **********************************************************************/
 int8_t Timer_start(uint8_t timerNumber) {
-    if (timerNumber >= TIMER_NUMBER_MAX)
+    uint8_t wasEnabled;
+    if (!IS_VALID(timerNumber))
         return ERROR;
 
-
-    timerActiveFlags |= (1 << timerNumber);
+    wasEnabled = lockTimer();
+    if (!(timerActiveFlags & BIT(timerNumber))) {
+        timerDeadline[timerNumber] = currentTime() + timerArray[timerNumber];
+        timerActiveFlags |= BIT(timerNumber);
+        insertTimer(timerNumber);
+        reschedule();
+    }
+    unlockTimer(wasEnabled);
     return SUCCESS;
 }
 
@@ -117,10 +324,20 @@ int8_t Timer_start(uint8_t timerNumber) {
  * @remark Stops the timer from counting.
  **********************************************************************/
 int8_t Timer_stop(uint8_t timerNumber) {
-    if (timerNumber >= TIMER_NUMBER_MAX)
+    uint8_t wasEnabled;
+    int32_t remaining;
+    if (!IS_VALID(timerNumber))
         return ERROR;
 
-    timerActiveFlags &= ~(1 << timerNumber);
+    wasEnabled = lockTimer();
+    if (timerActiveFlags & BIT(timerNumber)) {
+        // Keep what's left so Timer_start picks up from there
+        removeTimer(timerNumber);
+        remaining = (int32_t)(timerDeadline[timerNumber] - currentTime());
+        timerArray[timerNumber] = (remaining > 0)? remaining : 0;
+        timerActiveFlags &= ~BIT(timerNumber);
+    }
+    unlockTimer(wasEnabled);
     return SUCCESS;
 }
 
@@ -131,11 +348,21 @@ int8_t Timer_stop(uint8_t timerNumber) {
  * @return SUCCESS or ERROR.
  * @remark Sets the timer's timeout time, but does not make it active.
  **********************************************************************/
-int8_t Timer_set(uint8_t timerNumber, uint16_t newTime) {
-    if (timerNumber >= TIMER_NUMBER_MAX)
+int8_t Timer_set(uint8_t timerNumber, uint32_t newTime) {
+    uint8_t wasEnabled;
+    if (!IS_VALID(timerNumber))
 	return ERROR;
 
+    wasEnabled = lockTimer();
     timerArray[timerNumber] = newTime;
+    if (timerActiveFlags & BIT(timerNumber)) {
+        // A running timer counts the new time from now
+        removeTimer(timerNumber);
+        timerDeadline[timerNumber] = currentTime() + newTime;
+        insertTimer(timerNumber);
+        reschedule();
+    }
+    unlockTimer(wasEnabled);
     return SUCCESS;
 }
 
@@ -147,11 +374,11 @@ int8_t Timer_set(uint8_t timerNumber, uint16_t newTime) {
  * @remark none
  **********************************************************************/
 BOOL Timer_isActive(uint8_t timerNumber) {
-    if (timerNumber >= TIMER_NUMBER_MAX)
+    if (!IS_VALID(timerNumber))
 	return ERROR;
 
     // Check active bit flag for the timer
-    return (timerActiveFlags & (1 << timerNumber)) != 0;
+    return (timerActiveFlags & BIT(timerNumber)) != 0;
 }
 
 /**********************************************************************
@@ -161,11 +388,11 @@ BOOL Timer_isActive(uint8_t timerNumber) {
  * @remark none
  **********************************************************************/
 BOOL Timer_isExpired(uint8_t timerNumber) {
-    if (timerNumber >= TIMER_NUMBER_MAX)
+    if (!IS_VALID(timerNumber))
         return ERROR;
 
     // Check if the event bit flag was set
-	return (timerEventFlags & (1 << timerNumber)) != 0;
+	return (timerEventFlags & BIT(timerNumber)) != 0;
 }
 
 /**********************************************************************
@@ -175,10 +402,13 @@ BOOL Timer_isExpired(uint8_t timerNumber) {
  * @remark Clears the expired event on the timer.
  **********************************************************************/
 int8_t Timer_clear(uint8_t timerNumber) {
-    if (timerNumber >= TIMER_NUMBER_MAX)
+    uint8_t wasEnabled;
+    if (!IS_VALID(timerNumber))
 	return ERROR;
 
-    timerEventFlags &= ~(1 << timerNumber);
+    wasEnabled = lockTimer();
+    timerEventFlags &= ~BIT(timerNumber);
+    unlockTimer(wasEnabled);
 
     return SUCCESS;
 }
@@ -186,43 +416,246 @@ int8_t Timer_clear(uint8_t timerNumber) {
 
 /**********************************************************************
  * Function: get_time()
- * @return The free running time.
- * @remark Used to measure elapsed time.
+ * @return The free running time in milliseconds.
+ * @remark Used to measure elapsed time. Stays at 0 until Timer_init.
  **********************************************************************/
 uint32_t get_time(void) {
+    uint8_t wasEnabled;
+    uint32_t time;
     if (!timerInitialized)
-        return ERROR;
+        return 0;
 
-    return freeRunningTimer;
+    wasEnabled = lockTimer();
+    time = currentTime();
+    unlockTimer(wasEnabled);
+    return time;
 }
 
 
+/**********************************************************************
+ * Function: Timer_getCycles()
+ * @return The core timer count, TIMER_CYCLES_PER_SECOND.
+ * @remark Wraps every 107 s. The difference of two reads taken as
+ *  uint32_t is right across the wrap for anything shorter than that.
+ **********************************************************************/
+uint32_t Timer_getCycles() {
+    return _CP0_GET_COUNT();
+}
+
+/**********************************************************************
+ * Function: Timer_getMicros()
+ * @return Microseconds since Timer_init, or 0 before it.
+ * @remark Wraps every 71 minutes, take differences as uint32_t.
+ **********************************************************************/
+uint32_t Timer_getMicros() {
+    uint8_t wasEnabled;
+    uint32_t time;
+    if (!timerInitialized)
+        return 0;
+
+    wasEnabled = lockTimer();
+    time = updateMicros();
+    unlockTimer(wasEnabled);
+    return time;
+}
+
 /**********************************************************************
  * Function: Timer1IntHandler
  * @return none
  * @remark This is the interrupt handler to support the timer module.
-     It will increment time, to maintain the functionality of the
-     GetTime() timer and it will check through the active timers,
-     decrementing each active timers count, if the count goes to 0, it
-     will set the associated event flag and clear the active flag to
-     prevent further counting.
+     It fires at the end of each period, advances the free running time
+     by it, expires every timer at the head of the list whose deadline
+     has come, and sets the next period to reach the new head. Periodic
+     timers go back in the list, callbacks are queued for the main loop.
  **********************************************************************/
 void __ISR(_TIMER_1_VECTOR, ipl3) Timer1IntHandler(void) {
+    uint8_t curTimer;
+    int32_t untilNext;
+
     mT1ClearIntFlag();
-    freeRunningTimer++;
-    char curTimer = 0;
-    if (timerActiveFlags != 0) {
-        for (curTimer = 0; curTimer < TIMER_NUMBER_MAX; curTimer++) {
-            if ((timerActiveFlags & (1 << curTimer)) != 0) {
-                if (--timerArray[curTimer] == 0) {
-                    timerEventFlags |= (1 << curTimer);
-                    timerActiveFlags &= ~(1 << curTimer);
-                }
-            }
+    freeRunningTimer += periodMs;
+    updateMicros();
+    while (timerHead != NO_TIMER
+            && !IS_BEFORE(freeRunningTimer, timerDeadline[timerHead])) {
+        curTimer = timerHead;
+        timerHead = timerNext[curTimer];
+        timerEventFlags |= BIT(curTimer);
+        if (timerPeriod[curTimer] != 0) {
+            timerDeadline[curTimer] += timerPeriod[curTimer];
+            insertTimer(curTimer);
+        }
+        else {
+            timerArray[curTimer] = 0;
+            timerActiveFlags &= ~BIT(curTimer);
+        }
+        if (timerCallback[curTimer] != NULL
+                && !(timerQueuedFlags & BIT(curTimer))) {
+            timerQueuedFlags |= BIT(curTimer);
+            callbackQueue[callbackTail] = curTimer;
+            callbackTail = (callbackTail + 1) % TIMER_HANDLE_MAX;
         }
     }
+
+    periodMs = maxPeriodMs;
+    if (timerHead != NO_TIMER) {
+        untilNext = (int32_t)(timerDeadline[timerHead] - freeRunningTimer);
+        if (untilNext < periodMs)
+            periodMs = untilNext;
+    }
+    // TMR1 was just reset by the match, and is nowhere near a millisecond
+    PR1 = periodMs * ticksPerMs - 1;
 } // ISR
 
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: startTimer()
+ * @param Timer number.
+ * @param Milliseconds until it first expires.
+ * @param Milliseconds between expiring after that, or 0 for once.
+ * @return none
+ **********************************************************************/
+static void startTimer(uint8_t timerNumber, uint32_t delay, uint32_t period) {
+    uint8_t wasEnabled = lockTimer();
+    if (timerActiveFlags & BIT(timerNumber))
+        removeTimer(timerNumber);
+    timerArray[timerNumber] = delay;
+    timerPeriod[timerNumber] = period;
+    timerDeadline[timerNumber] = currentTime() + delay;
+    // Clear timers event flag and set its active flag.
+    timerEventFlags &= ~BIT(timerNumber);
+    timerActiveFlags |= BIT(timerNumber);
+    insertTimer(timerNumber);
+    reschedule();
+    unlockTimer(wasEnabled);
+}
+
+/**********************************************************************
+ * Function: updateMicros()
+ * @return Microseconds since Timer_init.
+ * @remark Must be called locked, and at least once per core timer wrap.
+ **********************************************************************/
+static uint32_t updateMicros() {
+    uint32_t cycles = _CP0_GET_COUNT();
+    microsRemainder += cycles - microsLastCycles;
+    microsLastCycles = cycles;
+    microsTime += microsRemainder / TIMER_CYCLES_PER_MICRO;
+    microsRemainder %= TIMER_CYCLES_PER_MICRO;
+    return microsTime;
+}
+
+/**********************************************************************
+ * Function: currentTime()
+ * @return Milliseconds since Timer_init.
+ * @remark Must be called locked. A period that ended but hasn't been
+ *  handled yet is counted, TMR1 is read again since it started over.
+ **********************************************************************/
+static uint32_t currentTime() {
+    uint32_t time = freeRunningTimer;
+    uint32_t ticks;
+    if (!timerInitialized)
+        return time;
+
+    ticks = TMR1;
+    if (mT1GetIntFlag()) {
+        time += periodMs;
+        ticks = TMR1;
+    }
+    return time + ticks / ticksPerMs;
+}
+
+/**********************************************************************
+ * Function: insertTimer()
+ * @param Timer number, with its deadline set.
+ * @return none
+ * @remark Must be called locked. Goes after any timer with the same
+ *  deadline, so timers started together expire in order.
+ **********************************************************************/
+static void insertTimer(uint8_t timerNumber) {
+    uint32_t deadline = timerDeadline[timerNumber];
+    uint8_t previous = NO_TIMER, current = timerHead;
+
+    while (current != NO_TIMER && !IS_BEFORE(deadline, timerDeadline[current])) {
+        previous = current;
+        current = timerNext[current];
+    }
+    timerNext[timerNumber] = current;
+    if (previous == NO_TIMER)
+        timerHead = timerNumber;
+    else
+        timerNext[previous] = timerNumber;
+}
+
+/**********************************************************************
+ * Function: removeTimer()
+ * @param Timer number, which must be in the list.
+ * @return none
+ * @remark Must be called locked.
+ **********************************************************************/
+static void removeTimer(uint8_t timerNumber) {
+    uint8_t current = timerHead;
+
+    if (current == timerNumber) {
+        timerHead = timerNext[timerNumber];
+        return;
+    }
+    while (current != NO_TIMER && timerNext[current] != timerNumber)
+        current = timerNext[current];
+    if (current != NO_TIMER)
+        timerNext[current] = timerNext[timerNumber];
+}
+
+/**********************************************************************
+ * Function: reschedule()
+ * @return none
+ * @remark Must be called locked. Ends the running period early if the
+ *  head's deadline comes before it. Leaves it alone if the period has
+ *  already ended, the interrupt will work out the next one.
+ **********************************************************************/
+static void reschedule() {
+    uint32_t ticks;
+    int32_t target, earliest;
+
+    if (!timerInitialized || timerHead == NO_TIMER || mT1GetIntFlag())
+        return;
+
+    target = (int32_t)(timerDeadline[timerHead] - freeRunningTimer);
+    if (target >= periodMs)
+        return;
+
+    // First millisecond boundary PR1 can still be moved to
+    ticks = TMR1;
+    earliest = ticks / ticksPerMs + 1;
+    if (earliest * ticksPerMs - 1 - ticks < REPROGRAM_MARGIN)
+        earliest++;
+    if (target < earliest)
+        target = earliest;
+    if (target >= periodMs)
+        return;
+
+    periodMs = target;
+    PR1 = target * ticksPerMs - 1;
+}
+
+/**********************************************************************
+ * Function: lockTimer()
+ * @return Whether the timer interrupt was enabled.
+ * @remark Keeps the interrupt out of the list and the period, nests
+ *  with unlockTimer.
+ **********************************************************************/
+static uint8_t lockTimer() {
+    uint8_t wasEnabled = IEC0bits.T1IE;
+    mT1IntEnable(0);
+    return wasEnabled;
+}
+
+static void unlockTimer(uint8_t wasEnabled) {
+    if (wasEnabled)
+        mT1IntEnable(1);
+}
+
 
 #ifdef TIMERS_TEST
 
@@ -9,6 +9,9 @@
  Code for initilazing and running the UART
 
  Notes
+ Every UART is described by an entry in the port table below, and all the
+ code paths work on a port rather than on a hard coded UART. The receive
+ and transmit buffer sizes are set per port in Uart.h.
 
  History
  When           Who         What/Why
@@ -22,54 +25,146 @@
 #include <xc.h>
 #include <peripheral/uart.h>
 #include <stdint.h>
+#include <string.h>
 #include "Uart.h"
+#include "RingBuffer.h"
 #include "Board.h"
 #include <ports.h>
+#ifdef UART_USE_DMA
+#include <peripheral/dma.h>
+#endif
 
 
 /***********************************************************************
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 #define F_PB (Board_GetPBClock())
-#define QUEUESIZE 512
+
+// With UART_USE_FIFO the RX interrupt waits for the hardware FIFO to be 3/4
+// full and the TX interrupt comes when it is empty, each ISR pass moves as
+// many bytes as the FIFO allows. Bytes left under the threshold at the end of
+// a burst are picked up by the receive functions (drainReceiveFIFO), since
+// the PIC32 UART has no receive timeout interrupt.
+#ifdef UART_USE_FIFO
+#define UART_FIFO_MODE (UART_INTERRUPT_ON_RX_3_QUARTER_FULL | UART_INTERRUPT_ON_TX_BUFFER_EMPTY)
+#else
+#define UART_FIFO_MODE UART_INTERRUPT_ON_RX_NOT_EMPTY
+#endif
+
+#define NO_DMA_CHANNEL  -1
+
+// status bits, same place in every UxSTA
+#define STA_URXDA   _U1STA_URXDA_MASK
+#define STA_OERR    _U1STA_OERR_MASK
+#define STA_UTXBF   _U1STA_UTXBF_MASK
 
 /*******************************************************************************
  * PRIVATE DATATYPES                                                           *
  ******************************************************************************/
-typedef struct CircBuffer {
-    unsigned char buffer[QUEUESIZE];
-    int head;
-    int tail;
-    unsigned int size;
-    unsigned char overflowCount;
-} CircBuffer;
-typedef struct CircBuffer* CBRef;
-
+typedef struct UartPort {
+    uint8_t id;                     // UARTx_ID
+    UART_MODULE module;             // plib module
+    volatile uint32_t *sta;         // UxSTA, UxSTACLR is the next word
+    volatile uint32_t *txReg;
+    volatile uint32_t *rxReg;
+    RingBuffer *transmitBuffer;
+    RingBuffer *receiveBuffer;
+    uint8_t *transmitStorage;
+    uint8_t *receiveStorage;
+    uint16_t transmitSize;
+    uint16_t receiveSize;
+#ifdef UART_USE_DMA
+    int rxDmaChannel;               // NO_DMA_CHANNEL if the port has none
+    int txDmaChannel;
+    int rxIrq;
+    int txIrq;
+    char dmaMode;
+    uint16_t txDmaLength;           // length of the block being sent
+#endif
+    UartStats stats;                // zeroed by UART_init
+    UartReceiveHandler receiveHandler; // NULL until UART_setReceiveHandler
+} UartPort;
 
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                *
  ******************************************************************************/
-void newCircBuffer(CBRef cB);
-void freeCircBuffer(CBRef* cB);
-unsigned int getLength(CBRef cB);
-int readHead(CBRef cB);
-int readTail(CBRef cB);
-unsigned char peak(CBRef cB);
-unsigned char readFront(CBRef cB);
-unsigned char writeBack(CBRef cB, unsigned char data);
+UartPort *getPort(uint8_t id);
+void handleInterrupt(UartPort *port);
+void startTransmit(UartPort *port);
+void drainReceiveFIFO(UartPort *port);
+void receiveByte(UartPort *port, uint8_t data);
+void updateTransmitStats(UartPort *port, uint16_t queued, uint16_t requested);
+#ifdef UART_USE_DMA
+void updateReceiveDMA(UartPort *port);
+void startTransmitDMA(UartPort *port);
+void transmitDMADone(UartPort *port);
+#endif
 
 /*******************************************************************************
  * PRIVATE VARIABLES                                                           *
  ******************************************************************************/
-struct CircBuffer outgoingUart1;
-CBRef transmitBufferUart1;
-struct CircBuffer incomingUart1;
-CBRef receiveBufferUart1;
-struct CircBuffer outgoingUart2;
-CBRef transmitBufferUart2;
-struct CircBuffer incomingUart2;
-CBRef receiveBufferUart2;
-
+RING_BUFFER_STORAGE(outgoingUart1, UART1_TX_SIZE);
+RING_BUFFER_STORAGE(incomingUart1, UART1_RX_SIZE);
+RingBuffer transmitBufferUart1, receiveBufferUart1;
+
+RING_BUFFER_STORAGE(outgoingUart2, UART2_TX_SIZE);
+RING_BUFFER_STORAGE(incomingUart2, UART2_RX_SIZE);
+RingBuffer transmitBufferUart2, receiveBufferUart2;
+
+#if UART3_RX_SIZE > 0
+RING_BUFFER_STORAGE(outgoingUart3, UART3_TX_SIZE);
+RING_BUFFER_STORAGE(incomingUart3, UART3_RX_SIZE);
+RingBuffer transmitBufferUart3, receiveBufferUart3;
+#endif
+#if UART4_RX_SIZE > 0
+RING_BUFFER_STORAGE(outgoingUart4, UART4_TX_SIZE);
+RING_BUFFER_STORAGE(incomingUart4, UART4_RX_SIZE);
+RingBuffer transmitBufferUart4, receiveBufferUart4;
+#endif
+#if UART5_RX_SIZE > 0
+RING_BUFFER_STORAGE(outgoingUart5, UART5_TX_SIZE);
+RING_BUFFER_STORAGE(incomingUart5, UART5_RX_SIZE);
+RingBuffer transmitBufferUart5, receiveBufferUart5;
+#endif
+#if UART6_RX_SIZE > 0
+RING_BUFFER_STORAGE(outgoingUart6, UART6_TX_SIZE);
+RING_BUFFER_STORAGE(incomingUart6, UART6_RX_SIZE);
+RingBuffer transmitBufferUart6, receiveBufferUart6;
+#endif
+
+#ifdef UART_USE_DMA
+#define PORT_DMA(rx, tx, rxIrq, txIrq)  , rx, tx, rxIrq, txIrq, FALSE, 0
+#define PORT_NO_DMA                     , NO_DMA_CHANNEL, NO_DMA_CHANNEL, 0, 0, FALSE, 0
+#else
+#define PORT_DMA(rx, tx, rxIrq, txIrq)
+#define PORT_NO_DMA
+#endif
+
+#define PORT_ENTRY(n, dma) \
+    { UART##n##_ID, UART##n, (volatile uint32_t *) &U##n##STA, \
+      (volatile uint32_t *) &U##n##TXREG, (volatile uint32_t *) &U##n##RXREG, \
+      &transmitBufferUart##n, &receiveBufferUart##n, \
+      outgoingUart##n, incomingUart##n, UART##n##_TX_SIZE, UART##n##_RX_SIZE \
+      dma }
+
+static UartPort portTable[] = {
+    PORT_ENTRY(1, PORT_DMA(DMA_CHANNEL0, DMA_CHANNEL1, _UART1_RX_IRQ, _UART1_TX_IRQ)),
+    PORT_ENTRY(2, PORT_DMA(DMA_CHANNEL2, DMA_CHANNEL3, _UART2_RX_IRQ, _UART2_TX_IRQ)),
+#if UART3_RX_SIZE > 0
+    PORT_ENTRY(3, PORT_NO_DMA),
+#endif
+#if UART4_RX_SIZE > 0
+    PORT_ENTRY(4, PORT_NO_DMA),
+#endif
+#if UART5_RX_SIZE > 0
+    PORT_ENTRY(5, PORT_NO_DMA),
+#endif
+#if UART6_RX_SIZE > 0
+    PORT_ENTRY(6, PORT_NO_DMA),
+#endif
+};
+
+#define PORT_COUNT (sizeof(portTable) / sizeof(portTable[0]))
 
 
 /**********************************************************************
@@ -80,124 +175,240 @@ CBRef receiveBufferUart2;
  * Function: UART_init()
  * @param id: identifies the UART module we want to initialize
  *        baudRate: The baudRate we want to initialize the function too.
- * @return a uint32_t value with the actual baudrate initialized. Check against
- *  desired to see if the system can handle the desired baud rate.
+ * @return None
  * @remark Initializes the UART to the specific ID and BaudRate given as
- *  functions to the system. Will return the actual baudrate initialzied.
+ *  functions to the system. Ids without a port entry are ignored.
  *
  * Written by John Ash, help from Max Dunne 1/20/2013
  **********************************************************************/
 
 void UART_init(uint8_t id, uint32_t baudRate){
+    UartPort *port = getPort(id);
+    if(port == NULL)
+        return;
 
-    //will need buffers for both the UARTS
-    if(id == UART1_ID){
-        transmitBufferUart1 = (struct CircBuffer*) &outgoingUart1; //set up buffer for receive
-        newCircBuffer(transmitBufferUart1);
-
-        receiveBufferUart1 = (struct CircBuffer*) &incomingUart1; //set up buffer for transmit
-        newCircBuffer(receiveBufferUart1);
-
-        UARTConfigure(UART1, 0x00);
-        UARTSetDataRate(UART1, F_PB, baudRate);
-        UARTSetFifoMode(UART1, UART_INTERRUPT_ON_RX_NOT_EMPTY);
-
-        mU1SetIntPriority(4); //set the interrupt priority
-
-        UARTEnable(UART1, UART_ENABLE_FLAGS(UART_PERIPHERAL | UART_TX | UART_RX));
-        mU1RXIntEnable(1);
-        mU1TXIntEnable(1);
-    }else if(id == UART2_ID){
-        transmitBufferUart2 = (struct CircBuffer*) &outgoingUart2; //set up buffer for receive
-        newCircBuffer(transmitBufferUart2);
+    RingBuffer_init(port->transmitBuffer, port->transmitStorage, port->transmitSize);
+    RingBuffer_init(port->receiveBuffer, port->receiveStorage, port->receiveSize);
+    memset(&port->stats, 0, sizeof(port->stats));
 
-        receiveBufferUart2 = (struct CircBuffer*) &incomingUart2; //set up buffer for transmit
-        newCircBuffer(receiveBufferUart2);
+    UARTConfigure(port->module, 0x00);
+    UARTSetDataRate(port->module, F_PB, baudRate);
+    UARTSetFifoMode(port->module, UART_FIFO_MODE);
 
-        UARTConfigure(UART2, 0x00);
-        UARTSetDataRate(UART2, F_PB, baudRate);
-        UARTSetFifoMode(UART2, UART_INTERRUPT_ON_RX_NOT_EMPTY);
+    INTSetVectorPriority(INT_VECTOR_UART(port->module), INT_PRIORITY_LEVEL_4);
 
-        mU2SetIntPriority(4); //set the interrupt priority
+    UARTEnable(port->module, UART_ENABLE_FLAGS(UART_PERIPHERAL | UART_TX | UART_RX));
+    INTEnable(INT_SOURCE_UART_RX(port->module), INT_ENABLED);
+    INTEnable(INT_SOURCE_UART_TX(port->module), INT_ENABLED);
+}
 
-        UARTEnable(UART2, UART_ENABLE_FLAGS(UART_PERIPHERAL | UART_TX | UART_RX));
-        mU2RXIntEnable(1);
-        mU2TXIntEnable(1);
-    }
+/**********************************************************************
+ * Function: UART_enableDMA()
+ * @param id: identifies the UART module to switch to DMA mode
+ * @return SUCCESS, or FAILURE if the DMA path is not built in or the
+ *  port has no DMA channels assigned
+ * @remark The receive channel runs in auto-enable mode with the receive
+ *  ring storage as its destination, and the ring tail follows the DMA
+ *  destination pointer. The transmit channel is loaded with the largest
+ *  contiguous span of the transmit ring and reloaded from its block done
+ *  interrupt. The per-byte UART interrupts are turned off for this UART.
+ **********************************************************************/
+char UART_enableDMA(uint8_t id){
+#ifdef UART_USE_DMA
+    UartPort *port = getPort(id);
+    if(port == NULL || port->rxDmaChannel == NO_DMA_CHANNEL)
+        return FAILURE;
+
+    INTEnable(INT_SOURCE_UART_RX(port->module), INT_DISABLED);
+    INTEnable(INT_SOURCE_UART_TX(port->module), INT_DISABLED);
+    UARTSetFifoMode(port->module, UART_INTERRUPT_ON_TX_NOT_FULL | UART_INTERRUPT_ON_RX_NOT_EMPTY);
+
+    // receive: one byte cells from RXREG into the whole ring, wrapping forever
+    DmaChnOpen(port->rxDmaChannel, DMA_CHN_PRI2, DMA_OPEN_AUTO);
+    DmaChnSetEventControl(port->rxDmaChannel, DMA_EV_START_IRQ_EN | DMA_EV_START_IRQ(port->rxIrq));
+    DmaChnSetTxfer(port->rxDmaChannel, (void*) port->rxReg, port->receiveStorage, 1, port->receiveSize, 1);
+    DmaChnEnable(port->rxDmaChannel);
+
+    // transmit: loaded per block in startTransmitDMA
+    DmaChnOpen(port->txDmaChannel, DMA_CHN_PRI1, DMA_OPEN_DEFAULT);
+    DmaChnSetEventControl(port->txDmaChannel, DMA_EV_START_IRQ_EN | DMA_EV_START_IRQ(port->txIrq));
+    DmaChnSetEvEnableFlags(port->txDmaChannel, DMA_EV_BLOCK_DONE);
+    INTSetVectorPriority(INT_VECTOR_DMA(port->txDmaChannel), INT_PRIORITY_LEVEL_4);
+    INTClearFlag(INT_SOURCE_DMA(port->txDmaChannel));
+    INTEnable(INT_SOURCE_DMA(port->txDmaChannel), INT_ENABLED);
+
+    port->txDmaLength = 0;
+    port->dmaMode = TRUE;
+    startTransmitDMA(port); // anything queued before the switch
+    return SUCCESS;
+#else
+    return FAILURE;
+#endif
 }
 
 void UART_putChar(uint8_t id, char ch)
 {
-    if(id == UART1_ID){
-        if (getLength(transmitBufferUart1) != QUEUESIZE) {
-            writeBack(transmitBufferUart1, ch);
-            if (U1STAbits.TRMT) {
-                IFS0bits.U1TXIF = 1;
-            }
-        }
-    }else if(id == UART2_ID){
-        if (getLength(transmitBufferUart2) != QUEUESIZE) {
-            writeBack(transmitBufferUart2, ch);
-            if (U2STAbits.TRMT) {
-                IFS1bits.U2TXIF = 1;
-            }
-        }
+    UartPort *port = getPort(id);
+    if (port == NULL)
+        return;
+    if (RingBuffer_put(port->transmitBuffer, ch) == SUCCESS) {
+        updateTransmitStats(port, 1, 1);
+        startTransmit(port);
+    } else {
+        updateTransmitStats(port, 0, 1);
     }
 }
 
 void UART_putString(uint8_t id, char* Data, int Length){
-    int x;
-    for(x = 0; x < Length; x++){
-        UART_putChar(id, Data[x]);
-        DELAY(10);
-    }
+    UART_write(id, (const uint8_t *) Data, Length);
+}
+
+/**********************************************************************
+ * Function: UART_write()
+ * @param id: identifies the UART module
+ *        data: bytes to send
+ *        length: number of bytes to send
+ * @return the number of bytes accepted into the transmit buffer
+ * @remark Copies what fits into the transmit buffer and kicks the
+ *  transmitter. Does not wait for the buffer to drain.
+ **********************************************************************/
+uint16_t UART_write(uint8_t id, const uint8_t *data, uint16_t length){
+    UartPort *port = getPort(id);
+    uint16_t accepted;
+
+    if(port == NULL)
+        return 0;
+
+    accepted = RingBuffer_write(port->transmitBuffer, data, length);
+    updateTransmitStats(port, accepted, length);
+    if(accepted > 0)
+        startTransmit(port);
+    return accepted;
+}
+
+/**********************************************************************
+ * Function: UART_read()
+ * @param id: identifies the UART module
+ *        buffer: where to copy received bytes
+ *        maxLength: size of buffer
+ * @return the number of bytes copied into buffer
+ * @remark Does not wait for data, returns 0 if none has arrived.
+ **********************************************************************/
+uint16_t UART_read(uint8_t id, uint8_t *buffer, uint16_t maxLength){
+    UartPort *port = getPort(id);
+    if(port == NULL)
+        return 0;
+    drainReceiveFIFO(port);
+    return RingBuffer_read(port->receiveBuffer, buffer, maxLength);
 }
 
 
 uint16_t UART_getChar(uint8_t id)
 {
-    uint16_t ch;
-    if(id == UART1_ID){
-        if (getLength(receiveBufferUart1) == 0) {
-            ch = 0xFF00;
-        } else {
-            ch = (readFront(receiveBufferUart1) & 0x00FF);
-        }
-        return ch;
-    }else if(id == UART2_ID){
-        if (getLength(receiveBufferUart2) == 0) {
-            ch = 0xFF00;
-        } else {
-            ch = (readFront(receiveBufferUart2) & 0x00FF);
-        }
-        return ch;
-    }
+    UartPort *port = getPort(id);
+    uint8_t ch;
+    if (port == NULL)
+        return 0xFF00;
+    drainReceiveFIFO(port);
+    if (RingBuffer_get(port->receiveBuffer, &ch) != SUCCESS)
+        return 0xFF00;
+    return ch;
 }
 
 char UART_isTransmitEmpty(uint8_t id)
 {
-    if(id == UART1_ID){
-        if (getLength(transmitBufferUart1) == 0)
-            return TRUE;
-        return FALSE;
-    } else if(id == UART2_ID){
-        if (getLength(transmitBufferUart2) == 0)
-            return TRUE;
-        return FALSE;
-    }
+    UartPort *port = getPort(id);
+    if (port == NULL)
+        return TRUE;
+    return RingBuffer_isEmpty(port->transmitBuffer);
 }
 
 char UART_isReceiveEmpty(uint8_t id)
 {
-    if(id == UART1_ID){
-        if (getLength(receiveBufferUart1) == 0)
-            return TRUE;
-        return FALSE;
-    } else if(id == UART2_ID){
-        if (getLength(receiveBufferUart2) == 0)
-            return TRUE;
-        return FALSE;
-    }
+    UartPort *port = getPort(id);
+    if (port == NULL)
+        return TRUE;
+    drainReceiveFIFO(port);
+    return RingBuffer_isEmpty(port->receiveBuffer);
+}
+
+uint16_t UART_getTransmitSpace(uint8_t id)
+{
+    UartPort *port = getPort(id);
+    if (port == NULL)
+        return 0;
+    return RingBuffer_getSpace(port->transmitBuffer);
+}
+
+/**********************************************************************
+ * Function: UART_reserve()
+ * @param id: identifies the UART module
+ *        region: set to the reserved part of the transmit buffer
+ *        length: number of bytes wanted
+ * @return length, or 0 if there is no contiguous region that long
+ **********************************************************************/
+uint16_t UART_reserve(uint8_t id, uint8_t **region, uint16_t length)
+{
+    UartPort *port = getPort(id);
+    if (port == NULL)
+        return 0;
+    if (RingBuffer_reserveSpan(port->transmitBuffer, region) < length)
+        return 0;
+    return length;
+}
+
+void UART_commit(uint8_t id, uint16_t length)
+{
+    UartPort *port = getPort(id);
+    if (port == NULL || length == 0)
+        return;
+    RingBuffer_publish(port->transmitBuffer, length);
+    updateTransmitStats(port, length, length);
+    startTransmit(port);
+}
+
+/**********************************************************************
+ * Function: UART_getStats()
+ * @param id: identifies the UART module
+ *        stats: where to copy the counters
+ * @return SUCCESS or FAILURE for a bad id
+ * @remark The counters are updated from the ISR, so they are copied
+ *  with interrupts off to keep them consistent with each other.
+ **********************************************************************/
+char UART_getStats(uint8_t id, UartStats *stats){
+    UartPort *port = getPort(id);
+    unsigned int intStatus;
+    if(port == NULL)
+        return FAILURE;
+    intStatus = INTDisableInterrupts();
+    *stats = port->stats;
+    INTRestoreInterrupts(intStatus);
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: UART_setReceiveHandler()
+ * @param id: identifies the UART module
+ *        handler: called from the receive interrupt, or NULL
+ * @return SUCCESS or FAILURE for a bad id
+ * @remark Stays set across UART_init.
+ **********************************************************************/
+char UART_setReceiveHandler(uint8_t id, UartReceiveHandler handler){
+    UartPort *port = getPort(id);
+    if(port == NULL)
+        return FAILURE;
+    port->receiveHandler = handler;
+    return SUCCESS;
+}
+
+void UART_clearStats(uint8_t id){
+    UartPort *port = getPort(id);
+    unsigned int intStatus;
+    if(port == NULL)
+        return;
+    intStatus = INTDisableInterrupts();
+    memset(&port->stats, 0, sizeof(port->stats));
+    INTRestoreInterrupts(intStatus);
 }
 
 
@@ -220,28 +431,53 @@ char UART_isReceiveEmpty(uint8_t id)
     Interrupt Handle for the uart. with the PIC32 architecture both send and receive are handled within the same interrupt
 
  Notes
-
+    The handlers for the other UARTs below are the same, only the port
+    table entry differs.
 
  Author
  Max Dunne, 2011.11.10
  ****************************************************************************/
 void __ISR(_UART1_VECTOR, ipl4) IntUart1Handler(void)
 {
-    if (mU1RXGetIntFlag()) {
-        mU1RXClearIntFlag();
-        writeBack(receiveBufferUart1, (unsigned char) U1RXREG);
-    }
-    if (mU1TXGetIntFlag()) {
-        mU1TXClearIntFlag();
-        if (!(getLength(transmitBufferUart1) == 0)) {
-            U1TXREG = readFront(transmitBufferUart1);
-        }
-    }
+    handleInterrupt(&portTable[0]);
 }
 
+void __ISR(_UART2_VECTOR, ipl4) IntUart2Handler(void)
+{
+    handleInterrupt(&portTable[1]);
+}
+
+// UART3-6 only exist on the bigger parts (PIC32MX5/6/7), which name
+// their vectors _UART_n_VECTOR
+#if UART3_RX_SIZE > 0
+void __ISR(_UART_3_VECTOR, ipl4) IntUart3Handler(void)
+{
+    handleInterrupt(getPort(UART3_ID));
+}
+#endif
+#if UART4_RX_SIZE > 0
+void __ISR(_UART_4_VECTOR, ipl4) IntUart4Handler(void)
+{
+    handleInterrupt(getPort(UART4_ID));
+}
+#endif
+#if UART5_RX_SIZE > 0
+void __ISR(_UART_5_VECTOR, ipl4) IntUart5Handler(void)
+{
+    handleInterrupt(getPort(UART5_ID));
+}
+#endif
+#if UART6_RX_SIZE > 0
+void __ISR(_UART_6_VECTOR, ipl4) IntUart6Handler(void)
+{
+    handleInterrupt(getPort(UART6_ID));
+}
+#endif
+
+#ifdef UART_USE_DMA
 /****************************************************************************
  Function
-    IntUart1Handler
+    IntUart1TxDmaHandler
 
  Parameters
     None.
@@ -250,195 +486,190 @@ void __ISR(_UART1_VECTOR, ipl4) IntUart1Handler(void)
     None.
 
  Description
-    Interrupt Handle for the uart. with the PIC32 architecture both send and receive are handled within the same interrupt
+    Block done interrupt for the UART1 transmit DMA channel. Releases the
+    span that was just sent from the transmit buffer and loads the next one.
 
  Notes
+    Also used for UART2 below with its own channel.
 
-
- Author
- Max Dunne, 2011.11.10
  ****************************************************************************/
-void __ISR(_UART2_VECTOR, ipl4) IntUart2Handler(void)
+void __ISR(_DMA_1_VECTOR, ipl4) IntUart1TxDmaHandler(void)
 {
-    if (mU2RXGetIntFlag()) {
-        mU2RXClearIntFlag();
-        writeBack(receiveBufferUart2, (unsigned char) U2RXREG);
-    }
-    if (mU2TXGetIntFlag()) {
-        mU2TXClearIntFlag();
-        if (!(getLength(transmitBufferUart2) == 0)) {
-            U2TXREG = readFront(transmitBufferUart2);
-        }
-    }
+    transmitDMADone(&portTable[0]);
 }
-/*******************************************************************************
- * PRIVATE FUNCTIONS                                                          *
- ******************************************************************************/
 
-void newCircBuffer(CBRef cB)
+void __ISR(_DMA_3_VECTOR, ipl4) IntUart2TxDmaHandler(void)
 {
-
-    // initialize to zero
-    int i;
-    for (i = 0; i < QUEUESIZE; i++) {
-        cB->buffer[i] = 0;
-    }
-
-    // initialize the data members
-    cB->head = 0;
-    cB->tail = 0;
-    cB->size = QUEUESIZE;
-    cB->overflowCount = 0;
-
+    transmitDMADone(&portTable[1]);
 }
+#endif
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                          *
+ ******************************************************************************/
 
-// this function frees the Circular Buffer CB Ref
+// returns the port table entry for a UART id, or NULL for a bad id
 
-void freeCircBuffer(CBRef* cB)
+UartPort *getPort(uint8_t id)
 {
-    // if it is already null, nothing to free
-    if (cB == NULL || *cB == NULL) {
-        return;
+    uint8_t i;
+    for (i = 0; i < PORT_COUNT; i++) {
+        if (portTable[i].id == id)
+            return &portTable[i];
     }
-
-    // free and nil the pointer
-    //free(*cB);
-    *cB = NULL;
+    return NULL;
 }
 
+// shared body of the UART interrupts
 
-
-
-// Accesor Methods
-// ===============
-
-// returns the amount of unread bytes in the circular buffer
-
-unsigned int getLength(CBRef cB)
+void handleInterrupt(UartPort *port)
 {
-    // if the circular buffer is not null
-    if (cB != NULL) {
-        if (cB->head <= cB->tail) {
-            return (cB->tail - cB->head);
-        } else {
-            return (cB->size + cB->tail - cB->head);
+    uint32_t start = _CP0_GET_COUNT();
+    uint32_t elapsed;
+
+    if (INTGetFlag(INT_SOURCE_UART_RX(port->module))) {
+        // empty the whole hardware FIFO, then clear the flag
+        while (*port->sta & STA_URXDA) {
+            receiveByte(port, (uint8_t) *port->rxReg);
+        }
+        if (*port->sta & STA_OERR) {
+            port->sta[1] = STA_OERR; // UxSTACLR, receiver stops until cleared
+            port->stats.rxOverruns++;
+        }
+        INTClearFlag(INT_SOURCE_UART_RX(port->module));
+        if (port->receiveHandler != NULL)
+            port->receiveHandler(port->id);
+    }
+    if (INTGetFlag(INT_SOURCE_UART_TX(port->module))) {
+        uint8_t ch;
+        INTClearFlag(INT_SOURCE_UART_TX(port->module));
+        // refill the hardware FIFO up to its depth
+        while (!(*port->sta & STA_UTXBF)
+                && RingBuffer_get(port->transmitBuffer, &ch) == SUCCESS) {
+            *port->txReg = ch;
         }
-    } else {
-        return 0;
     }
 
-
+    elapsed = _CP0_GET_COUNT() - start;
+    if (elapsed > port->stats.isrMaxTicks) {
+        port->stats.isrMaxTicks = (elapsed > 0xFFFF)? 0xFFFF : elapsed;
+    }
 }
 
-// returns the actual index of the head
+// puts one received byte in the ring and counts it
 
-int readHead(CBRef cB)
+void receiveByte(UartPort *port, uint8_t data)
 {
-    // if the circular buffer is not null
-    if (cB != NULL) {
-        return (cB->head);
-    } else {
-        return 0;
+    uint16_t length;
+    if (RingBuffer_put(port->receiveBuffer, data) != SUCCESS) {
+        port->stats.rxDropped++;
+        return;
     }
-
+    port->stats.bytesIn++;
+    length = RingBuffer_getLength(port->receiveBuffer);
+    if (length > port->stats.rxPeak)
+        port->stats.rxPeak = length;
 }
 
-// returns the actual index of the tail
+// counts bytes queued by the main loop for transmit
 
-int readTail(CBRef cB)
+void updateTransmitStats(UartPort *port, uint16_t queued, uint16_t requested)
 {
-    // if the circular buffer is not null
-    if (cB != NULL) {
-        return (cB->tail);
-    } else {
-        return 0;
-    }
-
+    uint16_t length;
+    port->stats.bytesOut += queued;
+    port->stats.txDropped += requested - queued;
+    length = RingBuffer_getLength(port->transmitBuffer);
+    if (length > port->stats.txPeak)
+        port->stats.txPeak = length;
 }
 
-// returns the byte (actual value) that the head points to. this
-// does not mark the byte as read, so succesive calls to peak will
-// always return the same value
+// starts the transmitter for the given UART if it has gone idle
 
-unsigned char peak(CBRef cB)
+void startTransmit(UartPort *port)
 {
-    // if the circular buffer is not null
-    if (cB != NULL) {
-        // if there are bytes in the buffer
-        if (getLength(cB) > 0) {
-            return cB->buffer[cB->head];
-        }
+#ifdef UART_USE_DMA
+    if (port->dmaMode) {
+        startTransmitDMA(port);
+        return;
+    }
+#endif
+    // the ISR refills the FIFO, so kick it whenever there is room there
+    if (!(*port->sta & STA_UTXBF)) {
+        INTSetFlag(INT_SOURCE_UART_TX(port->module));
     }
-    return 0;
 }
 
+// moves bytes still sitting under the RX interrupt threshold into the ring.
+// The RX interrupt is masked meanwhile so the ring keeps a single producer.
 
-// Manipulation Procedures
-// ======================
-// returns the front of the circular buffer and marks the byte as read
-
-unsigned char readFront(CBRef cB)
+void drainReceiveFIFO(UartPort *port)
 {
-    // if the circular buffer is not null
-    if (cB != NULL) {
-        char retVal;
-        // if there are bytes in the buffer
-        if (getLength(cB) > 0) {
-            retVal = cB->buffer[cB->head];
-            cB->head = cB->head < (cB->size - 1) ? cB->head + 1 : 0;
-            return retVal;
+#ifdef UART_USE_DMA
+    if (port->dmaMode) {
+        updateReceiveDMA(port);
+        return;
+    }
+#endif
+#ifdef UART_USE_FIFO
+    if (*port->sta & STA_URXDA) {
+        INTEnable(INT_SOURCE_UART_RX(port->module), INT_DISABLED);
+        while (*port->sta & STA_URXDA) {
+            receiveByte(port, (uint8_t) *port->rxReg);
         }
-        return 128;
+        INTEnable(INT_SOURCE_UART_RX(port->module), INT_ENABLED);
     }
-    return 254;
+#endif
 }
 
-// writes one byte at the end of the circular buffer,
-// increments overflow count if overflow occurs
+#ifdef UART_USE_DMA
+// pulls the receive ring tail up to wherever the DMA channel has written to.
+// The channel overwrites old data if the ring fills, so keep up with it.
 
-unsigned char writeBack(CBRef cB, unsigned char data)
+void updateReceiveDMA(UartPort *port)
 {
-    // if the circular buffer is not null
-    if (cB != NULL) {
-        if (getLength(cB) == (cB->size - 1)) {
-            cB->overflowCount++;
-            //return 1;
-        } else {
-            cB->buffer[cB->tail] = data;
-            cB->tail = cB->tail < (cB->size - 1) ? cB->tail + 1 : 0;
-            //return 0;
-        }
-        //return 0;
-    } else {
-        return 1;
-    }
-    return 0;
+    uint16_t before = RingBuffer_getLength(port->receiveBuffer);
+    uint16_t after;
+    RingBuffer_publishTo(port->receiveBuffer, DmaChnGetDstPnt(port->rxDmaChannel));
+    after = RingBuffer_getLength(port->receiveBuffer);
+    port->stats.bytesIn += after - before;
+    if (after > port->stats.rxPeak)
+        port->stats.rxPeak = after;
 }
 
-// empties the circular buffer. It does not change the size. use with caution!!
+// starts the transmit channel on the contiguous span at the head of the
+// transmit ring, if the channel is idle and there is something to send.
+// The head only moves once the block is done, so the bytes stay put.
 
-void makeEmpty(CBRef cB)
+void startTransmitDMA(UartPort *port)
 {
-    if (cB != NULL) {
-        int i;
-        for (i = 0; i < cB->size; ++i) {
-            cB->buffer[i] = 0;
+    const uint8_t *span;
+    uint16_t length;
+    unsigned int intStatus;
+
+    // the block done interrupt calls this too
+    intStatus = INTDisableInterrupts();
+    if (port->txDmaLength == 0) {
+        length = RingBuffer_peekSpan(port->transmitBuffer, &span);
+        if (length > 0) {
+            port->txDmaLength = length;
+            DmaChnSetTxfer(port->txDmaChannel, span, (void*) port->txReg, length, 1, 1);
+            DmaChnStartTxfer(port->txDmaChannel, DMA_WAIT_NOT, 0);
         }
-        cB->head = 0;
-        cB->tail = 0;
-        cB->overflowCount = 0;
     }
+    INTRestoreInterrupts(intStatus);
 }
 
-// returns the amount of times the CB has overflown;
+// block done on the transmit channel, release the span and send the next
 
-unsigned char getOverflow(CBRef cB)
+void transmitDMADone(UartPort *port)
 {
-    if (cB != NULL) {
-        return cB->overflowCount;
-    }
-    return 0;
+    DmaChnClrEvFlags(port->txDmaChannel, DMA_EV_ALL_EVNTS);
+    INTClearFlag(INT_SOURCE_DMA(port->txDmaChannel));
+    RingBuffer_consume(port->transmitBuffer, port->txDmaLength);
+    port->txDmaLength = 0;
+    startTransmitDMA(port);
 }
+#endif
 
 
 
@@ -0,0 +1,285 @@
+/**********************************************************************
+ Module
+   Watchdog.c
+
+ Revision
+   1.0.0
+
+ Description
+   Watchdog timer, reset reason and deadline misses.
+
+ Notes
+   The kept record is in the .persist section, which the XC32 startup
+   leaves as it was, so after a reset it holds whatever the last boot
+   put there, and after a power-up whatever the RAM came up as. The
+   magic word tells the two apart, and a power-up or brown-out clears it
+   whatever it says.
+
+   RCON keeps its flags through resets until they're cleared, so they
+   are cleared once they're read, or the next reset would look like this
+   one. A power-up sets BOR along with POR, so POR is checked first, and
+   WDTO before the others since a watchdog reset out of sleep can set
+   more than one.
+
+   Misses are recorded from the main loop only, so the log needs no
+   locking.
+
+***********************************************************************/
+
+#include <xc.h>
+#include <stdio.h>
+#include "Board.h"
+#include "Timer.h"
+#include "Watchdog.h"
+
+/***********************************************************************
+ * PRIVATE DEFINITIONS                                                 *
+ ***********************************************************************/
+
+#define KEPT_MAGIC              0x57445447 // "WDTG"
+
+// The LPRC-clocked watchdog counts a millisecond times 2^SWDTPS
+#define PERIOD_PER_STEP         1 // (ms)
+
+/***********************************************************************
+ * PRIVATE TYPEDEFS                                                    *
+ ***********************************************************************/
+
+// Outlives a reset, see the notes
+typedef struct {
+    uint32_t magic;
+    uint8_t task; // running, or WATCHDOG_NO_TASK
+    BOOL hasMiss;
+    WatchdogMiss lastMiss;
+    uint32_t watchdogResets; // since power-up
+} Kept;
+
+/***********************************************************************
+ * PRIVATE VARIABLES                                                   *
+ ***********************************************************************/
+
+static Kept __attribute__((persistent)) kept;
+
+static WatchdogReset resetReason = WATCHDOG_RESET_UNKNOWN;
+static uint8_t resetTask = WATCHDOG_NO_TASK;
+static BOOL isRunning = FALSE;
+
+static WatchdogMiss missLog[WATCHDOG_MISS_LOG];
+static uint8_t missNext = 0;
+static uint32_t missCount = 0;
+
+static const char *resetNames[] = { "power-up", "brown-out", "reset pin",
+    "software", "WATCHDOG", "config mismatch", "unknown" };
+
+/***********************************************************************
+ * PRIVATE PROTOTYPES                                                  *
+ ***********************************************************************/
+
+static WatchdogReset takeResetReason();
+static void printMiss(const WatchdogMiss *miss);
+
+/**********************************************************************
+ * PUBLIC FUNCTIONS                                                   *
+ **********************************************************************/
+
+void Watchdog_init() {
+    resetReason = takeResetReason();
+    isRunning = FALSE;
+    missNext = 0;
+    missCount = 0;
+
+    if (kept.magic != KEPT_MAGIC || resetReason == WATCHDOG_RESET_POWER
+            || resetReason == WATCHDOG_RESET_BROWNOUT) {
+        kept.magic = KEPT_MAGIC;
+        kept.task = WATCHDOG_NO_TASK;
+        kept.hasMiss = FALSE;
+        kept.watchdogResets = 0;
+    }
+    resetTask = kept.task;
+    kept.task = WATCHDOG_NO_TASK;
+    if (resetReason == WATCHDOG_RESET_WATCHDOG)
+        kept.watchdogResets++;
+
+    printf("Reset by %s", resetNames[resetReason]);
+    if (resetTask != WATCHDOG_NO_TASK)
+        printf(" in task %u", resetTask);
+    if (kept.watchdogResets != 0)
+        printf(", %lu watchdog resets since power-up",
+            (unsigned long)kept.watchdogResets);
+    printf(".\n");
+    if (kept.hasMiss) {
+        printf("Last deadline miss before it: ");
+        printMiss(&kept.lastMiss);
+    }
+}
+
+BOOL Watchdog_start(uint32_t longestPeriod) {
+    uint32_t period = Watchdog_getPeriod();
+    if (period < WATCHDOG_MARGIN * longestPeriod) {
+        printf("Watchdog left off, its %lu ms are too short for %lu ms.\n",
+            (unsigned long)period, (unsigned long)longestPeriod);
+        return FAILURE;
+    }
+
+    WDTCONSET = _WDTCON_WDTCLR_MASK;
+    WDTCONSET = _WDTCON_ON_MASK;
+    isRunning = TRUE;
+    return SUCCESS;
+}
+
+BOOL Watchdog_isRunning() {
+    return isRunning;
+}
+
+uint32_t Watchdog_getPeriod() {
+    return (uint32_t)PERIOD_PER_STEP << WDTCONbits.SWDTPS;
+}
+
+void Watchdog_feed() {
+    WDTCONSET = _WDTCON_WDTCLR_MASK;
+}
+
+void Watchdog_setTask(uint8_t task) {
+    kept.task = task;
+}
+
+void Watchdog_recordMiss(uint8_t task, uint32_t late) {
+    WatchdogMiss *miss = &missLog[missNext];
+    miss->time = get_time();
+    miss->late = late;
+    miss->task = task;
+    missNext = (missNext + 1) % WATCHDOG_MISS_LOG;
+    missCount++;
+
+    kept.lastMiss = *miss;
+    kept.hasMiss = TRUE;
+}
+
+WatchdogReset Watchdog_getResetReason() {
+    return resetReason;
+}
+
+uint8_t Watchdog_getResetTask() {
+    return resetTask;
+}
+
+BOOL Watchdog_getLastMiss(WatchdogMiss *miss) {
+    if (!kept.hasMiss)
+        return FAILURE;
+    *miss = kept.lastMiss;
+    return SUCCESS;
+}
+
+uint32_t Watchdog_getMissCount() {
+    return missCount;
+}
+
+void Watchdog_printStatus() {
+    uint8_t i, count, index;
+    printf("Watchdog %s, %lu ms, reset by %s, %lu deadline misses\n",
+        isRunning? "on" : "off", (unsigned long)Watchdog_getPeriod(),
+        resetNames[resetReason], (unsigned long)missCount);
+
+    // Oldest first
+    count = (missCount < WATCHDOG_MISS_LOG)? missCount : WATCHDOG_MISS_LOG;
+    for (i = 0; i < count; i++) {
+        index = (missNext + WATCHDOG_MISS_LOG - count + i) % WATCHDOG_MISS_LOG;
+        printf("  ");
+        printMiss(&missLog[index]);
+    }
+}
+
+/**********************************************************************
+ * PRIVATE FUNCTIONS                                                  *
+ **********************************************************************/
+
+/**********************************************************************
+ * Function: takeResetReason
+ * @return Why the board reset, from RCON.
+ * @remark Clears the flags it read, see the notes.
+ **********************************************************************/
+static WatchdogReset takeResetReason() {
+    uint32_t flags = RCON;
+    WatchdogReset reason;
+
+    if (flags & _RCON_POR_MASK)
+        reason = WATCHDOG_RESET_POWER;
+    else if (flags & _RCON_BOR_MASK)
+        reason = WATCHDOG_RESET_BROWNOUT;
+    else if (flags & _RCON_WDTO_MASK)
+        reason = WATCHDOG_RESET_WATCHDOG;
+    else if (flags & _RCON_CMR_MASK)
+        reason = WATCHDOG_RESET_CONFIG;
+    else if (flags & _RCON_SWR_MASK)
+        reason = WATCHDOG_RESET_SOFTWARE;
+    else if (flags & _RCON_EXTR_MASK)
+        reason = WATCHDOG_RESET_PIN;
+    else
+        reason = WATCHDOG_RESET_UNKNOWN;
+
+    RCONCLR = _RCON_POR_MASK | _RCON_BOR_MASK | _RCON_WDTO_MASK
+        | _RCON_CMR_MASK | _RCON_SWR_MASK | _RCON_EXTR_MASK;
+    return reason;
+}
+
+static void printMiss(const WatchdogMiss *miss) {
+    printf("task %u ran %lu ms late at %lu ms\n", miss->task,
+        (unsigned long)miss->late, (unsigned long)miss->time);
+}
+
+//#define WATCHDOG_TEST
+#ifdef WATCHDOG_TEST
+
+#include "Serial.h"
+#include "Scheduler.h"
+
+#define TICK_PERIOD     10 // (ms)
+#define HANG_AFTER      5000 // (ms)
+#define PRINT_PERIOD    1000 // (ms)
+
+static uint32_t startTime;
+
+// Critical, and stops feeding once it hangs
+static void tick() {
+    if (get_time() - startTime > HANG_AFTER) {
+        printf("Hanging, the watchdog should reset in %lu ms.\n",
+            (unsigned long)Watchdog_getPeriod());
+        while (1)
+            ;
+    }
+}
+
+// Late now and then, so there's a miss to see
+static void sometimesSlow() {
+    static uint8_t runs = 0;
+    uint32_t start = get_time();
+    if (++runs % 10 == 0) {
+        while (get_time() - start < 3 * TICK_PERIOD)
+            ;
+    }
+}
+
+int main() {
+    TaskId task;
+    Board_init();
+    Serial_init();
+    Timer_init();
+    Watchdog_init();
+    Scheduler_init();
+
+    task = Scheduler_addTask(tick, SCHEDULER_PRIORITY_HIGH, TICK_PERIOD);
+    Scheduler_setDeadline(task, 2 * TICK_PERIOD, TRUE);
+    Scheduler_addTask(sometimesSlow, SCHEDULER_PRIORITY_LOW, TICK_PERIOD);
+    Scheduler_addTask(Watchdog_printStatus, SCHEDULER_PRIORITY_LOW,
+        PRINT_PERIOD);
+    Watchdog_start(Scheduler_getCriticalPeriod());
+
+    // After the reset it should print "Reset by WATCHDOG in task 0"
+    startTime = get_time();
+    while (1)
+        Scheduler_run();
+
+    return SUCCESS;
+}
+
+#endif
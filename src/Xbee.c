@@ -17,104 +17,455 @@
  2-1-13   2:50  AM      jash        Complete functions and add comments.
  2-9-13   5:08  PM      jash        Added Mavlink functionality
  2-9-15   12:40 PM      jash        MAVLink test up and running, and set channel
+ 10-14-26                           API mode at 57600, configured without blocking
+ 10-14-26                           Addresses from the system id, a link per peer
 ***********************************************************************/
 
 #include <xc.h>
 #include <peripheral/uart.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #include <ports.h>
 #include "Board.h"
 #include "Uart.h"
 #include "Mavlink.h"
 #include "Timer.h"
 #include "Xbee.h"
+#include "Error.h"
+#include "Nvm.h"
 
 
 /***********************************************************************
  * PRIVATE DEFINITIONS                                                 *
  ***********************************************************************/
 
-#define API_DELAY           1000
-// note, need to reprogram Xbee for different Baud Rates.
-//  factory settings are 9600 baud rate
-#define XBEE_BAUD_RATE      9600
+// Factory settings are transparent mode at 9600 baud, the radio is moved
+//  to API mode at XBEE_API_BAUD_RATE the first time it boots with us
+#define XBEE_FACTORY_BAUD_RATE  9600
+#define XBEE_API_BAUD_RATE      57600
+#define XBEE_API_BAUD_CODE      6 // ATBD of XBEE_API_BAUD_RATE, 7 is 115200
 
 /*    FOR IFDEFS     */
 //#define XBEE_RESET_FACTORY
 
-//Leave uncommented when programming XBEE_1, comment out when programming XBEE_2
-#define XBEE_1
+// Every radio of the fleet is on the channel, and its MY is the address of
+//  its system id, see Xbee_setSystemId
+#define XBEE_CHANNEL            0x15
 
-#ifdef XBEE_1
-#define DELAY_HEARTBEAT 4000 //time to wait for recieve
-#else
-#define DELAY_HEARTBEAT 1000 //Time to wait before send heartbeat
-#endif
+// Stand-ins in configCommands for what's only known at run time
+#define VALUE_MY_ADDRESS        0x10000
+#define VALUE_DESTINATION       0x10001
+
+
+#define LINK_STATUS_DELAY 5000 // (ms) between UART_STATUS reports
+
+// Heartbeats, both ends send them and echo the other's, see
+//  Xbee_recieved_message_heartbeat
+#define DELAY_HEARTBEAT         1000 // (ms) between the ones we send
+#define HEARTBEAT_TIMEOUT       4000 // (ms) without one, connection lost
+#define LINK_WINDOW             32 // heartbeats the loss is over, bits of a mask
+#define RTT_GAIN_SHIFT          3 // smoothed round trip moves 1/8 of the way
+#define JITTER_GAIN_SHIFT       4 // jitter moves 1/16 of the way, RFC 3550
+
+// Configuration, see runConfigSM
+#define PROBE_TIMEOUT           250 // (ms) for the AT response in API mode
+#define GUARD_TIME              1100 // (ms) of silence around "+++", GT is 1 s
+#define COMMAND_TIMEOUT         1000 // (ms) for an "OK\r" to an AT command
+#define CONFIG_RETRIES          2 // each command, and of the whole thing
+
+// API frames, 802.15.4 firmware with AP=2, so a start byte only ever
+//  starts a frame and a lost byte costs one frame, not the stream
+#define API_MODE                2
+#define API_START               0x7E
+#define API_ESCAPE              0x7D
+#define API_XON                 0x11
+#define API_XOFF                0x13
+#define API_ESCAPE_XOR          0x20
+#define API_TX16                0x01
+#define API_AT_COMMAND          0x08
+#define API_RX16                0x81
+#define API_AT_RESPONSE         0x88
+#define API_TX_STATUS           0x89
+#define API_HEADER_LENGTH       3 // start and length
+#define API_FRAME_MAX           (XBEE_PAYLOAD_MAX + 5) // TX16 and RX16
+#define PROBE_FRAME_ID          0x52
+#define ADDRESS_FRAME_ID        0x53
+
+#define TX_STATUS_SUCCESS       0
+
+#define NEEDS_ESCAPE(c)         ((c) == API_START || (c) == API_ESCAPE \
+                                    || (c) == API_XON || (c) == API_XOFF)
+
+/***********************************************************************
+ * PRIVATE TYPEDEFS                                                    *
+ ***********************************************************************/
 
+/* The heartbeats of one peer, at the index of its MAVLink peer, which
+ *  may be taken over by another system, so the link keeps whose it is.
+ *  Theirs are kept as a mask of the last LINK_WINDOW sequence numbers up
+ *  to the newest, bit 0 the newest. */
+typedef struct {
+    uint8_t sysid; // 0 while unused
+    uint16_t peerSeq;
+    uint32_t peerReceived;
+    uint8_t peerWindow; // sequence numbers the mask covers so far
+    uint32_t peerTime, peerHeardTime; // theirs, ours (ms)
+    int32_t lastTransit; // (ms) our clock at arrival minus theirs
+    uint32_t rttScaled, jitterScaled; // shifted up by their gains
+    uint8_t isConnected;
+    uint16_t heartbeatSeq; // of ours to them
+    XbeeLinkQuality quality;
+} HeartbeatLink;
 
-#define ACK_WAIT_TIME 3000
 /**********************************************************************
  * PRIVATE PROTOTYPES                                                 *
  **********************************************************************/
 
-static uint8_t Xbee_programMode();
-
-void check_ACK(ACK *message);
+static void runConfigSM();
+static void configFailed();
+static void sendProbe();
+static void sendConfigCommand();
+static void readCommandMode();
+static void readApi();
+static void handleApiFrame(const uint8_t *frame, uint8_t length);
+static uint8_t sendApiFrame(const uint8_t *header, uint8_t headerLength,
+    const uint8_t *data, uint8_t length);
+static void Xbee_sendCommand(const char *command);
+static uint8_t sendPacket(uint16_t address, const uint8_t *data, uint8_t length);
+static void sendAddressQuery();
+static void sendAddress();
+static uint16_t destination();
+static void handleHeartbeat(uint8_t uart_id, const mavlink_message_t *msg);
+static void sendHeartbeat();
+static void sendHeartbeatTo(HeartbeatLink *link, uint32_t now);
+static HeartbeatLink *findLink(uint8_t sysid);
+static uint8_t countBits(uint32_t bits);
+#ifdef XBEE_TEST
+static void handleTestData(uint8_t uart_id, const mavlink_message_t *msg);
+#endif
 
 /**********************************************************************
  * PRIVATE VARIABLES                                                  *
  **********************************************************************/
 
+static enum {
+    CONFIG_OFF      = 0x0, // done, in API mode or left transparent
+    CONFIG_PROBE    = 0x1, // asked for ATAP in API mode, waiting
+    CONFIG_GUARD    = 0x2, // at the factory baud, quiet before "+++"
+    CONFIG_ENTER    = 0x3, // sent "+++", waiting for "OK\r"
+    CONFIG_COMMAND  = 0x4, // sent an AT command, waiting for "OK\r"
+    CONFIG_SWITCH   = 0x5, // ATCN sent, waiting to change baud
+    CONFIG_ADDRESS  = 0x6, // in API mode, asked for ATMY, waiting
+} configState;
+
+static uint8_t isApiMode = FALSE;
+static uint8_t configCommand = 0, configRetries = 0, probeRetries = 0;
+static uint8_t okMatched = 0; // characters of "OK\r" seen so far
+static uint8_t okReceived = FALSE;
+static uint8_t isAddressChecked = FALSE;
+static uint16_t myAddress = MAVLINK_ADDRESS(MAVLINK_SYSTEM_ID);
+
+// AT commands of command mode in order, a negative value has no parameter
+static const struct {
+    const char *name;
+    int32_t value;
+} configCommands[] = {
+#ifdef XBEE_RESET_FACTORY
+    {"RE", -1},
+#endif
+    {"CH", XBEE_CHANNEL},
+    {"DH", 0},
+    {"DL", VALUE_DESTINATION},
+    {"MY", VALUE_MY_ADDRESS},
+    {"AP", API_MODE},
+    {"BD", XBEE_API_BAUD_CODE},
+    {"WR", -1},
+    {"CN", -1},
+};
+#define CONFIG_COMMANDS (sizeof(configCommands) / sizeof(configCommands[0]))
+
+// API frame being read
+static uint8_t apiFrame[API_FRAME_MAX];
+static uint16_t apiIndex = 0, apiLength = 0;
+static uint8_t apiChecksum = 0, isApiEscaped = FALSE;
+static uint8_t frameId = 0;
+
+// Sends waiting to go out together as one packet, see Xbee_setAggregation
+static uint8_t batch[XBEE_PAYLOAD_MAX];
+static uint8_t batchLength = 0, batchWindow = 0; // (ms) window, 0 is off
+static uint16_t batchAddress = 0; // a packet has the one destination
+static uint32_t batchStarted = 0;
+
+static XbeeStats stats;
+
+static HeartbeatLink links[MAVLINK_PEERS_MAX];
+static uint8_t lastLink = MAVLINK_NO_PEER; // heard from last
+static uint16_t heartbeatSeq = 0; // of the ones to nobody in particular
+
 /**********************************************************************
  * PUBLIC FUNCTIONS                                                   *
  **********************************************************************/
 
 uint8_t Xbee_init(){
-    UART_init(XBEE_UART_ID,XBEE_BAUD_RATE);
-#ifdef XBEE_RESET_FACTORY
-    if( Xbee_programMode() == FAILURE){
-        return FAILURE;
-    }
+    uint8_t sysid;
+    Mavlink_init();
+    // One set with Xbee_setSystemId outlives the build's
+    if(Nvm_read(NVM_KEY_SYSTEM_ID, &sysid, sizeof(sysid)) == SUCCESS)
+        Mavlink_set_system_id(sysid);
+    myAddress = MAVLINK_ADDRESS(Mavlink_get_system_id());
+
+    // Already in API mode answers quickly at the API baud, anything else
+    //  is configured from the factory baud by runConfigSM
+    UART_init(XBEE_UART_ID, XBEE_API_BAUD_RATE);
+    isApiMode = FALSE;
+    isAddressChecked = FALSE;
+    probeRetries = 0;
+    memset(&stats, 0, sizeof(stats));
+    memset(links, 0, sizeof(links));
+    lastLink = MAVLINK_NO_PEER;
+    batchLength = 0;
+    sendProbe();
+
+    Mavlink_register(MAVLINK_MSG_ID_XBEE_HEARTBEAT, handleHeartbeat);
+#ifdef XBEE_TEST
+    Mavlink_register(MAVLINK_MSG_ID_TEST_DATA, handleTestData);
 #endif
     Timer_new(TIMER_HEARTBEAT, DELAY_HEARTBEAT);
+    Timer_new(TIMER_LINK_STATUS, LINK_STATUS_DELAY);
     return SUCCESS; 
 }
 
 
 void Xbee_runSM(){
-    //Recieve bytes if they are available
-    if(UART_isReceiveEmpty(XBEE_UART_ID) == FALSE){
-        Mavlink_recieve(XBEE_UART_ID);
+    uint8_t i;
+    //Recieve bytes if they are available, up to the budget
+    switch(configState){
+        case CONFIG_ENTER:
+        case CONFIG_COMMAND:
+            readCommandMode();
+            break;
+        case CONFIG_OFF:
+            if(isApiMode)
+                readApi();
+            else if(UART_isReceiveEmpty(XBEE_UART_ID) == FALSE)
+                Mavlink_recieve(XBEE_UART_ID);
+            break;
+        default:
+            readApi(); // the probe's answer
+            break;
+    }
+    if(configState != CONFIG_OFF){
+        runConfigSM();
+        return;
     }
-    //send and recieve heart beat message
-#ifndef XBEE_1 //if Xbee 2
-    //Sends out a HEARTBEAT every 1000 ms.
+    //Sends out a HEARTBEAT every 1000 ms, from both ends
     if(Timer_isActive(TIMER_HEARTBEAT) != TRUE){
-        Mavlink_send_xbee_heartbeat(XBEE_UART_ID, 1);
+        sendHeartbeat();
         Timer_new(TIMER_HEARTBEAT, DELAY_HEARTBEAT);
-        //printf("Heart beat sent");
     }
 
-#else
     //we have not heard a heartbeat message for 4 s, LOST CONNECTION
-    if(Timer_isActive(TIMER_HEARTBEAT) != TRUE){
-        Timer_new(TIMER_HEARTBEAT, DELAY_HEARTBEAT);
-        printf("XBEE LOST CONNECTION\n");
+    for(i = 0; i < MAVLINK_PEERS_MAX; i++){
+        HeartbeatLink *link = &links[i];
+        if(link->isConnected && get_time() - link->peerHeardTime >= HEARTBEAT_TIMEOUT){
+            link->isConnected = FALSE;
+            link->quality.isConnected = FALSE;
+            Error_log(ERROR_MODULE_XBEE, ERROR_LINK_LOST, link->quality.loss);
+            #ifdef DEBUG
+            printf("XBEE LOST CONNECTION to %u\n", link->sysid);
+            #endif
+        }
     }
-#endif
     
-    //check ACKS
-    check_ACK(&start_rescue);
+    //resend messages still waiting for an ACK
+    Mavlink_check_ACKs();
+
+    //report the link counters of every UART that is built
+    if(Timer_isActive(TIMER_LINK_STATUS) != TRUE){
+        uint8_t id;
+        for(id = UART1_ID; id <= UART6_ID; id++){
+            Mavlink_send_uart_status(XBEE_UART_ID, id);
+        }
+        Timer_new(TIMER_LINK_STATUS, LINK_STATUS_DELAY);
+    }
 
+    //send what was packed together once its window is up
+    if(batchLength > 0 && get_time() - batchStarted >= batchWindow)
+        Xbee_flush();
 
 }
 
 
+uint8_t Xbee_send(const uint8_t *data, uint16_t length){
+    return Xbee_sendTo(destination(), data, length);
+}
 
-void Xbee_recieved_message_heartbeat(mavlink_xbee_heartbeat_t* packet){
-#ifdef XBEE_1 
-    Timer_new(TIMER_HEARTBEAT, DELAY_HEARTBEAT); //still have a connection
-#endif
+
+uint8_t Xbee_sendTo(uint16_t address, const uint8_t *data, uint16_t length){
+    if(configState != CONFIG_OFF)
+        return FAILURE;
+    if(!isApiMode){
+        if(UART_getTransmitSpace(XBEE_UART_ID) < length)
+            return FAILURE;
+        UART_write(XBEE_UART_ID, data, length);
+        return SUCCESS;
+    }
+    if(length > XBEE_PAYLOAD_MAX)
+        return FAILURE;
+    if(batchWindow == 0)
+        return sendPacket(address, data, (uint8_t)length);
+
+    if((batchLength + length > XBEE_PAYLOAD_MAX || (batchLength > 0
+            && address != batchAddress)) && Xbee_flush() != SUCCESS)
+        return FAILURE;
+    if(batchLength == 0){
+        batchStarted = get_time();
+        batchAddress = address;
+    }else{
+        stats.txBatched++;
+    }
+    memcpy(&batch[batchLength], data, length);
+    batchLength += (uint8_t)length;
+    return SUCCESS;
+}
+
+
+uint8_t Xbee_flush(){
+    if(batchLength == 0)
+        return SUCCESS;
+    // Kept for the next call if the UART is full
+    if(sendPacket(batchAddress, batch, batchLength) != SUCCESS)
+        return FAILURE;
+    batchLength = 0;
+    return SUCCESS;
+}
+
+
+void Xbee_setAggregation(uint8_t window){
+    if(window == 0)
+        Xbee_flush();
+    batchWindow = window;
+}
+
+
+uint8_t Xbee_isApiMode(){
+    return isApiMode;
+}
+
+
+uint8_t Xbee_isReady(){
+    return configState == CONFIG_OFF;
+}
+
+
+void Xbee_getStats(XbeeStats *linkStats){
+    *linkStats = stats;
+}
+
+
+void Xbee_getLinkQuality(XbeeLinkQuality *linkQuality){
+    if(lastLink == MAVLINK_NO_PEER)
+        memset(linkQuality, 0, sizeof(*linkQuality));
+    else
+        *linkQuality = links[lastLink].quality;
+}
+
+
+uint8_t Xbee_getPeerLinkQuality(uint8_t sysid, XbeeLinkQuality *linkQuality){
+    HeartbeatLink *link = findLink(sysid);
+    if(link == NULL || link->sysid != sysid)
+        return FAILURE;
+    *linkQuality = link->quality;
+    return SUCCESS;
+}
+
+
+uint8_t Xbee_setSystemId(uint8_t sysid){
+    if(sysid == MAVLINK_SYSTEM_BROADCAST)
+        return FAILURE;
+    Mavlink_set_system_id(sysid);
+    myAddress = MAVLINK_ADDRESS(sysid);
+    // Taken up by the next configuration if the radio isn't ready for it
+    if(configState == CONFIG_OFF && isApiMode)
+        sendAddress();
+    return Nvm_write(NVM_KEY_SYSTEM_ID, &sysid, sizeof(sysid));
+}
+
+
+void Xbee_recieved_message_heartbeat(uint8_t sysid, mavlink_xbee_heartbeat_t* packet){
+    HeartbeatLink *link = findLink(sysid);
+    uint32_t now = get_time(), rtt, window;
+    int16_t ahead;
+    int32_t transit, change;
+    if(link == NULL)
+        return; // no room to keep it, see Mavlink_get_peer
+    // An entry taken over by another system starts over
+    if(link->sysid != sysid){
+        memset(link, 0, sizeof(*link));
+        link->sysid = sysid;
+    }
+    lastLink = (uint8_t)(link - links);
+    ahead = (int16_t)(packet->seq - link->peerSeq);
+
+    //slide the window up to the newest, a long way back means they
+    //  rebooted, so it starts over like after a lost connection
+    if(!link->isConnected || ahead <= -LINK_WINDOW){
+        link->peerReceived = 1;
+        link->peerWindow = 1;
+        link->jitterScaled = 0;
+    }else if(ahead >= LINK_WINDOW){
+        link->peerReceived = 1; // all the ones between lost
+        link->peerWindow = LINK_WINDOW;
+    }else if(ahead > 0){
+        link->peerReceived = (link->peerReceived << ahead) | 1;
+        link->peerWindow = (link->peerWindow + ahead > LINK_WINDOW)?
+            LINK_WINDOW : link->peerWindow + ahead;
+    }else{
+        link->peerReceived |= (uint32_t)1 << -ahead; // late, or a repeat
+    }
+    window = (link->peerWindow >= 32)? 0xFFFFFFFF
+        : ((uint32_t)1 << link->peerWindow) - 1;
+    link->quality.loss = (uint8_t)(100 * (link->peerWindow
+        - countBits(link->peerReceived & window)) / link->peerWindow);
+    link->quality.peerLoss = packet->loss;
+    link->quality.heartbeats++;
+
+    //jitter is how much the time on the way changes from one to the next,
+    //  against the other clock, so neither clock has to be set, RFC 3550
+    transit = (int32_t)(now - packet->time);
+    if(link->isConnected && ahead > 0){
+        change = transit - link->lastTransit;
+        if(change < 0)
+            change = -change;
+        link->jitterScaled += change
+            - (int32_t)(link->jitterScaled >> JITTER_GAIN_SHIFT);
+    }
+    link->quality.jitter = (uint16_t)(link->jitterScaled >> JITTER_GAIN_SHIFT);
+
+    //round trip of the heartbeat of ours it echoes, less how long it was held
+    if(packet->echo_time != 0 && now - packet->echo_time >= packet->echo_delay){
+        rtt = now - packet->echo_time - packet->echo_delay;
+        link->quality.rttLast = (rtt > 0xFFFF)? 0xFFFF : (uint16_t)rtt;
+        if(link->rttScaled == 0)
+            link->rttScaled = (uint32_t)link->quality.rttLast << RTT_GAIN_SHIFT;
+        else
+            link->rttScaled += link->quality.rttLast
+                - (int32_t)(link->rttScaled >> RTT_GAIN_SHIFT);
+        link->quality.rtt = (uint16_t)(link->rttScaled >> RTT_GAIN_SHIFT);
+        Mavlink_add_RTT_sample(sysid, rtt);
+    }
+
+    if(!link->isConnected && link->quality.heartbeats > 1)
+        Error_log(ERROR_MODULE_XBEE, ERROR_LINK_RESTORED, sysid);
+    if(!link->isConnected || ahead > 0){
+        link->peerSeq = packet->seq;
+        link->peerTime = packet->time;
+        link->peerHeardTime = now;
+        link->lastTransit = transit;
+    }
+    link->isConnected = TRUE;
+    link->quality.isConnected = TRUE;
 }
 
 
@@ -125,69 +476,440 @@ void Xbee_recieved_message_heartbeat(mavlink_xbee_heartbeat_t* packet){
  **********************************************************************/
 
 /**********************************************************************
- * Function: Xbee_programMode()
- * @return Success or Failure based on weather the mode could be set.
- * @remark Currently restores the XBEE to factory setting
- * @author John Ash
- * @date February 10th 2013
+ * Function: runConfigSM()
+ * @return None
+ * @remark Steps the radio configuration, never waits. The radio may
+ *  be in API mode from an earlier boot, so it's asked for ATAP at the
+ *  API baud first. With no answer it is taken through command mode at
+ *  the factory baud, one AT command at a time, and asked again at the
+ *  new baud. If that fails too it's left transparent at the factory
+ *  baud, the way it was before API mode. A radio in API mode is asked
+ *  for its MY too, and given ours if it has another, so a radio moved
+ *  to another boat takes up its address.
  **********************************************************************/
-static uint8_t Xbee_programMode(){
-    int i = 0;
-    char confirm[3];
-    DELAY(2000);
-    UART_putString(XBEE_UART_ID, "+++", 3);
-    DELAY(1000);
-    //wait for "OK\r"
-    do {
-        confirm[i] = UART_getChar(XBEE_UART_ID);
-        if (confirm[i] != 0)
-            i++;
-    } while(i < 3);
-
-    if (!(confirm[0] == 0x4F && confirm[1] == 0x4B && confirm[2] == 0x0D)){
-        return FAILURE;
+static void runConfigSM(){
+    switch(configState){
+        case CONFIG_PROBE:
+            if(isApiMode)
+                sendAddressQuery();
+            else if(Timer_isExpired(TIMER_XBEE_CONFIG))
+                configFailed();
+            break;
+        case CONFIG_ADDRESS:
+            // A radio that doesn't answer keeps what it has
+            if(isAddressChecked || Timer_isExpired(TIMER_XBEE_CONFIG))
+                configState = CONFIG_OFF;
+            break;
+        case CONFIG_GUARD:
+            if(!Timer_isExpired(TIMER_XBEE_CONFIG))
+                break;
+            // OK comes after another guard time of quiet
+            okMatched = 0;
+            okReceived = FALSE;
+            Xbee_sendCommand("+++");
+            Timer_new(TIMER_XBEE_CONFIG, GUARD_TIME + COMMAND_TIMEOUT);
+            configState = CONFIG_ENTER;
+            break;
+        case CONFIG_ENTER:
+            if(okReceived){
+                configCommand = 0;
+                configRetries = 0;
+                sendConfigCommand();
+                configState = CONFIG_COMMAND;
+            }
+            else if(Timer_isExpired(TIMER_XBEE_CONFIG)){
+                configFailed();
+            }
+            break;
+        case CONFIG_COMMAND:
+            if(okReceived){
+                configRetries = 0;
+                if(++configCommand == CONFIG_COMMANDS)
+                    configState = CONFIG_SWITCH;
+                else
+                    sendConfigCommand();
+            }
+            else if(Timer_isExpired(TIMER_XBEE_CONFIG)){
+                if(++configRetries <= CONFIG_RETRIES)
+                    sendConfigCommand();
+                else
+                    configFailed();
+            }
+            break;
+        case CONFIG_SWITCH:
+            // The new baud applies once ATCN's OK is out
+            if(!UART_isTransmitEmpty(XBEE_UART_ID))
+                break;
+            UART_init(XBEE_UART_ID, XBEE_API_BAUD_RATE);
+            sendProbe();
+            break;
+        default:
+            break;
+    } // switch
+}
+
+/**********************************************************************
+ * Function: configFailed()
+ * @return None
+ * @remark Starts command mode over at the factory baud, or after
+ *  CONFIG_RETRIES leaves the radio transparent there.
+ **********************************************************************/
+static void configFailed(){
+    UART_init(XBEE_UART_ID, XBEE_FACTORY_BAUD_RATE);
+    if(++probeRetries > CONFIG_RETRIES){
+        #ifdef DEBUG
+        printf("XBEE not configured, staying transparent.\n");
+        #endif
+        configState = CONFIG_OFF;
+        return;
     }
-    DELAY(1000);
-    UART_putString(XBEE_UART_ID, "ATRE\r", 5);// Resets to Factory settings
-    DELAY(1000);
-    UART_putString(XBEE_UART_ID, "ATCH15\r", 7);
-    DELAY(1000);
-    UART_putString(XBEE_UART_ID, "ATDH0\r", 6);
-    DELAY(1000);
-   #ifdef XBEE_1
-    UART_putString(XBEE_UART_ID, "ATDLAAC3\r", 9);
-    DELAY(1000);
-    UART_putString(XBEE_UART_ID, "ATMYBC64\r", 9);
-    #else
-    UART_putString(XBEE_UART_ID, "ATDLBC64\r", 9);
-    DELAY(1000);
-    UART_putString(XBEE_UART_ID, "ATMYAAC3\r", 9);
-    #endif
-    DELAY(1000);
-    UART_putString(XBEE_UART_ID, "ATWR\r", 5);//Writes the command to memory
-    DELAY(1000);
-    UART_putString(XBEE_UART_ID, "ATCN\r", 5);//Leave the menu.
-    return SUCCESS;
+    Timer_new(TIMER_XBEE_CONFIG, GUARD_TIME);
+    configState = CONFIG_GUARD;
+}
+
+/**********************************************************************
+ * Function: sendProbe()
+ * @return None
+ * @remark Asks for ATAP in an API frame, an answer of 1 means the radio
+ *  is in API mode at the current baud.
+ **********************************************************************/
+static void sendProbe(){
+    uint8_t header[] = {API_AT_COMMAND, PROBE_FRAME_ID, 'A', 'P'};
+    apiIndex = 0;
+    sendApiFrame(header, sizeof(header), NULL, 0);
+    Timer_new(TIMER_XBEE_CONFIG, PROBE_TIMEOUT);
+    configState = CONFIG_PROBE;
+}
+
+/**********************************************************************
+ * Function: sendAddressQuery()
+ * @return None
+ * @remark Asks for ATMY in an API frame, handleApiFrame sets it to ours
+ *  if it's another.
+ **********************************************************************/
+static void sendAddressQuery(){
+    uint8_t header[] = {API_AT_COMMAND, ADDRESS_FRAME_ID, 'M', 'Y'};
+    isAddressChecked = FALSE;
+    sendApiFrame(header, sizeof(header), NULL, 0);
+    Timer_new(TIMER_XBEE_CONFIG, PROBE_TIMEOUT);
+    configState = CONFIG_ADDRESS;
 }
 
+/**********************************************************************
+ * Function: sendAddress()
+ * @return None
+ * @remark Sets ATMY to ours in API frames and writes it to the radio's
+ *  flash, without waiting for either answer.
+ **********************************************************************/
+static void sendAddress(){
+    uint8_t header[] = {API_AT_COMMAND, 0, 'M', 'Y', 0, 0};
+    uint8_t write[] = {API_AT_COMMAND, 0, 'W', 'R'};
+    header[4] = (uint8_t)(myAddress >> 8);
+    header[5] = (uint8_t)myAddress;
+    sendApiFrame(header, sizeof(header), NULL, 0);
+    sendApiFrame(write, sizeof(write), NULL, 0);
+}
 
-void check_ACK(ACK *message){
-    if(message->ACK_status == ACK_STATUS_WAIT){
-        if(message->ACK_time == 0) {
-            message->ACK_time = get_time();
+/**********************************************************************
+ * Function: destination()
+ * @return The radio address Mavlink_send_frame's frames go to, and the
+ *  only one a transparent radio can send to, its DL. A transparent base
+ *  reaches the first boat only, as it always did.
+ **********************************************************************/
+static uint16_t destination(){
+    uint8_t target = Mavlink_get_default_target();
+    if(target == MAVLINK_SYSTEM_BROADCAST)
+        target = MAVLINK_SYSTEM_BOAT;
+    return MAVLINK_ADDRESS(target);
+}
+
+/**********************************************************************
+ * Function: sendConfigCommand()
+ * @return None
+ * @remark Sends the current AT command of command mode and starts its
+ *  timeout.
+ **********************************************************************/
+static void sendConfigCommand(){
+    char command[16];
+    int32_t value = configCommands[configCommand].value;
+    if(value == VALUE_MY_ADDRESS)
+        value = myAddress;
+    else if(value == VALUE_DESTINATION)
+        value = destination();
+    if(value < 0)
+        sprintf(command, "AT%s\r", configCommands[configCommand].name);
+    else
+        sprintf(command, "AT%s%lX\r", configCommands[configCommand].name,
+            (unsigned long)value);
+    okMatched = 0;
+    okReceived = FALSE;
+    Xbee_sendCommand(command);
+    Timer_new(TIMER_XBEE_CONFIG, COMMAND_TIMEOUT);
+}
 
+/**********************************************************************
+ * Function: readCommandMode()
+ * @return None
+ * @remark Looks for the "OK\r" of command mode, anything else is
+ *  ignored and the command times out.
+ **********************************************************************/
+static void readCommandMode(){
+    static const char ok[] = "OK\r";
+    uint8_t c;
+    while(UART_read(XBEE_UART_ID, &c, 1) > 0){
+        if(c == ok[okMatched])
+            okMatched++;
+        else
+            okMatched = (c == ok[0])? 1 : 0;
+        if(okMatched == sizeof(ok) - 1){
+            okReceived = TRUE;
+            okMatched = 0;
         }
-        else if((get_time() - message->ACK_time) >= ACK_WAIT_TIME){
-            Mavlink_resend_message(message);
-            message->ACK_time = 0;
+    }
+}
+
+/**********************************************************************
+ * Function: readApi()
+ * @return None
+ * @remark Reads API frames out of the UART, up to the receive budget of
+ *  bytes, and handles each one that passes its checksum.
+ **********************************************************************/
+static void readApi(){
+    uint8_t chunk[32];
+    uint16_t length, i, taken = 0;
+    while(taken < MAVLINK_RECEIVE_BYTES
+            && (length = UART_read(XBEE_UART_ID, chunk, sizeof(chunk))) > 0){
+        taken += length;
+        for(i = 0; i < length; i++){
+            uint8_t c = chunk[i];
+            if(c == API_START){
+                // Escaped everywhere else, so the last frame was cut short
+                if(apiIndex != 0)
+                    stats.rxErrors++;
+                apiIndex = 1;
+                isApiEscaped = FALSE;
+                continue;
+            }
+            if(apiIndex == 0)
+                continue; // not in a frame
+            if(c == API_ESCAPE){
+                isApiEscaped = TRUE;
+                continue;
+            }
+            if(isApiEscaped){
+                c ^= API_ESCAPE_XOR;
+                isApiEscaped = FALSE;
+            }
+            if(apiIndex == 1){
+                apiLength = (uint16_t)c << 8;
+            }else if(apiIndex == 2){
+                apiLength |= c;
+                apiChecksum = 0;
+                if(apiLength == 0 || apiLength > API_FRAME_MAX){
+                    stats.rxErrors++;
+                    apiIndex = 0;
+                    continue;
+                }
+            }else if(apiIndex < API_HEADER_LENGTH + apiLength){
+                apiFrame[apiIndex - API_HEADER_LENGTH] = c;
+                apiChecksum += c;
+            }else{
+                if((uint8_t)(apiChecksum + c) == 0xFF)
+                    handleApiFrame(apiFrame, (uint8_t)apiLength);
+                else
+                    stats.rxErrors++;
+                apiIndex = 0;
+                continue;
+            }
+            apiIndex++;
         }
+    }
+}
 
-    }else if(message->ACK_status == ACK_STATUS_RECIEVED){
-            message->ACK_status = ACK_STATUS_NO_ACK;
-            message->ACK_time = 0;
+/**********************************************************************
+ * Function: handleApiFrame()
+ * @param Frame data, from the API identifier on.
+ * @param Length of the frame data.
+ * @return None
+ * @remark RF data goes on to the MAVLink parser, TX status and AT
+ *  responses are kept here.
+ **********************************************************************/
+static void handleApiFrame(const uint8_t *frame, uint8_t length){
+    switch(frame[0]){
+        case API_RX16:
+            // source address, RSSI as -dBm, options, then the data
+            if(length < 5)
+                break;
+            stats.rssi = -(int8_t)frame[3];
+            stats.rxPackets++;
+            Mavlink_recieve_bytes(XBEE_UART_ID,
+                ((uint16_t)frame[1] << 8) | frame[2], &frame[5], length - 5);
+            break;
+        case API_TX_STATUS:
+            if(length < 3)
+                break;
+            stats.lastTxStatus = frame[2];
+            if(frame[2] == TX_STATUS_SUCCESS)
+                stats.txAcked++;
+            else
+                stats.txFailed++;
+            break;
+        case API_AT_RESPONSE:
+            // frame id, command, status, value
+            if(length >= 6 && frame[2] == 'A' && frame[3] == 'P'
+                    && frame[4] == 0 && frame[5] == API_MODE)
+                isApiMode = TRUE;
+            if(length >= 7 && frame[1] == ADDRESS_FRAME_ID && frame[2] == 'M'
+                    && frame[3] == 'Y' && frame[4] == 0){
+                if((((uint16_t)frame[5] << 8) | frame[6]) != myAddress)
+                    sendAddress();
+                isAddressChecked = TRUE;
+            }
+            break;
+        default:
+            break;
     }
 }
 
+/**********************************************************************
+ * Function: sendApiFrame()
+ * @param Start of the frame data, from the API identifier on.
+ * @param Length of the start.
+ * @param Rest of the frame data, may be NULL.
+ * @param Length of the rest.
+ * @return SUCCESS, or FAILURE if the UART has no room for all of it.
+ * @remark Escapes everything after the start byte, the checksum is of
+ *  the bytes before escaping.
+ **********************************************************************/
+static uint8_t sendApiFrame(const uint8_t *header, uint8_t headerLength,
+        const uint8_t *data, uint8_t length){
+    // Every byte after the start might need escaping
+    uint8_t frame[1 + 2 * (2 + API_FRAME_MAX + 1)];
+    uint8_t i, c, checksum = 0, *out = frame;
+    uint16_t frameLength = headerLength + length;
+    if(frameLength > API_FRAME_MAX)
+        return FAILURE;
+    *out++ = API_START;
+    for(i = 0; i < 2 + frameLength + 1; i++){
+        if(i == 0)
+            c = (uint8_t)(frameLength >> 8);
+        else if(i == 1)
+            c = (uint8_t)frameLength;
+        else if(i < 2 + headerLength)
+            checksum += c = header[i - 2];
+        else if(i < 2 + frameLength)
+            checksum += c = data[i - 2 - headerLength];
+        else
+            c = 0xFF - checksum;
+        if(NEEDS_ESCAPE(c)){
+            *out++ = API_ESCAPE;
+            c ^= API_ESCAPE_XOR;
+        }
+        *out++ = c;
+    }
+    if(UART_getTransmitSpace(XBEE_UART_ID) < out - frame)
+        return FAILURE;
+    UART_write(XBEE_UART_ID, frame, (uint16_t)(out - frame));
+    return SUCCESS;
+}
+
+/**********************************************************************
+ * Function: sendPacket()
+ * @param address: radio it goes to, or MAVLINK_ADDRESS_BROADCAST
+ * @param data: RF data of one packet, up to XBEE_PAYLOAD_MAX
+ * @param length: how many
+ * @return SUCCESS, or FAILURE if the UART had no room
+ * @remark A TX16 request, numbered for its status. A broadcast isn't
+ *  acknowledged or retried by the radios.
+ **********************************************************************/
+static uint8_t sendPacket(uint16_t address, const uint8_t *data, uint8_t length){
+    uint8_t header[5];
+    // 0 asks for no TX status, so it's skipped
+    if(++frameId == 0)
+        frameId = 1;
+    header[0] = API_TX16;
+    header[1] = frameId;
+    header[2] = (uint8_t)(address >> 8);
+    header[3] = (uint8_t)address;
+    header[4] = 0; // options, with the radio's own ACK and retries
+    return sendApiFrame(header, sizeof(header), data, length);
+}
+
+/**********************************************************************
+ * Function: Xbee_sendCommand()
+ * @param command: null terminated AT command string
+ * @remark Queues the command on the Xbee UART without waiting
+ **********************************************************************/
+static void Xbee_sendCommand(const char *command){
+    UART_write(XBEE_UART_ID, (const uint8_t *) command, strlen(command));
+}
+
+static void handleHeartbeat(uint8_t uart_id, const mavlink_message_t *msg){
+    mavlink_xbee_heartbeat_t data;
+    mavlink_msg_xbee_heartbeat_decode(msg, &data);
+    Xbee_recieved_message_heartbeat(msg->sysid, &data);
+}
+
+/**********************************************************************
+ * Function: sendHeartbeat()
+ * @remark One to each connected peer, each with its own echo, so the
+ *  base sends a heartbeat a second for every boat it hears. With none
+ *  connected one goes to the default target, which for the base is
+ *  every radio, so boats coming up can find it.
+ **********************************************************************/
+static void sendHeartbeat(){
+    uint32_t now = get_time();
+    uint8_t i, sent = 0;
+    for(i = 0; i < MAVLINK_PEERS_MAX; i++){
+        if(links[i].isConnected){
+            sendHeartbeatTo(&links[i], now);
+            sent++;
+        }
+    }
+    if(sent == 0)
+        Mavlink_send_xbee_heartbeat(XBEE_UART_ID, Mavlink_get_default_target(),
+            heartbeatSeq++, now, 0, 0, 0);
+}
+
+/**********************************************************************
+ * Function: sendHeartbeatTo()
+ * @remark Ours, with the newest of theirs echoed and how long it was
+ *  held, so they can take that out of the round trip. get_time() is
+ *  only 0 in the first millisecond, so an echo_time of 0 means none.
+ **********************************************************************/
+static void sendHeartbeatTo(HeartbeatLink *link, uint32_t now){
+    uint32_t held = now - link->peerHeardTime;
+    Mavlink_send_xbee_heartbeat(XBEE_UART_ID, link->sysid, link->heartbeatSeq++,
+        now, link->peerTime, (held > 0xFFFF)? 0xFFFF : (uint16_t)held,
+        link->quality.loss);
+}
+
+/**********************************************************************
+ * Function: findLink()
+ * @return The link at the index of the system's MAVLink peer, which may
+ *  still be another system's, or NULL if it isn't a peer.
+ **********************************************************************/
+static HeartbeatLink *findLink(uint8_t sysid){
+    uint8_t index = Mavlink_find_peer(sysid);
+    return (index == MAVLINK_NO_PEER)? NULL : &links[index];
+}
+
+static uint8_t countBits(uint32_t bits){
+    uint8_t count = 0;
+    for(; bits != 0; bits &= bits - 1)
+        count++;
+    return count;
+}
+
+#ifdef XBEE_TEST
+static void handleTestData(uint8_t uart_id, const mavlink_message_t *msg){
+    mavlink_test_data_t data;
+    mavlink_msg_test_data_decode(msg, &data);
+    Xbee_message_data_test(&data);
+}
+#endif
+
+
 
 /*************************************************************
  * This test function will program two Xbees, Master & Slave.
@@ -223,32 +945,33 @@ int main(){
     }
     printf("XBEE Initialized\n");
 
-// Master sends packets and listens for responses
-    #ifdef XBEE_1
-    Mavlink_send_Test_data(XBEE_UART_ID, 1);
-    Timer_new(TIMER_TIMEOUT, DELAY_TIMEOUT);
-    Timer_new(TIMER_STATUS, DELAY_STATUS);
-    while(1){
-        Xbee_runSM();
-        //lost a packet, report it, and restart
-        if(Timer_isActive(TIMER_TIMEOUT) != TRUE){
-            Mavlink_send_Test_data(XBEE_UART_ID, 1);
-            count_lost++;
-            Timer_new(TIMER_TIMEOUT, DELAY_TIMEOUT);
-            printf("lost_packet: %d\n", get_time());
-        }
-        //Printout the status
-        if(Timer_isActive(TIMER_STATUS) != TRUE){
-            Timer_new(TIMER_STATUS, DELAY_STATUS);
-            printf("Status: %d,%d [Recieved,Lost] TIME: %d\n", count_recieved, count_lost, get_time());
-        }
+// Master sends packets and listens for responses, it's the one on the
+//  base's system id, program the other with MAVLINK_SYSTEM_ID defined
+//  as MAVLINK_SYSTEM_BOAT
+    if(Mavlink_get_system_id() == MAVLINK_SYSTEM_BASE){
+        Mavlink_send_Test_data(XBEE_UART_ID, 1);
+        Timer_new(TIMER_TIMEOUT, DELAY_TIMEOUT);
+        Timer_new(TIMER_STATUS, DELAY_STATUS);
+        while(1){
+            Xbee_runSM();
+            //lost a packet, report it, and restart
+            if(Timer_isActive(TIMER_TIMEOUT) != TRUE){
+                Mavlink_send_Test_data(XBEE_UART_ID, 1);
+                count_lost++;
+                Timer_new(TIMER_TIMEOUT, DELAY_TIMEOUT);
+                printf("lost_packet: %d\n", get_time());
+            }
+            //Printout the status
+            if(Timer_isActive(TIMER_STATUS) != TRUE){
+                Timer_new(TIMER_STATUS, DELAY_STATUS);
+                printf("Status: %d,%d [Recieved,Lost] TIME: %d\n", count_recieved, count_lost, get_time());
+            }
 
+        }
     }
-    #else
     while(1){
         Xbee_runSM();
     }
-    #endif
 }
 
 
@@ -264,8 +987,13 @@ void Xbee_message_data_test(mavlink_test_data_t* packet){
 //#define XBEE_TEST_2
 #ifdef XBEE_TEST_2
 
-#define TIMER_TIMEOUT 4
-#define DELAY_TIMEOUT 4000
+static void rescueDone(uint8_t Message_Name, uint8_t ACK_status){
+    if(ACK_status == ACK_STATUS_RECIEVED)
+        printf("GPS SENT AND ACKOWLEGED, timeout now %u ms\n",
+            Mavlink_get_ACK_timeout(MAVLINK_SYSTEM_BOAT));
+    else
+        printf("ACK DEAD\n");
+}
 
 int main(){
     Board_init();
@@ -275,27 +1003,11 @@ int main(){
     printf("Xbee Test 2\n");
     while(1){
         Xbee_runSM();
-        //if(!UART_isTransmitEmpty(UART1_ID));
-        //printf("%d\t",Mavlink_returnACKStatus(messageName_start_rescue));
         if(!UART_isReceiveEmpty(UART1_ID)){
             Serial_getChar();
-            Mavlink_send_start_rescue(UART2_ID, TRUE, 0xFF, 0x34FD, 0xAB54);
-            Timer_new(TIMER_TIMEOUT, DELAY_TIMEOUT);
+            Mavlink_send_start_rescue(UART2_ID, MAVLINK_SYSTEM_BOAT, TRUE, 0xFF, 0x34FD, 0xAB54, rescueDone);
             printf("\nSENT\n");
         }
-        else if(Timer_isActive(TIMER_TIMEOUT) != TRUE && Mavlink_returnACKStatus(messageName_start_rescue) == ACK_STATUS_WAIT){
-        //else if(Timer_isActive(TIMER_TIMEOUT) != TRUE){
-            Mavlink_editACKStatus(messageName_start_rescue, ACK_STATUS_DEAD);
-            printf("ACK DEAD\n");
-        }
-        else if(Mavlink_returnACKStatus(messageName_start_rescue) == ACK_STATUS_DEAD){
-            Mavlink_send_start_rescue(UART2_ID, TRUE, 0xFF, 0x34FD, 0xAB54);
-            Timer_new(TIMER_TIMEOUT, DELAY_TIMEOUT);
-        }
-        else if(Mavlink_returnACKStatus(messageName_start_rescue) == ACK_STATUS_RECIEVED){
-            Mavlink_editACKStatus(messageName_start_rescue, ACK_STATUS_NO_ACK);
-            printf("GPS SENT AND ACKOWLEGED\n");
-        } 
     }
 }
 
@@ -315,7 +1027,7 @@ int main(){
         //printf("%d\t",Mavlink_returnACKStatus(messageName_start_rescue));
         if(!UART_isReceiveEmpty(UART1_ID)){
             Serial_getChar();
-            Mavlink_send_start_rescue(UART2_ID, TRUE, 0xFF, 0x34FD, 0xAB54);
+            Mavlink_send_start_rescue(UART2_ID, MAVLINK_SYSTEM_BOAT, TRUE, 0xFF, 0x34FD, 0xAB54, NULL);
             printf("\nSENT\n");
         }
     }
@@ -0,0 +1,428 @@
+/*
+ * Micro-benchmarks of the core modules, each with a check that it still
+ * gives the right answer, see t/bench/README.md.
+ *
+ * Times are read from the core timer, ticking at 40 MHz on the board. On a
+ * PC the stubs stand a 40 MHz count in for it, from the host's clock, and
+ * host.c stands in for the hardware. The results are printed as CSV.
+ */
+#include <xc.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <plib.h>
+#include "Board.h"
+#include "Serial.h"
+#include "Timer.h"
+#include "RingBuffer.h"
+#include "Gps.h"
+#include "Thermal.h"
+#include "Navigation.h"
+#include "bench.h"
+
+#define RING_SIZE           256 // (bytes) as the UART buffers
+#define RING_CHUNK          64 // (bytes) a UART_write or UART_read
+
+#define UBX_EPOCHS          200 // NAV-STATUS and NAV-POSLLH pairs
+#define UBX_EPOCH_BYTES     (2 * 8 + 16 + 28)
+#define THERMAL_FRAMES      (BENCH_CALLS / 10)
+#define THERMAL_TOLERANCE   0.01f // (degrees F)
+#define TICK_TIMERS         4 // periodic timers in the list
+#define NED_TOLERANCE       0.05 // (m)
+#define GEODETIC_TOLERANCE  2.0 // (m) a float ECEF round trip
+
+#define OPERATING_LATITUDE  36.95f // (degrees) Santa Cruz
+#define OPERATING_LONGITUDE -122.03f // (degrees)
+#define METERS_PER_DEGREE   111320.0
+
+// Private to the modules, but not static
+void handleByte(uint8_t data);
+void calculateIRTemp(float *temperatures);
+extern int pixelData[THERMAL_PIXELS];
+extern float inverseAlpha[THERMAL_PIXELS], pixelOffset[THERMAL_PIXELS];
+extern float chipTempK4;
+void convertENU2ECEF(Coordinate *var, float east, float north, float up,
+    float lat_ref, float lon_ref, float alt_ref);
+void convertGeodetic2ECEF(Coordinate *var, float lat, float lon, float alt);
+void convertECEF2Geodetic(Coordinate *var, float ecef_x, float ecef_y,
+    float ecef_z);
+void convertEuler2NED(Coordinate *var, float yaw, float pitch, float height);
+#ifdef BENCH_HOST
+void Timer1IntHandler(void);
+#endif
+
+RING_BUFFER_STORAGE(ringStorage, RING_SIZE);
+static uint8_t ubxStream[UBX_EPOCHS * UBX_EPOCH_BYTES];
+static float temperatures[THERMAL_PIXELS];
+static volatile float sink;
+static uint8_t failures = 0;
+
+/**********************************************************************
+ * Reporting                                                          *
+ **********************************************************************/
+
+void Bench_report(const char *name, uint32_t calls, uint32_t cycles,
+        int8_t check) {
+    double perCall = calls? (double)cycles / calls : 0.0;
+    printf("%s,%lu,%.1f,%.3f,%s\n", name, (unsigned long)calls, perCall,
+        perCall * 1e6 / TIMER_CYCLES_PER_SECOND,
+        (check == BENCH_PASS)? "pass"
+            : (check == BENCH_FAIL)? "fail" : "-");
+    if (check == BENCH_FAIL)
+        failures++;
+}
+
+/**********************************************************************
+ * RingBuffer, under every UART                                       *
+ **********************************************************************/
+
+// A byte at a time, the way the UART interrupts move them
+static void benchRingByte() {
+    RingBuffer ring;
+    uint32_t start, cycles;
+    uint16_t i;
+    uint8_t data;
+    int8_t check = BENCH_PASS;
+
+    RingBuffer_init(&ring, ringStorage, sizeof(ringStorage));
+    start = _CP0_GET_COUNT();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        RingBuffer_put(&ring, (uint8_t)i);
+        if (RingBuffer_get(&ring, &data) != SUCCESS || data != (uint8_t)i)
+            check = BENCH_FAIL;
+    }
+    cycles = _CP0_GET_COUNT() - start;
+    Bench_report("ring_put_get", BENCH_CALLS, cycles, check);
+}
+
+// Chunks copied in and out, as UART_write and UART_read do
+static void benchRingChunk() {
+    RingBuffer ring;
+    uint8_t in[RING_CHUNK], out[RING_CHUNK];
+    uint32_t start, cycles;
+    uint16_t i;
+    int8_t check = BENCH_PASS;
+
+    for (i = 0; i < RING_CHUNK; i++)
+        in[i] = (uint8_t)(i * 7);
+    RingBuffer_init(&ring, ringStorage, sizeof(ringStorage));
+    // Off the start of the storage, so the chunks wrap around its end
+    RingBuffer_write(&ring, in, RING_CHUNK / 2);
+    RingBuffer_read(&ring, out, RING_CHUNK / 2);
+
+    start = _CP0_GET_COUNT();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        if (RingBuffer_write(&ring, in, RING_CHUNK) != RING_CHUNK
+                || RingBuffer_read(&ring, out, RING_CHUNK) != RING_CHUNK)
+            check = BENCH_FAIL;
+    }
+    cycles = _CP0_GET_COUNT() - start;
+    if (memcmp(in, out, RING_CHUNK) != 0)
+        check = BENCH_FAIL;
+    Bench_report("ring_write_read_64", BENCH_CALLS, cycles, check);
+}
+
+// Spans handed out in place, as the transmit interrupt drains them
+static void benchRingSpan() {
+    RingBuffer ring;
+    const uint8_t *readSpan;
+    uint8_t *writeSpan;
+    uint32_t start, cycles, moved = 0;
+    uint16_t i, length;
+    int8_t check = BENCH_PASS;
+
+    RingBuffer_init(&ring, ringStorage, sizeof(ringStorage));
+    start = _CP0_GET_COUNT();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        length = RingBuffer_reserveSpan(&ring, &writeSpan);
+        if (length > RING_CHUNK)
+            length = RING_CHUNK;
+        RingBuffer_publish(&ring, length);
+        length = RingBuffer_peekSpan(&ring, &readSpan);
+        RingBuffer_consume(&ring, length);
+        moved += length;
+    }
+    cycles = _CP0_GET_COUNT() - start;
+    if (!RingBuffer_isEmpty(&ring) || moved == 0)
+        check = BENCH_FAIL;
+    Bench_report("ring_span_publish_consume", BENCH_CALLS, cycles, check);
+}
+
+/**********************************************************************
+ * Timer interrupt                                                    *
+ **********************************************************************/
+
+#ifdef BENCH_HOST
+// The handler called straight, with the list holding TICK_TIMERS periodic
+//  timers, the fastest every millisecond so every tick expires one
+static void benchTimerTick() {
+    const uint8_t numbers[TICK_TIMERS] = { TIMER_TEST, TIMER_BAROMETER,
+        TIMER_ENCODER, TIMER_NAVIGATION };
+    const uint32_t periods[TICK_TIMERS] = { 1, 5, 10, 20 };
+    uint32_t start, cycles, before;
+    uint16_t i;
+    int8_t check = BENCH_PASS;
+
+    for (i = 0; i < TICK_TIMERS; i++)
+        Timer_newPeriodic(numbers[i], periods[i]);
+    before = get_time();
+    start = _CP0_GET_COUNT();
+    for (i = 0; i < BENCH_CALLS; i++)
+        Timer1IntHandler();
+    cycles = _CP0_GET_COUNT() - start;
+    if (get_time() - before != BENCH_CALLS || !Timer_isExpired(TIMER_TEST))
+        check = BENCH_FAIL;
+    for (i = 0; i < TICK_TIMERS; i++)
+        Timer_stop(numbers[i]);
+    Bench_report("timer_isr_tick", BENCH_CALLS, cycles, check);
+}
+#else
+// An interrupt can't be called, so the time it takes away from a spin
+//  loop is measured, with a 1 ms periodic timer making every tick
+static void benchTimerTick() {
+    uint32_t start, withTicks, withoutTicks, ticks;
+    volatile uint32_t spin;
+    int8_t check = BENCH_PASS;
+
+    Timer_newPeriodic(TIMER_TEST, 1);
+    ticks = get_time();
+    start = _CP0_GET_COUNT();
+    for (spin = 0; spin < BENCH_CALLS * 100; spin++)
+        ;
+    withTicks = _CP0_GET_COUNT() - start;
+    ticks = get_time() - ticks;
+
+    mT1IntEnable(0);
+    start = _CP0_GET_COUNT();
+    for (spin = 0; spin < BENCH_CALLS * 100; spin++)
+        ;
+    withoutTicks = _CP0_GET_COUNT() - start;
+    mT1IntEnable(1);
+    Timer_stop(TIMER_TEST);
+
+    if (ticks == 0 || withTicks < withoutTicks)
+        check = BENCH_FAIL;
+    Bench_report("timer_isr_tick", ticks, withTicks - withoutTicks, check);
+}
+#endif
+
+/**********************************************************************
+ * UBX decode                                                         *
+ **********************************************************************/
+
+static uint8_t *putU32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+    return out + 4;
+}
+
+static uint8_t *putUbx(uint8_t *out, uint8_t id, const uint8_t *payload,
+        uint16_t length) {
+    uint8_t a = 0, b = 0, *check;
+    *out++ = 0xB5;
+    *out++ = 0x62;
+    check = out;
+    *out++ = 0x01; // NAV
+    *out++ = id;
+    *out++ = (uint8_t)length;
+    *out++ = (uint8_t)(length >> 8);
+    memcpy(out, payload, length);
+    out += length;
+    for (; check < out; check++) {
+        a += *check;
+        b += a;
+    }
+    *out++ = a;
+    *out++ = b;
+    return out;
+}
+
+// A 5 Hz walk north from the operating point with a 3D fix throughout
+static uint16_t makeUbxStream() {
+    uint8_t payload[28], *out = ubxStream;
+    uint16_t epoch;
+    for (epoch = 0; epoch < UBX_EPOCHS; epoch++) {
+        memset(payload, 0, sizeof(payload));
+        putU32(payload, epoch * 200);
+        payload[4] = 0x03; // 3D fix
+        payload[5] = 0x01; // fix OK
+        out = putUbx(out, 0x03, payload, 16);
+
+        putU32(&payload[4], (uint32_t)(int32_t)(OPERATING_LONGITUDE * 1e7f));
+        putU32(&payload[8],
+            (uint32_t)(int32_t)(OPERATING_LATITUDE * 1e7f) + epoch * 10);
+        putU32(&payload[12], 10000);
+        putU32(&payload[16], 10000);
+        putU32(&payload[20], 2500);
+        putU32(&payload[24], 2500);
+        out = putUbx(out, 0x02, payload, 28);
+    }
+    return out - ubxStream;
+}
+
+static void benchUbxDecode() {
+    GpsStats stats;
+    uint32_t start, cycles = 0, bytes = 0;
+    uint16_t length = makeUbxStream(), i, round;
+    const uint16_t rounds = BENCH_CALLS / UBX_EPOCHS;
+    int8_t check = BENCH_PASS;
+
+    GPS_init(GPS_OPTION_NO_CONFIG);
+    GPS_clearStats();
+    for (round = 0; round < rounds; round++) {
+        start = _CP0_GET_COUNT();
+        for (i = 0; i < length; i++)
+            handleByte(ubxStream[i]);
+        cycles += _CP0_GET_COUNT() - start;
+        bytes += length;
+    }
+    GPS_getStats(&stats);
+    if (stats.messages != 2 * UBX_EPOCHS * rounds
+            || stats.checksumErrors != 0 || stats.lengthErrors != 0
+            || stats.fixes != UBX_EPOCHS * rounds || !GPS_hasPosition())
+        check = BENCH_FAIL;
+    Bench_report("ubx_decode_byte", bytes, cycles, check);
+}
+
+/**********************************************************************
+ * Thermal pixels                                                     *
+ **********************************************************************/
+
+// Calibration and a frame near what the sensor gives at room temperature
+static void benchIRTemp() {
+    const float chipK = 25.0f + 273.15f;
+    uint32_t start, cycles;
+    uint16_t i;
+    float expected, error = 0.0f;
+    int8_t check = BENCH_PASS;
+
+    chipTempK4 = chipK * chipK * chipK * chipK;
+    for (i = 0; i < THERMAL_PIXELS; i++) {
+        pixelData[i] = -40 + (int)(i * 5);
+        pixelOffset[i] = -48.0f + (i % 7);
+        inverseAlpha[i] = 1.0f / (2.0e-8f + i * 1.0e-10f);
+    }
+
+    start = _CP0_GET_COUNT();
+    for (i = 0; i < THERMAL_FRAMES; i++)
+        calculateIRTemp(temperatures);
+    cycles = _CP0_GET_COUNT() - start;
+
+    for (i = 0; i < THERMAL_PIXELS; i++) {
+        double v = pixelData[i] - pixelOffset[i];
+        expected = (float)((pow(v * inverseAlpha[i] + chipTempK4, 0.25)
+            - 273.15) * 1.8 + 32);
+        if (fabsf(temperatures[i] - expected) > error)
+            error = fabsf(temperatures[i] - expected);
+    }
+    if (error > THERMAL_TOLERANCE)
+        check = BENCH_FAIL;
+    Bench_report("thermal_ir_temp_frame", THERMAL_FRAMES, cycles, check);
+}
+
+/**********************************************************************
+ * Navigation conversions                                             *
+ **********************************************************************/
+
+static void benchEuler2NED() {
+    Coordinate ned;
+    uint32_t start, cycles = 0;
+    uint16_t i;
+    double error = 0.0;
+    int8_t check = BENCH_PASS;
+
+    for (i = 0; i < BENCH_CALLS; i++) {
+        float yaw = (i % 360) + 0.5f, pitch = 30.0f + (i % 60);
+        double mag = 5.0 * tan((90.0 - pitch) * M_PI / 180.0);
+        start = _CP0_GET_COUNT();
+        convertEuler2NED(&ned, yaw, pitch, 5.0f);
+        cycles += _CP0_GET_COUNT() - start;
+        error = fmax(error, hypot(ned.x - mag * cos(yaw * M_PI / 180.0),
+            ned.y - mag * sin(yaw * M_PI / 180.0)));
+    }
+    if (error > NED_TOLERANCE)
+        check = BENCH_FAIL;
+    Bench_report("nav_euler_to_ned", BENCH_CALLS, cycles, check);
+}
+
+// Both ways around the globe, checked by the round trip
+static void benchGeodetic() {
+    Coordinate ecef, lla;
+    uint32_t start, toEcef = 0, toGeodetic = 0;
+    uint16_t i;
+    double error = 0.0;
+    int8_t check = BENCH_PASS;
+
+    for (i = 0; i < BENCH_CALLS; i++) {
+        float lat = -89.0f + (i % 179), lon = -179.5f + (i % 359);
+        start = _CP0_GET_COUNT();
+        convertGeodetic2ECEF(&ecef, lat, lon, 100.0f);
+        toEcef += _CP0_GET_COUNT() - start;
+        start = _CP0_GET_COUNT();
+        convertECEF2Geodetic(&lla, ecef.x, ecef.y, ecef.z);
+        toGeodetic += _CP0_GET_COUNT() - start;
+        error = fmax(error, fabs(lla.x - lat) * METERS_PER_DEGREE);
+        error = fmax(error, fabs(lla.y - lon) * METERS_PER_DEGREE
+            * cos(lat * M_PI / 180.0));
+        error = fmax(error, fabs(lla.z - 100.0));
+    }
+    if (error > GEODETIC_TOLERANCE)
+        check = BENCH_FAIL;
+    Bench_report("nav_geodetic_to_ecef", BENCH_CALLS, toEcef, check);
+    Bench_report("nav_ecef_to_geodetic", BENCH_CALLS, toGeodetic, check);
+}
+
+static void benchENU2ECEF() {
+    Coordinate ecef;
+    uint32_t start, cycles;
+    uint16_t i;
+
+    start = _CP0_GET_COUNT();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        convertENU2ECEF(&ecef, (i % 400) - 200.0f, (i % 300) - 150.0f, 0.0f,
+            OPERATING_LATITUDE, OPERATING_LONGITUDE, 10.0f);
+        sink = ecef.x;
+    }
+    cycles = _CP0_GET_COUNT() - start;
+    Bench_report("nav_enu_to_ecef", BENCH_CALLS, cycles, BENCH_UNCHECKED);
+}
+
+/**********************************************************************
+ * Runner                                                             *
+ **********************************************************************/
+
+#ifdef BENCH_HOST
+int main(int argc, char **argv) {
+    if (argc > 1 && freopen(argv[1], "w", stdout) == NULL) {
+        perror(argv[1]);
+        return 2;
+    }
+#else
+int main() {
+    Board_init();
+    Serial_init();
+#endif
+    Timer_init();
+
+    printf("benchmark,calls,cycles_per_call,us_per_call,check\n");
+    benchRingByte();
+    benchRingChunk();
+    benchRingSpan();
+    Bench_queue();
+    benchTimerTick();
+    benchUbxDecode();
+    benchIRTemp();
+    benchEuler2NED();
+    benchGeodetic();
+    benchENU2ECEF();
+    printf("# %u failed\n", failures);
+
+#ifdef BENCH_HOST
+    return failures? 1 : 0;
+#else
+    while (1)
+        ;
+#endif
+}
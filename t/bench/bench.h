@@ -0,0 +1,38 @@
+/*
+ * Timing and reporting shared by the benchmarks, see t/bench/README.md.
+ *
+ * Kept free of Board.h and Util.h, which disagree about FAILURE, so the
+ * Queue benchmark can sit in its own file next to the rest.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+#define BENCH_CALLS         10000 // per benchmark
+
+// Outcome of the check run alongside a benchmark
+#define BENCH_PASS          1
+#define BENCH_FAIL          0
+#define BENCH_UNCHECKED     -1
+
+/**
+ * Function: Bench_report
+ * @param Name of the benchmark, no commas.
+ * @param Calls timed.
+ * @param (core timer ticks) Taken by all of them.
+ * @param BENCH_PASS, BENCH_FAIL or BENCH_UNCHECKED.
+ * @return None.
+ * @remark Prints one CSV line, see the README for the columns.
+ */
+void Bench_report(const char *name, uint32_t calls, uint32_t cycles,
+    int8_t check);
+
+/**
+ * Function: Bench_queue
+ * @return None.
+ * @remark Times Queue_enqueue and Queue_dequeue, and the item pool.
+ */
+void Bench_queue();
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Queue and item pool benchmarks, see t/bench/README.md.
+ *
+ * Apart from bench.c since Queue.h brings in Util.h.
+ */
+#include <xc.h>
+#include "Queue.h"
+#include "Item.h"
+#include "bench.h"
+
+static ITEM items[QUEUE_MAX_COUNT];
+static uint8_t payloads[QUEUE_MAX_COUNT];
+
+// Fills the queue and empties it again, the items must come back in order
+static void benchEnqueueDequeue() {
+    QUEUE queue;
+    uint32_t start, cycles;
+    uint16_t round, i;
+    int8_t check = BENCH_PASS;
+
+    Queue_init(&queue);
+    for (i = 0; i < QUEUE_MAX_COUNT; i++)
+        Item_init(&items[i], &payloads[i], sizeof(payloads[i]));
+
+    start = _CP0_GET_COUNT();
+    for (round = 0; round < BENCH_CALLS / QUEUE_MAX_COUNT; round++) {
+        for (i = 0; i < QUEUE_MAX_COUNT; i++)
+            Queue_enqueue(&queue, &items[i]);
+        for (i = 0; i < QUEUE_MAX_COUNT; i++) {
+            if (Queue_dequeue(&queue) != &items[i])
+                check = BENCH_FAIL;
+        }
+    }
+    cycles = _CP0_GET_COUNT() - start;
+    if (!Queue_isEmpty(&queue))
+        check = BENCH_FAIL;
+    Bench_report("queue_enqueue_dequeue", round * QUEUE_MAX_COUNT, cycles,
+        check);
+}
+
+// An inline item in and out of the pool, the way a UART frame goes
+static void benchItemPool() {
+    uint32_t start, cycles;
+    uint16_t i;
+    uint8_t data = 0x5A, freeCount = Item_getFreeCount();
+    Item item;
+    int8_t check = BENCH_PASS;
+
+    start = _CP0_GET_COUNT();
+    for (i = 0; i < BENCH_CALLS; i++) {
+        item = Item_createInline(&data, sizeof(data));
+        if (item == NULL) {
+            check = BENCH_FAIL;
+            continue;
+        }
+        if (*(uint8_t *)Item_getData(item) != data)
+            check = BENCH_FAIL;
+        Item_destroy(item);
+    }
+    cycles = _CP0_GET_COUNT() - start;
+    if (Item_getFreeCount() != freeCount)
+        check = BENCH_FAIL;
+    Bench_report("item_create_destroy", BENCH_CALLS, cycles, check);
+}
+
+void Bench_queue() {
+    benchEnqueueDequeue();
+    benchItemPool();
+}
@@ -0,0 +1,55 @@
+/*
+ * Stand-ins for the hardware when running the benchmarks on a PC, see
+ * t/bench/README.md. Nothing here is timed.
+ */
+#include <xc.h>
+#include <plib.h>
+#include "Board.h"
+#include "Serial.h"
+#include "Uart.h"
+#include "I2C.h"
+#include "Nvm.h"
+
+volatile uint32_t TMR1, PR1;
+volatile BenchIEC0bits IEC0bits;
+volatile BenchIFS0bits IFS0bits;
+
+void Board_init() {}
+uint32_t Board_GetPBClock() { return BOARD_PB_CLOCK; }
+char Serial_init(void) { return SUCCESS; }
+
+// The GPS benchmark feeds its bytes straight to the parser
+void UART_init(uint8_t id, uint32_t baudRate) {}
+uint16_t UART_read(uint8_t id, uint8_t *buffer, uint16_t maxLength) {
+    return 0;
+}
+uint16_t UART_write(uint8_t id, const uint8_t *data, uint16_t length) {
+    return length;
+}
+char UART_isTransmitEmpty(uint8_t id) { return TRUE; }
+
+// The thermal benchmark fills in the calibration itself
+void I2C_init(I2C_MODULE I2C_ID, uint32_t I2C_clockFreq) {}
+BOOL I2C_addDevice(I2C_MODULE I2C_ID, uint8_t address, uint32_t maxClock) {
+    return SUCCESS;
+}
+BOOL I2C_readRegisters(I2C_MODULE I2C_ID, uint8_t address, uint8_t reg,
+        uint8_t *data, uint8_t length) {
+    return FAILURE;
+}
+BOOL I2C_writeRegisters(I2C_MODULE I2C_ID, uint8_t address, uint8_t reg,
+        const uint8_t *data, uint8_t length) {
+    return FAILURE;
+}
+BOOL I2C_submit(I2C_MODULE I2C_ID, I2CTransfer *transfer) { return FAILURE; }
+I2CTransferStatus I2C_transfer(I2C_MODULE I2C_ID, I2CTransfer *transfer) {
+    return I2C_TRANSFER_NACK;
+}
+
+// No store, the calibration and GPS state are worked out as without one
+BOOL Nvm_isReady() { return FALSE; }
+int8_t Nvm_read(NvmKey key, void *data, uint8_t length) { return FAILURE; }
+int8_t Nvm_write(NvmKey key, const void *data, uint8_t length) {
+    return FAILURE;
+}
+int8_t Nvm_erase(NvmKey key) { return FAILURE; }
@@ -0,0 +1,29 @@
+/*
+ * Stand-in for Timer1 when building Timer.c on a PC, see
+ * t/bench/README.md. The registers are variables, nothing counts them, so
+ * time only moves when the benchmark calls the interrupt handler.
+ */
+#ifndef BENCH_PERIPHERAL_TIMER_H
+#define BENCH_PERIPHERAL_TIMER_H
+
+#include <stdint.h>
+
+extern volatile uint32_t TMR1, PR1;
+typedef struct { unsigned T1IE : 1; } BenchIEC0bits;
+typedef struct { unsigned T1IF : 1; } BenchIFS0bits;
+extern volatile BenchIEC0bits IEC0bits;
+extern volatile BenchIFS0bits IFS0bits;
+
+#define T1_ON               0x8000
+#define T1_SOURCE_INT       0x0000
+#define T1_PS_1_64          0x0020
+#define T1_INT_ON           0x8000
+#define T1_INT_PRIOR_3      0x0003
+
+#define OpenTimer1(config, period)  do { TMR1 = 0; PR1 = (period); } while (0)
+#define ConfigIntTimer1(config)     do { } while (0)
+#define mT1IntEnable(enable)        (IEC0bits.T1IE = (enable))
+#define mT1ClearIntFlag()           (IFS0bits.T1IF = 0)
+#define mT1GetIntFlag()             (IFS0bits.T1IF)
+
+#endif
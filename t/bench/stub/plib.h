@@ -0,0 +1,21 @@
+/*
+ * Stand-in for the PIC32 peripheral library when building the benchmarks
+ * on a PC, see t/bench/README.md.
+ */
+#ifndef BENCH_PLIB_H
+#define BENCH_PLIB_H
+
+#include <stdint.h>
+#include "peripheral/timer.h"
+
+typedef enum _BOOL { FALSE = 0, TRUE } BOOL;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef enum { I2C1, I2C2 } I2C_MODULE;
+
+// Nothing interrupts the benchmark
+static inline unsigned int INTDisableInterrupts(void) { return 0; }
+static inline void INTRestoreInterrupts(unsigned int status) { (void)status; }
+
+#endif
@@ -0,0 +1,23 @@
+/*
+ * Stand-in for the XC32 device header when building the benchmarks on a
+ * PC, see t/bench/README.md. Only what the modules under test touch.
+ */
+#ifndef BENCH_XC_H
+#define BENCH_XC_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Core timer at the board's 40 MHz, from the host's monotonic clock
+static inline uint32_t hostCoreCount(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec * 1000000000ULL + now.tv_nsec) / 25);
+}
+#define _CP0_GET_COUNT()    hostCoreCount()
+
+// Interrupt handlers are plain functions, the benchmark calls them
+#define __ISR(vector, ipl)
+#define _TIMER_1_VECTOR     4
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ * Bounded queue from one thread to one other without a lock, see
+ * tool/ground_station/README.md.
+ *
+ * Each side only writes its own index, and reads the other's with acquire,
+ * so a slot is written in full before the reader can see it and read in
+ * full before the writer can reuse it. The indexes only ever count up, the
+ * slot is the index modulo N, so full and empty can't be mistaken for each
+ * other. Each index is on a cache line of its own, or the two threads
+ * would keep taking the line from each other.
+ */
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+
+template <typename T, std::size_t N>
+class SpscQueue {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "N has to be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // Producer only, false if the queue is full
+    bool push(const T &item) {
+        std::size_t at = tail.load(std::memory_order_relaxed);
+        if (at - head.load(std::memory_order_acquire) == N)
+            return false;
+        items[at & (N - 1)] = item;
+        tail.store(at + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only, false if the queue is empty
+    bool pop(T &item) {
+        std::size_t at = head.load(std::memory_order_relaxed);
+        if (at == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[at & (N - 1)];
+        head.store(at + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire)
+            == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    SpscQueue(const SpscQueue &);
+    SpscQueue &operator=(const SpscQueue &);
+
+    alignas(64) std::atomic<std::size_t> head; // next to pop
+    alignas(64) std::atomic<std::size_t> tail; // next to push
+    alignas(64) T items[N];
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,561 @@
+/*
+ * Ground station for the fleet, see tool/ground_station/README.md.
+ *
+ * The main thread only reads the radio: it waits in poll(), takes
+ * whatever bytes are there, frames them into MAVLink messages and offers
+ * each one to every consumer's queue. A full queue drops the message for
+ * that consumer and counts it, so a slow disk or terminal never holds up
+ * the port. Each consumer runs on a thread of its own: the capture logger
+ * appends to a serial_logger capture, and the fleet display keeps the
+ * latest of each boat in a table indexed by system id and prints it.
+ */
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+#include "mavlink/autoLifeguard/mavlink.h"
+#include "SpscQueue.hpp"
+
+namespace {
+
+const int DEFAULT_BAUD = 57600; // XBEE_API_BAUD_RATE
+const std::size_t QUEUE_SIZE = 4096; // messages a consumer may fall behind
+const unsigned BATCH_MAX = 256; // messages a consumer takes between ticks
+const int POLL_TIMEOUT = 100; // (ms) so a stop is noticed
+const double DISPLAY_PERIOD = 1.0; // (s) default, -p
+const double BOAT_TIMEOUT = 4.0; // (s) MAVLINK_PEER_TIMEOUT, shown as lost
+const unsigned SYSTEM_BASE = 15; // MAVLINK_SYSTEM_BASE, see Mavlink.h
+const double COORDINATE_SCALE = 1e7; // GPS_COORDINATE_SCALE
+
+// XBee API frames, as src/Xbee.c reads them
+const uint8_t API_START = 0x7E;
+const uint8_t API_ESCAPE = 0x7D;
+const uint8_t API_ESCAPE_XOR = 0x20;
+const uint8_t API_RX16 = 0x81;
+const unsigned API_FRAME_MAX = 105; // XBEE_PAYLOAD_MAX + 5
+
+const uint16_t ADDRESS_UNKNOWN = 0xFFFE; // MAVLINK_ADDRESS_UNKNOWN
+
+// serial_logger's capture, see tool/serial_logger/src/MavlinkCapture.py
+const char CAPTURE_MAGIC[] = "ALGCAP1\n";
+const char INDEX_SUFFIX[] = ".idx";
+
+const char *GUIDANCE_NAMES[] = { "idle", "tracking", "holding", "arrived" };
+
+std::atomic<bool> running(true);
+
+// A message as it came in
+struct Frame {
+    double hostTime; // (s) since the epoch
+    uint16_t address; // radio it came from, ADDRESS_UNKNOWN on a raw stream
+    int8_t rssi; // (dBm) of its packet, 0 on a raw stream
+    mavlink_message_t msg;
+};
+
+double hostTime() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1e6;
+}
+
+void stop(int) {
+    running = false;
+}
+
+/**********************************************************************
+ * Consumers                                                          *
+ **********************************************************************/
+
+// Takes messages off its queue on its own thread, see offer
+class Consumer {
+public:
+    Consumer() : dropped(0) {}
+    virtual ~Consumer() {}
+
+    // From the reading thread. A message that won't fit is dropped, unless
+    //  waiting is allowed, which is only for reading a file.
+    void offer(const Frame &frame, bool mayWait) {
+        while (!queue.push(frame)) {
+            if (!mayWait || !running) {
+                dropped++;
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Until the stop, then what's left in the queue
+    void run() {
+        Frame frame;
+        unsigned taken;
+        for (;;) {
+            for (taken = 0; taken < BATCH_MAX && queue.pop(frame); taken++)
+                handle(frame);
+            tick(hostTime());
+            if (taken == 0) {
+                if (!running && queue.empty())
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        finish();
+    }
+
+    unsigned long getDropped() const { return dropped; }
+    virtual const char *name() const = 0;
+
+protected:
+    virtual void handle(const Frame &frame) = 0;
+    virtual void tick(double) {}
+    virtual void finish() {}
+
+private:
+    SpscQueue<Frame, QUEUE_SIZE> queue;
+    std::atomic<unsigned long> dropped;
+};
+
+// Appends every message to a capture that MavlinkCapture.py and
+//  parser_replay read back. Written little endian as on the PC.
+class CaptureLogger : public Consumer {
+public:
+    explicit CaptureLogger(const std::string &path)
+        : file(fopen(path.c_str(), "wb")),
+          index(fopen((path + INDEX_SUFFIX).c_str(), "wb")),
+          offset(sizeof(CAPTURE_MAGIC) - 1), isDirty(false) {
+        if (file == NULL || index == NULL) {
+            perror(path.c_str());
+            exit(1);
+        }
+        fwrite(CAPTURE_MAGIC, 1, sizeof(CAPTURE_MAGIC) - 1, file);
+    }
+
+    ~CaptureLogger() {
+        fclose(file);
+        fclose(index);
+    }
+
+    const char *name() const { return "log"; }
+
+protected:
+    void handle(const Frame &frame) {
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t length = mavlink_msg_to_send_buffer(buffer, &frame.msg);
+        fwrite(&frame.hostTime, sizeof(frame.hostTime), 1, index);
+        fwrite(&offset, sizeof(offset), 1, index);
+        fwrite(&frame.msg.msgid, sizeof(frame.msg.msgid), 1, index);
+        fwrite(&frame.hostTime, sizeof(frame.hostTime), 1, file);
+        fwrite(&length, sizeof(length), 1, file);
+        fwrite(buffer, 1, length, file);
+        offset += sizeof(frame.hostTime) + sizeof(length) + length;
+        isDirty = true;
+    }
+
+    // Out to the disk whenever the queue runs dry, so a crash only loses
+    //  the last burst
+    void tick(double) {
+        if (!isDirty)
+            return;
+        fflush(file);
+        fflush(index);
+        isDirty = false;
+    }
+
+private:
+    FILE *file, *index;
+    uint32_t offset;
+    bool isDirty;
+};
+
+/* Latest of one system, a cache line each, the ones updated by every
+ * message first. Indexed by system id, so a message finds its boat
+ * without a search, and the table is 16 KB, well inside the L1 cache. */
+struct alignas(64) BoatState {
+    double heardTime; // (s) 0 before a message
+    uint32_t frames, lost; // messages, and sequence numbers missed
+    uint8_t lastSeq;
+    int8_t rssi;
+    uint16_t address;
+    double positionTime; // (s) of the last BOAT_POSITION, 0 before one
+    int32_t latitude, longitude; // (1e-7 degrees)
+    int16_t velocityNorth, velocityEast; // (cm/s)
+    uint16_t heading, accuracy; // (centidegrees), (cm)
+    uint8_t guidance; // GuidanceState
+    uint16_t voltage; // (mV) 0 before a BATTERY
+    uint32_t errors; // ERROR_EVENTs
+    uint8_t errorModule, errorCode; // of the last one
+};
+
+// Keeps every system's latest state and prints the table every period
+class FleetDisplay : public Consumer {
+public:
+    explicit FleetDisplay(double period)
+        : period(period), lastPrint(0.0) {
+        unsigned id;
+        memset(boats, 0, sizeof(boats));
+        for (id = 0; id < 256; id++)
+            boats[id].address = ADDRESS_UNKNOWN;
+    }
+
+    const char *name() const { return "display"; }
+
+protected:
+    void handle(const Frame &frame) {
+        const mavlink_message_t &msg = frame.msg;
+        BoatState &boat = boats[msg.sysid];
+        uint8_t gap;
+        // A gap is what was lost, going back is a resend or a reboot
+        if (boat.frames != 0) {
+            gap = (uint8_t)(msg.seq - boat.lastSeq - 1);
+            if (gap < 128)
+                boat.lost += gap;
+        }
+        boat.lastSeq = msg.seq;
+        boat.frames++;
+        boat.heardTime = frame.hostTime;
+        if (frame.address != ADDRESS_UNKNOWN) {
+            boat.address = frame.address;
+            boat.rssi = frame.rssi;
+        }
+
+        switch (msg.msgid) {
+            case MAVLINK_MSG_ID_BOAT_POSITION: {
+                mavlink_boat_position_t position;
+                mavlink_msg_boat_position_decode(&msg, &position);
+                boat.positionTime = frame.hostTime;
+                boat.latitude = position.latitude;
+                boat.longitude = position.longitude;
+                boat.velocityNorth = position.velocity_north;
+                boat.velocityEast = position.velocity_east;
+                boat.heading = position.heading;
+                boat.accuracy = position.accuracy;
+                boat.guidance = position.guidance;
+                break;
+            }
+            case MAVLINK_MSG_ID_BATTERY:
+                boat.voltage = mavlink_msg_battery_get_voltage(&msg);
+                break;
+            case MAVLINK_MSG_ID_ERROR_EVENT:
+                boat.errors++;
+                boat.errorModule = mavlink_msg_error_event_get_module(&msg);
+                boat.errorCode = mavlink_msg_error_event_get_code(&msg);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void tick(double now) {
+        if (now - lastPrint < period)
+            return;
+        lastPrint = now;
+        print(now);
+    }
+
+    void finish() {
+        print(hostTime());
+    }
+
+private:
+    void print(double now) {
+        unsigned id;
+        printf("\n sys  addr   seen  latitude     longitude     m/s   head"
+            "  acc(m) guidance   volts  frames lost%%  rssi errors\n");
+        for (id = 0; id < 256; id++) {
+            const BoatState &boat = boats[id];
+            if (boat.frames == 0)
+                continue;
+            printf("%4u%s", id, (id == SYSTEM_BASE)? "*" : " ");
+            if (boat.address != ADDRESS_UNKNOWN)
+                printf(" %04X", boat.address);
+            else
+                printf(" %4s", "-");
+            printf(" %5.1fs", now - boat.heardTime);
+            if (boat.positionTime != 0.0)
+                printf(" %12.7f %13.7f %5.1f %6.1f %7.1f %-8s",
+                    boat.latitude / COORDINATE_SCALE,
+                    boat.longitude / COORDINATE_SCALE,
+                    hypot(boat.velocityNorth, boat.velocityEast) / 100.0,
+                    boat.heading / 100.0, boat.accuracy / 100.0,
+                    (boat.guidance < 4)? GUIDANCE_NAMES[boat.guidance] : "?");
+            else
+                printf(" %12s %13s %5s %6s %7s %-8s", "-", "-", "-", "-", "-",
+                    "-");
+            if (boat.voltage != 0)
+                printf("  %6.2f", boat.voltage / 1000.0);
+            else
+                printf("  %6s", "-");
+            printf(" %7lu %5.1f %5d %4lu", (unsigned long)boat.frames,
+                100.0 * boat.lost / (boat.frames + boat.lost), boat.rssi,
+                (unsigned long)boat.errors);
+            if (boat.errors != 0)
+                printf(" last %u/%u", boat.errorModule, boat.errorCode);
+            if (now - boat.heardTime >= BOAT_TIMEOUT)
+                printf(" LOST");
+            printf("\n");
+        }
+        fflush(stdout);
+    }
+
+    BoatState boats[256];
+    double period, lastPrint;
+};
+
+/**********************************************************************
+ * Reading                                                            *
+ **********************************************************************/
+
+// Frames bytes into messages, out of XBee API frames or a raw stream
+class FrameReader {
+public:
+    FrameReader(bool isApi, std::vector<Consumer *> &consumers, bool mayWait)
+        : isApi(isApi), consumers(consumers), mayWait(mayWait),
+          apiIndex(0), apiLength(0), apiChecksum(0), isEscaped(false),
+          bytes(0), messages(0), drops(0), apiErrors(0) {
+        memset(&status, 0, sizeof(status));
+    }
+
+    void feed(const uint8_t *data, std::size_t length) {
+        double now = hostTime();
+        std::size_t i;
+        bytes += length;
+        for (i = 0; i < length; i++) {
+            if (isApi)
+                feedApi(data[i], now);
+            else
+                feedMavlink(data[i], ADDRESS_UNKNOWN, 0, now);
+        }
+    }
+
+    void printStats() const {
+        printf("read %lu bytes, %lu messages, %lu dropped by the parser",
+            bytes, messages, drops);
+        if (isApi)
+            printf(", %lu bad API frames", apiErrors);
+        printf("\n");
+    }
+
+private:
+    void feedMavlink(uint8_t c, uint16_t address, int8_t rssi, double now) {
+        Frame frame;
+        std::size_t i;
+        if (!mavlink_parse_char(MAVLINK_COMM_0, c, &frame.msg, &status)) {
+            drops += status.packet_rx_drop_count;
+            return;
+        }
+        messages++;
+        frame.hostTime = now;
+        frame.address = address;
+        frame.rssi = rssi;
+        for (i = 0; i < consumers.size(); i++)
+            consumers[i]->offer(frame, mayWait);
+    }
+
+    // As readApi in src/Xbee.c, a start byte always starts a frame
+    void feedApi(uint8_t c, double now) {
+        unsigned i;
+        if (c == API_START) {
+            if (apiIndex != 0)
+                apiErrors++;
+            apiIndex = 1;
+            isEscaped = false;
+            return;
+        }
+        if (apiIndex == 0)
+            return;
+        if (c == API_ESCAPE) {
+            isEscaped = true;
+            return;
+        }
+        if (isEscaped) {
+            c ^= API_ESCAPE_XOR;
+            isEscaped = false;
+        }
+        if (apiIndex == 1) {
+            apiLength = (unsigned)c << 8;
+        } else if (apiIndex == 2) {
+            apiLength |= c;
+            apiChecksum = 0;
+            if (apiLength == 0 || apiLength > API_FRAME_MAX) {
+                apiErrors++;
+                apiIndex = 0;
+                return;
+            }
+        } else if (apiIndex < 3 + apiLength) {
+            apiFrame[apiIndex - 3] = c;
+            apiChecksum += c;
+        } else {
+            apiIndex = 0;
+            if ((uint8_t)(apiChecksum + c) != 0xFF) {
+                apiErrors++;
+                return;
+            }
+            // source address, RSSI as -dBm, options, then the data
+            if (apiFrame[0] != API_RX16 || apiLength < 5)
+                return;
+            for (i = 5; i < apiLength; i++)
+                feedMavlink(apiFrame[i], (apiFrame[1] << 8) | apiFrame[2],
+                    -(int8_t)apiFrame[3], now);
+            return;
+        }
+        apiIndex++;
+    }
+
+    bool isApi;
+    std::vector<Consumer *> &consumers;
+    bool mayWait;
+    mavlink_status_t status;
+    uint8_t apiFrame[API_FRAME_MAX];
+    unsigned apiIndex, apiLength;
+    uint8_t apiChecksum;
+    bool isEscaped;
+    unsigned long bytes, messages, drops, apiErrors;
+};
+
+speed_t baudCode(int baud) {
+    switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        default:
+            fprintf(stderr, "unsupported baud rate %d\n", baud);
+            exit(2);
+    }
+}
+
+int openPort(const char *path, int baud) {
+    struct termios options;
+    int fd = open(path, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0 || tcgetattr(fd, &options) != 0) {
+        perror(path);
+        exit(1);
+    }
+    cfmakeraw(&options);
+    cfsetispeed(&options, baudCode(baud));
+    cfsetospeed(&options, baudCode(baud));
+    options.c_cflag |= CLOCAL | CREAD;
+    if (tcsetattr(fd, TCSANOW, &options) != 0) {
+        perror(path);
+        exit(1);
+    }
+    tcflush(fd, TCIFLUSH);
+    return fd;
+}
+
+// Everything that's waiting each time poll says there is some, until the
+//  stop, or the end of a file
+void readLoop(int fd, FrameReader &reader) {
+    uint8_t buffer[4096];
+    struct pollfd wait;
+    ssize_t length;
+    wait.fd = fd;
+    wait.events = POLLIN;
+    while (running) {
+        if (poll(&wait, 1, POLL_TIMEOUT) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("poll");
+            break;
+        }
+        if (!(wait.revents & (POLLIN | POLLHUP | POLLERR)))
+            continue;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+            reader.feed(buffer, length);
+        if (length == 0 || (length < 0 && errno != EAGAIN
+                && errno != EWOULDBLOCK && errno != EINTR))
+            break; // end of the file, or the port went away
+    }
+}
+
+void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-a] [-b baud] [-l capture_file] [-p period] "
+        "device | -f file\n"
+        "  -a  the radio is in API mode, as the board runs it\n"
+        "  -b  baud rate (default %d)\n"
+        "  -l  append every message to a serial_logger capture\n"
+        "  -p  seconds between fleet tables (default %.0f)\n"
+        "  -f  read recorded bytes from a file instead of a port\n",
+        name, DEFAULT_BAUD, DISPLAY_PERIOD);
+    exit(2);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool isApi = false, isFile = false;
+    int baud = DEFAULT_BAUD, fd, i;
+    double period = DISPLAY_PERIOD;
+    const char *path = NULL, *capture = NULL;
+    std::vector<Consumer *> consumers;
+    std::vector<std::thread> threads;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-a") == 0)
+            isApi = true;
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+            baud = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+            capture = argv[++i];
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+            period = atof(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            path = argv[++i];
+            isFile = true;
+        }
+        else if (argv[i][0] != '-' && path == NULL)
+            path = argv[i];
+        else
+            usage(argv[0]);
+    }
+    if (path == NULL)
+        usage(argv[0]);
+
+    if (isFile) {
+        fd = open(path, O_RDONLY | O_NONBLOCK);
+        if (fd < 0) {
+            perror(path);
+            return 1;
+        }
+    } else {
+        fd = openPort(path, baud);
+    }
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    if (capture != NULL)
+        consumers.push_back(new CaptureLogger(capture));
+    consumers.push_back(new FleetDisplay(period));
+    for (i = 0; i < (int)consumers.size(); i++)
+        threads.push_back(std::thread(&Consumer::run, consumers[i]));
+
+    // A file is read no faster than the consumers take it, a port as it
+    //  comes whatever they do
+    FrameReader reader(isApi, consumers, isFile);
+    readLoop(fd, reader);
+    running = false;
+    close(fd);
+
+    for (i = 0; i < (int)threads.size(); i++)
+        threads[i].join();
+    reader.printStats();
+    for (i = 0; i < (int)consumers.size(); i++) {
+        printf("%s dropped %lu messages\n", consumers[i]->name(),
+            consumers[i]->getDropped());
+        delete consumers[i];
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+#!/usr/bin/env python
+"""\
+log_decoder.py turns the binary records queued by SERIAL_LOG on the board
+back into text. Anything that is not a valid record (printf output) is
+passed through unchanged.
+
+Usage:
+    python log_decoder.py [-f ../../include/LogFormats.h] [capture_file]
+
+Reads the capture from stdin when no file is given, e.g. a file recorded
+with the serial_logger tool.
+
+Notes:
+-----
+* Record layout: 0xA5, id, argument count, sequence, arguments as little
+  endian 32-bit words, then the XOR of every byte after the 0xA5.
+* Format strings come from the LOG_FORMAT lines of LogFormats.h, in order.
+
+"""
+import os
+import re
+import struct
+import sys
+import argparse
+
+SYNC = 0xA5
+HEADER_LENGTH = 4
+MAX_ARGS = 6
+DEFAULT_FORMATS = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+    '..', '..', 'include', 'LogFormats.h')
+
+FORMAT_PATTERN = re.compile(r'LOG_FORMAT\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+SPEC_PATTERN = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?[a-zA-Z]')
+
+
+def load_formats(path):
+    """Returns the list of (name, format) in LogFormats.h order."""
+    with open(path) as f:
+        text = f.read()
+    return [(name, fmt.encode('latin-1').decode('unicode_escape'))
+        for name, fmt in FORMAT_PATTERN.findall(text)]
+
+
+def format_record(formats, record_id, words):
+    if record_id >= len(formats):
+        return 'unknown log id %d %r' % (record_id, words)
+    name, fmt = formats[record_id]
+    values = []
+    for spec, word in zip(SPEC_PATTERN.findall(fmt), words):
+        kind = spec[-1]
+        if kind in 'fFeEgG':
+            values.append(struct.unpack('<f', struct.pack('<I', word))[0])
+        elif kind in 'di':
+            values.append(struct.unpack('<i', struct.pack('<I', word))[0])
+        else:
+            values.append(word)
+    fmt = re.sub(r'%l+([diuxX])', r'%\1', fmt).replace('%u', '%d')
+    try:
+        return fmt % tuple(values)
+    except (TypeError, ValueError):
+        return '%s %r' % (name, words)
+
+
+def decode(data, formats, out):
+    """Decodes a bytearray, writing text to out. Returns the last sequence."""
+    i = 0
+    sequence = None
+    text = bytearray()
+    while i < len(data):
+        if data[i] == SYNC and i + HEADER_LENGTH < len(data):
+            count = data[i + 2]
+            length = HEADER_LENGTH + 4 * count
+            if count <= MAX_ARGS and i + length < len(data):
+                checksum = 0
+                for b in data[i + 1:i + length]:
+                    checksum ^= b
+                if checksum == data[i + length]:
+                    if text:
+                        out.write(text.decode('latin-1'))
+                        text = bytearray()
+                    seq = data[i + 3]
+                    if sequence is not None and seq != (sequence + 1) & 0xFF:
+                        out.write('[log: sequence gap %d -> %d]\n' % (sequence, seq))
+                    sequence = seq
+                    words = struct.unpack('<%dI' % count,
+                        bytes(data[i + HEADER_LENGTH:i + length]))
+                    out.write('[%3d] %s\n' % (seq,
+                        format_record(formats, data[i + 1], words)))
+                    i += length + 1
+                    continue
+        text.append(data[i])
+        i += 1
+    if text:
+        out.write(text.decode('latin-1'))
+    return sequence
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode SERIAL_LOG records.')
+    parser.add_argument('-f', '--formats', default=DEFAULT_FORMATS,
+        help='LogFormats.h to read format strings from (default: %(default)s)')
+    parser.add_argument('capture', nargs='?',
+        help='binary capture to decode (default: stdin)')
+    args = parser.parse_args()
+
+    formats = load_formats(args.formats)
+    if args.capture:
+        with open(args.capture, 'rb') as f:
+            data = bytearray(f.read())
+    else:
+        stream = getattr(sys.stdin, 'buffer', sys.stdin)
+        data = bytearray(stream.read())
+    decode(data, formats, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
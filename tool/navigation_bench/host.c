@@ -0,0 +1,43 @@
+/*
+ * Board, timer, GPS and flash store stand-ins for running the Navigation
+ * benchmark on a PC. The GPS sits still at the operating point, like the
+ * command center.
+ */
+#include <stdio.h>
+#include "Board.h"
+#include "Timer.h"
+#include "Gps.h"
+#include "Nvm.h"
+
+void Board_init() {}
+char Serial_init(void) { return SUCCESS; }
+void Timer_init(void) {}
+int8_t Timer_new(uint8_t timerNumber, uint32_t newTime) { return SUCCESS; }
+BOOL Timer_isExpired(uint8_t timerNumber) { return TRUE; }
+uint32_t get_time(void) { return hostCoreCount() / 40000; }
+uint32_t Timer_getCycles() { return hostCoreCount(); }
+
+BOOL GPS_init(uint8_t options) { return SUCCESS; }
+BOOL GPS_isInitialized() { return TRUE; }
+BOOL GPS_isConfigured() { return TRUE; }
+BOOL GPS_isConfigSaved() { return FALSE; }
+void GPS_setWarmStart(const GpsCoordinate *position, uint32_t accuracy) {}
+void GPS_runSM() {}
+int32_t GPS_isConnected() { return TRUE; }
+BOOL GPS_hasFix() { return TRUE; }
+BOOL GPS_hasPosition() { return TRUE; }
+float GPS_getLatitude() { return 36.95f; }
+float GPS_getLongitude() { return -122.03f; }
+float GPS_getAltitude() { return 10.0f; }
+void GPS_getCoordinate(GpsCoordinate *coord) {
+    coord->latitude = 369500000;
+    coord->longitude = -1220300000;
+    coord->altitude = 10000;
+}
+
+// No store, the GPS state is worked out as without one
+int8_t Nvm_read(NvmKey key, void *data, uint8_t length) { return FAILURE; }
+int8_t Nvm_write(NvmKey key, const void *data, uint8_t length) {
+    return FAILURE;
+}
+int8_t Nvm_erase(NvmKey key) { return FAILURE; }
@@ -0,0 +1,10 @@
+/*
+ * Stand-in for the PIC32 peripheral library when building Navigation.c on
+ * a PC, see tool/navigation_bench/README.md.
+ */
+#ifndef NAVIGATION_BENCH_PLIB_H
+#define NAVIGATION_BENCH_PLIB_H
+
+typedef enum _BOOL { FALSE = 0, TRUE } BOOL;
+
+#endif
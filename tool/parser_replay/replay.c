@@ -0,0 +1,335 @@
+/*
+ * Streams recorded bytes through the board's GPS and MAVLink parsers on a
+ * PC, as fast as they'll go, see tool/parser_replay/README.md.
+ *
+ * The UART, timer and XBee are stood in for here. The UART hands out the
+ * recording a chunk at a time, and the board's clock moves on by the time
+ * those bytes take at the recording's baud rate, so the parsers' timeouts
+ * and fix history behave as they did on the board. The rate reported is
+ * from the host's own clock.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Board.h"
+#include "Timer.h"
+#include "Uart.h"
+#include "Xbee.h"
+#include "Gps.h"
+#include "Mavlink.h"
+
+#define GPS_BAUD            115200
+#define MAVLINK_BAUD        115200
+#define BITS_PER_BYTE       10 // with the start and stop bits
+#define TIMERS              16
+#define CAPTURE_MAGIC       "ALGCAP1\n"
+#define CAPTURE_PACKET      10 // (bytes) host time (double), frame length
+#define EPOCH               200 // (ms) of the fixes made from a .dlm
+
+// UBX
+#define SYNC1               0xB5
+#define SYNC2               0x62
+#define NAV_CLASS           0x01
+#define NAV_POSLLH_ID       0x02
+#define NAV_STATUS_ID       0x03
+#define POSLLH_LENGTH       28
+#define STATUS_LENGTH       16
+#define FIX_3D              0x03
+#define FIX_OK              0x01
+#define HORIZONTAL_ACCURACY 2500 // (mm) given to fixes made from a .dlm
+
+typedef struct {
+    uint8_t *data;
+    size_t length, read;
+} Recording;
+
+static Recording recording;
+static uint32_t baud = GPS_BAUD;
+static uint64_t boardMicros = 0; // the board's clock, moved by the bytes
+static struct {
+    BOOL isActive;
+    uint64_t expires; // (us)
+} timers[TIMERS];
+
+/**********************************************************************
+ * Board stand-ins                                                    *
+ **********************************************************************/
+
+void UART_init(uint8_t id, uint32_t baudRate) {}
+uint16_t UART_read(uint8_t id, uint8_t *buffer, uint16_t maxLength) {
+    size_t left = recording.length - recording.read;
+    uint16_t length = (left < maxLength)? (uint16_t)left : maxLength;
+    memcpy(buffer, recording.data + recording.read, length);
+    recording.read += length;
+    boardMicros += (uint64_t)length * BITS_PER_BYTE * 1000000 / baud;
+    return length;
+}
+uint16_t UART_write(uint8_t id, const uint8_t *data, uint16_t length) {
+    return length;
+}
+uint16_t UART_getTransmitSpace(uint8_t id) { return 0xFFFF; }
+char UART_isTransmitEmpty(uint8_t id) { return TRUE; }
+uint16_t UART_reserve(uint8_t id, uint8_t **region, uint16_t length) {
+    static uint8_t discard[MAVLINK_MAX_PACKET_LEN];
+    *region = discard;
+    return (length <= sizeof(discard))? length : 0;
+}
+void UART_commit(uint8_t id, uint16_t length) {}
+char UART_getStats(uint8_t id, UartStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    return SUCCESS;
+}
+
+int8_t Timer_new(uint8_t timerNumber, uint32_t newTime) {
+    if (timerNumber >= TIMERS)
+        return FAILURE;
+    timers[timerNumber].isActive = TRUE;
+    timers[timerNumber].expires = boardMicros + (uint64_t)newTime * 1000;
+    return SUCCESS;
+}
+BOOL Timer_isExpired(uint8_t timerNumber) {
+    return timerNumber < TIMERS && timers[timerNumber].isActive
+        && boardMicros >= timers[timerNumber].expires;
+}
+uint32_t get_time(void) { return (uint32_t)(boardMicros / 1000); }
+uint32_t Timer_getMicros() { return hostCoreCount() / 40; }
+
+uint8_t Xbee_send(const uint8_t *data, uint16_t length) {
+    return SUCCESS;
+}
+uint8_t Xbee_sendTo(uint16_t address, const uint8_t *data, uint16_t length) {
+    return SUCCESS;
+}
+void Xbee_getStats(XbeeStats *stats) { memset(stats, 0, sizeof(*stats)); }
+
+/**********************************************************************
+ * Recordings                                                         *
+ **********************************************************************/
+
+static uint8_t *readFile(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    uint8_t *data;
+    long size;
+    if (file == NULL) {
+        perror(path);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc(size > 0? size : 1);
+    *length = fread(data, 1, size, file);
+    fclose(file);
+    return data;
+}
+
+static uint8_t *putU32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+    return out + 4;
+}
+
+static uint8_t *putUbx(uint8_t *out, uint8_t id, const uint8_t *payload,
+        uint16_t length) {
+    uint8_t a = 0, b = 0, *check;
+    *out++ = SYNC1;
+    *out++ = SYNC2;
+    check = out;
+    *out++ = NAV_CLASS;
+    *out++ = id;
+    *out++ = (uint8_t)length;
+    *out++ = (uint8_t)(length >> 8);
+    memcpy(out, payload, length);
+    out += length;
+    for (; check < out; check++) {
+        a += *check;
+        b += a;
+    }
+    *out++ = a;
+    *out++ = b;
+    return out;
+}
+
+/*
+ * The archive under model/gps/data keeps decoded fixes, one
+ * "latitude,longitude,altitude" line each, not the receiver's bytes. They
+ * are turned back into the NAV-STATUS and NAV-POSLLH of a 5 Hz epoch.
+ */
+static uint8_t *dlmToUbx(const uint8_t *text, size_t textLength,
+        size_t *length) {
+    const size_t epochBytes = 2 * 8 + POSLLH_LENGTH + STATUS_LENGTH;
+    size_t lines = 1, i;
+    uint8_t *data, *out, payload[POSLLH_LENGTH];
+    const char *line = (const char *)text, *end = line + textLength;
+    uint32_t iTOW = 0;
+
+    for (i = 0; i < textLength; i++)
+        lines += (text[i] == '\n');
+    data = out = malloc(lines * epochBytes);
+    while (line < end) {
+        double latitude, longitude, altitude;
+        const char *next = memchr(line, '\n', end - line);
+        next = (next == NULL)? end : next + 1;
+        if (sscanf(line, "%lf,%lf,%lf", &latitude, &longitude, &altitude) == 3) {
+            memset(payload, 0, sizeof(payload));
+            putU32(payload, iTOW);
+            payload[4] = FIX_3D;
+            payload[5] = FIX_OK;
+            out = putUbx(out, NAV_STATUS_ID, payload, STATUS_LENGTH);
+
+            putU32(&payload[4], (uint32_t)(int32_t)(longitude * 1e7));
+            putU32(&payload[8], (uint32_t)(int32_t)(latitude * 1e7));
+            putU32(&payload[12], (uint32_t)(int32_t)(altitude * 1000.0));
+            putU32(&payload[16], (uint32_t)(int32_t)(altitude * 1000.0));
+            putU32(&payload[20], HORIZONTAL_ACCURACY);
+            putU32(&payload[24], HORIZONTAL_ACCURACY);
+            out = putUbx(out, NAV_POSLLH_ID, payload, POSLLH_LENGTH);
+            iTOW += EPOCH;
+        }
+        line = next;
+    }
+    *length = out - data;
+    return data;
+}
+
+// Frames out of a serial_logger MAVLink capture, back to back
+static uint8_t *captureToStream(const uint8_t *capture, size_t captureLength,
+        size_t *length) {
+    size_t i = strlen(CAPTURE_MAGIC);
+    uint8_t *data = malloc(captureLength), *out = data;
+    while (i + CAPTURE_PACKET <= captureLength) {
+        uint16_t frame = capture[i + 8] | (capture[i + 9] << 8);
+        i += CAPTURE_PACKET;
+        if (i + frame > captureLength)
+            break;
+        memcpy(out, capture + i, frame);
+        out += frame;
+        i += frame;
+    }
+    *length = out - data;
+    return data;
+}
+
+static BOOL endsWith(const char *text, const char *suffix) {
+    size_t length = strlen(text), suffixLength = strlen(suffix);
+    return length >= suffixLength
+        && strcmp(text + length - suffixLength, suffix) == 0;
+}
+
+static void load(const char *path) {
+    size_t length;
+    uint8_t *data = readFile(path, &length);
+    free(recording.data);
+    if (endsWith(path, ".dlm")) {
+        recording.data = dlmToUbx(data, length, &recording.length);
+        free(data);
+    }
+    else if (length >= strlen(CAPTURE_MAGIC)
+            && memcmp(data, CAPTURE_MAGIC, strlen(CAPTURE_MAGIC)) == 0) {
+        recording.data = captureToStream(data, length, &recording.length);
+        free(data);
+    }
+    else {
+        recording.data = data;
+        recording.length = length;
+    }
+    recording.read = 0;
+}
+
+/**********************************************************************
+ * Replays                                                            *
+ **********************************************************************/
+
+static double hostSeconds(uint32_t startCycles) {
+    return (uint32_t)(hostCoreCount() - startCycles) / 40e6;
+}
+
+static void report(const char *path, size_t bytes, double seconds,
+        uint32_t frames, uint32_t rejects, uint32_t fixes) {
+    if (seconds <= 0.0)
+        seconds = 1e-9;
+    printf("%s\n", path);
+    printf("  %lu bytes in %.3f s, %.2f MB/s, %.0f frames/s\n",
+        (unsigned long)bytes, seconds, bytes / seconds / 1e6, frames / seconds);
+    printf("  %lu frames, %lu checksum rejects, %lu fixes\n",
+        (unsigned long)frames, (unsigned long)rejects, (unsigned long)fixes);
+}
+
+static void replayGps(const char *path, unsigned repeats) {
+    GpsStats stats;
+    uint32_t start;
+    size_t bytes = 0;
+    unsigned n;
+
+    baud = GPS_BAUD;
+    load(path);
+    GPS_init(GPS_OPTION_NO_CONFIG);
+    GPS_clearStats();
+    start = hostCoreCount();
+    for (n = 0; n < repeats; n++) {
+        recording.read = 0;
+        while (recording.read < recording.length)
+            GPS_runSM();
+        bytes += recording.length;
+    }
+    GPS_getStats(&stats);
+    report(path, bytes, hostSeconds(start), stats.messages,
+        stats.checksumErrors + stats.lengthErrors, stats.fixes);
+    printf("  %lu bytes outside of a message\n",
+        (unsigned long)stats.bytesSkipped);
+}
+
+static void replayMavlink(const char *path, unsigned repeats) {
+    MavlinkLinkStats before, after;
+    uint32_t start;
+    size_t bytes = 0;
+    unsigned n;
+
+    baud = MAVLINK_BAUD;
+    load(path);
+    Mavlink_get_link_stats(&before);
+    start = hostCoreCount();
+    for (n = 0; n < repeats; n++) {
+        recording.read = 0;
+        while (recording.read < recording.length)
+            Mavlink_recieve(XBEE_UART_ID);
+        bytes += recording.length;
+    }
+    Mavlink_get_link_stats(&after);
+    report(path, bytes, hostSeconds(start), after.received - before.received,
+        after.drops - before.drops, 0);
+    printf("  %lu frames nothing was registered for\n",
+        (unsigned long)(after.unhandled - before.unhandled));
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n repeats] [-g gps_file]... [-m mavlink_file]...\n"
+        "  gps_file      raw UBX or NMEA bytes, or a .dlm of decoded fixes\n"
+        "  mavlink_file  raw MAVLink bytes, or a serial_logger capture\n",
+        name);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    unsigned repeats = 1;
+    int i;
+
+    if (argc < 2)
+        usage(argv[0]);
+    Mavlink_init();
+    for (i = 1; i < argc; i++) {
+        if (i + 1 >= argc)
+            usage(argv[0]);
+        if (strcmp(argv[i], "-n") == 0)
+            repeats = (unsigned)atoi(argv[++i]);
+        else if (strcmp(argv[i], "-g") == 0)
+            replayGps(argv[++i], repeats? repeats : 1);
+        else if (strcmp(argv[i], "-m") == 0)
+            replayMavlink(argv[++i], repeats? repeats : 1);
+        else
+            usage(argv[0]);
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+/*
+ * Stand-in for the PIC32 peripheral library when building the parsers on
+ * a PC, see tool/parser_replay/README.md.
+ */
+#ifndef PARSER_REPLAY_PLIB_H
+#define PARSER_REPLAY_PLIB_H
+
+typedef enum _BOOL { FALSE = 0, TRUE } BOOL;
+
+// Nothing interrupts the replay
+static inline unsigned int INTDisableInterrupts(void) { return 0; }
+static inline void INTRestoreInterrupts(unsigned int status) { (void)status; }
+
+#endif
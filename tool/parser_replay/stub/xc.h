@@ -0,0 +1,19 @@
+/*
+ * Stand-in for the XC32 device header when building the parsers on a PC,
+ * see tool/parser_replay/README.md. Only what Gps.c and Mavlink.c touch.
+ */
+#ifndef PARSER_REPLAY_XC_H
+#define PARSER_REPLAY_XC_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Core timer at the board's 40 MHz, from the host's monotonic clock
+static inline uint32_t hostCoreCount(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec * 1000000000ULL + now.tv_nsec) / 25);
+}
+#define _CP0_GET_COUNT()    hostCoreCount()
+
+#endif
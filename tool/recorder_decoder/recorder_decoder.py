@@ -0,0 +1,123 @@
+#!/usr/bin/env python
+"""\
+recorder_decoder.py turns a dump of the flight recorder's flash (see
+include/Recorder.h) back into one line of text per record.
+
+Usage:
+    python recorder_decoder.py [-s session] [-t type] [dump_file]
+
+The dump is either the raw bytes of the chip, or the hex lines the
+RECORDER_TEST harness prints for 'd', one page a line. Reads stdin when no
+file is given.
+
+Notes:
+-----
+* Page: 'R', 'C', session (uint16), page in the session (uint32), then
+  records up to 0xFF.
+* Record: type, payload length, time in ms (uint32), payload, little
+  endian. The payloads are listed at RECORD_* in Recorder.h.
+
+"""
+import binascii
+import re
+import struct
+import sys
+import argparse
+
+PAGE_SIZE = 256
+PAGE_HEADER = 8
+RECORD_HEADER = 6
+ERASED = 0xFF
+HEX_LINE = re.compile(r'^[0-9a-fA-F]{%d}$' % (2 * PAGE_SIZE))
+
+# type: (name, struct format, fields, scale of each field)
+RECORDS = {
+    1: ('dropped', '<H', ('count',), (1,)),
+    2: ('gps', '<Iiiiii', ('iTOW', 'lat', 'lon', 'alt', 'north', 'east'),
+        (1, 1e-7, 1e-7, 1e-3, 1e-2, 1e-2)),
+    3: ('angles', '<hh', ('pitch', 'yaw'), (1e-2, 1e-2)),
+    4: ('imu', '<hhhH', ('x', 'y', 'z', 'heading'), (1, 1, 1, 1e-2)),
+    5: ('thermal', '<HhhB', ('heading', 'elevation', 'peak', 'pixels'),
+        (1e-2, 1e-2, 1e-2, 1)),
+    6: ('link', '<BBBHH', ('connected', 'loss', 'peer_loss', 'rtt', 'jitter'),
+        (1, 1, 1, 1, 1)),
+    7: ('event', '<BBH', ('module', 'code', 'arg'), (1, 1, 1)),
+}
+NAMES = dict((name, t) for t, (name, _, _, _) in RECORDS.items())
+NAMES['mark'] = 8
+
+
+def load_pages(data):
+    """Returns the dump as a bytearray of whole pages."""
+    lines = data.split()
+    if lines and all(HEX_LINE.match(line.decode('latin-1')) for line in lines):
+        data = bytearray(binascii.unhexlify(b''.join(lines)))
+    return data[:len(data) - len(data) % PAGE_SIZE]
+
+
+def format_record(record_type, time, payload):
+    if record_type not in RECORDS:
+        return '%10d %s %s' % (time, 'mark' if record_type == 8
+            else 'type%d' % record_type, binascii.hexlify(payload).decode())
+    name, fmt, fields, scales = RECORDS[record_type]
+    if len(payload) != struct.calcsize(fmt):
+        return '%10d %s bad length %d' % (time, name, len(payload))
+    values = struct.unpack(fmt, bytes(payload))
+    text = ' '.join('%s=%s' % (field, value if scale == 1 else
+        '%.7g' % (value * scale)) for field, value, scale
+        in zip(fields, values, scales))
+    return '%10d %s %s' % (time, name, text)
+
+
+def decode(data, out, session=None, record_type=None):
+    """Decodes the pages of a dump, writing text to out."""
+    last = None
+    for start in range(0, len(data), PAGE_SIZE):
+        page = data[start:start + PAGE_SIZE]
+        if page[0] == ERASED:
+            break
+        if page[0:2] != bytearray(b'RC'):
+            out.write('[page at 0x%x: no header]\n' % start)
+            continue
+        page_session, number = struct.unpack('<HI', bytes(page[2:PAGE_HEADER]))
+        if session is not None and page_session != session:
+            continue
+        if last is None or page_session != last[0]:
+            out.write('[session %d]\n' % page_session)
+        elif number != last[1] + 1:
+            out.write('[session %d: page gap %d -> %d]\n'
+                % (page_session, last[1], number))
+        last = (page_session, number)
+
+        i = PAGE_HEADER
+        while i + RECORD_HEADER <= PAGE_SIZE and page[i] != ERASED:
+            kind, length = page[i], page[i + 1]
+            time, = struct.unpack('<I', bytes(page[i + 2:i + RECORD_HEADER]))
+            payload = page[i + RECORD_HEADER:i + RECORD_HEADER + length]
+            if record_type is None or kind == record_type:
+                out.write(format_record(kind, time, payload) + '\n')
+            i += RECORD_HEADER + length
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode a flight recorder dump.')
+    parser.add_argument('-s', '--session', type=int,
+        help='only this session')
+    parser.add_argument('-t', '--type', choices=sorted(NAMES),
+        help='only records of this type')
+    parser.add_argument('dump', nargs='?',
+        help='raw or hex dump of the flash (default: stdin)')
+    args = parser.parse_args()
+
+    if args.dump:
+        with open(args.dump, 'rb') as f:
+            data = bytearray(f.read())
+    else:
+        stream = getattr(sys.stdin, 'buffer', sys.stdin)
+        data = bytearray(stream.read())
+    decode(load_pages(data), sys.stdout, args.session,
+        NAMES.get(args.type))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,356 @@
+# Module MavlinkCapture
+"""\
+MavlinkCapture frames and CRC checks MAVLink 1.0 packets in a serial
+stream, using the message definitions in autoLifeguard.xml, and writes
+them to an indexed binary capture that can be replayed and filtered
+without parsing every packet again.
+
+Capture file (little endian):
+    header:  'ALGCAP1\\n'
+    packet:  host time (double, s since the epoch), length of the frame
+             (uint16), then the whole MAVLink frame including its CRC
+
+Index file (capture file + '.idx'), one fixed size entry per packet:
+    host time (double), offset of the packet in the capture (uint32),
+    message id (uint8)
+
+Both are only appended to, so a capture cut short by a crash or Ctrl-C
+still reads back up to its last whole packet.
+
+Usage:
+    python MavlinkCapture.py capture_file [-m NAME ...] [--start s] [--end s]
+
+prints the packets of a capture, decoded, optionally only some messages
+or a span of seconds from the start of the capture.
+
+"""
+import os
+import struct
+import sys
+import argparse
+import xml.etree.ElementTree as ElementTree
+
+DEFAULT_DIALECT = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+    '..', '..', '..', 'include', 'mavlink', 'autoLifeguard.xml')
+
+STX = 0xFE
+HEADER_LENGTH = 6 # STX, length, sequence, system, component, message id
+CRC_LENGTH = 2
+
+CAPTURE_MAGIC = b'ALGCAP1\n'
+PACKET_HEADER = struct.Struct('<dH')
+INDEX_ENTRY = struct.Struct('<dIB')
+INDEX_SUFFIX = '.idx'
+
+CHUNK_SIZE = 4096 # bytes read from the port at a time
+
+# MAVLink type: (struct code, size)
+TYPES = {
+    'char': ('c', 1),
+    'int8_t': ('b', 1),
+    'uint8_t': ('B', 1),
+    'uint8_t_mavlink_version': ('B', 1),
+    'int16_t': ('h', 2),
+    'uint16_t': ('H', 2),
+    'int32_t': ('i', 4),
+    'uint32_t': ('I', 4),
+    'float': ('f', 4),
+    'int64_t': ('q', 8),
+    'uint64_t': ('Q', 8),
+    'double': ('d', 8),
+}
+
+
+def x25_crc(data, crc=0xFFFF):
+    """Accumulates the MAVLink (X.25) checksum over a bytearray."""
+    for b in data:
+        tmp = b ^ (crc & 0xFF)
+        tmp = (tmp ^ (tmp << 4)) & 0xFF
+        crc = ((crc >> 8) ^ (tmp << 8) ^ (tmp << 3) ^ (tmp >> 4)) & 0xFFFF
+    return crc
+
+
+class MessageDefinition:
+    """\
+    One message from the dialect. The fields are kept in wire order, which
+    is by type size, largest first, as mavgen lays them out.
+
+    """
+    def __init__(self, element):
+        self.id = int(element.get('id'))
+        self.name = element.get('name')
+        fields = []
+        for field in element.findall('field'):
+            kind = field.get('type')
+            count = 1
+            if '[' in kind:
+                kind, count = kind[:-1].split('[')
+                count = int(count)
+            fields.append((field.get('name'), kind, count))
+        # sorted() is stable, so equal sizes keep the order of the XML
+        self.fields = sorted(fields, key=lambda f: -TYPES[f[1]][1])
+
+        layout = '<'
+        for name, kind, count in self.fields:
+            code = TYPES[kind][0]
+            if count > 1:
+                layout += '%ds' % count if code == 'c' else '%d%s' % (count, code)
+            else:
+                layout += code
+        self.struct = struct.Struct(layout)
+        self.length = self.struct.size
+
+        text = bytearray((self.name + ' ').encode('ascii'))
+        for name, kind, count in self.fields:
+            base = 'uint8_t' if kind == 'uint8_t_mavlink_version' else kind
+            text += (base + ' ' + name + ' ').encode('ascii')
+            if count > 1:
+                text.append(count)
+        crc = x25_crc(text)
+        self.crc_extra = (crc & 0xFF) ^ (crc >> 8)
+
+    def decode(self, payload):
+        """Returns the payload as a list of (name, value)."""
+        values = list(self.struct.unpack(bytes(payload)))
+        decoded = []
+        for name, kind, count in self.fields:
+            if count > 1 and TYPES[kind][0] != 'c':
+                value, values = values[:count], values[count:]
+            else:
+                value, values = values[0], values[1:]
+            decoded.append((name, value))
+        return decoded
+
+
+class MavlinkDialect:
+    """\
+    The messages of a MAVLink XML definition, by id and by name.
+
+    """
+    def __init__(self, path=DEFAULT_DIALECT):
+        self.messages = {}
+        self.names = {}
+        for element in ElementTree.parse(path).getroot().iter('message'):
+            message = MessageDefinition(element)
+            self.messages[message.id] = message
+            self.names[message.name] = message.id
+
+
+class MavlinkParser:
+    """\
+    Finds MAVLink frames in a stream of bytes fed to it in chunks of any
+    size. A frame with a bad CRC, or a length that doesn't match its
+    message, is skipped one byte at a time, so a real frame inside it is
+    still found.
+
+    """
+    def __init__(self, dialect):
+        self.dialect = dialect
+        self.buffer = bytearray()
+        self.frames = 0
+        self.crc_errors = 0
+        self.unknown = 0
+        self.bytes_skipped = 0
+
+    def feed(self, data):
+        """\
+        Adds bytes to the stream.
+
+        Returns:
+            a list of (frame, text), where frame is a whole MAVLink frame
+            as a bytearray, or None when text is bytes that weren't one
+
+        """
+        buf = self.buffer
+        buf += data
+        found = []
+        text = bytearray()
+        i = 0
+        while i < len(buf):
+            if buf[i] != STX:
+                text.append(buf[i])
+                i += 1
+                continue
+            if i + HEADER_LENGTH > len(buf):
+                break
+            size = HEADER_LENGTH + buf[i + 1] + CRC_LENGTH
+            if i + size > len(buf):
+                break
+            frame = buf[i:i + size]
+            message = self.dialect.messages.get(frame[5])
+            if message is None or message.length != frame[1]:
+                self.unknown += 1
+            else:
+                crc = x25_crc(frame[1:size - CRC_LENGTH])
+                crc = x25_crc(bytearray([message.crc_extra]), crc)
+                if crc == frame[size - 2] | (frame[size - 1] << 8):
+                    if text:
+                        found.append((None, text))
+                        self.bytes_skipped += len(text)
+                        text = bytearray()
+                    found.append((frame, None))
+                    self.frames += 1
+                    i += size
+                    continue
+                self.crc_errors += 1
+            text.append(buf[i])
+            i += 1
+        if text:
+            found.append((None, text))
+            self.bytes_skipped += len(text)
+        self.buffer = buf[i:]
+        return found
+
+
+class CaptureWriter:
+    """\
+    Appends timestamped frames to a capture file and its index.
+
+    """
+    def __init__(self, path):
+        self.path = path
+        self.file = open(path, 'wb')
+        self.index = open(path + INDEX_SUFFIX, 'wb')
+        self.file.write(CAPTURE_MAGIC)
+        self.offset = len(CAPTURE_MAGIC)
+
+    def write(self, host_time, frame):
+        self.index.write(INDEX_ENTRY.pack(host_time, self.offset, frame[5]))
+        self.file.write(PACKET_HEADER.pack(host_time, len(frame)))
+        self.file.write(bytes(frame))
+        self.offset += PACKET_HEADER.size + len(frame)
+
+    def close(self):
+        if self.file:
+            self.file.close()
+            self.index.close()
+            self.file = None
+
+
+class CaptureReader:
+    """\
+    Reads packets back from a capture, through its index so packets that
+    are filtered out are never read.
+
+    """
+    def __init__(self, path):
+        self.path = path
+        with open(path + INDEX_SUFFIX, 'rb') as f:
+            data = f.read()
+        count = len(data) // INDEX_ENTRY.size
+        self.index = [INDEX_ENTRY.unpack_from(data, n * INDEX_ENTRY.size)
+            for n in range(count)]
+
+    def packets(self, ids=None, start=None, end=None):
+        """\
+        Yields (host time, frame) in the order they were captured.
+
+        Args:
+            ids: message ids to keep, or None for all
+            start, end: host times to keep between, or None
+
+        """
+        with open(self.path, 'rb') as f:
+            if f.read(len(CAPTURE_MAGIC)) != CAPTURE_MAGIC:
+                raise ValueError('{0} is not a capture'.format(self.path))
+            for host_time, offset, message_id in self.index:
+                if ids is not None and message_id not in ids:
+                    continue
+                if (start is not None and host_time < start) \
+                        or (end is not None and host_time > end):
+                    continue
+                f.seek(offset)
+                header = f.read(PACKET_HEADER.size)
+                if len(header) < PACKET_HEADER.size:
+                    return
+                length = PACKET_HEADER.unpack(header)[1]
+                frame = bytearray(f.read(length))
+                if len(frame) < length:
+                    return
+                yield host_time, frame
+
+
+class MavlinkCapture:
+    """\
+    Capture engine for SerialLogger. Reads whatever the port has waiting,
+    up to CHUNK_SIZE at once, keeps the frames with the time it read them
+    at, and hands everything else back as text.
+
+    Args:
+        path: capture file to write
+        dialect_path: MAVLink XML definitions
+
+    """
+    def __init__(self, path, dialect_path=DEFAULT_DIALECT):
+        self.dialect = MavlinkDialect(dialect_path)
+        self.parser = MavlinkParser(self.dialect)
+        self.writer = CaptureWriter(path)
+
+    def read(self, connection, host_time):
+        """\
+        Reads one chunk from a serial connection, blocking up to its
+        timeout for the first byte.
+
+        Returns:
+            the text that wasn't MAVLink, as a bytearray
+
+        """
+        waiting = connection.inWaiting()
+        data = connection.read(min(max(waiting, 1), CHUNK_SIZE))
+        return self.feed(bytearray(data), host_time)
+
+    def feed(self, data, host_time):
+        text = bytearray()
+        for frame, other in self.parser.feed(data):
+            if frame is not None:
+                self.writer.write(host_time, frame)
+            else:
+                text += other
+        return text
+
+    def describe(self, frame):
+        return describe(self.dialect, frame)
+
+    def close(self):
+        self.writer.close()
+
+
+def describe(dialect, frame):
+    """Returns a MAVLink frame as one line of text."""
+    message = dialect.messages[frame[5]]
+    payload = frame[HEADER_LENGTH:HEADER_LENGTH + frame[1]]
+    fields = ', '.join('{0}={1}'.format(name, value)
+        for name, value in message.decode(payload))
+    return '{0} [{1}] {2}'.format(message.name, frame[2], fields)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Print a MAVLink capture.')
+    parser.add_argument('capture', help='capture file written by serial_logger')
+    parser.add_argument('-m', '--message', action='append',
+        help='only this message, by name, may be repeated')
+    parser.add_argument('--start', type=float,
+        help='seconds from the start of the capture to begin at')
+    parser.add_argument('--end', type=float,
+        help='seconds from the start of the capture to stop at')
+    parser.add_argument('-x', '--xml', default=DEFAULT_DIALECT,
+        help='MAVLink definitions (default: %(default)s)')
+    args = parser.parse_args()
+
+    dialect = MavlinkDialect(args.xml)
+    reader = CaptureReader(args.capture)
+    if not reader.index:
+        return
+    ids = None
+    if args.message:
+        ids = set(dialect.names[name.upper()] for name in args.message)
+    first = reader.index[0][0]
+    start = first + args.start if args.start is not None else None
+    end = first + args.end if args.end is not None else None
+    for host_time, frame in reader.packets(ids, start, end):
+        sys.stdout.write('{0:10.3f} {1}\n'.format(host_time - first,
+            describe(dialect, frame)))
+
+
+if __name__ == '__main__':
+    main()
@@ -1,5 +1,7 @@
 # Module SerialLogger
 import os
+import sys
+import time
 import serial
 import pprint
 import logging
@@ -16,13 +18,15 @@ class SerialLogger:
         baud_rate: number for serial connection's baud rate
         device_port: path or id of the serial device's port
         timeout: number for the serial connection's timeout in seconds
+        capture: MavlinkCapture to keep the MAVLink frames in, or None to
+            log everything as text
     Returns: 
         an SerialLogger object
     Raises:
         
        
     """
-    def __init__(self, baud_rate, device_port, timeout, interactive=True, print_callback=sys.stdout.write):
+    def __init__(self, baud_rate, device_port, timeout, interactive=True, print_callback=sys.stdout.write, capture=None):
         self.greeting = "\nWelcome to the serial_logger tool."
 
         self.goodbye = "\nGoodbye!"
@@ -37,6 +41,7 @@ class SerialLogger:
         self.print_callback = print_callback
         self.last_id = 0
         self.line = ''
+        self.capture = capture
 
         # --------------------------------
         # Initialize logger
@@ -175,6 +180,11 @@ class SerialLogger:
 
         # print('Enter a command. For a list type \'help\'.')
 
+        if self.capture:
+            while (not self.want_exit):
+                self.do_capture()
+            return
+
         # Main loop
         line = ''
         while (not self.want_exit):
@@ -220,6 +230,27 @@ class SerialLogger:
 
         #sys.stdout.flush()
 
+    def do_capture(self):
+        """\
+        Reads everything waiting on the serial device at once, keeps the
+        MAVLink frames in the capture with the time they were read at, and
+        logs and prints the rest as text lines.
+
+        Note:
+        - Blocks up to the timeout when nothing is waiting
+        """
+        text = ''.join(chr(b) for b in self.capture.read(self.connection, time.time()))
+        if text:
+            self.print_callback(text)
+        for c in text:
+            if (c == '\n'):
+                logging.info(self.line)
+                self.line = ''
+            elif (c == '\r'):
+                pass
+            else:
+                self.line += repr(c)[1:-1]
+
 
     
     def execute_command(self,command):
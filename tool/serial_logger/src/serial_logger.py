@@ -14,6 +14,7 @@ import sys
 import os
 #sys.path.append('library')
 import SerialLogger
+import MavlinkCapture
 import string
 import pprint
 import argparse
@@ -38,6 +39,13 @@ def signal_handler(signal, frame):
 
 # Clean up for serial port and log when exiting.
 def cleanup():
+    try:
+        if capture:
+            capture.close()
+            logging.info('Captured {0!s} MAVLink frames, {1!s} CRC errors, to \'{2}\''.format(
+                capture.parser.frames, capture.parser.crc_errors, capture_file))
+    except NameError as ex:
+        pass
     try:
         myTerminalLogger.__del__()
         myTerminalLogger = None
@@ -74,6 +82,8 @@ device_port = None
 timeout = 5
 log_level='INFO'
 interactive = True
+capture_file = None
+capture = None
 
 
 
@@ -85,7 +95,7 @@ parser = argparse.ArgumentParser(
     description="""\
 Connects to a serial device and sends and receives data.
 """,
-    usage='serial_logger.py -h | [-l log_file] [--loglevel=LEVEL] [-c config_file] [-t timeout] [-b baud_rate] [device_path] ',
+    usage='serial_logger.py -h | [-l log_file] [--loglevel=LEVEL] [-c config_file] [-t timeout] [-b baud_rate] [-m capture_file] [device_path] ',
     add_help=False
     )
 
@@ -99,6 +109,8 @@ parser.add_argument('-t', '--timeout', dest='timeout', nargs=1, type=int,
     help='serial connection timeout in seconds (default: {0!s})'.format(timeout))
 parser.add_argument('-l','--log', dest='log_file', nargs=1,
     help='log file to record session to (default: {0})'.format(log_file))
+parser.add_argument('-m', '--mavlink', dest='capture_file', nargs=1,
+    help='capture MAVLink frames to this file, with an index, and log only the rest as text')
 parser.add_argument('--loglevel', dest='log_level', action='store', default=log_level,
     help='sets the logging level (default: %(default)s)', choices=['DEBUG', 'INFO', 'WARNING', 'ERROR', 'CRITICAL'])
 parser.add_argument('-h', '--help', action='store_true', dest='want_help',
@@ -143,6 +155,12 @@ if args_obj.device:
 elif config_obj.has_option('DEFAULT','device'):
     device_port = config_obj.get('DEFAULT', 'device')
 
+# Set the MAVLink capture file
+if args_obj.capture_file:
+    capture_file = args_obj.capture_file[0]
+elif config_obj.has_option('DEFAULT', 'capture'):
+    capture_file = config_obj.get('DEFAULT', 'capture')
+
 # Set the connection timeout
 if args_obj.timeout:
     timeout = args_obj.timeout
@@ -168,12 +186,16 @@ try:
     # Override Ctrl-C with definition
     signal.signal(signal.SIGINT, signal_handler)
 
+    if capture_file:
+        capture = MavlinkCapture.MavlinkCapture(capture_file)
+
     # Initial new terminal object
     myTerminalLogger = SerialLogger.SerialLogger(
         baud_rate = baud_rate,
         device_port = device_port,
         timeout = timeout,
-        interactive = interactive
+        interactive = interactive,
+        capture = capture
     )
 
 #----------------------------------------------------------